@@ -27,7 +27,11 @@
  *
  * @}
  */
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #ifdef _WIN32
 #define VC_EXTRALEAN
@@ -35,23 +39,37 @@
 #include <ola/win/CleanWindows.h>
 #include <io.h>
 #else
+#include <signal.h>
 #include <syslog.h>
 #endif  // _WIN32
 
 #include <unistd.h>
 
 #include <iostream>
+#include <map>
 #include <string>
+#include "ola/Clock.h"
 #include "ola/Logging.h"
+#include "ola/base/Atomic.h"
 #include "ola/base/Flags.h"
+#include "ola/thread/Mutex.h"
+#include "ola/thread/Thread.h"
 
 /**@private*/
 DEFINE_s_int8(log_level, l, ola::OLA_LOG_WARN, "Set the logging level 0 .. 4.");
 /**@private*/
 DEFINE_default_bool(syslog, false, "Send to syslog rather than stderr.");
+/**@private*/
+DEFINE_default_bool(log_async, false,
+                    "Write log messages from a background thread, so logging "
+                    "doesn't block the caller.");
 
 namespace ola {
 
+using ola::thread::ConditionVariable;
+using ola::thread::Mutex;
+using ola::thread::MutexLocker;
+using std::map;
 using std::ostringstream;
 using std::string;
 
@@ -61,7 +79,34 @@ using std::string;
  */
 LogDestination *log_target = NULL;
 
+/*
+ * The log target, if it was created with --log-async. The writer thread is
+ * stopped before a fork() and at exit, so that queued lines aren't lost, and
+ * restarted in the parent after a fork().
+ */
+AsyncLogDestination *async_log_target = NULL;
+
 log_level logging_level = OLA_LOG_WARN;
+
+static void StopAsyncLogging() {
+  if (async_log_target) {
+    async_log_target->Stop();
+  }
+}
+
+#ifndef _WIN32
+static void StartAsyncLogging() {
+  if (async_log_target) {
+    async_log_target->Init();
+  }
+}
+
+static void ResetAsyncLogging() {
+  if (async_log_target) {
+    async_log_target->ResetAfterFork();
+  }
+}
+#endif  // _WIN32
 /**@endcond*/
 
 /**
@@ -111,7 +156,41 @@ bool InitLoggingFromFlags() {
       break;
   }
 
-  return InitLogging(log_level, output);
+  if (!InitLogging(log_level, output)) {
+    return false;
+  }
+
+  if (FLAGS_log_async && log_target) {
+    // The AsyncLogDestination takes ownership of the current target.
+    AsyncLogDestination *destination = new AsyncLogDestination(log_target);
+    log_target = NULL;
+    InitAsyncLogging(log_level, destination);
+  }
+  return true;
+}
+
+
+void InitAsyncLogging(log_level level, AsyncLogDestination *destination) {
+  InitLogging(level, destination);
+  async_log_target = destination;
+  destination->Init();
+
+  static bool registered_handlers = false;
+  if (!registered_handlers) {
+    atexit(StopAsyncLogging);
+#ifndef _WIN32
+    // Only the parent restarts the writer thread, starting threads in the
+    // child isn't safe if the program is multithreaded. A single threaded
+    // child, like a daemon, calls RestartAsyncLogging() instead.
+    pthread_atfork(StopAsyncLogging, StartAsyncLogging, ResetAsyncLogging);
+#endif  // _WIN32
+    registered_handlers = true;
+  }
+}
+
+
+bool RestartAsyncLogging() {
+  return async_log_target ? async_log_target->Init() : true;
 }
 
 
@@ -144,6 +223,7 @@ void InitLogging(log_level level, LogDestination *destination) {
     delete log_target;
   }
   log_target = destination;
+  async_log_target = NULL;
 }
 
 /**@}*/
@@ -256,5 +336,385 @@ void UnixSyslogDestination::Write(log_level level, const string &log_line) {
 }
 #endif  // _WIN32
 
+/**@}*/
+/**@cond HIDDEN_SYMBOLS*/
+struct AsyncLogDestination::Slot {
+  // The position this slot is ready to be written at, or the position + 1
+  // once it holds a line.
+  volatile uint32_t sequence;
+  log_level level;
+  unsigned int length;
+  char data[MAX_LINE_LENGTH];
+};
+
+/*
+ * Takes lines from the ring and writes them to the destination. The repeat &
+ * rate limiting state is only touched by this thread, or by Stop() once the
+ * thread has exited.
+ */
+class AsyncLogDestination::WriterThread: public ola::thread::Thread {
+ public:
+  explicit WriterThread(AsyncLogDestination *parent)
+      : Thread(Thread::Options("log-writer")),
+        m_parent(parent),
+        m_last_level(OLA_LOG_INFO),
+        m_repeats(0) {
+  }
+
+  /*
+   * Write the lines in the ring.
+   * @returns true if there were any lines.
+   */
+  bool Drain(const TimeStamp &now) {
+    log_level level;
+    string line;
+    // Don't get stuck here if the ring is refilled as fast as it's drained.
+    for (uint32_t i = 0; i <= m_parent->m_mask; i++) {
+      if (!m_parent->Dequeue(&level, &line)) {
+        return i != 0;
+      }
+      WriteLine(level, line, now);
+    }
+    return true;
+  }
+
+  /*
+   * Write the summaries for repeated, suppressed & dropped lines.
+   * @param now the current time.
+   * @param force write the summaries even if the second isn't up.
+   */
+  void WriteSummaries(const TimeStamp &now, bool force) {
+    if (m_repeats && (force || now - m_repeat_start >= ONE_SECOND)) {
+      WriteSummary(m_last_level, m_last_line, "Last message repeated",
+                   m_repeats, " times");
+      m_repeats = 0;
+    }
+
+    CallSiteMap::iterator iter = m_call_sites.begin();
+    while (iter != m_call_sites.end()) {
+      if (force || now - iter->second.window_start >= ONE_SECOND) {
+        WriteSuppressed(iter->first, iter->second);
+        m_call_sites.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+
+    uint64_t dropped = AtomicLoad(&m_parent->m_dropped);
+    if (dropped != m_parent->m_reported_dropped) {
+      ostringstream str;
+      str << "Dropped " << dropped - m_parent->m_reported_dropped
+          << " log messages, the ring was full\n";
+      m_parent->m_destination->Write(OLA_LOG_WARN, str.str());
+      m_parent->m_reported_dropped = dropped;
+    }
+  }
+
+ protected:
+  void *Run() {
+#ifndef _WIN32
+    // Leave signals to the threads that are waiting for them.
+    sigset_t signals;
+    sigfillset(&signals);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+#endif  // _WIN32
+
+    TimeStamp now;
+    while (true) {
+      m_clock.CurrentTime(&now);
+      bool wrote_lines = Drain(now);
+      WriteSummaries(now, false);
+      if (wrote_lines && !m_parent->m_stopping) {
+        continue;
+      }
+
+      MutexLocker locker(m_parent->m_mutex);
+      if (m_parent->m_stopping) {
+        break;
+      }
+      // Writers only signal if we're waiting, and don't take the lock to do
+      // so. A signal that's missed is picked up by the timeout.
+      m_parent->m_writer_waiting = true;
+      m_parent->m_wake_up->TimedWait(m_parent->m_mutex,
+                                     now + TimeInterval(0, POLL_INTERVAL_US));
+      m_parent->m_writer_waiting = false;
+    }
+    return NULL;
+  }
+
+ private:
+  struct CallSite {
+    TimeStamp window_start;
+    log_level level;
+    unsigned int lines;
+    unsigned int suppressed;
+
+    CallSite() : level(OLA_LOG_INFO), lines(0), suppressed(0) {}
+  };
+
+  typedef map<string, CallSite> CallSiteMap;
+
+  AsyncLogDestination *m_parent;
+  Clock m_clock;
+  string m_last_line;
+  log_level m_last_level;
+  unsigned int m_repeats;
+  TimeStamp m_repeat_start;
+  CallSiteMap m_call_sites;
+
+  static const unsigned int MAX_CALL_SITES = 256;
+  static const int32_t POLL_INTERVAL_US = 100000;
+  static const TimeInterval ONE_SECOND;
+
+  void WriteLine(log_level level, const string &line, const TimeStamp &now) {
+    if (line == m_last_line) {
+      if (!m_repeats++) {
+        m_repeat_start = now;
+      }
+      return;
+    }
+    if (m_repeats) {
+      WriteSummary(m_last_level, m_last_line, "Last message repeated",
+                   m_repeats, " times");
+      m_repeats = 0;
+    }
+
+    if (m_parent->m_max_lines_per_second) {
+      // The call site is the file:line prefix.
+      string site = line.substr(0, line.find(": "));
+      CallSiteMap::iterator iter = m_call_sites.find(site);
+      if (iter == m_call_sites.end() &&
+          m_call_sites.size() < MAX_CALL_SITES) {
+        iter = m_call_sites.insert(
+            CallSiteMap::value_type(site, CallSite())).first;
+        iter->second.window_start = now;
+      }
+
+      if (iter != m_call_sites.end()) {
+        CallSite *call_site = &iter->second;
+        if (now - call_site->window_start >= ONE_SECOND) {
+          WriteSuppressed(iter->first, *call_site);
+          call_site->window_start = now;
+          call_site->lines = 0;
+          call_site->suppressed = 0;
+        }
+        call_site->level = level;
+        if (call_site->lines >= m_parent->m_max_lines_per_second) {
+          call_site->suppressed++;
+          m_last_line.clear();
+          return;
+        }
+        call_site->lines++;
+      }
+    }
+
+    m_last_line = line;
+    m_last_level = level;
+    m_parent->m_destination->Write(level, line);
+  }
+
+  void WriteSuppressed(const string &site, const CallSite &call_site) {
+    if (call_site.suppressed) {
+      WriteSummary(call_site.level, site, "Suppressed", call_site.suppressed,
+                   " messages");
+    }
+  }
+
+  void WriteSummary(log_level level, const string &line, const char *prefix,
+                    unsigned int count, const char *suffix) {
+    ostringstream str;
+    str << line.substr(0, line.find(": ")) << ": " << prefix << " " << count
+        << suffix << "\n";
+    m_parent->m_destination->Write(level, str.str());
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(WriterThread);
+};
+
+const TimeInterval AsyncLogDestination::WriterThread::ONE_SECOND(1, 0);
+/**@endcond*/
+
+/**
+ * @addtogroup logging
+ * @{
+ */
+AsyncLogDestination::AsyncLogDestination(LogDestination *destination,
+                                         const Options &options)
+    : m_destination(destination),
+      m_max_lines_per_second(options.max_lines_per_second),
+      m_slots(NULL),
+      m_mask(1),
+      m_enqueue_position(0),
+      m_dequeue_position(0),
+      m_dropped(0),
+      m_reported_dropped(0),
+      m_running(false),
+      m_active_writers(0),
+      m_writer_waiting(false),
+      m_stopping(false),
+      m_writer(NULL),
+      m_mutex(new Mutex()),
+      m_wake_up(new ConditionVariable()) {
+  while (m_mask + 1 < options.ring_size) {
+    m_mask = (m_mask << 1) | 1;
+  }
+  m_slots = new Slot[m_mask + 1];
+  for (uint32_t i = 0; i <= m_mask; i++) {
+    m_slots[i].sequence = i;
+  }
+}
+
+AsyncLogDestination::~AsyncLogDestination() {
+  Stop();
+  delete[] m_slots;
+  delete m_wake_up;
+  delete m_mutex;
+  delete m_destination;
+}
+
+bool AsyncLogDestination::Init() {
+  if (m_writer) {
+    return true;
+  }
+
+  m_stopping = false;
+  m_writer = new WriterThread(this);
+  if (!m_writer->Start()) {
+    delete m_writer;
+    m_writer = NULL;
+    return false;
+  }
+  AtomicBarrier();
+  m_running = true;
+  return true;
+}
+
+void AsyncLogDestination::Stop() {
+  if (!m_writer) {
+    return;
+  }
+
+  m_running = false;
+  AtomicBarrier();
+  {
+    MutexLocker locker(m_mutex);
+    m_stopping = true;
+    m_wake_up->Signal();
+  }
+  m_writer->Join();
+
+  // A Write() that saw m_running before it was cleared may still be adding a
+  // line, wait for it so the line is drained below rather than left in the
+  // ring.
+  while (AtomicLoad(&m_active_writers)) {
+    usleep(STOP_POLL_INTERVAL_US);
+  }
+
+  // The thread has exited, so it's safe to finish off here.
+  Clock clock;
+  TimeStamp now;
+  clock.CurrentTime(&now);
+  while (m_writer->Drain(now)) {}
+  m_writer->WriteSummaries(now, true);
+  delete m_writer;
+  m_writer = NULL;
+}
+
+void AsyncLogDestination::ResetAfterFork() {
+  // The thread isn't running in the child, so there is nothing to join.
+  delete m_writer;
+  m_writer = NULL;
+  m_running = false;
+  m_stopping = false;
+  m_writer_waiting = false;
+  // Writers in the parent may have been part way through Write().
+  m_active_writers = 0;
+  m_enqueue_position = 0;
+  m_dequeue_position = 0;
+  for (uint32_t i = 0; i <= m_mask; i++) {
+    m_slots[i].sequence = i;
+  }
+  m_reported_dropped = m_dropped;
+}
+
+void AsyncLogDestination::Write(log_level level, const string &log_line) {
+  if (level != OLA_LOG_FATAL) {
+    // Register before checking m_running, this pairs with Stop().
+    AtomicAdd(&m_active_writers, 1);
+    if (m_running) {
+      Enqueue(level, log_line);
+      AtomicSubtract(&m_active_writers, 1);
+      return;
+    }
+    AtomicSubtract(&m_active_writers, 1);
+  }
+  m_destination->Write(level, log_line);
+}
+
+uint64_t AsyncLogDestination::Dropped() const {
+  return AtomicLoad(&m_dropped);
+}
+
+void AsyncLogDestination::Enqueue(log_level level, const string &log_line) {
+  // Claim a slot. This is the bounded MPMC queue from
+  // http://www.1024cores.net/, with a single consumer.
+  uint32_t position = m_enqueue_position;
+  Slot *slot;
+  while (true) {
+    slot = &m_slots[position & m_mask];
+    uint32_t sequence = slot->sequence;
+    AtomicBarrier();
+    int32_t difference = static_cast<int32_t>(sequence - position);
+    if (difference == 0) {
+      if (AtomicCompareAndSwap(&m_enqueue_position, position,
+                               position + 1)) {
+        break;
+      }
+      position = m_enqueue_position;
+    } else if (difference < 0) {
+      // The ring is full.
+      AtomicAdd(&m_dropped, 1);
+      return;
+    } else {
+      position = m_enqueue_position;
+    }
+  }
+
+  slot->level = level;
+  if (log_line.size() > MAX_LINE_LENGTH) {
+    const char truncated[] = "...\n";
+    slot->length = MAX_LINE_LENGTH;
+    memcpy(slot->data, log_line.data(),
+           MAX_LINE_LENGTH - sizeof(truncated) + 1);
+    memcpy(slot->data + MAX_LINE_LENGTH - sizeof(truncated) + 1, truncated,
+           sizeof(truncated) - 1);
+  } else {
+    slot->length = log_line.size();
+    memcpy(slot->data, log_line.data(), log_line.size());
+  }
+  AtomicBarrier();
+  slot->sequence = position + 1;
+
+  if (m_writer_waiting) {
+    m_wake_up->Signal();
+  }
+}
+
+bool AsyncLogDestination::Dequeue(log_level *level, string *line) {
+  Slot *slot = &m_slots[m_dequeue_position & m_mask];
+  uint32_t sequence = slot->sequence;
+  AtomicBarrier();
+  if (sequence != m_dequeue_position + 1) {
+    return false;
+  }
+
+  *level = slot->level;
+  line->assign(slot->data, slot->length);
+  AtomicBarrier();
+  slot->sequence = m_dequeue_position + m_mask + 1;
+  m_dequeue_position++;
+  return true;
+}
+
 }  // namespace  ola
 /**@}*/
@@ -19,6 +19,12 @@
  */
 
 #include <cppunit/extensions/HelperMacros.h>
+#include <sys/types.h>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif  // _WIN32
+#include <unistd.h>
+#include <algorithm>
 #include <deque>
 #include <string>
 #include <utility>
@@ -27,22 +33,44 @@
 #include "ola/Logging.h"
 #include "ola/StringUtils.h"
 #include "ola/testing/TestUtils.h"
+#include "ola/thread/Mutex.h"
+#include "ola/thread/Thread.h"
 
 
 using std::deque;
 using std::vector;
 using std::string;
+using ola::AsyncLogDestination;
 using ola::IncrementLogLevel;
 using ola::log_level;
+using ola::thread::ConditionVariable;
+using ola::thread::Mutex;
+using ola::thread::MutexLocker;
 
 
 class LoggingTest: public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(LoggingTest);
   CPPUNIT_TEST(testLogging);
+  CPPUNIT_TEST(testAsyncLogging);
+  CPPUNIT_TEST(testAsyncRepeatedLines);
+  CPPUNIT_TEST(testAsyncRateLimit);
+  CPPUNIT_TEST(testAsyncDroppedLines);
+  CPPUNIT_TEST(testAsyncStopWhileWriting);
+#ifndef _WIN32
+  CPPUNIT_TEST(testAsyncFork);
+  CPPUNIT_TEST(testRestartAsyncLogging);
+#endif  // _WIN32
   CPPUNIT_TEST_SUITE_END();
 
  public:
     void testLogging();
+    void testAsyncLogging();
+    void testAsyncRepeatedLines();
+    void testAsyncRateLimit();
+    void testAsyncDroppedLines();
+    void testAsyncStopWhileWriting();
+    void testAsyncFork();
+    void testRestartAsyncLogging();
 };
 
 
@@ -56,6 +84,119 @@ class MockLogDestination: public ola::LogDestination {
 };
 
 
+/*
+ * Records the lines written, and can block the writer until released.
+ */
+class RecordingLogDestination: public ola::LogDestination {
+ public:
+    RecordingLogDestination()
+        : m_last_writer(ola::thread::Thread::Self()),
+          m_blocked(false),
+          m_writing(false) {
+    }
+
+    void Write(log_level level, const string &log_line) {
+      MutexLocker locker(&m_mutex);
+      m_lines.push_back(log_line);
+      m_last_writer = ola::thread::Thread::Self();
+      m_writing = true;
+      m_condition.Broadcast();
+      while (m_blocked) {
+        m_condition.Wait(&m_mutex);
+      }
+      m_writing = false;
+      (void) level;
+    }
+
+    void Block() {
+      MutexLocker locker(&m_mutex);
+      m_blocked = true;
+    }
+
+    void WaitForWrite() {
+      MutexLocker locker(&m_mutex);
+      while (!m_writing) {
+        m_condition.Wait(&m_mutex);
+      }
+    }
+
+    void Unblock() {
+      MutexLocker locker(&m_mutex);
+      m_blocked = false;
+      m_condition.Broadcast();
+    }
+
+    vector<string> Lines() {
+      MutexLocker locker(&m_mutex);
+      return m_lines;
+    }
+
+    // Wait up to a second for a number of lines to be written.
+    bool WaitForLines(size_t count) {
+      for (unsigned int i = 0; i < 1000; i++) {
+        if (Lines().size() >= count) {
+          return true;
+        }
+        usleep(1000);
+      }
+      return false;
+    }
+
+    // The thread that wrote the last line.
+    ola::thread::ThreadId LastWriter() {
+      MutexLocker locker(&m_mutex);
+      return m_last_writer;
+    }
+
+ private:
+    Mutex m_mutex;
+    ConditionVariable m_condition;
+    vector<string> m_lines;
+    ola::thread::ThreadId m_last_writer;
+    bool m_blocked;
+    bool m_writing;
+};
+
+
+bool IsDroppedSummary(const string &line) {
+  return line.find("Dropped ") == 0;
+}
+
+
+/*
+ * Writes lines until told to stop.
+ */
+class LineWriterThread: public ola::thread::Thread {
+ public:
+    LineWriterThread(AsyncLogDestination *destination, unsigned int id,
+                     const volatile bool *stop)
+        : Thread(),
+          m_destination(destination),
+          m_id(id),
+          m_stop(stop),
+          m_lines(0) {
+    }
+
+    void *Run() {
+      while (!*m_stop) {
+        // Each line is different, so none are collapsed.
+        m_destination->Write(ola::OLA_LOG_INFO,
+                             "foo.cpp:" + ola::IntToString(m_id) + ": line " +
+                             ola::IntToString(m_lines++) + "\n");
+      }
+      return NULL;
+    }
+
+    unsigned int Lines() const { return m_lines; }
+
+ private:
+    AsyncLogDestination *m_destination;
+    const unsigned int m_id;
+    const volatile bool *m_stop;
+    unsigned int m_lines;
+};
+
+
 CPPUNIT_TEST_SUITE_REGISTRATION(LoggingTest);
 
 
@@ -125,3 +266,254 @@ void LoggingTest::testLogging() {
   OLA_FATAL << "fatal";
   OLA_ASSERT_EQ(destination->LinesRemaining(), 0);
 }
+
+
+/*
+ * Check the AsyncLogDestination writes lines in order.
+ */
+void LoggingTest::testAsyncLogging() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination::Options options;
+  options.max_lines_per_second = 0;
+  AsyncLogDestination async_destination(destination, options);
+
+  // Lines are written straight away until Init() is called.
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:1: sync\n");
+  OLA_ASSERT_EQ(static_cast<size_t>(1), destination->Lines().size());
+
+  OLA_ASSERT_TRUE(async_destination.Init());
+  // FATAL lines are always written straight away.
+  async_destination.Write(ola::OLA_LOG_FATAL, "foo.cpp:5: fatal\n");
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:2: one\n");
+  async_destination.Write(ola::OLA_LOG_WARN, "foo.cpp:3: two\n");
+  async_destination.Write(ola::OLA_LOG_INFO,
+                          "foo.cpp:4: " + string(1000, 'x') + "\n");
+  async_destination.Stop();
+
+  vector<string> lines = destination->Lines();
+  OLA_ASSERT_EQ(static_cast<size_t>(5), lines.size());
+  OLA_ASSERT_EQ(string("foo.cpp:1: sync\n"), lines[0]);
+  OLA_ASSERT_EQ(string("foo.cpp:5: fatal\n"), lines[1]);
+  OLA_ASSERT_EQ(string("foo.cpp:2: one\n"), lines[2]);
+  OLA_ASSERT_EQ(string("foo.cpp:3: two\n"), lines[3]);
+  OLA_ASSERT_EQ(static_cast<size_t>(AsyncLogDestination::MAX_LINE_LENGTH),
+                lines[4].size());
+  OLA_ASSERT_EQ(string("xx...\n"), lines[4].substr(lines[4].size() - 6));
+  OLA_ASSERT_EQ(static_cast<uint64_t>(0), async_destination.Dropped());
+}
+
+
+/*
+ * Check runs of identical lines are collapsed.
+ */
+void LoggingTest::testAsyncRepeatedLines() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination async_destination(destination);
+  OLA_ASSERT_TRUE(async_destination.Init());
+
+  for (unsigned int i = 0; i < 4; i++) {
+    async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:1: same\n");
+  }
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:2: other\n");
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:2: other\n");
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:2: other\n");
+  async_destination.Stop();
+
+  vector<string> lines = destination->Lines();
+  OLA_ASSERT_EQ(static_cast<size_t>(4), lines.size());
+  OLA_ASSERT_EQ(string("foo.cpp:1: same\n"), lines[0]);
+  OLA_ASSERT_EQ(string("foo.cpp:1: Last message repeated 3 times\n"),
+                lines[1]);
+  OLA_ASSERT_EQ(string("foo.cpp:2: other\n"), lines[2]);
+  OLA_ASSERT_EQ(string("foo.cpp:2: Last message repeated 2 times\n"),
+                lines[3]);
+}
+
+
+/*
+ * Check the lines from each call site are rate limited.
+ */
+void LoggingTest::testAsyncRateLimit() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination::Options options;
+  options.max_lines_per_second = 5;
+  AsyncLogDestination async_destination(destination, options);
+  OLA_ASSERT_TRUE(async_destination.Init());
+
+  for (unsigned int i = 0; i < 8; i++) {
+    async_destination.Write(ola::OLA_LOG_INFO,
+                            "foo.cpp:1: line " + ola::IntToString(i) + "\n");
+  }
+  async_destination.Write(ola::OLA_LOG_INFO, "bar.cpp:1: line\n");
+  async_destination.Stop();
+
+  vector<string> lines = destination->Lines();
+  OLA_ASSERT_EQ(static_cast<size_t>(7), lines.size());
+  OLA_ASSERT_EQ(string("foo.cpp:1: line 0\n"), lines[0]);
+  OLA_ASSERT_EQ(string("foo.cpp:1: line 4\n"), lines[4]);
+  OLA_ASSERT_EQ(string("bar.cpp:1: line\n"), lines[5]);
+  OLA_ASSERT_EQ(string("foo.cpp:1: Suppressed 3 messages\n"), lines[6]);
+}
+
+
+/*
+ * Check lines are dropped, and counted, once the ring is full.
+ */
+void LoggingTest::testAsyncDroppedLines() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination::Options options;
+  options.ring_size = 16;
+  options.max_lines_per_second = 0;
+  AsyncLogDestination async_destination(destination, options);
+  OLA_ASSERT_TRUE(async_destination.Init());
+
+  // Hold the writer thread in the destination while the ring fills up.
+  destination->Block();
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:1: first\n");
+  destination->WaitForWrite();
+  for (unsigned int i = 0; i < 19; i++) {
+    async_destination.Write(ola::OLA_LOG_INFO,
+                            "foo.cpp:2: line " + ola::IntToString(i) + "\n");
+  }
+  OLA_ASSERT_EQ(static_cast<uint64_t>(3), async_destination.Dropped());
+
+  destination->Unblock();
+  async_destination.Stop();
+
+  vector<string> lines = destination->Lines();
+  OLA_ASSERT_EQ(static_cast<size_t>(18), lines.size());
+  OLA_ASSERT_EQ(string("foo.cpp:1: first\n"), lines[0]);
+  OLA_ASSERT_TRUE(
+      std::find(lines.begin(), lines.end(),
+                "Dropped 3 log messages, the ring was full\n") !=
+      lines.end());
+}
+
+
+/*
+ * Check no lines are lost when Stop() races with Write().
+ */
+void LoggingTest::testAsyncStopWhileWriting() {
+  const unsigned int THREADS = 4;
+  for (unsigned int round = 0; round < 100; round++) {
+    RecordingLogDestination *destination = new RecordingLogDestination();
+    AsyncLogDestination::Options options;
+    options.ring_size = 64;
+    options.max_lines_per_second = 0;
+    AsyncLogDestination async_destination(destination, options);
+    OLA_ASSERT_TRUE(async_destination.Init());
+
+    volatile bool stop = false;
+    vector<LineWriterThread*> threads;
+    for (unsigned int i = 0; i < THREADS; i++) {
+      threads.push_back(new LineWriterThread(&async_destination, i, &stop));
+      OLA_ASSERT_TRUE(threads.back()->Start());
+    }
+    usleep(1000);
+    // Lines left in the ring by Stop() are never written.
+    async_destination.Stop();
+
+    stop = true;
+    uint64_t written = 0;
+    for (unsigned int i = 0; i < THREADS; i++) {
+      OLA_ASSERT_TRUE(threads[i]->Join());
+      written += threads[i]->Lines();
+      delete threads[i];
+    }
+
+    vector<string> lines = destination->Lines();
+    uint64_t summaries = std::count_if(lines.begin(), lines.end(),
+                                       IsDroppedSummary);
+    OLA_ASSERT_EQ(written,
+                  lines.size() - summaries + async_destination.Dropped());
+  }
+}
+
+
+#ifndef _WIN32
+/*
+ * Check the child writes synchronously after a fork(), as the atfork handlers
+ * leave it.
+ */
+void LoggingTest::testAsyncFork() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination::Options options;
+  options.max_lines_per_second = 0;
+  AsyncLogDestination async_destination(destination, options);
+  OLA_ASSERT_TRUE(async_destination.Init());
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:1: before\n");
+
+  async_destination.Stop();
+  pid_t pid = fork();
+  OLA_ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    async_destination.ResetAfterFork();
+    async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:2: child\n");
+    vector<string> lines = destination->Lines();
+    bool ok = (lines.size() == 2 && lines[1] == "foo.cpp:2: child\n" &&
+               async_destination.Dropped() == 0);
+    // Don't run the destructors, or the cppunit cleanup, in the child.
+    _exit(ok ? 0 : 1);
+  }
+
+  OLA_ASSERT_TRUE(async_destination.Init());
+  async_destination.Write(ola::OLA_LOG_INFO, "foo.cpp:3: parent\n");
+  int status;
+  OLA_ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  OLA_ASSERT_TRUE(WIFEXITED(status));
+  OLA_ASSERT_EQ(0, WEXITSTATUS(status));
+
+  async_destination.Stop();
+  vector<string> lines = destination->Lines();
+  OLA_ASSERT_EQ(static_cast<size_t>(2), lines.size());
+  OLA_ASSERT_EQ(string("foo.cpp:3: parent\n"), lines[1]);
+}
+
+
+/*
+ * Check a daemon can restart the writer thread in the child after a fork().
+ */
+void LoggingTest::testRestartAsyncLogging() {
+  RecordingLogDestination *destination = new RecordingLogDestination();
+  AsyncLogDestination::Options options;
+  options.max_lines_per_second = 0;
+  ola::InitAsyncLogging(ola::OLA_LOG_INFO,
+                        new AsyncLogDestination(destination, options));
+
+  pid_t pid = fork();
+  OLA_ASSERT_NE(-1, pid);
+  if (pid == 0) {
+    // The atfork handler leaves the child writing synchronously.
+    size_t lines = destination->Lines().size();
+    OLA_INFO << "sync";
+    bool ok = (destination->Lines().size() == lines + 1 &&
+               pthread_equal(destination->LastWriter(),
+                             ola::thread::Thread::Self()));
+
+    // Once restarted, lines are queued for the writer thread again. Starting
+    // the thread logs a line too.
+    ok = ok && ola::RestartAsyncLogging();
+    lines = destination->Lines().size();
+    OLA_INFO << "async";
+    ok = ok && destination->WaitForLines(lines + 1) &&
+         !pthread_equal(destination->LastWriter(),
+                        ola::thread::Thread::Self());
+    _exit(ok ? 0 : 1);
+  }
+
+  int status;
+  OLA_ASSERT_EQ(pid, waitpid(pid, &status, 0));
+  OLA_ASSERT_TRUE(WIFEXITED(status));
+  OLA_ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // The parent's writer thread was restarted by the atfork handler.
+  size_t lines = destination->Lines().size();
+  OLA_INFO << "parent";
+  OLA_ASSERT_TRUE(destination->WaitForLines(lines + 1));
+  OLA_ASSERT_FALSE(pthread_equal(destination->LastWriter(),
+                                 ola::thread::Thread::Self()));
+
+  // This deletes the AsyncLogDestination and the destination.
+  ola::InitLogging(ola::OLA_LOG_WARN, ola::OLA_LOG_STDERR);
+}
+#endif  // _WIN32
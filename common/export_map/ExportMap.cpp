@@ -26,17 +26,221 @@
 #include "ola/ExportMap.h"
 #include "ola/StringUtils.h"
 #include "ola/stl/STLUtils.h"
+#include "ola/thread/Mutex.h"
 
 namespace ola {
 
+using ola::thread::MutexLocker;
 using std::map;
 using std::ostringstream;
 using std::string;
 using std::vector;
 
+string BaseVariable::MetricName(const string &name) {
+  string metric = name;
+  for (string::iterator iter = metric.begin(); iter != metric.end(); ++iter) {
+    char c = *iter;
+    if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+          (c >= '0' && c <= '9') || c == '_' || c == ':')) {
+      *iter = '_';
+    }
+  }
+  if (metric.empty() || (metric[0] >= '0' && metric[0] <= '9')) {
+    metric.insert(0, "_");
+  }
+  return metric;
+}
+
+void BaseVariable::AppendMetricType(const string &metric, const char *type,
+                                    string *output) {
+  output->append("# TYPE ");
+  output->append(metric);
+  output->push_back(' ');
+  output->append(type);
+  output->push_back('\n');
+}
+
+void BaseVariable::AppendMetricSample(const string &metric,
+                                      const string &label,
+                                      const string &key,
+                                      const string &value,
+                                      string *output) {
+  output->append(metric);
+  if (!label.empty()) {
+    output->push_back('{');
+    output->append(label);
+    output->append("=\"");
+    output->append(EscapeLabelValue(key));
+    output->append("\"}");
+  }
+  output->push_back(' ');
+  output->append(value);
+  output->push_back('\n');
+}
+
+string BaseVariable::EscapeLabelValue(const string &value) {
+  string escaped;
+  escaped.reserve(value.size());
+  for (string::const_iterator iter = value.begin(); iter != value.end();
+       ++iter) {
+    if (*iter == '\\' || *iter == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(*iter);
+    } else if (*iter == '\n') {
+      escaped.append("\\n");
+    } else {
+      escaped.push_back(*iter);
+    }
+  }
+  return escaped;
+}
+
+void BoolVariable::AppendMetrics(string *output) const {
+  const string metric = MetricName(Name());
+  AppendMetricType(metric, "gauge", output);
+  AppendMetricSample(metric, "", "", Value(), output);
+}
+
+void IntegerVariable::AppendMetrics(string *output) const {
+  const string metric = MetricName(Name());
+  AppendMetricType(metric, "gauge", output);
+  AppendMetricSample(metric, "", "", Value(), output);
+}
+
+void CounterVariable::AppendMetrics(string *output) const {
+  const string metric = MetricName(Name());
+  AppendMetricType(metric, "counter", output);
+  AppendMetricSample(metric + "_total", "", "", Value(), output);
+}
+
+
+void Histogram::Observe(uint64_t value) {
+  // Buckets are inclusive of their upper bound.
+  const unsigned int bucket = std::lower_bound(
+      m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+  MutexLocker locker(&m_mutex);
+  m_buckets[bucket]++;
+  m_count++;
+  m_sum += value;
+}
+
+uint64_t Histogram::BucketCount(unsigned int bucket) const {
+  MutexLocker locker(&m_mutex);
+  return m_buckets[bucket];
+}
+
+uint64_t Histogram::Count() const {
+  MutexLocker locker(&m_mutex);
+  return m_count;
+}
+
+uint64_t Histogram::Sum() const {
+  MutexLocker locker(&m_mutex);
+  return m_sum;
+}
+
+void Histogram::Snapshot(vector<uint64_t> *buckets, uint64_t *count,
+                         uint64_t *sum) const {
+  MutexLocker locker(&m_mutex);
+  *buckets = m_buckets;
+  *count = m_count;
+  *sum = m_sum;
+}
+
+
+HistogramVariable::HistogramVariable(const string &name,
+                                     const string &label,
+                                     const vector<uint64_t> &bounds)
+    : BaseVariable(name),
+      m_label(label),
+      m_bounds(bounds) {
+  std::sort(m_bounds.begin(), m_bounds.end());
+  m_bounds.erase(std::unique(m_bounds.begin(), m_bounds.end()),
+                 m_bounds.end());
+}
+
+HistogramVariable::~HistogramVariable() {
+  STLDeleteValues(&m_histograms);
+}
+
+Histogram *HistogramVariable::Lookup(const string &key) {
+  MutexLocker locker(&m_mutex);
+  HistogramMap::iterator iter = STLLookupOrInsertNull(&m_histograms, key);
+  if (!iter->second) {
+    iter->second = new Histogram(m_bounds);
+  }
+  return iter->second;
+}
+
+void HistogramVariable::Remove(const string &key) {
+  MutexLocker locker(&m_mutex);
+  STLRemoveAndDelete(&m_histograms, key);
+}
+
+const string HistogramVariable::Value() const {
+  ostringstream value;
+  value << "map:" << m_label;
+  MutexLocker locker(&m_mutex);
+  HistogramMap::const_iterator iter = m_histograms.begin();
+  for (; iter != m_histograms.end(); ++iter) {
+    vector<uint64_t> buckets;
+    uint64_t count, sum;
+    iter->second->Snapshot(&buckets, &count, &sum);
+    value << " " << iter->first << ":count=" << count << ",sum=" << sum;
+  }
+  return value.str();
+}
+
+/*
+ * The buckets are cumulative in the OpenMetrics format.
+ */
+void HistogramVariable::AppendMetrics(string *output) const {
+  const string metric = MetricName(Name());
+  const string label = m_label.empty() ? "" : MetricName(m_label);
+  AppendMetricType(metric, "histogram", output);
+
+  MutexLocker locker(&m_mutex);
+  HistogramMap::const_iterator iter = m_histograms.begin();
+  for (; iter != m_histograms.end(); ++iter) {
+    vector<uint64_t> buckets;
+    uint64_t histogram_count, histogram_sum;
+    iter->second->Snapshot(&buckets, &histogram_count, &histogram_sum);
+    string labels;
+    if (!label.empty() && !iter->first.empty()) {
+      labels = label + "=\"" + EscapeLabelValue(iter->first) + "\",";
+    }
+
+    uint64_t total = 0;
+    for (unsigned int i = 0; i <= m_bounds.size(); i++) {
+      total += buckets[i];
+      ostringstream sample;
+      sample << metric << "_bucket{" << labels << "le=\"";
+      if (i == m_bounds.size()) {
+        sample << "+Inf";
+      } else {
+        sample << m_bounds[i];
+      }
+      sample << "\"} " << total << "\n";
+      output->append(sample.str());
+    }
+
+    const string sample_label = labels.empty() ? "" : label;
+    ostringstream count, sum;
+    count << histogram_count;
+    sum << histogram_sum;
+    AppendMetricSample(metric + "_count", sample_label, iter->first,
+                       count.str(), output);
+    AppendMetricSample(metric + "_sum", sample_label, iter->first, sum.str(),
+                       output);
+  }
+}
+
+
 ExportMap::~ExportMap() {
   STLDeleteValues(&m_bool_variables);
+  STLDeleteValues(&m_counter_map_variables);
   STLDeleteValues(&m_counter_variables);
+  STLDeleteValues(&m_histogram_variables);
   STLDeleteValues(&m_int_map_variables);
   STLDeleteValues(&m_int_variables);
   STLDeleteValues(&m_str_map_variables);
@@ -94,14 +298,42 @@ UIntMap *ExportMap::GetUIntMapVar(const string &name, const string &label) {
 }
 
 
+/*
+ * Lookup or create a counter map variable
+ * @param name the name of the variable
+ * @param label the label to use for the map (optional)
+ * @return a MapVariable
+ */
+CounterMap *ExportMap::GetCounterMapVar(const string &name,
+                                        const string &label) {
+  return GetMapVar(&m_counter_map_variables, name, label);
+}
+
+
+HistogramVariable *ExportMap::GetHistogramVar(const string &name,
+                                              const string &label,
+                                              const vector<uint64_t> &bounds) {
+  MutexLocker locker(&m_mutex);
+  map<string, HistogramVariable*>::iterator iter = STLLookupOrInsertNull(
+      &m_histogram_variables, name);
+  if (!iter->second) {
+    iter->second = new HistogramVariable(name, label, bounds);
+  }
+  return iter->second;
+}
+
+
 /*
  * Return a list of all variables.
  * @return a vector of all variables.
  */
 vector<BaseVariable*> ExportMap::AllVariables() const {
   vector<BaseVariable*> variables;
+  MutexLocker locker(&m_mutex);
   STLValues(m_bool_variables, &variables);
+  STLValues(m_counter_map_variables, &variables);
   STLValues(m_counter_variables, &variables);
+  STLValues(m_histogram_variables, &variables);
   STLValues(m_int_map_variables, &variables);
   STLValues(m_int_variables, &variables);
   STLValues(m_str_map_variables, &variables);
@@ -115,6 +347,7 @@ vector<BaseVariable*> ExportMap::AllVariables() const {
 
 template<typename Type>
 Type *ExportMap::GetVar(map<string, Type*> *var_map, const string &name) {
+  MutexLocker locker(&m_mutex);
   typename map<string, Type*>::iterator iter;
   iter = var_map->find(name);
 
@@ -131,6 +364,7 @@ template<typename Type>
 Type *ExportMap::GetMapVar(map<string, Type*> *var_map,
                            const string &name,
                            const string &label) {
+  MutexLocker locker(&m_mutex);
   typename map<string, Type*>::iterator iter;
   iter = var_map->find(name);
 
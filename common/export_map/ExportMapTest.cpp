@@ -19,16 +19,23 @@
  */
 
 #include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 
 #include "ola/ExportMap.h"
+#include "ola/base/Atomic.h"
 #include "ola/testing/TestUtils.h"
+#include "ola/thread/Thread.h"
 
+using ola::AtomicAdd;
 using ola::BaseVariable;
 using ola::BoolVariable;
+using ola::CounterMap;
 using ola::CounterVariable;
 using ola::ExportMap;
+using ola::Histogram;
+using ola::HistogramVariable;
 using ola::IntMap;
 using ola::IntegerVariable;
 using ola::StringMap;
@@ -45,6 +52,10 @@ class ExportMapTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testBoolVariable);
   CPPUNIT_TEST(testStringMapVariable);
   CPPUNIT_TEST(testIntMapVariable);
+  CPPUNIT_TEST(testHistogramVariable);
+  CPPUNIT_TEST(testHistogramThreads);
+  CPPUNIT_TEST(testMapThreads);
+  CPPUNIT_TEST(testMetrics);
   CPPUNIT_TEST(testExportMap);
   CPPUNIT_TEST_SUITE_END();
 
@@ -55,6 +66,10 @@ class ExportMapTest: public CppUnit::TestFixture {
     void testBoolVariable();
     void testStringMapVariable();
     void testIntMapVariable();
+    void testHistogramVariable();
+    void testHistogramThreads();
+    void testMapThreads();
+    void testMetrics();
     void testExportMap();
 };
 
@@ -62,6 +77,66 @@ class ExportMapTest: public CppUnit::TestFixture {
 CPPUNIT_TEST_SUITE_REGISTRATION(ExportMapTest);
 
 
+/*
+ * Makes observations from another thread, like a Universe does while the
+ * ExportMap is served.
+ */
+class ObserverThread: public ola::thread::Thread {
+ public:
+    ObserverThread(HistogramVariable *var, unsigned int observations)
+        : Thread(),
+          m_var(var),
+          m_observations(observations) {
+    }
+
+    void *Run() {
+      for (unsigned int i = 0; i < m_observations; i++) {
+        m_var->Lookup("1")->Observe(1);
+        if (i % 100 == 0) {
+          m_var->Remove("2");
+          m_var->Lookup("2")->Observe(1);
+        }
+      }
+      return NULL;
+    }
+
+ private:
+    HistogramVariable *m_var;
+    const unsigned int m_observations;
+};
+
+
+/*
+ * Updates a CounterMap from another thread, through a cached entry like a
+ * Universe does, and by adding and removing keys.
+ */
+class CounterThread: public ola::thread::Thread {
+ public:
+    CounterThread(CounterMap *var, unsigned int updates)
+        : Thread(),
+          m_var(var),
+          m_updates(updates) {
+    }
+
+    void *Run() {
+      unsigned int *count = &(*m_var)["1"];
+      for (unsigned int i = 0; i < m_updates; i++) {
+        AtomicAdd(count, 1);
+        m_var->Increment("2");
+        if (i % 100 == 0) {
+          m_var->Remove("3");
+          m_var->Set("3", i);
+        }
+      }
+      return NULL;
+    }
+
+ private:
+    CounterMap *m_var;
+    const unsigned int m_updates;
+};
+
+
 /*
  * Check that the IntegerVariable works correctly.
  */
@@ -211,8 +286,155 @@ void ExportMapTest::testIntMapVariable() {
   // check increments work
   var.Increment(key1);
   OLA_ASSERT_EQ(var.Value(), string("map:count key1:1"));
+  var.Decrement(key1);
+  var.Decrement(key1);
+  OLA_ASSERT_EQ(var.Value(), string("map:count key1:-1"));
+}
+
+/*
+ * Check that the HistogramVariable works correctly.
+ */
+void ExportMapTest::testHistogramVariable() {
+  vector<uint64_t> bounds;
+  bounds.push_back(100);
+  bounds.push_back(10);
+  bounds.push_back(100);
+  HistogramVariable var("foo", "universe", bounds);
+
+  OLA_ASSERT_EQ(string("foo"), var.Name());
+  OLA_ASSERT_EQ(string("universe"), var.Label());
+  OLA_ASSERT_EQ(static_cast<size_t>(2), var.Bounds().size());
+  OLA_ASSERT_EQ(static_cast<uint64_t>(10), var.Bounds()[0]);
+  OLA_ASSERT_EQ(string("map:universe"), var.Value());
+
+  Histogram *histogram = var.Lookup("1");
+  OLA_ASSERT_EQ(histogram, var.Lookup("1"));
+  histogram->Observe(0);
+  histogram->Observe(10);
+  histogram->Observe(11);
+  histogram->Observe(1000);
+  OLA_ASSERT_EQ(static_cast<uint64_t>(2), histogram->BucketCount(0));
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), histogram->BucketCount(1));
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), histogram->BucketCount(2));
+  OLA_ASSERT_EQ(static_cast<uint64_t>(4), histogram->Count());
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1021), histogram->Sum());
+  OLA_ASSERT_EQ(string("map:universe 1:count=4,sum=1021"), var.Value());
+
+  var.Remove("1");
+  OLA_ASSERT_EQ(string("map:universe"), var.Value());
+}
+
+
+/*
+ * Check the histograms can be read while another thread updates them.
+ */
+void ExportMapTest::testHistogramThreads() {
+  vector<uint64_t> bounds;
+  bounds.push_back(10);
+  HistogramVariable var("foo", "universe", bounds);
+
+  const unsigned int observations = 100000;
+  ObserverThread thread(&var, observations);
+  OLA_ASSERT_TRUE(thread.Start());
+  for (unsigned int i = 0; i < 1000; i++) {
+    string metrics;
+    var.AppendMetrics(&metrics);
+    OLA_ASSERT_FALSE(metrics.empty());
+    // Every value is 1, so the count and sum always match.
+    Histogram *histogram = var.Lookup("1");
+    vector<uint64_t> buckets;
+    uint64_t count, sum;
+    histogram->Snapshot(&buckets, &count, &sum);
+    OLA_ASSERT_EQ(count, sum);
+    OLA_ASSERT_EQ(count, buckets[0]);
+  }
+  OLA_ASSERT_TRUE(thread.Join());
+
+  OLA_ASSERT_EQ(static_cast<uint64_t>(observations),
+                var.Lookup("1")->Count());
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), var.Lookup("2")->Count());
+}
+
+
+/*
+ * Check a map can be read while another thread updates it.
+ */
+void ExportMapTest::testMapThreads() {
+  CounterMap var("foo", "universe");
+
+  const unsigned int updates = 100000;
+  CounterThread thread(&var, updates);
+  OLA_ASSERT_TRUE(thread.Start());
+  for (unsigned int i = 0; i < 1000; i++) {
+    string metrics;
+    var.AppendMetrics(&metrics);
+    OLA_ASSERT_FALSE(metrics.empty());
+    OLA_ASSERT_FALSE(var.Value().empty());
+  }
+  OLA_ASSERT_TRUE(thread.Join());
+
+  OLA_ASSERT_EQ(updates, var["1"]);
+  OLA_ASSERT_EQ(updates, var["2"]);
 }
 
+
+/*
+ * Check the OpenMetrics output.
+ */
+void ExportMapTest::testMetrics() {
+  ExportMap map;
+  (*map.GetCounterVar("rpc-sent")) += 3;
+  map.GetIntegerVar("timers")->Set(-2);
+  map.GetBoolVar("using-epoll")->Set(true);
+  map.GetStringVar("ignored")->Set("foo");
+
+  CounterMap *frames = map.GetCounterMapVar("universe-dmx-frames", "universe");
+  (*frames)["1"] = 10;
+  (*frames)["2\""] = 1;
+  IntMap *ports = map.GetIntMapVar("ports");
+  ports->Set("a", 1);
+
+  vector<uint64_t> bounds;
+  bounds.push_back(10);
+  bounds.push_back(100);
+  map.GetHistogramVar("latency", "universe", bounds)->Lookup("1")->Observe(50);
+  map.GetHistogramVar("other", "", bounds)->Lookup("")->Observe(5);
+
+  string output;
+  vector<BaseVariable*> variables = map.AllVariables();
+  vector<BaseVariable*>::const_iterator iter = variables.begin();
+  for (; iter != variables.end(); ++iter) {
+    (*iter)->AppendMetrics(&output);
+  }
+
+  const string expected =
+      "# TYPE latency histogram\n"
+      "latency_bucket{universe=\"1\",le=\"10\"} 0\n"
+      "latency_bucket{universe=\"1\",le=\"100\"} 1\n"
+      "latency_bucket{universe=\"1\",le=\"+Inf\"} 1\n"
+      "latency_count{universe=\"1\"} 1\n"
+      "latency_sum{universe=\"1\"} 50\n"
+      "# TYPE other histogram\n"
+      "other_bucket{le=\"10\"} 1\n"
+      "other_bucket{le=\"100\"} 1\n"
+      "other_bucket{le=\"+Inf\"} 1\n"
+      "other_count 1\n"
+      "other_sum 5\n"
+      "# TYPE ports gauge\n"
+      "ports{key=\"a\"} 1\n"
+      "# TYPE rpc_sent counter\n"
+      "rpc_sent_total 3\n"
+      "# TYPE timers gauge\n"
+      "timers -2\n"
+      "# TYPE universe_dmx_frames counter\n"
+      "universe_dmx_frames_total{universe=\"1\"} 10\n"
+      "universe_dmx_frames_total{universe=\"2\\\"\"} 1\n"
+      "# TYPE using_epoll gauge\n"
+      "using_epoll 1\n";
+  OLA_ASSERT_EQ(expected, output);
+}
+
+
 /*
  * Check the export map works correctly.
  */
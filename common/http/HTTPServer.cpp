@@ -23,22 +23,32 @@
 #endif  // HAVE_CONFIG_H
 
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <ola/Logging.h>
+#include <ola/StringUtils.h>
+#include <ola/base/Array.h>
 #include <ola/base/Macro.h>
 #include <ola/file/Util.h>
 #include <ola/http/HTTPServer.h>
 #include <ola/io/Descriptor.h>
+#include <ola/thread/Mutex.h>
+#include <ola/util/Deleter.h>
 #include <ola/web/Json.h>
-#include <ola/web/JsonWriter.h>
+#include <ola/web/JsonStreamWriter.h>
 
 #ifdef _WIN32
 #include <ola/win/CleanWinSock2.h>
 #endif  // _WIN32
 
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -68,8 +78,9 @@ using std::set;
 using std::string;
 using std::vector;
 using ola::io::UnmanagedFileDescriptor;
+using ola::thread::MutexLocker;
+using ola::web::JsonStreamWriter;
 using ola::web::JsonValue;
-using ola::web::JsonWriter;
 
 const char HTTPServer::CONTENT_TYPE_PLAIN[] = "text/plain";
 const char HTTPServer::CONTENT_TYPE_HTML[] = "text/html";
@@ -81,6 +92,29 @@ const char HTTPServer::CONTENT_TYPE_JS[] = "text/javascript";
 const char HTTPServer::CONTENT_TYPE_OCT[] = "application/octet-stream";
 const char HTTPServer::CONTENT_TYPE_JSON[] = "application/json";
 const char HTTPServer::CONTENT_TYPE_XML[] = "application/xml";
+const char HTTPServer::CONTENT_TYPE_EVENT_STREAM[] = "text/event-stream";
+const char HTTPServer::CONTENT_TYPE_OPENMETRICS[] =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+const unsigned int HTTPRequest::K_MAX_POST_DATA_SIZE;
+
+// Older versions of libmicrohttpd don't define these.
+#ifndef MHD_SIZE_UNKNOWN
+#define MHD_SIZE_UNKNOWN -1
+#endif  // MHD_SIZE_UNKNOWN
+#ifndef MHD_CONTENT_READER_END_OF_STREAM
+#define MHD_CONTENT_READER_END_OF_STREAM -1
+#endif  // MHD_CONTENT_READER_END_OF_STREAM
+
+const size_t HTTPEventStream::MAX_PENDING_BYTES;
+
+// The largest block we hand to libmicrohttpd for an event stream.
+static const size_t EVENT_STREAM_BLOCK_SIZE = 4096;
+
+// Static files are unversioned, so pages are always revalidated, which is
+// cheap thanks to the ETag. Everything else can be reused for a while.
+static const char HTML_CACHE_CONTROL[] = "no-cache";
+static const char STATIC_CACHE_CONTROL[] = "public, max-age=3600";
 
 /**
  * @brief Called by MHD_get_connection_values to add headers to a request
@@ -125,6 +159,125 @@ int IteratePost(void *request_cls, OLA_UNUSED enum MHD_ValueKind kind,
 }
 
 
+/**
+ * @brief Split a header value into its comma separated elements.
+ */
+static void SplitHeader(const char *value, vector<string> *elements) {
+  if (!value) {
+    return;
+  }
+  vector<string> tokens;
+  ola::StringSplit(value, &tokens, ",");
+  vector<string>::iterator iter = tokens.begin();
+  for (; iter != tokens.end(); ++iter) {
+    ola::StringTrim(&(*iter));
+    if (!iter->empty()) {
+      elements->push_back(*iter);
+    }
+  }
+}
+
+
+/**
+ * @brief Check if an Accept-Encoding element, e.g. gzip;q=0.5, has a weight
+ *   of 0, which means the coding is not acceptable.
+ */
+static bool HasZeroWeight(const vector<string> &params) {
+  for (unsigned int i = 1; i < params.size(); i++) {
+    string param = params[i];
+    ola::StringTrim(&param);
+    ola::ToLower(&param);
+    if (param.compare(0, 2, "q=")) {
+      continue;
+    }
+    // A qvalue has at most 3 decimal places.
+    string value = param.substr(2);
+    return (value == "0" || value == "0." || value == "0.0" ||
+            value == "0.00" || value == "0.000");
+  }
+  return false;
+}
+
+
+/**
+ * @brief Check if the client will accept a gzip encoded response.
+ *
+ * An explicit gzip element takes precedence over *, which matches any coding
+ * that isn't listed.
+ */
+static bool AcceptsGzip(struct MHD_Connection *connection) {
+  vector<string> encodings;
+  SplitHeader(MHD_lookup_connection_value(connection, MHD_HEADER_KIND,
+                                          MHD_HTTP_HEADER_ACCEPT_ENCODING),
+              &encodings);
+  bool wildcard = false;
+  vector<string>::iterator iter = encodings.begin();
+  for (; iter != encodings.end(); ++iter) {
+    vector<string> params;
+    ola::StringSplit(*iter, &params, ";");
+    string coding = params[0];
+    ola::StringTrim(&coding);
+    ola::ToLower(&coding);
+    if (coding == "gzip" || coding == "x-gzip") {
+      return !HasZeroWeight(params);
+    } else if (coding == "*") {
+      wildcard = !HasZeroWeight(params);
+    }
+  }
+  return wildcard;
+}
+
+
+/**
+ * @brief Check if the client already has a copy of the entity.
+ */
+static bool ETagMatches(struct MHD_Connection *connection,
+                        const string &etag) {
+  vector<string> tags;
+  SplitHeader(MHD_lookup_connection_value(connection, MHD_HEADER_KIND,
+                                          MHD_HTTP_HEADER_IF_NONE_MATCH),
+              &tags);
+  vector<string>::iterator iter = tags.begin();
+  for (; iter != tags.end(); ++iter) {
+    // If-None-Match uses the weak comparison.
+    if (*iter == "*" || *iter == etag || *iter == "W/" + etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * @brief Build a strong ETag from the FNV-1a hash of the content.
+ */
+static string ContentETag(const string &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (string::const_iterator iter = data.begin(); iter != data.end();
+       ++iter) {
+    hash ^= static_cast<uint8_t>(*iter);
+    hash *= 1099511628211ULL;
+  }
+  std::ostringstream str;
+  str << '"' << std::hex << std::setw(16) << std::setfill('0') << hash << '"';
+  return str.str();
+}
+
+
+/**
+ * @brief Build a response that references data, which must outlive it.
+ */
+static struct MHD_Response *BuildPersistentResponse(const string &data) {
+  void *buffer = static_cast<void*>(const_cast<char*>(data.data()));
+#ifdef HAVE_MHD_CREATE_RESPONSE_FROM_BUFFER
+  return MHD_create_response_from_buffer(data.size(), buffer,
+                                         MHD_RESPMEM_PERSISTENT);
+#else
+  return MHD_create_response_from_data(data.size(), buffer, MHD_NO, MHD_NO);
+#endif  // HAVE_MHD_CREATE_RESPONSE_FROM_BUFFER
+}
+
+
 /**
  * @brief Called whenever a new request is made.
  *
@@ -160,29 +313,55 @@ static int HandleRequest(void *http_server_ptr,
   request = static_cast<HTTPRequest*>(*ptr);
 
   if (request->InFlight()) {
-    // don't dispatch more than once
-    return MHD_YES;
+    // don't dispatch more than once, but if the connection was resumed the
+    // response is waiting for us.
+    return request->QueuePendingResponse();
   }
 
   if (request->Method() == MHD_HTTP_METHOD_GET) {
     HTTPResponse *response = new HTTPResponse(connection);
     request->SetInFlight();
+    if (http_server->UsesDaemonThreads()) {
+      return http_server->DispatchDaemonRequest(request, response);
+    }
     return http_server->DispatchRequest(request, response);
 
   } else if (request->Method() == MHD_HTTP_METHOD_POST) {
     if (*upload_data_size != 0) {
-      request->ProcessPostData(upload_data, upload_data_size);
+      if (!request->ProcessPostData(upload_data, upload_data_size)) {
+        return MHD_NO;
+      }
       *upload_data_size = 0;
       return MHD_YES;
     }
     request->SetInFlight();
     HTTPResponse *response = new HTTPResponse(connection);
+    if (http_server->UsesDaemonThreads()) {
+      return http_server->DispatchDaemonRequest(request, response);
+    }
     return http_server->DispatchRequest(request, response);
   }
   return MHD_NO;
 }
 
 
+/**
+ * @brief Called by libmicrohttpd when it's ready for more event stream data.
+ */
+static ssize_t ReadEventStream(void *cls, OLA_UNUSED uint64_t pos, char *buf,
+                               size_t max) {
+  return static_cast<HTTPEventStream*>(cls)->Read(buf, max);
+}
+
+
+/**
+ * @brief Called by libmicrohttpd when an event stream connection closes.
+ */
+static void FreeEventStream(void *cls) {
+  static_cast<HTTPEventStream*>(cls)->ConnectionClosed();
+}
+
+
 /**
  * @brief Called when a request completes.
  *
@@ -215,7 +394,10 @@ HTTPRequest::HTTPRequest(const string &url,
   m_version(version),
   m_connection(connection),
   m_processor(NULL),
-  m_in_flight(false) {
+  m_in_flight(false),
+  m_pending_response(NULL),
+  m_pending_status_code(MHD_HTTP_OK),
+  m_pending_owned(false) {
 }
 
 
@@ -227,11 +409,12 @@ bool HTTPRequest::Init() {
   MHD_get_connection_values(m_connection, MHD_HEADER_KIND, AddHeaders, this);
 
   if (m_method == MHD_HTTP_METHOD_POST) {
+    // This fails if the body isn't form encoded, in which case we keep the
+    // raw data instead.
     m_processor = MHD_create_post_processor(m_connection,
                                             K_POST_BUFFER_SIZE,
                                             IteratePost,
                                             static_cast<void*>(this));
-    return m_processor;
   }
   return true;
 }
@@ -244,6 +427,37 @@ HTTPRequest::~HTTPRequest() {
   if (m_processor) {
     MHD_destroy_post_processor(m_processor);
   }
+  if (m_pending_response && m_pending_owned) {
+    MHD_destroy_response(m_pending_response);
+  }
+}
+
+
+void HTTPRequest::SetPendingResponse(struct MHD_Response *response,
+                                     unsigned int status_code,
+                                     bool owned) {
+  m_pending_response = response;
+  m_pending_status_code = status_code;
+  m_pending_owned = owned;
+}
+
+
+/**
+ * @brief Queue the pending response.
+ * @returns MHD_YES if there isn't a response yet, otherwise the result of
+ *   queuing it.
+ */
+int HTTPRequest::QueuePendingResponse() {
+  if (!m_pending_response) {
+    return MHD_YES;
+  }
+  int ret = MHD_queue_response(m_connection, m_pending_status_code,
+                               m_pending_response);
+  if (m_pending_owned) {
+    MHD_destroy_response(m_pending_response);
+  }
+  m_pending_response = NULL;
+  return ret;
 }
 
 
@@ -279,25 +493,40 @@ void HTTPRequest::AddPostParameter(const string &key, const string &value) {
 
 /**
  * @brief Process post data
+ * @returns false if the body is too large.
  */
-void HTTPRequest::ProcessPostData(const char *data, size_t *data_size) {
-  MHD_post_process(m_processor, data, *data_size);
+bool HTTPRequest::ProcessPostData(const char *data, size_t *data_size) {
+  if (m_processor) {
+    MHD_post_process(m_processor, data, *data_size);
+    return true;
+  }
+
+  if (m_post_data.size() + *data_size > K_MAX_POST_DATA_SIZE) {
+    OLA_WARN << "POST body for " << m_url << " is larger than "
+             << K_MAX_POST_DATA_SIZE << " bytes";
+    return false;
+  }
+  m_post_data.append(data, *data_size);
+  return true;
 }
 
 
 /**
  * @brief Return the value of the header sent with this request
- * @param key the name of the header
+ * @param key the name of the header, this is case insensitive.
  * @returns the value of the header or empty string if it doesn't exist.
  */
 const string HTTPRequest::GetHeader(const string &key) const {
   map<string, string>::const_iterator iter = m_headers.find(key);
 
-  if (iter == m_headers.end()) {
-    return "";
-  } else {
+  if (iter != m_headers.end()) {
     return iter->second;
   }
+  // Fall back to libmicrohttpd, which ignores the case of the name.
+  const char *value = MHD_lookup_connection_value(m_connection,
+                                                  MHD_HEADER_KIND,
+                                                  key.c_str());
+  return value ? string(value) : string();
 }
 
 
@@ -391,7 +620,9 @@ void HTTPResponse::SetHeader(const string &key, const string &value) {
  * @return true on success, false on error
  */
 int HTTPResponse::SendJson(const JsonValue &json) {
-  const string output = JsonWriter::AsString(json);
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.Value(json);
   struct MHD_Response *response = HTTPServer::BuildResponse(
       static_cast<void*>(const_cast<char*>(output.data())),
       output.length());
@@ -401,9 +632,7 @@ int HTTPResponse::SendJson(const JsonValue &json) {
                             iter->first.c_str(),
                             iter->second.c_str());
   }
-  int ret = MHD_queue_response(m_connection, m_status_code, response);
-  MHD_destroy_response(response);
-  return ret;
+  return QueueResponse(response, m_status_code, true);
 }
 
 
@@ -421,22 +650,232 @@ int HTTPResponse::Send() {
                             iter->first.c_str(),
                             iter->second.c_str());
   }
-  int ret = MHD_queue_response(m_connection, m_status_code, response);
-  MHD_destroy_response(response);
+  return QueueResponse(response, m_status_code, true);
+}
+
+
+/**
+ * @brief Send an event stream as the response.
+ * @param stream the HTTPEventStream, ownership is transferred.
+ * @return true on success, false on error
+ */
+int HTTPResponse::SendEventStream(HTTPEventStream *stream) {
+  struct MHD_Response *response = MHD_create_response_from_callback(
+      MHD_SIZE_UNKNOWN, EVENT_STREAM_BLOCK_SIZE, &ReadEventStream, stream,
+      &FreeEventStream);
+  if (!response) {
+    delete stream;
+    return MHD_NO;
+  }
+
+  if (m_server) {
+    stream->Attach(m_server, m_connection);
+    m_server->AddEventStream(stream);
+  }
+
+  SetContentType(HTTPServer::CONTENT_TYPE_EVENT_STREAM);
+  SetNoCache();
+  HeadersMultiMap::const_iterator iter;
+  for (iter = m_headers.begin(); iter != m_headers.end(); ++iter) {
+    MHD_add_response_header(response,
+                            iter->first.c_str(),
+                            iter->second.c_str());
+  }
+  return QueueResponse(response, m_status_code, true);
+}
+
+
+int HTTPResponse::QueueResponse(struct MHD_Response *response,
+                                unsigned int status_code,
+                                bool owned) {
+  if (m_server) {
+    return m_server->CompleteDeferredRequest(m_request, response, status_code,
+                                             owned);
+  }
+  int ret = MHD_queue_response(m_connection, status_code, response);
+  if (owned) {
+    MHD_destroy_response(response);
+  }
   return ret;
 }
 
 
+HTTPEventStream::HTTPEventStream(SingleUseCallback0<void> *on_close)
+    : m_offset(0),
+      m_closed(false),
+      m_on_close(on_close),
+      m_server(NULL),
+      m_connection(NULL),
+      m_suspended(false) {
+}
+
+
+HTTPEventStream::~HTTPEventStream() {
+  if (m_on_close) {
+    m_on_close->Run();
+  }
+}
+
+
+bool HTTPEventStream::SendEvent(const string &event, const string &data) {
+  string output;
+  if (!event.empty()) {
+    output.append("event: ");
+    output.append(event);
+    output.push_back('\n');
+  }
+
+  // Each line of the data needs its own field.
+  size_t start = 0;
+  while (true) {
+    size_t end = data.find('\n', start);
+    output.append("data: ");
+    output.append(data, start,
+                  end == string::npos ? string::npos : end - start);
+    output.push_back('\n');
+    if (end == string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+  output.push_back('\n');
+  return Append(output);
+}
+
+
+bool HTTPEventStream::SendComment(const string &comment) {
+  return Append(": " + comment + "\n\n");
+}
+
+
+void HTTPEventStream::Close() {
+  MutexLocker lock(&m_mutex);
+  m_closed = true;
+  Resume();
+}
+
+
+size_t HTTPEventStream::PendingBytes() const {
+  MutexLocker lock(&m_mutex);
+  return m_buffer.size() - m_offset;
+}
+
+
+void HTTPEventStream::SetOnClose(SingleUseCallback0<void> *on_close) {
+  delete m_on_close;
+  m_on_close = on_close;
+}
+
+
+/**
+ * @brief Copy queued data into a libmicrohttpd buffer.
+ * @returns the number of bytes copied, 0 if there isn't any data yet, or
+ *   MHD_CONTENT_READER_END_OF_STREAM if the stream has been closed.
+ */
+ssize_t HTTPEventStream::Read(char *buffer, size_t max) {
+  MutexLocker lock(&m_mutex);
+  size_t pending = m_buffer.size() - m_offset;
+  if (!pending) {
+    if (m_closed) {
+      return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+    if (m_connection) {
+      // libmicrohttpd's own threads would spin, so park the connection until
+      // there is more data.
+      MHD_suspend_connection(m_connection);
+      m_suspended = true;
+    }
+    // Otherwise libmicrohttpd polls us again each time MHD_run() is called.
+    return 0;
+  }
+
+  size_t size = std::min(pending, max);
+  memcpy(buffer, m_buffer.data() + m_offset, size);
+  m_offset += size;
+  if (m_offset == m_buffer.size()) {
+    m_buffer.clear();
+    m_offset = 0;
+  }
+  return size;
+}
+
+
+/**
+ * @brief Called when the connection is used by libmicrohttpd's own threads.
+ */
+void HTTPEventStream::Attach(HTTPServer *server,
+                             struct MHD_Connection *connection) {
+  MutexLocker lock(&m_mutex);
+  m_server = server;
+  m_connection = connection;
+}
+
+
+/**
+ * @brief Called by libmicrohttpd once it's finished with the stream.
+ *
+ * If libmicrohttpd runs its own threads, the stream is deleted on the
+ * HTTPServer thread, so the on_close callback runs there.
+ */
+void HTTPEventStream::ConnectionClosed() {
+  HTTPServer *server;
+  {
+    MutexLocker lock(&m_mutex);
+    server = m_server;
+    m_server = NULL;
+    m_connection = NULL;
+    m_suspended = false;
+    m_closed = true;
+  }
+
+  if (server) {
+    server->EventStreamClosed(this);
+  } else {
+    delete this;
+  }
+}
+
+
+bool HTTPEventStream::Append(const string &data) {
+  MutexLocker lock(&m_mutex);
+  if (m_closed ||
+      m_buffer.size() - m_offset + data.size() > MAX_PENDING_BYTES) {
+    return false;
+  }
+  if (m_offset) {
+    m_buffer.erase(0, m_offset);
+    m_offset = 0;
+  }
+  m_buffer.append(data);
+  Resume();
+  return true;
+}
+
+
+/**
+ * @brief Wake up a suspended connection, m_mutex must be held.
+ */
+void HTTPEventStream::Resume() {
+  if (m_suspended) {
+    MHD_resume_connection(m_connection);
+    m_suspended = false;
+  }
+}
+
+
 /**
  * @brief Setup the HTTP server.
  * @param options the configuration options for the server
  */
 HTTPServer::HTTPServer(const HTTPServerOptions &options)
     : Thread(Thread::Options("http")),
+      m_stopping(false),
+      m_running_request(NULL),
       m_httpd(NULL),
       m_default_handler(NULL),
       m_port(options.port),
-      m_data_dir(options.data_dir) {
+      m_data_dir(options.data_dir),
+      m_thread_pool_size(options.thread_pool_size) {
   ola::io::SelectServer::Options ss_options;
   // See issue #761. epoll/kqueue can't be used with the current
   // implementation.
@@ -452,9 +891,17 @@ HTTPServer::~HTTPServer() {
   Stop();
 
   if (m_httpd) {
+    if (UsesDaemonThreads()) {
+      ResumeDaemonConnections();
+    }
     MHD_stop_daemon(m_httpd);
   }
 
+  map<string, static_file_info>::iterator file_iter = m_static_content.begin();
+  for (; file_iter != m_static_content.end(); ++file_iter) {
+    FreeCachedFile(file_iter->second.cached_file);
+  }
+
   map<string, BaseHTTPCallback*>::const_iterator iter;
   for (iter = m_handlers.begin(); iter != m_handlers.end(); ++iter) {
     delete iter->second;
@@ -479,6 +926,40 @@ bool HTTPServer::Init() {
     return false;
   }
 
+  // Static files may be served as soon as the daemon starts.
+  LoadStaticContent();
+
+  if (m_thread_pool_size) {
+#if HAVE_DECL_MHD_USE_SUSPEND_RESUME
+    unsigned int flags = MHD_USE_SELECT_INTERNALLY | MHD_USE_SUSPEND_RESUME;
+#if HAVE_DECL_MHD_USE_EPOLL
+    if (MHD_is_feature_supported(MHD_FEATURE_EPOLL) == MHD_YES) {
+      flags |= MHD_USE_EPOLL;
+    }
+#endif  // HAVE_DECL_MHD_USE_EPOLL
+    m_httpd = MHD_start_daemon(flags,
+                               m_port,
+                               NULL,
+                               NULL,
+                               &HandleRequest,
+                               this,
+                               MHD_OPTION_NOTIFY_COMPLETED,
+                               RequestCompleted,
+                               NULL,
+                               MHD_OPTION_THREAD_POOL_SIZE,
+                               m_thread_pool_size,
+                               MHD_OPTION_END);
+    if (m_httpd) {
+      OLA_INFO << "HTTP Server using " << m_thread_pool_size << " threads";
+    }
+    return m_httpd ? true : false;
+#else
+    OLA_WARN << "libmicrohttpd doesn't support suspending connections, "
+             << "ignoring the HTTP thread pool size";
+    m_thread_pool_size = 0;
+#endif  // HAVE_DECL_MHD_USE_SUSPEND_RESUME
+  }
+
   m_httpd = MHD_start_daemon(MHD_NO_FLAG,
                              m_port,
                              NULL,
@@ -650,6 +1131,146 @@ int HTTPServer::DispatchRequest(const HTTPRequest *request,
 }
 
 
+/**
+ * @brief Called from one of libmicrohttpd's threads when a request arrives.
+ *
+ * The handlers, and the OlaClient they use, aren't thread safe so the
+ * connection is suspended and the request is run on our SelectServer thread.
+ * Static files don't need any of that and are served right away.
+ */
+int HTTPServer::DispatchDaemonRequest(HTTPRequest *request,
+                                      HTTPResponse *response) {
+  // Neither of these change once the server is running.
+  if (m_handlers.find(request->Url()) == m_handlers.end()) {
+    map<string, static_file_info>::iterator file_iter =
+        m_static_content.find(request->Url());
+    if (file_iter != m_static_content.end()) {
+      return ServeStaticContent(&(file_iter->second), response);
+    }
+  }
+
+  {
+    MutexLocker lock(&m_daemon_mutex);
+    if (m_stopping) {
+      delete response;
+      return MHD_NO;
+    }
+    MHD_suspend_connection(response->Connection());
+    m_deferred_requests[request] = response->Connection();
+  }
+
+  response->SetDeferred(this, request);
+  m_select_server->Execute(
+      NewSingleCallback(this, &HTTPServer::RunDeferredRequest, request,
+                        response));
+  return MHD_YES;
+}
+
+
+/**
+ * @brief Queue the response for a deferred request and resume the connection.
+ *
+ * This is called on our SelectServer thread, the response is queued when
+ * libmicrohttpd calls HandleRequest() again.
+ */
+int HTTPServer::CompleteDeferredRequest(HTTPRequest *request,
+                                        struct MHD_Response *response,
+                                        unsigned int status_code,
+                                        bool owned) {
+  MutexLocker lock(&m_daemon_mutex);
+  map<HTTPRequest*, struct MHD_Connection*>::iterator iter =
+      m_deferred_requests.find(request);
+  if (iter == m_deferred_requests.end()) {
+    OLA_WARN << "Response sent twice for " << request->Url();
+    if (owned) {
+      MHD_destroy_response(response);
+    }
+    return MHD_NO;
+  }
+
+  request->SetPendingResponse(response, status_code, owned);
+  MHD_resume_connection(iter->second);
+  m_deferred_requests.erase(iter);
+  if (request == m_running_request) {
+    m_running_request = NULL;
+  }
+  return MHD_YES;
+}
+
+
+void HTTPServer::AddEventStream(HTTPEventStream *stream) {
+  MutexLocker lock(&m_stream_mutex);
+  m_event_streams.insert(stream);
+}
+
+
+/**
+ * @brief Called from one of libmicrohttpd's threads when an event stream
+ *   connection closes.
+ */
+void HTTPServer::EventStreamClosed(HTTPEventStream *stream) {
+  {
+    MutexLocker lock(&m_stream_mutex);
+    m_event_streams.erase(stream);
+  }
+  // If we're stopping, this runs when the SelectServer is destroyed.
+  m_select_server->Execute(ola::DeletePointerCallback(stream));
+}
+
+
+void HTTPServer::RunDeferredRequest(HTTPRequest *request,
+                                    HTTPResponse *response) {
+  {
+    MutexLocker lock(&m_daemon_mutex);
+    if (m_stopping) {
+      delete response;
+      return;
+    }
+  }
+
+  m_running_request = request;
+  if (DispatchRequest(request, response) == MHD_NO && m_running_request) {
+    // The handler failed without sending a response. The connection is
+    // suspended, so rather than leave it hanging, send an error.
+    OLA_WARN << "No response for " << request->Url();
+    CompleteDeferredRequest(request, BuildResponse(NULL, 0),
+                            MHD_HTTP_INTERNAL_SERVER_ERROR, true);
+  }
+  m_running_request = NULL;
+}
+
+
+/**
+ * @brief Resume all the suspended connections, libmicrohttpd can't be stopped
+ *   until this is done.
+ */
+void HTTPServer::ResumeDaemonConnections() {
+  {
+    MutexLocker lock(&m_daemon_mutex);
+    m_stopping = true;
+    map<HTTPRequest*, struct MHD_Connection*>::iterator iter =
+        m_deferred_requests.begin();
+    for (; iter != m_deferred_requests.end(); ++iter) {
+      iter->first->SetPendingResponse(BuildResponse(NULL, 0),
+                                      MHD_HTTP_SERVICE_UNAVAILABLE, true);
+      MHD_resume_connection(iter->second);
+    }
+    m_deferred_requests.clear();
+  }
+
+  // Streams are only deleted on our SelectServer thread, which has stopped.
+  set<HTTPEventStream*> streams;
+  {
+    MutexLocker lock(&m_stream_mutex);
+    streams = m_event_streams;
+  }
+  set<HTTPEventStream*>::iterator iter = streams.begin();
+  for (; iter != streams.end(); ++iter) {
+    (*iter)->Close();
+  }
+}
+
+
 /**
  * @brief Register a handler
  * @param path the url to respond on
@@ -703,6 +1324,7 @@ bool HTTPServer::RegisterFile(const std::string &path,
   static_file_info file_info;
   file_info.file_path = file;
   file_info.content_type = content_type;
+  file_info.cached_file = NULL;
 
   pair<string, static_file_info> pair(path, file_info);
   m_static_content.insert(pair);
@@ -792,6 +1414,7 @@ int HTTPServer::ServeStaticContent(const std::string &path,
   static_file_info file_info;
   file_info.file_path = path;
   file_info.content_type = content_type;
+  file_info.cached_file = NULL;
   return ServeStaticContent(&file_info, response);
 }
 
@@ -803,6 +1426,10 @@ int HTTPServer::ServeStaticContent(const std::string &path,
  */
 int HTTPServer::ServeStaticContent(static_file_info *file_info,
                                    HTTPResponse *response) {
+  if (file_info->cached_file) {
+    return ServeCachedFile(file_info->cached_file, response);
+  }
+
   char *data;
   unsigned int length;
   string file_path = m_data_dir;
@@ -826,6 +1453,7 @@ int HTTPServer::ServeStaticContent(static_file_info *file_info,
 
   struct MHD_Response *mhd_response = BuildResponse(static_cast<void*>(data),
                                                     length);
+  free(data);
 
   if (!file_info->content_type.empty()) {
     MHD_add_response_header(mhd_response,
@@ -833,14 +1461,190 @@ int HTTPServer::ServeStaticContent(static_file_info *file_info,
                             file_info->content_type.c_str());
   }
 
-  int ret = MHD_queue_response(response->Connection(),
-                               MHD_HTTP_OK,
-                               mhd_response);
-  MHD_destroy_response(mhd_response);
+  int ret = response->QueueResponse(mhd_response, MHD_HTTP_OK, true);
+  delete response;
+  return ret;
+}
+
+/**
+ * @brief Serve a file from memory.
+ * @param cached_file the file to serve
+ * @param response the response to use
+ */
+int HTTPServer::ServeCachedFile(const CachedFile *cached_file,
+                                HTTPResponse *response) {
+  struct MHD_Connection *connection = response->Connection();
+  int ret;
+  if (ETagMatches(connection, cached_file->etag)) {
+    ret = response->QueueResponse(cached_file->not_modified_response,
+                                  MHD_HTTP_NOT_MODIFIED, false);
+  } else if (cached_file->gzip_response &&
+             ETagMatches(connection, cached_file->gzip_etag)) {
+    ret = response->QueueResponse(cached_file->gzip_not_modified_response,
+                                  MHD_HTTP_NOT_MODIFIED, false);
+  } else if (cached_file->gzip_response && AcceptsGzip(connection)) {
+    ret = response->QueueResponse(cached_file->gzip_response, MHD_HTTP_OK,
+                                  false);
+  } else {
+    ret = response->QueueResponse(cached_file->response, MHD_HTTP_OK, false);
+  }
   delete response;
   return ret;
 }
 
+
+/**
+ * @brief Load the registered static files into memory.
+ *
+ * The files don't change once installed, so they're only read once.
+ */
+void HTTPServer::LoadStaticContent() {
+  unsigned int count = 0;
+  size_t bytes = 0;
+  map<string, static_file_info>::iterator iter = m_static_content.begin();
+  for (; iter != m_static_content.end(); ++iter) {
+    if (!iter->second.cached_file) {
+      iter->second.cached_file = LoadFile(iter->second);
+    }
+    if (iter->second.cached_file) {
+      count++;
+      bytes += iter->second.cached_file->data.size() +
+               iter->second.cached_file->gzip_data.size();
+    }
+  }
+  OLA_INFO << "Cached " << count << " static files, " << bytes << " bytes";
+}
+
+
+/**
+ * @brief Read a file, and the .gz copy if there is one, and build the
+ *   responses for it.
+ * @returns the new CachedFile or NULL if the file couldn't be read.
+ */
+HTTPServer::CachedFile *HTTPServer::LoadFile(
+    const static_file_info &file_info) const {
+  std::auto_ptr<CachedFile> cached_file(new CachedFile());
+  if (!ReadFile(file_info.file_path, &cached_file->data)) {
+    OLA_DEBUG << "Not caching missing file " << file_info.file_path;
+    return NULL;
+  }
+
+  // The .gz copies are created when the files are installed. If the file has
+  // been edited since, the copy is out of date so don't use it.
+  const string gzip_file = file_info.file_path + ".gz";
+  if (IsOlderThan(gzip_file, file_info.file_path)) {
+    OLA_WARN << "Ignoring " << gzip_file << ", it's older than "
+             << file_info.file_path;
+  } else {
+    ReadFile(gzip_file, &cached_file->gzip_data);
+  }
+  if (cached_file->gzip_data.size() >= cached_file->data.size()) {
+    cached_file->gzip_data.clear();
+  }
+
+  cached_file->etag = ContentETag(cached_file->data);
+  // Derived from the uncompressed data so it's stable across gzip versions.
+  cached_file->gzip_etag = cached_file->etag;
+  cached_file->gzip_etag.insert(cached_file->gzip_etag.size() - 1, "-gz");
+  const char *cache_control = (
+      file_info.content_type == CONTENT_TYPE_HTML ? HTML_CACHE_CONTROL :
+                                                    STATIC_CACHE_CONTROL);
+
+  cached_file->response = BuildPersistentResponse(cached_file->data);
+  cached_file->not_modified_response = BuildResponse(NULL, 0);
+  cached_file->gzip_response = NULL;
+  cached_file->gzip_not_modified_response = NULL;
+  if (!cached_file->gzip_data.empty()) {
+    cached_file->gzip_response = BuildPersistentResponse(
+        cached_file->gzip_data);
+    MHD_add_response_header(cached_file->gzip_response,
+                            MHD_HTTP_HEADER_CONTENT_ENCODING, "gzip");
+    cached_file->gzip_not_modified_response = BuildResponse(NULL, 0);
+  }
+
+  struct MHD_Response *responses[] = {
+    cached_file->response,
+    cached_file->not_modified_response,
+    cached_file->gzip_response,
+    cached_file->gzip_not_modified_response,
+  };
+  const string *etags[] = {
+    &cached_file->etag,
+    &cached_file->etag,
+    &cached_file->gzip_etag,
+    &cached_file->gzip_etag,
+  };
+  for (unsigned int i = 0; i < arraysize(responses); i++) {
+    struct MHD_Response *response = responses[i];
+    if (!response) {
+      continue;
+    }
+    if (!file_info.content_type.empty()) {
+      MHD_add_response_header(response, MHD_HTTP_HEADER_CONTENT_TYPE,
+                              file_info.content_type.c_str());
+    }
+    MHD_add_response_header(response, MHD_HTTP_HEADER_ETAG,
+                            etags[i]->c_str());
+    MHD_add_response_header(response, MHD_HTTP_HEADER_CACHE_CONTROL,
+                            cache_control);
+    if (cached_file->gzip_response) {
+      MHD_add_response_header(response, MHD_HTTP_HEADER_VARY,
+                              MHD_HTTP_HEADER_ACCEPT_ENCODING);
+    }
+  }
+  return cached_file.release();
+}
+
+
+/**
+ * @brief Read a file from the data dir.
+ */
+bool HTTPServer::ReadFile(const string &file, string *data) const {
+  string file_path = m_data_dir;
+  file_path.push_back(ola::file::PATH_SEPARATOR);
+  file_path.append(file);
+  ifstream i_stream(file_path.c_str(), ifstream::binary);
+  if (!i_stream.is_open()) {
+    return false;
+  }
+
+  std::ostringstream str;
+  str << i_stream.rdbuf();
+  data->assign(str.str());
+  return true;
+}
+
+
+/**
+ * @brief Check if a file in the data dir was last modified before another.
+ * @returns false if either file doesn't exist.
+ */
+bool HTTPServer::IsOlderThan(const string &file,
+                             const string &other_file) const {
+  const string prefix = m_data_dir + ola::file::PATH_SEPARATOR;
+  struct stat file_stat, other_stat;
+  if (stat((prefix + file).c_str(), &file_stat) ||
+      stat((prefix + other_file).c_str(), &other_stat)) {
+    return false;
+  }
+  return file_stat.st_mtime < other_stat.st_mtime;
+}
+
+
+void HTTPServer::FreeCachedFile(CachedFile *cached_file) {
+  if (!cached_file) {
+    return;
+  }
+  MHD_destroy_response(cached_file->response);
+  if (cached_file->gzip_response) {
+    MHD_destroy_response(cached_file->gzip_response);
+    MHD_destroy_response(cached_file->gzip_not_modified_response);
+  }
+  MHD_destroy_response(cached_file->not_modified_response);
+  delete cached_file;
+}
+
+
 void HTTPServer::InsertSocket(bool is_readable, bool is_writeable, int fd) {
 #ifdef _WIN32
   UnmanagedSocketDescriptor *socket = new UnmanagedSocketDescriptor(fd);
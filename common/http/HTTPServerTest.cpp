@@ -0,0 +1,699 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * HTTPServerTest.cpp
+ * Test fixture for the HTTPServer.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <utime.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ola/Callback.h"
+#include "ola/Clock.h"
+#include "ola/StringUtils.h"
+#include "ola/base/Array.h"
+#include "ola/http/HTTPServer.h"
+#include "ola/io/SelectServer.h"
+#include "ola/network/IPV4Address.h"
+#include "ola/network/SocketAddress.h"
+#include "ola/network/TCPSocket.h"
+#include "ola/testing/TestUtils.h"
+#include "ola/thread/Mutex.h"
+
+using ola::NewCallback;
+using ola::NewSingleCallback;
+using ola::TimeInterval;
+using ola::TimeStamp;
+using ola::http::HTTPEventStream;
+using ola::http::HTTPRequest;
+using ola::http::HTTPResponse;
+using ola::http::HTTPServer;
+using ola::io::SelectServer;
+using ola::network::GenericSocketAddress;
+using ola::network::IPV4Address;
+using ola::network::IPV4SocketAddress;
+using ola::network::TCPAcceptingSocket;
+using ola::network::TCPSocket;
+using ola::thread::ConditionVariable;
+using ola::thread::Mutex;
+using ola::thread::MutexLocker;
+using std::auto_ptr;
+using std::string;
+using std::vector;
+
+class HTTPServerTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(HTTPServerTest);
+  CPPUNIT_TEST(testEventFraming);
+  CPPUNIT_TEST(testComment);
+  CPPUNIT_TEST(testPartialReads);
+  CPPUNIT_TEST(testOverflow);
+  CPPUNIT_TEST(testClose);
+  CPPUNIT_TEST(testDeferredRequests);
+  CPPUNIT_TEST(testDeferredShutdown);
+  CPPUNIT_TEST(testAcceptEncoding);
+  CPPUNIT_TEST(testConditionalRequests);
+  CPPUNIT_TEST(testStaleGzip);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  HTTPServerTest()
+      : m_port(0),
+        m_held_response(NULL) {
+  }
+
+  void tearDown();
+
+  void testEventFraming();
+  void testComment();
+  void testPartialReads();
+  void testOverflow();
+  void testClose();
+  void testDeferredRequests();
+  void testDeferredShutdown();
+  void testAcceptEncoding();
+  void testConditionalRequests();
+  void testStaleGzip();
+
+ private:
+  auto_ptr<HTTPServer> m_server;
+  uint16_t m_port;
+  Mutex m_mutex;
+  ConditionVariable m_condition;
+  HTTPResponse *m_held_response;  // GUARDED_BY(m_mutex)
+
+  void StartServer(unsigned int thread_pool_size);
+  TCPSocket *SendRequest(const string &path, const string &headers = "");
+  string ReadResponse(TCPSocket *socket);
+  string Get(const string &path, const string &headers = "");
+  void ReceiveData(TCPSocket *socket, string *output);
+
+  int HandleOk(const HTTPRequest *request, HTTPResponse *response);
+  int HandleFailure(const HTTPRequest *request, HTTPResponse *response);
+  int HoldResponse(const HTTPRequest *request, HTTPResponse *response);
+
+  static unsigned int StatusCode(const string &response);
+  static string Header(const string &response, const string &name);
+  static string Body(const string &response);
+  static uint16_t ReservePort();
+  static void WriteFile(const string &file, const string &data,
+                        time_t modified);
+
+  static const char CONTENT[];
+  static const char GZIP_CONTENT[];
+  static const char *TEST_FILES[];
+
+  // How long to wait for the server to respond.
+  static const unsigned int ABORT_TIMEOUT_MS = 5000;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HTTPServerTest);
+
+// The server doesn't decompress the .gz files, so they don't need to be real
+// gzip data, just shorter than the original.
+const char HTTPServerTest::CONTENT[] =
+    "function Foo() { return 'this is the uncompressed content'; }";
+const char HTTPServerTest::GZIP_CONTENT[] = "compressed";
+
+// Written to the build dir, which is the data dir for the tests.
+const char *HTTPServerTest::TEST_FILES[] = {
+  "HTTPServerTest.js",
+  "HTTPServerTest.js.gz",
+  "HTTPServerTestStale.js",
+  "HTTPServerTestStale.js.gz",
+  "HTTPServerTestPlain.js",
+};
+
+
+namespace {
+/*
+ * Drain a stream, the way libmicrohttpd would.
+ */
+string ReadAll(HTTPEventStream *stream, size_t block_size = 1024) {
+  string output;
+  char buffer[1024];
+  while (true) {
+    ssize_t r = stream->Read(buffer, std::min(block_size, sizeof(buffer)));
+    if (r <= 0) {
+      break;
+    }
+    output.append(buffer, r);
+  }
+  return output;
+}
+
+void SetFlag(bool *flag) {
+  *flag = true;
+}
+
+void ConnectionClosed(bool *closed, SelectServer *ss) {
+  *closed = true;
+  ss->Terminate();
+}
+}  // namespace
+
+
+void HTTPServerTest::tearDown() {
+  m_server.reset();
+  delete m_held_response;
+  for (unsigned int i = 0; i < arraysize(TEST_FILES); i++) {
+    remove((string(TEST_BUILD_DIR) + "/" + TEST_FILES[i]).c_str());
+  }
+}
+
+
+/*
+ * Start a server on a free port.
+ */
+void HTTPServerTest::StartServer(unsigned int thread_pool_size) {
+  // A file with a .gz copy, one where the copy is older than the file, and
+  // one without a copy.
+  const time_t now = time(NULL);
+  WriteFile(TEST_FILES[0], CONTENT, now - 100);
+  WriteFile(TEST_FILES[1], GZIP_CONTENT, now - 50);
+  WriteFile(TEST_FILES[2], CONTENT, now - 50);
+  WriteFile(TEST_FILES[3], GZIP_CONTENT, now - 100);
+  WriteFile(TEST_FILES[4], CONTENT, now - 100);
+
+  HTTPServer::HTTPServerOptions options;
+  options.port = ReservePort();
+  options.data_dir = TEST_BUILD_DIR;
+  options.thread_pool_size = thread_pool_size;
+  m_port = options.port;
+  m_server.reset(new HTTPServer(options));
+  m_server->RegisterHandler(
+      "/ok", NewCallback(this, &HTTPServerTest::HandleOk));
+  m_server->RegisterHandler(
+      "/fail", NewCallback(this, &HTTPServerTest::HandleFailure));
+  m_server->RegisterHandler(
+      "/hold", NewCallback(this, &HTTPServerTest::HoldResponse));
+  m_server->RegisterFile("/file.js", TEST_FILES[0],
+                         HTTPServer::CONTENT_TYPE_JS);
+  m_server->RegisterFile("/stale.js", TEST_FILES[2],
+                         HTTPServer::CONTENT_TYPE_JS);
+  m_server->RegisterFile("/plain.js", TEST_FILES[4],
+                         HTTPServer::CONTENT_TYPE_JS);
+  OLA_ASSERT_TRUE(m_server->Init());
+  OLA_ASSERT_TRUE(m_server->Start());
+}
+
+
+/*
+ * Connect to the server and send a GET request.
+ */
+TCPSocket *HTTPServerTest::SendRequest(const string &path,
+                                       const string &headers) {
+  TCPSocket *socket = TCPSocket::Connect(
+      IPV4SocketAddress(IPV4Address::Loopback(), m_port));
+  OLA_ASSERT_NOT_NULL(socket);
+  const string request = "GET " + path + " HTTP/1.1\r\n"
+                         "Host: localhost\r\n"
+                         "Connection: close\r\n" + headers + "\r\n";
+  OLA_ASSERT_EQ(static_cast<ssize_t>(request.size()),
+                socket->Send(reinterpret_cast<const uint8_t*>(request.data()),
+                             request.size()));
+  return socket;
+}
+
+
+/*
+ * Read until the server closes the connection, this takes ownership of the
+ * socket.
+ */
+string HTTPServerTest::ReadResponse(TCPSocket *socket) {
+  string output;
+  bool closed = false;
+  SelectServer ss;
+  socket->SetReadNonBlocking();
+  socket->SetOnData(
+      NewCallback(this, &HTTPServerTest::ReceiveData, socket, &output));
+  socket->SetOnClose(NewSingleCallback(ConnectionClosed, &closed, &ss));
+  ss.AddReadDescriptor(socket);
+  ss.RegisterSingleTimeout(
+      ABORT_TIMEOUT_MS, NewSingleCallback(&ss, &SelectServer::Terminate));
+  ss.Run();
+  if (!closed) {
+    ss.RemoveReadDescriptor(socket);
+  }
+  delete socket;
+  OLA_ASSERT_TRUE_MSG(closed, "Timed out waiting for a response");
+  return output;
+}
+
+
+string HTTPServerTest::Get(const string &path, const string &headers) {
+  return ReadResponse(SendRequest(path, headers));
+}
+
+
+void HTTPServerTest::ReceiveData(TCPSocket *socket, string *output) {
+  uint8_t buffer[1024];
+  unsigned int data_read;
+  socket->Receive(buffer, sizeof(buffer), data_read);
+  output->append(reinterpret_cast<char*>(buffer), data_read);
+}
+
+
+int HTTPServerTest::HandleOk(const HTTPRequest*, HTTPResponse *response) {
+  response->Append("ok");
+  int r = response->Send();
+  delete response;
+  return r;
+}
+
+
+/*
+ * Fail without sending a response.
+ */
+int HTTPServerTest::HandleFailure(const HTTPRequest*, HTTPResponse *response) {
+  delete response;
+  return MHD_NO;
+}
+
+
+/*
+ * Keep the response, so the request is still waiting when the server stops.
+ */
+int HTTPServerTest::HoldResponse(const HTTPRequest*, HTTPResponse *response) {
+  MutexLocker lock(&m_mutex);
+  m_held_response = response;
+  m_condition.Signal();
+  return MHD_YES;
+}
+
+
+unsigned int HTTPServerTest::StatusCode(const string &response) {
+  // HTTP/1.1 200 OK
+  if (response.size() < 12 || response.compare(0, 5, "HTTP/")) {
+    return 0;
+  }
+  return atoi(response.substr(9, 3).c_str());
+}
+
+
+/*
+ * Return the value of a response header, or an empty string if it's missing.
+ */
+string HTTPServerTest::Header(const string &response, const string &name) {
+  const string head = response.substr(0, response.find("\r\n\r\n"));
+  string lower_name = name;
+  ola::ToLower(&lower_name);
+  vector<string> lines;
+  ola::StringSplit(head, &lines, "\r\n");
+  vector<string>::iterator iter = lines.begin();
+  for (; iter != lines.end(); ++iter) {
+    const size_t colon = iter->find(':');
+    if (colon == string::npos) {
+      continue;
+    }
+    string key = iter->substr(0, colon);
+    ola::ToLower(&key);
+    if (key == lower_name) {
+      string value = iter->substr(colon + 1);
+      ola::StringTrim(&value);
+      return value;
+    }
+  }
+  return "";
+}
+
+
+string HTTPServerTest::Body(const string &response) {
+  size_t offset = response.find("\r\n\r\n");
+  return offset == string::npos ? "" : response.substr(offset + 4);
+}
+
+
+void HTTPServerTest::WriteFile(const string &file, const string &data,
+                               time_t modified) {
+  const string path = string(TEST_BUILD_DIR) + "/" + file;
+  std::ofstream stream(path.c_str(), std::ios::binary);
+  stream << data;
+  stream.close();
+  struct utimbuf times;
+  times.actime = modified;
+  times.modtime = modified;
+  OLA_ASSERT_EQ(0, utime(path.c_str(), &times));
+}
+
+
+/*
+ * See TCPConnectorTest, bind to port 0 to find a free port.
+ */
+uint16_t HTTPServerTest::ReservePort() {
+  TCPAcceptingSocket listening_socket(NULL);
+  IPV4SocketAddress listen_address(IPV4Address::Loopback(), 0);
+  OLA_ASSERT_TRUE_MSG(listening_socket.Listen(listen_address),
+                      "Failed to listen");
+  GenericSocketAddress addr = listening_socket.GetLocalAddress();
+  OLA_ASSERT_TRUE(addr.IsValid());
+  return addr.V4Addr().Port();
+}
+
+
+/*
+ * Check events are framed correctly.
+ */
+void HTTPServerTest::testEventFraming() {
+  HTTPEventStream stream;
+  OLA_ASSERT_EQ(static_cast<size_t>(0), stream.PendingBytes());
+  OLA_ASSERT_EQ(string(""), ReadAll(&stream));
+
+  OLA_ASSERT_TRUE(stream.SendEvent("dmx", "{\"universe\": 1}"));
+  const string expected = "event: dmx\ndata: {\"universe\": 1}\n\n";
+  OLA_ASSERT_EQ(expected.size(), stream.PendingBytes());
+  OLA_ASSERT_EQ(expected, ReadAll(&stream));
+  OLA_ASSERT_EQ(static_cast<size_t>(0), stream.PendingBytes());
+
+  // Events without a type just have data.
+  OLA_ASSERT_TRUE(stream.SendEvent("", "foo"));
+  OLA_ASSERT_EQ(string("data: foo\n\n"), ReadAll(&stream));
+
+  // Each line of the data gets its own field, including empty ones.
+  OLA_ASSERT_TRUE(stream.SendEvent("multi", "one\ntwo\n\nthree"));
+  OLA_ASSERT_EQ(
+      string("event: multi\ndata: one\ndata: two\ndata: \ndata: three\n\n"),
+      ReadAll(&stream));
+
+  OLA_ASSERT_TRUE(stream.SendEvent("trailing", "one\n"));
+  OLA_ASSERT_EQ(string("event: trailing\ndata: one\ndata: \n\n"),
+                ReadAll(&stream));
+
+  OLA_ASSERT_TRUE(stream.SendEvent("empty", ""));
+  OLA_ASSERT_EQ(string("event: empty\ndata: \n\n"), ReadAll(&stream));
+
+  // Events queue up until they're read.
+  OLA_ASSERT_TRUE(stream.SendEvent("a", "1"));
+  OLA_ASSERT_TRUE(stream.SendEvent("b", "2"));
+  OLA_ASSERT_EQ(string("event: a\ndata: 1\n\nevent: b\ndata: 2\n\n"),
+                ReadAll(&stream));
+}
+
+
+/*
+ * Check comments.
+ */
+void HTTPServerTest::testComment() {
+  HTTPEventStream stream;
+  OLA_ASSERT_TRUE(stream.SendComment("keepalive"));
+  OLA_ASSERT_EQ(string(": keepalive\n\n"), ReadAll(&stream));
+}
+
+
+/*
+ * Check that reads smaller than the queued data pick up where they left off,
+ * including when more data is queued in between.
+ */
+void HTTPServerTest::testPartialReads() {
+  HTTPEventStream stream;
+  OLA_ASSERT_TRUE(stream.SendEvent("", "0123456789"));
+  const string first = "data: 0123456789\n\n";
+
+  char buffer[8];
+  OLA_ASSERT_EQ(static_cast<ssize_t>(5), stream.Read(buffer, 5));
+  OLA_ASSERT_EQ(first.substr(0, 5), string(buffer, 5));
+  OLA_ASSERT_EQ(first.size() - 5, stream.PendingBytes());
+
+  OLA_ASSERT_EQ(static_cast<ssize_t>(8), stream.Read(buffer, sizeof(buffer)));
+  OLA_ASSERT_EQ(first.substr(5, 8), string(buffer, 8));
+
+  // Queue more data while part of the first event is still pending.
+  OLA_ASSERT_TRUE(stream.SendEvent("", "abc"));
+  const string second = "data: abc\n\n";
+  OLA_ASSERT_EQ(first.size() - 13 + second.size(), stream.PendingBytes());
+  OLA_ASSERT_EQ(first.substr(13) + second, ReadAll(&stream, 3));
+  OLA_ASSERT_EQ(static_cast<size_t>(0), stream.PendingBytes());
+  OLA_ASSERT_EQ(static_cast<ssize_t>(0), stream.Read(buffer, sizeof(buffer)));
+}
+
+
+/*
+ * Check events are dropped once MAX_PENDING_BYTES are queued.
+ */
+void HTTPServerTest::testOverflow() {
+  HTTPEventStream stream;
+  // Each event is "data: " + the data + "\n\n".
+  const string data(HTTPEventStream::MAX_PENDING_BYTES / 4 - 8, 'x');
+  for (unsigned int i = 0; i < 4; i++) {
+    OLA_ASSERT_TRUE(stream.SendEvent("", data));
+  }
+  OLA_ASSERT_EQ(HTTPEventStream::MAX_PENDING_BYTES, stream.PendingBytes());
+
+  OLA_ASSERT_FALSE(stream.SendEvent("", "more"));
+  OLA_ASSERT_FALSE(stream.SendComment("keepalive"));
+  OLA_ASSERT_EQ(HTTPEventStream::MAX_PENDING_BYTES, stream.PendingBytes());
+
+  // Once the client catches up, events are accepted again.
+  char buffer[16];
+  OLA_ASSERT_EQ(static_cast<ssize_t>(sizeof(buffer)),
+                stream.Read(buffer, sizeof(buffer)));
+  OLA_ASSERT_TRUE(stream.SendEvent("", "more"));
+  OLA_ASSERT_EQ(HTTPEventStream::MAX_PENDING_BYTES - sizeof(buffer) + 12,
+                stream.PendingBytes());
+
+  const string output = ReadAll(&stream);
+  OLA_ASSERT_EQ(HTTPEventStream::MAX_PENDING_BYTES - sizeof(buffer) + 12,
+                output.size());
+  OLA_ASSERT_EQ(string("data: more\n\n"), output.substr(output.size() - 12));
+}
+
+
+/*
+ * Check closing the stream, and the on_close callback.
+ */
+void HTTPServerTest::testClose() {
+  bool closed = false;
+  HTTPEventStream *stream = new HTTPEventStream(
+      NewSingleCallback(SetFlag, &closed));
+  OLA_ASSERT_TRUE(stream->SendEvent("", "last"));
+  stream->Close();
+
+  // Nothing more can be queued, but what's already there is still sent.
+  OLA_ASSERT_FALSE(stream->SendEvent("", "too late"));
+  OLA_ASSERT_FALSE(stream->SendComment("too late"));
+  OLA_ASSERT_EQ(string("data: last\n\n"), ReadAll(stream));
+
+  char buffer[16];
+  OLA_ASSERT_EQ(static_cast<ssize_t>(MHD_CONTENT_READER_END_OF_STREAM),
+                stream->Read(buffer, sizeof(buffer)));
+  OLA_ASSERT_FALSE(closed);
+
+  // libmicrohttpd is done with the stream, which deletes it.
+  stream->ConnectionClosed();
+  OLA_ASSERT_TRUE(closed);
+
+  // The client going away also runs the callback.
+  closed = false;
+  stream = new HTTPEventStream(NewSingleCallback(SetFlag, &closed));
+  OLA_ASSERT_TRUE(stream->SendEvent("", "unread"));
+  stream->ConnectionClosed();
+  OLA_ASSERT_TRUE(closed);
+
+  // Replacing the callback drops the old one.
+  closed = false;
+  stream = new HTTPEventStream(NewSingleCallback(SetFlag, &closed));
+  stream->SetOnClose(NULL);
+  delete stream;
+  OLA_ASSERT_FALSE(closed);
+}
+
+
+/*
+ * Check requests that run on the HTTPServer thread, because libmicrohttpd
+ * is using its own threads, always get a response.
+ */
+void HTTPServerTest::testDeferredRequests() {
+  StartServer(2);
+
+  string response = Get("/ok");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+  OLA_ASSERT_EQ(string("ok"), Body(response));
+
+  // A handler that fails without responding mustn't leave the connection
+  // suspended.
+  response = Get("/fail");
+  OLA_ASSERT_EQ(500u, StatusCode(response));
+
+  // And the server is still usable afterwards.
+  response = Get("/ok");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+}
+
+
+/*
+ * Check requests still waiting for a response are answered when the server
+ * stops.
+ */
+void HTTPServerTest::testDeferredShutdown() {
+  StartServer(2);
+  TCPSocket *socket = SendRequest("/hold");
+  {
+    MutexLocker lock(&m_mutex);
+    TimeStamp wake_up;
+    ola::Clock clock;
+    clock.CurrentTime(&wake_up);
+    wake_up += TimeInterval(ABORT_TIMEOUT_MS / 1000, 0);
+    while (!m_held_response) {
+      OLA_ASSERT_TRUE_MSG(m_condition.TimedWait(&m_mutex, wake_up),
+                          "Timed out waiting for the request");
+    }
+  }
+
+  m_server.reset();
+  const string response = ReadResponse(socket);
+  OLA_ASSERT_EQ(503u, StatusCode(response));
+}
+
+
+/*
+ * Check the .gz copy is served to clients that accept it.
+ */
+void HTTPServerTest::testAcceptEncoding() {
+  StartServer(0);
+
+  string response = Get("/file.js");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+  OLA_ASSERT_EQ(string(CONTENT), Body(response));
+  OLA_ASSERT_EQ(string(""), Header(response, "Content-Encoding"));
+  OLA_ASSERT_EQ(string("text/javascript"), Header(response, "Content-Type"));
+  // Caches need to know the response depends on Accept-Encoding.
+  OLA_ASSERT_EQ(string("Accept-Encoding"), Header(response, "Vary"));
+  const string etag = Header(response, "ETag");
+
+  response = Get("/file.js", "Accept-Encoding: gzip, deflate\r\n");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+  OLA_ASSERT_EQ(string(GZIP_CONTENT), Body(response));
+  OLA_ASSERT_EQ(string("gzip"), Header(response, "Content-Encoding"));
+  OLA_ASSERT_EQ(string("Accept-Encoding"), Header(response, "Vary"));
+  // The encodings are different entities, so they have different ETags.
+  OLA_ASSERT_NE(etag, Header(response, "ETag"));
+
+  const char *gzip_headers[] = {
+    "gzip",
+    "GZIP",
+    "x-gzip",
+    "gzip;q=0.5",
+    "deflate, gzip; q=0.001",
+    "*",
+    "identity, *;q=0.1",
+    "*;q=0, gzip",
+  };
+  for (unsigned int i = 0; i < arraysize(gzip_headers); i++) {
+    response = Get("/file.js",
+                   string("Accept-Encoding: ") + gzip_headers[i] + "\r\n");
+    OLA_ASSERT_EQ_MSG(string(GZIP_CONTENT), Body(response), gzip_headers[i]);
+  }
+
+  const char *plain_headers[] = {
+    "",
+    "identity",
+    "deflate, br",
+    "gzip;q=0",
+    "gzip; Q=0.000",
+    "gzip;q=0.",
+    "*;q=0",
+    "gzip;q=0, *",
+    "*, gzip;q=0",
+  };
+  for (unsigned int i = 0; i < arraysize(plain_headers); i++) {
+    response = Get("/file.js",
+                   string("Accept-Encoding: ") + plain_headers[i] + "\r\n");
+    OLA_ASSERT_EQ_MSG(string(CONTENT), Body(response), plain_headers[i]);
+  }
+
+  // Without a .gz copy there's only one encoding.
+  response = Get("/plain.js", "Accept-Encoding: gzip\r\n");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+  OLA_ASSERT_EQ(string(CONTENT), Body(response));
+  OLA_ASSERT_EQ(string(""), Header(response, "Content-Encoding"));
+  OLA_ASSERT_EQ(string(""), Header(response, "Vary"));
+}
+
+
+/*
+ * Check If-None-Match.
+ */
+void HTTPServerTest::testConditionalRequests() {
+  StartServer(0);
+
+  string response = Get("/file.js");
+  const string etag = Header(response, "ETag");
+  OLA_ASSERT_FALSE(etag.empty());
+  response = Get("/file.js", "Accept-Encoding: gzip\r\n");
+  const string gzip_etag = Header(response, "ETag");
+  OLA_ASSERT_FALSE(gzip_etag.empty());
+
+  const string matching_headers[] = {
+    etag,
+    "W/" + etag,
+    "\"foo\", " + etag,
+    "\"foo\",W/" + etag + ", \"bar\"",
+    "*",
+  };
+  for (unsigned int i = 0; i < arraysize(matching_headers); i++) {
+    response = Get("/file.js",
+                   "If-None-Match: " + matching_headers[i] + "\r\n");
+    OLA_ASSERT_EQ_MSG(304u, StatusCode(response), matching_headers[i]);
+    OLA_ASSERT_EQ(string(""), Body(response));
+    OLA_ASSERT_EQ(etag, Header(response, "ETag"));
+    OLA_ASSERT_EQ(string("Accept-Encoding"), Header(response, "Vary"));
+  }
+
+  // The gzip copy is revalidated with its own ETag.
+  response = Get("/file.js", "Accept-Encoding: gzip\r\n"
+                 "If-None-Match: " + gzip_etag + "\r\n");
+  OLA_ASSERT_EQ(304u, StatusCode(response));
+  OLA_ASSERT_EQ(gzip_etag, Header(response, "ETag"));
+  OLA_ASSERT_EQ(string("Accept-Encoding"), Header(response, "Vary"));
+
+  const string other_headers[] = {
+    "\"foo\"",
+    "W/\"foo\"",
+    etag.substr(1, etag.size() - 2),
+    "\"foo\", \"bar\"",
+  };
+  for (unsigned int i = 0; i < arraysize(other_headers); i++) {
+    response = Get("/file.js",
+                   "If-None-Match: " + other_headers[i] + "\r\n");
+    OLA_ASSERT_EQ_MSG(200u, StatusCode(response), other_headers[i]);
+    OLA_ASSERT_EQ(string(CONTENT), Body(response));
+  }
+}
+
+
+/*
+ * Check a .gz copy that's older than the file isn't used.
+ */
+void HTTPServerTest::testStaleGzip() {
+  StartServer(0);
+
+  string response = Get("/stale.js", "Accept-Encoding: gzip\r\n");
+  OLA_ASSERT_EQ(200u, StatusCode(response));
+  OLA_ASSERT_EQ(string(CONTENT), Body(response));
+  OLA_ASSERT_EQ(string(""), Header(response, "Content-Encoding"));
+  OLA_ASSERT_EQ(string(""), Header(response, "Vary"));
+
+  // The ETag is the same as a file without a copy.
+  OLA_ASSERT_EQ(Header(Get("/plain.js"), "ETag"), Header(response, "ETag"));
+}
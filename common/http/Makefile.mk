@@ -6,4 +6,14 @@ common_http_libolahttp_la_SOURCES = \
     common/http/HTTPServer.cpp \
     common/http/OlaHTTPServer.cpp
 common_http_libolahttp_la_LIBADD = $(libmicrohttpd_LIBS)
+
+# TESTS
+##################################################
+test_programs += common/http/HTTPServerTester
+
+common_http_HTTPServerTester_SOURCES = common/http/HTTPServerTest.cpp
+common_http_HTTPServerTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
+common_http_HTTPServerTester_LDADD = $(COMMON_TESTING_LIBS) \
+                                     common/http/libolahttp.la \
+                                     common/web/libolaweb.la
 endif
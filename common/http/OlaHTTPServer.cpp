@@ -49,6 +49,7 @@ OlaHTTPServer::OlaHTTPServer(const HTTPServer::HTTPServerOptions &options,
       m_server(options) {
   RegisterHandler("/debug", &OlaHTTPServer::DisplayDebug);
   RegisterHandler("/help", &OlaHTTPServer::DisplayHandlers);
+  RegisterHandler("/metrics", &OlaHTTPServer::DisplayMetrics);
 
   StringVariable *data_dir_var = export_map->GetStringVar(K_DATA_DIR_VAR);
   data_dir_var->Set(m_server.DataDir());
@@ -93,6 +94,34 @@ int OlaHTTPServer::DisplayDebug(const HTTPRequest*,
 }
 
 
+/**
+ * Display the numeric variables in the ExportMap, in the OpenMetrics text
+ * format.
+ */
+int OlaHTTPServer::DisplayMetrics(const HTTPRequest*,
+                                  HTTPResponse *raw_response) {
+  auto_ptr<HTTPResponse> response(raw_response);
+  ola::TimeStamp now;
+  m_clock.CurrentTime(&now);
+  ostringstream str;
+  str << "# TYPE uptime_in_ms gauge\n"
+      << "uptime_in_ms " << (now - m_start_time).InMilliSeconds() << "\n";
+
+  string output = str.str();
+  vector<BaseVariable*> variables = m_export_map->AllVariables();
+  vector<BaseVariable*>::const_iterator iter;
+  for (iter = variables.begin(); iter != variables.end(); ++iter) {
+    (*iter)->AppendMetrics(&output);
+  }
+  output.append("# EOF\n");
+
+  response->SetContentType(HTTPServer::CONTENT_TYPE_OPENMETRICS);
+  response->SetNoCache();
+  response->Append(output);
+  return response->Send();
+}
+
+
 /**
  * Display a list of registered handlers
  */
@@ -38,10 +38,10 @@ using ola::thread::timeout_id;
 
 TimeoutManager::TimeoutManager(ExportMap *export_map,
                                Clock *clock)
-    : m_export_map(export_map),
+    : m_timer_var(NULL),
       m_clock(clock) {
-  if (m_export_map) {
-    m_export_map->GetIntegerVar(K_TIMER_VAR);
+  if (export_map) {
+    m_timer_var = export_map->GetIntegerVar(K_TIMER_VAR);
   }
 }
 
@@ -60,8 +60,8 @@ timeout_id TimeoutManager::RegisterRepeatingTimeout(
   if (!closure)
     return INVALID_TIMEOUT;
 
-  if (m_export_map)
-    (*m_export_map->GetIntegerVar(K_TIMER_VAR))++;
+  if (m_timer_var)
+    (*m_timer_var)++;
 
   Event *event = new RepeatingEvent(interval, m_clock, closure);
   m_events.push(event);
@@ -74,8 +74,8 @@ timeout_id TimeoutManager::RegisterSingleTimeout(
   if (!closure)
     return INVALID_TIMEOUT;
 
-  if (m_export_map)
-    (*m_export_map->GetIntegerVar(K_TIMER_VAR))++;
+  if (m_timer_var)
+    (*m_timer_var)++;
 
   Event *event = new SingleEvent(interval, m_clock, closure);
   m_events.push(event);
@@ -104,8 +104,8 @@ TimeInterval TimeoutManager::ExecuteTimeouts(TimeStamp *now) {
     // if this was removed, skip it
     if (m_removed_timeouts.erase(e)) {
       delete e;
-      if (m_export_map)
-        (*m_export_map->GetIntegerVar(K_TIMER_VAR))--;
+      if (m_timer_var)
+        (*m_timer_var)--;
       continue;
     }
 
@@ -115,8 +115,8 @@ TimeInterval TimeoutManager::ExecuteTimeouts(TimeStamp *now) {
       m_events.push(e);
     } else {
       delete e;
-      if (m_export_map)
-        (*m_export_map->GetIntegerVar(K_TIMER_VAR))--;
+      if (m_timer_var)
+        (*m_timer_var)--;
     }
     m_clock->CurrentTime(now);
   }
@@ -187,7 +187,7 @@ class TimeoutManager {
   typedef std::priority_queue<Event*, std::vector<Event*>, ltevent>
       event_queue_t;
 
-  ola::ExportMap *m_export_map;
+  ola::IntegerVariable *m_timer_var;
   Clock *m_clock;
 
   event_queue_t m_events;
@@ -10,6 +10,8 @@ common_libolacommon_la_SOURCES += \
     common/network/MACAddress.cpp \
     common/network/NetworkUtils.cpp \
     common/network/NetworkUtilsInternal.h \
+    common/network/PacketCapture.cpp \
+    common/network/PacketCapture.h \
     common/network/Socket.cpp \
     common/network/SocketAddress.cpp \
     common/network/SocketCloser.cpp \
@@ -20,6 +22,13 @@ common_libolacommon_la_SOURCES += \
 
 common_libolacommon_la_LIBADD += $(RESOLV_LIBS)
 
+# Shared by the tools that replay packet captures.
+noinst_LTLIBRARIES += common/network/libolapacketreplay.la
+common_network_libolapacketreplay_la_SOURCES = \
+    common/network/PacketReplay.cpp \
+    common/network/PacketReplay.h
+common_network_libolapacketreplay_la_LIBADD = common/libolacommon.la
+
 if USING_WIN32
 common_libolacommon_la_SOURCES += \
     common/network/WindowsInterfacePicker.h \
@@ -48,6 +57,7 @@ common_network_NetworkTester_SOURCES = \
     common/network/InterfaceTest.cpp \
     common/network/MACAddressTest.cpp \
     common/network/NetworkUtilsTest.cpp \
+    common/network/PacketCaptureTest.cpp \
     common/network/SocketAddressTest.cpp \
     common/network/SocketTest.cpp
 common_network_NetworkTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
@@ -0,0 +1,405 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * PacketCapture.cpp
+ * Read and write UDP datagrams in the pcap file format.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <string.h>
+#include <ola/Logging.h>
+#include <ola/base/Atomic.h>
+#include <ola/network/IPV4Address.h>
+#include <ola/network/NetworkUtils.h>
+#include <ola/util/Utils.h>
+#include <string>
+#include "common/network/PacketCapture.h"
+
+namespace ola {
+namespace network {
+
+using ola::thread::MutexLocker;
+using std::string;
+
+namespace {
+
+const uint32_t PCAP_MAGIC = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_SWAPPED = 0xd4c3b2a1;
+const uint32_t PCAP_NSEC_MAGIC = 0xa1b23c4d;
+const uint32_t PCAP_NSEC_MAGIC_SWAPPED = 0x4d3cb2a1;
+const uint16_t PCAP_VERSION_MAJOR = 2;
+const uint16_t PCAP_VERSION_MINOR = 4;
+const uint32_t PCAP_SNAPLEN = 65535;
+
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint32_t LINKTYPE_RAW = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+const uint32_t LINKTYPE_IPV4 = 228;
+
+const unsigned int ETHERNET_HEADER_SIZE = 14;
+const unsigned int VLAN_TAG_SIZE = 4;
+const unsigned int LINUX_SLL_HEADER_SIZE = 16;
+const unsigned int IPV4_HEADER_SIZE = 20;
+const unsigned int UDP_HEADER_SIZE = 8;
+const uint16_t ETHERTYPE_IPV4 = 0x0800;
+const uint16_t ETHERTYPE_VLAN = 0x8100;
+const uint8_t IP_PROTOCOL_UDP = 17;
+const uint8_t IP_DEFAULT_TTL = 64;
+
+struct pcap_file_header {
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  int32_t thiszone;
+  uint32_t sigfigs;
+  uint32_t snaplen;
+  uint32_t link_type;
+};
+
+struct pcap_record_header {
+  uint32_t ts_sec;
+  uint32_t ts_usec;
+  uint32_t incl_len;
+  uint32_t orig_len;
+};
+
+uint32_t SwapUInt32(uint32_t value) {
+  return ((value & 0xff) << 24) | ((value & 0xff00) << 8) |
+         ((value >> 8) & 0xff00) | (value >> 24);
+}
+
+uint16_t ReadUInt16(const uint8_t *data) {
+  return ola::utils::JoinUInt8(data[0], data[1]);
+}
+
+void WriteUInt16(uint8_t *data, uint16_t value) {
+  ola::utils::SplitUInt16(value, &data[0], &data[1]);
+}
+
+/*
+ * The RFC 1071 checksum of an IPv4 header.
+ */
+uint16_t IPChecksum(const uint8_t *header, unsigned int length) {
+  uint32_t sum = 0;
+  for (unsigned int i = 0; i + 1 < length; i += 2) {
+    sum += ReadUInt16(header + i);
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return static_cast<uint16_t>(~sum);
+}
+
+PacketCaptureWriter *s_packet_capture = NULL;
+}  // namespace
+
+
+PacketCaptureWriter::PacketCaptureWriter(ola::Clock *clock)
+    : m_clock(clock),
+      m_free_clock(false),
+      m_packet_count(0),
+      m_ip_id(0) {
+  if (!m_clock) {
+    m_clock = new ola::Clock();
+    m_free_clock = true;
+  }
+}
+
+
+PacketCaptureWriter::~PacketCaptureWriter() {
+  Close();
+  if (m_free_clock) {
+    delete m_clock;
+  }
+}
+
+
+bool PacketCaptureWriter::Open(const string &filename) {
+  MutexLocker lock(&m_mutex);
+  if (m_output.is_open()) {
+    m_output.close();
+  }
+
+  m_output.open(filename.c_str(),
+                std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_output.is_open()) {
+    OLA_WARN << "Failed to open " << filename << " for writing";
+    return false;
+  }
+
+  pcap_file_header header;
+  header.magic = PCAP_MAGIC;
+  header.version_major = PCAP_VERSION_MAJOR;
+  header.version_minor = PCAP_VERSION_MINOR;
+  header.thiszone = 0;
+  header.sigfigs = 0;
+  header.snaplen = PCAP_SNAPLEN;
+  header.link_type = LINKTYPE_RAW;
+  m_output.write(reinterpret_cast<char*>(&header), sizeof(header));
+  m_packet_count = 0;
+  return m_output.good();
+}
+
+
+void PacketCaptureWriter::Close() {
+  MutexLocker lock(&m_mutex);
+  if (m_output.is_open()) {
+    m_output.close();
+  }
+}
+
+
+bool PacketCaptureWriter::WriteUDP(const IPV4SocketAddress &source,
+                                   const IPV4SocketAddress &destination,
+                                   const uint8_t *data,
+                                   unsigned int length) {
+  ola::TimeStamp now;
+  m_clock->CurrentTime(&now);
+  return WriteUDP(now, source, destination, data, length);
+}
+
+
+bool PacketCaptureWriter::WriteUDP(const ola::TimeStamp &timestamp,
+                                   const IPV4SocketAddress &source,
+                                   const IPV4SocketAddress &destination,
+                                   const uint8_t *data,
+                                   unsigned int length) {
+  const unsigned int headers_size = IPV4_HEADER_SIZE + UDP_HEADER_SIZE;
+  if (length > PCAP_SNAPLEN - headers_size) {
+    OLA_WARN << "Datagram of " << length << " bytes is too large to capture";
+    return false;
+  }
+
+  MutexLocker lock(&m_mutex);
+  if (!m_output.is_open()) {
+    return false;
+  }
+
+  uint8_t headers[IPV4_HEADER_SIZE + UDP_HEADER_SIZE];
+  memset(headers, 0, sizeof(headers));
+  uint8_t *ip_header = headers;
+  ip_header[0] = 0x45;  // v4, 5 word header
+  WriteUInt16(ip_header + 2, static_cast<uint16_t>(headers_size + length));
+  WriteUInt16(ip_header + 4, m_ip_id++);
+  ip_header[6] = 0x40;  // don't fragment
+  ip_header[8] = IP_DEFAULT_TTL;
+  ip_header[9] = IP_PROTOCOL_UDP;
+  uint32_t address = source.Host().AsInt();
+  memcpy(ip_header + 12, &address, sizeof(address));
+  address = destination.Host().AsInt();
+  memcpy(ip_header + 16, &address, sizeof(address));
+  WriteUInt16(ip_header + 10, IPChecksum(ip_header, IPV4_HEADER_SIZE));
+
+  // The UDP checksum is optional for IPv4, leave it as 0.
+  uint8_t *udp_header = headers + IPV4_HEADER_SIZE;
+  WriteUInt16(udp_header, source.Port());
+  WriteUInt16(udp_header + 2, destination.Port());
+  WriteUInt16(udp_header + 4, static_cast<uint16_t>(UDP_HEADER_SIZE + length));
+
+  pcap_record_header record;
+  record.ts_sec = static_cast<uint32_t>(timestamp.Seconds());
+  record.ts_usec = static_cast<uint32_t>(timestamp.MicroSeconds());
+  record.incl_len = headers_size + length;
+  record.orig_len = record.incl_len;
+
+  m_output.write(reinterpret_cast<char*>(&record), sizeof(record));
+  m_output.write(reinterpret_cast<char*>(headers), sizeof(headers));
+  m_output.write(reinterpret_cast<const char*>(data), length);
+  m_packet_count++;
+  return m_output.good();
+}
+
+
+PacketCaptureReader::PacketCaptureReader()
+    : m_swapped(false),
+      m_nanoseconds(false),
+      m_link_type(0) {
+}
+
+
+bool PacketCaptureReader::Open(const string &filename) {
+  Close();
+  m_input.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!m_input.is_open()) {
+    OLA_WARN << "Failed to open " << filename;
+    return false;
+  }
+
+  pcap_file_header header;
+  m_input.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!m_input.good()) {
+    OLA_WARN << filename << " is too short to be a pcap file";
+    Close();
+    return false;
+  }
+
+  if (header.magic == PCAP_MAGIC_SWAPPED ||
+      header.magic == PCAP_NSEC_MAGIC_SWAPPED) {
+    m_swapped = true;
+  } else if (header.magic != PCAP_MAGIC && header.magic != PCAP_NSEC_MAGIC) {
+    OLA_WARN << filename << " isn't a pcap file";
+    Close();
+    return false;
+  }
+
+  m_link_type = m_swapped ? SwapUInt32(header.link_type) : header.link_type;
+  if (m_link_type != LINKTYPE_ETHERNET && m_link_type != LINKTYPE_RAW &&
+      m_link_type != LINKTYPE_LINUX_SLL && m_link_type != LINKTYPE_IPV4) {
+    OLA_WARN << filename << " has unsupported link type " << m_link_type;
+    Close();
+    return false;
+  }
+  m_nanoseconds = (header.magic == PCAP_NSEC_MAGIC ||
+                   header.magic == PCAP_NSEC_MAGIC_SWAPPED);
+  return true;
+}
+
+
+void PacketCaptureReader::Close() {
+  if (m_input.is_open()) {
+    m_input.close();
+  }
+  m_input.clear();
+  m_swapped = false;
+  m_nanoseconds = false;
+  m_link_type = 0;
+}
+
+
+bool PacketCaptureReader::Next(CapturedPacket *packet) {
+  if (!m_input.is_open()) {
+    return false;
+  }
+
+  string frame;
+  while (true) {
+    uint32_t ts_sec, ts_subsec, incl_len, orig_len;
+    if (!(ReadUInt32(&ts_sec) && ReadUInt32(&ts_subsec) &&
+          ReadUInt32(&incl_len) && ReadUInt32(&orig_len))) {
+      return false;
+    }
+
+    if (incl_len > PCAP_SNAPLEN) {
+      OLA_WARN << "Corrupt pcap record of " << incl_len << " bytes";
+      return false;
+    }
+
+    frame.resize(incl_len);
+    if (incl_len) {
+      m_input.read(&frame[0], incl_len);
+      if (!m_input.good()) {
+        return false;
+      }
+    }
+
+    if (ExtractUDP(frame, packet)) {
+      struct timeval tv;
+      tv.tv_sec = ts_sec;
+      tv.tv_usec = m_nanoseconds ? ts_subsec / 1000 : ts_subsec;
+      packet->timestamp = tv;
+      return true;
+    }
+  }
+}
+
+
+bool PacketCaptureReader::ReadUInt32(uint32_t *value) {
+  m_input.read(reinterpret_cast<char*>(value), sizeof(*value));
+  if (!m_input.good()) {
+    return false;
+  }
+  if (m_swapped) {
+    *value = SwapUInt32(*value);
+  }
+  return true;
+}
+
+
+bool PacketCaptureReader::ExtractUDP(const string &frame,
+                                     CapturedPacket *packet) {
+  const uint8_t *data = reinterpret_cast<const uint8_t*>(frame.data());
+  unsigned int length = static_cast<unsigned int>(frame.size());
+  unsigned int offset = 0;
+
+  if (m_link_type == LINKTYPE_ETHERNET) {
+    if (length < ETHERNET_HEADER_SIZE) {
+      return false;
+    }
+    offset = ETHERNET_HEADER_SIZE;
+    uint16_t ethertype = ReadUInt16(data + offset - 2);
+    if (ethertype == ETHERTYPE_VLAN) {
+      if (length < ETHERNET_HEADER_SIZE + VLAN_TAG_SIZE) {
+        return false;
+      }
+      offset += VLAN_TAG_SIZE;
+      ethertype = ReadUInt16(data + offset - 2);
+    }
+    if (ethertype != ETHERTYPE_IPV4) {
+      return false;
+    }
+  } else if (m_link_type == LINKTYPE_LINUX_SLL) {
+    if (length < LINUX_SLL_HEADER_SIZE ||
+        ReadUInt16(data + LINUX_SLL_HEADER_SIZE - 2) != ETHERTYPE_IPV4) {
+      return false;
+    }
+    offset = LINUX_SLL_HEADER_SIZE;
+  }
+
+  if (length < offset + IPV4_HEADER_SIZE) {
+    return false;
+  }
+  const uint8_t *ip_header = data + offset;
+  unsigned int ip_header_size = (ip_header[0] & 0x0f) * 4;
+  uint16_t fragment = ReadUInt16(ip_header + 6);
+  if ((ip_header[0] >> 4) != 4 || ip_header_size < IPV4_HEADER_SIZE ||
+      ip_header[9] != IP_PROTOCOL_UDP || (fragment & 0x3fff)) {
+    return false;
+  }
+
+  offset += ip_header_size;
+  if (length < offset + UDP_HEADER_SIZE) {
+    return false;
+  }
+  const uint8_t *udp_header = data + offset;
+  unsigned int udp_length = ReadUInt16(udp_header + 4);
+  if (udp_length < UDP_HEADER_SIZE ||
+      length < offset + udp_length) {
+    return false;
+  }
+
+  uint32_t address;
+  memcpy(&address, ip_header + 12, sizeof(address));
+  packet->source = IPV4SocketAddress(IPV4Address(address),
+                                     ReadUInt16(udp_header));
+  memcpy(&address, ip_header + 16, sizeof(address));
+  packet->destination = IPV4SocketAddress(IPV4Address(address),
+                                          ReadUInt16(udp_header + 2));
+  packet->payload.assign(
+      reinterpret_cast<const char*>(udp_header + UDP_HEADER_SIZE),
+      udp_length - UDP_HEADER_SIZE);
+  return true;
+}
+
+
+void SetPacketCapture(PacketCaptureWriter *capture) {
+  AtomicStore(&s_packet_capture, capture);
+}
+
+
+PacketCaptureWriter *GetPacketCapture() {
+  return AtomicLoad(&s_packet_capture);
+}
+}  // namespace network
+}  // namespace ola
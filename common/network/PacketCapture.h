@@ -0,0 +1,166 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * PacketCapture.h
+ * Read and write UDP datagrams in the pcap file format.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef COMMON_NETWORK_PACKETCAPTURE_H_
+#define COMMON_NETWORK_PACKETCAPTURE_H_
+
+#include <stdint.h>
+#include <ola/Clock.h>
+#include <ola/base/Macro.h>
+#include <ola/network/SocketAddress.h>
+#include <ola/thread/Mutex.h>
+#include <fstream>
+#include <string>
+
+namespace ola {
+namespace network {
+
+/**
+ * @brief A UDP datagram read from a capture file.
+ */
+class CapturedPacket {
+ public:
+  CapturedPacket() {}
+
+  ola::TimeStamp timestamp;
+  IPV4SocketAddress source;
+  IPV4SocketAddress destination;
+  std::string payload;
+
+  const uint8_t *Data() const {
+    return reinterpret_cast<const uint8_t*>(payload.data());
+  }
+  unsigned int Size() const {
+    return static_cast<unsigned int>(payload.size());
+  }
+};
+
+
+/**
+ * @brief Write UDP datagrams to a pcap file.
+ *
+ * Each datagram is wrapped in synthesized IPv4 & UDP headers and written with
+ * the raw IP link type, so the files can be opened with Wireshark or tcpdump.
+ * This class is thread safe.
+ */
+class PacketCaptureWriter {
+ public:
+  /**
+   * @brief Create a new PacketCaptureWriter.
+   * @param clock the clock to timestamp packets with, ownership is not
+   *   transferred. If NULL a wall clock is used.
+   */
+  explicit PacketCaptureWriter(ola::Clock *clock = NULL);
+  ~PacketCaptureWriter();
+
+  /**
+   * @brief Open a file and write the pcap header, truncating the file.
+   */
+  bool Open(const std::string &filename);
+
+  void Close();
+
+  /**
+   * @brief Record a UDP datagram, timestamped with the current time.
+   */
+  bool WriteUDP(const IPV4SocketAddress &source,
+                const IPV4SocketAddress &destination,
+                const uint8_t *data,
+                unsigned int length);
+
+  /**
+   * @brief Record a UDP datagram with an explicit timestamp.
+   */
+  bool WriteUDP(const ola::TimeStamp &timestamp,
+                const IPV4SocketAddress &source,
+                const IPV4SocketAddress &destination,
+                const uint8_t *data,
+                unsigned int length);
+
+  unsigned int PacketCount() const { return m_packet_count; }
+
+ private:
+  ola::Clock *m_clock;
+  bool m_free_clock;
+  ola::thread::Mutex m_mutex;
+  std::ofstream m_output;
+  unsigned int m_packet_count;
+  uint16_t m_ip_id;
+
+  DISALLOW_COPY_AND_ASSIGN(PacketCaptureWriter);
+};
+
+
+/**
+ * @brief Read UDP datagrams from a pcap file.
+ *
+ * Files written by PacketCaptureWriter and Ethernet captures from tcpdump are
+ * supported. Anything that isn't an unfragmented IPv4 UDP datagram is skipped.
+ */
+class PacketCaptureReader {
+ public:
+  PacketCaptureReader();
+  ~PacketCaptureReader() {}
+
+  bool Open(const std::string &filename);
+  void Close();
+
+  /**
+   * @brief Read the next UDP datagram.
+   * @param packet the CapturedPacket to populate.
+   * @returns true if a packet was read, false at the end of the file or if
+   *   the file is corrupt.
+   */
+  bool Next(CapturedPacket *packet);
+
+ private:
+  std::ifstream m_input;
+  bool m_swapped;
+  bool m_nanoseconds;
+  uint32_t m_link_type;
+
+  bool ReadUInt32(uint32_t *value);
+  bool ExtractUDP(const std::string &frame, CapturedPacket *packet);
+
+  DISALLOW_COPY_AND_ASSIGN(PacketCaptureReader);
+};
+
+
+/**
+ * @brief Record the datagrams received by every UDPSocket.
+ *
+ * This is used to capture the traffic a running olad sees, so it can be
+ * replayed later. The capture should be set before the sockets are created.
+ * Where IP_PKTINFO is supported, sockets created while a capture is set
+ * record the address each datagram was sent to, e.g. the multicast group.
+ * Otherwise the destination is the address the socket is bound to, which is
+ * often the wildcard address.
+ * @param capture the PacketCaptureWriter to record to, ownership is not
+ *   transferred. Pass NULL to stop recording.
+ */
+void SetPacketCapture(PacketCaptureWriter *capture);
+
+/**
+ * @brief Return the PacketCaptureWriter set with SetPacketCapture(), or NULL.
+ */
+PacketCaptureWriter *GetPacketCapture();
+}  // namespace network
+}  // namespace ola
+#endif  // COMMON_NETWORK_PACKETCAPTURE_H_
@@ -0,0 +1,238 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * PacketCaptureTest.cpp
+ * Test fixture for the PacketCaptureWriter and PacketCaptureReader classes.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif  // HAVE_CONFIG_H
+
+#include "common/network/PacketCapture.h"
+#include "ola/Clock.h"
+#include "ola/network/IPV4Address.h"
+#include "ola/network/Socket.h"
+#include "ola/network/SocketAddress.h"
+#include "ola/testing/TestUtils.h"
+
+using ola::TimeInterval;
+using ola::TimeStamp;
+using ola::network::CapturedPacket;
+using ola::network::IPV4Address;
+using ola::network::IPV4SocketAddress;
+using ola::network::PacketCaptureReader;
+using ola::network::PacketCaptureWriter;
+using ola::network::UDPSocket;
+
+class PacketCaptureTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(PacketCaptureTest);
+  CPPUNIT_TEST(testRoundTrip);
+  CPPUNIT_TEST(testInvalidFile);
+  CPPUNIT_TEST(testSocketCapture);
+  CPPUNIT_TEST(testCaptureDestination);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+    void testRoundTrip();
+    void testInvalidFile();
+    void testSocketCapture();
+    void testCaptureDestination();
+    void tearDown();
+
+ private:
+    static const char CAPTURE_FILE[];
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PacketCaptureTest);
+
+const char PacketCaptureTest::CAPTURE_FILE[] =
+    TEST_BUILD_DIR "/common/network/PacketCaptureTest.pcap";
+
+
+void PacketCaptureTest::tearDown() {
+  ola::network::SetPacketCapture(NULL);
+  unlink(CAPTURE_FILE);
+}
+
+
+/*
+ * Check that datagrams survive a trip through a capture file.
+ */
+void PacketCaptureTest::testRoundTrip() {
+  const uint8_t first_payload[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  const uint8_t second_payload[] = {0xaa, 0xbb};
+  IPV4SocketAddress source =
+      IPV4SocketAddress::FromStringOrDie("192.168.1.10:5568");
+  IPV4SocketAddress destination =
+      IPV4SocketAddress::FromStringOrDie("239.255.0.1:5568");
+  IPV4SocketAddress other_source =
+      IPV4SocketAddress::FromStringOrDie("10.0.0.1:6454");
+
+  TimeStamp first_time = TimeStamp() + TimeInterval(1500000000, 123456);
+  TimeStamp second_time = first_time + TimeInterval(0, 25000);
+
+  PacketCaptureWriter writer;
+  OLA_ASSERT_TRUE(writer.Open(CAPTURE_FILE));
+  OLA_ASSERT_TRUE(writer.WriteUDP(first_time, source, destination,
+                                  first_payload, sizeof(first_payload)));
+  OLA_ASSERT_TRUE(writer.WriteUDP(second_time, other_source, destination,
+                                  second_payload, sizeof(second_payload)));
+  OLA_ASSERT_TRUE(writer.WriteUDP(source, destination, NULL, 0));
+  OLA_ASSERT_EQ(3u, writer.PacketCount());
+  writer.Close();
+
+  PacketCaptureReader reader;
+  OLA_ASSERT_TRUE(reader.Open(CAPTURE_FILE));
+
+  CapturedPacket packet;
+  OLA_ASSERT_TRUE(reader.Next(&packet));
+  OLA_ASSERT_EQ(first_time, packet.timestamp);
+  OLA_ASSERT_EQ(source, packet.source);
+  OLA_ASSERT_EQ(destination, packet.destination);
+  OLA_ASSERT_DATA_EQUALS(first_payload, sizeof(first_payload), packet.Data(),
+                         packet.Size());
+
+  OLA_ASSERT_TRUE(reader.Next(&packet));
+  OLA_ASSERT_EQ(second_time, packet.timestamp);
+  OLA_ASSERT_EQ(other_source, packet.source);
+  OLA_ASSERT_DATA_EQUALS(second_payload, sizeof(second_payload),
+                         packet.Data(), packet.Size());
+
+  OLA_ASSERT_TRUE(reader.Next(&packet));
+  OLA_ASSERT_EQ(0u, packet.Size());
+
+  OLA_ASSERT_FALSE(reader.Next(&packet));
+}
+
+
+/*
+ * Check that files which aren't captures are rejected.
+ */
+void PacketCaptureTest::testInvalidFile() {
+  PacketCaptureReader reader;
+  OLA_ASSERT_FALSE(reader.Open(TEST_BUILD_DIR "/does-not-exist.pcap"));
+
+  std::ofstream output(CAPTURE_FILE);
+  output << "this is not a pcap file, but it's long enough to be one";
+  output.close();
+  OLA_ASSERT_FALSE(reader.Open(CAPTURE_FILE));
+
+  CapturedPacket packet;
+  OLA_ASSERT_FALSE(reader.Next(&packet));
+}
+
+
+/*
+ * Check that datagrams received by a UDPSocket are recorded.
+ */
+void PacketCaptureTest::testSocketCapture() {
+  const uint8_t payload[] = {1, 2, 3, 4};
+
+  UDPSocket receiver;
+  OLA_ASSERT_TRUE(receiver.Init());
+  OLA_ASSERT_TRUE(receiver.Bind(
+      IPV4SocketAddress(IPV4Address::Loopback(), 0)));
+  IPV4SocketAddress destination;
+  OLA_ASSERT_TRUE(receiver.GetSocketAddress(&destination));
+
+  UDPSocket sender;
+  OLA_ASSERT_TRUE(sender.Init());
+  OLA_ASSERT_TRUE(sender.Bind(IPV4SocketAddress(IPV4Address::Loopback(), 0)));
+  IPV4SocketAddress source;
+  OLA_ASSERT_TRUE(sender.GetSocketAddress(&source));
+
+  PacketCaptureWriter writer;
+  OLA_ASSERT_TRUE(writer.Open(CAPTURE_FILE));
+  ola::network::SetPacketCapture(&writer);
+
+  OLA_ASSERT_EQ(static_cast<ssize_t>(sizeof(payload)),
+                sender.SendTo(payload, sizeof(payload), destination));
+  uint8_t buffer[100];
+  ssize_t size = sizeof(buffer);
+  IPV4SocketAddress received_from;
+  OLA_ASSERT_TRUE(receiver.RecvFrom(buffer, &size, &received_from));
+
+  ola::network::SetPacketCapture(NULL);
+  OLA_ASSERT_EQ(1u, writer.PacketCount());
+  writer.Close();
+
+  PacketCaptureReader reader;
+  OLA_ASSERT_TRUE(reader.Open(CAPTURE_FILE));
+  CapturedPacket packet;
+  OLA_ASSERT_TRUE(reader.Next(&packet));
+  OLA_ASSERT_EQ(source, packet.source);
+  OLA_ASSERT_EQ(destination, packet.destination);
+  OLA_ASSERT_DATA_EQUALS(payload, sizeof(payload), packet.Data(),
+                         packet.Size());
+  OLA_ASSERT_FALSE(reader.Next(&packet));
+}
+
+
+/*
+ * Check the capture records the address a datagram was sent to, rather than
+ * the wildcard address the socket is bound to.
+ */
+void PacketCaptureTest::testCaptureDestination() {
+  const uint8_t payload[] = {1, 2, 3, 4};
+
+  PacketCaptureWriter writer;
+  OLA_ASSERT_TRUE(writer.Open(CAPTURE_FILE));
+  ola::network::SetPacketCapture(&writer);
+
+  UDPSocket receiver;
+  OLA_ASSERT_TRUE(receiver.Init());
+  OLA_ASSERT_TRUE(receiver.Bind(
+      IPV4SocketAddress(IPV4Address::WildCard(), 0)));
+  IPV4SocketAddress bound_address;
+  OLA_ASSERT_TRUE(receiver.GetSocketAddress(&bound_address));
+  IPV4SocketAddress destination(IPV4Address::Loopback(),
+                                bound_address.Port());
+
+  UDPSocket sender;
+  OLA_ASSERT_TRUE(sender.Init());
+  OLA_ASSERT_EQ(static_cast<ssize_t>(sizeof(payload)),
+                sender.SendTo(payload, sizeof(payload), destination));
+  uint8_t buffer[100];
+  ssize_t size = sizeof(buffer);
+  OLA_ASSERT_TRUE(receiver.RecvFrom(buffer, &size));
+  OLA_ASSERT_EQ(static_cast<ssize_t>(sizeof(payload)), size);
+  IPV4SocketAddress sender_address;
+  OLA_ASSERT_TRUE(sender.GetSocketAddress(&sender_address));
+
+  ola::network::SetPacketCapture(NULL);
+  writer.Close();
+
+  PacketCaptureReader reader;
+  OLA_ASSERT_TRUE(reader.Open(CAPTURE_FILE));
+  CapturedPacket packet;
+  OLA_ASSERT_TRUE(reader.Next(&packet));
+#if HAVE_DECL_IP_PKTINFO
+  OLA_ASSERT_EQ(destination, packet.destination);
+#else
+  OLA_ASSERT_EQ(bound_address, packet.destination);
+#endif  // HAVE_DECL_IP_PKTINFO
+  // The source is recorded even though RecvFrom() didn't ask for it.
+  OLA_ASSERT_EQ(sender_address.Port(), packet.source.Port());
+  OLA_ASSERT_DATA_EQUALS(payload, sizeof(payload), packet.Data(),
+                         packet.Size());
+}
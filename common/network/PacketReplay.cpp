@@ -0,0 +1,85 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * PacketReplay.cpp
+ * Helpers for the tools that replay packet captures.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <unistd.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "common/network/PacketReplay.h"
+
+namespace ola {
+namespace network {
+
+using ola::TimeInterval;
+using ola::TimeStamp;
+using std::cout;
+using std::endl;
+using std::string;
+
+namespace {
+const double USEC_IN_SECOND = 1000000;
+}  // namespace
+
+void LatencyRecorder::NewDMX() {
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+  int64_t latency = (now - m_injected).AsInt();
+  m_total_usec += latency;
+  if (latency > m_max_usec) {
+    m_max_usec = latency;
+  }
+  m_frames++;
+}
+
+
+void WaitForPacket(ola::Clock *clock, uint16_t speed,
+                   const TimeStamp &replay_start,
+                   const TimeStamp &capture_start,
+                   const TimeStamp &packet_time) {
+  if (speed == 0) {
+    return;
+  }
+  int64_t offset = (packet_time - capture_start).AsInt() / speed;
+  TimeStamp due = replay_start + TimeInterval(offset);
+  TimeStamp now;
+  clock->CurrentTime(&now);
+  if (due > now) {
+    usleep(static_cast<useconds_t>((due - now).AsInt()));
+  }
+}
+
+
+void PrintReplaySummary(unsigned int packets,
+                        const TimeInterval &duration,
+                        const LatencyRecorder &recorder,
+                        const string &frame_type) {
+  double seconds = static_cast<double>(duration.AsInt()) / USEC_IN_SECOND;
+  if (seconds == 0) {
+    seconds = 1.0 / USEC_IN_SECOND;
+  }
+  cout << "Replayed " << packets << " packets in " << duration << ", "
+       << std::fixed << std::setprecision(0) << packets / seconds
+       << " packets/s" << endl;
+  cout << recorder.Frames() << " " << frame_type << " frames, latency mean "
+       << recorder.MeanLatency() << "us, max " << recorder.MaxLatency() << "us"
+       << endl;
+}
+}  // namespace network
+}  // namespace ola
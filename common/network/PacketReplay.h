@@ -0,0 +1,92 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * PacketReplay.h
+ * Helpers for the tools that replay packet captures.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef COMMON_NETWORK_PACKETREPLAY_H_
+#define COMMON_NETWORK_PACKETREPLAY_H_
+
+#include <stdint.h>
+#include <ola/Clock.h>
+#include <ola/base/Macro.h>
+#include <string>
+
+namespace ola {
+namespace network {
+
+/**
+ * @brief Records the time taken from injecting a packet until the DMX handler
+ * runs.
+ */
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(ola::Clock *clock)
+      : m_clock(clock),
+        m_frames(0),
+        m_total_usec(0),
+        m_max_usec(0) {
+  }
+
+  void PacketInjected() { m_clock->CurrentTime(&m_injected); }
+
+  void NewDMX();
+
+  unsigned int Frames() const { return m_frames; }
+  int64_t MeanLatency() const {
+    return m_frames ? m_total_usec / m_frames : 0;
+  }
+  int64_t MaxLatency() const { return m_max_usec; }
+
+ private:
+  ola::Clock *m_clock;
+  ola::TimeStamp m_injected;
+  unsigned int m_frames;
+  int64_t m_total_usec;
+  int64_t m_max_usec;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencyRecorder);
+};
+
+
+/**
+ * @brief Sleep until it's time to replay a packet.
+ * @param clock the clock to use.
+ * @param speed the replay speed as a multiple of real time, 0 doesn't wait.
+ * @param replay_start the time the replay started.
+ * @param capture_start the timestamp of the first packet in the capture.
+ * @param packet_time the timestamp of the packet to replay.
+ */
+void WaitForPacket(ola::Clock *clock, uint16_t speed,
+                   const ola::TimeStamp &replay_start,
+                   const ola::TimeStamp &capture_start,
+                   const ola::TimeStamp &packet_time);
+
+/**
+ * @brief Print the packet rate and latency of a replay to stdout.
+ * @param packets the number of packets replayed.
+ * @param duration how long the replay took.
+ * @param recorder the LatencyRecorder used during the replay.
+ * @param frame_type a description of the frames, e.g. "DMX".
+ */
+void PrintReplaySummary(unsigned int packets,
+                        const ola::TimeInterval &duration,
+                        const LatencyRecorder &recorder,
+                        const std::string &frame_type);
+}  // namespace network
+}  // namespace ola
+#endif  // COMMON_NETWORK_PACKETREPLAY_H_
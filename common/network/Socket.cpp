@@ -50,6 +50,7 @@
 
 #include <string>
 
+#include "common/network/PacketCapture.h"
 #include "common/network/SocketHelper.h"
 #include "ola/Logging.h"
 #include "ola/network/NetworkUtils.h"
@@ -60,8 +61,8 @@ namespace network {
 
 namespace {
 
-bool ReceiveFrom(int fd, uint8_t *buffer, ssize_t *data_read,
-                 struct sockaddr_in *source, socklen_t *src_size) {
+bool ReceiveDatagram(int fd, uint8_t *buffer, ssize_t *data_read,
+                     struct sockaddr_in *source, socklen_t *src_size) {
   *data_read = recvfrom(
     fd, reinterpret_cast<char*>(buffer), *data_read,
     0, reinterpret_cast<struct sockaddr*>(source), source ? src_size : NULL);
@@ -76,6 +77,101 @@ bool ReceiveFrom(int fd, uint8_t *buffer, ssize_t *data_read,
   return true;
 }
 
+#if HAVE_DECL_IP_PKTINFO
+/*
+ * Receive a datagram with recvmsg(), which also returns the address it was
+ * sent to if IP_PKTINFO is enabled on the socket.
+ */
+bool ReceiveMessage(int fd, uint8_t *buffer, ssize_t *data_read,
+                    struct sockaddr_in *source, socklen_t *src_size,
+                    IPV4Address *destination) {
+  struct iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len = *data_read;
+  char control[CMSG_SPACE(sizeof(struct in_pktinfo))];
+
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_name = source;
+  message.msg_namelen = *src_size;
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+
+  *data_read = recvmsg(fd, &message, 0);
+  if (*data_read < 0) {
+    OLA_WARN << "recvmsg fd: " << fd << " failed: " << strerror(errno);
+    return false;
+  }
+  *src_size = message.msg_namelen;
+
+  struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+  for (; header; header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level == IPPROTO_IP && header->cmsg_type == IP_PKTINFO) {
+      struct in_pktinfo info;
+      memcpy(&info, CMSG_DATA(header), sizeof(info));
+      *destination = IPV4Address(info.ipi_addr.s_addr);
+    }
+  }
+  return true;
+}
+#endif  // HAVE_DECL_IP_PKTINFO
+
+/*
+ * Receive a datagram and record it in the capture.
+ *
+ * Where IP_PKTINFO is supported the destination is the address the datagram
+ * was sent to, e.g. a multicast group. Otherwise it's the address the socket
+ * is bound to, which may be the wildcard address.
+ */
+bool ReceiveAndCapture(PacketCaptureWriter *capture, const UDPSocket *socket,
+                       int fd, uint8_t *buffer, ssize_t *data_read,
+                       struct sockaddr_in *source, socklen_t *src_size) {
+  struct sockaddr_in src_sockaddr;
+  socklen_t src_sockaddr_size = sizeof(src_sockaddr);
+  memset(&src_sockaddr, 0, sizeof(src_sockaddr));
+  IPV4SocketAddress local_address;
+  socket->GetSocketAddress(&local_address);
+  IPV4Address destination = local_address.Host();
+
+#if HAVE_DECL_IP_PKTINFO
+  bool ok = ReceiveMessage(fd, buffer, data_read, &src_sockaddr,
+                           &src_sockaddr_size, &destination);
+#else
+  bool ok = ReceiveDatagram(fd, buffer, data_read, &src_sockaddr,
+                            &src_sockaddr_size);
+#endif  // HAVE_DECL_IP_PKTINFO
+  if (!ok) {
+    return false;
+  }
+
+  if (source) {
+    *source = src_sockaddr;
+    *src_size = src_sockaddr_size;
+  }
+  capture->WriteUDP(
+      IPV4SocketAddress(IPV4Address(src_sockaddr.sin_addr.s_addr),
+                        NetworkToHost(src_sockaddr.sin_port)),
+      IPV4SocketAddress(destination, local_address.Port()),
+      buffer, static_cast<unsigned int>(*data_read));
+  return true;
+}
+
+/*
+ * Receive a datagram, recording it if a capture is active.
+ */
+bool ReceiveFrom(const UDPSocket *socket, int fd, uint8_t *buffer,
+                 ssize_t *data_read, struct sockaddr_in *source,
+                 socklen_t *src_size) {
+  PacketCaptureWriter *capture = GetPacketCapture();
+  if (capture) {
+    return ReceiveAndCapture(capture, socket, fd, buffer, data_read, source,
+                             src_size);
+  }
+  return ReceiveDatagram(fd, buffer, data_read, source, src_size);
+}
+
 }  // namespace
 
 // UDPSocket
@@ -101,6 +197,20 @@ bool UDPSocket::Init() {
 #else
   m_handle = sd;
 #endif  // _WIN32
+
+#if HAVE_DECL_IP_PKTINFO
+  if (GetPacketCapture()) {
+    // Ask for the destination address of each datagram, so the capture
+    // records the multicast group rather than the address we're bound to.
+    int pktinfo_flag = 1;
+    if (setsockopt(sd, IPPROTO_IP, IP_PKTINFO,
+                   reinterpret_cast<char*>(&pktinfo_flag),
+                   sizeof(pktinfo_flag)) < 0) {
+      OLA_WARN << "Failed to set IP_PKTINFO for " << sd << ", "
+               << strerror(errno);
+    }
+  }
+#endif  // HAVE_DECL_IP_PKTINFO
   return true;
 }
 
@@ -282,9 +392,10 @@ ssize_t UDPSocket::SendTo(ola::io::IOVecInterface *data,
 bool UDPSocket::RecvFrom(uint8_t *buffer, ssize_t *data_read) const {
   socklen_t length = 0;
 #ifdef _WIN32
-  return ReceiveFrom(m_handle.m_handle.m_fd, buffer, data_read, NULL, &length);
+  return ReceiveFrom(this, m_handle.m_handle.m_fd, buffer, data_read, NULL,
+                     &length);
 #else
-  return ReceiveFrom(m_handle, buffer, data_read, NULL, &length);
+  return ReceiveFrom(this, m_handle, buffer, data_read, NULL, &length);
 #endif  // _WIN32
 }
 
@@ -295,10 +406,11 @@ bool UDPSocket::RecvFrom(
   struct sockaddr_in src_sockaddr;
   socklen_t src_size = sizeof(src_sockaddr);
 #ifdef _WIN32
-  bool ok = ReceiveFrom(m_handle.m_handle.m_fd, buffer, data_read,
+  bool ok = ReceiveFrom(this, m_handle.m_handle.m_fd, buffer, data_read,
                         &src_sockaddr, &src_size);
 #else
-  bool ok = ReceiveFrom(m_handle, buffer, data_read, &src_sockaddr, &src_size);
+  bool ok = ReceiveFrom(this, m_handle, buffer, data_read, &src_sockaddr,
+                        &src_size);
 #endif  // _WIN32
   if (ok)
     source = IPV4Address(src_sockaddr.sin_addr.s_addr);
@@ -312,10 +424,11 @@ bool UDPSocket::RecvFrom(uint8_t *buffer,
   struct sockaddr_in src_sockaddr;
   socklen_t src_size = sizeof(src_sockaddr);
 #ifdef _WIN32
-  bool ok = ReceiveFrom(m_handle.m_handle.m_fd, buffer, data_read,
+  bool ok = ReceiveFrom(this, m_handle.m_handle.m_fd, buffer, data_read,
                         &src_sockaddr, &src_size);
 #else
-  bool ok = ReceiveFrom(m_handle, buffer, data_read, &src_sockaddr, &src_size);
+  bool ok = ReceiveFrom(this, m_handle, buffer, data_read, &src_sockaddr,
+                        &src_size);
 #endif  // _WIN32
   if (ok) {
     source = IPV4Address(src_sockaddr.sin_addr.s_addr);
@@ -330,10 +443,11 @@ bool UDPSocket::RecvFrom(uint8_t *buffer,
   struct sockaddr_in src_sockaddr;
   socklen_t src_size = sizeof(src_sockaddr);
 #ifdef _WIN32
-  bool ok = ReceiveFrom(m_handle.m_handle.m_fd, buffer, data_read,
+  bool ok = ReceiveFrom(this, m_handle.m_handle.m_fd, buffer, data_read,
                         &src_sockaddr, &src_size);
 #else
-  bool ok = ReceiveFrom(m_handle, buffer, data_read, &src_sockaddr, &src_size);
+  bool ok = ReceiveFrom(this, m_handle, buffer, data_read, &src_sockaddr,
+                        &src_size);
 #endif  // _WIN32
   if (ok) {
     *source = IPV4SocketAddress(IPV4Address(src_sockaddr.sin_addr.s_addr),
@@ -464,5 +578,26 @@ bool UDPSocket::SetTos(uint8_t tos) {
   }
   return true;
 }
+
+bool UDPSocket::SetMulticastAll(bool enable) {
+#if HAVE_DECL_IP_MULTICAST_ALL
+  int value = enable;
+  int ok = setsockopt(m_handle,
+                      IPPROTO_IP,
+                      IP_MULTICAST_ALL,
+                      reinterpret_cast<char*>(&value),
+                      sizeof(value));
+  if (ok < 0) {
+    OLA_WARN << "Failed to set IP_MULTICAST_ALL for " << m_handle << ", "
+             << strerror(errno);
+    return false;
+  }
+  return true;
+#else
+  OLA_WARN << "IP_MULTICAST_ALL isn't supported on this platform";
+  (void) enable;
+  return false;
+#endif  // HAVE_DECL_IP_MULTICAST_ALL
+}
 }  // namespace network
 }  // namespace ola
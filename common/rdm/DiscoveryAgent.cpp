@@ -18,6 +18,9 @@
  * Copyright (C) 2011 Simon Newton
  */
 
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
 #include "ola/Callback.h"
 #include "ola/Logging.h"
 #include "ola/rdm/DiscoveryAgent.h"
@@ -30,6 +33,20 @@ namespace ola {
 namespace rdm {
 
 using ola::utils::JoinUInt8;
+using std::vector;
+
+namespace {
+
+uint64_t UIDToInteger(const UID &uid) {
+  return ((static_cast<uint64_t>(uid.ManufacturerId()) << 32) +
+          uid.DeviceId());
+}
+
+UID IntegerToUID(uint64_t value) {
+  return UID(static_cast<uint16_t>(value >> 32),
+             static_cast<uint32_t>(value));
+}
+}  // namespace
 
 DiscoveryAgent::DiscoveryAgent(DiscoveryTargetInterface *target)
     : m_target(target),
@@ -45,7 +62,8 @@ DiscoveryAgent::DiscoveryAgent(DiscoveryTargetInterface *target)
       m_muting_uid(0, 0),
       m_unmute_count(0),
       m_mute_attempts(0),
-      m_tree_corrupt(false) {
+      m_tree_corrupt(false),
+      m_full_discovery(false) {
 }
 
 DiscoveryAgent::~DiscoveryAgent() {
@@ -58,6 +76,7 @@ void DiscoveryAgent::Abort() {
     delete range;
     m_uid_ranges.pop();
   }
+  m_resolved_ranges.clear();
 
   if (m_on_complete) {
     DiscoveryCompleteCallback *callback = m_on_complete;
@@ -114,10 +133,28 @@ void DiscoveryAgent::InitDiscovery(
 
   m_bad_uids.Clear();
   m_tree_corrupt = false;
+  m_full_discovery = !incremental;
+  m_resolved_ranges.clear();
 
   // push the first range on to the branch stack
   UID lower(0, 0);
-  m_uid_ranges.push(new UIDRange(lower, UID::AllDevices(), NULL));
+  UIDRange *root = new UIDRange(lower, UID::AllDevices(), NULL);
+  m_uid_ranges.push(root);
+
+  if (m_full_discovery && !m_branch_history.empty()) {
+    // Split the first range into the branches from the last full discovery.
+    // These are pushed in ascending order, so the highest branch is tried
+    // first, as it would be when splitting the whole range. Once they are
+    // done, the DUB for the entire range catches anything left over, like
+    // responders behind a proxy that was muted in a later branch.
+    OLA_DEBUG << "Starting discovery with " << m_branch_history.size()
+              << " branches";
+    root->split = true;
+    ResolvedRanges::const_iterator iter = m_branch_history.begin();
+    for (; iter != m_branch_history.end(); ++iter) {
+      m_uid_ranges.push(new UIDRange(iter->lower, iter->upper, root));
+    }
+  }
 
   m_unmute_count = 0;
   m_target->UnMuteAll(m_unmute_callback.get());
@@ -176,12 +213,7 @@ void DiscoveryAgent::IncrementalMuteComplete(bool status) {
 void DiscoveryAgent::SendDiscovery() {
   if (m_uid_ranges.empty()) {
     // we're hit the end of the stack, now we're done
-    if (m_on_complete) {
-      m_on_complete->Run(!m_tree_corrupt, m_uids);
-      m_on_complete = NULL;
-    } else {
-      OLA_WARN << "Discovery complete but no callback";
-    }
+    DiscoveryComplete();
     return;
   }
   UIDRange *range = m_uid_ranges.top();
@@ -363,18 +395,14 @@ void DiscoveryAgent::HandleCollision() {
   }
 
   // work out the mid point
-  uint64_t lower = ((static_cast<uint64_t>(lower_uid.ManufacturerId()) << 32) +
-                    lower_uid.DeviceId());
-  uint64_t upper = ((static_cast<uint64_t>(upper_uid.ManufacturerId()) << 32) +
-                    upper_uid.DeviceId());
-  uint64_t mid = (lower + upper) / 2;
-  UID mid_uid(mid >> 32, mid);
-  mid++;
-  UID mid_plus_one_uid(mid >> 32, mid);
+  uint64_t mid = (UIDToInteger(lower_uid) + UIDToInteger(upper_uid)) / 2;
+  UID mid_uid = IntegerToUID(mid);
+  UID mid_plus_one_uid = IntegerToUID(mid + 1);
   OLA_INFO << "Collision, splitting into: " << lower_uid << " - " << mid_uid
            << " , " << mid_plus_one_uid << " - " << upper_uid;
 
   range->uids_discovered = 0;
+  range->split = true;
   // add both ranges to the stack
   m_uid_ranges.push(new UIDRange(lower_uid, mid_uid, range));
   m_uid_ranges.push(new UIDRange(mid_plus_one_uid, upper_uid, range));
@@ -395,8 +423,74 @@ void DiscoveryAgent::FreeCurrentRange() {
   } else {
     range->parent->uids_discovered += range->uids_discovered;
   }
+
+  if (!range->split) {
+    m_resolved_ranges.push_back(
+        ResolvedRange(range->lower, range->upper, range->uids_discovered));
+  }
   delete range;
   m_uid_ranges.pop();
 }
+
+
+/*
+ * Called when the branch stack is empty. This records the branches for the
+ * next full discovery and runs the callback.
+ */
+void DiscoveryAgent::DiscoveryComplete() {
+  if (m_full_discovery) {
+    if (!m_tree_corrupt && CoalesceRanges(&m_resolved_ranges)) {
+      m_branch_history.swap(m_resolved_ranges);
+    } else {
+      m_branch_history.clear();
+    }
+  }
+  m_resolved_ranges.clear();
+
+  if (m_on_complete) {
+    DiscoveryCompleteCallback *callback = m_on_complete;
+    m_on_complete = NULL;
+    callback->Run(!m_tree_corrupt, m_uids);
+  } else {
+    OLA_WARN << "Discovery complete but no callback";
+  }
+}
+
+
+/*
+ * Sort the resolved branches and merge neighbours, as long as each merged
+ * branch contains at most one responder.
+ * @returns false if the branches don't cover the entire UID space.
+ */
+bool DiscoveryAgent::CoalesceRanges(ResolvedRanges *ranges) {
+  if (ranges->empty()) {
+    return false;
+  }
+
+  std::sort(ranges->begin(), ranges->end());
+  if (ranges->front().lower != UID(0, 0) ||
+      ranges->back().upper != UID::AllDevices()) {
+    return false;
+  }
+
+  ResolvedRanges coalesced;
+  coalesced.push_back(ranges->front());
+  ResolvedRanges::const_iterator iter = ranges->begin() + 1;
+  for (; iter != ranges->end(); ++iter) {
+    ResolvedRange &last = coalesced.back();
+    if (UIDToInteger(last.upper) + 1 != UIDToInteger(iter->lower)) {
+      return false;
+    }
+
+    if (last.uids + iter->uids <= 1) {
+      last.upper = iter->upper;
+      last.uids += iter->uids;
+    } else {
+      coalesced.push_back(*iter);
+    }
+  }
+  ranges->swap(coalesced);
+  return true;
+}
 }  // namespace rdm
 }  // namespace ola
@@ -51,6 +51,7 @@ class DiscoveryAgentTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testNonMutingResponder);
   CPPUNIT_TEST(testFlakeyResponder);
   CPPUNIT_TEST(testProxy);
+  CPPUNIT_TEST(testBranchHistory);
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -69,6 +70,7 @@ class DiscoveryAgentTest: public CppUnit::TestFixture {
     void testNonMutingResponder();
     void testFlakeyResponder();
     void testProxy();
+    void testBranchHistory();
 
  private:
     bool m_callback_run;
@@ -478,4 +480,89 @@ void DiscoveryAgentTest::testProxy() {
                              static_cast<const UIDSet*>(&uids)));
   OLA_ASSERT_TRUE(m_callback_run);
   m_callback_run = false;
+
+  // The second run starts from the branches of the first. The proxied
+  // responders are in different branches to the proxies.
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoverySuccessful,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  m_callback_run = false;
+}
+
+
+/**
+ * Check that a full discovery re-uses the branches from the last one.
+ */
+void DiscoveryAgentTest::testBranchHistory() {
+  UIDSet uids;
+  ResponderList responders;
+  for (unsigned int i = 0; i < 40; i++) {
+    uids.AddUID(UID(0x7a70, 0x1000 + 3 * i));
+  }
+  uids.AddUID(UID(0x0001, 0x00000001));
+  uids.AddUID(UID(0x4150, 0x12345678));
+  PopulateResponderListFromUIDs(uids, &responders);
+  MockDiscoveryTarget target(responders);
+
+  DiscoveryAgent agent(&target);
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoverySuccessful,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  m_callback_run = false;
+  unsigned int first_branch_count = target.BranchCallCount();
+
+  // At most, each responder needs a DUB to find it and one to check the
+  // branch is done, plus one for the entire range.
+  target.ResetCounters();
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoverySuccessful,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  m_callback_run = false;
+  OLA_ASSERT_LTE(target.BranchCallCount(), 2 * uids.Size() + 1);
+  OLA_ASSERT_EQ(uids.Size(), target.MuteCallCount());
+  OLA_ASSERT_LT(target.BranchCallCount(), first_branch_count);
+
+  // Now change the responders, the new ones share branches with the existing
+  // responders.
+  UID uid_to_remove(0x7a70, 0x1000 + 3 * 5);
+  UID uid_to_add(0x7a70, 0x1000 + 3 * 8 + 1);
+  UID uid_to_add2(0x7a70, 0x00000010);
+  uids.RemoveUID(uid_to_remove);
+  uids.AddUID(uid_to_add);
+  uids.AddUID(uid_to_add2);
+  target.RemoveResponder(uid_to_remove);
+  target.AddResponder(new MockResponder(uid_to_add));
+  target.AddResponder(new MockResponder(uid_to_add2));
+
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoverySuccessful,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  m_callback_run = false;
+
+  // A failed discovery clears the history
+  UID non_muting_uid(0x7a77, 0x00002002);
+  target.AddResponder(new NonMutingResponder(non_muting_uid));
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoveryFailed,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  m_callback_run = false;
+
+  target.RemoveResponder(non_muting_uid);
+  target.ResetCounters();
+  agent.StartFullDiscovery(
+      ola::NewSingleCallback(this,
+                             &DiscoveryAgentTest::DiscoverySuccessful,
+                             static_cast<const UIDSet*>(&uids)));
+  OLA_ASSERT_TRUE(m_callback_run);
+  OLA_ASSERT_GT(target.BranchCallCount(), 2 * uids.Size() + 1);
 }
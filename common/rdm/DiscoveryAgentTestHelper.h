@@ -340,7 +340,9 @@ class MockDiscoveryTarget: public ola::rdm::DiscoveryTargetInterface {
  public:
     explicit MockDiscoveryTarget(const ResponderList &responders)
         : m_responders(responders),
-          m_unmute_calls(0) {
+          m_unmute_calls(0),
+          m_mute_calls(0),
+          m_branch_calls(0) {
     }
 
     ~MockDiscoveryTarget() {
@@ -351,15 +353,26 @@ class MockDiscoveryTarget: public ola::rdm::DiscoveryTargetInterface {
 
     void ResetCounters() {
       m_unmute_calls = 0;
+      m_mute_calls = 0;
+      m_branch_calls = 0;
     }
 
     unsigned int UnmuteCallCount() const {
       return m_unmute_calls;
     }
 
+    unsigned int MuteCallCount() const {
+      return m_mute_calls;
+    }
+
+    unsigned int BranchCallCount() const {
+      return m_branch_calls;
+    }
+
     // Mute a device
     void MuteDevice(const ola::rdm::UID &target,
                     MuteDeviceCallback *mute_complete) {
+      m_mute_calls++;
       ResponderList::const_iterator iter = m_responders.begin();
       for (; iter != m_responders.end(); ++iter) {
         if ((*iter)->Mute(target)) {
@@ -385,6 +398,7 @@ class MockDiscoveryTarget: public ola::rdm::DiscoveryTargetInterface {
     void Branch(const ola::rdm::UID &lower,
                 const ola::rdm::UID &upper,
                 BranchCallback *callback) {
+      m_branch_calls++;
       // alloc twice the amount we need
       unsigned int data_size = 2 * MockResponder::DISCOVERY_RESPONSE_SIZE;
       uint8_t data[data_size];
@@ -426,5 +440,7 @@ class MockDiscoveryTarget: public ola::rdm::DiscoveryTargetInterface {
  private:
     ResponderList m_responders;
     unsigned int m_unmute_calls;
+    unsigned int m_mute_calls;
+    unsigned int m_branch_calls;
 };
 #endif  // COMMON_RDM_DISCOVERYAGENTTESTHELPER_H_
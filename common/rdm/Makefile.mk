@@ -73,6 +73,40 @@ EXTRA_DIST += \
     common/rdm/testdata/pids/pids2.proto \
     common/rdm/testdata/test_pids.proto
 
+# PROGRAMS
+##################################################
+noinst_PROGRAMS += \
+    common/rdm/param_data_benchmark \
+    common/rdm/pid_store_benchmark \
+    common/rdm/pid_store_compiler \
+    common/rdm/uidset_benchmark
+
+common_rdm_param_data_benchmark_SOURCES = \
+    common/rdm/param_data_benchmark.cpp
+common_rdm_param_data_benchmark_CXXFLAGS = $(COMMON_PROTOBUF_CXXFLAGS)
+common_rdm_param_data_benchmark_LDADD = common/libolacommon.la
+
+common_rdm_pid_store_benchmark_SOURCES = common/rdm/pid_store_benchmark.cpp
+common_rdm_pid_store_benchmark_CXXFLAGS = $(COMMON_PROTOBUF_CXXFLAGS)
+common_rdm_pid_store_benchmark_LDADD = common/libolacommon.la
+
+common_rdm_pid_store_compiler_SOURCES = common/rdm/pid_store_compiler.cpp
+common_rdm_pid_store_compiler_CXXFLAGS = $(COMMON_PROTOBUF_CXXFLAGS)
+common_rdm_pid_store_compiler_LDADD = common/libolacommon.la
+
+common_rdm_uidset_benchmark_SOURCES = common/rdm/uidset_benchmark.cpp
+common_rdm_uidset_benchmark_CXXFLAGS = $(COMMON_CXXFLAGS)
+common_rdm_uidset_benchmark_LDADD = common/libolacommon.la
+
+# The benchmark uses the mock responders from the DiscoveryAgent tests.
+if BUILD_TESTS
+noinst_PROGRAMS += common/rdm/discovery_benchmark
+
+common_rdm_discovery_benchmark_SOURCES = common/rdm/discovery_benchmark.cpp
+common_rdm_discovery_benchmark_CXXFLAGS = $(COMMON_TESTING_FLAGS)
+common_rdm_discovery_benchmark_LDADD = $(CPPUNIT_LIBS) common/libolacommon.la
+endif
+
 # TESTS
 ##################################################
 test_programs += \
@@ -107,6 +141,7 @@ common_rdm_RDMMessageTester_SOURCES = \
     common/rdm/GroupSizeCalculatorTest.cpp \
     common/rdm/MessageSerializerTest.cpp \
     common/rdm/MessageDeserializerTest.cpp \
+    common/rdm/ParamDataCodecTest.cpp \
     common/rdm/RDMMessageInterationTest.cpp \
     common/rdm/StringMessageBuilderTest.cpp \
     common/rdm/VariableFieldSizeCalculatorTest.cpp
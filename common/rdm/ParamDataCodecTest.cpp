@@ -0,0 +1,232 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * ParamDataCodecTest.cpp
+ * Test fixture for the PidCodecs.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <string>
+
+#include "ola/rdm/ParamDataCodec.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/testing/TestUtils.h"
+
+using ola::rdm::DeviceDescriptor;
+using ola::rdm::PackParamData;
+using ola::rdm::ParamDataReader;
+using ola::rdm::ParamDataWriter;
+using ola::rdm::PersonalityDescription;
+using ola::rdm::PidCodec;
+using ola::rdm::SensorDescriptor;
+using ola::rdm::SensorValueDescriptor;
+using ola::rdm::UnpackParamData;
+using std::string;
+
+class ParamDataCodecTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(ParamDataCodecTest);
+  CPPUNIT_TEST(testReaderWriter);
+  CPPUNIT_TEST(testDeviceInfo);
+  CPPUNIT_TEST(testPersonalityDescription);
+  CPPUNIT_TEST(testSensors);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void testReaderWriter();
+  void testDeviceInfo();
+  void testPersonalityDescription();
+  void testSensors();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ParamDataCodecTest);
+
+
+/*
+ * Check the reader & writer.
+ */
+void ParamDataCodecTest::testReaderWriter() {
+  uint8_t buffer[8];
+  ParamDataWriter writer(buffer, sizeof(buffer));
+  writer.Write<uint8_t>(1);
+  writer.Write<int16_t>(-2);
+  writer.Write<uint32_t>(0x01020304);
+  OLA_ASSERT_TRUE(writer.Ok());
+  OLA_ASSERT_EQ(7u, writer.Size());
+  writer.Write<uint16_t>(5);
+  OLA_ASSERT_FALSE(writer.Ok());
+  OLA_ASSERT_EQ(7u, writer.Size());
+
+  const uint8_t expected[] = {1, 0xff, 0xfe, 1, 2, 3, 4};
+  OLA_ASSERT_DATA_EQUALS(expected, sizeof(expected), buffer, writer.Size());
+
+  ParamDataReader reader(buffer, writer.Size());
+  OLA_ASSERT_EQ(static_cast<uint8_t>(1), reader.Read<uint8_t>());
+  OLA_ASSERT_EQ(static_cast<int16_t>(-2), reader.Read<int16_t>());
+  OLA_ASSERT_EQ(static_cast<uint32_t>(0x01020304), reader.Read<uint32_t>());
+  OLA_ASSERT_TRUE(reader.Ok());
+  OLA_ASSERT_EQ(0u, reader.Remaining());
+  OLA_ASSERT_EQ(static_cast<uint8_t>(0), reader.Read<uint8_t>());
+  OLA_ASSERT_FALSE(reader.Ok());
+
+  // Strings are truncated at the first NULL.
+  const uint8_t string_data[] = {'f', 'o', 'o', 0, 'b'};
+  ParamDataReader string_reader(string_data, sizeof(string_data));
+  string value;
+  string_reader.ReadString(&value);
+  OLA_ASSERT_TRUE(string_reader.Ok());
+  OLA_ASSERT_EQ(string("foo"), value);
+}
+
+
+/*
+ * Check DEVICE_INFO.
+ */
+void ParamDataCodecTest::testDeviceInfo() {
+  const uint8_t expected[] = {
+    1, 0,  // protocol version
+    1, 2,  // model
+    0x05, 0x09,  // product category
+    0, 0, 0, 0x0a,  // software version
+    0, 4,  // footprint
+    1, 3,  // personalities
+    0, 0x10,  // start address
+    0, 2,  // sub devices
+    5  // sensors
+  };
+
+  DeviceDescriptor device_info;
+  device_info.protocol_version_high = 1;
+  device_info.protocol_version_low = 0;
+  device_info.device_model = 0x0102;
+  device_info.product_category = ola::rdm::PRODUCT_CATEGORY_DIMMER_CS_LED;
+  device_info.software_version = 10;
+  device_info.dmx_footprint = 4;
+  device_info.current_personality = 1;
+  device_info.personality_count = 3;
+  device_info.dmx_start_address = 16;
+  device_info.sub_device_count = 2;
+  device_info.sensor_count = 5;
+
+  uint8_t data[PidCodec<ola::rdm::PID_DEVICE_INFO>::MAX_SIZE];
+  unsigned int size = PackParamData<ola::rdm::PID_DEVICE_INFO>(
+      device_info, data, sizeof(data));
+  OLA_ASSERT_DATA_EQUALS(expected, sizeof(expected), data, size);
+
+  // Too small
+  OLA_ASSERT_EQ(0u, PackParamData<ola::rdm::PID_DEVICE_INFO>(
+      device_info, data, sizeof(data) - 1));
+
+  DeviceDescriptor output;
+  OLA_ASSERT_TRUE(UnpackParamData<ola::rdm::PID_DEVICE_INFO>(
+      expected, sizeof(expected), &output));
+  OLA_ASSERT_EQ(static_cast<uint16_t>(0x0102),
+                static_cast<uint16_t>(output.device_model));
+  OLA_ASSERT_EQ(static_cast<uint16_t>(0x0509),
+                static_cast<uint16_t>(output.product_category));
+  OLA_ASSERT_EQ(static_cast<uint32_t>(10),
+                static_cast<uint32_t>(output.software_version));
+  OLA_ASSERT_EQ(static_cast<uint16_t>(16),
+                static_cast<uint16_t>(output.dmx_start_address));
+  OLA_ASSERT_EQ(static_cast<uint8_t>(5),
+                static_cast<uint8_t>(output.sensor_count));
+
+  OLA_ASSERT_FALSE(UnpackParamData<ola::rdm::PID_DEVICE_INFO>(
+      expected, sizeof(expected) - 1, &output));
+}
+
+
+/*
+ * Check DMX_PERSONALITY_DESCRIPTION, which has a variable length.
+ */
+void ParamDataCodecTest::testPersonalityDescription() {
+  PersonalityDescription description;
+  description.personality = 2;
+  description.slots_required = 0x0203;
+  description.description = "RGB";
+
+  const uint8_t expected[] = {2, 2, 3, 'R', 'G', 'B'};
+  uint8_t data[
+      PidCodec<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>::MAX_SIZE];
+  unsigned int size = PackParamData<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>(
+      description, data, sizeof(data));
+  OLA_ASSERT_DATA_EQUALS(expected, sizeof(expected), data, size);
+
+  // Long descriptions are truncated
+  description.description = string(40, 'x');
+  size = PackParamData<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>(
+      description, data, sizeof(data));
+  OLA_ASSERT_EQ(35u, size);
+
+  PersonalityDescription output;
+  OLA_ASSERT_TRUE(UnpackParamData<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>(
+      expected, sizeof(expected), &output));
+  OLA_ASSERT_EQ(static_cast<uint8_t>(2), output.personality);
+  OLA_ASSERT_EQ(static_cast<uint16_t>(0x0203), output.slots_required);
+  OLA_ASSERT_EQ(string("RGB"), output.description);
+
+  // No description is fine, but the other fields are required.
+  OLA_ASSERT_TRUE(UnpackParamData<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>(
+      expected, 3, &output));
+  OLA_ASSERT_EQ(string(""), output.description);
+  OLA_ASSERT_FALSE(UnpackParamData<ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION>(
+      expected, 2, &output));
+}
+
+
+/*
+ * Check SENSOR_DEFINITION & SENSOR_VALUE, which have signed fields.
+ */
+void ParamDataCodecTest::testSensors() {
+  SensorDescriptor definition;
+  definition.sensor_number = 1;
+  definition.type = ola::rdm::SENSOR_TEMPERATURE;
+  definition.unit = ola::rdm::UNITS_CENTIGRADE;
+  definition.prefix = ola::rdm::PREFIX_NONE;
+  definition.range_min = -40;
+  definition.range_max = 120;
+  definition.normal_min = 0;
+  definition.normal_max = 80;
+  definition.recorded_value_support = 3;
+  definition.description = "Temp";
+
+  uint8_t data[PidCodec<ola::rdm::PID_SENSOR_DEFINITION>::MAX_SIZE];
+  unsigned int size = PackParamData<ola::rdm::PID_SENSOR_DEFINITION>(
+      definition, data, sizeof(data));
+  OLA_ASSERT_EQ(17u, size);
+
+  SensorDescriptor output;
+  OLA_ASSERT_TRUE(UnpackParamData<ola::rdm::PID_SENSOR_DEFINITION>(
+      data, size, &output));
+  OLA_ASSERT_EQ(static_cast<int16_t>(-40), output.range_min);
+  OLA_ASSERT_EQ(static_cast<int16_t>(120), output.range_max);
+  OLA_ASSERT_EQ(static_cast<uint8_t>(3), output.recorded_value_support);
+  OLA_ASSERT_EQ(string("Temp"), output.description);
+
+  const uint8_t value_data[] = {2, 0xff, 0xff, 0, 1, 0x80, 0, 0x7f, 0xff};
+  SensorValueDescriptor value;
+  OLA_ASSERT_TRUE(UnpackParamData<ola::rdm::PID_SENSOR_VALUE>(
+      value_data, sizeof(value_data), &value));
+  OLA_ASSERT_EQ(static_cast<uint8_t>(2),
+                static_cast<uint8_t>(value.sensor_number));
+  OLA_ASSERT_EQ(static_cast<int16_t>(-1),
+                static_cast<int16_t>(value.present_value));
+  OLA_ASSERT_EQ(static_cast<int16_t>(1), static_cast<int16_t>(value.lowest));
+  OLA_ASSERT_EQ(static_cast<int16_t>(-32768),
+                static_cast<int16_t>(value.highest));
+  OLA_ASSERT_EQ(static_cast<int16_t>(32767),
+                static_cast<int16_t>(value.recorded));
+}
@@ -18,6 +18,7 @@
  * Copyright (C) 2011 Simon Newton
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -33,16 +34,47 @@ namespace rdm {
 using std::string;
 using std::vector;
 
+namespace {
+
+bool ValueLessThan(const PidDescriptor *pid, uint16_t value) {
+  return pid->Value() < value;
+}
+
+bool NameLessThan(const PidDescriptor *pid, const string &name) {
+  return pid->Name() < name;
+}
+
+bool CompareValues(const PidDescriptor *first, const PidDescriptor *second) {
+  return first->Value() < second->Value();
+}
+
+bool CompareNames(const PidDescriptor *first, const PidDescriptor *second) {
+  return first->Name() < second->Name();
+}
+}  // namespace
+
 RootPidStore::~RootPidStore() {
   m_esta_store.reset();
   STLDeleteValues(&m_manufacturer_store);
 }
 
 const PidStore *RootPidStore::ManufacturerStore(uint16_t esta_id) const {
+  if (!m_loader.get()) {
+    ManufacturerMap::const_iterator iter = m_manufacturer_store.find(esta_id);
+    if (iter == m_manufacturer_store.end())
+      return NULL;
+    return iter->second;
+  }
+
+  ola::thread::MutexLocker locker(&m_mutex);
   ManufacturerMap::const_iterator iter = m_manufacturer_store.find(esta_id);
-  if (iter == m_manufacturer_store.end())
-    return NULL;
-  return iter->second;
+  if (iter != m_manufacturer_store.end())
+    return iter->second;
+
+  // Remember manufacturers without parameters as well, so we only try once.
+  const PidStore *store = m_loader->LoadStore(esta_id);
+  m_manufacturer_store[esta_id] = store;
+  return store;
 }
 
 const PidDescriptor *RootPidStore::GetDescriptor(
@@ -128,26 +160,20 @@ const string RootPidStore::DataLocation() {
   return PID_DATA_DIR;
 }
 
-PidStore::PidStore(const vector<const PidDescriptor*> &pids) {
-  vector<const PidDescriptor*>::const_iterator iter = pids.begin();
-  for (; iter != pids.end(); ++iter) {
-    m_pid_by_value[(*iter)->Value()] = *iter;
-    m_pid_by_name[(*iter)->Name()] = *iter;
-  }
+PidStore::PidStore(const vector<const PidDescriptor*> &pids)
+    : m_pid_by_value(pids),
+      m_pid_by_name(pids) {
+  std::sort(m_pid_by_value.begin(), m_pid_by_value.end(), CompareValues);
+  std::sort(m_pid_by_name.begin(), m_pid_by_name.end(), CompareNames);
 }
 
 PidStore::~PidStore() {
-  STLDeleteValues(&m_pid_by_value);
+  STLDeleteElements(&m_pid_by_value);
   m_pid_by_name.clear();
 }
 
 void PidStore::AllPids(vector<const PidDescriptor*> *pids) const {
-  pids->reserve(pids->size() + m_pid_by_value.size());
-
-  PidMap::const_iterator iter = m_pid_by_value.begin();
-  for (; iter != m_pid_by_value.end(); ++iter) {
-    pids->push_back(iter->second);
-  }
+  pids->insert(pids->end(), m_pid_by_value.begin(), m_pid_by_value.end());
 }
 
 
@@ -167,11 +193,13 @@ PidDescriptor::~PidDescriptor() {
  * @param pid_value the 16 bit pid value.
  */
 const PidDescriptor *PidStore::LookupPID(uint16_t pid_value) const {
-  PidMap::const_iterator iter = m_pid_by_value.find(pid_value);
-  if (iter == m_pid_by_value.end())
+  PidList::const_iterator iter = std::lower_bound(
+      m_pid_by_value.begin(), m_pid_by_value.end(), pid_value,
+      ValueLessThan);
+  if (iter == m_pid_by_value.end() || (*iter)->Value() != pid_value)
     return NULL;
   else
-    return iter->second;
+    return *iter;
 }
 
 
@@ -180,11 +208,12 @@ const PidDescriptor *PidStore::LookupPID(uint16_t pid_value) const {
  * @param pid_name the name of the pid.
  */
 const PidDescriptor *PidStore::LookupPID(const string &pid_name) const {
-  PidNameMap::const_iterator iter = m_pid_by_name.find(pid_name);
-  if (iter == m_pid_by_name.end())
+  PidList::const_iterator iter = std::lower_bound(
+      m_pid_by_name.begin(), m_pid_by_name.end(), pid_name, NameLessThan);
+  if (iter == m_pid_by_name.end() || (*iter)->Name() != pid_name)
     return NULL;
   else
-    return iter->second;
+    return *iter;
 }
 
 
@@ -21,6 +21,14 @@
 #include <errno.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <algorithm>
 #include <fstream>
 #include <set>
 #include <sstream>
@@ -52,10 +60,79 @@ using std::vector;
 const char PidStoreLoader::OVERRIDE_FILE_NAME[] = "overrides.proto";
 const char PidStoreLoader::MANUFACTURER_NAMES_FILE_NAME[] =
     "manufacturer_names.proto";
+const char PidStoreLoader::COMPILED_FILE_NAME[] = "compiled_pids.bin";
+const char PidStoreLoader::COMPILED_MAGIC[] = "OLAPIDS1";
 const uint16_t PidStoreLoader::ESTA_MANUFACTURER_ID = 0;
 const uint16_t PidStoreLoader::MANUFACTURER_PID_MIN = 0x8000;
 const uint16_t PidStoreLoader::MANUFACTURER_PID_MAX = 0xffe0;
 
+namespace {
+
+const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+/*
+ * Update a 64 bit FNV-1a hash.
+ */
+uint64_t FNVHash(uint64_t hash, const char *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+/*
+ * Builds the manufacturer PidStores from a CompiledPidStore as they're needed.
+ */
+class CompiledManufacturerStoreLoader
+    : public RootPidStore::ManufacturerStoreLoader {
+ public:
+  /*
+   * Takes ownership of compiled.
+   */
+  CompiledManufacturerStoreLoader(ola::rdm::pid::CompiledPidStore *compiled,
+                                  bool validate)
+      : m_compiled(compiled),
+        m_validate(validate) {
+    IndexManufacturers(m_compiled->overrides(), &m_overrides);
+    IndexManufacturers(m_compiled->pids(), &m_manufacturers);
+  }
+
+  const PidStore *LoadStore(uint16_t esta_id) {
+    const ola::rdm::pid::Manufacturer *override_pb = STLFindOrNull(
+        m_overrides, esta_id);
+    const ola::rdm::pid::Manufacturer *manufacturer_pb = STLFindOrNull(
+        m_manufacturers, esta_id);
+    if (!override_pb && !manufacturer_pb) {
+      return NULL;
+    }
+    return m_loader.BuildManufacturerStore(override_pb, manufacturer_pb,
+                                           m_validate);
+  }
+
+ private:
+  typedef map<uint16_t, const ola::rdm::pid::Manufacturer*> ManufacturerIndex;
+
+  auto_ptr<ola::rdm::pid::CompiledPidStore> m_compiled;
+  const bool m_validate;
+  PidStoreLoader m_loader;
+  ManufacturerIndex m_overrides;
+  ManufacturerIndex m_manufacturers;
+
+  static void IndexManufacturers(const ola::rdm::pid::PidStore &store,
+                                 ManufacturerIndex *index) {
+    for (int i = 0; i < store.manufacturer_size(); ++i) {
+      const ola::rdm::pid::Manufacturer &manufacturer = store.manufacturer(i);
+      (*index)[static_cast<uint16_t>(manufacturer.manufacturer_id())] =
+          &manufacturer;
+    }
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledManufacturerStoreLoader);
+};
+}  // namespace
+
 const RootPidStore *PidStoreLoader::LoadFromFile(const string &file,
                                                  bool validate) {
   std::ifstream proto_file(file.data());
@@ -73,59 +150,134 @@ const RootPidStore *PidStoreLoader::LoadFromFile(const string &file,
 const RootPidStore *PidStoreLoader::LoadFromDirectory(
     const string &directory,
     bool validate) {
-  vector<string> files;
-
-  string override_file;
-  string manufacturer_names_file;
-  vector<string> all_files;
-  ola::file::ListDirectory(directory, &all_files);
-  vector<string>::const_iterator file_iter = all_files.begin();
-  for (; file_iter != all_files.end(); ++file_iter) {
-    if (ola::file::FilenameFromPath(*file_iter) == OVERRIDE_FILE_NAME) {
-      override_file = *file_iter;
-    } else if (ola::file::FilenameFromPath(*file_iter) ==
-               MANUFACTURER_NAMES_FILE_NAME) {
-      manufacturer_names_file = *file_iter;
-    } else if (StringEndsWith(*file_iter, ".proto")) {
-      files.push_back(*file_iter);
+  const string compiled_file = ola::file::JoinPaths(directory,
+                                                    COMPILED_FILE_NAME);
+  auto_ptr<ola::rdm::pid::CompiledPidStore> compiled(
+      new ola::rdm::pid::CompiledPidStore());
+  if (ReadCompiledFile(compiled_file, compiled.get())) {
+    uint64_t source_hash;
+    if (SourceHash(directory, &source_hash) &&
+        source_hash == compiled->source_hash()) {
+      const RootPidStore *store = BuildCompiledStore(compiled.release(),
+                                                     validate);
+      if (store) {
+        return store;
+      }
+      OLA_WARN << "Failed to load " << compiled_file;
+    } else {
+      OLA_INFO << compiled_file << " is out of date, using the text files";
     }
   }
+  return LoadFromTextDirectory(directory, validate);
+}
 
+const RootPidStore *PidStoreLoader::LoadFromTextDirectory(
+    const string &directory,
+    bool validate) {
   ola::rdm::pid::PidStore pid_store_pb;
-  vector<string>::const_iterator iter = files.begin();
-  for (; iter != files.end(); ++iter) {
-    std::ifstream proto_file(iter->data());
-    if (!proto_file.is_open()) {
-      OLA_WARN << "Failed to open " << *iter << ": " << strerror(errno);
-      return NULL;
-    }
-
-    google::protobuf::io::IstreamInputStream input_stream(&proto_file);
-    bool ok = google::protobuf::TextFormat::Merge(&input_stream,
-                                                  &pid_store_pb);
-    proto_file.close();
+  ola::rdm::pid::PidStore override_pb;
+  ola::rdm::pid::PidStore manufacturer_names_pb;
+  if (!ReadDirectory(directory, &pid_store_pb, &override_pb,
+                     &manufacturer_names_pb)) {
+    return NULL;
+  }
+  return BuildStore(pid_store_pb, override_pb, manufacturer_names_pb, validate);
+}
 
-    if (!ok) {
-      OLA_WARN << "Failed to load " << *iter;
-      return NULL;
-    }
+const RootPidStore *PidStoreLoader::LoadFromCompiledFile(const string &file,
+                                                         bool validate) {
+  auto_ptr<ola::rdm::pid::CompiledPidStore> compiled(
+      new ola::rdm::pid::CompiledPidStore());
+  if (!ReadCompiledFile(file, compiled.get())) {
+    return NULL;
   }
+  return BuildCompiledStore(compiled.release(), validate);
+}
 
+bool PidStoreLoader::CompileDirectory(const string &directory,
+                                      const string &output_file) {
+  ola::rdm::pid::CompiledPidStore compiled;
   ola::rdm::pid::PidStore override_pb;
-  if (!override_file.empty()) {
-    if (!ReadFile(override_file, &override_pb)) {
-      return NULL;
-    }
+  ola::rdm::pid::PidStore manufacturer_names_pb;
+  if (!ReadDirectory(directory, compiled.mutable_pids(), &override_pb,
+                     &manufacturer_names_pb)) {
+    return false;
   }
 
-  ola::rdm::pid::PidStore manufacturer_names_pb;
+  // Don't write out anything that wouldn't load.
+  auto_ptr<const RootPidStore> store(BuildStore(
+      compiled.pids(), override_pb, manufacturer_names_pb, true));
+  if (!store.get()) {
+    return false;
+  }
+
+  uint64_t source_hash;
+  if (!SourceHash(directory, &source_hash)) {
+    return false;
+  }
+  compiled.set_source_hash(source_hash);
+  if (override_pb.pid_size() || override_pb.manufacturer_size()) {
+    compiled.mutable_overrides()->Swap(&override_pb);
+  }
+
+  string output;
+  if (!compiled.SerializePartialToString(&output)) {
+    OLA_WARN << "Failed to serialize the PID store";
+    return false;
+  }
+
+  std::ofstream out(output_file.c_str(),
+                    std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    OLA_WARN << "Failed to open " << output_file << ": " << strerror(errno);
+    return false;
+  }
+  out.write(COMPILED_MAGIC, sizeof(COMPILED_MAGIC) - 1);
+  out.write(output.data(), output.size());
+  out.close();
+  if (out.fail()) {
+    OLA_WARN << "Failed to write " << output_file;
+    return false;
+  }
+  return true;
+}
+
+bool PidStoreLoader::SourceHash(const string &directory, uint64_t *hash) {
+  vector<string> files;
+  string override_file;
+  string manufacturer_names_file;
+  ListFiles(directory, &files, &override_file, &manufacturer_names_file);
+  if (!override_file.empty()) {
+    files.push_back(override_file);
+  }
   if (!manufacturer_names_file.empty()) {
-    if (!ReadFile(manufacturer_names_file, &manufacturer_names_pb)) {
-      return NULL;
-    }
+    files.push_back(manufacturer_names_file);
   }
+  // The order of ListDirectory() isn't defined.
+  std::sort(files.begin(), files.end());
 
-  return BuildStore(pid_store_pb, override_pb, manufacturer_names_pb, validate);
+  *hash = FNV_OFFSET_BASIS;
+  vector<string>::const_iterator iter = files.begin();
+  for (; iter != files.end(); ++iter) {
+    const string file_name = ola::file::FilenameFromPath(*iter);
+    // Include the terminating NULL so the name & contents can't run together.
+    *hash = FNVHash(*hash, file_name.c_str(), file_name.size() + 1);
+
+    std::ifstream input(iter->c_str(), std::ios::in | std::ios::binary);
+    if (!input.is_open()) {
+      OLA_WARN << "Failed to open " << *iter << ": " << strerror(errno);
+      return false;
+    }
+    char buffer[4096];
+    while (input.read(buffer, sizeof(buffer)) || input.gcount()) {
+      *hash = FNVHash(*hash, buffer, static_cast<size_t>(input.gcount()));
+    }
+    if (input.bad()) {
+      OLA_WARN << "Failed to read " << *iter;
+      return false;
+    }
+  }
+  return true;
 }
 
 const RootPidStore *PidStoreLoader::LoadFromStream(std::istream *data,
@@ -159,6 +311,162 @@ bool PidStoreLoader::ReadFile(const std::string &file_path,
   return ok;
 }
 
+void PidStoreLoader::ListFiles(const string &directory,
+                               vector<string> *files,
+                               string *override_file,
+                               string *manufacturer_names_file) {
+  vector<string> all_files;
+  ola::file::ListDirectory(directory, &all_files);
+  vector<string>::const_iterator file_iter = all_files.begin();
+  for (; file_iter != all_files.end(); ++file_iter) {
+    if (ola::file::FilenameFromPath(*file_iter) == OVERRIDE_FILE_NAME) {
+      *override_file = *file_iter;
+    } else if (ola::file::FilenameFromPath(*file_iter) ==
+               MANUFACTURER_NAMES_FILE_NAME) {
+      *manufacturer_names_file = *file_iter;
+    } else if (StringEndsWith(*file_iter, ".proto")) {
+      files->push_back(*file_iter);
+    }
+  }
+}
+
+bool PidStoreLoader::ReadDirectory(
+    const string &directory,
+    ola::rdm::pid::PidStore *store_pb,
+    ola::rdm::pid::PidStore *override_pb,
+    ola::rdm::pid::PidStore *manufacturer_names_pb) {
+  vector<string> files;
+  string override_file;
+  string manufacturer_names_file;
+  ListFiles(directory, &files, &override_file, &manufacturer_names_file);
+
+  vector<string>::const_iterator iter = files.begin();
+  for (; iter != files.end(); ++iter) {
+    if (!ReadFile(*iter, store_pb)) {
+      return false;
+    }
+  }
+
+  if (!override_file.empty() && !ReadFile(override_file, override_pb)) {
+    return false;
+  }
+
+  if (!manufacturer_names_file.empty() &&
+      !ReadFile(manufacturer_names_file, manufacturer_names_pb)) {
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Read a file written by CompileDirectory(). A missing file isn't an error,
+ * since we fall back to the text files.
+ */
+bool PidStoreLoader::ReadCompiledFile(
+    const string &file_path,
+    ola::rdm::pid::CompiledPidStore *compiled) {
+  const size_t magic_size = sizeof(COMPILED_MAGIC) - 1;
+  bool ok = false;
+#ifdef _WIN32
+  std::ifstream input(file_path.c_str(), std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    return false;
+  }
+  std::ostringstream contents;
+  contents << input.rdbuf();
+  const string data = contents.str();
+  ok = (data.size() >= magic_size &&
+        data.compare(0, magic_size, COMPILED_MAGIC) == 0 &&
+        compiled->ParsePartialFromArray(data.data() + magic_size,
+                                        static_cast<int>(
+                                            data.size() - magic_size)));
+#else
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      OLA_WARN << "Failed to open " << file_path << ": " << strerror(errno);
+    }
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) ||
+      file_stat.st_size < static_cast<off_t>(magic_size)) {
+    OLA_WARN << file_path << " is too short";
+    close(fd);
+    return false;
+  }
+
+  // Map the file rather than copying it, the parser reads it exactly once.
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    OLA_WARN << "Failed to map " << file_path << ": " << strerror(errno);
+    return false;
+  }
+
+  const char *contents = static_cast<const char*>(data);
+  ok = (memcmp(contents, COMPILED_MAGIC, magic_size) == 0 &&
+        compiled->ParsePartialFromArray(contents + magic_size,
+                                        static_cast<int>(size - magic_size)));
+  munmap(data, size);
+#endif  // _WIN32
+
+  if (!ok) {
+    OLA_WARN << file_path << " isn't a compiled PID store";
+  }
+  return ok;
+}
+
+/*
+ * Build the RootPidStore from a CompiledPidStore. The ESTA PIDs are built now,
+ * the manufacturer PIDs are built on demand. Takes ownership of compiled.
+ */
+const RootPidStore *PidStoreLoader::BuildCompiledStore(
+    ola::rdm::pid::CompiledPidStore *compiled,
+    bool validate) {
+  auto_ptr<ola::rdm::pid::CompiledPidStore> compiled_ptr(compiled);
+
+  // Load the overrides first so they get first dibs on each PID.
+  PidMap esta_pids;
+  if (!GetPidList(&esta_pids, compiled->overrides(), validate, true) ||
+      !GetPidList(&esta_pids, compiled->pids(), validate, true)) {
+    STLDeleteValues(&esta_pids);
+    return NULL;
+  }
+
+  // Ownership of the Descriptors is transferred to the vector
+  vector<const PidDescriptor*> pids;
+  STLValues(esta_pids, &pids);
+  const PidStore *esta_store = new PidStore(pids);
+
+  const uint64_t version = compiled->pids().version();
+  OLA_DEBUG << "Load Complete";
+  return new RootPidStore(
+      esta_store,
+      new CompiledManufacturerStoreLoader(compiled_ptr.release(), validate),
+      version);
+}
+
+const PidStore *PidStoreLoader::BuildManufacturerStore(
+    const ola::rdm::pid::Manufacturer *override_pb,
+    const ola::rdm::pid::Manufacturer *manufacturer_pb,
+    bool validate) {
+  PidMap pid_map;
+  if ((override_pb &&
+       !GetPidList(&pid_map, *override_pb, validate, false)) ||
+      (manufacturer_pb &&
+       !GetPidList(&pid_map, *manufacturer_pb, validate, false))) {
+    STLDeleteValues(&pid_map);
+    return NULL;
+  }
+
+  vector<const PidDescriptor*> pids;
+  STLValues(pid_map, &pids);
+  return new PidStore(pids);
+}
+
 /*
  * Build the RootPidStore from a protocol buffer.
  */
@@ -23,6 +23,7 @@
 #ifndef COMMON_RDM_PIDSTORELOADER_H_
 #define COMMON_RDM_PIDSTORELOADER_H_
 
+#include <stdint.h>
 #include <ola/messaging/Descriptor.h>
 #include <ola/rdm/PidStore.h>
 #include <map>
@@ -59,11 +60,57 @@ class PidStoreLoader {
    *   contents.
    * @returns A pointer to a new RootPidStore or NULL if loading failed.
    *
+   * If the directory contains a compiled store that was built from the
+   * current files, that's used instead of parsing the text files.
+   *
    * This is an all-or-nothing load. Any error with cause us to abort the load.
    */
   const RootPidStore *LoadFromDirectory(const std::string &directory,
                                         bool validate = true);
 
+  /**
+   * @brief Load PID information from the text files in a directory.
+   * @param directory the directory to load files from.
+   * @param validate set to true if we should perform validation of the
+   *   contents.
+   * @returns A pointer to a new RootPidStore or NULL if loading failed.
+   */
+  const RootPidStore *LoadFromTextDirectory(const std::string &directory,
+                                            bool validate = true);
+
+  /**
+   * @brief Load PID information from a file written by CompileDirectory().
+   * @param file the path to the compiled file.
+   * @param validate set to true if we should perform validation of the
+   *   contents.
+   * @returns A pointer to a new RootPidStore or NULL if loading failed.
+   *
+   * The ESTA PIDs are loaded immediately, the manufacturer PIDs are loaded
+   * the first time they're used. This doesn't check if the compiled file is
+   * up to date.
+   */
+  const RootPidStore *LoadFromCompiledFile(const std::string &file,
+                                           bool validate = true);
+
+  /**
+   * @brief Compile the text files in a directory into a single binary file.
+   * @param directory the directory to load files from.
+   * @param output_file the file to write.
+   * @returns true if the files were valid and the output was written.
+   */
+  bool CompileDirectory(const std::string &directory,
+                        const std::string &output_file);
+
+  /**
+   * @brief Hash the names and contents of the PID files in a directory.
+   * @param directory the directory containing the files.
+   * @param[out] hash the hash of the files.
+   * @returns true if all the files could be read, false otherwise.
+   *
+   * This is used to tell if a compiled file is out of date.
+   */
+  bool SourceHash(const std::string &directory, uint64_t *hash);
+
   /**
    * @brief Load Pid information from a stream
    * @param data the input stream.
@@ -74,15 +121,47 @@ class PidStoreLoader {
   const RootPidStore *LoadFromStream(std::istream *data,
                                      bool validate = true);
 
+  /**
+   * @brief Build the PidStore for a single manufacturer.
+   * @param override_pb the overrides for this manufacturer, may be NULL.
+   * @param manufacturer_pb the PIDs for this manufacturer, may be NULL.
+   * @param validate set to true if we should perform validation of the
+   *   contents.
+   * @returns A pointer to a new PidStore or NULL if loading failed.
+   */
+  const PidStore *BuildManufacturerStore(
+      const ola::rdm::pid::Manufacturer *override_pb,
+      const ola::rdm::pid::Manufacturer *manufacturer_pb,
+      bool validate);
+
+  static const char COMPILED_FILE_NAME[];
+
  private:
   typedef std::map<uint16_t, const PidDescriptor*> PidMap;
   typedef std::map<uint16_t, PidMap*> ManufacturerMap;
 
   DescriptorConsistencyChecker m_checker;
 
+  void ListFiles(const std::string &directory,
+                 std::vector<std::string> *files,
+                 std::string *override_file,
+                 std::string *manufacturer_names_file);
+
+  bool ReadDirectory(const std::string &directory,
+                     ola::rdm::pid::PidStore *store_pb,
+                     ola::rdm::pid::PidStore *override_pb,
+                     ola::rdm::pid::PidStore *manufacturer_names_pb);
+
   bool ReadFile(const std::string &file_path,
                 ola::rdm::pid::PidStore *proto);
 
+  bool ReadCompiledFile(const std::string &file_path,
+                        ola::rdm::pid::CompiledPidStore *compiled);
+
+  const RootPidStore *BuildCompiledStore(
+      ola::rdm::pid::CompiledPidStore *compiled,
+      bool validate);
+
   const RootPidStore *BuildStore(
       const ola::rdm::pid::PidStore &store_pb,
       const ola::rdm::pid::PidStore &override_pb,
@@ -130,6 +209,7 @@ class PidStoreLoader {
 
   static const char OVERRIDE_FILE_NAME[];
   static const char MANUFACTURER_NAMES_FILE_NAME[];
+  static const char COMPILED_MAGIC[];
   static const uint16_t ESTA_MANUFACTURER_ID;
   static const uint16_t MANUFACTURER_PID_MIN;
   static const uint16_t MANUFACTURER_PID_MAX;
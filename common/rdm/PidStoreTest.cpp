@@ -56,6 +56,7 @@ class PidStoreTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testPidStoreLoad);
   CPPUNIT_TEST(testPidStoreFileLoad);
   CPPUNIT_TEST(testPidStoreDirectoryLoad);
+  CPPUNIT_TEST(testPidStoreCompiledLoad);
   CPPUNIT_TEST(testPidStoreLoadMissingFile);
   CPPUNIT_TEST(testPidStoreLoadDuplicateManufacturer);
   CPPUNIT_TEST(testPidStoreLoadDuplicateValue);
@@ -70,6 +71,7 @@ class PidStoreTest: public CppUnit::TestFixture {
   void testPidStoreLoad();
   void testPidStoreFileLoad();
   void testPidStoreDirectoryLoad();
+  void testPidStoreCompiledLoad();
   void testPidStoreLoadMissingFile();
   void testPidStoreLoadDuplicateManufacturer();
   void testPidStoreLoadDuplicateValue();
@@ -84,6 +86,8 @@ class PidStoreTest: public CppUnit::TestFixture {
     path.append(filename);
     return path;
   }
+
+  void CheckDirectoryStore(const RootPidStore *root_store);
 };
 
 
@@ -399,7 +403,42 @@ void PidStoreTest::testPidStoreDirectoryLoad() {
 
   auto_ptr<const RootPidStore> root_store(loader.LoadFromDirectory(
       GetTestDataFile("pids")));
-  OLA_ASSERT_NOT_NULL(root_store.get());
+  CheckDirectoryStore(root_store.get());
+}
+
+/*
+ * Check that compiling a directory gives us the same PIDs.
+ */
+void PidStoreTest::testPidStoreCompiledLoad() {
+  PidStoreLoader loader;
+  const string compiled_file = TEST_BUILD_DIR "/compiled_pids.bin";
+  OLA_ASSERT_TRUE(loader.CompileDirectory(GetTestDataFile("pids"),
+                                          compiled_file));
+
+  auto_ptr<const RootPidStore> root_store(
+      loader.LoadFromCompiledFile(compiled_file));
+  CheckDirectoryStore(root_store.get());
+
+  // The hash only changes if the files do.
+  uint64_t hash1, hash2;
+  OLA_ASSERT_TRUE(loader.SourceHash(GetTestDataFile("pids"), &hash1));
+  OLA_ASSERT_TRUE(loader.SourceHash(GetTestDataFile("pids"), &hash2));
+  OLA_ASSERT_EQ(hash1, hash2);
+  OLA_ASSERT_TRUE(loader.SourceHash(GetTestDataFile(""), &hash2));
+  OLA_ASSERT_NE(hash1, hash2);
+
+  // A text file isn't a compiled store.
+  OLA_ASSERT_NULL(loader.LoadFromCompiledFile(
+      GetTestDataFile("pids/pids1.proto")));
+  OLA_ASSERT_NULL(loader.LoadFromCompiledFile(
+      GetTestDataFile("missing.bin")));
+}
+
+/*
+ * Check the store loaded from testdata/pids.
+ */
+void PidStoreTest::CheckDirectoryStore(const RootPidStore *root_store) {
+  OLA_ASSERT_NOT_NULL(root_store);
   // check version
   OLA_ASSERT_EQ(static_cast<uint64_t>(1302986774), root_store->Version());
 
@@ -14,14 +14,19 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  *
  * QueueingRDMController.cpp
- * The Jese DMX TRI device.
+ * An RDM Controller that queues requests.
  * Copyright (C) 2010 Simon Newton
  */
 
 #include <string.h>
+#include <algorithm>
+#include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
+#include "ola/Callback.h"
+#include "ola/Clock.h"
 #include "ola/Constants.h"
 #include "ola/Logging.h"
 #include "ola/rdm/QueueingRDMController.h"
@@ -29,18 +34,41 @@
 #include "ola/rdm/RDMEnums.h"
 #include "ola/rdm/UID.h"
 #include "ola/rdm/UIDSet.h"
+#include "ola/stl/STLUtils.h"
 
 namespace ola {
 namespace rdm {
 
+using ola::Clock;
+using ola::TimeStamp;
 using ola::rdm::RDMCommand;
 using ola::rdm::RDMRequest;
 using ola::rdm::UID;
 using ola::rdm::UIDSet;
+using std::map;
+using std::set;
 using std::string;
 using std::vector;
 
 
+/*
+ * A request that has been sent to the underlying controller.
+ */
+class QueueingRDMController::InFlightRequest {
+ public:
+  explicit InFlightRequest(const outstanding_rdm_request &queued)
+      : request(queued.request),
+        on_complete(queued.on_complete) {
+  }
+
+  const RDMRequest *request;
+  RDMCallback *on_complete;
+  // Set while we're in an ACK_OVERFLOW sequence.
+  std::auto_ptr<RDMResponse> response;
+  vector<RDMFrame> frames;
+};
+
+
 /*
  * A new QueueingRDMController. This takes another controller as a argument,
  * and ensures that we only send one request at a time.
@@ -49,11 +77,30 @@ QueueingRDMController::QueueingRDMController(
     RDMControllerInterface *controller,
     unsigned int max_queue_size)
   : m_controller(controller),
+    m_active(true),
+    m_clock(new Clock()),
+    m_free_clock(true),
     m_max_queue_size(max_queue_size),
-    m_rdm_request_pending(false),
+    m_max_in_flight(1),
+    m_queue_timeout(),
+    m_queued_count(0),
+    m_interactive_run(0) {
+}
+
+
+QueueingRDMController::QueueingRDMController(
+    RDMControllerInterface *controller,
+    const Options &options,
+    Clock *clock)
+  : m_controller(controller),
     m_active(true),
-    m_callback(ola::NewCallback(this,
-                                &QueueingRDMController::HandleRDMResponse)) {
+    m_clock(clock ? clock : new Clock()),
+    m_free_clock(clock == NULL),
+    m_max_queue_size(options.max_queue_size),
+    m_max_in_flight(std::max(options.max_in_flight, 1u)),
+    m_queue_timeout(options.queue_timeout),
+    m_queued_count(0),
+    m_interactive_run(0) {
 }
 
 
@@ -62,13 +109,31 @@ QueueingRDMController::QueueingRDMController(
  */
 QueueingRDMController::~QueueingRDMController() {
   // delete all outstanding requests
-  while (!m_pending_requests.empty()) {
-    outstanding_rdm_request outstanding_request = m_pending_requests.front();
-    if (outstanding_request.on_complete) {
-      RunRDMCallback(outstanding_request.on_complete, RDM_FAILED_TO_SEND);
+  vector<InFlightRequest*>::iterator in_flight_iter = m_in_flight.begin();
+  for (; in_flight_iter != m_in_flight.end(); ++in_flight_iter) {
+    if ((*in_flight_iter)->on_complete) {
+      RunRDMCallback((*in_flight_iter)->on_complete, RDM_FAILED_TO_SEND);
+    }
+    delete (*in_flight_iter)->request;
+    delete *in_flight_iter;
+  }
+
+  for (unsigned int i = 0; i < PRIORITY_CLASS_COUNT; i++) {
+    map<unsigned int, RequestQueue>::iterator iter =
+        m_classes[i].client_queues.begin();
+    for (; iter != m_classes[i].client_queues.end(); ++iter) {
+      RequestQueue::iterator queue_iter = iter->second.begin();
+      for (; queue_iter != iter->second.end(); ++queue_iter) {
+        if (queue_iter->on_complete) {
+          RunRDMCallback(queue_iter->on_complete, RDM_FAILED_TO_SEND);
+        }
+        delete queue_iter->request;
+      }
     }
-    delete outstanding_request.request;
-    m_pending_requests.pop();
+  }
+
+  if (m_free_clock) {
+    delete m_clock;
   }
 }
 
@@ -86,7 +151,7 @@ void QueueingRDMController::Pause() {
  */
 void QueueingRDMController::Resume() {
   m_active = true;
-  MaybeSendRDMRequest();
+  TakeNextAction();
 }
 
 
@@ -95,7 +160,11 @@ void QueueingRDMController::Resume() {
  */
 void QueueingRDMController::SendRDMRequest(RDMRequest *request,
                                            RDMCallback *on_complete) {
-  if (m_pending_requests.size() >= m_max_queue_size) {
+  ExpireRequests();
+
+  bool bulk = request->GetSchedulingOptions().bulk;
+  if (m_queued_count + m_in_flight.size() >= m_max_queue_size &&
+      (bulk || !DropNewestBulkRequest())) {
     OLA_WARN << "RDM Queue is full, dropping request";
     if (on_complete) {
       RunRDMCallback(on_complete, RDM_FAILED_TO_SEND);
@@ -107,7 +176,11 @@ void QueueingRDMController::SendRDMRequest(RDMRequest *request,
   outstanding_rdm_request outstanding_request;
   outstanding_request.request = request;
   outstanding_request.on_complete = on_complete;
-  m_pending_requests.push(outstanding_request);
+  if (!m_queue_timeout.IsZero()) {
+    m_clock->CurrentTime(&outstanding_request.deadline);
+    outstanding_request.deadline += m_queue_timeout;
+  }
+  Enqueue(outstanding_request, bulk);
   TakeNextAction();
 }
 
@@ -116,10 +189,7 @@ void QueueingRDMController::SendRDMRequest(RDMRequest *request,
  * Do the next action.
  */
 void QueueingRDMController::TakeNextAction() {
-  if (CheckForBlockingCondition())
-    return;
-
-  MaybeSendRDMRequest();
+  while (!CheckForBlockingCondition() && MaybeSendRDMRequest()) {}
 }
 
 
@@ -130,106 +200,338 @@ void QueueingRDMController::TakeNextAction() {
  * @returns true if some other action is running, false otherwise.
  */
 bool QueueingRDMController::CheckForBlockingCondition() {
-  return !m_active || m_rdm_request_pending;
+  return !m_active || m_in_flight.size() >= m_max_in_flight;
 }
 
 
 /*
- * If we're not paused, send the next request.
+ * Send the next request, if there is one that can be sent now.
+ * @returns true if a request was sent.
  */
-void QueueingRDMController::MaybeSendRDMRequest() {
-  if (m_pending_requests.empty())
+bool QueueingRDMController::MaybeSendRDMRequest() {
+  ExpireRequests();
+
+  outstanding_rdm_request outstanding_request;
+  if (!NextRequest(&outstanding_request)) {
+    return false;
+  }
+
+  InFlightRequest *in_flight = new InFlightRequest(outstanding_request);
+  m_in_flight.push_back(in_flight);
+  Dispatch(in_flight);
+  return true;
+}
+
+
+/*
+ * Add a request to the queue for its client.
+ */
+void QueueingRDMController::Enqueue(const outstanding_rdm_request &request,
+                                    bool bulk) {
+  PriorityClass *priority_class = &m_classes[bulk ? BULK : INTERACTIVE];
+  unsigned int client_id = request.request->GetSchedulingOptions().client_id;
+  RequestQueue &queue = priority_class->client_queues[client_id];
+  if (queue.empty()) {
+    priority_class->client_order.push_back(client_id);
+  }
+  queue.push_back(request);
+  m_queued_count++;
+}
+
+
+/*
+ * Make room for an interactive request by failing the most recently queued
+ * request of the client with the most bulk requests.
+ * @returns false if there were no bulk requests queued.
+ */
+bool QueueingRDMController::DropNewestBulkRequest() {
+  PriorityClass *priority_class = &m_classes[BULK];
+  map<unsigned int, RequestQueue>::iterator longest =
+      priority_class->client_queues.end();
+  map<unsigned int, RequestQueue>::iterator iter =
+      priority_class->client_queues.begin();
+  for (; iter != priority_class->client_queues.end(); ++iter) {
+    if (longest == priority_class->client_queues.end() ||
+        iter->second.size() > longest->second.size()) {
+      longest = iter;
+    }
+  }
+
+  if (longest == priority_class->client_queues.end()) {
+    return false;
+  }
+
+  outstanding_rdm_request dropped = longest->second.back();
+  longest->second.pop_back();
+  m_queued_count--;
+  if (longest->second.empty()) {
+    priority_class->client_order.erase(
+        std::find(priority_class->client_order.begin(),
+                  priority_class->client_order.end(),
+                  longest->first));
+    priority_class->client_queues.erase(longest);
+  }
+
+  OLA_INFO << "RDM Queue is full, dropping bulk request to "
+           << dropped.request->DestinationUID();
+  if (dropped.on_complete) {
+    RunRDMCallback(dropped.on_complete, RDM_FAILED_TO_SEND);
+  }
+  delete dropped.request;
+  return true;
+}
+
+
+/*
+ * Fail any queued requests that have passed their deadline.
+ */
+void QueueingRDMController::ExpireRequests() {
+  if (m_queue_timeout.IsZero() || m_queued_count == 0) {
     return;
+  }
+
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+  vector<outstanding_rdm_request> expired;
+
+  for (unsigned int i = 0; i < PRIORITY_CLASS_COUNT; i++) {
+    PriorityClass *priority_class = &m_classes[i];
+    map<unsigned int, RequestQueue>::iterator iter =
+        priority_class->client_queues.begin();
+    while (iter != priority_class->client_queues.end()) {
+      // The timeout is the same for all requests, so each queue is in
+      // deadline order.
+      RequestQueue &queue = iter->second;
+      while (!queue.empty() && queue.front().deadline <= now) {
+        expired.push_back(queue.front());
+        queue.pop_front();
+        m_queued_count--;
+      }
+
+      if (queue.empty()) {
+        priority_class->client_order.erase(
+            std::find(priority_class->client_order.begin(),
+                      priority_class->client_order.end(),
+                      iter->first));
+        priority_class->client_queues.erase(iter++);
+      } else {
+        ++iter;
+      }
+    }
+  }
+
+  // Run the callbacks last, since they may queue more requests.
+  vector<outstanding_rdm_request>::iterator iter = expired.begin();
+  for (; iter != expired.end(); ++iter) {
+    OLA_INFO << "RDM request to " << iter->request->DestinationUID()
+             << " wasn't sent before the deadline";
+    if (iter->on_complete) {
+      RunRDMCallback(iter->on_complete, RDM_TIMEOUT);
+    }
+    delete iter->request;
+  }
+}
+
+
+/*
+ * Pick the next request to send. Interactive requests go first, but after
+ * INTERACTIVE_BURST of them a waiting bulk request is sent.
+ * @returns false if there are no requests that can be sent now.
+ */
+bool QueueingRDMController::NextRequest(outstanding_rdm_request *request) {
+  bool bulk_waiting = !m_classes[BULK].client_order.empty();
+
+  if (bulk_waiting && m_interactive_run >= INTERACTIVE_BURST &&
+      NextRequestFromClass(&m_classes[BULK], request)) {
+    m_interactive_run = 0;
+    return true;
+  }
+
+  if (NextRequestFromClass(&m_classes[INTERACTIVE], request)) {
+    if (bulk_waiting) {
+      m_interactive_run++;
+    }
+    return true;
+  }
+
+  if (NextRequestFromClass(&m_classes[BULK], request)) {
+    m_interactive_run = 0;
+    return true;
+  }
+  return false;
+}
+
+
+/*
+ * Take the next request from a priority class, giving each client a turn.
+ */
+bool QueueingRDMController::NextRequestFromClass(
+    PriorityClass *priority_class,
+    outstanding_rdm_request *request) {
+  std::deque<unsigned int> &order = priority_class->client_order;
+  for (unsigned int i = 0; i < order.size(); i++) {
+    unsigned int client_id = order[i];
+    RequestQueue &queue = priority_class->client_queues[client_id];
+    RequestQueue::iterator iter = FirstDispatchable(&queue);
+    if (iter == queue.end()) {
+      continue;
+    }
+
+    *request = *iter;
+    queue.erase(iter);
+    m_queued_count--;
+    order.erase(order.begin() + i);
+    if (queue.empty()) {
+      priority_class->client_queues.erase(client_id);
+    } else {
+      order.push_back(client_id);
+    }
+    return true;
+  }
+  return false;
+}
+
 
-  m_rdm_request_pending = true;
-  DispatchNextRequest();
+/*
+ * Find the first request in a client's queue that can be sent now. A client's
+ * requests to the same UID are always sent in order, but a request to one UID
+ * may overtake a blocked request to another. Broadcasts are never reordered.
+ */
+QueueingRDMController::RequestQueue::iterator
+    QueueingRDMController::FirstDispatchable(RequestQueue *queue) const {
+  set<UID> skipped;
+  RequestQueue::iterator iter = queue->begin();
+  for (; iter != queue->end(); ++iter) {
+    const UID &destination = iter->request->DestinationUID();
+    if (destination.IsBroadcast() && !skipped.empty()) {
+      break;
+    }
+    if (!STLContains(skipped, destination) && CanDispatch(iter->request)) {
+      return iter;
+    }
+    if (destination.IsBroadcast()) {
+      break;
+    }
+    skipped.insert(destination);
+  }
+  return queue->end();
 }
 
 
 /*
- * Send the next RDM request.
+ * Check if a request can be sent alongside the ones already in flight. Only
+ * one request to each UID may be in flight, and broadcasts are sent on their
+ * own.
  */
-void QueueingRDMController::DispatchNextRequest() {
-  outstanding_rdm_request outstanding_request = m_pending_requests.front();
+bool QueueingRDMController::CanDispatch(const RDMRequest *request) const {
+  if (m_in_flight.empty()) {
+    return true;
+  }
+
+  if (m_in_flight.size() >= m_max_in_flight ||
+      request->DestinationUID().IsBroadcast()) {
+    return false;
+  }
+
+  vector<InFlightRequest*>::const_iterator iter = m_in_flight.begin();
+  for (; iter != m_in_flight.end(); ++iter) {
+    const UID &destination = (*iter)->request->DestinationUID();
+    if (destination.IsBroadcast() ||
+        destination == request->DestinationUID()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/*
+ * Send a request to the underlying controller.
+ */
+void QueueingRDMController::Dispatch(InFlightRequest *in_flight) {
   // We have to make a copy here because we pass ownership of the request to
   // the underlying controller.
   // We need to have the original request because we use it if we receive an
-  // ACK_OVERFLOW.
-  m_controller->SendRDMRequest(outstanding_request.request->Duplicate(),
-                               m_callback.get());
+  // ACK_OVERFLOW. The copy shares the parameter data with the original.
+  m_controller->SendRDMRequest(
+      in_flight->request->Duplicate(),
+      NewSingleCallback(this, &QueueingRDMController::HandleRDMResponse,
+                        in_flight));
 }
 
 
 /*
  * Handle the response to a RemoteGet command
  */
-void QueueingRDMController::HandleRDMResponse(RDMReply *reply) {
-  m_rdm_request_pending = false;
-
-  if (m_pending_requests.empty()) {
-    OLA_FATAL << "Received a response but the queue was empty!";
-    return;
-  }
-
+void QueueingRDMController::HandleRDMResponse(InFlightRequest *in_flight,
+                                              RDMReply *reply) {
   bool was_ack_overflow = reply->StatusCode() == RDM_COMPLETED_OK &&
                           reply->Response() &&
                           reply->Response()->ResponseType() == ACK_OVERFLOW;
+  vector<RDMFrame> &frames = in_flight->frames;
+
   // Check for ACK_OVERFLOW
-  if (m_response.get()) {
+  if (in_flight->response.get()) {
     if (reply->StatusCode() != RDM_COMPLETED_OK || reply->Response() == NULL) {
       // We failed part way through an ACK_OVERFLOW
-      m_frames.insert(m_frames.end(), reply->Frames().begin(),
-                      reply->Frames().end());
-      RDMReply new_reply(reply->StatusCode(), NULL, m_frames);
-      RunCallback(&new_reply);
-      m_response.reset();
-      m_frames.clear();
-      TakeNextAction();
+      frames.insert(frames.end(), reply->Frames().begin(),
+                    reply->Frames().end());
+      RDMReply new_reply(reply->StatusCode(), NULL, frames);
+      CompleteRequest(in_flight, &new_reply);
     } else {
       // Combine the data.
-      m_response.reset(RDMResponse::CombineResponses(
-          m_response.get(), reply->Response()));
-      m_frames.insert(m_frames.end(), reply->Frames().begin(),
-                      reply->Frames().end());
+      in_flight->response.reset(RDMResponse::CombineResponses(
+          in_flight->response.get(), reply->Response()));
+      frames.insert(frames.end(), reply->Frames().begin(),
+                    reply->Frames().end());
 
-      if (!m_response.get()) {
+      if (!in_flight->response.get()) {
         // The response was invalid
-        RDMReply new_reply(RDM_INVALID_RESPONSE, NULL, m_frames);
-        RunCallback(&new_reply);
-        m_frames.clear();
-        TakeNextAction();
+        RDMReply new_reply(RDM_INVALID_RESPONSE, NULL, frames);
+        CompleteRequest(in_flight, &new_reply);
       } else if (reply->Response()->ResponseType() != ACK_OVERFLOW) {
-        RDMReply new_reply(RDM_COMPLETED_OK, m_response.release(), m_frames);
-        RunCallback(&new_reply);
-        m_response.reset();
-        m_frames.clear();
-        TakeNextAction();
+        RDMReply new_reply(RDM_COMPLETED_OK, in_flight->response.release(),
+                           frames);
+        CompleteRequest(in_flight, &new_reply);
       } else {
-        DispatchNextRequest();
+        Dispatch(in_flight);
       }
-      return;
     }
   } else if (was_ack_overflow) {
     // We're in an ACK_OVERFLOW sequence.
-    m_frames.clear();
-    m_response.reset(reply->Response()->Duplicate());
-    m_frames.insert(m_frames.end(), reply->Frames().begin(),
-                    reply->Frames().end());
-    DispatchNextRequest();
+    frames.clear();
+    in_flight->response.reset(reply->Response()->Duplicate());
+    frames.insert(frames.end(), reply->Frames().begin(),
+                  reply->Frames().end());
+    Dispatch(in_flight);
   } else {
     // Just pass the RDMReply on.
-    RunCallback(reply);
-    TakeNextAction();
+    CompleteRequest(in_flight, reply);
   }
 }
 
-void QueueingRDMController::RunCallback(RDMReply *reply) {
-  outstanding_rdm_request outstanding_request = m_pending_requests.front();
-  m_pending_requests.pop();
-  if (outstanding_request.on_complete) {
-    outstanding_request.on_complete->Run(reply);
+
+/*
+ * Run the callback for a request that has finished & move onto the next one.
+ */
+void QueueingRDMController::CompleteRequest(InFlightRequest *in_flight,
+                                            RDMReply *reply) {
+  vector<InFlightRequest*>::iterator iter = std::find(
+      m_in_flight.begin(), m_in_flight.end(), in_flight);
+  if (iter == m_in_flight.end()) {
+    OLA_FATAL << "Received a response but the request wasn't in flight!";
+    return;
   }
-  delete outstanding_request.request;
+  m_in_flight.erase(iter);
+
+  const RDMRequest *request = in_flight->request;
+  RDMCallback *on_complete = in_flight->on_complete;
+  delete in_flight;
+  if (on_complete) {
+    on_complete->Run(reply);
+  }
+  delete request;
+  TakeNextAction();
 }
 
 
@@ -244,6 +546,15 @@ DiscoverableQueueingRDMController::DiscoverableQueueingRDMController(
 }
 
 
+DiscoverableQueueingRDMController::DiscoverableQueueingRDMController(
+        DiscoverableRDMControllerInterface *controller,
+        const Options &options,
+        Clock *clock)
+    : QueueingRDMController(controller, options, clock),
+      m_discoverable_controller(controller) {
+}
+
+
 /**
  * Run the full RDM discovery routine. This will either run immediately or
  * after the current request completes.
@@ -268,19 +579,25 @@ void DiscoverableQueueingRDMController::RunIncrementalDiscovery(
  * Override this so we can prioritize the discovery requests.
  */
 void DiscoverableQueueingRDMController::TakeNextAction() {
-  if (CheckForBlockingCondition())
-    return;
+  while (!CheckForBlockingCondition()) {
+    // prioritize discovery above RDM requests, discovery starts once the
+    // requests in flight have completed.
+    if (!m_pending_discovery_callbacks.empty()) {
+      if (InFlight() == 0) {
+        StartRDMDiscovery();
+      }
+      return;
+    }
 
-  // prioritize discovery above RDM requests
-  if (!m_pending_discovery_callbacks.empty())
-    StartRDMDiscovery();
-  else
-    MaybeSendRDMRequest();
+    if (!MaybeSendRDMRequest()) {
+      return;
+    }
+  }
 }
 
 
 /**
- * Block if either a RDM request is pending, or another discovery process is
+ * Block if we can't send more RDM requests, or another discovery process is
  * running.
  */
 bool DiscoverableQueueingRDMController::CheckForBlockingCondition() {
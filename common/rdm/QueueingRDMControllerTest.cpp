@@ -19,11 +19,13 @@
  */
 
 #include <cppunit/extensions/HelperMacros.h>
+#include <deque>
 #include <memory>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "ola/Clock.h"
 #include "ola/Logging.h"
 #include "ola/base/Array.h"
 #include "ola/Callback.h"
@@ -33,8 +35,11 @@
 #include "ola/rdm/QueueingRDMController.h"
 #include "ola/testing/TestUtils.h"
 
+using ola::MockClock;
 using ola::NewSingleCallback;
+using ola::TimeInterval;
 using ola::rdm::ACK_OVERFLOW;
+using ola::rdm::QueueingRDMController;
 using ola::rdm::RDMCallback;
 using ola::rdm::RDMDiscoveryCallback;
 using ola::rdm::RDMFrame;
@@ -61,6 +66,16 @@ RDMRequest *NewGetRequest(const UID &source, const UID &destination) {
                                      0);  // data length
 }
 
+RDMRequest *NewScheduledRequest(const UID &source, const UID &destination,
+                                unsigned int client_id, bool bulk) {
+  RDMRequest *request = NewGetRequest(source, destination);
+  RDMRequest::SchedulingOptions options;
+  options.client_id = client_id;
+  options.bulk = bulk;
+  request->SetSchedulingOptions(options);
+  return request;
+}
+
 RDMResponse *NewGetResponse(const UID &source, const UID &destination) {
   return new RDMGetResponse(source,
                             destination,
@@ -84,13 +99,18 @@ class QueueingRDMControllerTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testMultipleDiscovery);
   CPPUNIT_TEST(testReentrantDiscovery);
   CPPUNIT_TEST(testRequestAndDiscovery);
+  CPPUNIT_TEST(testPipelining);
+  CPPUNIT_TEST(testFairQueuing);
+  CPPUNIT_TEST(testBulkRequests);
+  CPPUNIT_TEST(testQueueTimeout);
   CPPUNIT_TEST_SUITE_END();
 
  public:
   QueueingRDMControllerTest()
       : m_source(1, 2),
         m_destination(3, 4),
-        m_discovery_complete_count(0) {
+        m_discovery_complete_count(0),
+        m_reply_count(0) {
   }
 
   void testSendAndReceive();
@@ -102,11 +122,26 @@ class QueueingRDMControllerTest: public CppUnit::TestFixture {
   void testMultipleDiscovery();
   void testReentrantDiscovery();
   void testRequestAndDiscovery();
+  void testPipelining();
+  void testFairQueuing();
+  void testBulkRequests();
+  void testQueueTimeout();
 
   void VerifyResponse(RDMReply *expected_reply, RDMReply *reply) {
     OLA_ASSERT_EQ(*expected_reply, *reply);
   }
 
+  void CountReply(ola::rdm::RDMStatusCode expected_code, RDMReply *reply) {
+    OLA_ASSERT_EQ(expected_code, reply->StatusCode());
+    m_reply_count++;
+  }
+
+  RDMCallback *NewReplyCounter(
+      ola::rdm::RDMStatusCode expected_code = ola::rdm::RDM_TIMEOUT) {
+    return NewSingleCallback(this, &QueueingRDMControllerTest::CountReply,
+                             expected_code);
+  }
+
   void VerifyDiscoveryComplete(UIDSet *expected_uids, const UIDSet &uids) {
     OLA_ASSERT_EQ(*expected_uids, uids);
     m_discovery_complete_count++;
@@ -121,6 +156,7 @@ class QueueingRDMControllerTest: public CppUnit::TestFixture {
   UID m_source;
   UID m_destination;
   int m_discovery_complete_count;
+  unsigned int m_reply_count;
 
   static const uint8_t MOCK_FRAME_DATA[];
   static const uint8_t MOCK_FRAME_DATA2[];
@@ -138,10 +174,13 @@ CPPUNIT_TEST_SUITE_REGISTRATION(QueueingRDMControllerTest);
 class MockRDMController: public ola::rdm::DiscoverableRDMControllerInterface {
  public:
     MockRDMController()
-        : m_rdm_callback(NULL),
+        : m_max_outstanding(1),
           m_discovery_callback(NULL) {
     }
 
+    // The number of captured requests that can be outstanding at once.
+    void SetMaxOutstanding(unsigned int max) { m_max_outstanding = max; }
+
     void SendRDMRequest(RDMRequest *request, RDMCallback *on_complete);
 
     void ExpectCallAndCapture(RDMRequest *request);
@@ -176,7 +215,8 @@ class MockRDMController: public ola::rdm::DiscoverableRDMControllerInterface {
 
     std::queue<expected_call> m_expected_calls;
     std::queue<expected_discovery_call> m_expected_discover_calls;
-    RDMCallback *m_rdm_callback;
+    unsigned int m_max_outstanding;
+    std::deque<RDMCallback*> m_rdm_callbacks;
     RDMDiscoveryCallback *m_discovery_callback;
 };
 
@@ -193,8 +233,9 @@ void MockRDMController::SendRDMRequest(RDMRequest *request,
     on_complete->Run(call.reply);
     delete call.reply;
   } else {
-    OLA_ASSERT_FALSE(m_rdm_callback);
-    m_rdm_callback = on_complete;
+    OLA_ASSERT_LT(m_rdm_callbacks.size(),
+                  static_cast<size_t>(m_max_outstanding));
+    m_rdm_callbacks.push_back(on_complete);
   }
 }
 
@@ -260,12 +301,12 @@ void MockRDMController::AddExpectedDiscoveryCall(bool full,
 
 
 /**
- * Run the current RDM callback
+ * Run the oldest outstanding RDM callback
  */
 void MockRDMController::RunRDMCallback(RDMReply *reply) {
-  OLA_ASSERT_TRUE(m_rdm_callback);
-  RDMCallback *callback = m_rdm_callback;
-  m_rdm_callback = NULL;
+  OLA_ASSERT_FALSE(m_rdm_callbacks.empty());
+  RDMCallback *callback = m_rdm_callbacks.front();
+  m_rdm_callbacks.pop_front();
   callback->Run(reply);
 }
 
@@ -851,3 +892,203 @@ void QueueingRDMControllerTest::testRequestAndDiscovery() {
   OLA_ASSERT_TRUE(m_discovery_complete_count);
   mock_controller.Verify();
 }
+
+
+/*
+ * Check that requests to different UIDs are pipelined.
+ */
+void QueueingRDMControllerTest::testPipelining() {
+  MockRDMController mock_controller;
+  mock_controller.SetMaxOutstanding(2);
+  QueueingRDMController::Options options(10);
+  options.max_in_flight = 2;
+  QueueingRDMController controller(&mock_controller, options);
+
+  UID destination2(3, 5);
+  RDMRequest *request1 = NewGetRequest(m_source, m_destination);
+  RDMRequest *request2 = NewGetRequest(m_source, m_destination);
+  RDMRequest *request3 = NewGetRequest(m_source, destination2);
+
+  // The second request to m_destination has to wait for the first.
+  mock_controller.ExpectCallAndCapture(request1);
+  mock_controller.ExpectCallAndCapture(request3);
+  controller.SendRDMRequest(request1, NewReplyCounter());
+  controller.SendRDMRequest(request2, NewReplyCounter());
+  controller.SendRDMRequest(request3, NewReplyCounter());
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(2u, controller.InFlight());
+  OLA_ASSERT_EQ(1u, controller.QueueDepth());
+
+  RDMReply timeout_reply(ola::rdm::RDM_TIMEOUT);
+  mock_controller.ExpectCallAndCapture(request2);
+  mock_controller.RunRDMCallback(&timeout_reply);
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(1u, m_reply_count);
+
+  mock_controller.RunRDMCallback(&timeout_reply);
+  mock_controller.RunRDMCallback(&timeout_reply);
+  OLA_ASSERT_EQ(3u, m_reply_count);
+  OLA_ASSERT_EQ(0u, controller.InFlight());
+
+  // Broadcasts are sent on their own.
+  RDMRequest *broadcast_request = NewGetRequest(
+      m_source, UID::AllDevices());
+  request1 = NewGetRequest(m_source, m_destination);
+  mock_controller.ExpectCallAndCapture(broadcast_request);
+  controller.SendRDMRequest(broadcast_request,
+                            NewReplyCounter(ola::rdm::RDM_WAS_BROADCAST));
+  controller.SendRDMRequest(request1, NewReplyCounter());
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(1u, controller.InFlight());
+
+  RDMReply broadcast_reply(ola::rdm::RDM_WAS_BROADCAST);
+  mock_controller.ExpectCallAndCapture(request1);
+  mock_controller.RunRDMCallback(&broadcast_reply);
+  mock_controller.RunRDMCallback(&timeout_reply);
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(5u, m_reply_count);
+}
+
+
+/*
+ * Check that clients take turns.
+ */
+void QueueingRDMControllerTest::testFairQueuing() {
+  MockRDMController mock_controller;
+  QueueingRDMController controller(&mock_controller, 10);
+
+  RDMRequest *client1_requests[] = {
+    NewScheduledRequest(m_source, UID(3, 1), 1, false),
+    NewScheduledRequest(m_source, UID(3, 2), 1, false),
+    NewScheduledRequest(m_source, UID(3, 3), 1, false),
+  };
+  RDMRequest *client2_request = NewScheduledRequest(
+      m_source, UID(4, 1), 2, false);
+
+  controller.Pause();
+  for (unsigned int i = 0; i < arraysize(client1_requests); i++) {
+    controller.SendRDMRequest(client1_requests[i], NewReplyCounter());
+  }
+  controller.SendRDMRequest(client2_request, NewReplyCounter());
+  OLA_ASSERT_EQ(4u, controller.QueueDepth());
+
+  mock_controller.ExpectCallAndReplyWith(
+      client1_requests[0], new RDMReply(ola::rdm::RDM_TIMEOUT));
+  mock_controller.ExpectCallAndReplyWith(
+      client2_request, new RDMReply(ola::rdm::RDM_TIMEOUT));
+  mock_controller.ExpectCallAndReplyWith(
+      client1_requests[1], new RDMReply(ola::rdm::RDM_TIMEOUT));
+  mock_controller.ExpectCallAndReplyWith(
+      client1_requests[2], new RDMReply(ola::rdm::RDM_TIMEOUT));
+  controller.Resume();
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(4u, m_reply_count);
+}
+
+
+/*
+ * Check that bulk requests yield to interactive ones, without starving.
+ */
+void QueueingRDMControllerTest::testBulkRequests() {
+  MockRDMController mock_controller;
+  QueueingRDMController controller(&mock_controller, 20);
+
+  const unsigned int REQUEST_COUNT = 6;
+  RDMRequest *bulk_requests[REQUEST_COUNT];
+  RDMRequest *interactive_requests[REQUEST_COUNT];
+
+  controller.Pause();
+  for (unsigned int i = 0; i < REQUEST_COUNT; i++) {
+    bulk_requests[i] = NewScheduledRequest(
+        m_source, UID(3, i), 1, true);
+    controller.SendRDMRequest(bulk_requests[i], NewReplyCounter());
+  }
+  for (unsigned int i = 0; i < REQUEST_COUNT; i++) {
+    interactive_requests[i] = NewScheduledRequest(
+        m_source, UID(4, i), 2, false);
+    controller.SendRDMRequest(interactive_requests[i], NewReplyCounter());
+  }
+
+  // Four interactive requests, then one bulk one.
+  const char expected_order[] = "iiiibiibbbbb";
+  unsigned int bulk_index = 0, interactive_index = 0;
+  for (unsigned int i = 0; i < arraysize(expected_order) - 1; i++) {
+    RDMRequest *request = expected_order[i] == 'b' ?
+        bulk_requests[bulk_index++] :
+        interactive_requests[interactive_index++];
+    mock_controller.ExpectCallAndReplyWith(
+        request, new RDMReply(ola::rdm::RDM_TIMEOUT));
+  }
+  controller.Resume();
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(2 * REQUEST_COUNT, m_reply_count);
+
+  // When the queue is full, an interactive request replaces the newest bulk
+  // request.
+  QueueingRDMController small_controller(&mock_controller, 2);
+  small_controller.Pause();
+  RDMRequest *bulk_request = NewScheduledRequest(
+      m_source, UID(3, 1), 1, true);
+  small_controller.SendRDMRequest(bulk_request, NewReplyCounter());
+  small_controller.SendRDMRequest(
+      NewScheduledRequest(m_source, UID(3, 2), 1, true),
+      NewReplyCounter(ola::rdm::RDM_FAILED_TO_SEND));
+  OLA_ASSERT_EQ(2u, small_controller.QueueDepth());
+
+  RDMRequest *interactive_request = NewScheduledRequest(
+      m_source, UID(4, 1), 2, false);
+  small_controller.SendRDMRequest(interactive_request, NewReplyCounter());
+  OLA_ASSERT_EQ(2 * REQUEST_COUNT + 1, m_reply_count);
+  OLA_ASSERT_EQ(2u, small_controller.QueueDepth());
+
+  // But another bulk request is rejected.
+  small_controller.SendRDMRequest(
+      NewScheduledRequest(m_source, UID(3, 3), 1, true),
+      NewReplyCounter(ola::rdm::RDM_FAILED_TO_SEND));
+  OLA_ASSERT_EQ(2 * REQUEST_COUNT + 2, m_reply_count);
+
+  mock_controller.ExpectCallAndReplyWith(
+      interactive_request, new RDMReply(ola::rdm::RDM_TIMEOUT));
+  mock_controller.ExpectCallAndReplyWith(
+      bulk_request, new RDMReply(ola::rdm::RDM_TIMEOUT));
+  small_controller.Resume();
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(2 * REQUEST_COUNT + 4, m_reply_count);
+}
+
+
+/*
+ * Check that requests which wait too long in the queue fail.
+ */
+void QueueingRDMControllerTest::testQueueTimeout() {
+  MockRDMController mock_controller;
+  MockClock clock;
+  QueueingRDMController::Options options(10);
+  options.queue_timeout = TimeInterval(2, 0);
+  QueueingRDMController controller(&mock_controller, options, &clock);
+
+  RDMRequest *request1 = NewGetRequest(m_source, m_destination);
+  mock_controller.ExpectCallAndCapture(request1);
+  controller.SendRDMRequest(request1, NewReplyCounter());
+
+  // This one is queued behind request1
+  controller.SendRDMRequest(NewGetRequest(m_source, m_destination),
+                            NewReplyCounter());
+  clock.AdvanceTime(1, 0);
+  RDMRequest *request3 = NewGetRequest(m_source, m_destination);
+  controller.SendRDMRequest(request3, NewReplyCounter());
+  OLA_ASSERT_EQ(2u, controller.QueueDepth());
+  mock_controller.Verify();
+
+  // The second request expires, the third is sent.
+  clock.AdvanceTime(1, 500000);
+  RDMReply timeout_reply(ola::rdm::RDM_TIMEOUT);
+  mock_controller.ExpectCallAndCapture(request3);
+  mock_controller.RunRDMCallback(&timeout_reply);
+  mock_controller.Verify();
+  OLA_ASSERT_EQ(2u, m_reply_count);
+  OLA_ASSERT_EQ(0u, controller.QueueDepth());
+
+  mock_controller.RunRDMCallback(&timeout_reply);
+  OLA_ASSERT_EQ(3u, m_reply_count);
+}
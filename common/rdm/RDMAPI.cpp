@@ -29,6 +29,7 @@
 #include "ola/StringUtils.h"
 #include "ola/base/Macro.h"
 #include "ola/network/NetworkUtils.h"
+#include "ola/rdm/ParamDataCodec.h"
 #include "ola/rdm/RDMAPI.h"
 #include "ola/rdm/RDMAPIImplInterface.h"
 #include "ola/rdm/RDMEnums.h"
@@ -46,6 +47,12 @@ using ola::SingleUseCallback4;
 using ola::network::HostToNetwork;
 using ola::network::NetworkToHost;
 
+namespace {
+
+const uint8_t *ParamData(const string &data) {
+  return reinterpret_cast<const uint8_t*>(data.data());
+}
+}  // namespace
 
 /*
  * Return the number of queues messages for a UID. Note that this is cached on
@@ -3247,24 +3254,11 @@ void RDMAPI::_HandleGetDeviceDescriptor(
   ResponseStatus response_status = status;
   DeviceDescriptor device_info;
 
-  if (response_status.WasAcked()) {
-    unsigned int data_size = data.size();
-    if (data_size == sizeof(device_info)) {
-      memcpy(&device_info, data.data(), sizeof(device_info));
-      device_info.device_model = NetworkToHost(device_info.device_model);
-      device_info.product_category =
-        NetworkToHost(device_info.product_category);
-      device_info.software_version =
-        NetworkToHost(device_info.software_version);
-      device_info.dmx_footprint =
-        NetworkToHost(device_info.dmx_footprint);
-      device_info.dmx_start_address =
-        NetworkToHost(device_info.dmx_start_address);
-      device_info.sub_device_count =
-        NetworkToHost(device_info.sub_device_count);
-    } else {
-      SetIncorrectPDL(&response_status, data.size(), sizeof(device_info));
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_DEVICE_INFO>(ParamData(data), data.size(),
+                                        &device_info)) {
+    SetIncorrectPDL(&response_status, data.size(),
+                    PidCodec<PID_DEVICE_INFO>::MAX_SIZE);
   }
   callback->Run(response_status, device_info);
 }
@@ -3390,18 +3384,15 @@ void RDMAPI::_HandleGetDMXPersonality(
     const ResponseStatus &status,
     const string &data) {
   ResponseStatus response_status = status;
-  static const unsigned int DATA_SIZE = 2;
-  uint8_t current_personality = 0;
-  uint8_t personality_count = 0;
-  if (response_status.WasAcked()) {
-    if (data.size() != DATA_SIZE) {
-      SetIncorrectPDL(&response_status, data.size(), DATA_SIZE);
-    } else {
-      current_personality = data[0];
-      personality_count = data[1];
-    }
+  PersonalityInfo personality_info = {0, 0};
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_DMX_PERSONALITY>(ParamData(data), data.size(),
+                                            &personality_info)) {
+    SetIncorrectPDL(&response_status, data.size(),
+                    PidCodec<PID_DMX_PERSONALITY>::MAX_SIZE);
   }
-  callback->Run(response_status, current_personality, personality_count);
+  callback->Run(response_status, personality_info.current_personality,
+                personality_info.personality_count);
 }
 
 
@@ -3416,41 +3407,22 @@ void RDMAPI::_HandleGetDMXPersonalityDescription(
                        const string&> *callback,
     const ResponseStatus &status,
     const string &data) {
+  typedef PidCodec<PID_DMX_PERSONALITY_DESCRIPTION> Codec;
   ResponseStatus response_status = status;
+  PersonalityDescription description;
+  description.personality = 0;
+  description.slots_required = 0;
 
-  uint8_t personality = 0;
-  uint16_t dmx_slots = 0;
-  string description;
-
-  if (response_status.WasAcked()) {
-    PACK(
-    struct personality_description {
-      uint8_t personality;
-      uint16_t dmx_slots;
-      // +1 for a null since it's not clear in the spec if this is null
-      // terminated
-      char description[MAX_RDM_STRING_LENGTH + 1];
-    });
-    STATIC_ASSERT(sizeof(personality_description) == 36);
-    struct personality_description raw_description;
-
-    unsigned int max = sizeof(personality_description) - 1;
-    unsigned int min = max - MAX_RDM_STRING_LENGTH;
-    unsigned int data_size = data.size();
-    if (data_size >= min && data_size <= max) {
-      memcpy(&raw_description, data.data(),
-             std::min(static_cast<unsigned int>(data.size()), max));
-      personality = raw_description.personality;
-      dmx_slots = NetworkToHost(raw_description.dmx_slots);
-      description = string(raw_description.description, data_size - min);
-      ShortenString(&description);
-    } else {
-      std::ostringstream str;
-      str << data_size << " needs to be between " << min << " and " << max;
-      response_status.error = str.str();
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_DMX_PERSONALITY_DESCRIPTION>(
+          ParamData(data), data.size(), &description)) {
+    std::ostringstream str;
+    str << data.size() << " needs to be between " << Codec::MIN_SIZE
+        << " and " << Codec::MAX_SIZE;
+    response_status.error = str.str();
   }
-  callback->Run(response_status, personality, dmx_slots, description);
+  callback->Run(response_status, description.personality,
+                description.slots_required, description.description);
 }
 
 
@@ -3464,15 +3436,12 @@ void RDMAPI::_HandleGetDMXAddress(
     const ResponseStatus &status,
     const string &data) {
   ResponseStatus response_status = status;
-  static const unsigned int DATA_SIZE = 2;
   uint16_t start_address = 0;
-  if (response_status.WasAcked()) {
-    if (data.size() != DATA_SIZE) {
-      SetIncorrectPDL(&response_status, data.size(), DATA_SIZE);
-    } else {
-      start_address = *(reinterpret_cast<const uint16_t*>(data.data()));
-      start_address = NetworkToHost(start_address);
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_DMX_START_ADDRESS>(ParamData(data), data.size(),
+                                              &start_address)) {
+    SetIncorrectPDL(&response_status, data.size(),
+                    PidCodec<PID_DMX_START_ADDRESS>::MAX_SIZE);
   }
   callback->Run(response_status, start_address);
 }
@@ -3602,50 +3571,17 @@ void RDMAPI::_HandleGetSensorDefinition(
                        const SensorDescriptor&> *callback,
     const ResponseStatus &status,
     const string &data) {
+  typedef PidCodec<PID_SENSOR_DEFINITION> Codec;
   ResponseStatus response_status = status;
   SensorDescriptor sensor;
 
-  if (response_status.WasAcked()) {
-    PACK(
-    struct sensor_definition_s {
-      uint8_t sensor_number;
-      uint8_t type;
-      uint8_t unit;
-      uint8_t prefix;
-      int16_t range_min;
-      int16_t range_max;
-      int16_t normal_min;
-      int16_t normal_max;
-      uint8_t recorded_value_support;
-      char description[MAX_RDM_STRING_LENGTH + 1];
-    });
-    STATIC_ASSERT(sizeof(sensor_definition_s) == 46);
-    struct sensor_definition_s raw_description;
-
-    unsigned int max = sizeof(raw_description) - 1;
-    unsigned int min = max - MAX_RDM_STRING_LENGTH;
-    unsigned int data_size = data.size();
-    if (data_size >= min && data_size <= max) {
-      memcpy(&raw_description, data.data(),
-             std::min(static_cast<unsigned int>(data.size()), max));
-
-      sensor.sensor_number = raw_description.sensor_number;
-      sensor.type = raw_description.type;
-      sensor.unit = raw_description.unit;
-      sensor.prefix = raw_description.prefix;
-      sensor.range_min = NetworkToHost(raw_description.range_min);
-      sensor.range_max = NetworkToHost(raw_description.range_max);
-      sensor.normal_min = NetworkToHost(raw_description.normal_min);
-      sensor.normal_max = NetworkToHost(raw_description.normal_max);
-      sensor.recorded_value_support = raw_description.recorded_value_support;
-      sensor.description = string(raw_description.description,
-                                  data_size - min);
-      ShortenString(&sensor.description);
-    } else {
-      std::ostringstream str;
-      str << data_size << " needs to be between " << min << " and " << max;
-      response_status.error = str.str();
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_SENSOR_DEFINITION>(ParamData(data), data.size(),
+                                              &sensor)) {
+    std::ostringstream str;
+    str << data.size() << " needs to be between " << Codec::MIN_SIZE
+        << " and " << Codec::MAX_SIZE;
+    response_status.error = str.str();
   }
   callback->Run(response_status, sensor);
 }
@@ -3663,17 +3599,11 @@ void RDMAPI::_HandleSensorValue(
   ResponseStatus response_status = status;
   SensorValueDescriptor sensor;
 
-  if (response_status.WasAcked()) {
-    unsigned int data_size = data.size();
-    if (data_size == sizeof(sensor)) {
-      memcpy(&sensor, data.data(), sizeof(sensor));
-      sensor.present_value = NetworkToHost(sensor.present_value);
-      sensor.lowest = NetworkToHost(sensor.lowest);
-      sensor.highest = NetworkToHost(sensor.highest);
-      sensor.recorded = NetworkToHost(sensor.recorded);
-    } else {
-      SetIncorrectPDL(&response_status, data.size(), sizeof(sensor));
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_SENSOR_VALUE>(ParamData(data), data.size(),
+                                         &sensor)) {
+    SetIncorrectPDL(&response_status, data.size(),
+                    PidCodec<PID_SENSOR_VALUE>::MAX_SIZE);
   }
   callback->Run(response_status, sensor);
 }
@@ -3691,14 +3621,11 @@ void RDMAPI::_HandleClock(
   ResponseStatus response_status = status;
   ClockValue clock;
 
-  if (response_status.WasAcked()) {
-    unsigned int data_size = data.size();
-    if (data_size == sizeof(clock)) {
-      memcpy(&clock, data.data(), sizeof(clock));
-      clock.year = NetworkToHost(clock.year);
-    } else {
-      SetIncorrectPDL(&response_status, data.size(), sizeof(clock));
-    }
+  if (response_status.WasAcked() &&
+      !UnpackParamData<PID_REAL_TIME_CLOCK>(ParamData(data), data.size(),
+                                            &clock)) {
+    SetIncorrectPDL(&response_status, data.size(),
+                    PidCodec<PID_REAL_TIME_CLOCK>::MAX_SIZE);
   }
   callback->Run(response_status, clock);
 }
@@ -28,6 +28,7 @@
 #include <string.h>
 #include <string>
 #include "ola/Logging.h"
+#include "ola/base/Atomic.h"
 #include "ola/network/NetworkUtils.h"
 #include "ola/rdm/RDMCommand.h"
 #include "ola/rdm/UID.h"
@@ -81,6 +82,15 @@ RDMCommand::RDMCommandClass GuessMessageType(const uint8_t *data,
  * @{
  */
 
+/**
+ * @brief The parameter data shared between copies of a command.
+ *
+ * The data follows the struct in the same allocation.
+ */
+struct RDMCommand::ParamDataBuffer {
+  unsigned int ref_count;
+};
+
 RDMCommand::RDMCommand(const UID &source,
                        const UID &destination,
                        uint8_t transaction_number,
@@ -97,6 +107,7 @@ RDMCommand::RDMCommand(const UID &source,
     m_message_count(message_count),
     m_sub_device(sub_device),
     m_param_id(param_id),
+    m_buffer(NULL),
     m_data(NULL),
     m_data_length(length) {
   SetParamData(data, length);
@@ -104,9 +115,7 @@ RDMCommand::RDMCommand(const UID &source,
 
 
 RDMCommand::~RDMCommand() {
-  if (m_data) {
-    delete[] m_data;
-  }
+  ReleaseParamData();
 }
 
 string RDMCommand::ToString() const {
@@ -171,13 +180,40 @@ uint8_t RDMCommand::MessageLength() const {
 void RDMCommand::SetParamData(const uint8_t *data, unsigned int length) {
   m_data_length = length;
   if (m_data_length > 0 && data != NULL) {
-    if (m_data) {
-      delete[] m_data;
-    }
+    ReleaseParamData();
+
+    // The reference count and the data share a single allocation.
+    uint8_t *memory = new uint8_t[sizeof(ParamDataBuffer) + m_data_length];
+    m_buffer = reinterpret_cast<ParamDataBuffer*>(memory);
+    m_buffer->ref_count = 1;
+    uint8_t *param_data = memory + sizeof(ParamDataBuffer);
+    memcpy(param_data, data, m_data_length);
+    m_data = param_data;
+  }
+}
+
+
+void RDMCommand::ShareParamData(const RDMCommand &other) {
+  if (&other == this) {
+    return;
+  }
+  ReleaseParamData();
+  m_buffer = other.m_buffer;
+  m_data = other.m_data;
+  m_data_length = other.m_data_length;
+  if (m_buffer) {
+    // Copies may be deleted on different threads.
+    AtomicAdd(&m_buffer->ref_count, 1);
+  }
+}
+
 
-    m_data = new uint8_t[m_data_length];
-    memcpy(m_data, data, m_data_length);
+void RDMCommand::ReleaseParamData() {
+  if (m_buffer && AtomicSubtract(&m_buffer->ref_count, 1) == 0) {
+    delete[] reinterpret_cast<uint8_t*>(m_buffer);
   }
+  m_buffer = NULL;
+  m_data = NULL;
 }
 
 
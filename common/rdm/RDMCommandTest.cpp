@@ -85,6 +85,7 @@ class RDMCommandTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testSetWithParamData);
   CPPUNIT_TEST(testRequestOverrides);
   CPPUNIT_TEST(testRequestMutation);
+  CPPUNIT_TEST(testDuplicate);
   CPPUNIT_TEST(testRequestInflation);
   CPPUNIT_TEST(testResponseMutation);
   CPPUNIT_TEST(testResponseInflation);
@@ -111,6 +112,7 @@ class RDMCommandTest: public CppUnit::TestFixture {
   void testSetWithParamData();
   void testRequestOverrides();
   void testRequestMutation();
+  void testDuplicate();
   void testRequestInflation();
   void testResponseMutation();
   void testResponseInflation();
@@ -385,6 +387,44 @@ void RDMCommandTest::testRequestMutation() {
   OLA_ASSERT_FALSE(command.IsDUB());
 }
 
+/*
+ * Test that copies share the parameter data.
+ */
+void RDMCommandTest::testDuplicate() {
+  uint8_t data[] = {1, 2, 3, 4};
+  auto_ptr<RDMRequest> request(
+      new RDMSetRequest(m_source, m_destination, 0, 1, 10, 296, data,
+                        arraysize(data)));
+  auto_ptr<RDMRequest> copy(request->Duplicate());
+  OLA_ASSERT_TRUE(*request == *copy);
+  OLA_ASSERT_EQ(RDMCommand::SET_COMMAND, copy->CommandClass());
+  OLA_ASSERT_EQ(request->ParamData(), copy->ParamData());
+
+  // Mutating the copy leaves the original alone.
+  copy->SetTransactionNumber(2);
+  OLA_ASSERT_EQ((uint8_t) 0, request->TransactionNumber());
+
+  // The data outlives the original.
+  request.reset();
+  auto_ptr<RDMRequest> second_copy(copy->Duplicate());
+  copy.reset();
+  OLA_ASSERT_DATA_EQUALS(data, arraysize(data), second_copy->ParamData(),
+                         second_copy->ParamDataSize());
+
+  // Requests without data
+  RDMGetRequest get_request(m_source, m_destination, 0, 1, 10, 296, NULL, 0);
+  copy.reset(get_request.Duplicate());
+  OLA_ASSERT_NULL(copy->ParamData());
+  OLA_ASSERT_EQ(0u, copy->ParamDataSize());
+
+  uint8_t response_data[] = {5, 6};
+  RDMGetResponse response(m_source, m_destination, 0, ola::rdm::RDM_ACK, 0,
+                          10, 296, response_data, arraysize(response_data));
+  auto_ptr<RDMResponse> response_copy(response.Duplicate());
+  OLA_ASSERT_TRUE(response == *response_copy);
+  OLA_ASSERT_EQ(response.ParamData(), response_copy->ParamData());
+}
+
 /*
  * Test that we can inflate RDM request messages correctly
  */
@@ -33,6 +33,7 @@
 #include "ola/network/InterfacePicker.h"
 #include "ola/network/MACAddress.h"
 #include "ola/network/NetworkUtils.h"
+#include "ola/rdm/ParamDataCodec.h"
 #include "ola/rdm/RDMEnums.h"
 #include "ola/rdm/ResponderHelper.h"
 #include "ola/rdm/ResponderSensor.h"
@@ -96,38 +97,24 @@ RDMResponse *ResponderHelper::GetDeviceInfo(
     return NackWithReason(request, NR_FORMAT_ERROR, queued_message_count);
   }
 
-  PACK(
-  struct device_info_s {
-    uint16_t rdm_version;
-    uint16_t model;
-    uint16_t product_category;
-    uint32_t software_version;
-    uint16_t dmx_footprint;
-    uint8_t current_personality;
-    uint8_t personality_count;
-    uint16_t dmx_start_address;
-    uint16_t sub_device_count;
-    uint8_t sensor_count;
-  });
-  STATIC_ASSERT(sizeof(device_info_s) == 19);
-
-  struct device_info_s device_info;
-  device_info.rdm_version = HostToNetwork(
-      static_cast<uint16_t>(RDM_VERSION_1_0));
-  device_info.model = HostToNetwork(device_model);
-  device_info.product_category = HostToNetwork(
-      static_cast<uint16_t>(product_category));
-  device_info.software_version = HostToNetwork(software_version);
-  device_info.dmx_footprint = HostToNetwork(dmx_footprint);
+  DeviceDescriptor device_info;
+  device_info.protocol_version_high = RDM_VERSION_1_0 >> 8;
+  device_info.protocol_version_low = RDM_VERSION_1_0 & 0xff;
+  device_info.device_model = device_model;
+  device_info.product_category = static_cast<uint16_t>(product_category);
+  device_info.software_version = software_version;
+  device_info.dmx_footprint = dmx_footprint;
   device_info.current_personality = current_personality;
   device_info.personality_count = personality_count;
-  device_info.dmx_start_address = HostToNetwork(dmx_start_address);
-  device_info.sub_device_count = HostToNetwork(sub_device_count);
+  device_info.dmx_start_address = dmx_start_address;
+  device_info.sub_device_count = sub_device_count;
   device_info.sensor_count = sensor_count;
+
+  uint8_t data[PidCodec<PID_DEVICE_INFO>::MAX_SIZE];
   return GetResponseFromData(
       request,
-      reinterpret_cast<uint8_t*>(&device_info),
-      sizeof(device_info),
+      data,
+      PackParamData<PID_DEVICE_INFO>(device_info, data, sizeof(data)),
       RDM_ACK,
       queued_message_count);
 }
@@ -183,21 +170,15 @@ RDMResponse *ResponderHelper::GetPersonality(
     return NackWithReason(request, NR_FORMAT_ERROR, queued_message_count);
   }
 
-  PACK(
-  struct personality_info_s {
-    uint8_t personality;
-    uint8_t total;
-  });
-  STATIC_ASSERT(sizeof(personality_info_s) == 2);
-
-  struct personality_info_s personality_info = {
+  PersonalityInfo personality_info = {
       personality_manager->ActivePersonalityNumber(),
       personality_manager->PersonalityCount()
   };
+  uint8_t data[PidCodec<PID_DMX_PERSONALITY>::MAX_SIZE];
   return GetResponseFromData(
     request,
-    reinterpret_cast<const uint8_t*>(&personality_info),
-    sizeof(personality_info),
+    data,
+    PackParamData<PID_DMX_PERSONALITY>(personality_info, data, sizeof(data)),
     RDM_ACK,
     queued_message_count);
 }
@@ -239,32 +220,17 @@ RDMResponse *ResponderHelper::GetPersonalityDescription(
   if (!personality) {
     return NackWithReason(request, NR_DATA_OUT_OF_RANGE, queued_message_count);
   } else {
-    PACK(
-    struct personality_description_s {
-      uint8_t personality;
-      uint16_t slots_required;
-      char description[MAX_RDM_STRING_LENGTH];
-    });
-    STATIC_ASSERT(sizeof(personality_description_s) == 35);
-
-    struct personality_description_s personality_description;
+    PersonalityDescription personality_description;
     personality_description.personality = personality_number;
-    personality_description.slots_required =
-        HostToNetwork(personality->Footprint());
-
-    size_t str_len = min(personality->Description().size(),
-                         sizeof(personality_description.description));
-    strncpy(personality_description.description,
-            personality->Description().c_str(), str_len);
-
-    unsigned int param_data_size = (
-        sizeof(personality_description) -
-        sizeof(personality_description.description) + str_len);
+    personality_description.slots_required = personality->Footprint();
+    personality_description.description = personality->Description();
 
+    uint8_t data[PidCodec<PID_DMX_PERSONALITY_DESCRIPTION>::MAX_SIZE];
     return GetResponseFromData(
         request,
-        reinterpret_cast<uint8_t*>(&personality_description),
-        param_data_size,
+        data,
+        PackParamData<PID_DMX_PERSONALITY_DESCRIPTION>(
+            personality_description, data, sizeof(data)),
         RDM_ACK,
         queued_message_count);
   }
@@ -460,39 +426,24 @@ RDMResponse *ResponderHelper::GetSensorDefinition(
     return NackWithReason(request, NR_DATA_OUT_OF_RANGE);
   }
 
-  PACK(
-  struct sensor_definition_s {
-    uint8_t sensor;
-    uint8_t type;
-    uint8_t unit;
-    uint8_t prefix;
-    int16_t range_min;
-    int16_t range_max;
-    int16_t normal_min;
-    int16_t normal_max;
-    uint8_t recorded_support;
-    char description[MAX_RDM_STRING_LENGTH];
-  });
-  STATIC_ASSERT(sizeof(sensor_definition_s) == 45);
-
   const Sensor *sensor = sensor_list.at(sensor_number);
-  struct sensor_definition_s sensor_definition;
-  sensor_definition.sensor = sensor_number;
+  SensorDescriptor sensor_definition;
+  sensor_definition.sensor_number = sensor_number;
   sensor_definition.type = sensor->Type();
   sensor_definition.unit = sensor->Unit();
   sensor_definition.prefix = sensor->Prefix();
-  sensor_definition.range_min = HostToNetwork(sensor->RangeMin());
-  sensor_definition.range_max = HostToNetwork(sensor->RangeMax());
-  sensor_definition.normal_min = HostToNetwork(sensor->NormalMin());
-  sensor_definition.normal_max = HostToNetwork(sensor->NormalMax());
-  sensor_definition.recorded_support = sensor->RecordedSupportBitMask();
-  strings::CopyToFixedLengthBuffer(sensor->Description(),
-                                   sensor_definition.description,
-                                   arraysize(sensor_definition.description));
-  return GetResponseFromData(
-    request,
-    reinterpret_cast<const uint8_t*>(&sensor_definition),
-    sizeof(sensor_definition));
+  sensor_definition.range_min = sensor->RangeMin();
+  sensor_definition.range_max = sensor->RangeMax();
+  sensor_definition.normal_min = sensor->NormalMin();
+  sensor_definition.normal_max = sensor->NormalMax();
+  sensor_definition.recorded_value_support = sensor->RecordedSupportBitMask();
+  sensor_definition.description = sensor->Description();
+
+  // The description is always padded to the full length.
+  uint8_t data[PidCodec<PID_SENSOR_DEFINITION>::MAX_SIZE];
+  memset(data, 0, sizeof(data));
+  PackParamData<PID_SENSOR_DEFINITION>(sensor_definition, data, sizeof(data));
+  return GetResponseFromData(request, data, sizeof(data));
 }
 
 /**
@@ -510,18 +461,18 @@ RDMResponse *ResponderHelper::GetSensorValue(
   }
 
   Sensor *sensor = sensor_list.at(sensor_number);
-  struct sensor_value_s sensor_value = {
-    sensor_number,
-    HostToNetwork(sensor->FetchValue()),
-    HostToNetwork(sensor->Lowest()),
-    HostToNetwork(sensor->Highest()),
-    HostToNetwork(sensor->Recorded()),
-  };
-
+  SensorValueDescriptor sensor_value;
+  sensor_value.sensor_number = sensor_number;
+  sensor_value.present_value = sensor->FetchValue();
+  sensor_value.lowest = sensor->Lowest();
+  sensor_value.highest = sensor->Highest();
+  sensor_value.recorded = sensor->Recorded();
+
+  uint8_t data[PidCodec<PID_SENSOR_VALUE>::MAX_SIZE];
   return GetResponseFromData(
     request,
-    reinterpret_cast<const uint8_t*>(&sensor_value),
-    sizeof(sensor_value));
+    data,
+    PackParamData<PID_SENSOR_VALUE>(sensor_value, data, sizeof(data)));
 }
 
 /**
@@ -547,18 +498,18 @@ RDMResponse *ResponderHelper::SetSensorValue(
     return NackWithReason(request, NR_DATA_OUT_OF_RANGE);
   }
 
-  struct sensor_value_s sensor_value = {
-    sensor_number,
-    HostToNetwork(value),
-    HostToNetwork(value),
-    HostToNetwork(value),
-    HostToNetwork(value),
-  };
+  SensorValueDescriptor sensor_value;
+  sensor_value.sensor_number = sensor_number;
+  sensor_value.present_value = value;
+  sensor_value.lowest = value;
+  sensor_value.highest = value;
+  sensor_value.recorded = value;
 
+  uint8_t data[PidCodec<PID_SENSOR_VALUE>::MAX_SIZE];
   return GetResponseFromData(
     request,
-    reinterpret_cast<const uint8_t*>(&sensor_value),
-    sizeof(sensor_value));
+    data,
+    PackParamData<PID_SENSOR_VALUE>(sensor_value, data, sizeof(data)));
 }
 
 
@@ -597,17 +548,6 @@ RDMResponse *ResponderHelper::GetRealTimeClock(
     return NackWithReason(request, NR_FORMAT_ERROR, queued_message_count);
   }
 
-  PACK(
-  struct clock_s {
-    uint16_t year;
-    uint8_t month;
-    uint8_t day;
-    uint8_t hour;
-    uint8_t minute;
-    uint8_t second;
-  });
-  STATIC_ASSERT(sizeof(clock_s) == 7);
-
   time_t now;
   now = time(NULL);
   struct tm tm_now;
@@ -617,18 +557,19 @@ RDMResponse *ResponderHelper::GetRealTimeClock(
   localtime_r(&now, &tm_now);
 #endif  // _WIN32
 
-  struct clock_s clock;
-  clock.year = HostToNetwork(static_cast<uint16_t>(1900 + tm_now.tm_year));
-  clock.month = tm_now.tm_mon + 1;
-  clock.day = tm_now.tm_mday;
-  clock.hour = tm_now.tm_hour;
-  clock.minute = tm_now.tm_min;
-  clock.second = tm_now.tm_sec;
+  ClockValue clock;
+  clock.year = static_cast<uint16_t>(1900 + tm_now.tm_year);
+  clock.month = static_cast<uint8_t>(tm_now.tm_mon + 1);
+  clock.day = static_cast<uint8_t>(tm_now.tm_mday);
+  clock.hour = static_cast<uint8_t>(tm_now.tm_hour);
+  clock.minute = static_cast<uint8_t>(tm_now.tm_min);
+  clock.second = static_cast<uint8_t>(tm_now.tm_sec);
 
+  uint8_t data[PidCodec<PID_REAL_TIME_CLOCK>::MAX_SIZE];
   return GetResponseFromData(
       request,
-      reinterpret_cast<uint8_t*>(&clock),
-      sizeof(clock),
+      data,
+      PackParamData<PID_REAL_TIME_CLOCK>(clock, data, sizeof(data)),
       RDM_ACK,
       queued_message_count);
 }
@@ -226,6 +226,26 @@ void UIDTest::testUIDSet() {
 
   difference = set3.SetDifference(set1);
   OLA_ASSERT_EQ(0u, difference.Size());
+
+  // Add UIDs out of order, the set should stay sorted.
+  UIDSet set4;
+  set4.AddUID(UID(2, 1));
+  set4.AddUID(UID(1, 5));
+  set4.AddUID(UID(1, 3));
+  set4.AddUID(UID(1, 5));
+  set4.AddUID(UID(3, 0));
+  OLA_ASSERT_EQ(4u, set4.Size());
+  OLA_ASSERT_EQ(
+      string("0001:00000003,0001:00000005,0002:00000001,0003:00000000"),
+      set4.ToString());
+
+  set4.RemoveUID(UID(1, 4));
+  OLA_ASSERT_EQ(4u, set4.Size());
+  set4.RemoveUID(UID(1, 5));
+  OLA_ASSERT_EQ(3u, set4.Size());
+  OLA_ASSERT_FALSE(set4.Contains(UID(1, 5)));
+  OLA_ASSERT_TRUE(set4.Contains(UID(1, 3)));
+  OLA_ASSERT_TRUE(set4.Contains(UID(3, 0)));
 }
 
 
@@ -249,6 +269,15 @@ void UIDTest::testUIDSetUnion() {
   OLA_ASSERT_TRUE(union_set.Contains(uid2));
   OLA_ASSERT_TRUE(union_set.Contains(uid3));
   OLA_ASSERT_TRUE(union_set.Contains(uid4));
+
+  // Overlapping sets
+  set1.AddUID(uid3);
+  expected.AddUID(uid);
+  expected.AddUID(uid2);
+  expected.AddUID(uid3);
+  expected.AddUID(uid4);
+  OLA_ASSERT_EQ(expected, set1.Union(set2));
+  OLA_ASSERT_EQ(expected, set2.Union(set1));
 }
 
 
@@ -0,0 +1,161 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * discovery_benchmark.cpp
+ * Run the DiscoveryAgent against a simulated line of responders and report
+ * how many commands each type of discovery takes.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "common/rdm/DiscoveryAgentTestHelper.h"
+#include "ola/Callback.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/math/Random.h"
+#include "ola/rdm/DiscoveryAgent.h"
+#include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+
+using ola::rdm::DiscoveryAgent;
+using ola::rdm::UID;
+using ola::rdm::UIDSet;
+using std::cout;
+using std::endl;
+using std::string;
+
+DEFINE_s_uint32(responders, r, 300, "The number of responders on the line.");
+DEFINE_s_uint16(manufacturers, m, 4,
+                "The number of manufacturers the responders are spread "
+                "across.");
+DEFINE_uint32(changes, 5,
+              "The number of responders to replace between the warm runs.");
+DEFINE_uint32(dub_us, 5800,
+              "The time a DUB takes, used to estimate the time on the line.");
+DEFINE_uint32(mute_us, 3000,
+              "The time a mute takes, used to estimate the time on the line.");
+
+/**
+ * Record the result of a discovery run.
+ */
+class DiscoveryResult {
+ public:
+  DiscoveryResult() : m_complete(false), m_ok(false) {}
+
+  void Complete(bool ok, const UIDSet &uids) {
+    m_complete = true;
+    m_ok = ok;
+    m_uids = uids;
+  }
+
+  bool Matches(const UIDSet &expected) const {
+    return m_complete && m_ok && m_uids == expected;
+  }
+
+ private:
+  bool m_complete;
+  bool m_ok;
+  UIDSet m_uids;
+};
+
+
+UID RandomUID() {
+  uint16_t manufacturer_id = static_cast<uint16_t>(
+      0x7a70 + ola::math::Random(0, FLAGS_manufacturers - 1));
+  // Most manufacturers allocate device ids sequentially, so keep them in a
+  // small range.
+  uint32_t device_id = static_cast<uint32_t>(ola::math::Random(0, 0xfffff));
+  return UID(manufacturer_id, device_id);
+}
+
+
+bool RunDiscovery(const string &name, DiscoveryAgent *agent,
+                  MockDiscoveryTarget *target, const UIDSet &expected,
+                  bool full) {
+  DiscoveryResult result;
+  target->ResetCounters();
+  DiscoveryAgent::DiscoveryCompleteCallback *callback =
+      ola::NewSingleCallback(&result, &DiscoveryResult::Complete);
+  if (full) {
+    agent->StartFullDiscovery(callback);
+  } else {
+    agent->StartIncrementalDiscovery(callback);
+  }
+
+  unsigned int branches = target->BranchCallCount();
+  unsigned int mutes = target->MuteCallCount() + target->UnmuteCallCount();
+  double line_time = (static_cast<double>(branches) * FLAGS_dub_us +
+                      static_cast<double>(mutes) * FLAGS_mute_us) / 1000000;
+  cout << std::setw(16) << name << ": " << std::setw(6) << branches
+       << " DUBs, " << std::setw(6) << mutes << " mutes, ~" << std::fixed
+       << std::setprecision(1) << line_time << "s on the line" << endl;
+
+  if (!result.Matches(expected)) {
+    cout << name << " didn't find the expected responders" << endl;
+    return false;
+  }
+  return true;
+}
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Measure RDM discovery on a simulated line of responders.");
+
+  if (FLAGS_responders == 0 || FLAGS_manufacturers == 0) {
+    ola::DisplayUsageAndExit();
+  }
+
+  ola::math::InitRandom();
+  UIDSet uids;
+  while (uids.Size() < FLAGS_responders) {
+    uids.AddUID(RandomUID());
+  }
+
+  ResponderList responders;
+  UIDSet::Iterator iter = uids.Begin();
+  for (; iter != uids.End(); ++iter) {
+    responders.push_back(new MockResponder(*iter));
+  }
+  MockDiscoveryTarget target(responders);
+  DiscoveryAgent agent(&target);
+
+  cout << uids.Size() << " responders" << endl;
+  bool ok = RunDiscovery("full (cold)", &agent, &target, uids, true);
+  ok &= RunDiscovery("full (warm)", &agent, &target, uids, true);
+  ok &= RunDiscovery("incremental", &agent, &target, uids, false);
+
+  // Replace some of the responders.
+  for (unsigned int i = 0; i < FLAGS_changes && uids.Size(); i++) {
+    UID old_uid = *uids.Begin();
+    uids.RemoveUID(old_uid);
+    target.RemoveResponder(old_uid);
+
+    UID new_uid = RandomUID();
+    while (uids.Contains(new_uid)) {
+      new_uid = RandomUID();
+    }
+    uids.AddUID(new_uid);
+    target.AddResponder(new MockResponder(new_uid));
+  }
+  cout << "Replaced " << FLAGS_changes << " responders" << endl;
+  ok &= RunDiscovery("full (warm)", &agent, &target, uids, true);
+  ok &= RunDiscovery("incremental", &agent, &target, uids, false);
+  return ok ? ola::EXIT_OK : ola::EXIT_SOFTWARE;
+}
@@ -0,0 +1,157 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * param_data_benchmark.cpp
+ * Compare the PidCodecs against the descriptor driven serializers.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/messaging/Message.h"
+#include "ola/rdm/MessageDeserializer.h"
+#include "ola/rdm/MessageSerializer.h"
+#include "ola/rdm/ParamDataCodec.h"
+#include "ola/rdm/PidStore.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/rdm/StringMessageBuilder.h"
+#include "ola/testing/BenchmarkTimer.h"
+
+using ola::messaging::Descriptor;
+using ola::messaging::Message;
+using ola::rdm::DeviceDescriptor;
+using ola::rdm::MessageDeserializer;
+using ola::rdm::MessageSerializer;
+using ola::rdm::PidCodec;
+using ola::rdm::PidDescriptor;
+using ola::rdm::RootPidStore;
+using ola::rdm::StringMessageBuilder;
+using ola::testing::BenchmarkTimer;
+using std::auto_ptr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+DEFINE_s_string(pid_location, p, "",
+                "The directory containing the PID definitions, defaults to "
+                "the installed PIDs.");
+DEFINE_s_uint32(iterations, i, 100000,
+                "The number of times to pack & unpack the DEVICE_INFO.");
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Compare the compile time RDM codecs against the PID store.");
+
+  string pid_location = FLAGS_pid_location.str();
+  if (pid_location.empty()) {
+    pid_location = RootPidStore::DataLocation();
+  }
+
+  auto_ptr<const RootPidStore> store(
+      RootPidStore::LoadFromDirectory(pid_location));
+  if (!store.get()) {
+    return ola::EXIT_DATAERR;
+  }
+  const PidDescriptor *pid_descriptor = store->EstaStore()->LookupPID(
+      ola::rdm::PID_DEVICE_INFO);
+  if (!pid_descriptor || !pid_descriptor->GetResponse()) {
+    cout << "DEVICE_INFO is missing from the PID store" << endl;
+    return ola::EXIT_DATAERR;
+  }
+  const Descriptor *descriptor = pid_descriptor->GetResponse();
+
+  DeviceDescriptor device_info;
+  device_info.protocol_version_high = 1;
+  device_info.protocol_version_low = 0;
+  device_info.device_model = 0x0102;
+  device_info.product_category = ola::rdm::PRODUCT_CATEGORY_DIMMER_CS_LED;
+  device_info.software_version = 10;
+  device_info.dmx_footprint = 4;
+  device_info.current_personality = 1;
+  device_info.personality_count = 3;
+  device_info.dmx_start_address = 16;
+  device_info.sub_device_count = 2;
+  device_info.sensor_count = 5;
+
+  const char *inputs[] = {"1", "0", "258", "1289", "10", "4", "1", "3", "16",
+                          "2", "5"};
+  vector<string> string_inputs(inputs,
+                               inputs + sizeof(inputs) / sizeof(*inputs));
+
+  BenchmarkTimer timer;
+  unsigned int total = 0;
+
+  // The descriptor path, as used by the ola_rdm_get & ola_rdm_set tools.
+  StringMessageBuilder builder;
+  MessageSerializer serializer;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    auto_ptr<const Message> message(
+        builder.GetMessage(string_inputs, descriptor));
+    unsigned int length = 0;
+    serializer.SerializeMessage(message.get(), &length);
+    total += length;
+  }
+  timer.Report("Descriptor build & serialize");
+
+  auto_ptr<const Message> message(
+      builder.GetMessage(string_inputs, descriptor));
+  if (!message.get()) {
+    cout << "Failed to build the message: " << builder.GetError() << endl;
+    return ola::EXIT_SOFTWARE;
+  }
+  timer.Reset();
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    unsigned int length = 0;
+    serializer.SerializeMessage(message.get(), &length);
+    total += length;
+  }
+  timer.Report("Descriptor serialize");
+
+  uint8_t data[PidCodec<ola::rdm::PID_DEVICE_INFO>::MAX_SIZE];
+  unsigned int data_size = 0;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    device_info.dmx_start_address = static_cast<uint16_t>(i);
+    data_size = ola::rdm::PackParamData<ola::rdm::PID_DEVICE_INFO>(
+        device_info, data, sizeof(data));
+    total += data_size;
+  }
+  timer.Report("PackParamData");
+
+  MessageDeserializer deserializer;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    auto_ptr<const Message> output(
+        deserializer.InflateMessage(descriptor, data, data_size));
+    total += output.get() ? output->FieldCount() : 0;
+  }
+  timer.Report("Descriptor deserialize");
+
+  DeviceDescriptor output;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    total += ola::rdm::UnpackParamData<ola::rdm::PID_DEVICE_INFO>(
+        data, data_size, &output);
+  }
+  timer.Report("UnpackParamData");
+
+  // Stop the compiler from discarding the loops.
+  return total ? ola::EXIT_OK : ola::EXIT_SOFTWARE;
+}
@@ -0,0 +1,138 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pid_store_benchmark.cpp
+ * Measure how long it takes to load the PID store from the text files and
+ * from a compiled file.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/rdm/PidStoreLoader.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/rdm/PidStore.h"
+#include "ola/testing/BenchmarkTimer.h"
+
+using ola::rdm::PidDescriptor;
+using ola::rdm::PidStoreLoader;
+using ola::rdm::RootPidStore;
+using ola::testing::BenchmarkTimer;
+using std::auto_ptr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+DEFINE_s_string(pid_location, p, "",
+                "The directory containing the PID definitions, defaults to "
+                "the installed PIDs.");
+DEFINE_s_string(output, o, "compiled_pids.bin",
+                "The file to write the compiled PIDs to.");
+DEFINE_uint32(lookups, 100000,
+              "The number of times to look up each ESTA PID.");
+
+static const uint16_t MAX_MANUFACTURER_ID = 0x7fff;
+
+/**
+ * Ask for every manufacturer's PIDs, returns the number that exist.
+ */
+unsigned int LoadManufacturers(const RootPidStore *store) {
+  unsigned int manufacturers = 0;
+  for (uint16_t id = 1; id <= MAX_MANUFACTURER_ID; id++) {
+    if (store->ManufacturerStore(id)) {
+      manufacturers++;
+    }
+  }
+  return manufacturers;
+}
+
+/**
+ * Look up each ESTA PID by value and by name.
+ */
+bool LookupPids(const RootPidStore *store) {
+  vector<const PidDescriptor*> pids;
+  store->EstaStore()->AllPids(&pids);
+  for (unsigned int i = 0; i < FLAGS_lookups; i++) {
+    vector<const PidDescriptor*>::const_iterator iter = pids.begin();
+    for (; iter != pids.end(); ++iter) {
+      if (store->GetDescriptor((*iter)->Value()) != *iter ||
+          store->GetDescriptor((*iter)->Name()) != *iter) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Compare loading the text & compiled PID stores.");
+
+  string pid_location = FLAGS_pid_location.str();
+  if (pid_location.empty()) {
+    pid_location = RootPidStore::DataLocation();
+  }
+
+  PidStoreLoader loader;
+  BenchmarkTimer timer;
+  auto_ptr<const RootPidStore> text_store(
+      loader.LoadFromTextDirectory(pid_location));
+  if (!text_store.get()) {
+    return ola::EXIT_DATAERR;
+  }
+  timer.Report("Load text files");
+  unsigned int manufacturers = LoadManufacturers(text_store.get());
+  timer.Report("Lookup all manufacturers");
+
+  if (!loader.CompileDirectory(pid_location, FLAGS_output.str())) {
+    return ola::EXIT_CANTCREAT;
+  }
+  timer.Report("Compile");
+
+  uint64_t hash;
+  if (!loader.SourceHash(pid_location, &hash)) {
+    return ola::EXIT_DATAERR;
+  }
+  timer.Report("Check for changes");
+
+  auto_ptr<const RootPidStore> compiled_store(
+      loader.LoadFromCompiledFile(FLAGS_output.str()));
+  if (!compiled_store.get()) {
+    return ola::EXIT_DATAERR;
+  }
+  timer.Report("Load compiled file");
+  if (LoadManufacturers(compiled_store.get()) != manufacturers) {
+    cout << "The compiled store has different manufacturers" << endl;
+    return ola::EXIT_SOFTWARE;
+  }
+  timer.Report("Lookup all manufacturers");
+
+  if (!LookupPids(compiled_store.get())) {
+    cout << "PID lookup failed" << endl;
+    return ola::EXIT_SOFTWARE;
+  }
+  timer.Report("Lookup ESTA PIDs");
+
+  cout << manufacturers << " manufacturers, "
+       << compiled_store->EstaStore()->PidCount() << " ESTA PIDs" << endl;
+  return ola::EXIT_OK;
+}
@@ -0,0 +1,59 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pid_store_compiler.cpp
+ * Compile a directory of PID definitions into a single binary file, which
+ * olad can load much faster than the text files.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <string>
+#include "common/rdm/PidStoreLoader.h"
+#include "ola/Logging.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/file/Util.h"
+
+using ola::rdm::PidStoreLoader;
+using std::string;
+
+DEFINE_s_string(pid_location, p, "",
+                "The directory containing the PID definitions.");
+DEFINE_s_string(output, o, "",
+                "The file to write, defaults to compiled_pids.bin in the PID "
+                "directory.");
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "--pid-location <dir> [--output <file>]",
+               "Compile the PID definitions into a binary file.");
+
+  if (FLAGS_pid_location.str().empty()) {
+    ola::DisplayUsageAndExit();
+  }
+
+  string output = FLAGS_output.str();
+  if (output.empty()) {
+    output = ola::file::JoinPaths(FLAGS_pid_location.str(),
+                                  PidStoreLoader::COMPILED_FILE_NAME);
+  }
+
+  PidStoreLoader loader;
+  if (!loader.CompileDirectory(FLAGS_pid_location.str(), output)) {
+    OLA_FATAL << "Failed to compile " << FLAGS_pid_location.str();
+    return ola::EXIT_DATAERR;
+  }
+  return ola::EXIT_OK;
+}
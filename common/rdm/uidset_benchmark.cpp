@@ -0,0 +1,189 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * uidset_benchmark.cpp
+ * Time the UIDSet operations used during discovery, with a std::set<UID>
+ * for comparison.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <vector>
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/math/Random.h"
+#include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+#include "ola/testing/BenchmarkTimer.h"
+
+using ola::rdm::UID;
+using ola::rdm::UIDSet;
+using ola::testing::BenchmarkTimer;
+using std::cout;
+using std::endl;
+using std::vector;
+
+DEFINE_s_uint32(uids, u, 10000, "The number of UIDs in each set.");
+DEFINE_uint32(changes, 100,
+              "The number of UIDs that differ between the two sets.");
+DEFINE_uint32(lookups, 100, "The number of times to look up each UID.");
+
+typedef std::set<UID> TreeSet;
+
+UID RandomUID() {
+  return UID(static_cast<uint16_t>(ola::math::Random(1, 0x7fff)),
+             static_cast<uint32_t>(ola::math::Random(0, 0x7fffffff)));
+}
+
+/**
+ * Run the benchmark on a UIDSet.
+ */
+unsigned int BenchmarkUIDSet(const vector<UID> &random_uids,
+                             const vector<UID> &sorted_uids,
+                             const vector<UID> &other_uids) {
+  unsigned int found = 0;
+  BenchmarkTimer timer;
+  UIDSet random_set;
+  for (vector<UID>::const_iterator iter = random_uids.begin();
+       iter != random_uids.end(); ++iter) {
+    random_set.AddUID(*iter);
+  }
+  timer.Report("UIDSet add (random)");
+
+  UIDSet sorted_set;
+  for (vector<UID>::const_iterator iter = sorted_uids.begin();
+       iter != sorted_uids.end(); ++iter) {
+    sorted_set.AddUID(*iter);
+  }
+  timer.Report("UIDSet add (sorted)");
+
+  UIDSet other_set;
+  for (vector<UID>::const_iterator iter = other_uids.begin();
+       iter != other_uids.end(); ++iter) {
+    other_set.AddUID(*iter);
+  }
+  timer.Reset();
+
+  for (unsigned int i = 0; i < FLAGS_lookups; i++) {
+    for (vector<UID>::const_iterator iter = random_uids.begin();
+         iter != random_uids.end(); ++iter) {
+      found += sorted_set.Contains(*iter);
+    }
+  }
+  timer.Report("UIDSet contains");
+
+  found += sorted_set.SetDifference(other_set).Size();
+  found += other_set.SetDifference(sorted_set).Size();
+  timer.Report("UIDSet difference (x2)");
+
+  found += sorted_set.Union(other_set).Size();
+  timer.Report("UIDSet union");
+  return found;
+}
+
+/**
+ * Run the same benchmark on a std::set.
+ */
+unsigned int BenchmarkTreeSet(const vector<UID> &random_uids,
+                              const vector<UID> &sorted_uids,
+                              const vector<UID> &other_uids) {
+  unsigned int found = 0;
+  BenchmarkTimer timer;
+  TreeSet random_set(random_uids.begin(), random_uids.end());
+  timer.Report("std::set add (random)");
+
+  TreeSet sorted_set;
+  for (vector<UID>::const_iterator iter = sorted_uids.begin();
+       iter != sorted_uids.end(); ++iter) {
+    sorted_set.insert(*iter);
+  }
+  timer.Report("std::set add (sorted)");
+
+  TreeSet other_set(other_uids.begin(), other_uids.end());
+  timer.Reset();
+
+  for (unsigned int i = 0; i < FLAGS_lookups; i++) {
+    for (vector<UID>::const_iterator iter = random_uids.begin();
+         iter != random_uids.end(); ++iter) {
+      found += sorted_set.count(*iter);
+    }
+  }
+  timer.Report("std::set contains");
+
+  TreeSet difference1, difference2;
+  std::set_difference(sorted_set.begin(), sorted_set.end(),
+                      other_set.begin(), other_set.end(),
+                      std::inserter(difference1, difference1.begin()));
+  std::set_difference(other_set.begin(), other_set.end(),
+                      sorted_set.begin(), sorted_set.end(),
+                      std::inserter(difference2, difference2.begin()));
+  found += difference1.size() + difference2.size();
+  timer.Report("std::set difference (x2)");
+
+  TreeSet union_set;
+  std::set_union(sorted_set.begin(), sorted_set.end(),
+                 other_set.begin(), other_set.end(),
+                 std::inserter(union_set, union_set.begin()));
+  found += union_set.size();
+  timer.Report("std::set union");
+  return found;
+}
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Compare UIDSet against a std::set of UIDs.");
+
+  ola::math::InitRandom();
+  vector<UID> random_uids;
+  random_uids.reserve(FLAGS_uids);
+  TreeSet seen;
+  while (random_uids.size() < FLAGS_uids) {
+    UID uid = RandomUID();
+    if (seen.insert(uid).second) {
+      random_uids.push_back(uid);
+    }
+  }
+
+  vector<UID> sorted_uids(random_uids);
+  std::sort(sorted_uids.begin(), sorted_uids.end());
+
+  // The other set is the same as the first, with some UIDs replaced, like
+  // the result of the next discovery run.
+  vector<UID> other_uids(random_uids);
+  for (unsigned int i = 0; i < FLAGS_changes && i < other_uids.size(); i++) {
+    UID uid = RandomUID();
+    while (!seen.insert(uid).second) {
+      uid = RandomUID();
+    }
+    other_uids[i] = uid;
+  }
+
+  cout << FLAGS_uids << " UIDs, " << FLAGS_changes << " changes" << endl;
+  unsigned int uidset_result = BenchmarkUIDSet(random_uids, sorted_uids,
+                                               other_uids);
+  unsigned int tree_result = BenchmarkTreeSet(random_uids, sorted_uids,
+                                              other_uids);
+  if (uidset_result != tree_result) {
+    cout << "UIDSet and std::set disagree" << endl;
+    return ola::EXIT_SOFTWARE;
+  }
+  return ola::EXIT_OK;
+}
@@ -52,12 +52,6 @@ const char RpcChannel::K_RPC_SENT_ERROR_VAR[] = "rpc-send-errors";
 const char RpcChannel::K_RPC_SENT_VAR[] = "rpc-sent";
 const char RpcChannel::STREAMING_NO_RESPONSE[] = "STREAMING_NO_RESPONSE";
 
-const char *RpcChannel::K_RPC_VARIABLES[] = {
-  K_RPC_RECEIVED_VAR,
-  K_RPC_SENT_ERROR_VAR,
-  K_RPC_SENT_VAR,
-};
-
 class OutstandingRequest {
   /*
    * These are requests on the server end that haven't completed yet.
@@ -117,7 +111,9 @@ RpcChannel::RpcChannel(
       m_buffer_size(0),
       m_expected_size(0),
       m_current_size(0),
-      m_export_map(export_map),
+      m_received_var(NULL),
+      m_sent_var(NULL),
+      m_sent_error_var(NULL),
       m_recv_type_map(NULL) {
   if (descriptor) {
     descriptor->SetOnData(
@@ -126,12 +122,12 @@ RpcChannel::RpcChannel(
         ola::NewSingleCallback(this, &RpcChannel::HandleChannelClose));
   }
 
-  if (m_export_map) {
-    for (unsigned int i = 0; i < arraysize(K_RPC_VARIABLES); ++i) {
-      m_export_map->GetCounterVar(string(K_RPC_VARIABLES[i]));
-    }
-    m_recv_type_map = m_export_map->GetUIntMapVar(K_RPC_RECEIVED_TYPE_VAR,
-                                                  "type");
+  if (export_map) {
+    m_received_var = export_map->GetCounterVar(K_RPC_RECEIVED_VAR);
+    m_sent_var = export_map->GetCounterVar(K_RPC_SENT_VAR);
+    m_sent_error_var = export_map->GetCounterVar(K_RPC_SENT_ERROR_VAR);
+    m_recv_type_map = export_map->GetUIntMapVar(K_RPC_RECEIVED_TYPE_VAR,
+                                                "type");
   }
 }
 
@@ -307,8 +303,8 @@ bool RpcChannel::SendMsg(RpcMessage *msg) {
   if (ret != length) {
     OLA_WARN << "Failed to send full RPC message, closing channel";
 
-    if (m_export_map) {
-      (*m_export_map->GetCounterVar(K_RPC_SENT_ERROR_VAR))++;
+    if (m_sent_error_var) {
+      (*m_sent_error_var)++;
     }
 
     // At this point there is no point using the descriptor since framing has
@@ -321,8 +317,8 @@ bool RpcChannel::SendMsg(RpcMessage *msg) {
     return false;
   }
 
-  if (m_export_map) {
-    (*m_export_map->GetCounterVar(K_RPC_SENT_VAR))++;
+  if (m_sent_var) {
+    (*m_sent_var)++;
   }
   return true;
 }
@@ -393,38 +389,38 @@ bool RpcChannel::HandleNewMsg(uint8_t *data, unsigned int size) {
     return false;
   }
 
-  if (m_export_map)
-    (*m_export_map->GetCounterVar(K_RPC_RECEIVED_VAR))++;
+  if (m_received_var)
+    (*m_received_var)++;
 
   switch (msg.type()) {
     case REQUEST:
       if (m_recv_type_map)
-        (*m_recv_type_map)["request"]++;
+        m_recv_type_map->Increment("request");
       HandleRequest(&msg);
       break;
     case RESPONSE:
       if (m_recv_type_map)
-        (*m_recv_type_map)["response"]++;
+        m_recv_type_map->Increment("response");
       HandleResponse(&msg);
       break;
     case RESPONSE_CANCEL:
       if (m_recv_type_map)
-        (*m_recv_type_map)["cancelled"]++;
+        m_recv_type_map->Increment("cancelled");
       HandleCanceledResponse(&msg);
       break;
     case RESPONSE_FAILED:
       if (m_recv_type_map)
-        (*m_recv_type_map)["failed"]++;
+        m_recv_type_map->Increment("failed");
       HandleFailedResponse(&msg);
       break;
     case RESPONSE_NOT_IMPLEMENTED:
       if (m_recv_type_map)
-        (*m_recv_type_map)["not-implemented"]++;
+        m_recv_type_map->Increment("not-implemented");
       HandleNotImplemented(&msg);
       break;
     case STREAM_REQUEST:
       if (m_recv_type_map)
-        (*m_recv_type_map)["stream_request"]++;
+        m_recv_type_map->Increment("stream_request");
       HandleStreamRequest(&msg);
       break;
     default:
@@ -151,7 +151,9 @@ class RpcChannel {
     unsigned int m_current_size;  // the amount of data read for the current msg
     HASH_NAMESPACE::HASH_MAP_CLASS<int, class OutstandingRequest*> m_requests;
     ResponseMap m_responses;
-    ExportMap *m_export_map;
+    CounterVariable *m_received_var;
+    CounterVariable *m_sent_var;
+    CounterVariable *m_sent_error_var;
     UIntMap *m_recv_type_map;
 
     bool SendMsg(RpcMessage *msg);
@@ -178,7 +180,6 @@ class RpcChannel {
     static const char K_RPC_RECEIVED_VAR[];
     static const char K_RPC_SENT_ERROR_VAR[];
     static const char K_RPC_SENT_VAR[];
-    static const char *K_RPC_VARIABLES[];
     static const char STREAMING_NO_RESPONSE[];
     static const unsigned int INITIAL_BUFFER_SIZE = 1 << 11;  // 2k
     static const unsigned int MAX_BUFFER_SIZE = 1 << 20;  // 1M
@@ -764,7 +764,18 @@ JsonValue* JsonArray::Clone() const {
   JsonArray *array = new JsonArray();
   ValuesVector::const_iterator iter = m_values.begin();
   for (; iter != m_values.end(); iter++) {
-    array->AppendValue((*iter)->Clone());
+    JsonValue *value = (*iter)->Clone();
+    // Format the clone the way Append() would: nested arrays and non-empty
+    // objects put each element on its own line.
+    JsonObject *object = ObjectCast(value);
+    if (object) {
+      array->Append(object);
+    } else if (ArrayCast(value)) {
+      array->AppendValue(value);
+      array->m_complex_type = true;
+    } else {
+      array->AppendValue(value);
+    }
   }
   return array;
 }
@@ -40,7 +40,8 @@ using std::auto_ptr;
 using std::string;
 
 static bool ParseTrimmedInput(const char **input,
-                              JsonParserInterface *parser);
+                              JsonParserInterface *parser,
+                              string *buffer);
 
 /**
  * @brief Trim leading whitespace from a string.
@@ -64,12 +65,14 @@ static bool TrimWhitespace(const char **input) {
  * @brief Extract a string token from the input.
  * @param input A pointer to a pointer with the data. This should point to the
  * first character after the quote (") character.
- * @param str A string object to store the extracted string.
+ * @param str A string object to store the extracted string. This is cleared
+ *   first.
  * @param parser the JsonParserInterface to pass tokens to.
  * @returns true if the string was extracted correctly, false otherwise.
  */
 static bool ParseString(const char **input, string* str,
                         JsonParserInterface *parser) {
+  str->clear();
   while (true) {
     size_t size = strcspn(*input, "\"\\");
     char c = (*input)[size];
@@ -251,7 +254,8 @@ static bool ParseNumber(const char **input, JsonParserInterface *parser) {
 /**
  * Starts from the first character after the  '['.
  */
-static bool ParseArray(const char **input, JsonParserInterface *parser) {
+static bool ParseArray(const char **input, JsonParserInterface *parser,
+                       string *buffer) {
   if (!TrimWhitespace(input)) {
     parser->SetError("Unterminated array");
     return false;
@@ -271,7 +275,7 @@ static bool ParseArray(const char **input, JsonParserInterface *parser) {
       return false;
     }
 
-    bool result = ParseTrimmedInput(input, parser);
+    bool result = ParseTrimmedInput(input, parser, buffer);
     if (!result) {
       OLA_INFO << "Invalid input";
       return false;
@@ -300,7 +304,8 @@ static bool ParseArray(const char **input, JsonParserInterface *parser) {
 /**
  * Starts from the first character after the  '{'.
  */
-static bool ParseObject(const char **input, JsonParserInterface *parser) {
+static bool ParseObject(const char **input, JsonParserInterface *parser,
+                        string *buffer) {
   if (!TrimWhitespace(input)) {
     parser->SetError("Unterminated object");
     return false;
@@ -327,11 +332,10 @@ static bool ParseObject(const char **input, JsonParserInterface *parser) {
     }
     (*input)++;
 
-    string key;
-    if (!ParseString(input, &key, parser)) {
+    if (!ParseString(input, buffer, parser)) {
       return false;
     }
-    parser->ObjectKey(key);
+    parser->ObjectKey(*buffer);
 
     if (!TrimWhitespace(input)) {
       parser->SetError("Missing : after key");
@@ -349,7 +353,7 @@ static bool ParseObject(const char **input, JsonParserInterface *parser) {
       return false;
     }
 
-    bool result = ParseTrimmedInput(input, parser);
+    bool result = ParseTrimmedInput(input, parser, buffer);
     if (!result) {
       return false;
     }
@@ -375,16 +379,16 @@ static bool ParseObject(const char **input, JsonParserInterface *parser) {
 }
 
 static bool ParseTrimmedInput(const char **input,
-                             JsonParserInterface *parser) {
+                              JsonParserInterface *parser,
+                              string *buffer) {
   static const char TRUE_STR[] = "true";
   static const char FALSE_STR[] = "false";
   static const char NULL_STR[] = "null";
 
   if (**input == '"') {
     (*input)++;
-    string str;
-    if (ParseString(input, &str, parser)) {
-      parser->String(str);
+    if (ParseString(input, buffer, parser)) {
+      parser->String(*buffer);
       return true;
     }
     return false;
@@ -404,10 +408,10 @@ static bool ParseTrimmedInput(const char **input,
     return ParseNumber(input, parser);
   } else if (**input == '[') {
     (*input)++;
-    return ParseArray(input, parser);
+    return ParseArray(input, parser, buffer);
   } else if (**input == '{') {
     (*input)++;
-    return ParseObject(input, parser);
+    return ParseObject(input, parser, buffer);
   }
   parser->SetError("Invalid JSON value");
   return false;
@@ -421,7 +425,9 @@ bool ParseRaw(const char *input, JsonParserInterface *parser) {
   }
 
   parser->Begin();
-  bool result = ParseTrimmedInput(&input, parser);
+  // Strings & keys are extracted into this, so its storage is reused.
+  string buffer;
+  bool result = ParseTrimmedInput(&input, parser, &buffer);
   if (!result) {
     return false;
   }
@@ -433,13 +439,9 @@ bool JsonLexer::Parse(const string &input,
                       JsonParserInterface *parser) {
   // TODO(simon): Do we need to convert to unicode here? I think this may be
   // an issue on Windows. Consider mbstowcs.
-  // Copying the input sucks though, so we should use input.c_str() if we can.
-  char* input_data = new char[input.size() + 1];
-  strncpy(input_data, input.c_str(), input.size() + 1);
-
-  bool result = ParseRaw(input_data, parser);
-  delete[] input_data;
-  return result;
+  // The lexer never writes to the input, so parse it in place. c_str() is
+  // always NUL terminated.
+  return ParseRaw(input.c_str(), parser);
 }
 }  // namespace web
 }  // namespace ola
@@ -35,8 +35,6 @@
 namespace ola {
 namespace web {
 
-using std::auto_ptr;
-using std::set;
 using std::string;
 using std::vector;
 
@@ -288,9 +286,12 @@ void NumberValidator::Visit(const JsonDouble &value) {
 
 // ObjectValidator
 // -----------------------------------------------------------------------------
+const unsigned int ObjectValidator::NOT_TRACKED = static_cast<unsigned int>(-1);
+
 ObjectValidator::ObjectValidator(const Options &options)
     : BaseValidator(JSON_OBJECT),
-      m_options(options) {
+      m_options(options),
+      m_prepared(false) {
 }
 
 ObjectValidator::~ObjectValidator() {
@@ -301,6 +302,7 @@ ObjectValidator::~ObjectValidator() {
 void ObjectValidator::AddValidator(const std::string &property,
                                    ValidatorInterface *validator) {
   STLReplaceAndDelete(&m_property_validators, property, validator);
+  m_prepared = false;
 }
 
 void ObjectValidator::SetAdditionalValidator(ValidatorInterface *validator) {
@@ -310,11 +312,13 @@ void ObjectValidator::SetAdditionalValidator(ValidatorInterface *validator) {
 void ObjectValidator::AddSchemaDependency(const string &property,
                                           ValidatorInterface *validator) {
   STLReplaceAndDelete(&m_schema_dependencies, property, validator);
+  m_prepared = false;
 }
 
 void ObjectValidator::AddPropertyDependency(const string &property,
                                             const StringSet &properties) {
   m_property_dependencies[property] = properties;
+  m_prepared = false;
 }
 
 void ObjectValidator::Visit(const JsonObject &obj) {
@@ -331,32 +335,33 @@ void ObjectValidator::Visit(const JsonObject &obj) {
     return;
   }
 
-  m_seen_properties.clear();
+  if (!m_prepared) {
+    Prepare();
+  }
+
+  std::fill(m_seen.begin(), m_seen.end(), false);
   obj.VisitProperties(this);
 
-  StringSet missing_properties;
-  std::set_difference(m_options.required_properties.begin(),
-                      m_options.required_properties.end(),
-                      m_seen_properties.begin(),
-                      m_seen_properties.end(),
-                      std::inserter(missing_properties,
-                                    missing_properties.end()));
-  if (!missing_properties.empty()) {
-    m_is_valid = false;
+  vector<unsigned int>::const_iterator iter = m_required_properties.begin();
+  for (; iter != m_required_properties.end(); ++iter) {
+    if (!m_seen[*iter]) {
+      m_is_valid = false;
+      break;
+    }
   }
 
   // Check PropertyDependencies
-  PropertyDependencies::const_iterator prop_iter =
-    m_property_dependencies.begin();
-  for (; prop_iter != m_property_dependencies.end() && m_is_valid;
+  vector<PropertyDependency>::const_iterator prop_iter =
+    m_flat_property_dependencies.begin();
+  for (; prop_iter != m_flat_property_dependencies.end() && m_is_valid;
        ++prop_iter) {
-    if (!STLContains(m_seen_properties, prop_iter->first)) {
+    if (!m_seen[prop_iter->property]) {
       continue;
     }
 
-    StringSet::const_iterator iter = prop_iter->second.begin();
-    for (; iter != prop_iter->second.end(); ++iter) {
-      if (!STLContains(m_seen_properties, *iter)) {
+    iter = prop_iter->required.begin();
+    for (; iter != prop_iter->required.end(); ++iter) {
+      if (!m_seen[*iter]) {
         m_is_valid = false;
         break;
       }
@@ -364,13 +369,13 @@ void ObjectValidator::Visit(const JsonObject &obj) {
   }
 
   // Check Schema Dependencies
-  SchemaDependencies::const_iterator schema_iter =
-    m_schema_dependencies.begin();
-  for (; schema_iter != m_schema_dependencies.end() && m_is_valid;
+  vector<SchemaDependency>::const_iterator schema_iter =
+    m_flat_schema_dependencies.begin();
+  for (; schema_iter != m_flat_schema_dependencies.end() && m_is_valid;
        ++schema_iter) {
-    if (STLContains(m_seen_properties, schema_iter->first)) {
-      obj.Accept(schema_iter->second);
-      if (!schema_iter->second->IsValid()) {
+    if (m_seen[schema_iter->property]) {
+      obj.Accept(schema_iter->validator);
+      if (!schema_iter->validator->IsValid()) {
         m_is_valid = false;
         break;
       }
@@ -380,11 +385,15 @@ void ObjectValidator::Visit(const JsonObject &obj) {
 
 void ObjectValidator::VisitProperty(const std::string &property,
                                     const JsonValue &value) {
-  m_seen_properties.insert(property);
-
-  // The algorithm is described in section 8.3.3
-  ValidatorInterface *validator = STLFindOrNull(
-      m_property_validators, property);
+  ValidatorInterface *validator = NULL;
+  PropertyTable::const_iterator iter = m_properties.find(property);
+  if (iter != m_properties.end()) {
+    if (iter->second.seen_index != NOT_TRACKED) {
+      m_seen[iter->second.seen_index] = true;
+    }
+    // The algorithm is described in section 8.3.3
+    validator = iter->second.validator;
+  }
 
   // patternProperties would be added here if supported
 
@@ -405,6 +414,55 @@ void ObjectValidator::VisitProperty(const std::string &property,
   }
 }
 
+void ObjectValidator::Prepare() {
+  m_properties.clear();
+  m_required_properties.clear();
+  m_flat_property_dependencies.clear();
+  m_flat_schema_dependencies.clear();
+  m_seen.clear();
+
+  PropertyValidators::const_iterator validator_iter =
+    m_property_validators.begin();
+  for (; validator_iter != m_property_validators.end(); ++validator_iter) {
+    m_properties[validator_iter->first].validator = validator_iter->second;
+  }
+
+  StringSet::const_iterator iter = m_options.required_properties.begin();
+  for (; iter != m_options.required_properties.end(); ++iter) {
+    m_required_properties.push_back(SeenIndex(*iter));
+  }
+
+  PropertyDependencies::const_iterator prop_iter =
+    m_property_dependencies.begin();
+  for (; prop_iter != m_property_dependencies.end(); ++prop_iter) {
+    PropertyDependency dependency;
+    dependency.property = SeenIndex(prop_iter->first);
+    for (iter = prop_iter->second.begin(); iter != prop_iter->second.end();
+         ++iter) {
+      dependency.required.push_back(SeenIndex(*iter));
+    }
+    m_flat_property_dependencies.push_back(dependency);
+  }
+
+  SchemaDependencies::const_iterator schema_iter =
+    m_schema_dependencies.begin();
+  for (; schema_iter != m_schema_dependencies.end(); ++schema_iter) {
+    SchemaDependency dependency = {SeenIndex(schema_iter->first),
+                                   schema_iter->second};
+    m_flat_schema_dependencies.push_back(dependency);
+  }
+  m_prepared = true;
+}
+
+unsigned int ObjectValidator::SeenIndex(const string &property) {
+  PropertyInfo &info = m_properties[property];
+  if (info.seen_index == NOT_TRACKED) {
+    info.seen_index = m_seen.size();
+    m_seen.push_back(false);
+  }
+  return info.seen_index;
+}
+
 void ObjectValidator::ExtendSchema(JsonObject *schema) const {
   if (m_options.min_properties > 0) {
     schema->Add("minProperties", m_options.min_properties);
@@ -467,7 +525,35 @@ ArrayValidator::ArrayValidator(Items *items, AdditionalItems *additional_items,
     m_items(items),
     m_additional_items(additional_items),
     m_options(options),
-    m_wildcard_validator(new WildcardValidator()) {
+    m_wildcard_validator(new WildcardValidator()),
+    m_default_validator(NULL) {
+  if (m_items.get()) {
+    if (m_items->Validator()) {
+      // 8.2.3.1, items is an object.
+      m_default_validator = m_items->Validator();
+    } else {
+      // 8.2.3.3, items is an array.
+      m_element_validators = m_items->Validators();
+
+      // Check to see if additionalItems it defined.
+      if (m_additional_items.get()) {
+        if (m_additional_items->Validator()) {
+          // additionalItems is an object
+          m_default_validator = m_additional_items->Validator();
+        } else if (m_additional_items->AllowAdditional()) {
+          // additionalItems is a bool, and true
+          m_default_validator = m_wildcard_validator.get();
+        }
+      } else {
+        // additionalItems not provided, so it defaults to the empty schema
+        // (wildcard).
+        m_default_validator = m_wildcard_validator.get();
+      }
+    }
+  } else {
+    // no items, therefore it defaults to the empty (wildcard) schema.
+    m_default_validator = m_wildcard_validator.get();
+  }
 }
 
 ArrayValidator::~ArrayValidator() {}
@@ -490,20 +576,21 @@ void ArrayValidator::Visit(const JsonArray &array) {
     return;
   }
 
-
-  auto_ptr<ArrayElementValidator> element_validator(
-      ConstructElementValidator());
-
   for (unsigned int i = 0; i < array.Size(); i++) {
-    array.ElementAt(i)->Accept(element_validator.get());
-    if (!element_validator->IsValid()) {
-      break;
+    ValidatorInterface *validator = i < m_element_validators.size() ?
+        m_element_validators[i] : m_default_validator;
+    if (!validator) {
+      // additional items aren't allowed
+      m_is_valid = false;
+      return;
+    }
+    array.ElementAt(i)->Accept(validator);
+    if (!validator->IsValid()) {
+      m_is_valid = false;
+      return;
     }
   }
-  m_is_valid = element_validator->IsValid();
-  if (!m_is_valid) {
-    return;
-  }
+  m_is_valid = true;
 
   if (m_options.unique_items) {
     for (unsigned int i = 0; i < array.Size(); i++) {
@@ -561,118 +648,6 @@ void ArrayValidator::ExtendSchema(JsonObject *schema) const {
   }
 }
 
-// TODO(simon): do this once at construction, rather than on every visit?
-ArrayValidator::ArrayElementValidator*
-    ArrayValidator::ConstructElementValidator() const {
-  if (m_items.get()) {
-    if (m_items->Validator()) {
-      // 8.2.3.1, items is an object.
-      ValidatorList empty_validators;
-      return new ArrayElementValidator(empty_validators, m_items->Validator());
-    } else {
-      // 8.2.3.3, items is an array.
-      const ValidatorList &validators = m_items->Validators();
-      ValidatorInterface *default_validator = NULL;
-
-      // Check to see if additionalItems it defined.
-      if (m_additional_items.get()) {
-        if (m_additional_items->Validator()) {
-          // additionalItems is an object
-          default_validator = m_additional_items->Validator();
-        } else if (m_additional_items->AllowAdditional()) {
-          // additionalItems is a bool, and true
-          default_validator = m_wildcard_validator.get();
-        }
-      } else {
-        // additionalItems not provided, so it defaults to the empty schema
-        // (wildcard).
-        default_validator = m_wildcard_validator.get();
-      }
-      return new ArrayElementValidator(validators, default_validator);
-    }
-  } else {
-    // no items, therefore it defaults to the empty (wildcard) schema.
-    ValidatorList empty_validators;
-    return new ArrayElementValidator(
-        empty_validators, m_wildcard_validator.get());
-  }
-}
-
-// ArrayValidator::ArrayElementValidator
-// -----------------------------------------------------------------------------
-ArrayValidator::ArrayElementValidator::ArrayElementValidator(
-    const ValidatorList &validators,
-    ValidatorInterface *default_validator)
-    : BaseValidator(JSON_UNDEFINED),
-      m_item_validators(validators.begin(), validators.end()),
-      m_default_validator(default_validator) {
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(
-    const JsonString &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonBool &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonNull &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonRawValue &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonObject &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonArray &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonUInt &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(
-    const JsonUInt64 &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonInt &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(const JsonInt64 &value) {
-  ValidateItem(value);
-}
-
-void ArrayValidator::ArrayElementValidator::Visit(
-    const JsonDouble &value) {
-  ValidateItem(value);
-}
-
-template <typename T>
-void ArrayValidator::ArrayElementValidator::ValidateItem(const T &item) {
-  ValidatorInterface *validator = NULL;
-
-  if (!m_item_validators.empty()) {
-    validator = m_item_validators.front();
-    m_item_validators.pop_front();
-  } else if (!m_default_validator) {
-    // additional items aren't allowed
-    m_is_valid = false;
-    return;
-  } else {
-    validator = m_default_validator;
-  }
-  item.Accept(validator);
-  m_is_valid = validator->IsValid();
-}
-
 // ConjunctionValidator
 // -----------------------------------------------------------------------------
 ConjunctionValidator::ConjunctionValidator(const string &keyword,
@@ -27,7 +27,7 @@
 #include "ola/web/JsonSections.h"
 #include "ola/Logging.h"
 #include "ola/web/Json.h"
-#include "ola/web/JsonWriter.h"
+#include "ola/web/JsonStreamWriter.h"
 #include "ola/StringUtils.h"
 
 
@@ -118,20 +118,32 @@ void JsonSection::AddItem(const GenericItem *item) {
  * Return the section as a string.
  */
 string JsonSection::AsString() const {
-  JsonObject json;
+  string output;
+  JsonStreamWriter writer(&output);
+  Write(&writer);
+  return output;
+}
 
-  json.Add("refresh", m_allow_refresh);
-  json.Add("error", m_error);
-  if (!m_save_button_text.empty())
-    json.Add("save_button", m_save_button_text);
 
-  JsonArray *items = json.AddArray("items");
+/*
+ * Write the section to a JsonStreamWriter.
+ */
+void JsonSection::Write(JsonStreamWriter *writer) const {
+  // In the same order as a JsonObject would write them.
+  writer->StartObject();
+  writer->Add("error", m_error);
+  writer->StartArray("items");
   vector<const GenericItem*>::const_iterator iter = m_items.begin();
   for (; iter != m_items.end(); ++iter) {
-    JsonObject *item = items->AppendObject();
-    (*iter)->PopulateItem(item);
+    JsonObject item;
+    (*iter)->PopulateItem(&item);
+    writer->Value(item);
   }
-  return JsonWriter::AsString(json);
+  writer->EndArray();
+  writer->Add("refresh", m_allow_refresh);
+  if (!m_save_button_text.empty())
+    writer->Add("save_button", m_save_button_text);
+  writer->EndObject();
 }
 }  // namespace web
 }  // namespace ola
@@ -0,0 +1,340 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * JsonStreamWriter.cpp
+ * Write JSON text without building a tree of JsonValues.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string>
+#include "ola/Logging.h"
+#include "ola/web/Json.h"
+#include "ola/web/JsonStreamWriter.h"
+
+namespace ola {
+namespace web {
+
+using std::string;
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+/*
+ * Replays a tree of JsonValues into a JsonStreamWriter.
+ */
+class TreeWriter : public JsonValueConstVisitorInterface,
+                   public JsonObjectPropertyVisitor {
+ public:
+  explicit TreeWriter(JsonStreamWriter *writer) : m_writer(writer) {}
+
+  void Visit(const JsonString &value) { m_writer->Value(value.Value()); }
+  void Visit(const JsonBool &value) { m_writer->Value(value.Value()); }
+  void Visit(const JsonNull &) { m_writer->Null(); }
+  void Visit(const JsonRawValue &value) { m_writer->Raw(value.Value()); }
+  void Visit(const JsonUInt &value) { m_writer->Value(value.Value()); }
+  void Visit(const JsonUInt64 &value) { m_writer->Value(value.Value()); }
+  void Visit(const JsonInt &value) { m_writer->Value(value.Value()); }
+  void Visit(const JsonInt64 &value) { m_writer->Value(value.Value()); }
+  // Keep the original representation of parsed numbers.
+  void Visit(const JsonDouble &value) { m_writer->Raw(value.ToString()); }
+
+  void Visit(const JsonObject &value) {
+    m_writer->StartObject();
+    value.VisitProperties(this);
+    m_writer->EndObject();
+  }
+
+  void Visit(const JsonArray &value) {
+    m_writer->StartArray();
+    for (unsigned int i = 0; i < value.Size(); i++) {
+      value.ElementAt(i)->Accept(this);
+    }
+    m_writer->EndArray();
+  }
+
+  void VisitProperty(const string &property, const JsonValue &value) {
+    m_writer->Key(property);
+    value.Accept(this);
+  }
+
+ private:
+  JsonStreamWriter *m_writer;
+};
+}  // namespace
+
+const unsigned int JsonStreamWriter::DEFAULT_INDENT;
+
+JsonStreamWriter::JsonStreamWriter(string *output)
+    : m_output(output),
+      m_indent(0) {
+}
+
+void JsonStreamWriter::Key(const string &key) {
+  if (m_scopes.empty() || !m_scopes.back().is_object) {
+    OLA_WARN << "JSON key " << key << " outside of an object";
+    return;
+  }
+
+  Scope &scope = m_scopes.back();
+  m_output->append(scope.has_values ? ",\n" : "\n");
+  scope.has_values = true;
+  AppendIndent();
+  AppendKey(key);
+  m_output->append(": ");
+}
+
+void JsonStreamWriter::StartObject() {
+  StartValue(true);
+  m_output->push_back('{');
+  Scope scope = {true, false, false};
+  m_scopes.push_back(scope);
+  m_indent += DEFAULT_INDENT;
+}
+
+void JsonStreamWriter::StartObject(const string &key) {
+  Key(key);
+  StartObject();
+}
+
+void JsonStreamWriter::EndObject() {
+  if (m_scopes.empty() || !m_scopes.back().is_object) {
+    OLA_WARN << "EndObject() called outside of an object";
+    return;
+  }
+
+  m_indent -= DEFAULT_INDENT;
+  if (m_scopes.back().has_values) {
+    m_output->push_back('\n');
+    AppendIndent();
+  }
+  m_output->push_back('}');
+  m_scopes.pop_back();
+}
+
+void JsonStreamWriter::StartArray() {
+  StartValue(true);
+  m_output->push_back('[');
+  Scope scope = {false, false, false};
+  m_scopes.push_back(scope);
+}
+
+void JsonStreamWriter::StartArray(const string &key) {
+  Key(key);
+  StartArray();
+}
+
+void JsonStreamWriter::EndArray() {
+  if (m_scopes.empty() || m_scopes.back().is_object) {
+    OLA_WARN << "EndArray() called outside of an array";
+    return;
+  }
+
+  if (m_scopes.back().one_per_line) {
+    m_output->push_back('\n');
+    m_indent -= DEFAULT_INDENT;
+    AppendIndent();
+  }
+  m_output->push_back(']');
+  m_scopes.pop_back();
+}
+
+void JsonStreamWriter::Value(const string &value) {
+  StartValue(false);
+  AppendString(value);
+}
+
+void JsonStreamWriter::Value(const char *value) {
+  StartValue(false);
+  AppendString(value);
+}
+
+void JsonStreamWriter::Value(unsigned int value) {
+  StartValue(false);
+  AppendUInt(value);
+}
+
+void JsonStreamWriter::Value(int value) {
+  StartValue(false);
+  if (value < 0) {
+    m_output->push_back('-');
+    // Negate as unsigned so INT_MIN works.
+    AppendUInt(0u - static_cast<unsigned int>(value));
+  } else {
+    AppendUInt(static_cast<unsigned int>(value));
+  }
+}
+
+void JsonStreamWriter::Value(uint64_t value) {
+  StartValue(false);
+  AppendUInt(value);
+}
+
+void JsonStreamWriter::Value(int64_t value) {
+  StartValue(false);
+  if (value < 0) {
+    m_output->push_back('-');
+    AppendUInt(0u - static_cast<uint64_t>(value));
+  } else {
+    AppendUInt(static_cast<uint64_t>(value));
+  }
+}
+
+void JsonStreamWriter::Value(double value) {
+  StartValue(false);
+  // The same as the default ostream formatting JsonDouble uses.
+  char buffer[32];
+  int length = snprintf(buffer, sizeof(buffer), "%g", value);
+  m_output->append(buffer, length);
+}
+
+void JsonStreamWriter::Value(bool value) {
+  StartValue(false);
+  m_output->append(value ? "true" : "false");
+}
+
+void JsonStreamWriter::Value(const JsonValue &value) {
+  TreeWriter writer(this);
+  value.Accept(&writer);
+}
+
+void JsonStreamWriter::Null() {
+  StartValue(false);
+  m_output->append("null");
+}
+
+void JsonStreamWriter::Raw(const string &value) {
+  StartValue(false);
+  m_output->append(value);
+}
+
+/*
+ * Write the separator needed before a value.
+ */
+void JsonStreamWriter::StartValue(bool is_container) {
+  if (m_scopes.empty() || m_scopes.back().is_object) {
+    // Key() has already written the separator.
+    return;
+  }
+
+  Scope &scope = m_scopes.back();
+  if (!scope.has_values) {
+    // The first element decides how the array is laid out.
+    scope.has_values = true;
+    scope.one_per_line = is_container;
+    if (is_container) {
+      m_indent += DEFAULT_INDENT;
+      m_output->push_back('\n');
+      AppendIndent();
+    }
+  } else if (scope.one_per_line) {
+    m_output->append(",\n");
+    AppendIndent();
+  } else {
+    m_output->append(", ");
+  }
+}
+
+void JsonStreamWriter::AppendIndent() {
+  m_output->append(m_indent, ' ');
+}
+
+void JsonStreamWriter::AppendUInt(uint64_t value) {
+  char buffer[20];
+  char *end = buffer + sizeof(buffer);
+  char *ptr = end;
+  do {
+    *--ptr = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value);
+  m_output->append(ptr, end - ptr);
+}
+
+/*
+ * This matches EscapeString(EncodeString(value)), which JsonWriter uses.
+ */
+void JsonStreamWriter::AppendString(const string &value) {
+  m_output->push_back('"');
+  string::const_iterator start = value.begin();
+  string::const_iterator iter = value.begin();
+  for (; iter != value.end(); ++iter) {
+    char c = *iter;
+    bool printable = isprint(c);
+    if (printable && c != '"' && c != '\\' && c != '/') {
+      continue;
+    }
+
+    m_output->append(start, iter);
+    start = iter + 1;
+    m_output->push_back('\\');
+    if (printable) {
+      m_output->push_back(c);
+    } else {
+      // EncodeString() turns it into \x.., then the \ is escaped.
+      uint8_t byte = static_cast<uint8_t>(c);
+      m_output->append("\\x");
+      m_output->push_back(HEX_DIGITS[byte >> 4]);
+      m_output->push_back(HEX_DIGITS[byte & 0x0f]);
+    }
+  }
+  m_output->append(start, value.end());
+  m_output->push_back('"');
+}
+
+/*
+ * This matches EscapeString(key), which JsonWriter uses for keys.
+ */
+void JsonStreamWriter::AppendKey(const string &key) {
+  m_output->push_back('"');
+  string::const_iterator start = key.begin();
+  string::const_iterator iter = key.begin();
+  for (; iter != key.end(); ++iter) {
+    char escaped;
+    switch (*iter) {
+      case '"':
+      case '\\':
+      case '/':
+        escaped = *iter;
+        break;
+      case '\b':
+        escaped = 'b';
+        break;
+      case '\f':
+        escaped = 'f';
+        break;
+      case '\n':
+        escaped = 'n';
+        break;
+      case '\r':
+        escaped = 'r';
+        break;
+      case '\t':
+        escaped = 't';
+        break;
+      default:
+        continue;
+    }
+    m_output->append(start, iter);
+    start = iter + 1;
+    m_output->push_back('\\');
+    m_output->push_back(escaped);
+  }
+  m_output->append(start, key.end());
+  m_output->push_back('"');
+}
+}  // namespace web
+}  // namespace ola
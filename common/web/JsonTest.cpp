@@ -19,6 +19,7 @@
  */
 
 #include <cppunit/extensions/HelperMacros.h>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <vector>
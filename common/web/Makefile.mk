@@ -26,6 +26,7 @@ common_web_libolaweb_la_SOURCES = \
     common/web/JsonPointer.cpp \
     common/web/JsonSchema.cpp \
     common/web/JsonSections.cpp \
+    common/web/JsonStreamWriter.cpp \
     common/web/JsonTypes.cpp \
     common/web/JsonWriter.cpp \
     common/web/PointerTracker.cpp \
@@ -44,6 +45,24 @@ if USING_WIN32
 common_web_libolaweb_la_LIBADD = common/libolacommon.la
 endif
 
+# PROGRAMS
+################################################
+noinst_PROGRAMS += \
+    common/web/json_parser_benchmark \
+    common/web/json_writer_benchmark
+
+common_web_json_parser_benchmark_SOURCES = \
+    common/web/json_parser_benchmark.cpp
+common_web_json_parser_benchmark_CXXFLAGS = $(COMMON_CXXFLAGS)
+common_web_json_parser_benchmark_LDADD = common/web/libolaweb.la \
+                                         common/libolacommon.la
+
+common_web_json_writer_benchmark_SOURCES = \
+    common/web/json_writer_benchmark.cpp
+common_web_json_writer_benchmark_CXXFLAGS = $(COMMON_CXXFLAGS)
+common_web_json_writer_benchmark_LDADD = common/web/libolaweb.la \
+                                         common/libolacommon.la
+
 # TESTS
 ################################################
 # Patch test names are abbreviated to prevent Windows' UAC from blocking them.
@@ -56,7 +75,8 @@ test_programs += \
     common/web/PointerTrackerTester \
     common/web/SchemaParserTester \
     common/web/SchemaTester \
-    common/web/SectionsTester
+    common/web/SectionsTester \
+    common/web/StreamWriterTester
 
 COMMON_WEB_TEST_LDADD = $(COMMON_TESTING_LIBS) \
                         common/web/libolaweb.la
@@ -96,3 +116,7 @@ common_web_SchemaTester_LDADD = $(COMMON_WEB_TEST_LDADD)
 common_web_SectionsTester_SOURCES = common/web/SectionsTest.cpp
 common_web_SectionsTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
 common_web_SectionsTester_LDADD = $(COMMON_WEB_TEST_LDADD)
+
+common_web_StreamWriterTester_SOURCES = common/web/StreamWriterTest.cpp
+common_web_StreamWriterTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
+common_web_StreamWriterTester_LDADD = $(COMMON_WEB_TEST_LDADD)
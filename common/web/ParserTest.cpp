@@ -20,6 +20,7 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include "ola/web/Json.h"
@@ -30,11 +31,13 @@
 
 using ola::web::JsonArray;
 using ola::web::JsonBool;
+using ola::web::JsonDouble;
 using ola::web::JsonInt;
 using ola::web::JsonLexer;
 using ola::web::JsonNull;
 using ola::web::JsonObject;
 using ola::web::JsonParser;
+using ola::web::JsonParserInterface;
 using ola::web::JsonString;
 using ola::web::JsonUInt;
 using ola::web::JsonValue;
@@ -52,6 +55,7 @@ class JsonParserTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testObject);
   CPPUNIT_TEST(testInvalidInput);
   CPPUNIT_TEST(testStressTests);
+  CPPUNIT_TEST(testLexerBufferReuse);
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -63,6 +67,39 @@ class JsonParserTest: public CppUnit::TestFixture {
     void testObject();
     void testInvalidInput();
     void testStressTests();
+    void testLexerBufferReuse();
+};
+
+
+/**
+ * Records the events from the lexer as a string.
+ */
+class RecordingParser : public JsonParserInterface {
+ public:
+  void Begin() { m_events.str(""); }
+  void End() {}
+  void String(const string &value) { m_events << "'" << value << "' "; }
+  void Number(uint32_t value) { m_events << value << " "; }
+  void Number(int32_t value) { m_events << value << " "; }
+  void Number(uint64_t value) { m_events << value << " "; }
+  void Number(int64_t value) { m_events << value << " "; }
+  void Number(const JsonDouble::DoubleRepresentation &) {
+    m_events << "double ";
+  }
+  void Number(double) { m_events << "double "; }
+  void Bool(bool value) { m_events << (value ? "true " : "false "); }
+  void Null() { m_events << "null "; }
+  void OpenArray() { m_events << "[ "; }
+  void CloseArray() { m_events << "] "; }
+  void OpenObject() { m_events << "{ "; }
+  void ObjectKey(const string &key) { m_events << key << ": "; }
+  void CloseObject() { m_events << "} "; }
+  void SetError(const string &error) { m_events << "error " << error; }
+
+  string Events() const { return m_events.str(); }
+
+ private:
+  std::ostringstream m_events;
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(JsonParserTest);
@@ -601,3 +638,53 @@ void JsonParserTest::testStressTests() {
   value.reset(JsonParser::Parse("{ a]b:123}", &error));
   OLA_ASSERT_NULL(value.get());
 }
+
+/**
+ * The lexer extracts every key and string value into the same buffer. Check
+ * each one is passed on intact when long and short strings, keys and values
+ * interleave at different depths.
+ */
+void JsonParserTest::testLexerBufferReuse() {
+  const string input =
+    "{\"a long key at the top level\": \"v\", "
+    "\"b\": {\"nested key\": \"a much longer string value\", "
+    "\"k\": \"\", \"esc\\\"aped\": \"x\\ny\", "
+    "\"deeper\": {\"z\": [\"first element\", {\"d\": \"e\"}, 1]}}, "
+    "\"\": \"empty key\", \"last\": \"s\"}";
+
+  RecordingParser recorder;
+  OLA_ASSERT_TRUE(JsonLexer::Parse(input, &recorder));
+  OLA_ASSERT_EQ(
+      string("{ a long key at the top level: 'v' "
+             "b: { nested key: 'a much longer string value' k: '' "
+             "esc\"aped: 'x\ny' "
+             "deeper: { z: [ 'first element' { d: 'e' } 1 ] } } "
+             ": 'empty key' last: 's' } "),
+      recorder.Events());
+
+  // The tree should be the same.
+  string error;
+  auto_ptr<const JsonValue> value(JsonParser::Parse(input, &error));
+  OLA_ASSERT_NOT_NULL(value.get());
+  OLA_ASSERT_EQ(
+      string("{\n"
+             "  \"\": \"empty key\",\n"
+             "  \"a long key at the top level\": \"v\",\n"
+             "  \"b\": {\n"
+             "    \"deeper\": {\n"
+             "      \"z\": [\n"
+             "        \"first element\",\n"
+             "        {\n"
+             "          \"d\": \"e\"\n"
+             "        },\n"
+             "        1\n"
+             "      ]\n"
+             "    },\n"
+             "    \"esc\\\"aped\": \"x\\\\x0ay\",\n"
+             "    \"k\": \"\",\n"
+             "    \"nested key\": \"a much longer string value\"\n"
+             "  },\n"
+             "  \"last\": \"s\"\n"
+             "}"),
+      JsonWriter::AsString(*value.get()));
+}
@@ -25,6 +25,7 @@
 #include <memory>
 #include <stack>
 #include <string>
+#include <vector>
 
 #include "common/web/PointerTracker.h"
 #include "common/web/SchemaErrorLogger.h"
@@ -108,7 +109,8 @@ class SchemaParser : public JsonParserInterface {
 
   std::auto_ptr<ValidatorInterface> m_root_validator;
 
-  std::stack<class SchemaParseContextInterface*> m_context_stack;
+  std::stack<class SchemaParseContextInterface*,
+             std::vector<class SchemaParseContextInterface*> > m_context_stack;
   JsonPointer m_pointer;
   PointerTracker m_pointer_tracker;
   SchemaErrorLogger m_error_logger;
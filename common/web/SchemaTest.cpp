@@ -539,6 +539,13 @@ void JsonSchemaTest::testObjectValidator() {
   object4->Accept(&property_validator);
   OLA_ASSERT_FALSE(property_validator.IsValid());
 
+  // Validators added after an object has been checked are used as well.
+  property_validator.AddValidator("c", new BoolValidator());
+  object3->Accept(&property_validator);
+  OLA_ASSERT_FALSE(property_validator.IsValid());
+  object5->Accept(&property_validator);
+  OLA_ASSERT_TRUE(property_validator.IsValid());
+
   // Now check a is also an int, and prevent any other properties
   ObjectValidator::Options no_additional_properties_options;
   no_additional_properties_options.SetAdditionalProperties(false);
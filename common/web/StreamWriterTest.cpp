@@ -0,0 +1,272 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * StreamWriterTest.cpp
+ * Unittest for the JsonStreamWriter.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <limits>
+#include <string>
+
+#include "ola/testing/TestUtils.h"
+#include "ola/web/Json.h"
+#include "ola/web/JsonStreamWriter.h"
+#include "ola/web/JsonWriter.h"
+
+using ola::web::JsonArray;
+using ola::web::JsonObject;
+using ola::web::JsonStreamWriter;
+using ola::web::JsonValue;
+using ola::web::JsonWriter;
+using std::string;
+
+class StreamWriterTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(StreamWriterTest);
+  CPPUNIT_TEST(testScalars);
+  CPPUNIT_TEST(testStrings);
+  CPPUNIT_TEST(testSimpleArray);
+  CPPUNIT_TEST(testObjects);
+  CPPUNIT_TEST(testNesting);
+  CPPUNIT_TEST(testTree);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void testScalars();
+  void testStrings();
+  void testSimpleArray();
+  void testObjects();
+  void testNesting();
+  void testTree();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StreamWriterTest);
+
+
+/*
+ * Test numbers, bools & null.
+ */
+void StreamWriterTest::testScalars() {
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.StartArray();
+  writer.Value(0u);
+  writer.Value(42);
+  writer.Value(-42);
+  writer.Value(std::numeric_limits<int>::min());
+  writer.Value(std::numeric_limits<unsigned int>::max());
+  writer.Value(std::numeric_limits<uint64_t>::max());
+  writer.Value(std::numeric_limits<int64_t>::min());
+  writer.Value(1.5);
+  writer.Value(-0.25);
+  writer.Value(true);
+  writer.Value(false);
+  writer.Null();
+  writer.Raw("[1,2]");
+  writer.EndArray();
+
+  OLA_ASSERT_EQ(
+      string("[0, 42, -42, -2147483648, 4294967295, 18446744073709551615, "
+             "-9223372036854775808, 1.5, -0.25, true, false, null, [1,2]]"),
+      output);
+
+  // Doubles are formatted like JsonDouble.
+  JsonArray array;
+  array.AppendValue(new ola::web::JsonDouble(1e9));
+  array.AppendValue(new ola::web::JsonDouble(3.14159265));
+  output.clear();
+  writer.Value(1e9);
+  output.append(", ");
+  writer.Value(3.14159265);
+  OLA_ASSERT_EQ(JsonWriter::AsString(array), "[" + output + "]");
+}
+
+
+/*
+ * Test strings are escaped the same way JsonWriter does.
+ */
+void StreamWriterTest::testStrings() {
+  const string values[] = {
+    "",
+    "foo",
+    "with \"quotes\"",
+    "back\\slash / slash",
+    "new\nline\ttab",
+    "\x01\x7f\xc3\xa9",
+  };
+
+  for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    ola::web::JsonString tree_value(values[i]);
+    string output;
+    JsonStreamWriter writer(&output);
+    writer.Value(values[i]);
+    OLA_ASSERT_EQ(JsonWriter::AsString(tree_value), output);
+  }
+
+  // Keys are only escaped.
+  JsonObject object;
+  object.Add("a\"b\n", 1);
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.StartObject();
+  writer.Add("a\"b\n", 1);
+  writer.EndObject();
+  OLA_ASSERT_EQ(JsonWriter::AsString(object), output);
+}
+
+
+/*
+ * Test arrays of simple values are written on one line.
+ */
+void StreamWriterTest::testSimpleArray() {
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.StartArray();
+  writer.EndArray();
+  OLA_ASSERT_EQ(string("[]"), output);
+
+  JsonArray array;
+  array.Append(1);
+  array.Append("foo");
+  array.Append(true);
+
+  output.clear();
+  writer.StartArray();
+  writer.Value(1);
+  writer.Value("foo");
+  writer.Value(true);
+  writer.EndArray();
+  OLA_ASSERT_EQ(JsonWriter::AsString(array), output);
+}
+
+
+/*
+ * Test objects, with the keys in sorted order so they match JsonObject.
+ */
+void StreamWriterTest::testObjects() {
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.StartObject();
+  writer.EndObject();
+  OLA_ASSERT_EQ(string("{}"), output);
+
+  JsonObject object;
+  object.Add("age", 10);
+  object.Add("name", "simon");
+  object.Add("nothing");
+  object.AddRaw("raw", "[]");
+  object.Add("ok", true);
+
+  output.clear();
+  writer.StartObject();
+  writer.Add("age", 10);
+  writer.Add("name", "simon");
+  writer.Add("nothing");
+  writer.Add("ok", true);
+  writer.AddRaw("raw", "[]");
+  writer.EndObject();
+  OLA_ASSERT_EQ(JsonWriter::AsString(object), output);
+}
+
+
+/*
+ * Test the indentation of nested objects & arrays.
+ */
+void StreamWriterTest::testNesting() {
+  JsonObject object;
+  object.Add("id", 1);
+  JsonArray *ports = object.AddArray("ports");
+  JsonObject *port = ports->AppendObject();
+  port->Add("id", "1-I-0");
+  port->AddObject("priority");
+  port = ports->AppendObject();
+  port->Add("id", "1-O-0");
+  JsonObject *priority = port->AddObject("priority");
+  priority->Add("value", 100);
+  JsonArray *matrix = object.AddArray("matrix");
+  matrix->AppendArray()->Append(1);
+  JsonArray *row = matrix->AppendArray();
+  row->Append(2);
+  row->Append(3);
+  object.AddArray("none");
+
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.StartObject();
+  writer.Add("id", 1);
+  writer.StartArray("matrix");
+  writer.StartArray();
+  writer.Value(1);
+  writer.EndArray();
+  writer.StartArray();
+  writer.Value(2);
+  writer.Value(3);
+  writer.EndArray();
+  writer.EndArray();
+  writer.StartArray("none");
+  writer.EndArray();
+  writer.StartArray("ports");
+  writer.StartObject();
+  writer.Add("id", "1-I-0");
+  writer.StartObject("priority");
+  writer.EndObject();
+  writer.EndObject();
+  writer.StartObject();
+  writer.Add("id", "1-O-0");
+  writer.StartObject("priority");
+  writer.Add("value", 100);
+  writer.EndObject();
+  writer.EndObject();
+  writer.EndArray();
+  writer.EndObject();
+
+  OLA_ASSERT_EQ(JsonWriter::AsString(object), output);
+}
+
+
+/*
+ * Test writing an existing JsonValue.
+ */
+void StreamWriterTest::testTree() {
+  JsonObject object;
+  object.Add("name", "foo");
+  JsonArray *values = object.AddArray("values");
+  values->Append(1);
+  values->Append(2);
+  JsonObject *child = object.AddObject("child");
+  child->Add("ok", false);
+  values = child->AddArray("list");
+  values->AppendObject()->Add("x", -1);
+
+  string output;
+  JsonStreamWriter writer(&output);
+  writer.Value(object);
+  OLA_ASSERT_EQ(JsonWriter::AsString(object), output);
+
+  // And as part of a larger document.
+  JsonObject outer;
+  outer.Add("a", 1);
+  outer.AddValue("b", object.Clone());
+
+  output.clear();
+  writer.StartObject();
+  writer.Add("a", 1);
+  writer.Key("b");
+  writer.Value(object);
+  writer.EndObject();
+  OLA_ASSERT_EQ(JsonWriter::AsString(outer), output);
+}
@@ -0,0 +1,217 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * json_parser_benchmark.cpp
+ * Time parsing & validating the documents in common/web/testdata.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ola/StringUtils.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/file/Util.h"
+#include "ola/stl/STLUtils.h"
+#include "ola/testing/BenchmarkTimer.h"
+#include "ola/web/Json.h"
+#include "ola/web/JsonLexer.h"
+#include "ola/web/JsonParser.h"
+#include "ola/web/JsonSchema.h"
+
+using ola::STLDeleteElements;
+using ola::StringEndsWith;
+using ola::testing::BenchmarkTimer;
+using ola::web::JsonDouble;
+using ola::web::JsonLexer;
+using ola::web::JsonParser;
+using ola::web::JsonParserInterface;
+using ola::web::JsonSchema;
+using ola::web::JsonValue;
+using std::auto_ptr;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+DEFINE_s_string(data_dir, d, "common/web/testdata",
+                "The directory containing the test documents.");
+DEFINE_s_uint32(iterations, i, 1000,
+                "The number of times to parse each document.");
+
+/**
+ * Discards everything, so we can time the lexer by itself.
+ */
+class NullParser : public JsonParserInterface {
+ public:
+  void Begin() {}
+  void End() {}
+  void String(const string &) {}
+  void Number(uint32_t) {}
+  void Number(int32_t) {}
+  void Number(uint64_t) {}
+  void Number(int64_t) {}
+  void Number(const JsonDouble::DoubleRepresentation &) {}
+  void Number(double) {}
+  void Bool(bool) {}
+  void Null() {}
+  void OpenArray() {}
+  void CloseArray() {}
+  void OpenObject() {}
+  void ObjectKey(const string &) {}
+  void CloseObject() {}
+  void SetError(const string &) {}
+};
+
+/**
+ * Split a .test file into its documents, see SchemaParserTest.cpp.
+ */
+bool ReadTestFile(const string &path, vector<string> *documents) {
+  std::ifstream in(path.c_str(), std::ios::in);
+  if (!in.is_open()) {
+    cout << "Failed to open " << path << endl;
+    return false;
+  }
+
+  string document;
+  string line;
+  while (getline(in, line)) {
+    if (line.compare(0, 2, "//") == 0) {
+      continue;
+    } else if (line.compare(0, 3, "===") == 0 || line == "--------") {
+      if (!document.empty()) {
+        documents->push_back(document);
+      }
+      document.clear();
+    } else {
+      document.append(line);
+      document.push_back('\n');
+    }
+  }
+  if (!document.empty()) {
+    documents->push_back(document);
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Time parsing & validating the JSON documents in "
+               "common/web/testdata.");
+
+  vector<string> files;
+  if (!ola::file::ListDirectory(FLAGS_data_dir.str(), &files)) {
+    return ola::EXIT_NOINPUT;
+  }
+
+  // schema.json is in the same format as the .test files.
+  vector<string> documents;
+  vector<string>::const_iterator file_iter = files.begin();
+  for (; file_iter != files.end(); ++file_iter) {
+    const string &path = *file_iter;
+    if ((StringEndsWith(path, ".test") || StringEndsWith(path, ".json")) &&
+        !ReadTestFile(path, &documents)) {
+      return ola::EXIT_NOINPUT;
+    }
+  }
+
+  // Some of the negative schema tests aren't valid JSON, skip those.
+  vector<string> valid_documents;
+  uint64_t bytes = 0;
+  vector<string>::const_iterator iter = documents.begin();
+  for (; iter != documents.end(); ++iter) {
+    string error;
+    auto_ptr<JsonValue> value(JsonParser::Parse(*iter, &error));
+    if (value.get()) {
+      valid_documents.push_back(*iter);
+      bytes += iter->size();
+    }
+  }
+  documents.swap(valid_documents);
+  bytes *= FLAGS_iterations;
+  cout << documents.size() << " documents, "
+       << bytes / FLAGS_iterations << " bytes" << endl;
+
+  BenchmarkTimer timer;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    for (iter = documents.begin(); iter != documents.end(); ++iter) {
+      NullParser parser;
+      if (!JsonLexer::Parse(*iter, &parser)) {
+        cout << "Failed to lex " << *iter << endl;
+        return ola::EXIT_DATAERR;
+      }
+    }
+  }
+  timer.Report("Lex", bytes);
+
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    for (iter = documents.begin(); iter != documents.end(); ++iter) {
+      string error;
+      auto_ptr<JsonValue> value(JsonParser::Parse(*iter, &error));
+      if (!value.get()) {
+        cout << "Failed to parse " << *iter << ": " << error << endl;
+        return ola::EXIT_DATAERR;
+      }
+    }
+  }
+  timer.Report("Build tree", bytes);
+
+  // Some of these are invalid schemas, which is fine.
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    for (iter = documents.begin(); iter != documents.end(); ++iter) {
+      string error;
+      auto_ptr<JsonSchema> schema(JsonSchema::FromString(*iter, &error));
+    }
+  }
+  timer.Report("Parse schemas", bytes);
+
+  // Validate every document against every schema.
+  vector<JsonSchema*> schemas;
+  vector<JsonValue*> values;
+  for (iter = documents.begin(); iter != documents.end(); ++iter) {
+    string error;
+    JsonSchema *schema = JsonSchema::FromString(*iter, &error);
+    if (schema) {
+      schemas.push_back(schema);
+    }
+    values.push_back(JsonParser::Parse(*iter, &error));
+  }
+
+  unsigned int valid = 0;
+  timer.Reset();
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    valid = 0;
+    vector<JsonSchema*>::const_iterator schema_iter = schemas.begin();
+    for (; schema_iter != schemas.end(); ++schema_iter) {
+      vector<JsonValue*>::const_iterator value_iter = values.begin();
+      for (; value_iter != values.end(); ++value_iter) {
+        if ((*schema_iter)->IsValid(**value_iter)) {
+          valid++;
+        }
+      }
+    }
+  }
+  timer.Report("Validate", bytes * schemas.size());
+  cout << schemas.size() << " schemas, " << valid << " of "
+       << schemas.size() * values.size() << " documents were valid" << endl;
+  STLDeleteElements(&schemas);
+  STLDeleteElements(&values);
+  return ola::EXIT_OK;
+}
@@ -0,0 +1,173 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * json_writer_benchmark.cpp
+ * Time building the universe list of a large server with a tree of
+ * JsonValues and with the JsonStreamWriter.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/testing/BenchmarkTimer.h"
+#include "ola/web/Json.h"
+#include "ola/web/JsonStreamWriter.h"
+#include "ola/web/JsonWriter.h"
+
+using ola::testing::BenchmarkTimer;
+using ola::web::JsonArray;
+using ola::web::JsonObject;
+using ola::web::JsonStreamWriter;
+using ola::web::JsonWriter;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+DEFINE_s_uint32(universes, u, 1000, "The number of universes.");
+DEFINE_s_uint32(iterations, i, 100, "The number of responses to build.");
+
+struct Port {
+  string device;
+  string description;
+  string id;
+  bool is_output;
+  unsigned int priority;
+};
+
+struct Universe {
+  unsigned int id;
+  string name;
+  unsigned int rdm_devices;
+  vector<Port> ports;
+};
+
+/*
+ * This is what /json/universe_info returns, for every universe.
+ */
+void BuildTree(const vector<Universe> &universes, string *output) {
+  JsonObject json;
+  JsonArray *universes_json = json.AddArray("universes");
+  vector<Universe>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    JsonObject *universe = universes_json->AppendObject();
+    universe->Add("id", iter->id);
+    universe->Add("name", iter->name);
+    universe->Add("rdm_devices", iter->rdm_devices);
+    JsonArray *ports = universe->AddArray("ports");
+    vector<Port>::const_iterator port_iter = iter->ports.begin();
+    for (; port_iter != iter->ports.end(); ++port_iter) {
+      JsonObject *port = ports->AppendObject();
+      port->Add("description", port_iter->description);
+      port->Add("device", port_iter->device);
+      port->Add("id", port_iter->id);
+      port->Add("is_output", port_iter->is_output);
+      JsonObject *priority = port->AddObject("priority");
+      priority->Add("current_mode", "static");
+      priority->Add("value", port_iter->priority);
+    }
+  }
+  *output = JsonWriter::AsString(json);
+}
+
+/*
+ * The same, with the keys in the order JsonObject sorts them.
+ */
+void BuildStream(const vector<Universe> &universes, string *output) {
+  output->clear();
+  JsonStreamWriter json(output);
+  json.StartObject();
+  json.StartArray("universes");
+  vector<Universe>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    json.StartObject();
+    json.Add("id", iter->id);
+    json.Add("name", iter->name);
+    json.StartArray("ports");
+    vector<Port>::const_iterator port_iter = iter->ports.begin();
+    for (; port_iter != iter->ports.end(); ++port_iter) {
+      json.StartObject();
+      json.Add("description", port_iter->description);
+      json.Add("device", port_iter->device);
+      json.Add("id", port_iter->id);
+      json.Add("is_output", port_iter->is_output);
+      json.StartObject("priority");
+      json.Add("current_mode", "static");
+      json.Add("value", port_iter->priority);
+      json.EndObject();
+      json.EndObject();
+    }
+    json.EndArray();
+    json.Add("rdm_devices", iter->rdm_devices);
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+}
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Compare building JSON with JsonWriter & JsonStreamWriter.");
+
+  vector<Universe> universes(FLAGS_universes);
+  for (unsigned int i = 0; i < universes.size(); i++) {
+    Universe &universe = universes[i];
+    std::ostringstream name;
+    name << "Universe " << i + 1;
+    universe.id = i + 1;
+    universe.name = name.str();
+    universe.rdm_devices = i % 32;
+    for (unsigned int j = 0; j < 2; j++) {
+      std::ostringstream id;
+      id << "1-" << (j ? "O" : "I") << "-" << i;
+      Port port = {"Art-Net", "ArtNet Universe 0:0:0", id.str(), j == 1,
+                   100};
+      universe.ports.push_back(port);
+    }
+  }
+
+  string tree_output, stream_output;
+  BenchmarkTimer timer;
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    BuildTree(universes, &tree_output);
+  }
+  double tree_ms = timer.ElapsedMs();
+
+  timer.Reset();
+  for (unsigned int i = 0; i < FLAGS_iterations; i++) {
+    BuildStream(universes, &stream_output);
+  }
+  double stream_ms = timer.ElapsedMs();
+
+  if (tree_output != stream_output) {
+    cout << "The outputs differ!" << endl;
+    return ola::EXIT_SOFTWARE;
+  }
+
+  cout << FLAGS_universes << " universes, " << tree_output.size()
+       << " bytes per response" << endl;
+  cout << std::fixed << std::setprecision(3);
+  cout << std::setw(18) << "JsonWriter: " << tree_ms / FLAGS_iterations
+       << " ms per response" << endl;
+  cout << std::setw(18) << "JsonStreamWriter: "
+       << stream_ms / FLAGS_iterations << " ms per response" << endl;
+  return ola::EXIT_OK;
+}
@@ -6,6 +6,19 @@ dist_piddata_DATA = \
     data/rdm/manufacturer_names.proto \
     data/rdm/manufacturer_pids.proto
 
+# The compiled PIDs are built with the tools we just built, so we can't
+# generate them when cross compiling. olad falls back to the text files.
+if !CROSS_COMPILING
+nodist_piddata_DATA = data/rdm/compiled_pids.bin
+
+data/rdm/compiled_pids.bin: common/rdm/pid_store_compiler$(EXEEXT) \
+    $(dist_piddata_DATA)
+	common/rdm/pid_store_compiler$(EXEEXT) \
+	    --pid-location $(srcdir)/data/rdm --output $@
+
+CLEANFILES += data/rdm/compiled_pids.bin
+endif
+
 # SCRIPTS
 ################################################
 dist_noinst_SCRIPTS += \
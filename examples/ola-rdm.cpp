@@ -66,6 +66,7 @@ typedef struct {
   vector<string> args;  // extra args
   string cmd;  // argv[0]
   bool display_frames;  // print raw frames.
+  bool use_cache;  // allow olad to answer GETs from its cache.
 } options;
 
 
@@ -74,6 +75,7 @@ typedef struct {
  */
 void ParseOptions(int argc, char *argv[], options *opts) {
   const int FRAME_OPTION_VALUE = 256;
+  const int NO_CACHE_OPTION_VALUE = 257;
 
   opts->cmd = argv[0];
   string cmd_name = ola::file::FilenameFromPathOrPath(opts->cmd);
@@ -94,6 +96,7 @@ void ParseOptions(int argc, char *argv[], options *opts) {
   opts->uid = NULL;
   opts->sub_device = 0;
   opts->display_frames = false;
+  opts->use_cache = true;
 
   if (cmd_name == "ola_rdm_set") {
     opts->set_mode = true;
@@ -107,6 +110,7 @@ void ParseOptions(int argc, char *argv[], options *opts) {
       {"list-pids", no_argument, 0, 'l'},
       {"universe", required_argument, 0, 'u'},
       {"frames", no_argument, 0, FRAME_OPTION_VALUE},
+      {"no-cache", no_argument, 0, NO_CACHE_OPTION_VALUE},
       {"uid", required_argument, &uid_set, 1},
       {0, 0, 0, 0}
     };
@@ -142,6 +146,9 @@ void ParseOptions(int argc, char *argv[], options *opts) {
       case FRAME_OPTION_VALUE:
         opts->display_frames = true;
         break;
+      case NO_CACHE_OPTION_VALUE:
+        opts->use_cache = false;
+        break;
       default:
         break;
     }
@@ -164,6 +171,8 @@ void DisplayGetPidHelp(const options &opts) {
   "Use '" << opts.cmd << " --list-pids' to get a list of PIDs.\n"
   "\n"
   "  --frames                  display the raw RDM frames if available.\n"
+  "  --no-cache                always send the request to the device, rather\n"
+  "                            than using the value cached by olad.\n"
   "  --uid <uid>               the UID of the device to control.\n"
   "  -d, --sub-device <device> target a particular sub device (default is 0)\n"
   "  -h, --help                display this help message and exit.\n"
@@ -227,7 +236,7 @@ void DisplayPIDsAndExit(uint16_t manufacturer_id,
 
 class RDMController {
  public:
-  RDMController(string pid_location, bool show_frames);
+  RDMController(string pid_location, bool show_frames, bool use_cache);
 
   bool InitPidHelper();
   bool Setup();
@@ -263,6 +272,7 @@ class RDMController {
   };
 
   const bool m_show_frames;
+  const bool m_use_cache;
   ola::client::OlaClientWrapper m_ola_client;
   PidStoreHelper m_pid_helper;
   PendingRequest m_pending_request;
@@ -277,8 +287,10 @@ class RDMController {
 };
 
 
-RDMController::RDMController(string pid_location, bool show_frames)
+RDMController::RDMController(string pid_location, bool show_frames,
+                             bool use_cache)
     : m_show_frames(show_frames),
+      m_use_cache(use_cache),
       m_pid_helper(pid_location) {
 }
 
@@ -493,6 +505,7 @@ int RDMController::PerformRequestAndWait(unsigned int universe,
       param_data_length,
       args);
   } else {
+    args.cache_first = m_use_cache;
     m_ola_client.GetClient()->RDMGet(
       m_pending_request.universe,
       *m_pending_request.uid,
@@ -593,7 +606,8 @@ int main(int argc, char *argv[]) {
   }
   options opts;
   ParseOptions(argc, argv, &opts);
-  RDMController controller(opts.pid_location, opts.display_frames);
+  RDMController controller(opts.pid_location, opts.display_frames,
+                           opts.use_cache);
 
   if (opts.help)
     DisplayHelpAndExit(opts);
@@ -24,14 +24,22 @@
  *
  * Exported variables can be used to expose the internal state on the /debug
  * page of the webserver. This allows real time debugging and monitoring of the
- * applications.
+ * applications. The numeric variables are also served in the OpenMetrics text
+ * format on /metrics, so they can be scraped by Prometheus.
+ *
+ * Looking up a variable by name is a map lookup, so code on the hot path
+ * should keep the pointer returned by the ExportMap, rather than calling
+ * GetCounterVar() etc. each time.
  */
 
 #ifndef INCLUDE_OLA_EXPORTMAP_H_
 #define INCLUDE_OLA_EXPORTMAP_H_
 
+#include <ola/base/Atomic.h>
 #include <ola/base/Macro.h>
 #include <ola/StringUtils.h>
+#include <ola/thread/Mutex.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <functional>
@@ -73,6 +81,51 @@ class BaseVariable {
    */
   virtual const std::string Value() const = 0;
 
+  /**
+   * @brief Append the variable in the OpenMetrics text format.
+   * @param output the string to append to.
+   *
+   * Variables without a numeric value, like strings, don't append anything.
+   */
+  virtual void AppendMetrics(OLA_UNUSED std::string *output) const {}
+
+ protected:
+  /**
+   * @brief Convert a variable name to a valid metric name.
+   *
+   * Characters that aren't allowed in metric names, like -, are replaced
+   * with _.
+   */
+  static std::string MetricName(const std::string &name);
+
+  /**
+   * @brief Append the TYPE line for a metric.
+   * @param metric the metric name, from MetricName().
+   * @param type the OpenMetrics type, e.g. counter or gauge.
+   * @param output the string to append to.
+   */
+  static void AppendMetricType(const std::string &metric, const char *type,
+                               std::string *output);
+
+  /**
+   * @brief Append a single sample.
+   * @param metric the sample name.
+   * @param label the label name, or the empty string if there isn't one.
+   * @param key the value of the label.
+   * @param value the sample value.
+   * @param output the string to append to.
+   */
+  static void AppendMetricSample(const std::string &metric,
+                                 const std::string &label,
+                                 const std::string &key,
+                                 const std::string &value,
+                                 std::string *output);
+
+  /**
+   * @brief Escape a label value.
+   */
+  static std::string EscapeLabelValue(const std::string &value);
+
  private:
   std::string m_name;
 };
@@ -120,6 +173,8 @@ class BoolVariable: public BaseVariable {
    */
   const std::string Value() const { return m_value ? "1" : "0"; }
 
+  void AppendMetrics(std::string *output) const;
+
  private:
   bool m_value;
 };
@@ -145,7 +200,10 @@ class StringVariable: public BaseVariable {
 
 
 /*
- * Represents a integer variable
+ * Represents a integer variable. This is exported as a gauge.
+ *
+ * Increments and decrements are atomic, so a cached pointer can be updated
+ * from any thread.
  */
 class IntegerVariable: public BaseVariable {
  public:
@@ -155,8 +213,8 @@ class IntegerVariable: public BaseVariable {
   ~IntegerVariable() {}
 
   void Set(int value) { m_value = value; }
-  void operator++(int) { m_value++; }
-  void operator--(int) { m_value--; }
+  void operator++(int) { AtomicAdd(&m_value, 1); }
+  void operator--(int) { AtomicSubtract(&m_value, 1); }
   void Reset() { m_value = 0; }
   int Get() const { return m_value; }
   const std::string Value() const {
@@ -164,6 +222,7 @@ class IntegerVariable: public BaseVariable {
     out << m_value;
     return out.str();
   }
+  void AppendMetrics(std::string *output) const;
 
  private:
   int m_value;
@@ -172,6 +231,8 @@ class IntegerVariable: public BaseVariable {
 
 /*
  * Represents a counter which can only be added to.
+ *
+ * Updates are atomic, so a cached pointer can be updated from any thread.
  */
 class CounterVariable: public BaseVariable {
  public:
@@ -180,8 +241,8 @@ class CounterVariable: public BaseVariable {
         m_value(0) {}
   ~CounterVariable() {}
 
-  void operator++(int) { m_value++; }
-  void operator+=(unsigned int value) { m_value += value; }
+  void operator++(int) { AtomicAdd(&m_value, 1); }
+  void operator+=(unsigned int value) { AtomicAdd(&m_value, value); }
   void Reset() { m_value = 0; }
   unsigned int Get() const { return m_value; }
   const std::string Value() const {
@@ -189,6 +250,7 @@ class CounterVariable: public BaseVariable {
     out << m_value;
     return out.str();
   }
+  void AppendMetrics(std::string *output) const;
 
  private:
   unsigned int m_value;
@@ -196,7 +258,13 @@ class CounterVariable: public BaseVariable {
 
 
 /*
- * A Map variable holds string -> type mappings
+ * A Map variable holds string -> type mappings. The label is used as the
+ * OpenMetrics label name for the keys, numeric maps are exported as gauges.
+ *
+ * The map may be read from another thread, e.g. by the HTTP server. The
+ * reference returned by operator[] remains valid until the key is removed,
+ * so callers that update an entry often can hold on to it, but they must
+ * update it with AtomicAdd(), AtomicSubtract() or AtomicStore().
  */
 template<typename Type>
 class MapVariable: public BaseVariable {
@@ -211,10 +279,17 @@ class MapVariable: public BaseVariable {
   Type &operator[](const std::string &key);
   const std::string Value() const;
   const std::string Label() const { return m_label; }
+  void AppendMetrics(std::string *output) const {
+    AppendMapMetrics("gauge", "", output);
+  }
 
  protected:
+  mutable ola::thread::Mutex m_mutex;  // protects m_variables
   std::map<std::string, Type> m_variables;
 
+  void AppendMapMetrics(const char *type, const char *suffix,
+                        std::string *output) const;
+
  private:
   std::string m_label;
 };
@@ -231,7 +306,13 @@ class IntMap: public MapVariable<int> {
       : MapVariable<int>(name, label) {}
 
   void Increment(const std::string &key) {
-    m_variables[key]++;
+    ola::thread::MutexLocker locker(&m_mutex);
+    AtomicAdd(&m_variables[key], 1);
+  }
+
+  void Decrement(const std::string &key) {
+    ola::thread::MutexLocker locker(&m_mutex);
+    AtomicSubtract(&m_variables[key], 1);
   }
 };
 
@@ -245,17 +326,133 @@ class UIntMap: public MapVariable<unsigned int> {
       : MapVariable<unsigned int>(name, label) {}
 
   void Increment(const std::string &key) {
-    m_variables[key]++;
+    ola::thread::MutexLocker locker(&m_mutex);
+    AtomicAdd(&m_variables[key], 1);
+  }
+
+  void Decrement(const std::string &key) {
+    ola::thread::MutexLocker locker(&m_mutex);
+    AtomicSubtract(&m_variables[key], 1);
   }
 };
 
 
+/**
+ * A UIntMap that only goes up, this is exported as a counter.
+ */
+class CounterMap: public UIntMap {
+ public:
+  CounterMap(const std::string &name, const std::string &label)
+      : UIntMap(name, label) {}
+
+  void AppendMetrics(std::string *output) const {
+    AppendMapMetrics("counter", "_total", output);
+  }
+};
+
+
+/**
+ * @brief The buckets of a single histogram in a HistogramVariable.
+ *
+ * Observations are usually made on the main thread while the ExportMap is
+ * served from the HTTP thread, so access to the buckets is locked.
+ */
+class Histogram {
+ public:
+  /**
+   * @brief Create a new Histogram.
+   * @param bounds the upper bound of each bucket, in ascending order. This
+   *   must outlive the Histogram.
+   */
+  explicit Histogram(const std::vector<uint64_t> &bounds)
+      : m_bounds(bounds),
+        m_buckets(bounds.size() + 1, 0),
+        m_count(0),
+        m_sum(0) {}
+
+  /**
+   * @brief Record a value.
+   */
+  void Observe(uint64_t value);
+
+  /**
+   * @brief The number of values in a bucket.
+   * @param bucket the bucket index, Bounds().size() is the +Inf bucket.
+   * @returns the number of values that were greater than the bound of the
+   *   previous bucket and less than or equal to the bound of this one.
+   */
+  uint64_t BucketCount(unsigned int bucket) const;
+
+  uint64_t Count() const;
+  uint64_t Sum() const;
+  const std::vector<uint64_t> &Bounds() const { return m_bounds; }
+
+  /**
+   * @brief Copy the buckets, count and sum in a single step, so they are
+   *   consistent with each other.
+   */
+  void Snapshot(std::vector<uint64_t> *buckets, uint64_t *count,
+                uint64_t *sum) const;
+
+ private:
+  mutable ola::thread::Mutex m_mutex;
+  const std::vector<uint64_t> &m_bounds;
+  std::vector<uint64_t> m_buckets;
+  uint64_t m_count;
+  uint64_t m_sum;
+
+  DISALLOW_COPY_AND_ASSIGN(Histogram);
+};
+
+
+/**
+ * @brief A set of histograms, keyed by a label, that share bucket bounds.
+ *
+ * Use the empty string as the key for a histogram without a label. Keys may
+ * be looked up and removed from any thread.
+ */
+class HistogramVariable: public BaseVariable {
+ public:
+  HistogramVariable(const std::string &name, const std::string &label,
+                    const std::vector<uint64_t> &bounds);
+  ~HistogramVariable();
+
+  /**
+   * @brief Lookup or create the histogram for a key.
+   * @returns the Histogram, which is valid until the key is removed.
+   */
+  Histogram *Lookup(const std::string &key);
+  void Remove(const std::string &key);
+
+  const std::string Label() const { return m_label; }
+  const std::vector<uint64_t> &Bounds() const { return m_bounds; }
+
+  /*
+   * The form is:
+   *   var_name  map:label_name key1:count=N,sum=S key2:count=N,sum=S
+   */
+  const std::string Value() const;
+  void AppendMetrics(std::string *output) const;
+
+ private:
+  typedef std::map<std::string, Histogram*> HistogramMap;
+
+  std::string m_label;
+  std::vector<uint64_t> m_bounds;
+  mutable ola::thread::Mutex m_mutex;  // protects m_histograms
+  HistogramMap m_histograms;
+
+  DISALLOW_COPY_AND_ASSIGN(HistogramVariable);
+};
+
+
 /*
  * Return a value from the Map Variable, this will create an entry in the map
  * if the variable doesn't exist.
  */
 template<typename Type>
 Type &MapVariable<Type>::operator[](const std::string &key) {
+  ola::thread::MutexLocker locker(&m_mutex);
   return m_variables[key];
 }
 
@@ -265,6 +462,7 @@ Type &MapVariable<Type>::operator[](const std::string &key) {
  */
 template<typename Type>
 void MapVariable<Type>::Set(const std::string &key, Type value) {
+  ola::thread::MutexLocker locker(&m_mutex);
   m_variables[key] = value;
 }
 
@@ -275,6 +473,7 @@ void MapVariable<Type>::Set(const std::string &key, Type value) {
  */
 template<typename Type>
 void MapVariable<Type>::Remove(const std::string &key) {
+  ola::thread::MutexLocker locker(&m_mutex);
   typename std::map<std::string, Type>::iterator iter = m_variables.find(key);
 
   if (iter != m_variables.end())
@@ -291,9 +490,10 @@ template<typename Type>
 inline const std::string MapVariable<Type>::Value() const {
   std::ostringstream value;
   value << "map:" << m_label;
+  ola::thread::MutexLocker locker(&m_mutex);
   typename std::map<std::string, Type>::const_iterator iter;
   for (iter = m_variables.begin(); iter != m_variables.end(); ++iter)
-    value << " " << iter->first << ":" << iter->second;
+    value << " " << iter->first << ":" << AtomicLoad(&iter->second);
   return value.str();
 }
 
@@ -305,6 +505,7 @@ template<>
 inline const std::string MapVariable<std::string>::Value() const {
   std::ostringstream value;
   value << "map:" << m_label;
+  ola::thread::MutexLocker locker(&m_mutex);
   std::map<std::string, std::string>::const_iterator iter;
   for (iter = m_variables.begin(); iter != m_variables.end(); ++iter) {
     std::string var = iter->second;
@@ -315,6 +516,39 @@ inline const std::string MapVariable<std::string>::Value() const {
 }
 
 
+/*
+ * Append a sample for each key. If the map doesn't have a label, "key" is
+ * used as the label name.
+ */
+template<typename Type>
+inline void MapVariable<Type>::AppendMapMetrics(const char *type,
+                                                const char *suffix,
+                                                std::string *output) const {
+  const std::string metric = MetricName(Name());
+  const std::string label = m_label.empty() ? "key" : MetricName(m_label);
+  AppendMetricType(metric, type, output);
+  ola::thread::MutexLocker locker(&m_mutex);
+  typename std::map<std::string, Type>::const_iterator iter;
+  for (iter = m_variables.begin(); iter != m_variables.end(); ++iter) {
+    std::ostringstream value;
+    value << AtomicLoad(&iter->second);
+    AppendMetricSample(metric + suffix, label, iter->first, value.str(),
+                       output);
+  }
+}
+
+
+/*
+ * Strings aren't exported as metrics.
+ */
+template<>
+inline void MapVariable<std::string>::AppendMapMetrics(
+    OLA_UNUSED const char *type,
+    OLA_UNUSED const char *suffix,
+    OLA_UNUSED std::string *output) const {
+}
+
+
 
 
 /**
@@ -371,6 +605,23 @@ class ExportMap {
   IntMap *GetIntMapVar(const std::string &name, const std::string &label = "");
   UIntMap *GetUIntMapVar(const std::string &name,
                          const std::string &label = "");
+  CounterMap *GetCounterMapVar(const std::string &name,
+                               const std::string &label = "");
+
+  /**
+   * @brief Lookup or create a HistogramVariable.
+   * @param name the name of this variable.
+   * @param label the label used for the keys.
+   * @param bounds the upper bound of each bucket, this is ignored if the
+   *   variable already exists.
+   * @return a HistogramVariable.
+   *
+   * The variable is created if it doesn't already exist. The pointer is
+   * valid for the lifetime of the ExportMap.
+   */
+  HistogramVariable *GetHistogramVar(const std::string &name,
+                                     const std::string &label,
+                                     const std::vector<uint64_t> &bounds);
 
   /**
    * @brief Fetch a list of all known variables.
@@ -388,6 +639,9 @@ class ExportMap {
                   const std::string &name,
                   const std::string &label);
 
+  // protects the maps below, variables can be looked up while another thread
+  // calls AllVariables().
+  mutable ola::thread::Mutex m_mutex;
   std::map<std::string, BoolVariable*> m_bool_variables;
   std::map<std::string, CounterVariable*> m_counter_variables;
   std::map<std::string, IntegerVariable*> m_int_variables;
@@ -396,6 +650,8 @@ class ExportMap {
   std::map<std::string, StringMap*> m_str_map_variables;
   std::map<std::string, IntMap*> m_int_map_variables;
   std::map<std::string, UIntMap*> m_uint_map_variables;
+  std::map<std::string, CounterMap*> m_counter_map_variables;
+  std::map<std::string, HistogramVariable*> m_histogram_variables;
 
   DISALLOW_COPY_AND_ASSIGN(ExportMap);
 };
@@ -44,6 +44,8 @@
 #ifndef INCLUDE_OLA_LOGGING_H_
 #define INCLUDE_OLA_LOGGING_H_
 
+#include <stdint.h>
+#include <ola/base/Macro.h>
 #include <ostream>
 #include <string>
 #include <sstream>
@@ -210,6 +212,133 @@ class UnixSyslogDestination : public SyslogDestination {
 };
 #endif  // _WIN32
 
+/**
+ * @cond HIDDEN_SYMBOLS
+ */
+namespace thread {
+class ConditionVariable;
+class Mutex;
+}  // namespace thread
+/**@endcond*/
+
+/**
+ * @brief A LogDestination that writes to another LogDestination from a
+ * background thread.
+ *
+ * Write() copies the line into a fixed size ring without taking a lock, so
+ * the caller never blocks on the underlying destination. If the ring is full
+ * the line is dropped and counted, and the number dropped is logged once
+ * there's space again.
+ *
+ * The writer thread collapses runs of identical lines into a single
+ * "Last message repeated" line, and limits the number of lines written per
+ * second from each call site.
+ *
+ * FATAL lines skip the ring and are written straight away, so the underlying
+ * destination must allow concurrent calls to Write(). Lines longer than
+ * MAX_LINE_LENGTH are truncated.
+ */
+class AsyncLogDestination: public LogDestination {
+ public:
+  struct Options {
+    /**
+     * @brief The number of lines the ring holds. This is rounded up to a
+     * power of two.
+     */
+    unsigned int ring_size;
+
+    /**
+     * @brief The maximum number of lines per second from each call site, or 0
+     * for no limit.
+     */
+    unsigned int max_lines_per_second;
+
+    Options()
+        : ring_size(512),
+          max_lines_per_second(20) {
+    }
+  };
+
+  /**
+   * @brief Create a new AsyncLogDestination.
+   * @param destination the LogDestination to write to, ownership is
+   *   transferred.
+   * @param options the Options to use.
+   */
+  explicit AsyncLogDestination(LogDestination *destination,
+                               const Options &options = Options());
+
+  /**
+   * @brief Destructor.
+   *
+   * This stops the writer thread and writes any lines still in the ring.
+   */
+  ~AsyncLogDestination();
+
+  /**
+   * @brief Start the writer thread.
+   * @returns true if the thread was started, false otherwise.
+   *
+   * Lines are written synchronously until this is called.
+   */
+  bool Init();
+
+  /**
+   * @brief Stop the writer thread, after writing any lines in the ring.
+   *
+   * Lines are written synchronously until Init() is called again.
+   */
+  void Stop();
+
+  /**
+   * @brief Empty the ring in the child after a fork().
+   *
+   * The writer thread doesn't exist in the child, so this doesn't start one
+   * and lines are written synchronously until Init() is called.
+   */
+  void ResetAfterFork();
+
+  /**
+   * @brief Queue a line to be written by the writer thread.
+   */
+  void Write(log_level level, const std::string &log_line);
+
+  /**
+   * @brief The number of lines dropped because the ring was full.
+   */
+  uint64_t Dropped() const;
+
+  static const unsigned int MAX_LINE_LENGTH = 512;
+
+ private:
+  struct Slot;
+  class WriterThread;
+
+  LogDestination *m_destination;
+  const unsigned int m_max_lines_per_second;
+  Slot *m_slots;
+  uint32_t m_mask;
+  volatile uint32_t m_enqueue_position;
+  uint32_t m_dequeue_position;
+  volatile uint64_t m_dropped;
+  uint64_t m_reported_dropped;
+  volatile bool m_running;
+  // The number of calls to Write() that may be adding to the ring.
+  volatile uint32_t m_active_writers;
+  volatile bool m_writer_waiting;
+  bool m_stopping;
+  WriterThread *m_writer;
+  thread::Mutex *m_mutex;
+  thread::ConditionVariable *m_wake_up;
+
+  static const unsigned int STOP_POLL_INTERVAL_US = 100;
+
+  void Enqueue(log_level level, const std::string &log_line);
+  bool Dequeue(log_level *level, std::string *line);
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLogDestination);
+};
+
 /**@}*/
 
 /**
@@ -260,6 +389,16 @@ void IncrementLogLevel();
  */
 bool InitLoggingFromFlags();
 
+/**
+ * @brief Restart the writer thread used by --log-async.
+ *
+ * A forked child writes log lines synchronously, since it can't safely start
+ * a thread from the atfork handler. Call this once the child is running, for
+ * example after Daemonise(). This does nothing if --log-async wasn't used.
+ * @returns true if the writer thread is running, or --log-async wasn't used.
+ */
+bool RestartAsyncLogging();
+
 /**
  * @brief Initialize the OLA logging system
  * @param level the level to log at
@@ -274,6 +413,15 @@ bool InitLogging(log_level level, log_output output);
  * @param destination the LogDestination to use.
  */
 void InitLogging(log_level level, LogDestination *destination);
+
+/**
+ * @brief Initialize the OLA logging system with an AsyncLogDestination.
+ *
+ * This starts the writer thread, and stops it before a fork() and at exit.
+ * @param level the level to log at
+ * @param destination the AsyncLogDestination to use, ownership is transferred.
+ */
+void InitAsyncLogging(log_level level, AsyncLogDestination *destination);
 /***/
 }  // namespace ola
 /**@}*/
@@ -0,0 +1,102 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Atomic.h
+ * Atomic operations.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+/**
+ * @file Atomic.h
+ * @brief Atomic operations on integers.
+ *
+ * These wrap the compiler's __sync builtins, which configure checks for, so
+ * there is a single place to change if we move to another implementation.
+ * Each operation is a full memory barrier.
+ */
+
+#ifndef INCLUDE_OLA_BASE_ATOMIC_H_
+#define INCLUDE_OLA_BASE_ATOMIC_H_
+
+namespace ola {
+
+/**
+ * @brief Atomically add to a value.
+ * @param value the value to update.
+ * @param delta the amount to add.
+ * @returns the new value.
+ */
+template <typename T, typename D>
+inline T AtomicAdd(volatile T *value, D delta) {
+  return __sync_add_and_fetch(value, static_cast<T>(delta));
+}
+
+/**
+ * @brief Atomically subtract from a value.
+ * @param value the value to update.
+ * @param delta the amount to subtract.
+ * @returns the new value.
+ */
+template <typename T, typename D>
+inline T AtomicSubtract(volatile T *value, D delta) {
+  return __sync_sub_and_fetch(value, static_cast<T>(delta));
+}
+
+/**
+ * @brief Read a value, including 64 bit values on 32 bit platforms.
+ * @param value the value to read.
+ * @returns the current value.
+ */
+template <typename T>
+inline T AtomicLoad(const volatile T *value) {
+  return __sync_add_and_fetch(const_cast<volatile T*>(value), 0);
+}
+
+/**
+ * @brief Write a value, including 64 bit values on 32 bit platforms.
+ * @param value the value to update.
+ * @param new_value the value to store.
+ */
+template <typename T, typename D>
+inline void AtomicStore(volatile T *value, D new_value) {
+  T old_value = *value;
+  while (!__sync_bool_compare_and_swap(value, old_value,
+                                       static_cast<T>(new_value))) {
+    old_value = *value;
+  }
+}
+
+/**
+ * @brief Replace a value if it hasn't changed.
+ * @param value the value to update.
+ * @param expected the value we expect it to hold.
+ * @param new_value the value to store.
+ * @returns true if the value was replaced, false if it didn't hold expected.
+ */
+template <typename T>
+inline bool AtomicCompareAndSwap(volatile T *value, T expected, T new_value) {
+  return __sync_bool_compare_and_swap(value, expected, new_value);
+}
+
+/**
+ * @brief A full memory barrier.
+ *
+ * Neither the compiler nor the CPU will move loads or stores across this.
+ */
+inline void AtomicBarrier() {
+  __sync_synchronize();
+}
+}  // namespace ola
+#endif  // INCLUDE_OLA_BASE_ATOMIC_H_
@@ -1,6 +1,7 @@
 olabaseincludedir = $(pkgincludedir)/base/
 olabaseinclude_HEADERS = \
     include/ola/base/Array.h \
+    include/ola/base/Atomic.h \
     include/ola/base/Credentials.h \
     include/ola/base/Env.h \
     include/ola/base/Flags.h \
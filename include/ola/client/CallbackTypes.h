@@ -32,6 +32,7 @@
 #include <ola/rdm/RDMCommand.h>
 #include <ola/rdm/UIDSet.h>
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -133,6 +134,25 @@ typedef SingleUseCallback2<void, const Result&, const ola::rdm::UIDSet&>
 typedef SingleUseCallback3<void, const Result&, const DMXMetadata&,
                            const DmxBuffer&> DMXCallback;
 
+/**
+ * @brief Called once when OlaClient::FetchBulkDMX() completes.
+ * @param result the Result of the API call.
+ * @param data a map of universe id to DmxBuffer. Universes that don't exist
+ *   are missing from the map.
+ */
+typedef SingleUseCallback2<void, const Result&,
+                           const std::map<unsigned int, DmxBuffer>&>
+    BulkDMXCallback;
+
+/**
+ * @brief Invoked when OlaClient::FetchUniverseStats() completes.
+ * @param result the Result of the API call.
+ * @param stats the UniverseStats, universes that don't exist are left out.
+ */
+typedef SingleUseCallback2<void, const Result&,
+                           const std::vector<UniverseStats>&>
+    UniverseStatsCallback;
+
 /**
  * @brief Called when new DMX data arrives.
  * @param metadata the DMXMetadata associated with the frame.
@@ -153,6 +173,18 @@ typedef SingleUseCallback3<void, const Result&,
                            const RDMMetadata&,
                            const ola::rdm::RDMResponse*> RDMCallback;
 
+/**
+ * @brief Called as each request in a bulk RDM operation completes.
+ * Used with OlaClient::SendBulkRDM().
+ * @param result the Result of the API call.
+ * @param index the index of the RDMOperation that completed.
+ * @param metadata the metadata for the response, including the
+ * rdm_response_code.
+ * @param response the RDM Response, or NULL if no response was received.
+ */
+typedef Callback4<void, const Result&, unsigned int, const RDMMetadata&,
+                  const ola::rdm::RDMResponse*> BulkRDMCallback;
+
 
 }  // namespace client
 }  // namespace ola
@@ -23,6 +23,9 @@
 
 #include <ola/client/CallbackTypes.h>
 #include <ola/dmx/SourcePriorities.h>
+#include <ola/rdm/UID.h>
+#include <stdint.h>
+#include <string>
 
 /**
  * @file
@@ -111,9 +114,98 @@ struct SendRDMArgs {
    */
   bool include_raw_frames;
 
+  /**
+   * @brief Set to true for background requests, like a full scan of the
+   * responders' parameters.
+   *
+   * Bulk requests are sent when the port isn't busy with interactive ones.
+   */
+  bool bulk;
+
+  /**
+   * @brief Set to true to allow olad to answer a GET from its cache, rather
+   * than sending it to the responder.
+   *
+   * Only parameters which rarely change are cached. The cache is invalidated
+   * by SETs and the queued & status messages olad sees.
+   */
+  bool cache_first;
+
   explicit SendRDMArgs(RDMCallback *_callback)
     : callback(_callback),
-      include_raw_frames(false) {
+      include_raw_frames(false),
+      bulk(false),
+      cache_first(false) {
+  }
+};
+
+/**
+ * @brief A single request in a bulk RDM operation, used with
+ * OlaClient::SendBulkRDM().
+ */
+struct RDMOperation {
+  unsigned int universe;  /**< The universe to send the request on */
+  ola::rdm::UID uid;  /**< The UID to send the request to */
+  uint16_t sub_device;  /**< The sub device index */
+  uint16_t pid;  /**< The PID to address */
+  bool is_set;  /**< True for a SET, false for a GET */
+  std::string data;  /**< The parameter data */
+
+  RDMOperation(unsigned int _universe,
+               const ola::rdm::UID &_uid,
+               uint16_t _sub_device,
+               uint16_t _pid,
+               bool _is_set = false,
+               const std::string &_data = "")
+    : universe(_universe),
+      uid(_uid),
+      sub_device(_sub_device),
+      pid(_pid),
+      is_set(_is_set),
+      data(_data) {
+  }
+};
+
+/**
+ * @brief Arguments used with OlaClient::SendBulkRDM()
+ */
+struct SendBulkRDMArgs {
+  /**
+   * @brief The callback to run as each request completes. Ownership is
+   * transferred, it's deleted once all the requests have completed.
+   */
+  BulkRDMCallback *callback;
+
+  /**
+   * @brief The callback to run once all the requests have completed, may be
+   * NULL.
+   */
+  SetCallback *done;
+
+  /**
+   * @brief Set to true to include frame & timing information in the
+   * responses.
+   */
+  bool include_raw_frames;
+
+  /**
+   * @brief Send the requests when the port isn't busy with interactive ones.
+   * Defaults to true.
+   */
+  bool bulk;
+
+  /**
+   * @brief Set to true to allow olad to answer GETs from its cache.
+   */
+  bool cache_first;
+
+  explicit SendBulkRDMArgs(BulkRDMCallback *_callback,
+                           SetCallback *_done = NULL)
+    : callback(_callback),
+      done(_done),
+      include_raw_frames(false),
+      bulk(true),
+      cache_first(false) {
   }
 };
 }  // namespace client
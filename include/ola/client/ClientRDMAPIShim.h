@@ -39,9 +39,16 @@ class OlaClient;
 class ClientRDMAPIShim : public ola::rdm::RDMAPIImplInterface {
  public:
   explicit ClientRDMAPIShim(OlaClient *client)
-      : m_client(client) {
+      : m_client(client),
+        m_cache_first(false) {
   }
 
+  /**
+   * @brief Allow olad to answer GETs from its cache, rather than sending
+   *   them to the responder.
+   */
+  void SetCacheFirst(bool cache_first) { m_cache_first = cache_first; }
+
   bool RDMGet(rdm_callback *callback,
               unsigned int universe,
               const ola::rdm::UID &uid,
@@ -68,6 +75,7 @@ class ClientRDMAPIShim : public ola::rdm::RDMAPIImplInterface {
 
  private:
   OlaClient *m_client;
+  bool m_cache_first;
 
   void HandleResponse(
       rdm_callback *callback,
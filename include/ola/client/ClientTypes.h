@@ -27,6 +27,7 @@
 
 #include <olad/PortConstants.h>
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 
@@ -305,6 +306,62 @@ class OlaUniverse {
   unsigned int m_rdm_device_count;
 };
 
+/**
+ * @brief The frame statistics for a universe or port. The rates are over the
+ * last second.
+ */
+struct FrameStats {
+  /**
+   * @brief The total number of frames.
+   */
+  uint64_t frames;
+  double fps;
+  unsigned int jitter_us;
+  /**
+   * @brief The mean time from the data arriving to the frame being sent.
+   * This is only set for output frames.
+   */
+  unsigned int mean_latency_us;
+  unsigned int max_latency_us;
+
+  FrameStats()
+      : frames(0),
+        fps(0),
+        jitter_us(0),
+        mean_latency_us(0),
+        max_latency_us(0) {
+  }
+};
+
+/**
+ * @brief The frame statistics for a port.
+ */
+struct PortStats {
+  std::string port_id;
+  bool is_output;
+  FrameStats stats;
+
+  PortStats() : is_output(false) {}
+};
+
+/**
+ * @brief The frame statistics for a universe.
+ */
+struct UniverseStats {
+  unsigned int universe;
+  /**
+   * @brief The frames received from input ports & clients.
+   */
+  FrameStats input;
+  /**
+   * @brief The frames sent to the output ports & clients.
+   */
+  FrameStats output;
+  std::vector<PortStats> ports;
+
+  UniverseStats() : universe(0) {}
+};
+
 /**
  * @brief Metadata that accompanies DMX packets
  */
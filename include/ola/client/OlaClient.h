@@ -32,8 +32,10 @@
 #include <ola/rdm/UIDSet.h>
 #include <ola/timecode/TimeCode.h>
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace ola {
 namespace client {
@@ -248,6 +250,18 @@ class OlaClient {
                const DmxBuffer &data,
                const SendDMXArgs &args);
 
+  /**
+   * @brief Send DMX data for several universes at once.
+   *
+   * olad applies all the updates together, so they go out in the same frame.
+   * If any of the universes don't exist, none of them are updated.
+   * @param data a map of universe id to DmxBuffer.
+   * @param args the SendDMXArgs to use for this call, the priority applies to
+   *   all the universes.
+   */
+  void SendBulkDMX(const std::map<unsigned int, DmxBuffer> &data,
+                   const SendDMXArgs &args);
+
   /**
    * @brief Fetch the latest DMX data for a universe.
    * @param universe the universe id to get data for.
@@ -255,6 +269,23 @@ class OlaClient {
    */
   void FetchDMX(unsigned int universe, DMXCallback *callback);
 
+  /**
+   * @brief Fetch the latest DMX data for several universes.
+   * @param universes the universe ids to get data for.
+   * @param callback the BulkDMXCallback to invoke upon completion.
+   */
+  void FetchBulkDMX(const std::vector<unsigned int> &universes,
+                    BulkDMXCallback *callback);
+
+  /**
+   * @brief Fetch the frame rate, latency & jitter for universes.
+   * @param universes the universe ids to get the stats for, or an empty
+   *   vector for all universes.
+   * @param callback the UniverseStatsCallback to invoke upon completion.
+   */
+  void FetchUniverseStats(const std::vector<unsigned int> &universes,
+                          UniverseStatsCallback *callback);
+
   /**
    * @brief Trigger discovery for a universe.
    * @param universe the universe id to run discovery on.
@@ -308,6 +339,18 @@ class OlaClient {
               unsigned int data_length,
               const SendRDMArgs& args);
 
+  /**
+   * @brief Send a batch of RDM commands.
+   *
+   * The commands are sent to olad without waiting for the earlier ones to
+   * complete. The callback in args is run once for each operation, with the
+   * index of the operation, as the responses arrive.
+   * @param operations the RDM requests to send.
+   * @param args the arguments, which include the callbacks to run.
+   */
+  void SendBulkRDM(const std::vector<RDMOperation> &operations,
+                   const SendBulkRDMArgs &args);
+
   /**
    * @brief Send TimeCode data.
    * @param timecode The timecode data.
@@ -26,12 +26,14 @@
 #include <ola/base/Macro.h>
 #include <ola/io/Descriptor.h>
 #include <ola/io/SelectServer.h>
+#include <ola/thread/Mutex.h>
 #include <ola/thread/Thread.h>
 #include <ola/web/Json.h>
 // 0.4.6 of microhttp doesn't include stdarg so we do it here.
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/types.h>
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <ola/win/CleanWinSock2.h>
@@ -48,6 +50,8 @@
 namespace ola {
 namespace http {
 
+class HTTPServer;
+
 /*
  * Represents the HTTP request
  */
@@ -67,15 +71,41 @@ class HTTPRequest {
 
   void AddHeader(const std::string &key, const std::string &value);
   void AddPostParameter(const std::string &key, const std::string &value);
-  void ProcessPostData(const char *data, size_t *data_size);
+  bool ProcessPostData(const char *data, size_t *data_size);
   const std::string GetHeader(const std::string &key) const;
   bool CheckParameterExists(const std::string &key) const;
   const std::string GetParameter(const std::string &key) const;
   const std::string GetPostParameter(const std::string &key) const;
 
+  /**
+   * @brief The body of a POST request which isn't form encoded.
+   *
+   * This is used for JSON & binary uploads. It's empty for form posts, use
+   * GetPostParameter() for those.
+   */
+  const std::string &PostData() const { return m_post_data; }
+
   bool InFlight() const { return m_in_flight; }
   void SetInFlight() { m_in_flight = true; }
 
+  /**
+   * @brief Hold a response until libmicrohttpd resumes the connection.
+   *
+   * Used when libmicrohttpd runs its own threads, since responses can only be
+   * queued from them.
+   * @param response the response to queue.
+   * @param status_code the HTTP status code.
+   * @param owned true if the response should be destroyed once queued.
+   */
+  void SetPendingResponse(struct MHD_Response *response,
+                          unsigned int status_code,
+                          bool owned);
+
+  /**
+   * @brief Queue the pending response, if there is one.
+   */
+  int QueuePendingResponse();
+
  private:
   std::string m_url;
   std::string m_method;
@@ -83,15 +113,94 @@ class HTTPRequest {
   struct MHD_Connection *m_connection;
   std::map<std::string, std::string> m_headers;
   std::map<std::string, std::string> m_post_params;
+  std::string m_post_data;
   struct MHD_PostProcessor *m_processor;
   bool m_in_flight;
+  struct MHD_Response *m_pending_response;
+  unsigned int m_pending_status_code;
+  bool m_pending_owned;
 
   static const unsigned int K_POST_BUFFER_SIZE = 1024;
+  // The largest POST body we'll accept, if it isn't form encoded.
+  static const unsigned int K_MAX_POST_DATA_SIZE = 4 << 20;
 
   DISALLOW_COPY_AND_ASSIGN(HTTPRequest);
 };
 
 
+/**
+ * @brief A Server-Sent Events (text/event-stream) response body.
+ *
+ * Events are buffered until libmicrohttpd is ready to write them to the
+ * connection. Once passed to HTTPResponse::SendEventStream() the stream is
+ * owned by the connection, and is deleted when the connection closes. The
+ * on_close callback is run at that point, so the owner can forget about it.
+ *
+ * All methods other than Read() must be called from the HTTP server thread.
+ */
+class HTTPEventStream {
+ public:
+  explicit HTTPEventStream(ola::SingleUseCallback0<void> *on_close = NULL);
+  ~HTTPEventStream();
+
+  /**
+   * @brief Queue an event.
+   * @param event the event type, may be empty.
+   * @param data the event data, this may span several lines.
+   * @returns false if the client isn't keeping up and the event was dropped.
+   */
+  bool SendEvent(const std::string &event, const std::string &data);
+
+  /**
+   * @brief Queue a comment, which clients ignore. Used as a keep-alive.
+   */
+  bool SendComment(const std::string &comment);
+
+  /**
+   * @brief End the stream once the queued events have been written.
+   */
+  void Close();
+
+  /**
+   * @brief Replace the callback run when the connection closes.
+   */
+  void SetOnClose(ola::SingleUseCallback0<void> *on_close);
+
+  /**
+   * @brief The number of bytes waiting to be written to the connection.
+   */
+  size_t PendingBytes() const;
+
+  /**
+   * @privatesection
+   * These are used by the HTTPServer.
+   */
+  ssize_t Read(char *buffer, size_t max);
+  void Attach(HTTPServer *server, struct MHD_Connection *connection);
+  void ConnectionClosed();
+
+  // The maximum number of bytes to queue before events are dropped.
+  static const size_t MAX_PENDING_BYTES = 1 << 20;
+
+ private:
+  // When libmicrohttpd runs its own threads, Read() is called from them.
+  mutable ola::thread::Mutex m_mutex;
+  std::string m_buffer;
+  size_t m_offset;
+  bool m_closed;
+  ola::SingleUseCallback0<void> *m_on_close;
+  // These are only set when libmicrohttpd runs its own threads.
+  HTTPServer *m_server;
+  struct MHD_Connection *m_connection;
+  bool m_suspended;
+
+  bool Append(const std::string &data);
+  void Resume();
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPEventStream);
+};
+
+
 /*
  * Represents the HTTP Response
  */
@@ -99,22 +208,53 @@ class HTTPResponse {
  public:
   explicit HTTPResponse(struct MHD_Connection *connection):
     m_connection(connection),
-    m_status_code(MHD_HTTP_OK) {}
+    m_status_code(MHD_HTTP_OK),
+    m_server(NULL),
+    m_request(NULL) {}
 
   void Append(const std::string &data) { m_data.append(data); }
+
+  /**
+   * @brief The body of the response, so it can be written in place, e.g. by
+   *   a JsonStreamWriter.
+   */
+  std::string *Body() { return &m_data; }
   void SetContentType(const std::string &type);
   void SetHeader(const std::string &key, const std::string &value);
   void SetStatus(unsigned int status) { m_status_code = status; }
   void SetNoCache();
   int SendJson(const ola::web::JsonValue &json);
   int Send();
+  int SendEventStream(HTTPEventStream *stream);
   struct MHD_Connection *Connection() const { return m_connection; }
+
+  /**
+   * @brief Queue a libmicrohttpd response for this request.
+   * @param response the response to queue.
+   * @param status_code the HTTP status code.
+   * @param owned true if the response should be destroyed once queued.
+   */
+  int QueueResponse(struct MHD_Response *response,
+                    unsigned int status_code,
+                    bool owned);
+
+  /**
+   * @brief Mark this response as being sent from outside libmicrohttpd's
+   *   threads, see HTTPServer::DispatchDaemonRequest().
+   */
+  void SetDeferred(HTTPServer *server, HTTPRequest *request) {
+    m_server = server;
+    m_request = request;
+  }
+
  private:
   std::string m_data;
   struct MHD_Connection *m_connection;
   typedef std::multimap<std::string, std::string> HeadersMultiMap;
   HeadersMultiMap m_headers;
   unsigned int m_status_code;
+  HTTPServer *m_server;
+  HTTPRequest *m_request;
 
   DISALLOW_COPY_AND_ASSIGN(HTTPResponse);
 };
@@ -152,10 +292,14 @@ class HTTPServer: public ola::thread::Thread {
     uint16_t port;
     // The root for content served with ServeStaticContent();
     std::string data_dir;
+    // If non-0, libmicrohttpd runs this many threads of its own, using epoll
+    // where it's available, rather than being driven by our SelectServer.
+    unsigned int thread_pool_size;
 
     HTTPServerOptions()
       : port(0),
-        data_dir("") {
+        data_dir(""),
+        thread_pool_size(0) {
     }
   };
 
@@ -174,10 +318,26 @@ class HTTPServer: public ola::thread::Thread {
 
   int DispatchRequest(const HTTPRequest *request, HTTPResponse *response);
 
+  /**
+   * @privatesection
+   * These are used when libmicrohttpd runs its own threads. Requests for
+   * static files are served from those threads, everything else is
+   * suspended and passed to our SelectServer thread.
+   */
+  int DispatchDaemonRequest(HTTPRequest *request, HTTPResponse *response);
+  int CompleteDeferredRequest(HTTPRequest *request,
+                              struct MHD_Response *response,
+                              unsigned int status_code,
+                              bool owned);
+  void AddEventStream(HTTPEventStream *stream);
+  void EventStreamClosed(HTTPEventStream *stream);
+  bool UsesDaemonThreads() const { return m_thread_pool_size != 0; }
+
   // Register a callback handler.
   bool RegisterHandler(const std::string &path, BaseHTTPCallback *handler);
 
-  // Register a file handler.
+  // Register a file handler. Files registered before Init() is called are
+  // held in memory.
   bool RegisterFile(const std::string &path,
                     const std::string &content_type);
   bool RegisterFile(const std::string &path,
@@ -209,6 +369,8 @@ class HTTPServer: public ola::thread::Thread {
   static const char CONTENT_TYPE_OCT[];
   static const char CONTENT_TYPE_XML[];
   static const char CONTENT_TYPE_JSON[];
+  static const char CONTENT_TYPE_EVENT_STREAM[];
+  static const char CONTENT_TYPE_OPENMETRICS[];
 
   // Expose the SelectServer
   ola::io::SelectServer *SelectServer() { return m_select_server.get(); }
@@ -216,9 +378,26 @@ class HTTPServer: public ola::thread::Thread {
   static struct MHD_Response *BuildResponse(void *data, size_t size);
 
  private :
+  /*
+   * A static file held in memory. The responses are built once and queued
+   * for each request, so the content is never copied.
+   */
+  struct CachedFile {
+    std::string data;
+    std::string gzip_data;
+    struct MHD_Response *response;
+    struct MHD_Response *gzip_response;  // NULL if there isn't a .gz file
+    struct MHD_Response *not_modified_response;
+    struct MHD_Response *gzip_not_modified_response;
+    // The encodings are different entities, so they need different ETags.
+    std::string etag;
+    std::string gzip_etag;
+  };
+
   typedef struct {
     std::string file_path;
     std::string content_type;
+    CachedFile *cached_file;
   } static_file_info;
 
   struct DescriptorState {
@@ -242,6 +421,19 @@ class HTTPServer: public ola::thread::Thread {
 
   typedef std::set<DescriptorState*, Descriptor_lt> SocketSet;
 
+  // Used when libmicrohttpd runs its own threads. These are declared before
+  // the SelectServer since it may run deferred callbacks when it's destroyed.
+  ola::thread::Mutex m_daemon_mutex;
+  bool m_stopping;  // GUARDED_BY(m_daemon_mutex)
+  // GUARDED_BY(m_daemon_mutex)
+  std::map<HTTPRequest*, struct MHD_Connection*> m_deferred_requests;
+  // The deferred request being dispatched, NULL once it has a response. Only
+  // used on our SelectServer thread.
+  HTTPRequest *m_running_request;
+  // Never held while calling into libmicrohttpd.
+  ola::thread::Mutex m_stream_mutex;
+  std::set<HTTPEventStream*> m_event_streams;  // GUARDED_BY(m_stream_mutex)
+
   struct MHD_Daemon *m_httpd;
   std::auto_ptr<ola::io::SelectServer> m_select_server;
   SocketSet m_sockets;
@@ -251,10 +443,20 @@ class HTTPServer: public ola::thread::Thread {
   BaseHTTPCallback *m_default_handler;
   unsigned int m_port;
   std::string m_data_dir;
+  unsigned int m_thread_pool_size;
 
   int ServeStaticContent(static_file_info *file_info,
                          HTTPResponse *response);
-
+  int ServeCachedFile(const CachedFile *cached_file, HTTPResponse *response);
+  void LoadStaticContent();
+  CachedFile *LoadFile(const static_file_info &file_info) const;
+  bool ReadFile(const std::string &file, std::string *data) const;
+  bool IsOlderThan(const std::string &file,
+                   const std::string &other_file) const;
+  static void FreeCachedFile(CachedFile *cached_file);
+
+  void RunDeferredRequest(HTTPRequest *request, HTTPResponse *response);
+  void ResumeDaemonConnections();
   void InsertSocket(bool is_readable, bool is_writeable, int fd);
   void FreeSocket(DescriptorState *state);
 
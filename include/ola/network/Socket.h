@@ -286,6 +286,20 @@ class UDPSocket: public UDPSocketInterface {
 
   bool SetTos(uint8_t tos);
 
+  /**
+   * @brief Control delivery of multicast traffic for groups joined by other
+   *   sockets.
+   *
+   * By default Linux delivers a datagram for any group joined on the host to
+   * every socket bound to the matching port. Disabling this restricts the
+   * socket to the groups it has joined itself, which allows groups to be
+   * split across several sockets bound to the same port.
+   * @param enable true to receive all groups, false to only receive the
+   *   groups joined on this socket.
+   * @return true if it worked, false if it failed or isn't supported.
+   */
+  bool SetMulticastAll(bool enable);
+
  private:
   ola::io::DescriptorHandle m_handle;
   bool m_bound_to_port;
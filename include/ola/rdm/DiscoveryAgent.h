@@ -36,6 +36,7 @@
 #include <queue>
 #include <stack>
 #include <utility>
+#include <vector>
 
 namespace ola {
 namespace rdm {
@@ -131,6 +132,12 @@ class DiscoveryTargetInterface {
  * MAX_MUTE_ATTEMPTS times) and branches that contain responders which continue
  * to respond once muted. The latter causes a branch to be marked as corrupt,
  * which prevents us from looping forver.
+ *
+ * After a successful full discovery, the branches that were resolved without
+ * a collision are remembered. The next full discovery starts from these
+ * branches rather than the whole UID space, which skips the DUB commands that
+ * would collide again. Any new responders are still found, since the branches
+ * cover the entire UID space.
  */
 class DiscoveryAgent {
  public:
@@ -179,7 +186,8 @@ class DiscoveryAgent {
           attempt(0),
           failures(0),
           uids_discovered(0),
-          branch_corrupt(false) {
+          branch_corrupt(false),
+          split(false) {
     }
     UID lower;
     UID upper;
@@ -188,9 +196,28 @@ class DiscoveryAgent {
     unsigned int failures;
     unsigned int uids_discovered;
     bool branch_corrupt;  // true if this branch contains a bad device
+    bool split;  // true if there was a collision in this branch
+  };
+
+  /**
+   * @brief A branch that was resolved without a collision.
+   */
+  struct ResolvedRange {
+    ResolvedRange(const UID &_lower, const UID &_upper, unsigned int _uids)
+        : lower(_lower),
+          upper(_upper),
+          uids(_uids) {
+    }
+    bool operator<(const ResolvedRange &other) const {
+      return lower < other.lower;
+    }
+    UID lower;
+    UID upper;
+    unsigned int uids;  // the number of UIDs discovered in this branch
   };
 
   typedef std::stack<UIDRange*> UIDRanges;
+  typedef std::vector<ResolvedRange> ResolvedRanges;
 
   DiscoveryTargetInterface *m_target;
   UIDSet m_uids;
@@ -214,6 +241,11 @@ class DiscoveryAgent {
   unsigned int m_unmute_count;
   unsigned int m_mute_attempts;
   bool m_tree_corrupt;  // true if there was a problem with discovery
+  bool m_full_discovery;
+  // the branches resolved so far in this discovery run
+  ResolvedRanges m_resolved_ranges;
+  // the branches resolved in the last successful full discovery
+  ResolvedRanges m_branch_history;
 
   void InitDiscovery(DiscoveryCompleteCallback *on_complete,
                      bool incremental);
@@ -227,6 +259,9 @@ class DiscoveryAgent {
   void BranchMuteComplete(bool status);
   void HandleCollision();
   void FreeCurrentRange();
+  void DiscoveryComplete();
+
+  static bool CoalesceRanges(ResolvedRanges *ranges);
 
   static const unsigned int PREAMBLE_SIZE = 8;
   static const unsigned int EUID_SIZE = 12;
@@ -17,6 +17,7 @@ olardminclude_HEADERS = \
     include/ola/rdm/NetworkManagerInterface.h \
     include/ola/rdm/NetworkResponder.h \
     include/ola/rdm/OpenLightingEnums.h \
+    include/ola/rdm/ParamDataCodec.h \
     include/ola/rdm/PidStore.h \
     include/ola/rdm/PidStoreHelper.h \
     include/ola/rdm/QueueingRDMController.h \
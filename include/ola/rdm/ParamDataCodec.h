@@ -0,0 +1,444 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * ParamDataCodec.h
+ * Pack & unpack the parameter data of the common E1.20 PIDs.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+/**
+ * @addtogroup rdm_helpers
+ * @{
+ * @file ParamDataCodec.h
+ * @brief Pack & unpack the parameter data of the common E1.20 PIDs.
+ *
+ * The Descriptor based code (StringMessageBuilder, MessageSerializer &
+ * MessageDeserializer) can handle any PID, but builds a tree of
+ * heap-allocated fields for every message. The PIDs that every controller and
+ * responder uses have a fixed layout, so for those we describe the layout at
+ * compile time with a PidCodec specialization, and read & write the fields
+ * directly to and from the parameter data.
+ *
+ * @examplepara
+ *   @code
+ *   uint8_t data[PidCodec<PID_DEVICE_INFO>::MAX_SIZE];
+ *   unsigned int size = PackParamData<PID_DEVICE_INFO>(device_info, data,
+ *                                                      sizeof(data));
+ *   ...
+ *   DeviceDescriptor device_info;
+ *   if (UnpackParamData<PID_DEVICE_INFO>(data, size, &device_info)) {
+ *     ...
+ *   }
+ *   @endcode
+ * @}
+ */
+
+#ifndef INCLUDE_OLA_RDM_PARAMDATACODEC_H_
+#define INCLUDE_OLA_RDM_PARAMDATACODEC_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <ola/base/Macro.h>
+#include <ola/rdm/RDMAPI.h>
+#include <ola/rdm/RDMEnums.h>
+#include <string>
+
+namespace ola {
+namespace rdm {
+
+/**
+ * @brief Reads big endian fields from parameter data.
+ *
+ * Reading past the end of the data returns 0 and marks the reader as failed,
+ * so the fields can be read unconditionally and checked once with Ok().
+ */
+class ParamDataReader {
+ public:
+  ParamDataReader(const uint8_t *data, unsigned int size)
+      : m_data(data),
+        m_size(size),
+        m_offset(0),
+        m_ok(true) {
+  }
+
+  /**
+   * @brief Read an integer field.
+   */
+  template <typename T>
+  T Read() {
+    STATIC_ASSERT(sizeof(T) <= sizeof(uint32_t));
+    if (Remaining() < sizeof(T)) {
+      m_ok = false;
+      m_offset = m_size;
+      return 0;
+    }
+    uint32_t value = 0;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+      value = (value << 8) | m_data[m_offset++];
+    }
+    return static_cast<T>(value);
+  }
+
+  /**
+   * @brief Read the rest of the data as a string.
+   * @param[out] value the string, truncated at the first NULL.
+   * @param max_length the maximum length of the string.
+   */
+  void ReadString(std::string *value,
+                  unsigned int max_length = MAX_RDM_STRING_LENGTH) {
+    if (Remaining() > max_length) {
+      m_ok = false;
+    }
+    const char *start = reinterpret_cast<const char*>(m_data + m_offset);
+    unsigned int length = Remaining() < max_length ? Remaining() : max_length;
+    const void *null = memchr(start, 0, length);
+    if (null) {
+      length = static_cast<unsigned int>(
+          static_cast<const char*>(null) - start);
+    }
+    value->assign(start, length);
+    m_offset = m_size;
+  }
+
+  /**
+   * @brief The number of bytes left to read.
+   */
+  unsigned int Remaining() const { return m_size - m_offset; }
+
+  /**
+   * @brief True if all reads were successful.
+   */
+  bool Ok() const { return m_ok; }
+
+ private:
+  const uint8_t *m_data;
+  const unsigned int m_size;
+  unsigned int m_offset;
+  bool m_ok;
+
+  DISALLOW_COPY_AND_ASSIGN(ParamDataReader);
+};
+
+
+/**
+ * @brief Writes big endian fields to a parameter data buffer.
+ *
+ * Writes that would overflow the buffer are dropped and mark the writer as
+ * failed.
+ */
+class ParamDataWriter {
+ public:
+  ParamDataWriter(uint8_t *data, unsigned int size)
+      : m_data(data),
+        m_size(size),
+        m_offset(0),
+        m_ok(true) {
+  }
+
+  /**
+   * @brief Write an integer field.
+   */
+  template <typename T>
+  void Write(T value) {
+    STATIC_ASSERT(sizeof(T) <= sizeof(uint32_t));
+    if (m_size - m_offset < sizeof(T)) {
+      m_ok = false;
+      return;
+    }
+    const uint32_t raw = static_cast<uint32_t>(value);
+    for (unsigned int i = sizeof(T); i > 0; i--) {
+      m_data[m_offset++] = static_cast<uint8_t>(raw >> (8 * (i - 1)));
+    }
+  }
+
+  /**
+   * @brief Write a string field, without a terminating NULL.
+   * @param value the string to write, it's truncated to max_length.
+   * @param max_length the maximum length of the string.
+   */
+  void WriteString(const std::string &value,
+                   unsigned int max_length = MAX_RDM_STRING_LENGTH) {
+    unsigned int length = static_cast<unsigned int>(
+        value.size() < max_length ? value.size() : max_length);
+    // Stop at the first NULL, like strncpy would.
+    const void *null = memchr(value.data(), 0, length);
+    if (null) {
+      length = static_cast<unsigned int>(
+          static_cast<const char*>(null) - value.data());
+    }
+    if (m_size - m_offset < length) {
+      m_ok = false;
+      return;
+    }
+    memcpy(m_data + m_offset, value.data(), length);
+    m_offset += length;
+  }
+
+  /**
+   * @brief The number of bytes written.
+   */
+  unsigned int Size() const { return m_offset; }
+
+  /**
+   * @brief True if all writes were successful.
+   */
+  bool Ok() const { return m_ok; }
+
+ private:
+  uint8_t *m_data;
+  const unsigned int m_size;
+  unsigned int m_offset;
+  bool m_ok;
+
+  DISALLOW_COPY_AND_ASSIGN(ParamDataWriter);
+};
+
+
+/**
+ * @brief The current personality & number of personalities.
+ */
+struct PersonalityInfo {
+  uint8_t current_personality;
+  uint8_t personality_count;
+};
+
+/**
+ * @brief The description of a personality.
+ */
+struct PersonalityDescription {
+  uint8_t personality;
+  uint16_t slots_required;
+  std::string description;
+};
+
+
+/**
+ * @brief The layout of the GET response / SET request for a PID.
+ *
+ * Each specialization provides:
+ *  - Type, the type the parameter data is unpacked into.
+ *  - MIN_SIZE & MAX_SIZE, the limits on the parameter data length.
+ *  - Pack() & Unpack(), which write & read the fields in order.
+ */
+template <rdm_pid PID>
+struct PidCodec;
+
+/**
+ * @cond HIDDEN_SYMBOLS
+ */
+template <>
+struct PidCodec<PID_DEVICE_INFO> {
+  typedef DeviceDescriptor Type;
+  enum { MIN_SIZE = 19, MAX_SIZE = 19 };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.protocol_version_high);
+    writer->Write(value.protocol_version_low);
+    writer->Write(value.device_model);
+    writer->Write(value.product_category);
+    writer->Write(value.software_version);
+    writer->Write(value.dmx_footprint);
+    writer->Write(value.current_personality);
+    writer->Write(value.personality_count);
+    writer->Write(value.dmx_start_address);
+    writer->Write(value.sub_device_count);
+    writer->Write(value.sensor_count);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->protocol_version_high = reader->Read<uint8_t>();
+    value->protocol_version_low = reader->Read<uint8_t>();
+    value->device_model = reader->Read<uint16_t>();
+    value->product_category = reader->Read<uint16_t>();
+    value->software_version = reader->Read<uint32_t>();
+    value->dmx_footprint = reader->Read<uint16_t>();
+    value->current_personality = reader->Read<uint8_t>();
+    value->personality_count = reader->Read<uint8_t>();
+    value->dmx_start_address = reader->Read<uint16_t>();
+    value->sub_device_count = reader->Read<uint16_t>();
+    value->sensor_count = reader->Read<uint8_t>();
+  }
+};
+
+template <>
+struct PidCodec<PID_DMX_PERSONALITY> {
+  typedef PersonalityInfo Type;
+  enum { MIN_SIZE = 2, MAX_SIZE = 2 };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.current_personality);
+    writer->Write(value.personality_count);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->current_personality = reader->Read<uint8_t>();
+    value->personality_count = reader->Read<uint8_t>();
+  }
+};
+
+template <>
+struct PidCodec<PID_DMX_PERSONALITY_DESCRIPTION> {
+  typedef PersonalityDescription Type;
+  enum { MIN_SIZE = 3, MAX_SIZE = MIN_SIZE + MAX_RDM_STRING_LENGTH };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.personality);
+    writer->Write(value.slots_required);
+    writer->WriteString(value.description);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->personality = reader->Read<uint8_t>();
+    value->slots_required = reader->Read<uint16_t>();
+    reader->ReadString(&value->description);
+  }
+};
+
+template <>
+struct PidCodec<PID_DMX_START_ADDRESS> {
+  typedef uint16_t Type;
+  enum { MIN_SIZE = 2, MAX_SIZE = 2 };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    *value = reader->Read<uint16_t>();
+  }
+};
+
+template <>
+struct PidCodec<PID_SENSOR_DEFINITION> {
+  typedef SensorDescriptor Type;
+  enum { MIN_SIZE = 13, MAX_SIZE = MIN_SIZE + MAX_RDM_STRING_LENGTH };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.sensor_number);
+    writer->Write(value.type);
+    writer->Write(value.unit);
+    writer->Write(value.prefix);
+    writer->Write(value.range_min);
+    writer->Write(value.range_max);
+    writer->Write(value.normal_min);
+    writer->Write(value.normal_max);
+    writer->Write(value.recorded_value_support);
+    writer->WriteString(value.description);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->sensor_number = reader->Read<uint8_t>();
+    value->type = reader->Read<uint8_t>();
+    value->unit = reader->Read<uint8_t>();
+    value->prefix = reader->Read<uint8_t>();
+    value->range_min = reader->Read<int16_t>();
+    value->range_max = reader->Read<int16_t>();
+    value->normal_min = reader->Read<int16_t>();
+    value->normal_max = reader->Read<int16_t>();
+    value->recorded_value_support = reader->Read<uint8_t>();
+    reader->ReadString(&value->description);
+  }
+};
+
+template <>
+struct PidCodec<PID_SENSOR_VALUE> {
+  typedef SensorValueDescriptor Type;
+  enum { MIN_SIZE = 9, MAX_SIZE = 9 };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.sensor_number);
+    writer->Write(value.present_value);
+    writer->Write(value.lowest);
+    writer->Write(value.highest);
+    writer->Write(value.recorded);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->sensor_number = reader->Read<uint8_t>();
+    value->present_value = reader->Read<int16_t>();
+    value->lowest = reader->Read<int16_t>();
+    value->highest = reader->Read<int16_t>();
+    value->recorded = reader->Read<int16_t>();
+  }
+};
+
+template <>
+struct PidCodec<PID_REAL_TIME_CLOCK> {
+  typedef ClockValue Type;
+  enum { MIN_SIZE = 7, MAX_SIZE = 7 };
+
+  static void Pack(const Type &value, ParamDataWriter *writer) {
+    writer->Write(value.year);
+    writer->Write(value.month);
+    writer->Write(value.day);
+    writer->Write(value.hour);
+    writer->Write(value.minute);
+    writer->Write(value.second);
+  }
+
+  static void Unpack(ParamDataReader *reader, Type *value) {
+    value->year = reader->Read<uint16_t>();
+    value->month = reader->Read<uint8_t>();
+    value->day = reader->Read<uint8_t>();
+    value->hour = reader->Read<uint8_t>();
+    value->minute = reader->Read<uint8_t>();
+    value->second = reader->Read<uint8_t>();
+  }
+};
+/**
+ * @endcond
+ */
+
+
+/**
+ * @brief Pack a parameter into a buffer.
+ * @tparam PID the PID to pack, there must be a PidCodec for it.
+ * @param value the parameter to pack.
+ * @param[out] data the buffer to write to, PidCodec<PID>::MAX_SIZE is always
+ *   large enough.
+ * @param size the size of the buffer.
+ * @returns the number of bytes written, or 0 if the buffer was too small.
+ */
+template <rdm_pid PID>
+unsigned int PackParamData(const typename PidCodec<PID>::Type &value,
+                           uint8_t *data, unsigned int size) {
+  ParamDataWriter writer(data, size);
+  PidCodec<PID>::Pack(value, &writer);
+  return writer.Ok() ? writer.Size() : 0;
+}
+
+/**
+ * @brief Unpack the parameter data for a PID.
+ * @tparam PID the PID to unpack, there must be a PidCodec for it.
+ * @param data the parameter data.
+ * @param size the size of the parameter data.
+ * @param[out] value the unpacked parameter.
+ * @returns true if the size was within the limits for the PID, false
+ *   otherwise.
+ */
+template <rdm_pid PID>
+bool UnpackParamData(const uint8_t *data, unsigned int size,
+                     typename PidCodec<PID>::Type *value) {
+  if (size < static_cast<unsigned int>(PidCodec<PID>::MIN_SIZE) ||
+      size > static_cast<unsigned int>(PidCodec<PID>::MAX_SIZE)) {
+    return false;
+  }
+  ParamDataReader reader(data, size);
+  PidCodec<PID>::Unpack(&reader, value);
+  return reader.Ok() && reader.Remaining() == 0;
+}
+}  // namespace rdm
+}  // namespace ola
+#endif  // INCLUDE_OLA_RDM_PARAMDATACODEC_H_
@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include <ola/messaging/Descriptor.h>
 #include <ola/base/Macro.h>
+#include <ola/thread/Mutex.h>
 #include <istream>
 #include <map>
 #include <memory>
@@ -64,11 +65,31 @@ class PidDescriptor;
  * An overrides.proto file can be used as a local system override of any PID
  * data. This allows manufacturers to specify their own manufacturer specific
  * commands and for testing of draft PIDs.
+ *
+ * If the directory contains a compiled store, generated from the .proto files
+ * by pid_store_compiler, it's used instead of parsing the text files. The
+ * manufacturer PidStores are then built the first time they are used.
  */
 class RootPidStore {
  public:
   typedef std::map<uint16_t, const PidStore*> ManufacturerMap;
 
+  /**
+   * @brief Builds manufacturer PidStores on demand.
+   */
+  class ManufacturerStoreLoader {
+   public:
+    virtual ~ManufacturerStoreLoader() {}
+
+    /**
+     * @brief Build the PidStore for a manufacturer.
+     * @param esta_id the manufacturer id.
+     * @returns A new PidStore, or NULL if there were no parameters for this
+     * manufacturer or the parameters were invalid.
+     */
+    virtual const PidStore *LoadStore(uint16_t esta_id) = 0;
+  };
+
   /**
    * @brief Create a new RootPidStore.
    *
@@ -83,6 +104,23 @@ class RootPidStore {
         m_version(version) {
   }
 
+  /**
+   * @brief Create a new RootPidStore which loads the manufacturer PidStores
+   * when they are first used.
+   * @param esta_store the PidStore for the ESTA parameters, ownership is
+   *   transferred.
+   * @param loader the ManufacturerStoreLoader to use, ownership is
+   *   transferred.
+   * @param version the version of the parameter data.
+   */
+  RootPidStore(const PidStore *esta_store,
+               ManufacturerStoreLoader *loader,
+               uint64_t version = 0)
+      : m_esta_store(esta_store),
+        m_loader(loader),
+        m_version(version) {
+  }
+
   ~RootPidStore();
 
   /**
@@ -170,7 +208,10 @@ class RootPidStore {
 
  private:
   std::auto_ptr<const PidStore> m_esta_store;
-  ManufacturerMap m_manufacturer_store;
+  std::auto_ptr<ManufacturerStoreLoader> m_loader;
+  // Only modified when there is a loader, in which case m_mutex protects it.
+  mutable ManufacturerMap m_manufacturer_store;
+  mutable ola::thread::Mutex m_mutex;
   uint64_t m_version;
 
   const PidDescriptor *InternalESTANameLookup(
@@ -204,7 +245,9 @@ class PidStore {
    * @brief The number of PidDescriptors in this store.
    * @returns the number of PidDescriptors in this store.
    */
-  unsigned int PidCount() const { return m_pid_by_value.size(); }
+  unsigned int PidCount() const {
+    return static_cast<unsigned int>(m_pid_by_value.size());
+  }
 
   /**
    * @brief Return a list of all PidDescriptors.
@@ -230,10 +273,11 @@ class PidStore {
   const PidDescriptor *LookupPID(const std::string &pid_name) const;
 
  private:
-  typedef std::map<uint16_t, const PidDescriptor*> PidMap;
-  typedef std::map<std::string, const PidDescriptor*> PidNameMap;
-  PidMap m_pid_by_value;
-  PidNameMap m_pid_by_name;
+  // Both lists hold the same descriptors, sorted by value & name so lookups
+  // are a binary search over contiguous memory.
+  typedef std::vector<const PidDescriptor*> PidList;
+  PidList m_pid_by_value;
+  PidList m_pid_by_name;
 
   DISALLOW_COPY_AND_ASSIGN(PidStore);
 };
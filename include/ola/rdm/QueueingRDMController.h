@@ -22,15 +22,18 @@
  * @addtogroup rdm_controller
  * @{
  * @file QueueingRDMController.h
- * @brief An RDM Controller that queues messages and only sends a single message
- * at a time.
+ * @brief An RDM Controller that queues messages and limits how many are in
+ * flight at once.
  * @}
  */
 #ifndef INCLUDE_OLA_RDM_QUEUEINGRDMCONTROLLER_H_
 #define INCLUDE_OLA_RDM_QUEUEINGRDMCONTROLLER_H_
 
+#include <ola/Clock.h>
+#include <ola/base/Macro.h>
 #include <ola/rdm/RDMControllerInterface.h>
-#include <queue>
+#include <deque>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,13 +42,59 @@ namespace ola {
 namespace rdm {
 
 /*
- * A RDM controller that only sends a single request at a time. This also
- * handles timing out messages that we don't get a response for.
+ * A RDM controller that queues requests and limits how many are in flight.
+ *
+ * By default only a single request is in flight at a time. If the underlying
+ * controller can match responses to requests by UID, requests to different
+ * UIDs can be pipelined by increasing max_in_flight.
+ *
+ * Queued requests are scheduled using the RDMRequest's SchedulingOptions.
+ * Interactive requests are sent ahead of bulk ones, although bulk requests
+ * are still given a share of the port. Within each class, clients take turns
+ * so one client can't starve another. A client's requests to the same UID are
+ * always sent in the order they were queued.
  */
 class QueueingRDMController: public RDMControllerInterface {
  public:
+    struct Options {
+     public:
+      explicit Options(unsigned int queue_size)
+          : max_queue_size(queue_size),
+            max_in_flight(1),
+            queue_timeout() {
+      }
+
+      /**
+       * @brief The maximum number of requests to queue.
+       */
+      unsigned int max_queue_size;
+
+      /**
+       * @brief The maximum number of requests to have in flight. Requests in
+       * flight at the same time always have different destinations.
+       */
+      unsigned int max_in_flight;
+
+      /**
+       * @brief Fail requests with RDM_TIMEOUT if they haven't been sent
+       * within this time. Zero disables the deadline.
+       */
+      ola::TimeInterval queue_timeout;
+    };
+
     QueueingRDMController(RDMControllerInterface *controller,
                           unsigned int max_queue_size);
+
+    /**
+     * @brief Create a new QueueingRDMController.
+     * @param controller the controller to send requests with.
+     * @param options the Options to use.
+     * @param clock the clock used for the queue deadlines, ownership is not
+     *   transferred. If NULL a new Clock is created.
+     */
+    QueueingRDMController(RDMControllerInterface *controller,
+                          const Options &options,
+                          ola::Clock *clock = NULL);
     ~QueueingRDMController();
 
     void Pause();
@@ -54,28 +103,77 @@ class QueueingRDMController: public RDMControllerInterface {
     // This can be called multiple times and the requests will be queued.
     void SendRDMRequest(RDMRequest *request, RDMCallback *on_complete);
 
+    /**
+     * @brief The number of requests waiting to be sent.
+     */
+    unsigned int QueueDepth() const { return m_queued_count; }
+
+    /**
+     * @brief The number of requests that have been sent but not completed.
+     */
+    unsigned int InFlight() const {
+      return static_cast<unsigned int>(m_in_flight.size());
+    }
+
  protected:
     typedef struct {
       const RDMRequest *request;
       RDMCallback *on_complete;
+      ola::TimeStamp deadline;
     } outstanding_rdm_request;
 
     RDMControllerInterface *m_controller;
-    unsigned int m_max_queue_size;
-    std::queue<outstanding_rdm_request> m_pending_requests;
-    bool m_rdm_request_pending;  // true if a request is in progress
     bool m_active;  // true if the controller is active
-    std::auto_ptr<RDMCallback> m_callback;
-    std::auto_ptr<ola::rdm::RDMResponse> m_response;
-    std::vector<RDMFrame> m_frames;
 
     virtual void TakeNextAction();
     virtual bool CheckForBlockingCondition();
-    void MaybeSendRDMRequest();
-    void DispatchNextRequest();
+    bool MaybeSendRDMRequest();
+
+ private:
+    class InFlightRequest;
+
+    typedef std::deque<outstanding_rdm_request> RequestQueue;
+
+    // The requests of one priority class. Each client has a queue and the
+    // clients with queued requests take turns in the order given by
+    // client_order.
+    typedef struct {
+      std::map<unsigned int, RequestQueue> client_queues;
+      std::deque<unsigned int> client_order;
+    } PriorityClass;
+
+    enum { INTERACTIVE, BULK, PRIORITY_CLASS_COUNT };
 
-    void HandleRDMResponse(RDMReply *reply);
-    void RunCallback(RDMReply *reply);
+    ola::Clock *m_clock;
+    bool m_free_clock;
+    unsigned int m_max_queue_size;
+    unsigned int m_max_in_flight;
+    ola::TimeInterval m_queue_timeout;
+    PriorityClass m_classes[PRIORITY_CLASS_COUNT];
+    unsigned int m_queued_count;
+    // The number of interactive requests sent in a row while bulk requests
+    // were waiting.
+    unsigned int m_interactive_run;
+    std::vector<InFlightRequest*> m_in_flight;
+
+    void Enqueue(const outstanding_rdm_request &request, bool bulk);
+    bool DropNewestBulkRequest();
+    void ExpireRequests();
+    bool NextRequest(outstanding_rdm_request *request);
+    bool NextRequestFromClass(PriorityClass *priority_class,
+                              outstanding_rdm_request *request);
+    RequestQueue::iterator FirstDispatchable(RequestQueue *queue) const;
+    bool CanDispatch(const RDMRequest *request) const;
+    void Dispatch(InFlightRequest *in_flight);
+
+    void HandleRDMResponse(InFlightRequest *in_flight, RDMReply *reply);
+    void CompleteRequest(InFlightRequest *in_flight, RDMReply *reply);
+
+    // The number of interactive requests that may be sent in a row before a
+    // waiting bulk request is sent.
+    static const unsigned int INTERACTIVE_BURST = 4;
+
+    DISALLOW_COPY_AND_ASSIGN(QueueingRDMController);
 };
 
 
@@ -91,6 +189,11 @@ class DiscoverableQueueingRDMController: public QueueingRDMController {
         DiscoverableRDMControllerInterface *controller,
         unsigned int max_queue_size);
 
+    DiscoverableQueueingRDMController(
+        DiscoverableRDMControllerInterface *controller,
+        const Options &options,
+        ola::Clock *clock = NULL);
+
     ~DiscoverableQueueingRDMController() {}
 
     // These can be called multiple times and the requests will be queued
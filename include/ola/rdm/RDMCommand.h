@@ -55,6 +55,9 @@ namespace rdm {
  *
  * @note RDMCommands may hold more than 231 bytes of data. Use the
  * RDMCommandSerializer class if you want the wire format.
+ *
+ * The parameter data is never modified once the command has been created, so
+ * copies made with Duplicate() share it rather than copying it.
  */
 class RDMCommand {
  public:
@@ -207,6 +210,12 @@ class RDMCommand {
 
   void SetParamData(const uint8_t *data, unsigned int length);
 
+  /**
+   * @brief Share the parameter data of another command.
+   * @param other The command to share the parameter data with.
+   */
+  void ShareParamData(const RDMCommand &other);
+
   static RDMStatusCode VerifyData(const uint8_t *data,
                                   size_t length,
                                   RDMCommandHeader *command_message);
@@ -217,9 +226,14 @@ class RDMCommand {
   uint8_t m_message_count;
   uint16_t m_sub_device;
   uint16_t m_param_id;
-  uint8_t *m_data;
+  struct ParamDataBuffer;
+
+  ParamDataBuffer *m_buffer;
+  const uint8_t *m_data;
   unsigned int m_data_length;
 
+  void ReleaseParamData();
+
   static uint16_t CalculateChecksum(const uint8_t *data,
                                     unsigned int packet_length);
 
@@ -266,6 +280,30 @@ class RDMRequest: public RDMCommand {
     uint16_t checksum;
   };
 
+  /**
+   * @brief Hints used to schedule the request when a port is shared. These
+   * aren't part of the RDM message.
+   */
+  struct SchedulingOptions {
+   public:
+    SchedulingOptions()
+      : client_id(0),
+        bulk(false) {
+    }
+
+    /**
+     * @brief Identifies the client that made the request. Queued requests are
+     * shared fairly between clients.
+     */
+    unsigned int client_id;
+
+    /**
+     * @brief True if the request is part of a bulk operation, like a scan.
+     * Bulk requests yield to interactive ones.
+     */
+    bool bulk;
+  };
+
   /**
    * @brief Create a new request.
    * @param source The source UID.
@@ -303,7 +341,7 @@ class RDMRequest: public RDMCommand {
    * @returns A new RDMRequest that is identical to this one.
    */
   virtual RDMRequest *Duplicate() const {
-    return new RDMRequest(
+    RDMRequest *request = new RDMRequest(
       SourceUID(),
       DestinationUID(),
       TransactionNumber(),
@@ -311,9 +349,12 @@ class RDMRequest: public RDMCommand {
       SubDevice(),
       m_command_class,
       ParamId(),
-      ParamData(),
-      ParamDataSize(),
+      NULL,
+      0,
       m_override_options);
+    request->ShareParamData(*this);
+    request->SetSchedulingOptions(m_scheduling_options);
+    return request;
   }
 
   virtual void Print(CommandPrinter *printer,
@@ -332,6 +373,13 @@ class RDMRequest: public RDMCommand {
   uint8_t MessageLength() const;
   uint16_t Checksum(uint16_t checksum) const;
 
+  /**
+   * @brief The scheduling hints for this request.
+   */
+  const SchedulingOptions& GetSchedulingOptions() const {
+    return m_scheduling_options;
+  }
+
   /**
    * @name Mutators
    * @{
@@ -361,6 +409,14 @@ class RDMRequest: public RDMCommand {
     m_port_id = port_id;
   }
 
+  /**
+   * @brief Set the scheduling hints.
+   * @param options the new SchedulingOptions.
+   */
+  void SetSchedulingOptions(const SchedulingOptions &options) {
+    m_scheduling_options = options;
+  }
+
   /** @} */
 
   /**
@@ -374,6 +430,7 @@ class RDMRequest: public RDMCommand {
 
  protected:
   OverrideOptions m_override_options;
+  SchedulingOptions m_scheduling_options;
 
  private:
   RDMCommandClass m_command_class;
@@ -432,16 +489,19 @@ class BaseRDMRequest: public RDMGetSetRequest {
   }
 
   BaseRDMRequest<command_class> *Duplicate() const {
-    return new BaseRDMRequest<command_class>(
+    BaseRDMRequest<command_class> *request = new BaseRDMRequest<command_class>(
       SourceUID(),
       DestinationUID(),
       TransactionNumber(),
       PortId(),
       SubDevice(),
       ParamId(),
-      ParamData(),
-      ParamDataSize(),
+      NULL,
+      0,
       m_override_options);
+    request->ShareParamData(*this);
+    request->SetSchedulingOptions(m_scheduling_options);
+    return request;
   }
 };
 
@@ -494,7 +554,7 @@ class RDMResponse: public RDMCommand {
    * @returns A new RDMResponse that is identical to this one.
    */
   RDMResponse *Duplicate() const {
-    return new RDMResponse(
+    RDMResponse *response = new RDMResponse(
       SourceUID(),
       DestinationUID(),
       TransactionNumber(),
@@ -503,8 +563,10 @@ class RDMResponse: public RDMCommand {
       SubDevice(),
       CommandClass(),
       ParamId(),
-      ParamData(),
-      ParamDataSize());
+      NULL,
+      0);
+    response->ShareParamData(*this);
+    return response;
   }
 
   /**
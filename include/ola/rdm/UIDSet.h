@@ -32,8 +32,9 @@
 #include <ola/rdm/UID.h>
 #include <algorithm>
 #include <iomanip>
-#include <set>
+#include <iterator>
 #include <string>
+#include <vector>
 
 namespace ola {
 namespace rdm {
@@ -43,6 +44,13 @@ namespace rdm {
  * @{
  * @class UIDSet
  * @brief Represents a set of RDM UIDs.
+ *
+ * The UIDs are kept in a sorted vector, which is much faster to search, merge
+ * and iterate than a tree once there are thousands of UIDs. Adding UIDs in
+ * ascending order is constant time, adding them in a random order is linear
+ * in the size of the set.
+ *
+ * Adding or removing UIDs invalidates any Iterators.
  * @}
  */
 class UIDSet {
@@ -50,7 +58,7 @@ class UIDSet {
     /**
      * @brief the Iterator for a UIDSets
      */
-    typedef std::set<UID>::const_iterator Iterator;
+    typedef std::vector<UID>::const_iterator Iterator;
 
     /**
      * @brief Construct an empty set
@@ -103,7 +111,17 @@ class UIDSet {
      * @param uid the UID to add.
      */
     void AddUID(const UID &uid) {
-      m_uids.insert(uid);
+      // UIDs usually arrive in order, so check the end first.
+      if (m_uids.empty() || PackedLess()(m_uids.back(), uid)) {
+        m_uids.push_back(uid);
+        return;
+      }
+      UIDVector::iterator iter = std::lower_bound(m_uids.begin(),
+                                                  m_uids.end(), uid,
+                                                  PackedLess());
+      if (*iter != uid) {
+        m_uids.insert(iter, uid);
+      }
     }
 
     /**
@@ -111,7 +129,12 @@ class UIDSet {
      * @param uid the UID to remove.
      */
     void RemoveUID(const UID &uid) {
-      m_uids.erase(uid);
+      UIDVector::iterator iter = std::lower_bound(m_uids.begin(),
+                                                  m_uids.end(), uid,
+                                                  PackedLess());
+      if (iter != m_uids.end() && *iter == uid) {
+        m_uids.erase(iter);
+      }
     }
 
     /**
@@ -120,7 +143,8 @@ class UIDSet {
      * @return true if the set contains this UID.
      */
     bool Contains(const UID &uid) const {
-      return m_uids.find(uid) != m_uids.end();
+      return std::binary_search(m_uids.begin(), m_uids.end(), uid,
+                                PackedLess());
     }
 
     /**
@@ -128,14 +152,16 @@ class UIDSet {
      * @param other the UIDSet to perform the union with.
      * @return the union of the two UIDSets.
      */
-    UIDSet Union(const UIDSet &other) {
-      std::set<UID> result;
-      set_union(m_uids.begin(),
-                m_uids.end(),
-                other.Begin(),
-                other.End(),
-                inserter(result, result.begin()));
-      return UIDSet(result);
+    UIDSet Union(const UIDSet &other) const {
+      UIDSet result;
+      result.m_uids.reserve(m_uids.size() + other.m_uids.size());
+      std::set_union(m_uids.begin(),
+                     m_uids.end(),
+                     other.m_uids.begin(),
+                     other.m_uids.end(),
+                     std::back_inserter(result.m_uids),
+                     PackedLess());
+      return result;
     }
 
     /**
@@ -157,14 +183,16 @@ class UIDSet {
      * @param other the UIDSet to subtract from this set.
      * @return the difference between this UIDSet and other.
      */
-    UIDSet SetDifference(const UIDSet &other) {
-      std::set<UID> difference;
+    UIDSet SetDifference(const UIDSet &other) const {
+      UIDSet difference;
+      difference.m_uids.reserve(m_uids.size());
       std::set_difference(m_uids.begin(),
                           m_uids.end(),
                           other.m_uids.begin(),
                           other.m_uids.end(),
-                          std::inserter(difference, difference.begin()));
-      return UIDSet(difference);
+                          std::back_inserter(difference.m_uids),
+                          PackedLess());
+      return difference;
     }
 
     /**
@@ -189,7 +217,7 @@ class UIDSet {
      */
     std::string ToString() const {
       std::ostringstream str;
-      std::set<UID>::const_iterator iter;
+      UIDVector::const_iterator iter;
       for (iter = m_uids.begin(); iter != m_uids.end(); ++iter) {
         if (iter != m_uids.begin())
           str << ",";
@@ -208,11 +236,25 @@ class UIDSet {
     }
 
  private:
-    std::set<UID> m_uids;
+    typedef std::vector<UID> UIDVector;
 
-    explicit UIDSet(const std::set<UID> uids) {
-      m_uids = uids;
-    }
+    /*
+     * Orders UIDs the same way as UID::operator<, but with a single 64 bit
+     * comparison, which keeps the binary searches & merges branch-light.
+     */
+    struct PackedLess {
+      bool operator()(const UID &a, const UID &b) const {
+        return Pack(a) < Pack(b);
+      }
+
+      static uint64_t Pack(const UID &uid) {
+        return (static_cast<uint64_t>(uid.ManufacturerId()) << 32) |
+               uid.DeviceId();
+      }
+    };
+
+    // Sorted, with no duplicates.
+    UIDVector m_uids;
 };
 }  // namespace rdm
 }  // namespace ola
@@ -0,0 +1,105 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * BenchmarkTimer.h
+ * Times the stages of the benchmark programs.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef INCLUDE_OLA_TESTING_BENCHMARKTIMER_H_
+#define INCLUDE_OLA_TESTING_BENCHMARKTIMER_H_
+
+#include <stdint.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "ola/Clock.h"
+#include "ola/base/Macro.h"
+
+namespace ola {
+namespace testing {
+
+/**
+ * @brief Times a block of code and prints the result.
+ *
+ * Each call to Report() prints the time since the last Reset() or Report(),
+ * and then starts timing the next stage.
+ */
+class BenchmarkTimer {
+ public:
+  BenchmarkTimer() { Reset(); }
+
+  /**
+   * @brief Start timing from now.
+   */
+  void Reset() { m_clock.CurrentTime(&m_start); }
+
+  /**
+   * @brief The time since the last Reset() or Report(), in milliseconds.
+   */
+  double ElapsedMs() const {
+    TimeStamp now;
+    m_clock.CurrentTime(&now);
+    return static_cast<double>((now - m_start).AsInt()) / 1000;
+  }
+
+  /**
+   * @brief Print the time taken by a stage.
+   * @param description the name of the stage.
+   */
+  void Report(const std::string &description) {
+    PrintTime(description);
+    std::cout << std::endl;
+    Reset();
+  }
+
+  /**
+   * @brief Print the time taken by a stage, and the throughput.
+   * @param description the name of the stage.
+   * @param bytes the number of bytes processed.
+   * @param operations the number of operations performed, if non-zero the
+   *   rate is printed as well.
+   */
+  void Report(const std::string &description, uint64_t bytes,
+              unsigned int operations = 0) {
+    double ms = PrintTime(description);
+    // Avoid a divide by zero for very short runs.
+    double seconds = ms ? ms / 1000 : 0.000001;
+    if (operations) {
+      std::cout << ", " << std::setw(10) << std::setprecision(0)
+                << operations / seconds << " ops/s";
+    }
+    std::cout << ", " << std::setw(8) << std::setprecision(2)
+              << static_cast<double>(bytes) / seconds / 1000000 << " MB/s"
+              << std::endl;
+    Reset();
+  }
+
+ private:
+  Clock m_clock;
+  TimeStamp m_start;
+
+  double PrintTime(const std::string &description) const {
+    double ms = ElapsedMs();
+    std::cout << std::setw(32) << description << ": " << std::setw(10)
+              << std::fixed << std::setprecision(3) << ms << " ms";
+    return ms;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkTimer);
+};
+}  // namespace testing
+}  // namespace ola
+#endif  // INCLUDE_OLA_TESTING_BENCHMARKTIMER_H_
@@ -1,4 +1,5 @@
 # These aren't installed
 noinst_HEADERS += \
+    include/ola/testing/BenchmarkTimer.h \
     include/ola/testing/MockUDPSocket.h \
     include/ola/testing/TestUtils.h
@@ -34,6 +34,7 @@
 #include <memory>
 #include <stack>
 #include <string>
+#include <vector>
 
 namespace ola {
 namespace web {
@@ -113,11 +114,13 @@ class JsonParser : public JsonParserInterface {
   std::string m_error;
   std::auto_ptr<JsonValue> m_root;
   std::string m_key;
-  std::stack<ContainerType> m_container_stack;
+  // These are backed by vectors, which unlike a deque don't allocate until
+  // something is pushed, and keep their storage between documents.
+  std::stack<ContainerType, std::vector<ContainerType> > m_container_stack;
 
   // The stacks below don't own the objects they point to.
-  std::stack<JsonArray*> m_array_stack;
-  std::stack<JsonObject*> m_object_stack;
+  std::stack<JsonArray*, std::vector<JsonArray*> > m_array_stack;
+  std::stack<JsonObject*, std::vector<JsonObject*> > m_object_stack;
 
   void AddValue(JsonValue *value);
   DISALLOW_COPY_AND_ASSIGN(JsonParser);
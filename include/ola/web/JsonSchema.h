@@ -33,7 +33,6 @@
 #include <ola/stl/STLUtils.h>
 #include <ola/web/Json.h>
 #include <ola/web/JsonTypes.h>
-#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -603,6 +602,31 @@ class ObjectValidator : public BaseValidator, JsonObjectPropertyVisitor {
   typedef std::map<std::string, ValidatorInterface*> SchemaDependencies;
   typedef std::map<std::string, StringSet> PropertyDependencies;
 
+  /*
+   * The maps above are flattened into the structures below the first time
+   * an object is validated, so each property is only looked up once.
+   * Properties that are required, or are part of a dependency, are given a
+   * slot in m_seen.
+   */
+  struct PropertyInfo {
+    PropertyInfo() : validator(NULL), seen_index(NOT_TRACKED) {}
+
+    ValidatorInterface *validator;
+    unsigned int seen_index;
+  };
+
+  struct PropertyDependency {
+    unsigned int property;
+    std::vector<unsigned int> required;
+  };
+
+  struct SchemaDependency {
+    unsigned int property;
+    ValidatorInterface *validator;
+  };
+
+  typedef std::map<std::string, PropertyInfo> PropertyTable;
+
   const Options m_options;
 
   PropertyValidators m_property_validators;
@@ -610,10 +634,19 @@ class ObjectValidator : public BaseValidator, JsonObjectPropertyVisitor {
   PropertyDependencies m_property_dependencies;
   SchemaDependencies m_schema_dependencies;
 
-  StringSet m_seen_properties;
+  bool m_prepared;
+  PropertyTable m_properties;
+  std::vector<unsigned int> m_required_properties;
+  std::vector<PropertyDependency> m_flat_property_dependencies;
+  std::vector<SchemaDependency> m_flat_schema_dependencies;
+  std::vector<bool> m_seen;
 
+  void Prepare();
+  unsigned int SeenIndex(const std::string &property);
   void ExtendSchema(JsonObject *schema) const;
 
+  static const unsigned int NOT_TRACKED;
+
   DISALLOW_COPY_AND_ASSIGN(ObjectValidator);
 };
 
@@ -703,8 +736,6 @@ class ArrayValidator : public BaseValidator {
   void Visit(const JsonArray &array);
 
  private:
-  typedef std::deque<ValidatorInterface*> ValidatorQueue;
-
   const std::auto_ptr<Items> m_items;
   const std::auto_ptr<AdditionalItems> m_additional_items;
   const Options m_options;
@@ -712,35 +743,13 @@ class ArrayValidator : public BaseValidator {
   // This is used if items is missing, or if additionalItems is true.
   std::auto_ptr<WildcardValidator> m_wildcard_validator;
 
-  class ArrayElementValidator : public BaseValidator {
-   public:
-    ArrayElementValidator(const ValidatorList &validators,
-                          ValidatorInterface *default_validator);
-
-    void Visit(const JsonString&);
-    void Visit(const JsonBool&);
-    void Visit(const JsonNull&);
-    void Visit(const JsonRawValue&);
-    void Visit(const JsonObject&);
-    void Visit(const JsonArray &array);
-    void Visit(const JsonUInt&);
-    void Visit(const JsonUInt64&);
-    void Visit(const JsonInt&);
-    void Visit(const JsonInt64&);
-    void Visit(const JsonDouble&);
-
-   private:
-    ValidatorQueue m_item_validators;
-    ValidatorInterface *m_default_validator;
-
-    template <typename T>
-    void ValidateItem(const T &item);
-
-    DISALLOW_COPY_AND_ASSIGN(ArrayElementValidator);
-  };
+  // The validators for the first elements, and the one for the rest of the
+  // elements, or NULL if there can't be any more. These don't own the
+  // validators.
+  ValidatorList m_element_validators;
+  ValidatorInterface *m_default_validator;
 
   void ExtendSchema(JsonObject *schema) const;
-  ArrayElementValidator* ConstructElementValidator() const;
 
   DISALLOW_COPY_AND_ASSIGN(ArrayValidator);
 };
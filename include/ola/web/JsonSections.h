@@ -23,6 +23,7 @@
 
 #include <ola/StringUtils.h>
 #include <ola/web/Json.h>
+#include <ola/web/JsonStreamWriter.h>
 #include <string>
 #include <utility>
 #include <vector>
@@ -210,6 +211,7 @@ class JsonSection {
 
     void AddItem(const GenericItem *item);
     std::string AsString() const;
+    void Write(JsonStreamWriter *writer) const;
 
  private:
     bool m_allow_refresh;
@@ -0,0 +1,163 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * JsonStreamWriter.h
+ * Write JSON text without building a tree of JsonValues.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+/**
+ * @addtogroup json
+ * @{
+ * @file JsonStreamWriter.h
+ * @brief Write JSON text without building a tree of JsonValues.
+ * @}
+ */
+
+#ifndef INCLUDE_OLA_WEB_JSONSTREAMWRITER_H_
+#define INCLUDE_OLA_WEB_JSONSTREAMWRITER_H_
+
+#include <ola/base/Macro.h>
+#include <ola/web/Json.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ola {
+namespace web {
+
+/**
+ * @addtogroup json
+ * @{
+ */
+
+/**
+ * @brief Writes JSON text directly into a string, one value at a time.
+ *
+ * The output is laid out the same way as JsonWriter's, but nothing is
+ * allocated other than the output itself. Unlike a JsonObject, properties are
+ * written in the order they're added, rather than sorted by key.
+ *
+ * @code
+ *   string output;
+ *   JsonStreamWriter writer(&output);
+ *   writer.StartObject();
+ *   writer.Add("universe", 1);
+ *   writer.StartArray("ports");
+ *   writer.Value(1);
+ *   writer.Value(2);
+ *   writer.EndArray();
+ *   writer.EndObject();
+ * @endcode
+ *
+ * Inside an object, each value must be preceded by a call to Key(), or use
+ * the methods that take the key. Arrays which start with an object or array
+ * are written one element per line, like JsonWriter does.
+ */
+class JsonStreamWriter {
+ public:
+  /**
+   * @brief Create a new JsonStreamWriter.
+   * @param output the string to append to. Ownership is not transferred.
+   */
+  explicit JsonStreamWriter(std::string *output);
+
+  /**
+   * @brief Set the key of the next value in an object.
+   */
+  void Key(const std::string &key);
+
+  void StartObject();
+  void StartObject(const std::string &key);
+  void EndObject();
+
+  void StartArray();
+  void StartArray(const std::string &key);
+  void EndArray();
+
+  void Value(const std::string &value);
+  void Value(const char *value);
+  void Value(unsigned int value);
+  void Value(int value);
+  void Value(uint64_t value);
+  void Value(int64_t value);
+  void Value(double value);
+  void Value(bool value);
+
+  /**
+   * @brief Write an existing JsonValue.
+   */
+  void Value(const JsonValue &value);
+
+  void Null();
+
+  /**
+   * @brief Write a value that's already JSON text.
+   */
+  void Raw(const std::string &value);
+
+  /**
+   * @brief Add a property to the current object.
+   */
+  template <typename T>
+  void Add(const std::string &key, const T &value) {
+    Key(key);
+    Value(value);
+  }
+
+  void Add(const std::string &key, const char *value) {
+    Key(key);
+    Value(value);
+  }
+
+  /**
+   * @brief Add a null property to the current object.
+   */
+  void Add(const std::string &key) {
+    Key(key);
+    Null();
+  }
+
+  void AddRaw(const std::string &key, const std::string &value) {
+    Key(key);
+    Raw(value);
+  }
+
+ private:
+  struct Scope {
+    bool is_object;
+    bool has_values;
+    // For arrays, true if each element is on its own line.
+    bool one_per_line;
+  };
+
+  std::string *m_output;
+  std::vector<Scope> m_scopes;
+  unsigned int m_indent;
+
+  void StartValue(bool is_container);
+  void AppendIndent();
+  void AppendUInt(uint64_t value);
+  void AppendString(const std::string &value);
+  void AppendKey(const std::string &key);
+
+  static const unsigned int DEFAULT_INDENT = 2;
+
+  DISALLOW_COPY_AND_ASSIGN(JsonStreamWriter);
+};
+/**@}*/
+}  // namespace web
+}  // namespace ola
+#endif  // INCLUDE_OLA_WEB_JSONSTREAMWRITER_H_
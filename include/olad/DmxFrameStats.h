@@ -0,0 +1,110 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DmxFrameStats.h
+ * Tracks the frame rate, latency & jitter of a stream of DMX frames.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef INCLUDE_OLAD_DMXFRAMESTATS_H_
+#define INCLUDE_OLAD_DMXFRAMESTATS_H_
+
+#include <stdint.h>
+#include <ola/Clock.h>
+
+namespace ola {
+
+/**
+ * @brief Tracks the frame rate, latency & jitter of a stream of DMX frames.
+ *
+ * Frames are counted in a ring of fixed length slots, so recording a frame
+ * is constant time and doesn't allocate. The rates are calculated over the
+ * last second of complete slots, which means they lag by up to one slot.
+ *
+ * Jitter is the mean deviation of the time between frames, estimated the
+ * same way as the interarrival jitter in RFC 3550.
+ */
+class DmxFrameStats {
+ public:
+  DmxFrameStats();
+
+  /**
+   * @brief Record a frame.
+   * @param now the time the frame was received or sent.
+   */
+  void RecordFrame(const TimeStamp &now);
+
+  /**
+   * @brief Record a frame, along with how long it took to get here.
+   * @param now the time the frame was sent.
+   * @param latency the time since the data for this frame arrived.
+   */
+  void RecordFrame(const TimeStamp &now, const TimeInterval &latency);
+
+  /**
+   * @brief The total number of frames recorded.
+   */
+  uint64_t Frames() const { return m_frames; }
+
+  /**
+   * @brief The frame rate over the last second.
+   * @param now the current time.
+   */
+  double FramesPerSecond(const TimeStamp &now) const;
+
+  /**
+   * @brief The mean latency over the last second.
+   * @param now the current time.
+   * @returns the mean latency, or zero if no frames had a latency.
+   */
+  TimeInterval MeanLatency(const TimeStamp &now) const;
+
+  /**
+   * @brief The maximum latency over the last second.
+   * @param now the current time.
+   */
+  TimeInterval MaxLatency(const TimeStamp &now) const;
+
+  /**
+   * @brief The current jitter estimate.
+   */
+  TimeInterval Jitter() const { return TimeInterval(m_jitter >> 4); }
+
+ private:
+  // The window is made up of WINDOW_SLOTS complete slots, plus the current
+  // one.
+  enum { WINDOW_SLOTS = 10, RING_SIZE = WINDOW_SLOTS + 1 };
+
+  struct Slot {
+    int64_t index;
+    unsigned int frames;
+    unsigned int latency_count;
+    int64_t latency_sum;
+    int64_t max_latency;
+  };
+
+  Slot m_slots[RING_SIZE];
+  uint64_t m_frames;
+  TimeStamp m_last_frame;
+  int64_t m_last_interval;
+  int64_t m_jitter;  // in microseconds, scaled by 16
+
+  Slot *CurrentSlot(const TimeStamp &now);
+  bool InWindow(const Slot &slot, int64_t current_index) const;
+
+  static int64_t SlotIndex(const TimeStamp &now);
+};
+}  // namespace ola
+#endif  // INCLUDE_OLAD_DMXFRAMESTATS_H_
@@ -1,5 +1,6 @@
 oladinclude_HEADERS = \
     include/olad/Device.h \
+    include/olad/DmxFrameStats.h \
     include/olad/DmxSource.h \
     include/olad/Plugin.h \
     include/olad/PluginAdaptor.h \
@@ -30,6 +30,7 @@
 #include <ola/rdm/UID.h>
 #include <ola/rdm/UIDSet.h>
 #include <ola/util/SequenceNumber.h>
+#include <olad/DmxFrameStats.h>
 #include <olad/DmxSource.h>
 
 #include <set>
@@ -42,6 +43,7 @@ namespace ola {
 class Client;
 class InputPort;
 class OutputPort;
+class Port;
 
 class Universe: public ola::rdm::RDMControllerInterface {
  public:
@@ -125,6 +127,13 @@ class Universe: public ola::rdm::RDMControllerInterface {
     //    stale == client that has not sent data
     void CleanStaleSourceClients();
 
+    // Frame statistics, for the data arriving from ports & clients and the
+    // data sent to the output ports & sink clients.
+    const DmxFrameStats &InputStats() const { return m_input_stats; }
+    const DmxFrameStats &OutputStats() const { return m_output_stats; }
+    // Returns NULL if the port isn't part of this universe.
+    const DmxFrameStats *PortStats(const Port *port) const;
+
     // RDM methods
     void SendRDMRequest(ola::rdm::RDMRequest *request,
                         ola::rdm::RDMCallback *callback);
@@ -147,9 +156,17 @@ class Universe: public ola::rdm::RDMControllerInterface {
     static const char K_UNIVERSE_NAME_VAR[];
     static const char K_UNIVERSE_OUTPUT_PORT_VAR[];
     static const char K_UNIVERSE_RDM_REQUESTS[];
+    static const char K_UNIVERSE_RDM_OUTSTANDING_VAR[];
+    static const char K_UNIVERSE_RDM_TIME_VAR[];
     static const char K_UNIVERSE_SINK_CLIENTS_VAR[];
     static const char K_UNIVERSE_SOURCE_CLIENTS_VAR[];
     static const char K_UNIVERSE_UID_COUNT_VAR[];
+    static const char K_UNIVERSE_DROPPED_VAR[];
+    static const char K_UNIVERSE_MERGE_LATENCY_VAR[];
+    static const char K_UNIVERSE_INPUT_FRAMES_VAR[];
+    static const char K_UNIVERSE_INPUT_JITTER_VAR[];
+    static const char K_UNIVERSE_OUTPUT_JITTER_VAR[];
+    static const char K_UNIVERSE_OUTPUT_LATENCY_VAR[];
 
  private:
     typedef struct {
@@ -160,6 +177,14 @@ class Universe: public ola::rdm::RDMControllerInterface {
       std::vector<rdm::RDMFrame> frames;
     } broadcast_request_tracker;
 
+    // An RDM request sent by this universe. The universe is set to NULL if
+    // it's deleted before the reply arrives.
+    typedef struct {
+      Universe *universe;
+      TimeStamp start_time;
+      ola::rdm::RDMCallback *callback;
+    } rdm_request_tracker;
+
     typedef std::map<Client*, bool> SourceClientMap;
 
     std::string m_universe_name;
@@ -183,12 +208,34 @@ class Universe: public ola::rdm::RDMControllerInterface {
     TimeInterval m_rdm_discovery_interval;
     TimeStamp m_last_discovery_time;
     ola::SequenceNumber<uint8_t> m_transaction_number_sequence;
+    // ExportMap entries that are updated for each frame, NULL if there isn't
+    // an ExportMap.
+    unsigned int *m_frame_count;
+    unsigned int *m_dropped_count;
+    Histogram *m_merge_latency;
+    unsigned int *m_input_frame_count;
+    unsigned int *m_input_jitter;
+    unsigned int *m_output_jitter;
+    Histogram *m_output_latency;
+    Histogram *m_rdm_request_time;
+    std::set<rdm_request_tracker*> m_pending_rdm_requests;
+
+    typedef std::map<const Port*, DmxFrameStats> PortStatsMap;
+
+    DmxFrameStats m_input_stats;
+    DmxFrameStats m_output_stats;
+    PortStatsMap m_port_stats;
 
+    static void HandleRDMReply(rdm_request_tracker *tracker,
+                               ola::rdm::RDMReply *reply);
     void HandleBroadcastAck(broadcast_request_tracker *tracker,
                             ola::rdm::RDMReply *reply);
     void HandleBroadcastDiscovery(broadcast_request_tracker *tracker,
                                   ola::rdm::RDMReply *reply);
-    bool UpdateDependants();
+    bool UpdateDependants(const TimeStamp *arrival = NULL);
+    void RecordMergeLatency(const TimeStamp &start);
+    TimeStamp RecordInputFrame(const Port *port, const TimeStamp &timestamp,
+                               const TimeStamp &now);
     void UpdateName();
     void UpdateMode();
     void HTPMergeSources(const std::vector<DmxSource> &sources);
@@ -18,6 +18,7 @@
  * Copyright (C) 2007 Simon Newton
  */
 
+#include <string.h>
 #include <sys/time.h>
 #include <algorithm>
 #include <map>
@@ -41,12 +42,31 @@ using std::vector;
 const TimeInterval DMPE131Inflator::EXPIRY_INTERVAL(2500000);
 
 
+DMPE131Inflator::DMPE131Inflator(bool ignore_preview,
+                                 uint8_t max_sources,
+                                 ola::Clock *clock)
+    : DMPInflator(),
+      m_ignore_preview(ignore_preview),
+      m_max_sources(max_sources),
+      m_clock(clock),
+      m_free_clock(false) {
+  if (!m_clock) {
+    m_clock = new ola::Clock();
+    m_free_clock = true;
+  }
+}
+
+
 DMPE131Inflator::~DMPE131Inflator() {
   UniverseHandlers::iterator iter;
   for (iter = m_handlers.begin(); iter != m_handlers.end(); ++iter) {
     delete iter->second.closure;
   }
   m_handlers.clear();
+
+  if (m_free_clock) {
+    delete m_clock;
+  }
 }
 
 
@@ -186,7 +206,10 @@ bool DMPE131Inflator::SetHandler(uint16_t universe,
     handler.closure = closure;
     handler.active_priority = 0;
     handler.priority = priority;
-    m_handlers[universe] = handler;
+    iter = m_handlers.insert(std::make_pair(universe, handler)).first;
+    // Reserve space for the max number of sources up front, so we never
+    // reallocate while receiving data.
+    iter->second.sources.reserve(m_max_sources);
   } else {
     Callback0<void> *old_closure = iter->second.closure;
     iter->second.closure = closure;
@@ -247,29 +270,20 @@ bool DMPE131Inflator::TrackSourceIfRequired(
 
   *buffer = NULL;  // default the buffer to NULL
   ola::TimeStamp now;
-  m_clock.CurrentTime(&now);
+  m_clock->CurrentTime(&now);
   const E131Header &e131_header = headers.GetE131Header();
   uint8_t priority = e131_header.Priority();
+  const CID cid = headers.GetRootHeader().GetCid();
+  const cid_key key = KeyFromCID(cid);
   vector<dmx_source> &sources = universe_data->sources;
-  vector<dmx_source>::iterator iter = sources.begin();
 
-  while (iter != sources.end()) {
-    if (iter->cid != headers.GetRootHeader().GetCid()) {
-      TimeStamp expiry_time = iter->last_heard_from + EXPIRY_INTERVAL;
-      if (now > expiry_time) {
-        OLA_INFO << "source " << iter->cid.ToString() << " has expired";
-        iter = sources.erase(iter);
-        continue;
-      }
-    }
-    iter++;
+  if (now > universe_data->next_expiry) {
+    ExpireSources(universe_data, key, now);
   }
 
-  if (sources.empty())
-    universe_data->active_priority = 0;
-
-  for (iter = sources.begin(); iter != sources.end(); ++iter) {
-    if (iter->cid == headers.GetRootHeader().GetCid())
+  vector<dmx_source>::iterator iter = sources.begin();
+  for (; iter != sources.end(); ++iter) {
+    if (KeysMatch(iter->key, key))
       break;
   }
 
@@ -288,20 +302,23 @@ bool DMPE131Inflator::TrackSourceIfRequired(
       universe_data->active_priority = priority;
     }
 
-    if (sources.size() == MAX_MERGE_SOURCES) {
+    if (sources.size() >= m_max_sources) {
       // TODO(simon): flag this in the export map
       OLA_WARN << "Max merge sources reached for universe " <<
-        e131_header.Universe() << ", " <<
-        headers.GetRootHeader().GetCid().ToString() << " won't be tracked";
+        e131_header.Universe() << ", " << cid.ToString() <<
+        " won't be tracked";
         return false;
     } else {
-      OLA_INFO << "Added new E1.31 source: " <<
-        headers.GetRootHeader().GetCid().ToString();
+      OLA_INFO << "Added new E1.31 source: " << cid.ToString();
       dmx_source new_source;
-      new_source.cid = headers.GetRootHeader().GetCid();
+      new_source.key = key;
+      new_source.cid = cid;
       new_source.sequence = e131_header.Sequence();
       new_source.last_heard_from = now;
       iter = sources.insert(sources.end(), new_source);
+      if (sources.size() == 1) {
+        universe_data->next_expiry = now + EXPIRY_INTERVAL;
+      }
       *buffer = &iter->buffer;
       return true;
     }
@@ -319,7 +336,7 @@ bool DMPE131Inflator::TrackSourceIfRequired(
     iter->sequence = e131_header.Sequence();
 
     if (e131_header.StreamTerminated()) {
-      OLA_INFO << "CID " << headers.GetRootHeader().GetCid().ToString() <<
+      OLA_INFO << "CID " << cid.ToString() <<
         " sent a termination for universe " << e131_header.Universe();
       sources.erase(iter);
       if (sources.empty())
@@ -351,5 +368,53 @@ bool DMPE131Inflator::TrackSourceIfRequired(
     return true;
   }
 }
+
+
+/*
+ * Remove any sources, other than the one that sent this packet, that we
+ * haven't heard from within EXPIRY_INTERVAL.
+ *
+ * This also works out when the next source could expire, so we only walk the
+ * list of sources when there is something to remove, rather than on every
+ * packet. Since last_heard_from only ever moves forward, the stored time is
+ * always at or before the real next expiry.
+ */
+void DMPE131Inflator::ExpireSources(universe_handler *universe_data,
+                                    const cid_key &key,
+                                    const TimeStamp &now) {
+  vector<dmx_source> &sources = universe_data->sources;
+  TimeStamp next_expiry = now + EXPIRY_INTERVAL;
+
+  vector<dmx_source>::iterator iter = sources.begin();
+  while (iter != sources.end()) {
+    if (!KeysMatch(iter->key, key)) {
+      TimeStamp expiry_time = iter->last_heard_from + EXPIRY_INTERVAL;
+      if (now > expiry_time) {
+        OLA_INFO << "source " << iter->cid.ToString() << " has expired";
+        iter = sources.erase(iter);
+        continue;
+      }
+      next_expiry = std::min(next_expiry, expiry_time);
+    }
+    iter++;
+  }
+
+  if (sources.empty())
+    universe_data->active_priority = 0;
+  universe_data->next_expiry = next_expiry;
+}
+
+
+/*
+ * Pack a CID into a key.
+ */
+DMPE131Inflator::cid_key DMPE131Inflator::KeyFromCID(const CID &cid) {
+  uint8_t data[CID::CID_LENGTH];
+  cid.Pack(data);
+  cid_key key;
+  memcpy(&key.high, data, sizeof(key.high));
+  memcpy(&key.low, data + sizeof(key.high), sizeof(key.low));
+  return key;
+}
 }  // namespace acn
 }  // namespace ola
@@ -36,10 +36,16 @@ class DMPE131Inflator: public DMPInflator {
   friend class DMPE131InflatorTest;
 
  public:
-    explicit DMPE131Inflator(bool ignore_preview):
-      DMPInflator(),
-      m_ignore_preview(ignore_preview) {
-    }
+    /**
+     * @brief Create a new DMPE131Inflator.
+     * @param ignore_preview true to discard preview data.
+     * @param max_sources the max number of sources to merge per universe.
+     * @param clock the Clock to use for source expiry, if NULL a new Clock is
+     *   created.
+     */
+    explicit DMPE131Inflator(bool ignore_preview,
+                             uint8_t max_sources = DEFAULT_MAX_SOURCES,
+                             ola::Clock *clock = NULL);
     ~DMPE131Inflator();
 
     bool SetHandler(uint16_t universe, ola::DmxBuffer *buffer,
@@ -48,6 +54,11 @@ class DMPE131Inflator: public DMPInflator {
 
     void RegisteredUniverses(std::vector<uint16_t> *universes);
 
+    /**
+     * @brief The default number of sources we'll merge per universe.
+     */
+    static const uint8_t DEFAULT_MAX_SOURCES = 6;
+
  protected:
     virtual bool HandlePDUData(uint32_t vector,
                                const HeaderSet &headers,
@@ -55,7 +66,17 @@ class DMPE131Inflator: public DMPInflator {
                                unsigned int pdu_len);
 
  private:
+    /*
+     * The packed form of a CID. Comparing these is much cheaper than
+     * comparing CID objects.
+     */
+    typedef struct {
+      uint64_t high;
+      uint64_t low;
+    } cid_key;
+
     typedef struct {
+      cid_key key;
       ola::acn::CID cid;
       uint8_t sequence;
       TimeStamp last_heard_from;
@@ -67,6 +88,8 @@ class DMPE131Inflator: public DMPInflator {
       Callback0<void> *closure;
       uint8_t active_priority;
       uint8_t *priority;
+      // Sources are only checked for expiry once this time has passed.
+      TimeStamp next_expiry;
       std::vector<dmx_source> sources;
     } universe_handler;
 
@@ -74,14 +97,21 @@ class DMPE131Inflator: public DMPInflator {
 
     UniverseHandlers m_handlers;
     bool m_ignore_preview;
-    ola::Clock m_clock;
+    const uint8_t m_max_sources;
+    ola::Clock *m_clock;
+    bool m_free_clock;
 
     bool TrackSourceIfRequired(universe_handler *universe_data,
                                const HeaderSet &headers,
                                DmxBuffer **buffer);
+    void ExpireSources(universe_handler *universe_data, const cid_key &key,
+                       const TimeStamp &now);
+
+    static cid_key KeyFromCID(const ola::acn::CID &cid);
+    static bool KeysMatch(const cid_key &key1, const cid_key &key2) {
+      return key1.high == key2.high && key1.low == key2.low;
+    }
 
-    // The max number of sources we'll track per universe.
-    static const uint8_t MAX_MERGE_SOURCES = 6;
     // The max merge priority.
     static const uint8_t MAX_E131_PRIORITY = 200;
     // ignore packets that differ by less than this amount from the last one
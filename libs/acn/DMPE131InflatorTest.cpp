@@ -0,0 +1,352 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMPE131InflatorTest.cpp
+ * Test fixture for the DMPE131Inflator class
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string.h>
+#include <vector>
+
+#include "ola/Callback.h"
+#include "ola/Clock.h"
+#include "ola/Constants.h"
+#include "ola/DmxBuffer.h"
+#include "ola/acn/ACNVectors.h"
+#include "ola/acn/CID.h"
+#include "ola/network/NetworkUtils.h"
+#include "libs/acn/DMPAddress.h"
+#include "libs/acn/DMPE131Inflator.h"
+#include "libs/acn/DMPHeader.h"
+#include "libs/acn/E131Header.h"
+#include "libs/acn/HeaderSet.h"
+#include "libs/acn/RootHeader.h"
+#include "ola/testing/TestUtils.h"
+
+namespace ola {
+namespace acn {
+
+using ola::DmxBuffer;
+using ola::network::HostToNetwork;
+using std::vector;
+
+class DMPE131InflatorTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DMPE131InflatorTest);
+  CPPUNIT_TEST(testSingleSource);
+  CPPUNIT_TEST(testMerge);
+  CPPUNIT_TEST(testMaxSources);
+  CPPUNIT_TEST(testPriority);
+  CPPUNIT_TEST(testExpiry);
+  CPPUNIT_TEST(testManySources);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  DMPE131InflatorTest() : m_handler_calls(0) {}
+
+  void testSingleSource();
+  void testMerge();
+  void testMaxSources();
+  void testPriority();
+  void testExpiry();
+  void testManySources();
+
+ private:
+  ola::MockClock m_clock;
+  unsigned int m_handler_calls;
+
+  void HandlerCalled() { m_handler_calls++; }
+
+  bool SendData(DMPE131Inflator *inflator,
+                const CID &cid,
+                uint16_t universe,
+                uint8_t priority,
+                uint8_t sequence,
+                const DmxBuffer &data);
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DMPE131InflatorTest);
+
+
+/*
+ * Pass a DMP set property message to the inflator.
+ */
+bool DMPE131InflatorTest::SendData(DMPE131Inflator *inflator,
+                                   const CID &cid,
+                                   uint16_t universe,
+                                   uint8_t priority,
+                                   uint8_t sequence,
+                                   const DmxBuffer &data) {
+  RootHeader root_header;
+  root_header.SetCid(cid);
+  HeaderSet headers;
+  headers.SetRootHeader(root_header);
+  headers.SetE131Header(E131Header("source", priority, sequence, universe));
+  headers.SetDMPHeader(DMPHeader(true, false, RANGE_EQUAL, TWO_BYTES));
+
+  // start, increment & number, followed by the start code and data
+  uint16_t address[3];
+  address[0] = HostToNetwork(static_cast<uint16_t>(0));
+  address[1] = HostToNetwork(static_cast<uint16_t>(1));
+  address[2] = HostToNetwork(static_cast<uint16_t>(data.Size() + 1));
+
+  uint8_t pdu_data[sizeof(address) + DMX_UNIVERSE_SIZE + 1];
+  memcpy(pdu_data, address, sizeof(address));
+  pdu_data[sizeof(address)] = DMX512_START_CODE;
+  unsigned int length = DMX_UNIVERSE_SIZE;
+  data.Get(pdu_data + sizeof(address) + 1, &length);
+
+  return inflator->HandlePDUData(
+      ola::acn::DMP_SET_PROPERTY_VECTOR, headers, pdu_data,
+      static_cast<unsigned int>(sizeof(address) + length + 1));
+}
+
+
+/*
+ * Check a single source is passed through.
+ */
+void DMPE131InflatorTest::testSingleSource() {
+  DMPE131Inflator inflator(true, DMPE131Inflator::DEFAULT_MAX_SOURCES,
+                           &m_clock);
+  DmxBuffer output;
+  uint8_t priority = 0;
+  OLA_ASSERT(inflator.SetHandler(
+      1, &output, &priority,
+      NewCallback(this, &DMPE131InflatorTest::HandlerCalled)));
+
+  DmxBuffer data;
+  data.SetFromString("1,2,3,4");
+  CID cid = CID::Generate();
+  OLA_ASSERT(SendData(&inflator, cid, 1, 100, 0, data));
+  OLA_ASSERT_EQ(1u, m_handler_calls);
+  OLA_ASSERT_EQ(static_cast<uint8_t>(100), priority);
+  OLA_ASSERT(data == output);
+
+  // data for another universe is ignored
+  OLA_ASSERT(SendData(&inflator, cid, 2, 100, 1, data));
+  OLA_ASSERT_EQ(1u, m_handler_calls);
+
+  // an old sequence number is ignored
+  DmxBuffer new_data;
+  new_data.SetFromString("5,6,7,8");
+  OLA_ASSERT(SendData(&inflator, cid, 1, 100, 0, new_data));
+  OLA_ASSERT_EQ(1u, m_handler_calls);
+  OLA_ASSERT(data == output);
+
+  OLA_ASSERT(SendData(&inflator, cid, 1, 100, 1, new_data));
+  OLA_ASSERT_EQ(2u, m_handler_calls);
+  OLA_ASSERT(new_data == output);
+}
+
+
+/*
+ * Check that sources at the same priority are HTP merged.
+ */
+void DMPE131InflatorTest::testMerge() {
+  DMPE131Inflator inflator(true, DMPE131Inflator::DEFAULT_MAX_SOURCES,
+                           &m_clock);
+  DmxBuffer output;
+  uint8_t priority = 0;
+  inflator.SetHandler(1, &output, &priority,
+                      NewCallback(this, &DMPE131InflatorTest::HandlerCalled));
+
+  DmxBuffer data1, data2, expected;
+  data1.SetFromString("10,0,30");
+  data2.SetFromString("0,20,5");
+  expected.SetFromString("10,20,30");
+
+  OLA_ASSERT(SendData(&inflator, CID::Generate(), 1, 100, 0, data1));
+  OLA_ASSERT(SendData(&inflator, CID::Generate(), 1, 100, 0, data2));
+  OLA_ASSERT_EQ(2u, m_handler_calls);
+  OLA_ASSERT(expected == output);
+}
+
+
+/*
+ * Check we don't track more than the max number of sources.
+ */
+void DMPE131InflatorTest::testMaxSources() {
+  DMPE131Inflator inflator(true, 2, &m_clock);
+  DmxBuffer output;
+  uint8_t priority = 0;
+  inflator.SetHandler(1, &output, &priority,
+                      NewCallback(this, &DMPE131InflatorTest::HandlerCalled));
+
+  DmxBuffer data1, data2, data3, expected;
+  data1.SetFromString("10,0,0");
+  data2.SetFromString("0,20,0");
+  data3.SetFromString("0,0,30");
+  expected.SetFromString("10,20,0");
+
+  CID cid1 = CID::Generate();
+  CID cid2 = CID::Generate();
+  CID cid3 = CID::Generate();
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 100, 0, data1));
+  OLA_ASSERT(SendData(&inflator, cid2, 1, 100, 0, data2));
+  OLA_ASSERT(SendData(&inflator, cid3, 1, 100, 0, data3));
+  OLA_ASSERT_EQ(2u, m_handler_calls);
+  OLA_ASSERT(expected == output);
+
+  // once a source terminates, there is room for the third source
+  RootHeader root_header;
+  root_header.SetCid(cid2);
+  HeaderSet headers;
+  headers.SetRootHeader(root_header);
+  headers.SetE131Header(E131Header("source", 100, 1, 1, false, true));
+  headers.SetDMPHeader(DMPHeader(true, false, RANGE_EQUAL, TWO_BYTES));
+  uint16_t address[3] = {0, HostToNetwork(static_cast<uint16_t>(1)), 0};
+  inflator.HandlePDUData(ola::acn::DMP_SET_PROPERTY_VECTOR, headers,
+                         reinterpret_cast<uint8_t*>(address),
+                         sizeof(address));
+
+  expected.SetFromString("10,0,30");
+  OLA_ASSERT(SendData(&inflator, cid3, 1, 100, 1, data3));
+  OLA_ASSERT(expected == output);
+}
+
+
+/*
+ * Check that a higher priority source takes over.
+ */
+void DMPE131InflatorTest::testPriority() {
+  DMPE131Inflator inflator(true, DMPE131Inflator::DEFAULT_MAX_SOURCES,
+                           &m_clock);
+  DmxBuffer output;
+  uint8_t priority = 0;
+  inflator.SetHandler(1, &output, &priority,
+                      NewCallback(this, &DMPE131InflatorTest::HandlerCalled));
+
+  DmxBuffer data1, data2;
+  data1.SetFromString("10,0,30");
+  data2.SetFromString("0,20,5");
+
+  CID cid1 = CID::Generate();
+  CID cid2 = CID::Generate();
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 100, 0, data1));
+  OLA_ASSERT(SendData(&inflator, cid2, 1, 150, 0, data2));
+  OLA_ASSERT(data2 == output);
+  OLA_ASSERT_EQ(static_cast<uint8_t>(150), priority);
+
+  // lower priority data is now ignored
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 100, 1, data1));
+  OLA_ASSERT(data2 == output);
+}
+
+
+/*
+ * Check that sources expire.
+ */
+void DMPE131InflatorTest::testExpiry() {
+  DMPE131Inflator inflator(true, DMPE131Inflator::DEFAULT_MAX_SOURCES,
+                           &m_clock);
+  DmxBuffer output;
+  uint8_t priority = 0;
+  inflator.SetHandler(1, &output, &priority,
+                      NewCallback(this, &DMPE131InflatorTest::HandlerCalled));
+
+  DmxBuffer data1, data2, expected;
+  data1.SetFromString("10,0,30");
+  data2.SetFromString("0,20,5");
+  expected.SetFromString("10,20,30");
+
+  CID cid1 = CID::Generate();
+  CID cid2 = CID::Generate();
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 100, 0, data1));
+  OLA_ASSERT(SendData(&inflator, cid2, 1, 100, 0, data2));
+  OLA_ASSERT(expected == output);
+
+  // Keep the second source alive
+  m_clock.AdvanceTime(2, 0);
+  OLA_ASSERT(SendData(&inflator, cid2, 1, 100, 1, data2));
+  OLA_ASSERT(expected == output);
+
+  m_clock.AdvanceTime(1, 0);
+  OLA_ASSERT(SendData(&inflator, cid2, 1, 100, 2, data2));
+  OLA_ASSERT(data2 == output);
+
+  // The second source is still around, so a lower priority source is ignored
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 50, 1, data1));
+  OLA_ASSERT(data2 == output);
+
+  // once it's gone the lower priority source is accepted
+  m_clock.AdvanceTime(3, 0);
+  OLA_ASSERT(SendData(&inflator, cid1, 1, 50, 2, data1));
+  OLA_ASSERT(data1 == output);
+  OLA_ASSERT_EQ(static_cast<uint8_t>(50), priority);
+}
+
+
+/*
+ * Stress test with 50 sources across 500 universes.
+ */
+void DMPE131InflatorTest::testManySources() {
+  const unsigned int SOURCE_COUNT = 50;
+  const uint16_t UNIVERSE_COUNT = 500;
+  const unsigned int ROUNDS = 2;
+
+  DMPE131Inflator inflator(true, SOURCE_COUNT, &m_clock);
+  vector<DmxBuffer> outputs(UNIVERSE_COUNT);
+  uint8_t priority = 0;
+  for (uint16_t universe = 0; universe < UNIVERSE_COUNT; universe++) {
+    inflator.SetHandler(
+        universe + 1, &outputs[universe], &priority,
+        NewCallback(this, &DMPE131InflatorTest::HandlerCalled));
+  }
+
+  vector<CID> cids;
+  for (unsigned int i = 0; i < SOURCE_COUNT; i++) {
+    cids.push_back(CID::Generate());
+  }
+
+  // each source sets a single channel
+  vector<DmxBuffer> source_data(SOURCE_COUNT);
+  for (unsigned int i = 0; i < SOURCE_COUNT; i++) {
+    source_data[i].SetRangeToValue(0, 0, SOURCE_COUNT);
+    source_data[i].SetChannel(i, static_cast<uint8_t>(i + 1));
+  }
+
+  for (unsigned int round = 0; round < ROUNDS; round++) {
+    for (uint16_t universe = 0; universe < UNIVERSE_COUNT; universe++) {
+      for (unsigned int i = 0; i < SOURCE_COUNT; i++) {
+        OLA_ASSERT(SendData(&inflator, cids[i], universe + 1, 100,
+                            static_cast<uint8_t>(round), source_data[i]));
+      }
+    }
+    m_clock.AdvanceTime(0, 25000);
+  }
+
+  OLA_ASSERT_EQ(ROUNDS * SOURCE_COUNT * UNIVERSE_COUNT, m_handler_calls);
+  for (uint16_t universe = 0; universe < UNIVERSE_COUNT; universe++) {
+    for (unsigned int i = 0; i < SOURCE_COUNT; i++) {
+      OLA_ASSERT_EQ(static_cast<uint8_t>(i + 1), outputs[universe].Get(i));
+    }
+  }
+
+  // One more source is over the limit and is ignored.
+  DmxBuffer extra_data;
+  extra_data.SetRangeToValue(0, 255, SOURCE_COUNT);
+  OLA_ASSERT(SendData(&inflator, CID::Generate(), 1, 100, 0, extra_data));
+  OLA_ASSERT_EQ(static_cast<uint8_t>(1), outputs[0].Get(0));
+
+  // All sources expire, apart from the one that keeps sending
+  m_clock.AdvanceTime(3, 0);
+  OLA_ASSERT(SendData(&inflator, cids[0], 1, 100,
+                      static_cast<uint8_t>(ROUNDS), source_data[0]));
+  OLA_ASSERT(source_data[0] == outputs[0]);
+}
+}  // namespace acn
+}  // namespace ola
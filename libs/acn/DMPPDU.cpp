@@ -24,6 +24,7 @@
 namespace ola {
 namespace acn {
 
+using ola::io::IOStack;
 using ola::io::OutputStream;
 
 /*
@@ -50,6 +51,20 @@ void DMPPDU::PackHeader(OutputStream *stream) const {
 }
 
 
+/*
+ * Prepend a DMP flags, length, vector & header. The addresses & data must
+ * already be on the stack.
+ */
+void DMPPDU::PrependPDU(IOStack *stack,
+                        uint8_t vector,
+                        const DMPHeader &header) {
+  uint8_t header_byte = header.Header();
+  stack->Write(&header_byte, DMPHeader::DMP_HEADER_SIZE);
+  stack->Write(&vector, sizeof(vector));
+  PrependFlagsAndLength(stack);
+}
+
+
 /*
  * Create a new Single Address GetProperty PDU.
  * @param is_virtual set to true if this is a virtual address
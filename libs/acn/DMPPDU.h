@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "ola/acn/ACNVectors.h"
+#include "ola/io/IOStack.h"
 #include "libs/acn/DMPAddress.h"
 #include "libs/acn/DMPHeader.h"
 #include "libs/acn/PDU.h"
@@ -48,6 +49,10 @@ class DMPPDU: public PDU {
     bool PackHeader(uint8_t *data, unsigned int *length) const;
     void PackHeader(ola::io::OutputStream *stream) const;
 
+    static void PrependPDU(ola::io::IOStack *stack,
+                           uint8_t vector,
+                           const DMPHeader &header);
+
  protected:
     DMPHeader m_header;
 };
@@ -288,6 +293,34 @@ const DMPPDU *NewRangeDMPSetProperty(
                    TypeToDMPSize<type>());
   return new DMPSetProperty<RangeDMPAddress<type> >(header, chunks);
 }
+
+
+/*
+ * Prepend a SetProperty PDU with a single range address to an IOStack. The
+ * property data must already be on the stack. This produces the same bytes as
+ * NewRangeDMPSetProperty() with a single chunk, without building the PDU
+ * objects or copying the data again.
+ * @param stack the IOStack holding the property data
+ * @param is_virtual set to true if this is a virtual address
+ * @param is_relative set to true if this is a relative address
+ * @param address the range address for the data
+ */
+template <typename type>
+void PrependRangeDMPSetProperty(ola::io::IOStack *stack,
+                                bool is_virtual,
+                                bool is_relative,
+                                const RangeDMPAddress<type> &address) {
+  uint8_t packed_address[3 * sizeof(type)];
+  unsigned int address_size = sizeof(packed_address);
+  address.Pack(packed_address, &address_size);
+  stack->Write(packed_address, address_size);
+
+  DMPHeader header(is_virtual,
+                   is_relative,
+                   RANGE_EQUAL,
+                   TypeToDMPSize<type>());
+  DMPPDU::PrependPDU(stack, ola::acn::DMP_SET_PROPERTY_VECTOR, header);
+}
 }  // namespace acn
 }  // namespace ola
 #endif  // LIBS_ACN_DMPPDU_H_
@@ -39,6 +39,9 @@ using ola::DmxBuffer;
 using ola::network::IPV4Address;
 using ola::network::IPV4SocketAddress;
 using ola::network::HostToNetwork;
+using ola::network::Interface;
+using ola::network::InterfacePicker;
+using ola::network::UDPSocket;
 using std::auto_ptr;
 using std::map;
 using std::string;
@@ -107,6 +110,19 @@ void TrackedSource::NewPage(uint8_t page_number, uint8_t last_page,
   }
 }
 
+/*
+ * An additional socket used to receive a subset of the universes.
+ */
+class ReceiveShard {
+ public:
+  explicit ReceiveShard(BaseInflator *inflator)
+      : transport(&socket, inflator) {
+  }
+
+  UDPSocket socket;
+  IncomingUDPTransport transport;
+};
+
 E131Node::E131Node(ola::thread::SchedulerInterface *ss,
                    const string &ip_address,
                    const Options &options,
@@ -114,22 +130,43 @@ E131Node::E131Node(ola::thread::SchedulerInterface *ss,
     : m_ss(ss),
       m_options(options),
       m_preferred_ip(ip_address),
+      m_choose_interface(true),
       m_cid(cid),
       m_root_sender(m_cid),
-      m_e131_sender(&m_socket, &m_root_sender),
-      m_dmp_inflator(options.ignore_preview),
+      m_e131_sender(&m_socket, &m_root_sender, options.port),
+      m_dmp_inflator(options.ignore_preview, options.max_sources),
       m_discovery_inflator(NewCallback(this, &E131Node::NewDiscoveryPage)),
       m_incoming_udp_transport(&m_socket, &m_root_inflator),
-      m_send_buffer(NULL),
-      m_discovery_timeout(ola::thread::INVALID_TIMEOUT) {
-
-
-  if (!m_options.use_rev2) {
-    // Allocate a buffer for the dmx data + start code
-    m_send_buffer = new uint8_t[DMX_UNIVERSE_SIZE + 1];
-    m_send_buffer[0] = 0;  // start code is 0
-  }
+      m_discovery_timeout(ola::thread::INVALID_TIMEOUT),
+      m_clock(options.clock ? options.clock : &m_default_clock),
+      m_refresh_timeout(ola::thread::INVALID_TIMEOUT),
+      m_refresh_bucket_universes(0) {
+  // setup all the inflators
+  m_root_inflator.AddInflator(&m_e131_inflator);
+  m_root_inflator.AddInflator(&m_e131_rev2_inflator);
+  m_e131_inflator.AddInflator(&m_dmp_inflator);
+  m_e131_inflator.AddInflator(&m_discovery_inflator);
+  m_e131_rev2_inflator.AddInflator(&m_dmp_inflator);
+}
 
+E131Node::E131Node(ola::thread::SchedulerInterface *ss,
+                   const Interface &iface,
+                   const Options &options,
+                   const ola::acn::CID &cid)
+    : m_ss(ss),
+      m_options(options),
+      m_choose_interface(false),
+      m_cid(cid),
+      m_interface(iface),
+      m_root_sender(m_cid),
+      m_e131_sender(&m_socket, &m_root_sender, options.port),
+      m_dmp_inflator(options.ignore_preview, options.max_sources),
+      m_discovery_inflator(NewCallback(this, &E131Node::NewDiscoveryPage)),
+      m_incoming_udp_transport(&m_socket, &m_root_inflator),
+      m_discovery_timeout(ola::thread::INVALID_TIMEOUT),
+      m_clock(options.clock ? options.clock : &m_default_clock),
+      m_refresh_timeout(ola::thread::INVALID_TIMEOUT),
+      m_refresh_bucket_universes(0) {
   // setup all the inflators
   m_root_inflator.AddInflator(&m_e131_inflator);
   m_root_inflator.AddInflator(&m_e131_rev2_inflator);
@@ -152,20 +189,20 @@ E131Node::~E131Node() {
   }
 
   Stop();
-  if (m_send_buffer)
-    delete[] m_send_buffer;
 
   STLDeleteValues(&m_discovered_sources);
+  STLDeleteElements(&m_receive_shards);
 }
 
 
 bool E131Node::Start() {
-  auto_ptr<ola::network::InterfacePicker> picker(
-    ola::network::InterfacePicker::NewPicker());
-  if (!picker->ChooseInterface(&m_interface, m_preferred_ip)) {
+  auto_ptr<InterfacePicker> picker(InterfacePicker::NewPicker());
+  if (m_choose_interface &&
+      !picker->ChooseInterface(&m_interface, m_preferred_ip)) {
     OLA_INFO << "Failed to find an interface";
     return false;
   }
+  ChooseExtraInterfaces(picker.get());
 
   if (!m_socket.Init()) {
     return false;
@@ -184,24 +221,32 @@ bool E131Node::Start() {
   m_socket.SetOnData(NewCallback(&m_incoming_udp_transport,
                                  &IncomingUDPTransport::Receive));
 
+  if (!SetupReceiveShards())
+    return false;
+
   if (m_options.enable_draft_discovery) {
     IPV4Address addr;
     m_e131_sender.UniverseIP(DISCOVERY_UNIVERSE_ID, &addr);
-
-    if (!m_socket.JoinMulticast(m_interface.ip_address, addr)) {
-      OLA_WARN << "Failed to join multicast group " << addr;
-    }
+    JoinGroup(&m_socket, addr);
 
     m_discovery_timeout = m_ss->RegisterRepeatingTimeout(
         UNIVERSE_DISCOVERY_INTERVAL,
         ola::NewCallback(this, &E131Node::PerformDiscoveryHousekeeping));
   }
+
+  if (RateControlEnabled()) {
+    m_refresh_timeout = m_ss->RegisterRepeatingTimeout(
+        REFRESH_TICK,
+        ola::NewCallback(this, &E131Node::RefreshUniverses));
+  }
   return true;
 }
 
 bool E131Node::Stop() {
   m_ss->RemoveTimeout(m_discovery_timeout);
   m_discovery_timeout = ola::thread::INVALID_TIMEOUT;
+  m_ss->RemoveTimeout(m_refresh_timeout);
+  m_refresh_timeout = ola::thread::INVALID_TIMEOUT;
   return true;
 }
 
@@ -243,7 +288,36 @@ bool E131Node::SendDMX(uint16_t universe,
                        const ola::DmxBuffer &buffer,
                        uint8_t priority,
                        bool preview) {
-  return SendDMXWithSequenceOffset(universe, buffer, 0, priority, preview);
+  if (!RateControlEnabled()) {
+    return SendDMXWithSequenceOffset(universe, buffer, 0, priority, preview);
+  }
+
+  ActiveTxUniverses::iterator iter = m_tx_universes.find(universe);
+  tx_universe *settings;
+  if (iter == m_tx_universes.end()) {
+    settings = SetupOutgoingSettings(universe);
+  } else {
+    settings = &iter->second;
+  }
+
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+
+  if (settings->last_data == buffer &&
+      settings->last_priority == priority &&
+      settings->last_preview == preview) {
+    if (m_options.suppress_unchanged &&
+        settings->repeat_count >= UNCHANGED_FRAME_COUNT &&
+        now - settings->last_sent < RefreshInterval()) {
+      return true;
+    }
+  } else {
+    settings->last_data = buffer;
+    settings->last_priority = priority;
+    settings->last_preview = preview;
+    settings->repeat_count = 0;
+  }
+  return TransmitLastFrame(universe, settings, now);
 }
 
 
@@ -261,29 +335,6 @@ bool E131Node::SendDMXWithSequenceOffset(uint16_t universe,
     settings = &iter->second;
   }
 
-  const uint8_t *dmp_data;
-  unsigned int dmp_data_length;
-
-  if (m_options.use_rev2) {
-    dmp_data = buffer.GetRaw();
-    dmp_data_length = buffer.Size();
-  } else {
-    unsigned int data_size = DMX_UNIVERSE_SIZE;
-    buffer.Get(m_send_buffer + 1, &data_size);
-    dmp_data = m_send_buffer;
-    dmp_data_length = data_size + 1;
-  }
-
-  TwoByteRangeDMPAddress range_addr(0, 1, (uint16_t) dmp_data_length);
-  DMPAddressData<TwoByteRangeDMPAddress> range_chunk(&range_addr,
-                                                     dmp_data,
-                                                     dmp_data_length);
-  vector<DMPAddressData<TwoByteRangeDMPAddress> > ranged_chunks;
-  ranged_chunks.push_back(range_chunk);
-  const DMPPDU *pdu = NewRangeDMPSetProperty<uint16_t>(true,
-                                                       false,
-                                                       ranged_chunks);
-
   E131Header header(settings->source,
                     priority,
                     static_cast<uint8_t>(settings->sequence + sequence_offset),
@@ -292,10 +343,9 @@ bool E131Node::SendDMXWithSequenceOffset(uint16_t universe,
                     false,  // terminated
                     m_options.use_rev2);
 
-  bool result = m_e131_sender.SendDMP(header, pdu);
+  bool result = m_e131_sender.SendDMX(header, buffer);
   if (result && !sequence_offset)
     settings->sequence++;
-  delete pdu;
   return result;
 }
 
@@ -315,18 +365,6 @@ bool E131Node::SendStreamTerminated(uint16_t universe,
     sequence_number = iter->second.sequence;
   }
 
-  unsigned int data_size = DMX_UNIVERSE_SIZE;
-  buffer.Get(m_send_buffer + 1, &data_size);
-  data_size++;
-
-  TwoByteRangeDMPAddress range_addr(0, 1, (uint16_t) data_size);
-  DMPAddressData<TwoByteRangeDMPAddress> range_chunk(
-      &range_addr, m_send_buffer, data_size);
-  vector<DMPAddressData<TwoByteRangeDMPAddress> > ranged_chunks;
-  ranged_chunks.push_back(range_chunk);
-  const DMPPDU *pdu = NewRangeDMPSetProperty<uint16_t>(
-      true, false, ranged_chunks);
-
   E131Header header(source_name,
                     priority,
                     sequence_number,
@@ -335,11 +373,10 @@ bool E131Node::SendStreamTerminated(uint16_t universe,
                     true,  // terminated
                     false);
 
-  bool result = m_e131_sender.SendDMP(header, pdu);
+  bool result = m_e131_sender.SendDMX(header, buffer);
   // only update if we were previously tracking this universe
   if (result && iter != m_tx_universes.end())
     iter->second.sequence++;
-  delete pdu;
   return result;
 }
 
@@ -354,8 +391,7 @@ bool E131Node::SetHandler(uint16_t universe,
     return false;
   }
 
-  if (!m_socket.JoinMulticast(m_interface.ip_address, addr)) {
-    OLA_WARN << "Failed to join multicast group " << addr;
+  if (!JoinGroup(SocketForUniverse(universe), addr)) {
     return false;
   }
 
@@ -370,14 +406,27 @@ bool E131Node::RemoveHandler(uint16_t universe) {
     return false;
   }
 
-  if (!m_socket.LeaveMulticast(m_interface.ip_address, addr)) {
-    OLA_WARN << "Failed to leave multicast group " << addr;
+  if (!LeaveGroup(SocketForUniverse(universe), addr)) {
     return false;
   }
 
   return m_dmp_inflator.RemoveHandler(universe);
 }
 
+void E131Node::GetInterfaces(vector<Interface> *interfaces) const {
+  interfaces->push_back(m_interface);
+  interfaces->insert(interfaces->end(), m_extra_interfaces.begin(),
+                     m_extra_interfaces.end());
+}
+
+void E131Node::GetReceiveSockets(vector<UDPSocket*> *sockets) {
+  sockets->push_back(&m_socket);
+  ReceiveShards::iterator iter = m_receive_shards.begin();
+  for (; iter != m_receive_shards.end(); ++iter) {
+    sockets->push_back(&(*iter)->socket);
+  }
+}
+
 
 void E131Node::GetKnownControllers(std::vector<KnownController> *controllers) {
   TrackedSources::const_iterator iter = m_discovered_sources.begin();
@@ -399,11 +448,207 @@ E131Node::tx_universe *E131Node::SetupOutgoingSettings(uint16_t universe) {
   tx_universe settings;
   settings.source = m_options.source_name;
   settings.sequence = 0;
+  settings.last_priority = DEFAULT_PRIORITY;
+  settings.last_preview = false;
+  settings.repeat_count = 0;
   ActiveTxUniverses::iterator iter =
       m_tx_universes.insert(std::make_pair(universe, settings)).first;
   return &iter->second;
 }
 
+/*
+ * Check if we need to track the frames we send.
+ */
+bool E131Node::RateControlEnabled() const {
+  return m_options.suppress_unchanged || m_options.refresh_interval;
+}
+
+/*
+ * The maximum time between frames for a universe.
+ */
+TimeInterval E131Node::RefreshInterval() const {
+  uint16_t interval = m_options.refresh_interval ?
+      m_options.refresh_interval : DEFAULT_KEEP_ALIVE_INTERVAL;
+  return TimeInterval(interval / 1000, (interval % 1000) * 1000);
+}
+
+/*
+ * Send the last frame we have for a universe.
+ */
+bool E131Node::TransmitLastFrame(uint16_t universe, tx_universe *settings,
+                                 const TimeStamp &now) {
+  bool ok = SendDMXWithSequenceOffset(universe, settings->last_data, 0,
+                                      settings->last_priority,
+                                      settings->last_preview);
+  if (ok) {
+    settings->last_sent = now;
+    if (settings->repeat_count < UNCHANGED_FRAME_COUNT) {
+      settings->repeat_count++;
+    }
+  }
+  return ok;
+}
+
+/*
+ * Resend the last frame for any universe we haven't sent in a while.
+ *
+ * The refreshes are paced with a TokenBucket that allows twice the average
+ * rate needed to refresh every universe once per interval. After start up,
+ * when every universe is due at once, this spreads the sends out and they
+ * stay staggered from then on.
+ */
+bool E131Node::RefreshUniverses() {
+  if (m_tx_universes.empty()) {
+    return true;
+  }
+
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+  const TimeInterval interval = RefreshInterval();
+
+  if (!m_refresh_bucket.get() ||
+      m_refresh_bucket_universes != m_tx_universes.size()) {
+    int64_t interval_ms = interval.InMilliSeconds();
+    unsigned int rate = static_cast<unsigned int>(std::max<int64_t>(
+        1, 2000 * static_cast<int64_t>(m_tx_universes.size()) / interval_ms));
+    unsigned int burst = std::max(1u, rate * REFRESH_TICK / 1000);
+    m_refresh_bucket.reset(new TokenBucket(burst, rate, burst, now));
+    m_refresh_bucket_universes = m_tx_universes.size();
+  }
+
+  ActiveTxUniverses::iterator iter = m_tx_universes.begin();
+  for (; iter != m_tx_universes.end(); ++iter) {
+    tx_universe *settings = &iter->second;
+    // Streams that were started but never sent any data are skipped.
+    if (settings->last_data.Size() == 0 ||
+        now - settings->last_sent < interval) {
+      continue;
+    }
+
+    if (!m_refresh_bucket->GetToken(now)) {
+      break;
+    }
+    TransmitLastFrame(iter->first, settings, now);
+  }
+  return true;
+}
+
+/*
+ * Resolve the additional interfaces we should receive on.
+ */
+void E131Node::ChooseExtraInterfaces(InterfacePicker *picker) {
+  m_extra_interfaces.clear();
+
+  InterfacePicker::Options options;
+  options.specific_only = true;
+
+  vector<string>::const_iterator iter = m_options.extra_interfaces.begin();
+  for (; iter != m_options.extra_interfaces.end(); ++iter) {
+    Interface iface;
+    if (!picker->ChooseInterface(&iface, *iter, options)) {
+      OLA_WARN << "Failed to find an interface for " << *iter;
+      continue;
+    }
+
+    bool duplicate = iface.ip_address == m_interface.ip_address;
+    vector<Interface>::const_iterator extra_iter = m_extra_interfaces.begin();
+    for (; extra_iter != m_extra_interfaces.end(); ++extra_iter) {
+      duplicate |= iface.ip_address == extra_iter->ip_address;
+    }
+    if (!duplicate) {
+      m_extra_interfaces.push_back(iface);
+    }
+  }
+}
+
+/*
+ * Create the additional sockets that universes are spread across.
+ *
+ * Each socket is bound to the same port, so without IP_MULTICAST_ALL they
+ * would all receive every group we've joined. If we can't turn that off, we
+ * fall back to a single socket.
+ */
+bool E131Node::SetupReceiveShards() {
+  if (m_options.receive_sockets <= 1) {
+    return true;
+  }
+
+  if (!m_socket.SetMulticastAll(false)) {
+    OLA_WARN << "Unable to restrict multicast delivery, using a single "
+             << "receive socket";
+    return true;
+  }
+
+  for (int i = 1; i < m_options.receive_sockets; i++) {
+    auto_ptr<ReceiveShard> shard(new ReceiveShard(&m_root_inflator));
+    if (!shard->socket.Init()) {
+      return false;
+    }
+
+    if (!shard->socket.Bind(
+          IPV4SocketAddress(IPV4Address::WildCard(), m_options.port))) {
+      return false;
+    }
+
+    if (!shard->socket.SetMulticastAll(false)) {
+      return false;
+    }
+
+    shard->socket.SetOnData(NewCallback(&shard->transport,
+                                        &IncomingUDPTransport::Receive));
+    m_receive_shards.push_back(shard.release());
+  }
+  OLA_INFO << "E1.31 universes spread across " << m_receive_shards.size() + 1
+           << " sockets";
+  return true;
+}
+
+/*
+ * Return the socket that receives a universe.
+ */
+UDPSocket *E131Node::SocketForUniverse(uint16_t universe) {
+  ReceiveShards::size_type shard = universe % (m_receive_shards.size() + 1);
+  return shard ? &m_receive_shards[shard - 1]->socket : &m_socket;
+}
+
+/*
+ * Join a multicast group on all our interfaces. Only a failure on the
+ * preferred interface is fatal.
+ */
+bool E131Node::JoinGroup(UDPSocket *socket, const IPV4Address &group) {
+  if (!socket->JoinMulticast(m_interface.ip_address, group)) {
+    OLA_WARN << "Failed to join multicast group " << group;
+    return false;
+  }
+
+  vector<Interface>::const_iterator iter = m_extra_interfaces.begin();
+  for (; iter != m_extra_interfaces.end(); ++iter) {
+    if (!socket->JoinMulticast(iter->ip_address, group)) {
+      OLA_WARN << "Failed to join multicast group " << group << " on "
+               << iter->name;
+    }
+  }
+  return true;
+}
+
+/*
+ * Leave a multicast group on all our interfaces.
+ */
+bool E131Node::LeaveGroup(UDPSocket *socket, const IPV4Address &group) {
+  if (!socket->LeaveMulticast(m_interface.ip_address, group)) {
+    OLA_WARN << "Failed to leave multicast group " << group;
+    return false;
+  }
+
+  vector<Interface>::const_iterator iter = m_extra_interfaces.begin();
+  for (; iter != m_extra_interfaces.end(); ++iter) {
+    if (!socket->LeaveMulticast(iter->ip_address, group)) {
+      OLA_WARN << "Failed to leave multicast group " << group << " on "
+               << iter->name;
+    }
+  }
+  return true;
+}
 
 bool E131Node::PerformDiscoveryHousekeeping() {
   // Send the Universe Discovery packets.
@@ -23,10 +23,12 @@
 #define LIBS_ACN_E131NODE_H_
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 #include "ola/Callback.h"
+#include "ola/Clock.h"
 #include "ola/Constants.h"
 #include "ola/DmxBuffer.h"
 #include "ola/acn/ACNPort.h"
@@ -35,7 +37,9 @@
 #include "ola/io/SelectServerInterface.h"
 #include "ola/thread/SchedulerInterface.h"
 #include "ola/network/Interface.h"
+#include "ola/network/InterfacePicker.h"
 #include "ola/network/Socket.h"
+#include "olad/TokenBucket.h"
 #include "libs/acn/DMPE131Inflator.h"
 #include "libs/acn/E131DiscoveryInflator.h"
 #include "libs/acn/E131Inflator.h"
@@ -60,7 +64,12 @@ class E131Node {
          enable_draft_discovery(false),
          dscp(0),
          port(ola::acn::ACN_PORT),
-         source_name(ola::OLA_DEFAULT_INSTANCE_NAME) {
+         source_name(ola::OLA_DEFAULT_INSTANCE_NAME),
+         receive_sockets(1),
+         suppress_unchanged(false),
+         refresh_interval(0),
+         max_sources(DMPE131Inflator::DEFAULT_MAX_SOURCES),
+         clock(NULL) {
     }
 
     bool use_rev2;  /**< Use Revision 0.2 of the 2009 draft */
@@ -69,6 +78,44 @@ class E131Node {
     uint8_t dscp;  /**< The DSCP value to tag packets with */
     uint16_t port; /**< The UDP port to use, defaults to ACN_PORT */
     std::string source_name; /**< The source name to use */
+    /**
+     * @brief Additional interfaces to join the universe multicast groups on.
+     *
+     * Each entry is an IP address or interface name. Data is always sent on
+     * the preferred interface passed to the constructor.
+     */
+    std::vector<std::string> extra_interfaces;
+    /**
+     * @brief The number of sockets to spread the input universes across.
+     *
+     * Each socket has its own receive buffer in the kernel, which reduces
+     * drops when many universes arrive in a burst. All the sockets are read
+     * from the same thread. A universe is always received on the same socket,
+     * so the packets for a universe are never reordered.
+     */
+    uint8_t receive_sockets;
+    /**
+     * @brief Stop sending unchanged data after three identical frames.
+     *
+     * Once suppressed, the data is repeated every refresh_interval, or
+     * DEFAULT_KEEP_ALIVE_INTERVAL if refresh_interval is 0.
+     */
+    bool suppress_unchanged;
+    /**
+     * @brief The maximum time in ms between frames for a universe.
+     *
+     * If SendDMX() hasn't been called within this time the last frame is
+     * sent again. Refreshes are paced so they are spread across the
+     * interval, rather than sent in a burst. 0 disables refreshing.
+     */
+    uint16_t refresh_interval;
+    uint8_t max_sources;  /**< The max number of sources to merge per universe */
+    /**
+     * @brief The Clock to use for change suppression and refreshes.
+     *
+     * If NULL, the node uses its own Clock. Ownership is not transferred.
+     */
+    ola::Clock *clock;
   };
 
   struct KnownController {
@@ -89,6 +136,18 @@ class E131Node {
            const std::string &ip_address,
            const Options &options,
            const ola::acn::CID &cid = ola::acn::CID::Generate());
+
+  /**
+   * @brief Create a new E1.31 node that uses a specific interface.
+   * @param ss the SchedulerInterface to use.
+   * @param iface the interface to send & receive on.
+   * @param options the Options to use for the node.
+   * @param cid the CID to use, if not provided we generate one.
+   */
+  E131Node(ola::thread::SchedulerInterface *ss,
+           const ola::network::Interface &iface,
+           const Options &options,
+           const ola::acn::CID &cid = ola::acn::CID::Generate());
   ~E131Node();
 
   /**
@@ -194,11 +253,26 @@ class E131Node {
    */
   const ola::network::Interface &GetInterface() const { return m_interface; }
 
+  /**
+   * @brief Return all the Interfaces this node is receiving on.
+   *
+   * The first entry is always the one returned by GetInterface().
+   */
+  void GetInterfaces(std::vector<ola::network::Interface> *interfaces) const;
+
   /**
    * @brief Return the UDP socket this node is using.
    */
   ola::network::UDPSocket* GetSocket() { return &m_socket; }
 
+  /**
+   * @brief Return all the UDP sockets this node is receiving on.
+   *
+   * The first entry is always the one returned by GetSocket(). Each of the
+   * sockets needs to be added to the SelectServer.
+   */
+  void GetReceiveSockets(std::vector<ola::network::UDPSocket*> *sockets);
+
   /**
    * @brief Return a list of known controllers.
    *
@@ -211,18 +285,28 @@ class E131Node {
   struct tx_universe {
     std::string source;
     uint8_t sequence;
+    // The last frame sent, used for change detection and refreshes.
+    DmxBuffer last_data;
+    uint8_t last_priority;
+    bool last_preview;
+    uint8_t repeat_count;
+    TimeStamp last_sent;
   };
 
   typedef std::map<uint16_t, tx_universe> ActiveTxUniverses;
   typedef std::map<acn::CID, class TrackedSource*> TrackedSources;
+  typedef std::vector<class ReceiveShard*> ReceiveShards;
 
   ola::thread::SchedulerInterface *m_ss;
   const Options m_options;
   const std::string m_preferred_ip;
+  const bool m_choose_interface;
   const ola::acn::CID m_cid;
 
   ola::network::Interface m_interface;
+  std::vector<ola::network::Interface> m_extra_interfaces;
   ola::network::UDPSocket m_socket;
+  ReceiveShards m_receive_shards;
   // senders
   RootSender m_root_sender;
   E131Sender m_e131_sender;
@@ -235,14 +319,34 @@ class E131Node {
 
   IncomingUDPTransport m_incoming_udp_transport;
   ActiveTxUniverses m_tx_universes;
-  uint8_t *m_send_buffer;
 
   // Discovery members
   ola::thread::timeout_id m_discovery_timeout;
   TrackedSources m_discovered_sources;
 
+  // Output rate control members
+  ola::Clock m_default_clock;
+  ola::Clock *m_clock;
+  ola::thread::timeout_id m_refresh_timeout;
+  std::auto_ptr<TokenBucket> m_refresh_bucket;
+  ActiveTxUniverses::size_type m_refresh_bucket_universes;
+
   tx_universe *SetupOutgoingSettings(uint16_t universe);
 
+  bool RateControlEnabled() const;
+  TimeInterval RefreshInterval() const;
+  bool TransmitLastFrame(uint16_t universe, tx_universe *settings,
+                         const TimeStamp &now);
+  bool RefreshUniverses();
+
+  void ChooseExtraInterfaces(ola::network::InterfacePicker *picker);
+  bool SetupReceiveShards();
+  ola::network::UDPSocket *SocketForUniverse(uint16_t universe);
+  bool JoinGroup(ola::network::UDPSocket *socket,
+                 const ola::network::IPV4Address &group);
+  bool LeaveGroup(ola::network::UDPSocket *socket,
+                  const ola::network::IPV4Address &group);
+
   bool PerformDiscoveryHousekeeping();
   void NewDiscoveryPage(const HeaderSet &headers,
                         const E131DiscoveryInflator::DiscoveryPage &page);
@@ -253,6 +357,10 @@ class E131Node {
   static const uint16_t UNIVERSE_DISCOVERY_INTERVAL = 10000;  // milliseconds
   static const uint16_t DISCOVERY_UNIVERSE_ID = 64214;
   static const uint16_t DISCOVERY_PAGE_SIZE = 512;
+  // The number of identical frames sent before suppression starts.
+  static const uint8_t UNCHANGED_FRAME_COUNT = 3;
+  static const uint16_t DEFAULT_KEEP_ALIVE_INTERVAL = 800;  // milliseconds
+  static const uint16_t REFRESH_TICK = 20;  // milliseconds
 
   DISALLOW_COPY_AND_ASSIGN(E131Node);
 };
@@ -0,0 +1,290 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * E131NodeTest.cpp
+ * Test fixture for the E131Node class.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "ola/Callback.h"
+#include "ola/Clock.h"
+#include "ola/DmxBuffer.h"
+#include "ola/io/SelectServer.h"
+#include "ola/network/IPV4Address.h"
+#include "ola/network/Interface.h"
+#include "ola/network/Socket.h"
+#include "ola/network/SocketAddress.h"
+#include "ola/testing/TestUtils.h"
+#include "libs/acn/E131Node.h"
+
+namespace ola {
+namespace acn {
+
+using ola::DmxBuffer;
+using ola::MockClock;
+using ola::TimeInterval;
+using ola::io::SelectServer;
+using ola::network::IPV4Address;
+using ola::network::IPV4SocketAddress;
+using ola::network::Interface;
+using ola::network::UDPSocket;
+using std::auto_ptr;
+using std::vector;
+
+class E131NodeTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(E131NodeTest);
+  CPPUNIT_TEST(testReceiveShards);
+  CPPUNIT_TEST(testSuppressUnchanged);
+  CPPUNIT_TEST(testRefreshInterval);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  E131NodeTest()
+      : TestFixture(),
+        m_port(0),
+        m_readable_socket(-1),
+        m_frames(0) {
+  }
+
+  void setUp();
+  void testReceiveShards();
+  void testSuppressUnchanged();
+  void testRefreshInterval();
+
+ private:
+  auto_ptr<SelectServer> m_ss;
+  MockClock m_clock;
+  Interface m_interface;
+  uint16_t m_port;
+  int m_readable_socket;
+  unsigned int m_frames;
+  UDPSocket m_listener;
+
+  void SetupListener();
+  unsigned int ReceivedFrames();
+
+  void SocketReadable(UDPSocket *socket, int index) {
+    uint8_t data[1500];
+    ssize_t size = sizeof(data);
+    socket->RecvFrom(data, &size);
+    m_readable_socket = index;
+    m_ss->Terminate();
+  }
+
+  void FrameReceived() {
+    uint8_t data[1500];
+    ssize_t size = sizeof(data);
+    if (m_listener.RecvFrom(data, &size)) {
+      m_frames++;
+    }
+  }
+
+  void Timeout() { m_ss->Terminate(); }
+  void Noop() {}
+
+  static const int ABORT_TIMEOUT_IN_MS = 1000;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(E131NodeTest);
+
+void E131NodeTest::setUp() {
+  m_ss.reset(new SelectServer(NULL, &m_clock));
+  m_interface.name = "lo";
+  m_interface.ip_address = IPV4Address::Loopback();
+
+  // Find a free port for the nodes to share.
+  UDPSocket socket;
+  OLA_ASSERT_TRUE(socket.Init());
+  OLA_ASSERT_TRUE(socket.Bind(
+      IPV4SocketAddress(IPV4Address::WildCard(), 0)));
+  IPV4SocketAddress address;
+  OLA_ASSERT_TRUE(socket.GetSocketAddress(&address));
+  m_port = address.Port();
+}
+
+
+/*
+ * Listen for the frames sent to universe 1.
+ */
+void E131NodeTest::SetupListener() {
+  OLA_ASSERT_TRUE(m_listener.Init());
+  OLA_ASSERT_TRUE(m_listener.Bind(
+      IPV4SocketAddress(IPV4Address::WildCard(), m_port)));
+  IPV4Address group;
+  OLA_ASSERT_TRUE(IPV4Address::FromString("239.255.0.1", &group));
+  OLA_ASSERT_TRUE(m_listener.JoinMulticast(m_interface.ip_address, group));
+  m_listener.SetOnData(NewCallback(this, &E131NodeTest::FrameReceived));
+  OLA_ASSERT_TRUE(m_ss->AddReadDescriptor(&m_listener));
+}
+
+
+/*
+ * Run the SelectServer until the pending frames have arrived, and return the
+ * number of frames received since the last call.
+ */
+unsigned int E131NodeTest::ReceivedFrames() {
+  for (unsigned int i = 0; i < 5; i++) {
+    m_ss->RunOnce(TimeInterval(0, 5000));
+  }
+  unsigned int frames = m_frames;
+  m_frames = 0;
+  return frames;
+}
+
+
+/*
+ * Check each universe is received on the socket it maps to.
+ */
+void E131NodeTest::testReceiveShards() {
+  E131Node::Options options;
+  options.port = m_port;
+  options.receive_sockets = 3;
+  E131Node receiver(m_ss.get(), m_interface, options);
+  OLA_ASSERT_TRUE(receiver.Start());
+
+  const uint16_t UNIVERSE_COUNT = 6;
+  DmxBuffer buffers[UNIVERSE_COUNT];
+  uint8_t priorities[UNIVERSE_COUNT];
+  for (uint16_t i = 0; i < UNIVERSE_COUNT; i++) {
+    OLA_ASSERT_TRUE(receiver.SetHandler(
+        i + 1, &buffers[i], &priorities[i],
+        NewCallback(this, &E131NodeTest::Noop)));
+  }
+
+  // Without IP_MULTICAST_ALL support the node uses a single socket.
+  vector<UDPSocket*> sockets;
+  receiver.GetReceiveSockets(&sockets);
+  OLA_ASSERT_TRUE(sockets.size() == 1 || sockets.size() == 3);
+  for (unsigned int i = 0; i < sockets.size(); i++) {
+    sockets[i]->SetOnData(NewCallback(this, &E131NodeTest::SocketReadable,
+                                      sockets[i], static_cast<int>(i)));
+    OLA_ASSERT_TRUE(m_ss->AddReadDescriptor(sockets[i]));
+  }
+
+  E131Node::Options sender_options;
+  sender_options.port = m_port;
+  E131Node sender(m_ss.get(), m_interface, sender_options);
+  OLA_ASSERT_TRUE(sender.Start());
+
+  DmxBuffer buffer;
+  buffer.SetFromString("1,2,3");
+  for (uint16_t universe = 1; universe <= UNIVERSE_COUNT; universe++) {
+    m_readable_socket = -1;
+    OLA_ASSERT_TRUE(sender.SendDMX(universe, buffer));
+    ola::thread::timeout_id timeout = m_ss->RegisterSingleTimeout(
+        ABORT_TIMEOUT_IN_MS, NewSingleCallback(this, &E131NodeTest::Timeout));
+    m_ss->Run();
+    OLA_ASSERT_NE(-1, m_readable_socket);
+    m_ss->RemoveTimeout(timeout);
+    OLA_ASSERT_EQ(static_cast<int>(universe % sockets.size()),
+                  m_readable_socket);
+  }
+
+  for (unsigned int i = 0; i < sockets.size(); i++) {
+    m_ss->RemoveReadDescriptor(sockets[i]);
+  }
+}
+
+
+/*
+ * Check unchanged frames are suppressed and a changed frame is sent at once.
+ */
+void E131NodeTest::testSuppressUnchanged() {
+  SetupListener();
+
+  E131Node::Options options;
+  options.port = m_port;
+  options.suppress_unchanged = true;
+  options.clock = &m_clock;
+  E131Node node(m_ss.get(), m_interface, options);
+  OLA_ASSERT_TRUE(node.Start());
+
+  DmxBuffer buffer;
+  buffer.SetFromString("1,2,3");
+  // The first three identical frames are sent, the rest are dropped.
+  for (unsigned int i = 0; i < 5; i++) {
+    OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  }
+  OLA_ASSERT_EQ(3u, ReceivedFrames());
+
+  m_clock.AdvanceTime(0, 100000);
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(0u, ReceivedFrames());
+
+  // A change is sent immediately.
+  buffer.SetFromString("4,5,6");
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(1u, ReceivedFrames());
+
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(2u, ReceivedFrames());
+
+  // Once the keep alive interval has passed, the frame is repeated.
+  m_clock.AdvanceTime(0, 900000);
+  OLA_ASSERT_EQ(1u, ReceivedFrames());
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(0u, ReceivedFrames());
+
+  node.Stop();
+  m_ss->RemoveReadDescriptor(&m_listener);
+}
+
+
+/*
+ * Check the last frame is resent once the refresh interval has passed.
+ */
+void E131NodeTest::testRefreshInterval() {
+  SetupListener();
+
+  E131Node::Options options;
+  options.port = m_port;
+  options.refresh_interval = 1000;
+  options.clock = &m_clock;
+  E131Node node(m_ss.get(), m_interface, options);
+  OLA_ASSERT_TRUE(node.Start());
+
+  DmxBuffer buffer;
+  buffer.SetFromString("1,2,3");
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(1u, ReceivedFrames());
+
+  m_clock.AdvanceTime(0, 500000);
+  OLA_ASSERT_EQ(0u, ReceivedFrames());
+
+  m_clock.AdvanceTime(0, 600000);
+  OLA_ASSERT_EQ(1u, ReceivedFrames());
+
+  // The refresh restarts the interval.
+  m_clock.AdvanceTime(0, 500000);
+  OLA_ASSERT_EQ(0u, ReceivedFrames());
+
+  // Without suppression every frame is sent, changed or not.
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  buffer.SetFromString("4,5,6");
+  OLA_ASSERT_TRUE(node.SendDMX(1, buffer));
+  OLA_ASSERT_EQ(2u, ReceivedFrames());
+
+  node.Stop();
+  m_ss->RemoveReadDescriptor(&m_listener);
+}
+}  // namespace acn
+}  // namespace ola
@@ -29,6 +29,7 @@
 namespace ola {
 namespace acn {
 
+using ola::io::IOStack;
 using ola::io::OutputStream;
 using ola::network::HostToNetwork;
 
@@ -151,5 +152,42 @@ void E131PDU::PackData(OutputStream *stream) const {
     stream->Write(m_data, m_data_size);
   }
 }
+
+
+/*
+ * Prepend an E1.31 flags, length, vector & header. The data, usually a DMP
+ * PDU, must already be on the stack.
+ */
+void E131PDU::PrependPDU(IOStack *stack,
+                         uint32_t vector,
+                         const E131Header &header) {
+  if (header.UsingRev2()) {
+    E131Rev2Header::e131_rev2_pdu_header rev2_header;
+    strings::CopyToFixedLengthBuffer(header.Source(), rev2_header.source,
+                                     arraysize(rev2_header.source));
+    rev2_header.priority = header.Priority();
+    rev2_header.sequence = header.Sequence();
+    rev2_header.universe = HostToNetwork(header.Universe());
+    stack->Write(reinterpret_cast<uint8_t*>(&rev2_header),
+                 sizeof(E131Rev2Header::e131_rev2_pdu_header));
+  } else {
+    E131Header::e131_pdu_header e131_header;
+    strings::CopyToFixedLengthBuffer(header.Source(), e131_header.source,
+                                     arraysize(e131_header.source));
+    e131_header.priority = header.Priority();
+    e131_header.reserved = 0;
+    e131_header.sequence = header.Sequence();
+    e131_header.options = static_cast<uint8_t>(
+        (header.PreviewData() ? E131Header::PREVIEW_DATA_MASK : 0) |
+        (header.StreamTerminated() ? E131Header::STREAM_TERMINATED_MASK : 0));
+    e131_header.universe = HostToNetwork(header.Universe());
+    stack->Write(reinterpret_cast<uint8_t*>(&e131_header),
+                 sizeof(E131Header::e131_pdu_header));
+  }
+
+  vector = HostToNetwork(vector);
+  stack->Write(reinterpret_cast<uint8_t*>(&vector), sizeof(vector));
+  PrependFlagsAndLength(stack);
+}
 }  // namespace acn
 }  // namespace ola
@@ -21,6 +21,7 @@
 #ifndef LIBS_ACN_E131PDU_H_
 #define LIBS_ACN_E131PDU_H_
 
+#include "ola/io/IOStack.h"
 #include "libs/acn/PDU.h"
 #include "libs/acn/E131Header.h"
 
@@ -60,6 +61,10 @@ class E131PDU: public PDU {
   void PackHeader(ola::io::OutputStream *stream) const;
   void PackData(ola::io::OutputStream *stream) const;
 
+  static void PrependPDU(ola::io::IOStack *stack,
+                         uint32_t vector,
+                         const E131Header &header);
+
  private:
   E131Header m_header;
   const DMPPDU *m_dmp_pdu;
@@ -21,8 +21,11 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <string.h>
 #include <string>
+#include <vector>
 
+#include "ola/io/IOStack.h"
 #include "ola/network/NetworkUtils.h"
+#include "libs/acn/DMPPDU.h"
 #include "libs/acn/PDUTestCommon.h"
 #include "libs/acn/E131PDU.h"
 #include "ola/testing/TestUtils.h"
@@ -30,21 +33,27 @@
 namespace ola {
 namespace acn {
 
+using ola::io::IOStack;
 using ola::network::HostToNetwork;
 using std::string;
+using std::vector;
 
 class E131PDUTest: public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(E131PDUTest);
   CPPUNIT_TEST(testSimpleRev2E131PDU);
   CPPUNIT_TEST(testSimpleE131PDU);
   CPPUNIT_TEST(testNestedE131PDU);
+  CPPUNIT_TEST(testPrependPDU);
   CPPUNIT_TEST_SUITE_END();
 
  public:
     void testSimpleRev2E131PDU();
     void testSimpleE131PDU();
     void testNestedE131PDU();
+    void testPrependPDU();
  private:
+    void CheckPrependMatchesPack(const E131Header &header);
+
     static const unsigned int TEST_VECTOR;
 };
 
@@ -157,5 +166,53 @@ void E131PDUTest::testSimpleE131PDU() {
 void E131PDUTest::testNestedE131PDU() {
   // TODO(simon): add this test
 }
+
+
+/*
+ * Check that building an E1.31 DMX PDU on an IOStack produces the same bytes
+ * as packing the PDU objects.
+ */
+void E131PDUTest::CheckPrependMatchesPack(const E131Header &header) {
+  uint8_t dmx_data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  const uint16_t data_length = sizeof(dmx_data);
+
+  TwoByteRangeDMPAddress range_addr(0, 1, data_length);
+  DMPAddressData<TwoByteRangeDMPAddress> range_chunk(&range_addr, dmx_data,
+                                                     data_length);
+  vector<DMPAddressData<TwoByteRangeDMPAddress> > ranged_chunks;
+  ranged_chunks.push_back(range_chunk);
+  const DMPPDU *dmp_pdu = NewRangeDMPSetProperty<uint16_t>(true, false,
+                                                           ranged_chunks);
+  E131PDU pdu(TEST_VECTOR, header, dmp_pdu);
+
+  unsigned int size = pdu.Size();
+  uint8_t *expected = new uint8_t[size];
+  OLA_ASSERT(pdu.Pack(expected, &size));
+  delete dmp_pdu;
+
+  IOStack stack;
+  stack.Write(dmx_data, data_length);
+  PrependRangeDMPSetProperty<uint16_t>(&stack, true, false, range_addr);
+  E131PDU::PrependPDU(&stack, TEST_VECTOR, header);
+  OLA_ASSERT_EQ(size, stack.Size());
+
+  uint8_t *actual = new uint8_t[size];
+  OLA_ASSERT_EQ(size, stack.Read(actual, size));
+  OLA_ASSERT_DATA_EQUALS(expected, size, actual, size);
+  OLA_ASSERT_TRUE(stack.Empty());
+  delete[] actual;
+  delete[] expected;
+}
+
+
+/*
+ * Test that prepending E1.31 & DMP PDUs matches the packed version.
+ */
+void E131PDUTest::testPrependPDU() {
+  const string source = "foo source";
+  CheckPrependMatchesPack(E131Header(source, 1, 2, 6000, true, false));
+  CheckPrependMatchesPack(E131Header(source, 100, 255, 1, false, true));
+  CheckPrependMatchesPack(E131Rev2Header(source, 1, 2, 6000));
+}
 }  // namespace acn
 }  // namespace ola
@@ -18,8 +18,10 @@
  * Copyright (C) 2007 Simon Newton
  */
 
+#include "ola/Constants.h"
 #include "ola/Logging.h"
 #include "ola/acn/ACNVectors.h"
+#include "ola/io/IOStack.h"
 #include "ola/network/IPV4Address.h"
 #include "ola/network/NetworkUtils.h"
 #include "ola/util/Utils.h"
@@ -33,18 +35,22 @@
 namespace ola {
 namespace acn {
 
+using ola::io::IOStack;
 using ola::network::IPV4Address;
 using ola::network::HostToNetwork;
 
 /*
  * Create a new E131Sender
  * @param root_sender the root layer to use
+ * @param port the UDP port to send to
  */
 E131Sender::E131Sender(ola::network::UDPSocket *socket,
-                       RootSender *root_sender)
+                       RootSender *root_sender,
+                       uint16_t port)
     : m_socket(socket),
       m_transport_impl(socket, &m_packer),
-      m_root_sender(root_sender) {
+      m_root_sender(root_sender),
+      m_port(port) {
   if (!m_root_sender) {
     OLA_WARN << "root_sender is null, this won't work";
   }
@@ -68,7 +74,7 @@ bool E131Sender::SendDMP(const E131Header &header, const DMPPDU *dmp_pdu) {
     return false;
   }
 
-  OutgoingUDPTransport transport(&m_transport_impl, addr);
+  OutgoingUDPTransport transport(&m_transport_impl, addr, m_port);
 
   E131PDU pdu(ola::acn::VECTOR_E131_DATA, header, dmp_pdu);
   unsigned int vector = ola::acn::VECTOR_ROOT_E131;
@@ -78,6 +84,50 @@ bool E131Sender::SendDMP(const E131Header &header, const DMPPDU *dmp_pdu) {
   return m_root_sender->SendPDU(vector, pdu, &transport);
 }
 
+
+/*
+ * Send a frame of DMX data. This builds the packet from the inside out in
+ * pooled memory blocks, so the slot data is copied exactly once.
+ * @param header the E131Header
+ * @param buffer the DMX data, the start code is added here unless the header
+ *   is for Rev 2.
+ */
+bool E131Sender::SendDMX(const E131Header &header,
+                         const ola::DmxBuffer &buffer) {
+  if (!m_root_sender) {
+    return false;
+  }
+
+  IPV4Address addr;
+  if (!UniverseIP(header.Universe(), &addr)) {
+    OLA_INFO << "Could not convert universe " << header.Universe()
+             << " to IP.";
+    return false;
+  }
+
+  OutgoingUDPTransport transport(&m_transport_impl, addr, m_port);
+
+  IOStack packet(&m_memory_pool);
+  unsigned int slots = buffer.Size();
+  packet.Write(buffer.GetRaw(), slots);
+  if (!header.UsingRev2()) {
+    uint8_t start_code = DMX512_START_CODE;
+    packet.Write(&start_code, sizeof(start_code));
+    slots++;
+  }
+
+  TwoByteRangeDMPAddress range_addr(0, 1, static_cast<uint16_t>(slots));
+  PrependRangeDMPSetProperty<uint16_t>(&packet, true, false, range_addr);
+  E131PDU::PrependPDU(&packet, ola::acn::VECTOR_E131_DATA, header);
+
+  unsigned int vector = ola::acn::VECTOR_ROOT_E131;
+  if (header.UsingRev2()) {
+    vector = ola::acn::VECTOR_ROOT_E131_REV2;
+  }
+  return m_root_sender->SendStack(vector, &packet, &transport);
+}
+
+
 bool E131Sender::SendDiscoveryData(const E131Header &header,
                                    const uint8_t *data,
                                    unsigned int data_size) {
@@ -92,11 +142,13 @@ bool E131Sender::SendDiscoveryData(const E131Header &header,
     return false;
   }
 
-  OutgoingUDPTransport transport(&m_transport_impl, addr);
+  OutgoingUDPTransport transport(&m_transport_impl, addr, m_port);
 
-  E131PDU pdu(ola::acn::VECTOR_E131_DISCOVERY, header, data, data_size);
-  unsigned int vector = ola::acn::VECTOR_ROOT_E131;
-  return m_root_sender->SendPDU(vector, pdu, &transport);
+  IOStack packet(&m_memory_pool);
+  packet.Write(data, data_size);
+  E131PDU::PrependPDU(&packet, ola::acn::VECTOR_E131_DISCOVERY, header);
+  return m_root_sender->SendStack(ola::acn::VECTOR_ROOT_E131, &packet,
+                                  &transport);
 }
 
 
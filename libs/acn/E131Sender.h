@@ -22,6 +22,8 @@
 #ifndef LIBS_ACN_E131SENDER_H_
 #define LIBS_ACN_E131SENDER_H_
 
+#include "ola/DmxBuffer.h"
+#include "ola/io/MemoryBlockPool.h"
 #include "ola/network/Socket.h"
 #include "libs/acn/DMPPDU.h"
 #include "libs/acn/E131Header.h"
@@ -37,10 +39,12 @@ class DMPInflator;
 class E131Sender {
  public:
   E131Sender(ola::network::UDPSocket *socket,
-            class RootSender *root_sender);
+             class RootSender *root_sender,
+             uint16_t port = ola::acn::ACN_PORT);
   ~E131Sender() {}
 
   bool SendDMP(const E131Header &header, const DMPPDU *pdu);
+  bool SendDMX(const E131Header &header, const ola::DmxBuffer &buffer);
   bool SendDiscoveryData(const E131Header &header, const uint8_t *data,
                          unsigned int data_size);
 
@@ -49,9 +53,11 @@ class E131Sender {
 
  private:
   ola::network::UDPSocket *m_socket;
+  ola::io::MemoryBlockPool m_memory_pool;
   PreamblePacker m_packer;
   OutgoingUDPTransportImpl m_transport_impl;
   class RootSender *m_root_sender;
+  const uint16_t m_port;
 
   DISALLOW_COPY_AND_ASSIGN(E131Sender);
 };
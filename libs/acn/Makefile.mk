@@ -93,7 +93,9 @@ libs_acn_libolae131core_la_LIBADD = $(uuid_LIBS) \
 # PROGRAMS
 ##################################################
 noinst_PROGRAMS += libs/acn/e131_transmit_test \
-                   libs/acn/e131_loadtest
+                   libs/acn/e131_loadtest \
+                   libs/acn/e131_replay \
+                   libs/acn/pdu_encode_benchmark
 libs_acn_e131_transmit_test_SOURCES = \
     libs/acn/e131_transmit_test.cpp \
     libs/acn/E131TestFramework.cpp \
@@ -103,6 +105,13 @@ libs_acn_e131_transmit_test_LDADD = libs/acn/libolae131core.la
 libs_acn_e131_loadtest_SOURCES = libs/acn/e131_loadtest.cpp
 libs_acn_e131_loadtest_LDADD = libs/acn/libolae131core.la
 
+libs_acn_e131_replay_SOURCES = libs/acn/e131_replay.cpp
+libs_acn_e131_replay_LDADD = common/network/libolapacketreplay.la \
+                            libs/acn/libolae131core.la
+
+libs_acn_pdu_encode_benchmark_SOURCES = libs/acn/pdu_encode_benchmark.cpp
+libs_acn_pdu_encode_benchmark_LDADD = libs/acn/libolae131core.la
+
 # TESTS
 ##################################################
 test_programs += \
@@ -114,9 +123,11 @@ libs_acn_E131Tester_SOURCES = \
     libs/acn/BaseInflatorTest.cpp \
     libs/acn/CIDTest.cpp \
     libs/acn/DMPAddressTest.cpp \
+    libs/acn/DMPE131InflatorTest.cpp \
     libs/acn/DMPInflatorTest.cpp \
     libs/acn/DMPPDUTest.cpp \
     libs/acn/E131InflatorTest.cpp \
+    libs/acn/E131NodeTest.cpp \
     libs/acn/E131PDUTest.cpp \
     libs/acn/HeaderSetTest.cpp \
     libs/acn/PDUTest.cpp \
@@ -106,5 +106,22 @@ bool RootSender::SendPDUBlock(unsigned int vector,
   m_root_block.AddPDU(&m_root_pdu);
   return transport->Send(m_root_block);
 }
+
+
+/*
+ * Prepend a RootPDU to the encoded PDUs in an IOStack and send it.
+ * @param vector the vector to use at the root level
+ * @param stack the IOStack holding the encoded PDUs, this will be emptied.
+ * @param transport the OutgoingTransport to use when sending the message.
+ */
+bool RootSender::SendStack(unsigned int vector,
+                           ola::io::IOStack *stack,
+                           OutgoingTransport *transport) {
+  if (!transport)
+    return false;
+
+  RootPDU::PrependPDU(stack, vector, m_root_pdu.Cid());
+  return transport->Send(stack);
+}
 }  // namespace acn
 }  // namespace ola
@@ -23,6 +23,7 @@
 
 #include "ola/acn/CID.h"
 #include "ola/base/Macro.h"
+#include "ola/io/IOStack.h"
 #include "libs/acn/PDU.h"
 #include "libs/acn/RootPDU.h"
 #include "libs/acn/Transport.h"
@@ -51,6 +52,10 @@ class RootSender {
     bool SendPDUBlock(unsigned int vector,
                       const PDUBlock<PDU> &block,
                       OutgoingTransport *transport);
+    // Encapsulate & send PDUs that have already been prepended to an IOStack
+    bool SendStack(unsigned int vector,
+                   ola::io::IOStack *stack,
+                   OutgoingTransport *transport);
 
     // TODO(simon): add methods to queue and send PDUs/blocks with different
     // vectors
@@ -21,6 +21,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <memory>
 
+#include "ola/io/IOStack.h"
 #include "ola/io/SelectServer.h"
 #include "ola/network/InterfacePicker.h"
 #include "ola/network/NetworkUtils.h"
@@ -43,19 +44,22 @@ class RootSenderTest: public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(RootSenderTest);
   CPPUNIT_TEST(testRootSender);
   CPPUNIT_TEST(testRootSenderWithCustomCID);
+  CPPUNIT_TEST(testRootSenderWithIOStack);
   CPPUNIT_TEST_SUITE_END();
 
  public:
     RootSenderTest(): TestFixture(), m_ss(NULL) {}
     void testRootSender();
     void testRootSenderWithCustomCID();
+    void testRootSenderWithIOStack();
     void setUp();
     void tearDown();
     void Stop();
     void FatalStop() { OLA_ASSERT(false); }
 
  private:
-    void testRootSenderWithCIDs(const CID &root_cid, const CID &send_cid);
+    void testRootSenderWithCIDs(const CID &root_cid, const CID &send_cid,
+                                bool use_stack = false);
     ola::io::SelectServer *m_ss;
     static const int ABORT_TIMEOUT_IN_MS = 1000;
 };
@@ -95,8 +99,18 @@ void RootSenderTest::testRootSenderWithCustomCID() {
 }
 
 
+/*
+ * Test sending a PDU that has been prepended to an IOStack
+ */
+void RootSenderTest::testRootSenderWithIOStack() {
+  CID cid = CID::Generate();
+  testRootSenderWithCIDs(cid, cid, true);
+}
+
+
 void RootSenderTest::testRootSenderWithCIDs(const CID &root_cid,
-                                            const CID &send_cid) {
+                                            const CID &send_cid,
+                                            bool use_stack) {
   std::auto_ptr<Callback0<void> > stop_closure(
       NewCallback(this, &RootSenderTest::Stop));
 
@@ -131,15 +145,23 @@ void RootSenderTest::testRootSenderWithCIDs(const CID &root_cid,
   // now actually send some data
   MockPDU mock_pdu(4, 8);
 
-  if (root_cid == send_cid)
+  if (use_stack) {
+    ola::io::IOStack packet;
+    MockPDU::PrependPDU(&packet, 4, 8);
+    OLA_ASSERT(root_sender.SendStack(MockPDU::TEST_VECTOR,
+                                     &packet,
+                                     &outgoing_udp_transport));
+    OLA_ASSERT(packet.Empty());
+  } else if (root_cid == send_cid) {
     OLA_ASSERT(root_sender.SendPDU(MockPDU::TEST_VECTOR,
                                        mock_pdu,
                                        &outgoing_udp_transport));
-  else
+  } else {
     OLA_ASSERT(root_sender.SendPDU(MockPDU::TEST_VECTOR,
                                        mock_pdu,
                                        send_cid,
                                        &outgoing_udp_transport));
+  }
 
   SingleUseCallback0<void> *closure =
     NewSingleCallback(this, &RootSenderTest::FatalStop);
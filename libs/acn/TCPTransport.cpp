@@ -20,11 +20,14 @@
 
 #include <ola/Logging.h>
 #include <ola/StringUtils.h>
+#include <ola/io/IOQueue.h>
+#include <ola/network/NetworkUtils.h>
 #include <ola/network/SocketAddress.h>
 #include <algorithm>
 #include <iostream>
 #include "libs/acn/BaseInflator.h"
 #include "libs/acn/HeaderSet.h"
+#include "libs/acn/PreamblePacker.h"
 #include "libs/acn/TCPTransport.h"
 
 namespace ola {
@@ -45,6 +48,35 @@ const unsigned int ACN_HEADER_SIZE = sizeof(ACN_HEADER);
 const unsigned int IncomingStreamTransport::INITIAL_SIZE = 500;
 
 
+/**
+ * Send a block of PDUs. The block is written directly into MemoryBlocks, there
+ * is no intermediate buffer.
+ * @param pdu_block the block of pdus to send
+ * @returns true if the data was queued for sending, false if the sender's
+ *   buffer limit has been reached.
+ */
+bool OutgoingStreamTransport::Send(const PDUBlock<PDU> &pdu_block) {
+  ola::io::IOQueue packet(m_memory_pool);
+  ola::io::OutputStream output(&packet);
+  output.Write(ACN_HEADER, ACN_HEADER_SIZE);
+  output << ola::network::HostToNetwork(pdu_block.Size());
+  pdu_block.Write(&output);
+  return m_sender->SendMessage(&packet);
+}
+
+
+/**
+ * Send a block of PDUs that has already been encoded into an IOStack.
+ * @param stack the IOStack holding the block, this will be emptied
+ * @returns true if the data was queued for sending, false if the sender's
+ *   buffer limit has been reached.
+ */
+bool OutgoingStreamTransport::Send(ola::io::IOStack *stack) {
+  PreamblePacker::AddTCPPreamble(stack);
+  return m_sender->SendMessage(stack);
+}
+
+
 /**
  * Create a new IncomingStreamTransport.
  * @param inflator the inflator to call for each PDU
@@ -32,9 +32,13 @@
 #define LIBS_ACN_TCPTRANSPORT_H_
 
 #include <memory>
+#include "ola/base/Macro.h"
+#include "ola/io/Descriptor.h"
+#include "ola/io/IOStack.h"
+#include "ola/io/MemoryBlockPool.h"
+#include "ola/io/NonBlockingSender.h"
 #include "ola/io/OutputBuffer.h"
 #include "ola/io/OutputStream.h"
-#include "ola/io/Descriptor.h"
 #include "ola/network/TCPSocket.h"
 #include "libs/acn/PDU.h"
 #include "libs/acn/Transport.h"
@@ -43,6 +47,30 @@
 namespace ola {
 namespace acn {
 
+/**
+ * Send PDUs over a stream connection. The PDUs are encoded into MemoryBlocks
+ * from the pool and handed to the NonBlockingSender, which writes them with
+ * scatter/gather I/O and buffers anything the socket won't take.
+ */
+class OutgoingStreamTransport: public OutgoingTransport {
+ public:
+    OutgoingStreamTransport(ola::io::NonBlockingSender *sender,
+                            ola::io::MemoryBlockPool *memory_pool)
+        : m_sender(sender),
+          m_memory_pool(memory_pool) {
+    }
+    ~OutgoingStreamTransport() {}
+
+    bool Send(const PDUBlock<PDU> &pdu_block);
+    bool Send(ola::io::IOStack *stack);
+
+ private:
+    ola::io::NonBlockingSender *m_sender;
+    ola::io::MemoryBlockPool *m_memory_pool;
+
+    DISALLOW_COPY_AND_ASSIGN(OutgoingStreamTransport);
+};
+
 
 /**
  * Read ACN messages from a stream. Generally you want to use the
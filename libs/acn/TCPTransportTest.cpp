@@ -26,6 +26,8 @@
 #include "ola/Logging.h"
 #include "ola/io/IOQueue.h"
 #include "ola/io/IOStack.h"
+#include "ola/io/MemoryBlockPool.h"
+#include "ola/io/NonBlockingSender.h"
 #include "ola/io/SelectServer.h"
 #include "libs/acn/PDUTestCommon.h"
 #include "libs/acn/PreamblePacker.h"
@@ -52,6 +54,7 @@ class TCPTransportTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testZeroLengthPDUBlock);
   CPPUNIT_TEST(testMultiplePDUs);
   CPPUNIT_TEST(testSinglePDUBlock);
+  CPPUNIT_TEST(testOutgoingStreamTransport);
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -63,6 +66,7 @@ class TCPTransportTest: public CppUnit::TestFixture {
     void testMultiplePDUs();
     void testMultiplePDUsWithExtraData();
     void testSinglePDUBlock();
+    void testOutgoingStreamTransport();
     void setUp();
     void tearDown();
 
@@ -245,6 +249,35 @@ void TCPTransportTest::testSinglePDUBlock() {
 }
 
 
+/**
+ * Check the OutgoingStreamTransport produces a stream the
+ * IncomingStreamTransport accepts, for both PDUBlocks and IOStacks.
+ */
+void TCPTransportTest::testOutgoingStreamTransport() {
+  ola::io::MemoryBlockPool pool;
+  ola::io::NonBlockingSender sender(&m_loopback, m_ss.get(), &pool);
+  OutgoingStreamTransport outgoing_transport(&sender, &pool);
+
+  PDUBlock<PDU> pdu_block;
+  MockPDU first_pdu(1, 2);
+  MockPDU second_pdu(2, 4);
+  pdu_block.AddPDU(&first_pdu);
+  pdu_block.AddPDU(&second_pdu);
+  OLA_ASSERT(outgoing_transport.Send(pdu_block));
+
+  IOStack packet(&pool);
+  MockPDU::PrependPDU(&packet, 4, 8);
+  OLA_ASSERT(outgoing_transport.Send(&packet));
+  OLA_ASSERT(packet.Empty());
+
+  m_ss->RunOnce(TimeInterval(1, 0));
+  m_loopback.CloseClient();
+  m_ss->RunOnce(TimeInterval(1, 0));
+  OLA_ASSERT(m_stream_ok);
+  OLA_ASSERT_EQ(3u, m_pdus_received);
+}
+
+
 /**
  * Send empty PDU block.
  */
@@ -23,6 +23,7 @@
 
 #include <string>
 #include "ola/acn/ACNPort.h"
+#include "ola/io/IOStack.h"
 #include "ola/network/Interface.h"
 #include "ola/network/Socket.h"
 #include "libs/acn/PDU.h"
@@ -40,6 +41,13 @@ class OutgoingTransport {
     virtual ~OutgoingTransport() {}
 
     virtual bool Send(const PDUBlock<PDU> &pdu_block) = 0;
+
+    /*
+     * Send a PDU block that has already been encoded into an IOStack. The
+     * transport prepends its preamble and sends the stack with scatter/gather
+     * I/O. The stack is emptied.
+     */
+    virtual bool Send(ola::io::IOStack *stack) = 0;
 };
 }  // namespace acn
 }  // namespace ola
@@ -43,6 +43,15 @@ bool OutgoingUDPTransport::Send(const PDUBlock<PDU> &pdu_block) {
 }
 
 
+/*
+ * Send an encoded PDU block.
+ * @param stack the IOStack holding the block, this will be emptied
+ */
+bool OutgoingUDPTransport::Send(ola::io::IOStack *stack) {
+  return m_impl->Send(stack, m_destination);
+}
+
+
 /*
  * Send a block of PDU messages using UDP.
  * @param pdu_block the block of pdus to send
@@ -61,6 +70,29 @@ bool OutgoingUDPTransportImpl::Send(const PDUBlock<PDU> &pdu_block,
 }
 
 
+/*
+ * Send an encoded PDU block using UDP. The preamble is prepended to the stack
+ * and the MemoryBlocks are passed straight to sendmsg().
+ * @param stack the IOStack holding the block, this will be emptied
+ * @param destination the ipv4 address & port to send to
+ */
+bool OutgoingUDPTransportImpl::Send(ola::io::IOStack *stack,
+                                    const IPV4SocketAddress &destination) {
+  PreamblePacker::AddUDPPreamble(stack);
+  unsigned int size = stack->Size();
+  if (size > PreamblePacker::MAX_DATAGRAM_SIZE) {
+    OLA_WARN << "ACN datagram of " << size << " bytes exceeds the maximum of "
+             << PreamblePacker::MAX_DATAGRAM_SIZE;
+    stack->Pop(size);
+    return false;
+  }
+
+  ssize_t bytes_sent = m_socket->SendTo(stack, destination);
+  stack->Pop(size);
+  return bytes_sent == static_cast<ssize_t>(size);
+}
+
+
 
 IncomingUDPTransport::IncomingUDPTransport(ola::network::UDPSocket *socket,
                                            BaseInflator *inflator)
@@ -47,6 +47,7 @@ class OutgoingUDPTransport: public OutgoingTransport {
     ~OutgoingUDPTransport() {}
 
     bool Send(const PDUBlock<PDU> &pdu_block);
+    bool Send(ola::io::IOStack *stack);
 
  private:
     class OutgoingUDPTransportImpl *m_impl;
@@ -78,6 +79,8 @@ class OutgoingUDPTransportImpl {
 
     bool Send(const PDUBlock<PDU> &pdu_block,
               const ola::network::IPV4SocketAddress &destination);
+    bool Send(ola::io::IOStack *stack,
+              const ola::network::IPV4SocketAddress &destination);
 
  private:
     ola::network::UDPSocket *m_socket;
@@ -0,0 +1,148 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * e131_replay.cpp
+ * Replay a packet capture through the E1.31 receive path and measure how it
+ * performs.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "common/network/PacketCapture.h"
+#include "common/network/PacketReplay.h"
+#include "ola/Callback.h"
+#include "ola/Clock.h"
+#include "ola/DmxBuffer.h"
+#include "ola/acn/ACNPort.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/stl/STLUtils.h"
+#include "libs/acn/DMPE131Inflator.h"
+#include "libs/acn/E131Inflator.h"
+#include "libs/acn/HeaderSet.h"
+#include "libs/acn/PreamblePacker.h"
+#include "libs/acn/RootInflator.h"
+#include "libs/acn/TransportHeader.h"
+
+using ola::Clock;
+using ola::DmxBuffer;
+using ola::TimeStamp;
+using ola::acn::DMPE131Inflator;
+using ola::acn::E131Inflator;
+using ola::acn::E131InflatorRev2;
+using ola::acn::HeaderSet;
+using ola::acn::PreamblePacker;
+using ola::acn::RootInflator;
+using ola::acn::TransportHeader;
+using ola::network::CapturedPacket;
+using ola::network::LatencyRecorder;
+using ola::network::PacketCaptureReader;
+using ola::network::PrintReplaySummary;
+using ola::network::WaitForPacket;
+using std::vector;
+
+DEFINE_s_uint16(speed, s, 1,
+                "The replay speed as a multiple of real time, 0 replays as "
+                "fast as possible.");
+DEFINE_s_uint16(universe, u, 1, "The first universe to listen on.");
+DEFINE_s_uint16(universes, n, 1, "The number of universes to listen on.");
+DEFINE_s_uint16(port, p, ola::acn::ACN_PORT,
+                "Replay the packets sent to this UDP port.");
+
+/**
+ * Pass a datagram to the inflators, the same way IncomingUDPTransport does.
+ */
+void InjectPacket(RootInflator *inflator, const CapturedPacket &packet) {
+  unsigned int header_size = PreamblePacker::ACN_HEADER_SIZE;
+  if (packet.Size() < header_size ||
+      memcmp(packet.Data(), PreamblePacker::ACN_HEADER, header_size)) {
+    return;
+  }
+
+  HeaderSet header_set;
+  TransportHeader transport_header(packet.source, TransportHeader::UDP);
+  header_set.SetTransportHeader(transport_header);
+  inflator->InflatePDUBlock(&header_set, packet.Data() + header_size,
+                            packet.Size() - header_size);
+}
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "<capture-file>",
+               "Replay the E1.31 packets in a pcap file through the E1.31 "
+               "receive path.");
+
+  if (argc != 2 || FLAGS_universes == 0) {
+    ola::DisplayUsageAndExit();
+  }
+
+  PacketCaptureReader reader;
+  if (!reader.Open(argv[1])) {
+    exit(ola::EXIT_NOINPUT);
+  }
+
+  Clock clock;
+  LatencyRecorder recorder(&clock);
+
+  RootInflator root_inflator;
+  E131Inflator e131_inflator;
+  E131InflatorRev2 e131_rev2_inflator;
+  DMPE131Inflator dmp_inflator(false);
+  root_inflator.AddInflator(&e131_inflator);
+  root_inflator.AddInflator(&e131_rev2_inflator);
+  e131_inflator.AddInflator(&dmp_inflator);
+  e131_rev2_inflator.AddInflator(&dmp_inflator);
+
+  vector<DmxBuffer*> buffers;
+  vector<uint8_t> priorities(FLAGS_universes);
+  for (uint16_t i = 0; i < FLAGS_universes; i++) {
+    DmxBuffer *buffer = new DmxBuffer();
+    buffers.push_back(buffer);
+    dmp_inflator.SetHandler(
+        static_cast<uint16_t>(FLAGS_universe + i), buffer, &priorities[i],
+        ola::NewCallback(&recorder, &LatencyRecorder::NewDMX));
+  }
+
+  unsigned int packets = 0;
+  CapturedPacket packet;
+  TimeStamp capture_start, replay_start, replay_end;
+  clock.CurrentTime(&replay_start);
+
+  while (reader.Next(&packet)) {
+    if (packet.destination.Port() != FLAGS_port) {
+      continue;
+    }
+    if (packets == 0) {
+      capture_start = packet.timestamp;
+    }
+    WaitForPacket(&clock, FLAGS_speed, replay_start, capture_start,
+                  packet.timestamp);
+    recorder.PacketInjected();
+    InjectPacket(&root_inflator, packet);
+    packets++;
+  }
+  clock.CurrentTime(&replay_end);
+
+  for (uint16_t i = 0; i < FLAGS_universes; i++) {
+    dmp_inflator.RemoveHandler(static_cast<uint16_t>(FLAGS_universe + i));
+  }
+  ola::STLDeleteElements(&buffers);
+
+  PrintReplaySummary(packets, replay_end - replay_start, recorder, "merged");
+  return ola::EXIT_OK;
+}
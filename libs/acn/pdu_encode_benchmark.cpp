@@ -0,0 +1,154 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * pdu_encode_benchmark.cpp
+ * Measure the throughput of encoding E1.31 data packets.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <vector>
+#include "ola/Constants.h"
+#include "ola/DmxBuffer.h"
+#include "ola/acn/ACNVectors.h"
+#include "ola/acn/CID.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/io/IOStack.h"
+#include "ola/io/MemoryBlockPool.h"
+#include "ola/testing/BenchmarkTimer.h"
+#include "libs/acn/DMPPDU.h"
+#include "libs/acn/E131Header.h"
+#include "libs/acn/E131PDU.h"
+#include "libs/acn/PreamblePacker.h"
+#include "libs/acn/RootPDU.h"
+
+using ola::DmxBuffer;
+using ola::acn::CID;
+using ola::acn::DMPAddressData;
+using ola::acn::DMPPDU;
+using ola::acn::E131Header;
+using ola::acn::E131PDU;
+using ola::acn::PDU;
+using ola::acn::PDUBlock;
+using ola::acn::PreamblePacker;
+using ola::acn::RootPDU;
+using ola::acn::TwoByteRangeDMPAddress;
+using ola::io::IOStack;
+using ola::io::MemoryBlockPool;
+using ola::testing::BenchmarkTimer;
+using std::vector;
+
+DEFINE_s_uint32(iterations, i, 1000000, "The number of packets to encode");
+DEFINE_s_uint16(slots, s, ola::DMX_UNIVERSE_SIZE,
+                "The number of slots in each packet [1 - 512]");
+
+/**
+ * Encode packets by building the PDU objects & packing them into a flat
+ * buffer. This is how E1.31 packets were built before the IOStack path.
+ */
+uint64_t EncodeWithPack(const CID &cid, const E131Header &header,
+                        const DmxBuffer &buffer, unsigned int iterations) {
+  PreamblePacker packer;
+  uint8_t send_buffer[ola::DMX_UNIVERSE_SIZE + 1];
+  send_buffer[0] = ola::DMX512_START_CODE;
+  uint64_t total = 0;
+
+  for (unsigned int i = 0; i < iterations; i++) {
+    unsigned int data_size = ola::DMX_UNIVERSE_SIZE;
+    buffer.Get(send_buffer + 1, &data_size);
+    data_size++;
+
+    TwoByteRangeDMPAddress range_addr(0, 1,
+                                      static_cast<uint16_t>(data_size));
+    DMPAddressData<TwoByteRangeDMPAddress> range_chunk(
+        &range_addr, send_buffer, data_size);
+    vector<DMPAddressData<TwoByteRangeDMPAddress> > ranged_chunks;
+    ranged_chunks.push_back(range_chunk);
+    const DMPPDU *dmp_pdu = ola::acn::NewRangeDMPSetProperty<uint16_t>(
+        true, false, ranged_chunks);
+
+    E131PDU e131_pdu(ola::acn::VECTOR_E131_DATA, header, dmp_pdu);
+    PDUBlock<PDU> working_block, root_block;
+    working_block.AddPDU(&e131_pdu);
+    RootPDU root_pdu(ola::acn::VECTOR_ROOT_E131);
+    root_pdu.Cid(cid);
+    root_pdu.SetBlock(&working_block);
+    root_block.AddPDU(&root_pdu);
+
+    unsigned int length = 0;
+    if (packer.Pack(root_block, &length)) {
+      total += length;
+    }
+    delete dmp_pdu;
+  }
+  return total;
+}
+
+
+/**
+ * Encode packets by prepending the headers into pooled MemoryBlocks.
+ */
+uint64_t EncodeWithIOStack(const CID &cid, const E131Header &header,
+                           const DmxBuffer &buffer, unsigned int iterations) {
+  MemoryBlockPool pool;
+  uint64_t total = 0;
+
+  for (unsigned int i = 0; i < iterations; i++) {
+    IOStack packet(&pool);
+    unsigned int slots = buffer.Size();
+    packet.Write(buffer.GetRaw(), slots);
+    uint8_t start_code = ola::DMX512_START_CODE;
+    packet.Write(&start_code, sizeof(start_code));
+    slots++;
+
+    TwoByteRangeDMPAddress range_addr(0, 1, static_cast<uint16_t>(slots));
+    ola::acn::PrependRangeDMPSetProperty<uint16_t>(&packet, true, false,
+                                                   range_addr);
+    E131PDU::PrependPDU(&packet, ola::acn::VECTOR_E131_DATA, header);
+    RootPDU::PrependPDU(&packet, ola::acn::VECTOR_ROOT_E131, cid);
+    PreamblePacker::AddUDPPreamble(&packet);
+    total += packet.Size();
+  }
+  return total;
+}
+
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "",
+               "Measure the throughput of E1.31 packet encoding.");
+
+  if (FLAGS_iterations == 0 || FLAGS_slots == 0 ||
+      FLAGS_slots > ola::DMX_UNIVERSE_SIZE) {
+    ola::DisplayUsageAndExit();
+  }
+
+  DmxBuffer buffer;
+  for (unsigned int i = 0; i < FLAGS_slots; i++) {
+    buffer.SetChannel(i, static_cast<uint8_t>(i));
+  }
+
+  CID cid = CID::Generate();
+  E131Header header("pdu_encode_benchmark", 100, 0, 1);
+  unsigned int iterations = FLAGS_iterations;
+  BenchmarkTimer timer;
+
+  uint64_t bytes = EncodeWithPack(cid, header, buffer, iterations);
+  timer.Report("pack", bytes, iterations);
+
+  bytes = EncodeWithIOStack(cid, header, buffer, iterations);
+  timer.Report("iostack", bytes, iterations);
+  return 0;
+}
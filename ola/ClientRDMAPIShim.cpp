@@ -42,6 +42,7 @@ bool ClientRDMAPIShim::RDMGet(rdm_callback *callback,
                               unsigned int data_length) {
   SendRDMArgs args(NewSingleCallback(
       this, &ClientRDMAPIShim::HandleResponse, callback));
+  args.cache_first = m_cache_first;
   m_client->RDMGet(universe, uid, sub_device, pid, data, data_length, args);
   return true;
 }
@@ -55,6 +56,7 @@ bool ClientRDMAPIShim::RDMGet(rdm_pid_callback *callback,
                               unsigned int data_length) {
   SendRDMArgs args(NewSingleCallback(
       this, &ClientRDMAPIShim::HandleResponseWithPid, callback));
+  args.cache_first = m_cache_first;
   m_client->RDMGet(universe, uid, sub_device, pid, data, data_length, args);
   return true;
 }
@@ -20,6 +20,7 @@
 
 #include "ola/client/OlaClient.h"
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -168,6 +169,21 @@ void OlaClient::FetchDMX(unsigned int universe, DMXCallback *callback) {
   m_core->FetchDMX(universe, callback);
 }
 
+void OlaClient::SendBulkDMX(const std::map<unsigned int, DmxBuffer> &data,
+                            const SendDMXArgs &args) {
+  m_core->SendBulkDMX(data, args);
+}
+
+void OlaClient::FetchBulkDMX(const std::vector<unsigned int> &universes,
+                             BulkDMXCallback *callback) {
+  m_core->FetchBulkDMX(universes, callback);
+}
+
+void OlaClient::FetchUniverseStats(const std::vector<unsigned int> &universes,
+                                   UniverseStatsCallback *callback) {
+  m_core->FetchUniverseStats(universes, callback);
+}
+
 void OlaClient::RunDiscovery(unsigned int universe,
                              DiscoveryType discovery_type,
                              DiscoveryCallback *callback) {
@@ -203,5 +219,10 @@ void OlaClient::RDMSet(unsigned int universe,
                        const SendRDMArgs& args) {
   m_core->RDMSet(universe, uid, sub_device, pid, data, data_length, args);
 }
+
+void OlaClient::SendBulkRDM(const std::vector<RDMOperation> &operations,
+                            const SendBulkRDMArgs &args) {
+  m_core->SendBulkRDM(operations, args);
+}
 }  // namespace client
 }  // namespace ola
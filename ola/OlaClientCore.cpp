@@ -24,6 +24,7 @@
 #include <sys/types.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -53,7 +54,19 @@ using std::auto_ptr;
 using std::string;
 using std::vector;
 
+namespace {
+void FrameStatsFromProto(const ola::proto::FrameStats &input,
+                         FrameStats *output) {
+  output->frames = input.frames();
+  output->fps = input.fps();
+  output->jitter_us = input.jitter_us();
+  output->mean_latency_us = input.mean_latency_us();
+  output->max_latency_us = input.max_latency_us();
+}
+}  // namespace
+
 const char OlaClientCore::NOT_CONNECTED_ERROR[] = "Not connected";
+const unsigned int OlaClientCore::BULK_RDM_CHUNK_SIZE;
 
 OlaClientCore::OlaClientCore(ConnectedDescriptor *descriptor)
     : m_descriptor(descriptor),
@@ -515,6 +528,79 @@ void OlaClientCore::FetchDMX(unsigned int universe,
   }
 }
 
+void OlaClientCore::SendBulkDMX(const std::map<unsigned int, DmxBuffer> &data,
+                                const SendDMXArgs &args) {
+  ola::proto::DmxDataBulk request;
+  std::map<unsigned int, DmxBuffer>::const_iterator iter = data.begin();
+  for (; iter != data.end(); ++iter) {
+    ola::proto::DmxData *universe_data = request.add_data();
+    universe_data->set_universe(iter->first);
+    universe_data->set_data(iter->second.Get());
+    universe_data->set_priority(args.priority);
+  }
+
+  RpcController *controller = new RpcController();
+  ola::proto::Ack *reply = new ola::proto::Ack();
+
+  if (m_connected) {
+    CompletionCallback *cb = ola::NewSingleCallback(
+        this,
+        &OlaClientCore::HandleGeneralAck,
+        controller, reply, args.callback);
+    m_stub->UpdateDmxDataBulk(controller, &request, reply, cb);
+  } else {
+    controller->SetFailed(NOT_CONNECTED_ERROR);
+    HandleGeneralAck(controller, reply, args.callback);
+  }
+}
+
+void OlaClientCore::FetchBulkDMX(const std::vector<unsigned int> &universes,
+                                 BulkDMXCallback *callback) {
+  ola::proto::UniverseListRequest request;
+  RpcController *controller = new RpcController();
+  ola::proto::DmxDataBulk *reply = new ola::proto::DmxDataBulk();
+
+  std::vector<unsigned int>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    request.add_universe(*iter);
+  }
+
+  if (m_connected) {
+    CompletionCallback *cb = NewSingleCallback(
+        this,
+        &OlaClientCore::HandleGetDmxBulk,
+        controller, reply, callback);
+    m_stub->GetDmxBulk(controller, &request, reply, cb);
+  } else {
+    controller->SetFailed(NOT_CONNECTED_ERROR);
+    HandleGetDmxBulk(controller, reply, callback);
+  }
+}
+
+void OlaClientCore::FetchUniverseStats(
+    const std::vector<unsigned int> &universes,
+    UniverseStatsCallback *callback) {
+  ola::proto::UniverseListRequest request;
+  RpcController *controller = new RpcController();
+  ola::proto::UniverseStatsReply *reply = new ola::proto::UniverseStatsReply();
+
+  std::vector<unsigned int>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    request.add_universe(*iter);
+  }
+
+  if (m_connected) {
+    CompletionCallback *cb = NewSingleCallback(
+        this,
+        &OlaClientCore::HandleUniverseStats,
+        controller, reply, callback);
+    m_stub->GetUniverseStats(controller, &request, reply, cb);
+  } else {
+    controller->SetFailed(NOT_CONNECTED_ERROR);
+    HandleUniverseStats(controller, reply, callback);
+  }
+}
+
 void OlaClientCore::RunDiscovery(unsigned int universe,
                                  DiscoveryType discovery_type,
                                  DiscoveryCallback *callback) {
@@ -886,6 +972,58 @@ void OlaClientCore::HandleGetDmx(RpcController *controller_ptr,
   callback->Run(result, metadata, buffer);
 }
 
+void OlaClientCore::HandleGetDmxBulk(RpcController *controller_ptr,
+                                     ola::proto::DmxDataBulk *reply_ptr,
+                                     BulkDMXCallback *callback) {
+  auto_ptr<RpcController> controller(controller_ptr);
+  auto_ptr<ola::proto::DmxDataBulk> reply(reply_ptr);
+
+  if (!callback) {
+    return;
+  }
+
+  Result result(controller->Failed() ? controller->ErrorText() : "");
+  std::map<unsigned int, DmxBuffer> data;
+  if (!controller->Failed()) {
+    for (int i = 0; i < reply->data_size(); i++) {
+      data[reply->data(i).universe()].Set(reply->data(i).data());
+    }
+  }
+  callback->Run(result, data);
+}
+
+void OlaClientCore::HandleUniverseStats(
+    RpcController *controller_ptr,
+    ola::proto::UniverseStatsReply *reply_ptr,
+    UniverseStatsCallback *callback) {
+  auto_ptr<RpcController> controller(controller_ptr);
+  auto_ptr<ola::proto::UniverseStatsReply> reply(reply_ptr);
+
+  if (!callback) {
+    return;
+  }
+
+  Result result(controller->Failed() ? controller->ErrorText() : "");
+  std::vector<UniverseStats> stats;
+  if (!controller->Failed()) {
+    stats.resize(reply->universe_size());
+    for (int i = 0; i < reply->universe_size(); i++) {
+      const ola::proto::UniverseStats &universe = reply->universe(i);
+      stats[i].universe = universe.universe();
+      FrameStatsFromProto(universe.input(), &stats[i].input);
+      FrameStatsFromProto(universe.output(), &stats[i].output);
+      stats[i].ports.resize(universe.port_size());
+      for (int j = 0; j < universe.port_size(); j++) {
+        PortStats &port = stats[i].ports[j];
+        port.port_id = universe.port(j).port_id();
+        port.is_output = universe.port(j).is_output();
+        FrameStatsFromProto(universe.port(j).stats(), &port.stats);
+      }
+    }
+  }
+  callback->Run(result, stats);
+}
+
 void OlaClientCore::HandleUIDList(RpcController *controller_ptr,
                                   ola::proto::UIDListReply *reply_ptr,
                                   DiscoveryCallback *callback) {
@@ -925,23 +1063,75 @@ void OlaClientCore::HandleRDM(RpcController *controller_ptr,
 
   if (!controller->Failed()) {
     response = BuildRDMResponse(reply.get(), &metadata.response_code);
-    for (int i = 0; i < reply->raw_frame_size(); i++) {
-      const ola::proto::RDMFrame &proto_frame = reply->raw_frame(i);
-
-      ola::rdm::RDMFrame frame(
-          reinterpret_cast<const uint8_t*>(proto_frame.raw_response().data()),
-          proto_frame.raw_response().size());
-      frame.timing.response_time = proto_frame.timing().response_delay();
-      frame.timing.break_time = proto_frame.timing().break_time();
-      frame.timing.mark_time = proto_frame.timing().mark_time();
-      frame.timing.data_time = proto_frame.timing().data_time();
-      metadata.frames.push_back(frame);
-    }
+    CopyRDMFrames(*reply, &metadata);
   }
 
   callback->Run(result, metadata, response);
 }
 
+void OlaClientCore::HandleBulkRDM(RpcController *controller_ptr,
+                                  ola::proto::RDMBulkResponse *reply_ptr,
+                                  bulk_rdm_state *state,
+                                  unsigned int offset) {
+  auto_ptr<RpcController> controller(controller_ptr);
+  auto_ptr<ola::proto::RDMBulkResponse> reply(reply_ptr);
+  unsigned int count = std::min(BULK_RDM_CHUNK_SIZE, state->total - offset);
+
+  if (controller->Failed()) {
+    if (state->error.empty()) {
+      state->error = controller->ErrorText();
+    }
+    Result result(controller->ErrorText());
+    RDMMetadata metadata;
+    for (unsigned int i = 0; i < count; i++) {
+      state->callback->Run(result, offset + i, metadata, NULL);
+    }
+  } else {
+    Result result("");
+    for (unsigned int i = 0; i < count; i++) {
+      RDMMetadata metadata;
+      auto_ptr<ola::rdm::RDMResponse> response;
+      if (i < static_cast<unsigned int>(reply->response_size())) {
+        ola::proto::RDMResponse *proto_response = reply->mutable_response(i);
+        response.reset(
+            BuildRDMResponse(proto_response, &metadata.response_code));
+        CopyRDMFrames(*proto_response, &metadata);
+      } else {
+        metadata.response_code = ola::rdm::RDM_FAILED_TO_SEND;
+      }
+      state->callback->Run(result, offset + i, metadata, response.get());
+    }
+  }
+  BulkRDMChunkComplete(state);
+}
+
+void OlaClientCore::BulkRDMChunkComplete(bulk_rdm_state *state) {
+  if (--state->outstanding) {
+    return;
+  }
+  if (state->done) {
+    state->done->Run(Result(state->error));
+  }
+  delete state->callback;
+  delete state;
+}
+
+void OlaClientCore::CopyRDMFrames(const ola::proto::RDMResponse &reply,
+                                  RDMMetadata *metadata) {
+  for (int i = 0; i < reply.raw_frame_size(); i++) {
+    const ola::proto::RDMFrame &proto_frame = reply.raw_frame(i);
+
+    ola::rdm::RDMFrame frame(
+        reinterpret_cast<const uint8_t*>(proto_frame.raw_response().data()),
+        proto_frame.raw_response().size());
+    frame.timing.response_time = proto_frame.timing().response_delay();
+    frame.timing.break_time = proto_frame.timing().break_time();
+    frame.timing.mark_time = proto_frame.timing().mark_time();
+    frame.timing.data_time = proto_frame.timing().data_time();
+    metadata->frames.push_back(frame);
+  }
+}
+
 void OlaClientCore::GenericFetchCandidatePorts(
     unsigned int universe_id,
     bool include_universe,
@@ -1004,6 +1194,12 @@ void OlaClientCore::SendRDMCommand(bool is_set,
   if (args.include_raw_frames) {
     request.set_include_raw_response(true);
   }
+  if (args.bulk) {
+    request.set_bulk(true);
+  }
+  if (args.cache_first) {
+    request.set_cache_first(true);
+  }
 
   CompletionCallback *cb = NewSingleCallback(
       this,
@@ -1013,6 +1209,72 @@ void OlaClientCore::SendRDMCommand(bool is_set,
   m_stub->RDMCommand(controller, &request, reply, cb);
 }
 
+/*
+ * Send a batch of rdm commands, split into chunks of BULK_RDM_CHUNK_SIZE.
+ */
+void OlaClientCore::SendBulkRDM(const vector<RDMOperation> &operations,
+                                const SendBulkRDMArgs &args) {
+  if (!args.callback) {
+    OLA_WARN << "Bulk RDM callback was null, commands won't be sent";
+    if (args.done) {
+      args.done->Run(Result("Missing callback"));
+    }
+    return;
+  }
+
+  bulk_rdm_state *state = new bulk_rdm_state;
+  state->callback = args.callback;
+  state->done = args.done;
+  state->total = static_cast<unsigned int>(operations.size());
+  // The extra count stops the state being freed while we're still sending.
+  state->outstanding = 1;
+
+  for (unsigned int offset = 0; offset < state->total;
+       offset += BULK_RDM_CHUNK_SIZE) {
+    unsigned int count = std::min(BULK_RDM_CHUNK_SIZE, state->total - offset);
+    RpcController *controller = new RpcController();
+    ola::proto::RDMBulkResponse *reply = new ola::proto::RDMBulkResponse();
+    state->outstanding++;
+
+    if (!m_connected) {
+      controller->SetFailed(NOT_CONNECTED_ERROR);
+      HandleBulkRDM(controller, reply, state, offset);
+      continue;
+    }
+
+    ola::proto::RDMBulkRequest request;
+    for (unsigned int i = offset; i < offset + count; i++) {
+      const RDMOperation &operation = operations[i];
+      ola::proto::RDMRequest *pb_request = request.add_request();
+      pb_request->set_universe(operation.universe);
+      ola::proto::UID *pb_uid = pb_request->mutable_uid();
+      pb_uid->set_esta_id(operation.uid.ManufacturerId());
+      pb_uid->set_device_id(operation.uid.DeviceId());
+      pb_request->set_sub_device(operation.sub_device);
+      pb_request->set_param_id(operation.pid);
+      pb_request->set_is_set(operation.is_set);
+      pb_request->set_data(operation.data);
+
+      if (args.include_raw_frames) {
+        pb_request->set_include_raw_response(true);
+      }
+      if (args.bulk) {
+        pb_request->set_bulk(true);
+      }
+      if (args.cache_first) {
+        pb_request->set_cache_first(true);
+      }
+    }
+
+    CompletionCallback *cb = NewSingleCallback(
+        this,
+        &OlaClientCore::HandleBulkRDM,
+        controller, reply, state, offset);
+    m_stub->RDMBulkCommand(controller, &request, reply, cb);
+  }
+  BulkRDMChunkComplete(state);
+}
+
 /**
  * This constructs a ola::rdm::RDMResponse object from the information in a
  * ola::proto::RDMResponse.
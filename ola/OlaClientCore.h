@@ -21,8 +21,10 @@
 #ifndef OLA_OLACLIENTCORE_H_
 #define OLA_OLACLIENTCORE_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/protocol/Ola.pb.h"
 #include "common/protocol/OlaService.pb.h"
@@ -246,6 +248,18 @@ class OlaClientCore: public ola::proto::OlaClientService {
                const DmxBuffer &data,
                const SendDMXArgs &args);
 
+  /**
+   * @brief Send DMX data for several universes at once.
+   *
+   * olad applies all the updates together, so they go out in the same frame.
+   * If any of the universes don't exist, none of them are updated.
+   * @param data a map of universe id to DmxBuffer.
+   * @param args the SendDMXArgs to use for this call, the priority applies to
+   *   all the universes.
+   */
+  void SendBulkDMX(const std::map<unsigned int, DmxBuffer> &data,
+                   const SendDMXArgs &args);
+
   /**
    * @brief Fetch the latest DMX data for a universe.
    * @param universe the universe id to get data for.
@@ -253,6 +267,23 @@ class OlaClientCore: public ola::proto::OlaClientService {
    */
   void FetchDMX(unsigned int universe, DMXCallback *callback);
 
+  /**
+   * @brief Fetch the latest DMX data for several universes.
+   * @param universes the universe ids to get data for.
+   * @param callback the BulkDMXCallback to invoke upon completion.
+   */
+  void FetchBulkDMX(const std::vector<unsigned int> &universes,
+                    BulkDMXCallback *callback);
+
+  /**
+   * @brief Fetch the frame rate, latency & jitter for universes.
+   * @param universes the universe ids to get the stats for, or an empty
+   *   vector for all universes.
+   * @param callback the UniverseStatsCallback to invoke upon completion.
+   */
+  void FetchUniverseStats(const std::vector<unsigned int> &universes,
+                          UniverseStatsCallback *callback);
+
   /**
    * @brief Trigger discovery for a universe.
    * @param universe the universe id to run discovery on.
@@ -306,6 +337,18 @@ class OlaClientCore: public ola::proto::OlaClientService {
               unsigned int data_length,
               const SendRDMArgs& args);
 
+  /**
+   * @brief Send a batch of RDM commands.
+   *
+   * The commands are sent to olad without waiting for the earlier ones to
+   * complete. The callback in args is run once for each operation, with the
+   * index of the operation, as the responses arrive.
+   * @param operations the RDM requests to send.
+   * @param args the arguments, which include the callbacks to run.
+   */
+  void SendBulkRDM(const std::vector<RDMOperation> &operations,
+                   const SendBulkRDMArgs &args);
+
   /**
    * @brief Send TimeCode data.
    * @param timecode The timecode data.
@@ -401,6 +444,20 @@ class OlaClientCore: public ola::proto::OlaClientService {
                     ola::proto::DmxData *reply,
                     DMXCallback *callback);
 
+  /**
+   * @brief Called when a GetDmxBulk() request completes.
+   */
+  void HandleGetDmxBulk(ola::rpc::RpcController *controller,
+                        ola::proto::DmxDataBulk *reply,
+                        BulkDMXCallback *callback);
+
+  /**
+   * @brief Called when a GetUniverseStats() request completes.
+   */
+  void HandleUniverseStats(ola::rpc::RpcController *controller,
+                           ola::proto::UniverseStatsReply *reply,
+                           UniverseStatsCallback *callback);
+
   /**
    * @brief Called when a RunDiscovery() request completes.
    */
@@ -441,8 +498,43 @@ class OlaClientCore: public ola::proto::OlaClientService {
       ola::proto::RDMResponse *reply,
       ola::rdm::RDMStatusCode *status_code);
 
+  /**
+   * @brief Tracks the chunks of a SendBulkRDM() call.
+   */
+  typedef struct {
+    BulkRDMCallback *callback;
+    SetCallback *done;
+    unsigned int total;
+    unsigned int outstanding;
+    std::string error;
+  } bulk_rdm_state;
+
+  /**
+   * @brief Called when a chunk of a bulk RDM request completes.
+   */
+  void HandleBulkRDM(ola::rpc::RpcController *controller,
+                     ola::proto::RDMBulkResponse *reply,
+                     bulk_rdm_state *state,
+                     unsigned int offset);
+
+  /**
+   * @brief Called once per chunk, and once by SendBulkRDM() itself.
+   */
+  void BulkRDMChunkComplete(bulk_rdm_state *state);
+
+  /**
+   * @brief Copy the raw frames from the server's RDM reply message.
+   */
+  static void CopyRDMFrames(const ola::proto::RDMResponse &reply,
+                     RDMMetadata *metadata);
+
   static const char NOT_CONNECTED_ERROR[];
 
+  /**
+   * @brief The maximum number of operations to send in a single RPC.
+   */
+  static const unsigned int BULK_RDM_CHUNK_SIZE = 250;
+
   DISALLOW_COPY_AND_ASSIGN(OlaClientCore);
 };
 
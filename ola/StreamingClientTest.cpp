@@ -93,6 +93,7 @@ bool OlaServerThread::Setup() {
   ola_options.http_localhost_only = false;
   ola_options.http_enable_quit = false;
   ola_options.http_port = 0;
+  ola_options.http_threads = 0;
   ola_options.http_data_dir = "";
 
   // pick an unused port
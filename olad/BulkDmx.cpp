@@ -0,0 +1,321 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * BulkDmx.cpp
+ * The formats used to send & receive DMX for many universes over HTTP.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <string>
+#include "ola/Constants.h"
+#include "ola/DmxBuffer.h"
+#include "ola/StringUtils.h"
+#include "ola/base/Macro.h"
+#include "ola/web/JsonLexer.h"
+#include "olad/BulkDmx.h"
+
+namespace ola {
+
+using ola::web::JsonDouble;
+using ola::web::JsonLexer;
+using ola::web::JsonParserInterface;
+using std::string;
+
+namespace {
+
+const char BASE64_CHARS[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// universe (4) + length (2)
+const unsigned int BINARY_HEADER_SIZE = 6;
+
+/*
+ * Fills a BulkDmxData from the JSON format as it's lexed, without building a
+ * tree of JsonValues.
+ */
+class BulkDmxJsonParser : public JsonParserInterface {
+ public:
+  explicit BulkDmxJsonParser(BulkDmxData *data)
+      : m_data(data),
+        m_state(START),
+        m_universe(0),
+        m_has_universe(false),
+        m_has_dmx(false) {
+  }
+
+  void Begin() {}
+  void End() {}
+
+  void String(const string &value) {
+    if (m_state != UNIVERSE_OBJECT || m_key != "base64") {
+      return Unexpected();
+    }
+    m_dmx.clear();
+    if (!Base64Decode(value, &m_dmx)) {
+      return SetError("Invalid base64 data");
+    }
+    m_has_dmx = true;
+  }
+
+  void Number(uint32_t value) {
+    if (m_state == DMX_ARRAY) {
+      if (value > DMX_MAX_SLOT_VALUE) {
+        return SetError("DMX values must be between 0 and 255");
+      }
+      if (m_dmx.size() == DMX_UNIVERSE_SIZE) {
+        return SetError("Too many DMX values");
+      }
+      m_dmx.push_back(static_cast<char>(value));
+    } else if (m_state == UNIVERSE_OBJECT && m_key == "universe") {
+      m_universe = value;
+      m_has_universe = true;
+    } else {
+      Unexpected();
+    }
+  }
+
+  void Number(int32_t value) {
+    // -0 is lexed as a signed number.
+    if (value < 0) {
+      return Unexpected();
+    }
+    Number(static_cast<uint32_t>(value));
+  }
+
+  void Number(uint64_t) { Unexpected(); }
+  void Number(int64_t) { Unexpected(); }
+  void Number(const JsonDouble::DoubleRepresentation &) { Unexpected(); }
+  void Number(double) { Unexpected(); }
+  void Bool(bool) { Unexpected(); }
+  void Null() { Unexpected(); }
+
+  void OpenArray() {
+    if (m_state == TOP_OBJECT && m_key == "universes") {
+      m_state = UNIVERSES_ARRAY;
+    } else if (m_state == UNIVERSE_OBJECT && m_key == "dmx") {
+      m_state = DMX_ARRAY;
+      m_dmx.clear();
+    } else {
+      Unexpected();
+    }
+  }
+
+  void CloseArray() {
+    if (m_state == DMX_ARRAY) {
+      m_state = UNIVERSE_OBJECT;
+      m_has_dmx = true;
+    } else if (m_state == UNIVERSES_ARRAY) {
+      m_state = TOP_OBJECT;
+    }
+  }
+
+  void OpenObject() {
+    if (m_state == START) {
+      m_state = TOP_OBJECT;
+    } else if (m_state == UNIVERSES_ARRAY) {
+      m_state = UNIVERSE_OBJECT;
+      m_has_universe = false;
+      m_has_dmx = false;
+    } else {
+      Unexpected();
+    }
+  }
+
+  void ObjectKey(const string &key) {
+    m_key = key;
+  }
+
+  void CloseObject() {
+    if (m_state != UNIVERSE_OBJECT) {
+      return;
+    }
+    if (!m_has_universe) {
+      return SetError("Missing universe");
+    }
+    if (!m_has_dmx || m_dmx.empty()) {
+      return SetError("Missing DMX data for universe " +
+                      IntToString(m_universe));
+    }
+    if (m_dmx.size() > DMX_UNIVERSE_SIZE) {
+      return SetError("Too much DMX data for universe " +
+                      IntToString(m_universe));
+    }
+    (*m_data)[m_universe].Set(m_dmx);
+    m_state = UNIVERSES_ARRAY;
+  }
+
+  void SetError(const string &error) {
+    // Keep the first error, and ignore everything after it.
+    if (m_error.empty()) {
+      m_error = error;
+      m_state = FAILED;
+    }
+  }
+
+  const string &Error() const { return m_error; }
+
+ private:
+  enum State {
+    START,
+    TOP_OBJECT,
+    UNIVERSES_ARRAY,
+    UNIVERSE_OBJECT,
+    DMX_ARRAY,
+    FAILED,
+  };
+
+  BulkDmxData *m_data;
+  State m_state;
+  string m_key;
+  string m_error;
+  unsigned int m_universe;
+  bool m_has_universe;
+  bool m_has_dmx;
+  string m_dmx;
+
+  void Unexpected() {
+    if (m_state == FAILED) {
+      return;
+    }
+    SetError(m_key.empty() ? string("Unexpected value") :
+             "Unexpected value for " + m_key);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(BulkDmxJsonParser);
+};
+
+int Base64Value(char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  } else if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  } else if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  } else if (c == '+') {
+    return 62;
+  } else if (c == '/') {
+    return 63;
+  }
+  return -1;
+}
+}  // namespace
+
+bool ParseBulkDmxJson(const string &input, BulkDmxData *data,
+                      string *error) {
+  BulkDmxJsonParser parser(data);
+  if (!JsonLexer::Parse(input, &parser)) {
+    *error = parser.Error().empty() ? "Invalid JSON" : parser.Error();
+    return false;
+  }
+  if (!parser.Error().empty()) {
+    *error = parser.Error();
+    return false;
+  }
+  return true;
+}
+
+bool ParseBulkDmxBinary(const string &input, BulkDmxData *data,
+                        string *error) {
+  const uint8_t *ptr = reinterpret_cast<const uint8_t*>(input.data());
+  const uint8_t *end = ptr + input.size();
+  while (ptr != end) {
+    if (end - ptr < static_cast<int>(BINARY_HEADER_SIZE)) {
+      *error = "Truncated universe header";
+      return false;
+    }
+    unsigned int universe = (static_cast<unsigned int>(ptr[0]) << 24) |
+                            (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+    unsigned int length = (ptr[4] << 8) | ptr[5];
+    ptr += BINARY_HEADER_SIZE;
+
+    if (length == 0 || length > DMX_UNIVERSE_SIZE) {
+      *error = "Invalid DMX length for universe " + IntToString(universe);
+      return false;
+    }
+    if (end - ptr < static_cast<int>(length)) {
+      *error = "Truncated DMX data for universe " + IntToString(universe);
+      return false;
+    }
+    (*data)[universe].Set(ptr, length);
+    ptr += length;
+  }
+  return true;
+}
+
+void WriteBulkDmxBinary(const BulkDmxData &data, string *output) {
+  BulkDmxData::const_iterator iter = data.begin();
+  for (; iter != data.end(); ++iter) {
+    unsigned int universe = iter->first;
+    unsigned int length = iter->second.Size();
+    output->push_back(static_cast<char>(universe >> 24));
+    output->push_back(static_cast<char>(universe >> 16));
+    output->push_back(static_cast<char>(universe >> 8));
+    output->push_back(static_cast<char>(universe));
+    output->push_back(static_cast<char>(length >> 8));
+    output->push_back(static_cast<char>(length));
+    output->append(iter->second.Get());
+  }
+}
+
+void Base64Encode(const string &data, string *output) {
+  output->reserve(output->size() + (data.size() + 2) / 3 * 4);
+  const uint8_t *ptr = reinterpret_cast<const uint8_t*>(data.data());
+  size_t remaining = data.size();
+  for (; remaining >= 3; remaining -= 3, ptr += 3) {
+    output->push_back(BASE64_CHARS[ptr[0] >> 2]);
+    output->push_back(BASE64_CHARS[((ptr[0] & 0x03) << 4) | (ptr[1] >> 4)]);
+    output->push_back(BASE64_CHARS[((ptr[1] & 0x0f) << 2) | (ptr[2] >> 6)]);
+    output->push_back(BASE64_CHARS[ptr[2] & 0x3f]);
+  }
+
+  if (remaining == 1) {
+    output->push_back(BASE64_CHARS[ptr[0] >> 2]);
+    output->push_back(BASE64_CHARS[(ptr[0] & 0x03) << 4]);
+    output->append("==");
+  } else if (remaining == 2) {
+    output->push_back(BASE64_CHARS[ptr[0] >> 2]);
+    output->push_back(BASE64_CHARS[((ptr[0] & 0x03) << 4) | (ptr[1] >> 4)]);
+    output->push_back(BASE64_CHARS[(ptr[1] & 0x0f) << 2]);
+    output->push_back('=');
+  }
+}
+
+bool Base64Decode(const string &input, string *output) {
+  size_t length = input.size();
+  while (length && input[length - 1] == '=') {
+    length--;
+  }
+  if (input.size() - length > 2 || length % 4 == 1) {
+    return false;
+  }
+
+  unsigned int bits = 0;
+  unsigned int bit_count = 0;
+  for (size_t i = 0; i < length; i++) {
+    int value = Base64Value(input[i]);
+    if (value < 0) {
+      return false;
+    }
+    bits = (bits << 6) | value;
+    bit_count += 6;
+    if (bit_count >= 8) {
+      bit_count -= 8;
+      output->push_back(static_cast<char>((bits >> bit_count) & 0xff));
+    }
+  }
+  return true;
+}
+}  // namespace ola
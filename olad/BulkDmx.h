@@ -0,0 +1,91 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * BulkDmx.h
+ * The formats used to send & receive DMX for many universes over HTTP.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef OLAD_BULKDMX_H_
+#define OLAD_BULKDMX_H_
+
+#include <map>
+#include <string>
+#include "ola/DmxBuffer.h"
+
+namespace ola {
+
+/**
+ * @brief DMX data, keyed by universe id.
+ */
+typedef std::map<unsigned int, DmxBuffer> BulkDmxData;
+
+/**
+ * @brief Parse the JSON bulk DMX format.
+ *
+ * The document looks like:
+ * @code
+ *   {"universes": [
+ *     {"universe": 1, "dmx": [0, 255, 128]},
+ *     {"universe": 2, "base64": "AP+A"}
+ *   ]}
+ * @endcode
+ * Each universe has either a "dmx" array or "base64" encoded data. If a
+ * universe appears more than once, the last data wins.
+ * @param input the JSON text.
+ * @param data the map to add the DMX data to.
+ * @param error set to the reason if parsing fails.
+ * @returns true if the input was valid.
+ */
+bool ParseBulkDmxJson(const std::string &input, BulkDmxData *data,
+                      std::string *error);
+
+/**
+ * @brief Parse the binary bulk DMX format.
+ *
+ * The input is a sequence of records, one per universe. Each record is a
+ * 4 byte universe id and a 2 byte length, both big endian, followed by that
+ * many bytes of DMX data.
+ * @param input the binary data.
+ * @param data the map to add the DMX data to.
+ * @param error set to the reason if parsing fails.
+ * @returns true if the input was valid.
+ */
+bool ParseBulkDmxBinary(const std::string &input, BulkDmxData *data,
+                        std::string *error);
+
+/**
+ * @brief Write DMX data in the binary bulk DMX format.
+ * @param data the DMX data to write.
+ * @param output the string to append to.
+ */
+void WriteBulkDmxBinary(const BulkDmxData &data, std::string *output);
+
+/**
+ * @brief Base64 encode some data.
+ * @param data the data to encode.
+ * @param output the string to append the encoded text to.
+ */
+void Base64Encode(const std::string &data, std::string *output);
+
+/**
+ * @brief Decode base64 text, the padding is optional.
+ * @param input the base64 text.
+ * @param output the string to append the decoded data to.
+ * @returns false if the input isn't valid base64.
+ */
+bool Base64Decode(const std::string &input, std::string *output);
+}  // namespace ola
+#endif  // OLAD_BULKDMX_H_
@@ -0,0 +1,222 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * BulkDmxTest.cpp
+ * Test fixture for the bulk DMX formats.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <string>
+
+#include "ola/Constants.h"
+#include "ola/DmxBuffer.h"
+#include "ola/testing/TestUtils.h"
+#include "olad/BulkDmx.h"
+
+using ola::Base64Decode;
+using ola::Base64Encode;
+using ola::BulkDmxData;
+using ola::DmxBuffer;
+using ola::ParseBulkDmxBinary;
+using ola::ParseBulkDmxJson;
+using ola::WriteBulkDmxBinary;
+using std::string;
+
+class BulkDmxTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(BulkDmxTest);
+  CPPUNIT_TEST(testBase64);
+  CPPUNIT_TEST(testJson);
+  CPPUNIT_TEST(testInvalidJson);
+  CPPUNIT_TEST(testBinary);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void testBase64();
+  void testJson();
+  void testInvalidJson();
+  void testBinary();
+
+ private:
+  bool ParseJson(const string &input, BulkDmxData *data) {
+    string error;
+    return ParseBulkDmxJson(input, data, &error);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BulkDmxTest);
+
+static DmxBuffer FromString(const string &values) {
+  DmxBuffer buffer;
+  buffer.SetFromString(values);
+  return buffer;
+}
+
+
+/*
+ * Check base64 encoding & decoding.
+ */
+void BulkDmxTest::testBase64() {
+  // From RFC 4648
+  const char *vectors[][2] = {
+    {"", ""},
+    {"f", "Zg=="},
+    {"fo", "Zm8="},
+    {"foo", "Zm9v"},
+    {"foob", "Zm9vYg=="},
+    {"fooba", "Zm9vYmE="},
+    {"foobar", "Zm9vYmFy"},
+  };
+
+  for (unsigned int i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+    string encoded;
+    Base64Encode(vectors[i][0], &encoded);
+    OLA_ASSERT_EQ(string(vectors[i][1]), encoded);
+
+    string decoded;
+    OLA_ASSERT_TRUE(Base64Decode(vectors[i][1], &decoded));
+    OLA_ASSERT_EQ(string(vectors[i][0]), decoded);
+  }
+
+  // Binary data, without padding
+  const uint8_t binary[] = {0, 0xff, 0x80, 0xfb};
+  string data(reinterpret_cast<const char*>(binary), sizeof(binary));
+  string encoded;
+  Base64Encode(data, &encoded);
+  OLA_ASSERT_EQ(string("AP+A+w=="), encoded);
+  string decoded;
+  OLA_ASSERT_TRUE(Base64Decode("AP+A+w", &decoded));
+  OLA_ASSERT_EQ(data, decoded);
+
+  OLA_ASSERT_FALSE(Base64Decode("Zm9v!", &decoded));
+  OLA_ASSERT_FALSE(Base64Decode("Z", &decoded));
+  OLA_ASSERT_FALSE(Base64Decode("Zg===", &decoded));
+}
+
+
+/*
+ * Check parsing the JSON format.
+ */
+void BulkDmxTest::testJson() {
+  BulkDmxData data;
+  OLA_ASSERT_TRUE(ParseJson("{\"universes\": []}", &data));
+  OLA_ASSERT_TRUE(data.empty());
+
+  OLA_ASSERT_TRUE(ParseJson(
+      "{\"universes\": ["
+      "  {\"universe\": 1, \"dmx\": [0, 255, 128]},"
+      "  {\"base64\": \"AQID\", \"universe\": 10},"
+      "  {\"universe\": 1, \"dmx\": [1, 2]}"
+      "]}",
+      &data));
+  OLA_ASSERT_EQ(static_cast<size_t>(2), data.size());
+  OLA_ASSERT_EQ(FromString("1,2"), data[1]);
+  OLA_ASSERT_EQ(FromString("1,2,3"), data[10]);
+
+  // A full universe
+  string input = "{\"universes\": [{\"universe\": 4, \"dmx\": [";
+  for (unsigned int i = 0; i < ola::DMX_UNIVERSE_SIZE; i++) {
+    input.append(i ? ", 7" : "7");
+  }
+  input.append("]}]}");
+  data.clear();
+  OLA_ASSERT_TRUE(ParseJson(input, &data));
+  OLA_ASSERT_EQ(static_cast<unsigned int>(ola::DMX_UNIVERSE_SIZE),
+                data[4].Size());
+}
+
+
+/*
+ * Check invalid JSON documents are rejected.
+ */
+void BulkDmxTest::testInvalidJson() {
+  const char *inputs[] = {
+    "",
+    "[]",
+    "{\"universes\": [",
+    "{\"universes\": {}}",
+    "{\"universes\": [1]}",
+    "{\"foo\": 1}",
+    "{\"universes\": [{\"dmx\": [1]}]}",
+    "{\"universes\": [{\"universe\": 1}]}",
+    "{\"universes\": [{\"universe\": 1, \"dmx\": []}]}",
+    "{\"universes\": [{\"universe\": -1, \"dmx\": [1]}]}",
+    "{\"universes\": [{\"universe\": 1, \"dmx\": [256]}]}",
+    "{\"universes\": [{\"universe\": 1, \"dmx\": [1.5]}]}",
+    "{\"universes\": [{\"universe\": 1, \"dmx\": [true]}]}",
+    "{\"universes\": [{\"universe\": 1, \"base64\": \"!!\"}]}",
+    "{\"universes\": [{\"universe\": 1, \"dmx\": [1], \"foo\": 2}]}",
+  };
+
+  for (unsigned int i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+    BulkDmxData data;
+    string error;
+    OLA_ASSERT_FALSE_MSG(ParseBulkDmxJson(inputs[i], &data, &error),
+                         inputs[i]);
+    OLA_ASSERT_FALSE(error.empty());
+  }
+
+  // Too many slots
+  string input = "{\"universes\": [{\"universe\": 4, \"dmx\": [";
+  for (unsigned int i = 0; i <= ola::DMX_UNIVERSE_SIZE; i++) {
+    input.append(i ? ", 7" : "7");
+  }
+  input.append("]}]}");
+  BulkDmxData data;
+  OLA_ASSERT_FALSE(ParseJson(input, &data));
+}
+
+
+/*
+ * Check the binary format.
+ */
+void BulkDmxTest::testBinary() {
+  BulkDmxData data;
+  data[1] = FromString("1,2,3");
+  data[0x01020304] = FromString("255");
+
+  string output;
+  WriteBulkDmxBinary(data, &output);
+  const uint8_t expected[] = {
+    0, 0, 0, 1, 0, 3, 1, 2, 3,
+    1, 2, 3, 4, 0, 1, 255,
+  };
+  OLA_ASSERT_DATA_EQUALS(expected, sizeof(expected),
+                         reinterpret_cast<const uint8_t*>(output.data()),
+                         output.size());
+
+  BulkDmxData parsed;
+  string error;
+  OLA_ASSERT_TRUE(ParseBulkDmxBinary(output, &parsed, &error));
+  OLA_ASSERT_TRUE(data == parsed);
+
+  // Truncated headers & data
+  parsed.clear();
+  OLA_ASSERT_FALSE(ParseBulkDmxBinary(output.substr(0, 4), &parsed, &error));
+  OLA_ASSERT_FALSE(ParseBulkDmxBinary(output.substr(0, 8), &parsed, &error));
+
+  // Zero & oversized lengths
+  const uint8_t empty[] = {0, 0, 0, 1, 0, 0};
+  OLA_ASSERT_FALSE(ParseBulkDmxBinary(
+      string(reinterpret_cast<const char*>(empty), sizeof(empty)),
+      &parsed, &error));
+
+  string large(reinterpret_cast<const char*>(empty), sizeof(empty));
+  large[4] = 2;
+  large[5] = 1;
+  large.append(513, 0);
+  OLA_ASSERT_FALSE(ParseBulkDmxBinary(large, &parsed, &error));
+}
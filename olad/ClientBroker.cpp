@@ -18,7 +18,7 @@
  * Copyright (C) 2010 Simon Newton
  */
 
-#include <set>
+#include <map>
 #include <string>
 #include <vector>
 #include "ola/Logging.h"
@@ -27,12 +27,13 @@
 
 namespace ola {
 
-using std::set;
 using std::string;
 using std::vector;
 
 void ClientBroker::AddClient(const Client *client) {
-  m_clients.insert(client);
+  // Ids aren't reused, so a callback for a client that has gone away won't
+  // run even if a new client is allocated at the same address.
+  m_clients[client] = m_next_client_id++;
 }
 
 void ClientBroker::RemoveClient(const Client *client) {
@@ -43,43 +44,64 @@ void ClientBroker::SendRDMRequest(const Client *client,
                                   Universe *universe,
                                   ola::rdm::RDMRequest *request,
                                   ola::rdm::RDMCallback *callback) {
-  if (!STLContains(m_clients, client)) {
+  client_map::const_iterator iter = m_clients.find(client);
+  unsigned int client_id = 0;
+  if (iter == m_clients.end()) {
     OLA_WARN << "Making an RDM call but the client doesn't exist in the "
              << "broker!";
+  } else {
+    client_id = iter->second;
   }
 
+  ola::rdm::RDMRequest::SchedulingOptions options =
+      request->GetSchedulingOptions();
+  options.client_id = client_id;
+  request->SetSchedulingOptions(options);
+
   universe->SendRDMRequest(
       request,
       NewSingleCallback(this, &ClientBroker::RequestComplete, client,
-                        callback));
+                        client_id, callback));
 }
 
 void ClientBroker::RunRDMDiscovery(const Client *client,
                                    Universe *universe,
                                    bool full_discovery,
                                    ola::rdm::RDMDiscoveryCallback *callback) {
-  if (!STLContains(m_clients, client)) {
+  client_map::const_iterator iter = m_clients.find(client);
+  unsigned int client_id = 0;
+  if (iter == m_clients.end()) {
     OLA_WARN << "Running RDM discovery but the client doesn't exist in the "
              << "broker!";
+  } else {
+    client_id = iter->second;
   }
 
   universe->RunRDMDiscovery(
       NewSingleCallback(this, &ClientBroker::DiscoveryComplete, client,
-                        callback),
+                        client_id, callback),
       full_discovery);
 }
 
+bool ClientBroker::IsActive(const Client *client,
+                            unsigned int client_id) const {
+  client_map::const_iterator iter = m_clients.find(client);
+  return iter != m_clients.end() && iter->second == client_id;
+}
+
 /*
  * Return from an RDM call.
  * @param key the client associated with this request
+ * @param client_id the id the client had when the request was made
  * @param callback the callback to run if the key still exists
  * @param code the code of the RDM request
  * @param response the RDM response
  */
 void ClientBroker::RequestComplete(const Client *client,
+                                   unsigned int client_id,
                                    ola::rdm::RDMCallback *callback,
                                    ola::rdm::RDMReply *reply) {
-  if (!STLContains(m_clients, client)) {
+  if (!IsActive(client, client_id)) {
     OLA_DEBUG << "Client no longer exists, cleaning up from RDM response";
     delete callback;
   } else {
@@ -89,9 +111,10 @@ void ClientBroker::RequestComplete(const Client *client,
 
 void ClientBroker::DiscoveryComplete(
     const Client *client,
+    unsigned int client_id,
     ola::rdm::RDMDiscoveryCallback *callback,
     const ola::rdm::UIDSet &uids) {
-  if (!STLContains(m_clients, client)) {
+  if (!IsActive(client, client_id)) {
     OLA_DEBUG << "Client no longer exists, cleaning up from RDM discovery";
     delete callback;
   } else {
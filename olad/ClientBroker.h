@@ -24,7 +24,7 @@
 #ifndef OLAD_CLIENTBROKER_H_
 #define OLAD_CLIENTBROKER_H_
 
-#include <set>
+#include <map>
 #include <string>
 #include <vector>
 #include "ola/base/Macro.h"
@@ -48,10 +48,13 @@ namespace ola {
  * and proxying RDM calls. When the RDM call returns, if the client responsible
  * for the call has been deleted, we delete the callback rather then executing
  * it.
+ *
+ * Each client is given an id, which is attached to the RDM requests it makes
+ * so the RDM queues can share the port fairly between clients.
  */
 class ClientBroker {
  public:
-  ClientBroker() {}
+  ClientBroker() : m_next_client_id(1) {}
   ~ClientBroker() {}
 
   /**
@@ -93,15 +96,20 @@ class ClientBroker {
                        ola::rdm::RDMDiscoveryCallback *callback);
 
  private:
-  typedef std::set<const Client*> client_set;
+  typedef std::map<const Client*, unsigned int> client_map;
+
+  client_map m_clients;
+  unsigned int m_next_client_id;
 
-  client_set m_clients;
+  bool IsActive(const Client *client, unsigned int client_id) const;
 
   void RequestComplete(const Client *key,
+                       unsigned int client_id,
                        ola::rdm::RDMCallback *callback,
                        ola::rdm::RDMReply *reply);
 
   void DiscoveryComplete(const Client *key,
+                         unsigned int client_id,
                          ola::rdm::RDMDiscoveryCallback *on_complete,
                          const ola::rdm::UIDSet &uids);
 
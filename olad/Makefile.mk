@@ -9,6 +9,8 @@ oladinclude_HEADERS += olad/OlaDaemon.h olad/OlaServer.h
 # LIBRARIES
 ##################################################
 ola_server_sources = \
+    olad/BulkDmx.cpp \
+    olad/BulkDmx.h \
     olad/ClientBroker.cpp \
     olad/ClientBroker.h \
     olad/DiscoveryAgent.cpp \
@@ -22,7 +24,10 @@ ola_server_sources = \
     olad/PluginLoader.h \
     olad/PluginManager.cpp \
     olad/PluginManager.h \
-    olad/RDMHTTPModule.h
+    olad/RDMCache.cpp \
+    olad/RDMCache.h \
+    olad/RDMHTTPModule.h \
+    olad/StreamingHTTPModule.h
 ola_server_additional_libs =
 
 if HAVE_DNSSD
@@ -38,7 +43,8 @@ endif
 if HAVE_LIBMICROHTTPD
 ola_server_sources += olad/HttpServerActions.cpp \
                       olad/OladHTTPServer.cpp \
-                      olad/RDMHTTPModule.cpp
+                      olad/RDMHTTPModule.cpp \
+                      olad/StreamingHTTPModule.cpp
 ola_server_additional_libs += common/http/libolahttp.la
 endif
 
@@ -87,8 +93,13 @@ COMMON_OLAD_TEST_LDADD = $(COMMON_TESTING_LIBS) $(libprotobuf_LIBS) \
                          common/libolacommon.la
 
 olad_OlaTester_SOURCES = \
+    olad/BulkDmxTest.cpp \
     olad/PluginManagerTest.cpp \
-    olad/OlaServerServiceImplTest.cpp
+    olad/OlaServerServiceImplTest.cpp \
+    olad/RDMCacheTest.cpp
+if HAVE_LIBMICROHTTPD
+olad_OlaTester_SOURCES += olad/StreamingHTTPModuleTest.cpp
+endif
 olad_OlaTester_CXXFLAGS = $(COMMON_TESTING_PROTOBUF_FLAGS)
 olad_OlaTester_LDADD = $(COMMON_OLAD_TEST_LDADD)
 
@@ -53,6 +53,7 @@
 #include "olad/Port.h"
 #include "olad/PortBroker.h"
 #include "olad/Preferences.h"
+#include "olad/RDMCache.h"
 #include "olad/Universe.h"
 #include "olad/plugin_api/Client.h"
 #include "olad/plugin_api/DeviceManager.h"
@@ -67,6 +68,8 @@ DEFINE_s_uint16(rpc_port, r, ola::OlaServer::DEFAULT_RPC_PORT,
                 "The port to listen for RPCs on. Defaults to 9010.");
 DEFINE_default_bool(register_with_dns_sd, true,
                     "Don't register the web service using DNS-SD (Bonjour).");
+DEFINE_default_bool(rdm_cache, true,
+                    "Don't cache RDM parameters that rarely change.");
 
 namespace ola {
 
@@ -84,6 +87,7 @@ const char OlaServer::K_INSTANCE_NAME_VAR[] = "server-instance-name";
 const char OlaServer::K_UID_VAR[] = "server-uid";
 const char OlaServer::SERVER_PREFERENCES[] = "server";
 const char OlaServer::UNIVERSE_PREFERENCES[] = "universe";
+const char OlaServer::RDM_CACHE_PREFERENCES[] = "rdm-cache";
 // The Bonjour API expects <service>[,<sub-type>] so we use that form here.
 const char OlaServer::K_DISCOVERY_SERVICE_TYPE[] = "_http._tcp,_ola";
 const unsigned int OlaServer::K_HOUSEKEEPING_TIMEOUT_MS = 10000;
@@ -103,6 +107,7 @@ OlaServer::OlaServer(const vector<PluginLoader*> &plugin_loaders,
       m_default_uid(OPEN_LIGHTING_ESTA_CODE, 0),
       m_server_preferences(NULL),
       m_universe_preferences(NULL),
+      m_rdm_cache_preferences(NULL),
       m_housekeeping_timeout(ola::thread::INVALID_TIMEOUT) {
   if (!m_export_map) {
     m_our_export_map.reset(new ExportMap());
@@ -146,11 +151,18 @@ OlaServer::~OlaServer() {
     m_universe_preferences->Save();
   }
 
+  // The RDM cache is updated by the requests that fail as the plugins stop.
+  if (m_rdm_cache.get() && m_rdm_cache_preferences) {
+    m_rdm_cache->Save(m_rdm_cache_preferences);
+    m_rdm_cache_preferences->Save();
+  }
+
   m_port_manager.reset();
   m_plugin_adaptor.reset();
   m_device_manager.reset();
   m_plugin_manager.reset();
   m_service_impl.reset();
+  m_rdm_cache.reset();
 }
 
 bool OlaServer::Init() {
@@ -230,6 +242,19 @@ bool OlaServer::Init() {
   auto_ptr<PluginManager> plugin_manager(
     new PluginManager(m_plugin_loaders, plugin_adaptor.get()));
 
+  auto_ptr<RDMCache> rdm_cache;
+  if (FLAGS_rdm_cache) {
+    m_rdm_cache_preferences = m_preferences_factory->NewPreference(
+        RDM_CACHE_PREFERENCES);
+    m_rdm_cache_preferences->Load();
+    rdm_cache.reset(new RDMCache(RDMCache::Options(), m_export_map));
+    rdm_cache->Load(*m_rdm_cache_preferences);
+    // Responders which are no longer found may have been replaced, so drop
+    // their cached data.
+    universe_store->SetUIDRemovedCallback(
+        NewCallback(rdm_cache.get(), &RDMCache::InvalidateUID));
+  }
+
   auto_ptr<OlaServerServiceImpl> service_impl(new OlaServerServiceImpl(
       universe_store.get(),
       device_manager.get(),
@@ -237,7 +262,8 @@ bool OlaServer::Init() {
       port_manager.get(),
       broker.get(),
       m_ss->WakeUpTime(),
-      NewCallback(this, &OlaServer::ReloadPluginsInternal)));
+      NewCallback(this, &OlaServer::ReloadPluginsInternal),
+      rdm_cache.get()));
 
   // Initialize the RPC server.
   RpcServer::Options rpc_options;
@@ -302,6 +328,7 @@ bool OlaServer::Init() {
   m_plugin_manager.reset(plugin_manager.release());
   m_port_broker.reset(port_broker.release());
   m_port_manager.reset(port_manager.release());
+  m_rdm_cache.reset(rdm_cache.release());
   m_rpc_server.reset(rpc_server.release());
   m_service_impl.reset(service_impl.release());
   m_universe_store.reset(universe_store.release());
@@ -384,6 +411,9 @@ void OlaServer::ClientRemoved(RpcSession *session) {
 bool OlaServer::RunHousekeeping() {
   OLA_DEBUG << "Garbage collecting";
   m_universe_store->GarbageCollectUniverses();
+  if (m_rdm_cache.get()) {
+    m_rdm_cache->PurgeExpired();
+  }
 
   // Give the universes an opportunity to run discovery
   vector<Universe*> universes;
@@ -424,6 +454,7 @@ bool OlaServer::StartHttpServer(ola::rpc::RpcServer *server,
   options.data_dir = (m_options.http_data_dir.empty() ? HTTP_DATA_DIR :
                       m_options.http_data_dir);
   options.enable_quit = m_options.http_enable_quit;
+  options.thread_pool_size = m_options.http_threads;
 
   auto_ptr<OladHTTPServer> httpd(
       new OladHTTPServer(m_export_map, options,
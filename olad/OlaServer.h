@@ -68,6 +68,8 @@ class OlaServer : public ola::rpc::RpcSessionHandlerInterface {
     bool http_localhost_only;  /** @brief Restrict access to localhost only */
     bool http_enable_quit;  /** @brief Enable /quit URL */
     unsigned int http_port;  /** @brief Port to run the HTTP server on */
+    /** @brief Threads for libmicrohttpd, 0 runs it on the HTTP server thread */
+    unsigned int http_threads;
     /** @brief Directory that contains the static content */
     std::string http_data_dir;
     std::string network_interface;
@@ -188,6 +190,7 @@ class OlaServer : public ola::rpc::RpcSessionHandlerInterface {
   std::auto_ptr<class UniverseStore> m_universe_store;
   std::auto_ptr<class PortManager> m_port_manager;
   std::auto_ptr<class OlaServerServiceImpl> m_service_impl;
+  std::auto_ptr<class RDMCache> m_rdm_cache;
   std::auto_ptr<class ClientBroker> m_broker;
   std::auto_ptr<class PortBroker> m_port_broker;
   std::auto_ptr<const ola::rdm::RootPidStore> m_pid_store;
@@ -195,6 +198,7 @@ class OlaServer : public ola::rpc::RpcSessionHandlerInterface {
   std::auto_ptr<ola::rpc::RpcServer> m_rpc_server;
   class Preferences *m_server_preferences;
   class Preferences *m_universe_preferences;
+  class Preferences *m_rdm_cache_preferences;
   std::string m_instance_name;
 
   ola::thread::timeout_id m_housekeeping_timeout;
@@ -224,6 +228,7 @@ class OlaServer : public ola::rpc::RpcSessionHandlerInterface {
   static const char K_UID_VAR[];
   static const char SERVER_PREFERENCES[];
   static const char UNIVERSE_PREFERENCES[];
+  static const char RDM_CACHE_PREFERENCES[];
   static const unsigned int K_HOUSEKEEPING_TIMEOUT_MS;
 
   DISALLOW_COPY_AND_ASSIGN(OlaServer);
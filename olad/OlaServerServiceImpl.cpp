@@ -20,7 +20,10 @@
  */
 
 #include <algorithm>
+#include <map>
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 #include "common/protocol/Ola.pb.h"
 #include "common/rpc/RpcSession.h"
@@ -28,6 +31,7 @@
 #include "ola/CallbackRunner.h"
 #include "ola/DmxBuffer.h"
 #include "ola/Logging.h"
+#include "ola/StringUtils.h"
 #include "ola/rdm/RDMCommand.h"
 #include "ola/rdm/UIDSet.h"
 #include "ola/strings/Format.h"
@@ -35,6 +39,7 @@
 #include "ola/timecode/TimeCodeEnums.h"
 #include "olad/ClientBroker.h"
 #include "olad/Device.h"
+#include "olad/DmxFrameStats.h"
 #include "olad/DmxSource.h"
 #include "olad/OlaServerServiceImpl.h"
 #include "olad/Plugin.h"
@@ -56,6 +61,7 @@ using ola::proto::DeviceInfo;
 using ola::proto::DeviceInfoReply;
 using ola::proto::DeviceInfoRequest;
 using ola::proto::DmxData;
+using ola::proto::DmxDataBulk;
 using ola::proto::MergeModeRequest;
 using ola::proto::OptionalUniverseRequest;
 using ola::proto::PatchPortRequest;
@@ -69,7 +75,9 @@ using ola::proto::RegisterDmxRequest;
 using ola::proto::UniverseInfo;
 using ola::proto::UniverseInfoReply;
 using ola::proto::UniverseNameRequest;
+using ola::proto::UniverseListRequest;
 using ola::proto::UniverseRequest;
+using ola::proto::UniverseStatsReply;
 using ola::rdm::RDMRequest;
 using ola::rdm::RDMResponse;
 using ola::rdm::UID;
@@ -106,6 +114,85 @@ RDMRequest::OverrideOptions RDMRequestOptionsFromProto(
   }
   return options;
 }
+
+/*
+ * Return the priority of some DMX data, clamped to the valid range.
+ */
+uint8_t SourcePriority(const DmxData &data) {
+  uint8_t priority = ola::dmx::SOURCE_PRIORITY_DEFAULT;
+  if (data.has_priority()) {
+    priority = data.priority();
+    priority = std::max(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MIN),
+                        priority);
+    priority = std::min(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MAX),
+                        priority);
+  }
+  return priority;
+}
+
+/*
+ * Copy a DmxFrameStats into the protobuf.
+ */
+void FrameStatsToProto(const DmxFrameStats &stats, const TimeStamp &now,
+                       bool is_output, ola::proto::FrameStats *output) {
+  output->set_frames(stats.Frames());
+  output->set_fps(stats.FramesPerSecond(now));
+  output->set_jitter_us(static_cast<uint32_t>(stats.Jitter().AsInt()));
+  if (is_output) {
+    output->set_mean_latency_us(
+        static_cast<uint32_t>(stats.MeanLatency(now).AsInt()));
+    output->set_max_latency_us(
+        static_cast<uint32_t>(stats.MaxLatency(now).AsInt()));
+  }
+}
+
+template<class PortClass>
+void AddPortStats(const Universe &universe, const TimeStamp &now,
+                  bool is_output, const vector<PortClass*> &ports,
+                  ola::proto::UniverseStats *output) {
+  typename vector<PortClass*>::const_iterator iter = ports.begin();
+  for (; iter != ports.end(); ++iter) {
+    const DmxFrameStats *stats = universe.PortStats(*iter);
+    if (!stats) {
+      continue;
+    }
+    ola::proto::PortStats *port_stats = output->add_port();
+    port_stats->set_port_id((*iter)->UniqueId());
+    port_stats->set_is_output(is_output);
+    FrameStatsToProto(*stats, now, is_output, port_stats->mutable_stats());
+  }
+}
+
+/*
+ * Order the requests in a RDMBulkCommand so that the requests to each
+ * responder are spread out, rather than bunched together. Requests to the
+ * same responder stay in order. This means a responder with many requests
+ * doesn't hold up the rest of the port queue, and transports that can have a
+ * request outstanding to each responder (like Art-Net) can pipeline them.
+ */
+void InterleaveByResponder(const ola::proto::RDMBulkRequest &request,
+                           vector<int> *order) {
+  typedef std::pair<int, UID> Responder;
+  std::map<Responder, unsigned int> counts;
+  // (the number of earlier requests to the same responder, index)
+  vector<std::pair<unsigned int, int> > ranked;
+  ranked.reserve(request.request_size());
+
+  for (int i = 0; i < request.request_size(); i++) {
+    const ola::proto::RDMRequest &rdm_request = request.request(i);
+    Responder responder(rdm_request.universe(),
+                        UID(rdm_request.uid().esta_id(),
+                            rdm_request.uid().device_id()));
+    ranked.push_back(std::make_pair(counts[responder]++, i));
+  }
+  std::sort(ranked.begin(), ranked.end());
+
+  order->reserve(ranked.size());
+  vector<std::pair<unsigned int, int> >::const_iterator iter = ranked.begin();
+  for (; iter != ranked.end(); ++iter) {
+    order->push_back(iter->second);
+  }
+}
 }  // namespace
 
 typedef CallbackRunner<ola::rpc::RpcService::CompletionCallback> ClosureRunner;
@@ -117,14 +204,16 @@ OlaServerServiceImpl::OlaServerServiceImpl(
     PortManager *port_manager,
     ClientBroker *broker,
     const TimeStamp *wake_up_time,
-    ReloadPluginsCallback *reload_plugins_callback)
+    ReloadPluginsCallback *reload_plugins_callback,
+    RDMCache *rdm_cache)
     : m_universe_store(universe_store),
       m_device_manager(device_manager),
       m_plugin_manager(plugin_manager),
       m_port_manager(port_manager),
       m_broker(broker),
       m_wake_up_time(wake_up_time),
-      m_reload_plugins_callback(reload_plugins_callback) {
+      m_reload_plugins_callback(reload_plugins_callback),
+      m_rdm_cache(rdm_cache) {
 }
 
 void OlaServerServiceImpl::GetDmx(
@@ -143,6 +232,73 @@ void OlaServerServiceImpl::GetDmx(
   response->set_universe(request->universe());
 }
 
+void OlaServerServiceImpl::GetDmxBulk(
+    RpcController* controller,
+    const UniverseListRequest* request,
+    DmxDataBulk* response,
+    ola::rpc::RpcService::CompletionCallback* done) {
+  ClosureRunner runner(done);
+  if (request->universe_size() > MAX_BULK_DMX_UNIVERSES) {
+    controller->SetFailed("Too many universes, the limit is " +
+                          IntToString(MAX_BULK_DMX_UNIVERSES));
+    return;
+  }
+
+  for (int i = 0; i < request->universe_size(); i++) {
+    Universe *universe = m_universe_store->GetUniverse(request->universe(i));
+    if (!universe) {
+      continue;
+    }
+    DmxData *data = response->add_data();
+    data->set_universe(request->universe(i));
+    data->set_data(universe->GetDMX().Get());
+  }
+}
+
+void OlaServerServiceImpl::GetUniverseStats(
+    RpcController* controller,
+    const UniverseListRequest* request,
+    UniverseStatsReply* response,
+    ola::rpc::RpcService::CompletionCallback* done) {
+  ClosureRunner runner(done);
+  if (request->universe_size() > MAX_BULK_DMX_UNIVERSES) {
+    controller->SetFailed("Too many universes, the limit is " +
+                          IntToString(MAX_BULK_DMX_UNIVERSES));
+    return;
+  }
+
+  vector<Universe*> universes;
+  if (request->universe_size()) {
+    for (int i = 0; i < request->universe_size(); i++) {
+      Universe *universe = m_universe_store->GetUniverse(request->universe(i));
+      if (universe) {
+        universes.push_back(universe);
+      }
+    }
+  } else {
+    m_universe_store->GetList(&universes);
+  }
+
+  const TimeStamp &now = *m_wake_up_time;
+  vector<Universe*>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    const Universe *universe = *iter;
+    ola::proto::UniverseStats *stats = response->add_universe();
+    stats->set_universe(universe->UniverseId());
+    FrameStatsToProto(universe->InputStats(), now, false,
+                      stats->mutable_input());
+    FrameStatsToProto(universe->OutputStats(), now, true,
+                      stats->mutable_output());
+
+    vector<InputPort*> input_ports;
+    universe->InputPorts(&input_ports);
+    AddPortStats(*universe, now, false, input_ports, stats);
+    vector<OutputPort*> output_ports;
+    universe->OutputPorts(&output_ports);
+    AddPortStats(*universe, now, true, output_ports, stats);
+  }
+}
+
 void OlaServerServiceImpl::RegisterForDmx(
     RpcController* controller,
     const RegisterDmxRequest* request,
@@ -178,19 +334,55 @@ void OlaServerServiceImpl::UpdateDmxData(
   DmxBuffer buffer;
   buffer.Set(request->data());
 
-  uint8_t priority = ola::dmx::SOURCE_PRIORITY_DEFAULT;
-  if (request->has_priority()) {
-    priority = request->priority();
-    priority = std::max(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MIN),
-                        priority);
-    priority = std::min(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MAX),
-                        priority);
-  }
-  DmxSource source(buffer, *m_wake_up_time, priority);
+  DmxSource source(buffer, *m_wake_up_time, SourcePriority(*request));
   client->DMXReceived(request->universe(), source);
   universe->SourceClientDataChanged(client);
 }
 
+void OlaServerServiceImpl::UpdateDmxDataBulk(
+    RpcController* controller,
+    const DmxDataBulk* request,
+    Ack*,
+    ola::rpc::RpcService::CompletionCallback* done) {
+  ClosureRunner runner(done);
+  if (request->data_size() > MAX_BULK_DMX_UNIVERSES) {
+    controller->SetFailed("Too many universes, the limit is " +
+                          IntToString(MAX_BULK_DMX_UNIVERSES));
+    return;
+  }
+
+  // Check all the universes exist before changing any of them.
+  vector<Universe*> universes;
+  universes.reserve(request->data_size());
+  for (int i = 0; i < request->data_size(); i++) {
+    Universe *universe = m_universe_store->GetUniverse(
+        request->data(i).universe());
+    if (!universe) {
+      return MissingUniverseError(controller);
+    }
+    universes.push_back(universe);
+  }
+
+  Client *client = GetClient(controller);
+  for (int i = 0; i < request->data_size(); i++) {
+    const DmxData &data = request->data(i);
+    DmxBuffer buffer;
+    buffer.Set(data.data());
+    DmxSource source(buffer, *m_wake_up_time, SourcePriority(data));
+    client->DMXReceived(data.universe(), source);
+  }
+
+  // Then merge & send each universe once, if it appeared more than once the
+  // last data wins.
+  std::set<Universe*> updated;
+  vector<Universe*>::iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    if (updated.insert(*iter).second) {
+      (*iter)->SourceClientDataChanged(client);
+    }
+  }
+}
+
 void OlaServerServiceImpl::StreamDmxData(
     RpcController *controller,
     const ola::proto::DmxData* request,
@@ -206,15 +398,7 @@ void OlaServerServiceImpl::StreamDmxData(
   DmxBuffer buffer;
   buffer.Set(request->data());
 
-  uint8_t priority = ola::dmx::SOURCE_PRIORITY_DEFAULT;
-  if (request->has_priority()) {
-    priority = request->priority();
-    priority = std::max(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MIN),
-                        priority);
-    priority = std::min(static_cast<uint8_t>(ola::dmx::SOURCE_PRIORITY_MAX),
-                        priority);
-  }
-  DmxSource source(buffer, *m_wake_up_time, priority);
+  DmxSource source(buffer, *m_wake_up_time, SourcePriority(*request));
   client->DMXReceived(request->universe(), source);
   universe->SourceClientDataChanged(client);
 }
@@ -720,48 +904,53 @@ void OlaServerServiceImpl::RDMCommand(
     return;
   }
 
-  Client *client = GetClient(controller);
-  UID source_uid = client->GetUID();
-
-  UID destination(request->uid().esta_id(),
-                  request->uid().device_id());
+  SendRDMCommand(GetClient(controller), universe, *request, response, done);
+}
 
-  RDMRequest::OverrideOptions options = RDMRequestOptionsFromProto(*request);
+void OlaServerServiceImpl::RDMBulkCommand(
+    RpcController* controller,
+    const ola::proto::RDMBulkRequest* request,
+    ola::proto::RDMBulkResponse* response,
+    ola::rpc::RpcService::CompletionCallback* done) {
+  if (request->request_size() > MAX_BULK_RDM_REQUESTS) {
+    controller->SetFailed("Too many RDM requests, the limit is " +
+                          IntToString(MAX_BULK_RDM_REQUESTS));
+    done->Run();
+    return;
+  }
 
-  ola::rdm::RDMRequest *rdm_request = NULL;
-  if (request->is_set()) {
-    rdm_request = new ola::rdm::RDMSetRequest(
-        source_uid,
-        destination,
-        universe->GetRDMTransactionNumber(),
-        1,  // port id
-        request->sub_device(),
-        request->param_id(),
-        reinterpret_cast<const uint8_t*>(request->data().data()),
-        request->data().size(),
-        options);
-  } else {
-    rdm_request = new ola::rdm::RDMGetRequest(
-        source_uid,
-        destination,
-        universe->GetRDMTransactionNumber(),
-        1,  // port id
-        request->sub_device(),
-        request->param_id(),
-        reinterpret_cast<const uint8_t*>(request->data().data()),
-        request->data().size(),
-        options);
+  vector<Universe*> universes;
+  universes.reserve(request->request_size());
+  for (int i = 0; i < request->request_size(); i++) {
+    Universe *universe = m_universe_store->GetUniverse(
+        request->request(i).universe());
+    if (!universe) {
+      MissingUniverseError(controller);
+      done->Run();
+      return;
+    }
+    universes.push_back(universe);
+    response->add_response();
   }
 
-  ola::rdm::RDMCallback *callback =
-    NewSingleCallback(
-        this,
-        &OlaServerServiceImpl::HandleRDMResponse,
-        response,
-        done,
-        request->include_raw_response());
+  // The extra request stops the RPC completing while we're still sending, if
+  // some of the requests complete straight away.
+  bulk_rdm_tracker *tracker = new bulk_rdm_tracker;
+  tracker->outstanding = request->request_size() + 1;
+  tracker->done = done;
 
-  m_broker->SendRDMRequest(client, universe, rdm_request, callback);
+  Client *client = GetClient(controller);
+  vector<int> order;
+  InterleaveByResponder(*request, &order);
+  for (vector<int>::const_iterator iter = order.begin(); iter != order.end();
+       ++iter) {
+    SendRDMCommand(
+        client, universes[*iter], request->request(*iter),
+        response->mutable_response(*iter),
+        NewSingleCallback(this, &OlaServerServiceImpl::BulkRDMRequestComplete,
+                          tracker));
+  }
+  BulkRDMRequestComplete(tracker);
 }
 
 void OlaServerServiceImpl::RDMDiscoveryCommand(
@@ -840,6 +1029,100 @@ void OlaServerServiceImpl::SendTimeCode(
 
 // Private methods
 //-----------------------------------------------------------------------------
+/*
+ * Build and send a RDM request.
+ */
+void OlaServerServiceImpl::SendRDMCommand(
+    Client *client,
+    Universe *universe,
+    const ola::proto::RDMRequest &request,
+    ola::proto::RDMResponse *response,
+    ola::rpc::RpcService::CompletionCallback *done) {
+  UID source_uid = client->GetUID();
+
+  UID destination(request.uid().esta_id(),
+                  request.uid().device_id());
+
+  RDMRequest::OverrideOptions options = RDMRequestOptionsFromProto(request);
+
+  ola::rdm::RDMRequest *rdm_request = NULL;
+  if (request.is_set()) {
+    rdm_request = new ola::rdm::RDMSetRequest(
+        source_uid,
+        destination,
+        universe->GetRDMTransactionNumber(),
+        1,  // port id
+        request.sub_device(),
+        request.param_id(),
+        reinterpret_cast<const uint8_t*>(request.data().data()),
+        request.data().size(),
+        options);
+  } else {
+    rdm_request = new ola::rdm::RDMGetRequest(
+        source_uid,
+        destination,
+        universe->GetRDMTransactionNumber(),
+        1,  // port id
+        request.sub_device(),
+        request.param_id(),
+        reinterpret_cast<const uint8_t*>(request.data().data()),
+        request.data().size(),
+        options);
+  }
+
+  RDMRequest::SchedulingOptions scheduling_options;
+  scheduling_options.bulk = request.bulk();
+  rdm_request->SetSchedulingOptions(scheduling_options);
+
+  if (!m_rdm_cache) {
+    ola::rdm::RDMCallback *callback =
+      NewSingleCallback(
+          this,
+          &OlaServerServiceImpl::HandleRDMResponse,
+          response,
+          done,
+          request.include_raw_response());
+    m_broker->SendRDMRequest(client, universe, rdm_request, callback);
+    return;
+  }
+
+  RDMCache::RequestInfo request_info(request.universe(), *rdm_request);
+  string data;
+  if (request.cache_first() && m_rdm_cache->Get(request_info, &data)) {
+    ola::rdm::RDMReply reply(
+        ola::rdm::RDM_COMPLETED_OK,
+        ola::rdm::GetResponseFromData(
+            rdm_request,
+            reinterpret_cast<const uint8_t*>(data.data()),
+            data.size()));
+    delete rdm_request;
+    HandleRDMResponse(response, done, false, &reply);
+    return;
+  }
+
+  ola::rdm::RDMCallback *callback =
+    NewSingleCallback(
+        this,
+        &OlaServerServiceImpl::HandleCachedRDMResponse,
+        response,
+        done,
+        request.include_raw_response(),
+        request_info);
+  m_broker->SendRDMRequest(client, universe, rdm_request, callback);
+}
+
+
+/*
+ * Called as each request in a RDMBulkCommand completes.
+ */
+void OlaServerServiceImpl::BulkRDMRequestComplete(bulk_rdm_tracker *tracker) {
+  if (--tracker->outstanding == 0) {
+    tracker->done->Run();
+    delete tracker;
+  }
+}
+
+
 /*
  * Handle an RDM Response, this includes broadcast messages, messages that
  * timed out and normal response messages.
@@ -918,6 +1201,20 @@ void OlaServerServiceImpl::HandleRDMResponse(
 }
 
 
+/**
+ * Update the RDM cache before returning the response to the client.
+ */
+void OlaServerServiceImpl::HandleCachedRDMResponse(
+    ola::proto::RDMResponse* response,
+    ola::rpc::RpcService::CompletionCallback* done,
+    bool include_raw_packets,
+    RDMCache::RequestInfo request_info,
+    ola::rdm::RDMReply *reply) {
+  m_rdm_cache->Update(request_info, *reply);
+  HandleRDMResponse(response, done, include_raw_packets, reply);
+}
+
+
 /**
  * Called when RDM discovery completes
  */
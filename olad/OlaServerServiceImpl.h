@@ -28,6 +28,7 @@
 #include "ola/rdm/RDMControllerInterface.h"
 #include "ola/rdm/UID.h"
 #include "ola/rdm/UIDSet.h"
+#include "olad/RDMCache.h"
 
 #ifndef OLAD_OLASERVERSERVICEIMPL_H_
 #define OLAD_OLASERVERSERVICEIMPL_H_
@@ -63,7 +64,8 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
                        class PortManager *port_manager,
                        class ClientBroker *broker,
                        const class TimeStamp *wake_up_time,
-                       ReloadPluginsCallback *reload_plugins_callback);
+                       ReloadPluginsCallback *reload_plugins_callback,
+                       RDMCache *rdm_cache = NULL);
 
   ~OlaServerServiceImpl() {}
 
@@ -75,6 +77,27 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
               ola::proto::DmxData* response,
               ola::rpc::RpcService::CompletionCallback* done);
 
+  /**
+   * @brief Returns the current DMX values for a list of universes.
+   *
+   * Universes that don't exist are left out of the response.
+   */
+  void GetDmxBulk(ola::rpc::RpcController* controller,
+                  const ola::proto::UniverseListRequest* request,
+                  ola::proto::DmxDataBulk* response,
+                  ola::rpc::RpcService::CompletionCallback* done);
+
+  /**
+   * @brief Returns the frame rate, latency & jitter for a list of universes.
+   *
+   * An empty list returns all universes. Universes that don't exist are left
+   * out of the response.
+   */
+  void GetUniverseStats(ola::rpc::RpcController* controller,
+                        const ola::proto::UniverseListRequest* request,
+                        ola::proto::UniverseStatsReply* response,
+                        ola::rpc::RpcService::CompletionCallback* done);
+
 
   /**
    * @brief Register a client to receive DMX data.
@@ -91,6 +114,17 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
                      const ola::proto::DmxData* request,
                      ola::proto::Ack* response,
                      ola::rpc::RpcService::CompletionCallback* done);
+
+  /**
+   * @brief Update the DMX values for several universes at once.
+   *
+   * If any of the universes don't exist, none of them are updated.
+   */
+  void UpdateDmxDataBulk(ola::rpc::RpcController* controller,
+                         const ola::proto::DmxDataBulk* request,
+                         ola::proto::Ack* response,
+                         ola::rpc::RpcService::CompletionCallback* done);
+
   /**
    * @brief Handle a streaming DMX update, no response is sent.
    */
@@ -232,6 +266,17 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
                   ola::rpc::RpcService::CompletionCallback* done);
 
 
+  /**
+   * @brief Handle a batch of RDM Commands.
+   *
+   * The requests are all sent at once and the RPC completes when the last
+   * response arrives. Requests to the same responder are sent in order.
+   */
+  void RDMBulkCommand(ola::rpc::RpcController* controller,
+                      const ::ola::proto::RDMBulkRequest* request,
+                      ola::proto::RDMBulkResponse* response,
+                      ola::rpc::RpcService::CompletionCallback* done);
+
   /**
    * @brief Handle an RDM Discovery Command.
    *
@@ -259,11 +304,39 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
                     ::ola::proto::Ack* response,
                     ola::rpc::RpcService::CompletionCallback* done);
 
+  /**
+   * @brief The maximum number of requests in a RDMBulkCommand. This keeps the
+   * response within the RPC message size limit.
+   */
+  static const int MAX_BULK_RDM_REQUESTS = 1000;
+
+  /**
+   * @brief The maximum number of universes in a UpdateDmxDataBulk,
+   * GetDmxBulk or GetUniverseStats call.
+   */
+  static const int MAX_BULK_DMX_UNIVERSES = 1000;
+
  private:
+  typedef struct {
+    unsigned int outstanding;
+    ola::rpc::RpcService::CompletionCallback *done;
+  } bulk_rdm_tracker;
+
+  void SendRDMCommand(class Client *client,
+                      Universe *universe,
+                      const ola::proto::RDMRequest &request,
+                      ola::proto::RDMResponse *response,
+                      ola::rpc::RpcService::CompletionCallback *done);
+  void BulkRDMRequestComplete(bulk_rdm_tracker *tracker);
   void HandleRDMResponse(ola::proto::RDMResponse* response,
                          ola::rpc::RpcService::CompletionCallback* done,
                          bool include_raw_packets,
                          ola::rdm::RDMReply *reply);
+  void HandleCachedRDMResponse(ola::proto::RDMResponse* response,
+                               ola::rpc::RpcService::CompletionCallback* done,
+                               bool include_raw_packets,
+                               RDMCache::RequestInfo request_info,
+                               ola::rdm::RDMReply *reply);
   void RDMDiscoveryComplete(unsigned int universe,
                             ola::rpc::RpcService::CompletionCallback* done,
                             ola::proto::UIDListReply *response,
@@ -297,6 +370,7 @@ class OlaServerServiceImpl : public ola::proto::OlaServerService {
   class ClientBroker *m_broker;
   const class TimeStamp *m_wake_up_time;
   std::auto_ptr<ReloadPluginsCallback> m_reload_plugins_callback;
+  RDMCache *m_rdm_cache;
 };
 }  // namespace ola
 #endif  // OLAD_OLASERVERSERVICEIMPL_H_
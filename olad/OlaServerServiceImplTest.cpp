@@ -24,6 +24,7 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <string>
+#include <vector>
 
 #include "common/rpc/RpcController.h"
 #include "common/rpc/RpcSession.h"
@@ -33,13 +34,20 @@
 #include "ola/DmxBuffer.h"
 #include "ola/ExportMap.h"
 #include "ola/Logging.h"
+#include "ola/rdm/RDMCommand.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/rdm/RDMReply.h"
 #include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+#include "ola/stl/STLUtils.h"
 #include "ola/testing/TestUtils.h"
+#include "olad/ClientBroker.h"
 #include "olad/OlaServerServiceImpl.h"
 #include "olad/PluginLoader.h"
 #include "olad/Universe.h"
 #include "olad/plugin_api/Client.h"
 #include "olad/plugin_api/DeviceManager.h"
+#include "olad/plugin_api/TestCommon.h"
 #include "olad/plugin_api/UniverseStore.h"
 
 using ola::Client;
@@ -50,21 +58,31 @@ using ola::OlaServerServiceImpl;
 using ola::Universe;
 using ola::UniverseStore;
 using ola::rpc::RpcController;
+using ola::rdm::RDMCallback;
+using ola::rdm::RDMReply;
+using ola::rdm::RDMRequest;
+using ola::rdm::UID;
+using ola::rdm::UIDSet;
 using ola::rpc::RpcSession;
 using std::string;
+using std::vector;
 
 class OlaServerServiceImplTest: public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(OlaServerServiceImplTest);
   CPPUNIT_TEST(testGetDmx);
   CPPUNIT_TEST(testRegisterForDmx);
   CPPUNIT_TEST(testUpdateDmxData);
+  CPPUNIT_TEST(testBulkDmx);
   CPPUNIT_TEST(testSetUniverseName);
   CPPUNIT_TEST(testSetMergeMode);
+  CPPUNIT_TEST(testRDMBulkCommand);
   CPPUNIT_TEST_SUITE_END();
 
  public:
     OlaServerServiceImplTest():
-      m_uid(ola::OPEN_LIGHTING_ESTA_CODE, 0) {
+      m_uid(ola::OPEN_LIGHTING_ESTA_CODE, 0),
+      m_bulk_rdm_completions(0),
+      m_bulk_dmx_completions(0) {
     }
 
     void setUp() {
@@ -74,12 +92,19 @@ class OlaServerServiceImplTest: public CppUnit::TestFixture {
     void testGetDmx();
     void testRegisterForDmx();
     void testUpdateDmxData();
+    void testBulkDmx();
     void testSetUniverseName();
     void testSetMergeMode();
+    void testRDMBulkCommand();
+
+    void RDMBulkCommandComplete() { m_bulk_rdm_completions++; }
+    void BulkDmxComplete() { m_bulk_dmx_completions++; }
 
  private:
     ola::rdm::UID m_uid;
     ola::Clock m_clock;
+    unsigned int m_bulk_rdm_completions;
+    unsigned int m_bulk_dmx_completions;
 
     void CallGetDmx(OlaServerServiceImpl *service,
                     int universe_id,
@@ -101,6 +126,11 @@ class OlaServerServiceImplTest: public CppUnit::TestFixture {
                           int universe_id,
                           ola::proto::MergeMode merge_mode,
                           class SetMergeModeCheck *check);
+    void CallRDMBulkCommand(OlaServerServiceImpl *service,
+                            Client *client,
+                            const ola::proto::RDMBulkRequest &request,
+                            RpcController *controller,
+                            ola::proto::RDMBulkResponse *response);
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(OlaServerServiceImplTest);
@@ -422,6 +452,121 @@ void OlaServerServiceImplTest::CallUpdateDmxData(
   service->UpdateDmxData(&controller, &request, &response, closure);
 }
 
+/*
+ * Check the UpdateDmxDataBulk & GetDmxBulk methods work
+ */
+void OlaServerServiceImplTest::testBulkDmx() {
+  UniverseStore store(NULL, NULL);
+  ola::TimeStamp time1;
+  m_clock.CurrentTime(&time1);
+  ola::Client client(NULL, m_uid);
+  OlaServerServiceImpl service(&store, NULL, NULL, NULL, NULL,
+                               &time1, NULL);
+  RpcSession session(NULL);
+  session.SetData(&client);
+
+  Universe *universe1 = store.GetUniverseOrCreate(1);
+  Universe *universe2 = store.GetUniverseOrCreate(2);
+  DmxBuffer dmx_data1("this is a test");
+  DmxBuffer dmx_data2("different data hmm");
+
+  ola::proto::DmxDataBulk request;
+  ola::proto::DmxData *data = request.add_data();
+  data->set_universe(1);
+  data->set_data(dmx_data1.Get());
+  data = request.add_data();
+  data->set_universe(3);
+  data->set_data(dmx_data2.Get());
+
+  // Universe 3 doesn't exist, so nothing is updated
+  {
+    RpcController controller(&session);
+    ola::proto::Ack response;
+    service.UpdateDmxDataBulk(
+        &controller, &request, &response,
+        NewSingleCallback(this, &OlaServerServiceImplTest::BulkDmxComplete));
+    OLA_ASSERT_EQ(1u, m_bulk_dmx_completions);
+    OLA_ASSERT(controller.Failed());
+    OLA_ASSERT_EQ(string("Universe doesn't exist"), controller.ErrorText());
+    OLA_ASSERT_EQ(0u, universe1->GetDMX().Size());
+  }
+
+  // Now update both universes, the last data for universe 2 wins
+  request.mutable_data(1)->set_universe(2);
+  data = request.add_data();
+  data->set_universe(2);
+  data->set_data(dmx_data1.Get());
+  {
+    RpcController controller(&session);
+    ola::proto::Ack response;
+    service.UpdateDmxDataBulk(
+        &controller, &request, &response,
+        NewSingleCallback(this, &OlaServerServiceImplTest::BulkDmxComplete));
+    OLA_ASSERT_EQ(2u, m_bulk_dmx_completions);
+    OLA_ASSERT_FALSE(controller.Failed());
+    OLA_ASSERT_EQ(dmx_data1, universe1->GetDMX());
+    OLA_ASSERT_EQ(dmx_data1, universe2->GetDMX());
+  }
+
+  // Fetch them back, missing universes are skipped
+  {
+    RpcController controller(&session);
+    ola::proto::UniverseListRequest get_request;
+    get_request.add_universe(2);
+    get_request.add_universe(5);
+    get_request.add_universe(1);
+    ola::proto::DmxDataBulk response;
+    service.GetDmxBulk(
+        &controller, &get_request, &response,
+        NewSingleCallback(this, &OlaServerServiceImplTest::BulkDmxComplete));
+    OLA_ASSERT_EQ(3u, m_bulk_dmx_completions);
+    OLA_ASSERT_FALSE(controller.Failed());
+    OLA_ASSERT_EQ(2, response.data_size());
+    OLA_ASSERT_EQ(2, response.data(0).universe());
+    OLA_ASSERT_EQ(dmx_data1.Get(), response.data(0).data());
+    OLA_ASSERT_EQ(1, response.data(1).universe());
+    OLA_ASSERT_EQ(dmx_data1.Get(), response.data(1).data());
+  }
+
+  // Each universe received & sent a single frame
+  {
+    RpcController controller(&session);
+    ola::proto::UniverseListRequest stats_request;
+    ola::proto::UniverseStatsReply response;
+    service.GetUniverseStats(
+        &controller, &stats_request, &response,
+        NewSingleCallback(this, &OlaServerServiceImplTest::BulkDmxComplete));
+    OLA_ASSERT_EQ(4u, m_bulk_dmx_completions);
+    OLA_ASSERT_FALSE(controller.Failed());
+    OLA_ASSERT_EQ(2, response.universe_size());
+    for (int i = 0; i < response.universe_size(); i++) {
+      const ola::proto::UniverseStats &stats = response.universe(i);
+      OLA_ASSERT_EQ(static_cast<uint64_t>(1), stats.input().frames());
+      OLA_ASSERT_EQ(static_cast<uint64_t>(1), stats.output().frames());
+      OLA_ASSERT_TRUE(stats.output().has_mean_latency_us());
+      OLA_ASSERT_EQ(0, stats.port_size());
+    }
+  }
+
+  // Too many universes
+  {
+    ola::proto::DmxDataBulk large_request;
+    for (int i = 0; i <= OlaServerServiceImpl::MAX_BULK_DMX_UNIVERSES; i++) {
+      data = large_request.add_data();
+      data->set_universe(1);
+      data->set_data(dmx_data2.Get());
+    }
+    RpcController controller(&session);
+    ola::proto::Ack response;
+    service.UpdateDmxDataBulk(
+        &controller, &large_request, &response,
+        NewSingleCallback(this, &OlaServerServiceImplTest::BulkDmxComplete));
+    OLA_ASSERT_EQ(5u, m_bulk_dmx_completions);
+    OLA_ASSERT(controller.Failed());
+    OLA_ASSERT_EQ(dmx_data1, universe1->GetDMX());
+  }
+}
+
 /*
  * Check the SetUniverseName method works
  */
@@ -535,3 +680,174 @@ void OlaServerServiceImplTest::CallSetMergeMode(
   request.set_merge_mode(merge_mode);
   service->SetMergeMode(&controller, &request, &response, closure);
 }
+
+
+/*
+ * Holds on to the RDM requests sent to a port, so they can be answered later.
+ */
+class RDMRequestRecorder {
+ public:
+  ~RDMRequestRecorder() {
+    ola::STLDeleteElements(&m_requests);
+    ola::STLDeleteElements(&m_callbacks);
+  }
+
+  void HandleRequest(const RDMRequest *request, RDMCallback *callback) {
+    m_requests.push_back(request);
+    m_callbacks.push_back(callback);
+  }
+
+  unsigned int Count() const { return m_requests.size(); }
+
+  const RDMRequest *Request(unsigned int i) const { return m_requests[i]; }
+
+  /*
+   * Ack the requests, starting with the last one. The parameter data of each
+   * response is the sub device of the request.
+   */
+  void AckAll() {
+    while (!m_requests.empty()) {
+      const RDMRequest *request = m_requests.back();
+      RDMCallback *callback = m_callbacks.back();
+      m_requests.pop_back();
+      m_callbacks.pop_back();
+
+      uint8_t data = static_cast<uint8_t>(request->SubDevice());
+      RDMReply reply(ola::rdm::RDM_COMPLETED_OK,
+                     ola::rdm::GetResponseFromData(request, &data,
+                                                   sizeof(data)));
+      delete request;
+      callback->Run(&reply);
+    }
+  }
+
+ private:
+  vector<const RDMRequest*> m_requests;
+  vector<RDMCallback*> m_callbacks;
+};
+
+
+void AddRDMRequest(ola::proto::RDMBulkRequest *bulk_request,
+                   int universe_id, const UID &uid, int sub_device) {
+  ola::proto::RDMRequest *request = bulk_request->add_request();
+  request->set_universe(universe_id);
+  request->mutable_uid()->set_esta_id(uid.ManufacturerId());
+  request->mutable_uid()->set_device_id(uid.DeviceId());
+  request->set_sub_device(sub_device);
+  request->set_param_id(ola::rdm::PID_DEVICE_INFO);
+  request->set_data("");
+  request->set_is_set(false);
+}
+
+
+/*
+ * Check the RDMBulkCommand method works
+ */
+void OlaServerServiceImplTest::testRDMBulkCommand() {
+  UniverseStore store(NULL, NULL);
+  ola::ClientBroker broker;
+  ola::Client client(NULL, m_uid);
+  broker.AddClient(&client);
+  OlaServerServiceImpl service(&store, NULL, NULL, NULL, &broker, NULL, NULL);
+
+  const unsigned int universe_id = 1;
+  UID uid1(0x7a70, 1);
+  UID uid2(0x7a70, 2);
+  UID unknown_uid(0x7a70, 3);
+
+  ola::proto::RDMBulkRequest request;
+  AddRDMRequest(&request, universe_id, uid1, 0);
+  AddRDMRequest(&request, universe_id, uid1, 1);
+  AddRDMRequest(&request, universe_id, uid1, 2);
+  AddRDMRequest(&request, universe_id, unknown_uid, 3);
+  AddRDMRequest(&request, universe_id, uid2, 4);
+  AddRDMRequest(&request, universe_id, uid2, 5);
+
+  // The universe doesn't exist yet
+  {
+    RpcSession session(NULL);
+    RpcController controller(&session);
+    ola::proto::RDMBulkResponse response;
+    CallRDMBulkCommand(&service, &client, request, &controller, &response);
+    OLA_ASSERT_EQ(1u, m_bulk_rdm_completions);
+    OLA_ASSERT(controller.Failed());
+    OLA_ASSERT_EQ(string("Universe doesn't exist"), controller.ErrorText());
+  }
+
+  Universe *universe = store.GetUniverseOrCreate(universe_id);
+  UIDSet uids;
+  uids.AddUID(uid1);
+  uids.AddUID(uid2);
+  RDMRequestRecorder recorder;
+  TestMockRDMOutputPort port(
+      NULL, 1, &uids, true,
+      ola::NewCallback(&recorder, &RDMRequestRecorder::HandleRequest));
+  universe->AddPort(&port);
+  port.SetUniverse(universe);
+
+  RpcSession session(NULL);
+  RpcController controller(&session);
+  ola::proto::RDMBulkResponse response;
+  m_bulk_rdm_completions = 0;
+  CallRDMBulkCommand(&service, &client, request, &controller, &response);
+
+  // The request to the unknown UID completed straight away, the rest are
+  // waiting for the port.
+  OLA_ASSERT_EQ(0u, m_bulk_rdm_completions);
+  OLA_ASSERT_EQ(5u, recorder.Count());
+
+  // The requests to each responder are interleaved, and stay in order.
+  const int expected_order[] = {0, 4, 1, 5, 2};
+  for (unsigned int i = 0; i < recorder.Count(); i++) {
+    OLA_ASSERT_EQ(static_cast<uint16_t>(expected_order[i]),
+                  recorder.Request(i)->SubDevice());
+  }
+
+  recorder.AckAll();
+  OLA_ASSERT_EQ(1u, m_bulk_rdm_completions);
+  OLA_ASSERT_FALSE(controller.Failed());
+  OLA_ASSERT_EQ(request.request_size(), response.response_size());
+  for (int i = 0; i < response.response_size(); i++) {
+    const ola::proto::RDMResponse &rdm_response = response.response(i);
+    if (i == 3) {
+      OLA_ASSERT_EQ(ola::proto::RDM_UNKNOWN_UID,
+                    rdm_response.response_code());
+      continue;
+    }
+    OLA_ASSERT_EQ(ola::proto::RDM_COMPLETED_OK, rdm_response.response_code());
+    OLA_ASSERT_EQ(ola::proto::RDM_ACK, rdm_response.response_type());
+    OLA_ASSERT_EQ(string(1, static_cast<char>(i)), rdm_response.data());
+  }
+
+  // Too many requests
+  ola::proto::RDMBulkRequest large_request;
+  for (int i = 0; i <= OlaServerServiceImpl::MAX_BULK_RDM_REQUESTS; i++) {
+    AddRDMRequest(&large_request, universe_id, uid1, 0);
+  }
+  RpcController large_controller(&session);
+  ola::proto::RDMBulkResponse large_response;
+  m_bulk_rdm_completions = 0;
+  CallRDMBulkCommand(&service, &client, large_request, &large_controller,
+                     &large_response);
+  OLA_ASSERT_EQ(1u, m_bulk_rdm_completions);
+  OLA_ASSERT(large_controller.Failed());
+  OLA_ASSERT_EQ(0u, recorder.Count());
+
+  universe->RemovePort(&port);
+}
+
+/*
+ * Call the RDMBulkCommand method
+ */
+void OlaServerServiceImplTest::CallRDMBulkCommand(
+    OlaServerServiceImpl *service,
+    Client *client,
+    const ola::proto::RDMBulkRequest &request,
+    RpcController *controller,
+    ola::proto::RDMBulkResponse *response) {
+  controller->Session()->SetData(client);
+  service->RDMBulkCommand(
+      controller, &request, response,
+      NewSingleCallback(this,
+                        &OlaServerServiceImplTest::RDMBulkCommandComplete));
+}
@@ -36,6 +36,8 @@
 // which needs to be after WinSock2.h, hence this order
 #include "olad/OlaDaemon.h"
 
+#include "common/network/PacketCapture.h"
+
 #include "ola/Logging.h"
 #include "ola/base/Credentials.h"
 #include "ola/base/Flags.h"
@@ -45,6 +47,8 @@
 #include "ola/thread/SignalThread.h"
 
 using ola::OlaDaemon;
+using ola::network::PacketCaptureWriter;
+using ola::network::SetPacketCapture;
 using ola::thread::SignalThread;
 using std::cout;
 using std::endl;
@@ -60,8 +64,15 @@ DEFINE_s_string(interface, i, "",
                 "to use.");
 DEFINE_string(pid_location, "",
               "The directory containing the PID definitions.");
+DEFINE_string(packet_capture, "",
+              "Record the UDP datagrams received by plugins to this file, in "
+              "pcap format.");
 DEFINE_s_uint16(http_port, p, ola::OlaServer::DEFAULT_HTTP_PORT,
                 "The port to run the http server on. Defaults to 9090.");
+DEFINE_uint16(http_threads, 0,
+              "The number of threads the http server uses to accept "
+              "connections and serve static files. 0 handles everything on "
+              "a single thread.");
 
 /**
  * This is called by the SelectServer loop to start up the SignalThread. If the
@@ -106,8 +117,11 @@ int main(int argc, char *argv[]) {
   #endif  // OLAD_SKIP_ROOT_CHECK
 
 #ifndef _WIN32
-  if (FLAGS_daemon)
+  if (FLAGS_daemon) {
     ola::Daemonise();
+    // The forked child writes logs synchronously until we restart the writer.
+    ola::RestartAsyncLogging();
+  }
 #endif  // _WIN32
 
   ola::ExportMap export_map;
@@ -132,10 +146,21 @@ int main(int argc, char *argv[]) {
   options.http_enable = FLAGS_http;
   options.http_enable_quit = FLAGS_http_quit;
   options.http_port = FLAGS_http_port;
+  options.http_threads = FLAGS_http_threads;
   options.http_data_dir = FLAGS_http_data_dir.str();
   options.network_interface = FLAGS_interface.str();
   options.pid_data_dir = FLAGS_pid_location.str();
 
+  // The capture must outlive the daemon, since plugins may still be receiving
+  // while they're torn down.
+  PacketCaptureWriter packet_capture;
+  if (!FLAGS_packet_capture.str().empty()) {
+    if (!packet_capture.Open(FLAGS_packet_capture.str())) {
+      return ola::EXIT_CANTCREAT;
+    }
+    SetPacketCapture(&packet_capture);
+  }
+
   std::auto_ptr<OlaDaemon> olad(new OlaDaemon(options, &export_map));
   if (!olad.get()) {
     return ola::EXIT_UNAVAILABLE;
@@ -172,5 +197,7 @@ int main(int argc, char *argv[]) {
 #endif  // _WIN32
 
   olad->Run();
+  olad.reset();
+  SetPacketCapture(NULL);
   return ola::EXIT_OK;
 }
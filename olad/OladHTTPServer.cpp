@@ -20,6 +20,7 @@
 
 #include <sys/time.h>
 #include <iostream>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -31,7 +32,8 @@
 #include "ola/base/Version.h"
 #include "ola/dmx/SourcePriorities.h"
 #include "ola/network/NetworkUtils.h"
-#include "ola/web/Json.h"
+#include "ola/web/JsonStreamWriter.h"
+#include "olad/BulkDmx.h"
 #include "olad/DmxSource.h"
 #include "olad/HttpServerActions.h"
 #include "olad/OladHTTPServer.h"
@@ -50,8 +52,7 @@ using ola::http::HTTPRequest;
 using ola::http::HTTPResponse;
 using ola::http::HTTPServer;
 using ola::io::ConnectedDescriptor;
-using ola::web::JsonArray;
-using ola::web::JsonObject;
+using ola::web::JsonStreamWriter;
 using std::cout;
 using std::endl;
 using std::ostringstream;
@@ -85,7 +86,8 @@ OladHTTPServer::OladHTTPServer(ExportMap *export_map,
       m_ola_server(ola_server),
       m_enable_quit(options.enable_quit),
       m_interface(iface),
-      m_rdm_module(&m_server, &m_client) {
+      m_rdm_module(&m_server, &m_client),
+      m_stream_module(&m_server, &m_client) {
   // The main handlers
   RegisterHandler("/quit", &OladHTTPServer::DisplayQuit);
   RegisterHandler("/reload", &OladHTTPServer::ReloadPlugins);
@@ -95,6 +97,8 @@ OladHTTPServer::OladHTTPServer(ExportMap *export_map,
   RegisterHandler("/set_plugin_state", &OladHTTPServer::SetPluginState);
   RegisterHandler("/set_dmx", &OladHTTPServer::HandleSetDmx);
   RegisterHandler("/get_dmx", &OladHTTPServer::GetDmx);
+  RegisterHandler("/set_dmx_bulk", &OladHTTPServer::HandleSetDmxBulk);
+  RegisterHandler("/get_dmx_bulk", &OladHTTPServer::GetDmxBulk);
 
   // json endpoints for the new UI
   RegisterHandler("/json/server_stats", &OladHTTPServer::JsonServerStats);
@@ -441,7 +445,8 @@ int OladHTTPServer::JsonServerStats(const HTTPRequest*,
   strftime(start_time_str, sizeof(start_time_str), "%c", &start_time);
 #endif  // _WIN32
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("hostname", ola::network::FQDN());
   json.Add("instance_name", m_ola_server->InstanceName());
   json.Add("config_dir",
@@ -453,10 +458,11 @@ int OladHTTPServer::JsonServerStats(const HTTPRequest*,
   json.Add("version", ola::base::Version::GetVersion());
   json.Add("up_since", start_time_str);
   json.Add("quit_enabled", m_enable_quit);
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  int r = response->SendJson(json);
+  int r = response->Send();
   delete response;
   return r;
 }
@@ -765,6 +771,90 @@ int OladHTTPServer::HandleSetDmx(const HTTPRequest *request,
 }
 
 
+/**
+ * @brief Handle the get bulk DMX command
+ * @param request the HTTPRequest
+ * @param response the HTTPResponse
+ * @returns MHD_NO or MHD_YES
+ */
+int OladHTTPServer::GetDmxBulk(const HTTPRequest *request,
+                               HTTPResponse *response) {
+  if (request->CheckParameterExists(HELP_PARAMETER)) {
+    return ServeUsage(response,
+        "?u=[comma separated list of universes]&amp;format=[json|base64|"
+        "binary]");
+  }
+
+  vector<string> tokens;
+  StringSplit(request->GetParameter("u"), &tokens, ",");
+  vector<unsigned int> universes;
+  vector<string>::const_iterator iter = tokens.begin();
+  for (; iter != tokens.end(); ++iter) {
+    unsigned int universe_id;
+    if (!StringToInt(*iter, &universe_id)) {
+      return ServeHelpRedirect(response);
+    }
+    universes.push_back(universe_id);
+  }
+
+  const string format_str = request->GetParameter("format");
+  BulkDmxFormat format = BULK_DMX_JSON;
+  if (format_str == "base64") {
+    format = BULK_DMX_BASE64;
+  } else if (format_str == "binary") {
+    format = BULK_DMX_BINARY;
+  } else if (!format_str.empty() && format_str != "json") {
+    return ServeHelpRedirect(response);
+  }
+
+  m_client.FetchBulkDMX(
+      universes,
+      NewSingleCallback(this, &OladHTTPServer::HandleGetDmxBulk, response,
+                        format));
+  return MHD_YES;
+}
+
+
+/**
+ * @brief Handle the set bulk DMX command
+ * @param request the HTTPRequest
+ * @param response the HTTPResponse
+ * @returns MHD_NO or MHD_YES
+ */
+int OladHTTPServer::HandleSetDmxBulk(const HTTPRequest *request,
+                                     HTTPResponse *response) {
+  if (request->CheckParameterExists(HELP_PARAMETER)) {
+    return ServeUsage(response,
+        "POST a JSON document: {\"universes\": [{\"universe\": 1, "
+        "\"dmx\": [0, 255]}, {\"universe\": 2, \"base64\": \"AP8=\"}]}"
+        "<br>or, with a Content-Type of application/octet-stream, a record "
+        "per universe: universe (4 bytes), length (2 bytes), DMX data. The "
+        "universe & length are big endian.");
+  }
+
+  BulkDmxData data;
+  string error;
+  bool ok;
+  if (StringBeginsWith(request->GetHeader("Content-Type"),
+                       HTTPServer::CONTENT_TYPE_OCT)) {
+    ok = ParseBulkDmxBinary(request->PostData(), &data, &error);
+  } else {
+    ok = ParseBulkDmxJson(request->PostData(), &data, &error);
+  }
+  if (!ok) {
+    return m_server.ServeError(response, error);
+  }
+  if (data.empty()) {
+    return m_server.ServeError(response, "No DMX data");
+  }
+
+  ola::client::SendDMXArgs args(
+      NewSingleCallback(this, &OladHTTPServer::HandleBoolResponse, response));
+  m_client.SendBulkDMX(data, args);
+  return MHD_YES;
+}
+
+
 /**
  * @brief Cause the server to shutdown
  * @param request the HTTPRequest
@@ -835,58 +925,61 @@ void OladHTTPServer::HandlePluginList(HTTPResponse *response,
     return;
   }
 
-  JsonObject *json = new JsonObject();
+  // The response is written as we go, so the plugins have to come first.
+  JsonStreamWriter *json = new JsonStreamWriter(response->Body());
+  json->StartObject();
+  json->StartArray("plugins");
+  vector<OlaPlugin>::const_iterator iter;
+  for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
+    json->StartObject();
+    json->Add("name", iter->Name());
+    json->Add("id", iter->Id());
+    json->Add("active", iter->IsActive());
+    json->Add("enabled", iter->IsEnabled());
+    json->EndObject();
+  }
+  json->EndArray();
 
-  // fire off the universe request now. the main server is running in a
-  // separate thread.
   m_client.FetchUniverseList(
       NewSingleCallback(this,
                         &OladHTTPServer::HandleUniverseList,
                         response,
                         json));
-
-  JsonArray *plugins_json = json->AddArray("plugins");
-  vector<OlaPlugin>::const_iterator iter;
-  for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
-    JsonObject *plugin = plugins_json->AppendObject();
-    plugin->Add("name", iter->Name());
-    plugin->Add("id", iter->Id());
-    plugin->Add("active", iter->IsActive());
-    plugin->Add("enabled", iter->IsEnabled());
-  }
 }
 
 
 /**
  * @brief Handle the universe list callback
  * @param response the HTTPResponse that is associated with the request.
- * @param json the JsonObject to add the data to
+ * @param json the JsonStreamWriter to add the data to
  * @param result the result of the API call
  * @param universes the vector of OlaUniverse
  */
 void OladHTTPServer::HandleUniverseList(HTTPResponse *response,
-                                        JsonObject *json,
+                                        JsonStreamWriter *json,
                                         const client::Result &result,
                                         const vector<OlaUniverse> &universes) {
   if (result.Success()) {
-    JsonArray *universe_json = json->AddArray("universes");
-
+    json->StartArray("universes");
     vector<OlaUniverse>::const_iterator iter;
     for (iter = universes.begin(); iter != universes.end(); ++iter) {
-      JsonObject *universe = universe_json->AppendObject();
-      universe->Add("id", iter->Id());
-      universe->Add("input_ports", iter->InputPortCount());
-      universe->Add("name", iter->Name());
-      universe->Add("output_ports", iter->OutputPortCount());
-      universe->Add("rdm_devices", iter->RDMDeviceCount());
+      json->StartObject();
+      json->Add("id", iter->Id());
+      json->Add("input_ports", iter->InputPortCount());
+      json->Add("name", iter->Name());
+      json->Add("output_ports", iter->OutputPortCount());
+      json->Add("rdm_devices", iter->RDMDeviceCount());
+      json->EndObject();
     }
+    json->EndArray();
   }
+  json->EndObject();
+  delete json;
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(*json);
+  response->Send();
   delete response;
-  delete json;
 }
 
 
@@ -932,24 +1025,28 @@ void OladHTTPServer::HandlePluginInfo(HTTPResponse *response,
   // Replace \n before passing in so we get \\n out the far end
   ReplaceAll(&escaped_description, "\n", "\\n");
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("description", escaped_description);
   json.Add("name", state.name);
   json.Add("enabled", state.enabled);
   json.Add("active", state.active);
   json.Add("preferences_source", state.preferences_source);
-  JsonArray *plugins = json.AddArray("conflicts_with");
+  json.StartArray("conflicts_with");
   vector<OlaPlugin>::const_iterator iter = state.conflicting_plugins.begin();
   for (; iter != state.conflicting_plugins.end(); ++iter) {
-    JsonObject *plugin = plugins->AppendObject();
-    plugin->Add("active", iter->IsActive());
-    plugin->Add("id", iter->Id());
-    plugin->Add("name", iter->Name());
+    json.StartObject();
+    json.Add("active", iter->IsActive());
+    json.Add("id", iter->Id());
+    json.Add("name", iter->Name());
+    json.EndObject();
   }
+  json.EndArray();
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -968,10 +1065,14 @@ void OladHTTPServer::HandleUniverseInfo(HTTPResponse *response,
     return;
   }
 
-  JsonObject *json = new JsonObject();
+  // The response is written as we go, so these have to come first.
+  JsonStreamWriter *json = new JsonStreamWriter(response->Body());
+  json->StartObject();
+  json->Add("id", universe.Id());
+  json->Add("name", universe.Name());
+  json->Add("merge_mode",
+           (universe.MergeMode() == OlaUniverse::MERGE_HTP ? "HTP" : "LTP"));
 
-  // fire off the device/port request now. the main server is running in a
-  // separate thread.
   m_client.FetchDeviceInfo(
       ola::OLA_PLUGIN_ALL,
       NewSingleCallback(this,
@@ -979,54 +1080,93 @@ void OladHTTPServer::HandleUniverseInfo(HTTPResponse *response,
                         response,
                         json,
                         universe.Id()));
-
-  json->Add("id", universe.Id());
-  json->Add("name", universe.Name());
-  json->Add("merge_mode",
-           (universe.MergeMode() == OlaUniverse::MERGE_HTP ? "HTP" : "LTP"));
 }
 
 
 void OladHTTPServer::HandlePortsForUniverse(
     HTTPResponse *response,
-    JsonObject *json,
+    JsonStreamWriter *json,
     unsigned int universe_id,
     const client::Result &result,
     const vector<OlaDevice> &devices) {
   if (result.Success()) {
-    vector<OlaDevice>::const_iterator iter = devices.begin();
+    vector<OlaDevice>::const_iterator iter;
     vector<OlaInputPort>::const_iterator input_iter;
     vector<OlaOutputPort>::const_iterator output_iter;
 
-    JsonArray *output_ports_json = json->AddArray("output_ports");
-    JsonArray *input_ports_json = json->AddArray("input_ports");
+    // Each array is written in a separate pass over the devices.
+    json->StartArray("output_ports");
+    for (iter = devices.begin(); iter != devices.end(); ++iter) {
+      const vector<OlaOutputPort> &output_ports = iter->OutputPorts();
+      for (output_iter = output_ports.begin();
+           output_iter != output_ports.end(); ++output_iter) {
+        if (output_iter->IsActive() &&
+            output_iter->Universe() == universe_id) {
+          PortToJson(json, *iter, *output_iter, true);
+        }
+      }
+    }
+    json->EndArray();
 
-    for (; iter != devices.end(); ++iter) {
+    json->StartArray("input_ports");
+    for (iter = devices.begin(); iter != devices.end(); ++iter) {
       const vector<OlaInputPort> &input_ports = iter->InputPorts();
       for (input_iter = input_ports.begin(); input_iter != input_ports.end();
            ++input_iter) {
         if (input_iter->IsActive() && input_iter->Universe() == universe_id) {
-          JsonObject *obj = input_ports_json->AppendObject();
-          PortToJson(obj, *iter, *input_iter, false);
+          PortToJson(json, *iter, *input_iter, false);
         }
       }
+    }
+    json->EndArray();
+  }
 
-      const vector<OlaOutputPort> &output_ports = iter->OutputPorts();
-      for (output_iter = output_ports.begin();
-           output_iter != output_ports.end(); ++output_iter) {
-        if (output_iter->IsActive() &&
-            output_iter->Universe() == universe_id) {
-          JsonObject *obj = output_ports_json->AppendObject();
-          PortToJson(obj, *iter, *output_iter, true);
-        }
-      }
+  vector<unsigned int> universes(1, universe_id);
+  m_client.FetchUniverseStats(
+      universes,
+      NewSingleCallback(this,
+                        &OladHTTPServer::HandleUniverseStats,
+                        response,
+                        json));
+}
+
+
+/**
+ * @brief Add the frame stats to the universe info & send the response.
+ * @param response the HTTPResponse that is associated with the request.
+ * @param json the JsonStreamWriter for the universe info.
+ * @param result the result of the API call
+ * @param stats the stats for the universe
+ */
+void OladHTTPServer::HandleUniverseStats(
+    HTTPResponse *response,
+    JsonStreamWriter *json,
+    const client::Result &result,
+    const vector<client::UniverseStats> &stats) {
+  if (result.Success() && !stats.empty()) {
+    const client::UniverseStats &universe_stats = stats[0];
+    json->StartObject("stats");
+    FrameStatsToJson(json, "input", universe_stats.input);
+    FrameStatsToJson(json, "output", universe_stats.output);
+    json->StartArray("ports");
+    vector<client::PortStats>::const_iterator iter =
+        universe_stats.ports.begin();
+    for (; iter != universe_stats.ports.end(); ++iter) {
+      json->StartObject();
+      json->Add("id", iter->port_id);
+      json->Add("is_output", iter->is_output);
+      FrameStatsToJson(json, "stats", iter->stats);
+      json->EndObject();
     }
+    json->EndArray();
+    json->EndObject();
   }
+  json->EndObject();
+  delete json;
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(*json);
-  delete json;
+  response->Send();
   delete response;
 }
 
@@ -1050,26 +1190,26 @@ void OladHTTPServer::HandleCandidatePorts(
   vector<OlaInputPort>::const_iterator input_iter;
   vector<OlaOutputPort>::const_iterator output_iter;
 
-  JsonArray json;
+  JsonStreamWriter json(response->Body());
+  json.StartArray();
   for (; iter != devices.end(); ++iter) {
     const vector<OlaInputPort> &input_ports = iter->InputPorts();
     for (input_iter = input_ports.begin(); input_iter != input_ports.end();
          ++input_iter) {
-      JsonObject *obj = json.AppendObject();
-      PortToJson(obj, *iter, *input_iter, false);
+      PortToJson(&json, *iter, *input_iter, false);
     }
 
     const vector<OlaOutputPort> &output_ports = iter->OutputPorts();
     for (output_iter = output_ports.begin();
          output_iter != output_ports.end(); ++output_iter) {
-      JsonObject *obj = json.AppendObject();
-      PortToJson(obj, *iter, *output_iter, true);
+      PortToJson(&json, *iter, *output_iter, true);
     }
   }
+  json.EndArray();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -1109,14 +1249,16 @@ void OladHTTPServer::SendCreateUniverseResponse(
     failed &= action_queue->GetAction(i)->Failed();
   }
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("ok", !failed);
   json.Add("universe", universe_id);
   json.Add("message", (failed ? "Failed to patch any ports" : ""));
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete action_queue;
   delete response;
 }
@@ -1181,16 +1323,75 @@ void OladHTTPServer::HandleGetDmx(HTTPResponse *response,
                                   const client::Result &result,
                                   const client::DMXMetadata &,
                                   const DmxBuffer &buffer) {
-  // rather than adding 512 JsonValue we cheat and use raw here
-  ostringstream str;
-  str << "[" << buffer.ToString() << "]";
-  JsonObject json;
-  json.AddRaw("dmx", str.str());
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
+  json.StartArray("dmx");
+  for (unsigned int i = 0; i < buffer.Size(); i++) {
+    json.Value(static_cast<unsigned int>(buffer.Get(i)));
+  }
+  json.EndArray();
   json.Add("error", result.Error());
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
+  delete response;
+}
+
+
+/**
+ * @brief Callback for m_client.FetchBulkDMX called by GetDmxBulk
+ * @param response the HTTPResponse
+ * @param format the format to return the data in
+ * @param result the result of the API call
+ * @param data the DmxBuffer for each universe
+ */
+void OladHTTPServer::HandleGetDmxBulk(
+    HTTPResponse *response,
+    BulkDmxFormat format,
+    const client::Result &result,
+    const std::map<unsigned int, DmxBuffer> &data) {
+  response->SetNoCache();
+  if (format == BULK_DMX_BINARY) {
+    if (!result.Success()) {
+      m_server.ServeError(response, result.Error());
+      return;
+    }
+    WriteBulkDmxBinary(data, response->Body());
+    response->SetContentType(HTTPServer::CONTENT_TYPE_OCT);
+    response->Send();
+    delete response;
+    return;
+  }
+
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
+  json.Add("error", result.Error());
+  json.StartArray("universes");
+  std::map<unsigned int, DmxBuffer>::const_iterator iter = data.begin();
+  for (; iter != data.end(); ++iter) {
+    const DmxBuffer &buffer = iter->second;
+    json.StartObject();
+    json.Add("universe", iter->first);
+    if (format == BULK_DMX_BASE64) {
+      string encoded;
+      Base64Encode(buffer.Get(), &encoded);
+      json.Add("base64", encoded);
+    } else {
+      json.StartArray("dmx");
+      for (unsigned int i = 0; i < buffer.Size(); i++) {
+        json.Value(static_cast<unsigned int>(buffer.Get(i)));
+      }
+      json.EndArray();
+    }
+    json.EndObject();
+  }
+  json.EndArray();
+  json.EndObject();
+
+  response->SetContentType(HTTPServer::CONTENT_TYPE_JSON);
+  response->Send();
   delete response;
 }
 
@@ -1214,21 +1415,38 @@ void OladHTTPServer::HandleBoolResponse(HTTPResponse *response,
 
 
 /**
- * @brief Add the json representation of this port to the ostringstream
+ * @brief Write the json representation of a set of frame stats.
+ */
+void OladHTTPServer::FrameStatsToJson(JsonStreamWriter *json,
+                                      const string &key,
+                                      const client::FrameStats &stats) {
+  json->StartObject(key);
+  json->Add("frames", stats.frames);
+  json->Add("fps", stats.fps);
+  json->Add("jitter_us", stats.jitter_us);
+  json->Add("mean_latency_us", stats.mean_latency_us);
+  json->Add("max_latency_us", stats.max_latency_us);
+  json->EndObject();
+}
+
+
+/**
+ * @brief Write the json representation of this port as an object.
  */
-void OladHTTPServer::PortToJson(JsonObject *json,
+void OladHTTPServer::PortToJson(JsonStreamWriter *json,
                                 const OlaDevice &device,
                                 const OlaPort &port,
                                 bool is_output) {
   ostringstream str;
   str << device.Alias() << "-" << (is_output ? "O" : "I") << "-" << port.Id();
 
+  json->StartObject();
   json->Add("device", device.Name());
   json->Add("description", port.Description());
   json->Add("id", str.str());
   json->Add("is_output", is_output);
 
-  JsonObject *priority_json = json->AddObject("priority");
+  json->StartObject("priority");
   if (port.PriorityCapability() != CAPABILITY_NONE) {
     // This can be used as the default value for the priority input and because
     // inherit ports can return a 0 priority we shall set it to the default
@@ -1238,13 +1456,15 @@ void OladHTTPServer::PortToJson(JsonObject *json,
       // We check here because 0 is an invalid priority outside of Olad
       priority = dmx::SOURCE_PRIORITY_DEFAULT;
     }
-    priority_json->Add("value", static_cast<int>(priority));
-    priority_json->Add(
+    json->Add("value", static_cast<int>(priority));
+    json->Add(
       "current_mode",
       (port.PriorityMode() == PRIORITY_MODE_INHERIT ?  "inherit" : "static"));
-    priority_json->Add("priority_capability",
+    json->Add("priority_capability",
       (port.PriorityCapability() == CAPABILITY_STATIC ? "static" : "full"));
   }
+  json->EndObject();
+  json->EndObject();
 }
 
 
@@ -22,6 +22,7 @@
 #define OLAD_OLADHTTPSERVER_H_
 
 #include <time.h>
+#include <map>
 #include <string>
 #include <vector>
 #include "ola/ExportMap.h"
@@ -31,7 +32,9 @@
 #include "ola/http/OlaHTTPServer.h"
 #include "ola/network/Interface.h"
 #include "ola/rdm/PidStore.h"
+#include "ola/web/JsonStreamWriter.h"
 #include "olad/RDMHTTPModule.h"
+#include "olad/StreamingHTTPModule.h"
 
 namespace ola {
 
@@ -83,6 +86,10 @@ class OladHTTPServer: public ola::http::OlaHTTPServer {
              ola::http::HTTPResponse *response);
   int HandleSetDmx(const ola::http::HTTPRequest *request,
                    ola::http::HTTPResponse *response);
+  int GetDmxBulk(const ola::http::HTTPRequest *request,
+                 ola::http::HTTPResponse *response);
+  int HandleSetDmxBulk(const ola::http::HTTPRequest *request,
+                       ola::http::HTTPResponse *response);
   int DisplayQuit(const ola::http::HTTPRequest *request,
                   ola::http::HTTPResponse *response);
   int ReloadPlugins(const ola::http::HTTPRequest *request,
@@ -95,7 +102,7 @@ class OladHTTPServer: public ola::http::OlaHTTPServer {
                         const std::vector<client::OlaPlugin> &plugins);
 
   void HandleUniverseList(ola::http::HTTPResponse *response,
-                          ola::web::JsonObject *json,
+                          ola::web::JsonStreamWriter *json,
                           const client::Result &result,
                           const std::vector<client::OlaUniverse> &universes);
 
@@ -113,11 +120,16 @@ class OladHTTPServer: public ola::http::OlaHTTPServer {
                           const client::OlaUniverse &universe);
 
   void HandlePortsForUniverse(ola::http::HTTPResponse *response,
-                              ola::web::JsonObject *json,
+                              ola::web::JsonStreamWriter *json,
                               unsigned int universe_id,
                               const client::Result &result,
                               const std::vector<client::OlaDevice> &devices);
 
+  void HandleUniverseStats(ola::http::HTTPResponse *response,
+                           ola::web::JsonStreamWriter *json,
+                           const client::Result &result,
+                           const std::vector<client::UniverseStats> &stats);
+
   void HandleCandidatePorts(ola::http::HTTPResponse *response,
                             const client::Result &result,
                             const std::vector<client::OlaDevice> &devices);
@@ -157,6 +169,7 @@ class OladHTTPServer: public ola::http::OlaHTTPServer {
   bool m_enable_quit;
   ola::network::Interface m_interface;
   RDMHTTPModule m_rdm_module;
+  StreamingHTTPModule m_stream_module;
   time_t m_start_time_t;
 
   void HandleGetDmx(ola::http::HTTPResponse *response,
@@ -164,10 +177,25 @@ class OladHTTPServer: public ola::http::OlaHTTPServer {
                     const client::DMXMetadata &metadata,
                     const DmxBuffer &buffer);
 
+  typedef enum {
+    BULK_DMX_JSON,
+    BULK_DMX_BASE64,
+    BULK_DMX_BINARY,
+  } BulkDmxFormat;
+
+  void HandleGetDmxBulk(ola::http::HTTPResponse *response,
+                        BulkDmxFormat format,
+                        const client::Result &result,
+                        const std::map<unsigned int, DmxBuffer> &data);
+
   void HandleBoolResponse(ola::http::HTTPResponse *response,
                           const client::Result &result);
 
-  void PortToJson(ola::web::JsonObject *object,
+  void FrameStatsToJson(ola::web::JsonStreamWriter *json,
+                        const std::string &key,
+                        const client::FrameStats &stats);
+
+  void PortToJson(ola::web::JsonStreamWriter *json,
                   const client::OlaDevice &device,
                   const client::OlaPort &port,
                   bool is_output);
@@ -0,0 +1,401 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMCache.cpp
+ * Caches the replies to RDM GETs for parameters that rarely change.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ola/ExportMap.h"
+#include "ola/Logging.h"
+#include "ola/StringUtils.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/strings/Format.h"
+#include "olad/Preferences.h"
+#include "olad/RDMCache.h"
+
+namespace ola {
+
+using ola::rdm::RDMCommand;
+using ola::rdm::RDMReply;
+using ola::rdm::RDMRequest;
+using ola::rdm::RDMResponse;
+using ola::rdm::UID;
+using std::auto_ptr;
+using std::string;
+using std::vector;
+
+const char RDMCache::ENTRY_KEY[] = "entry";
+const char RDMCache::HITS_VAR[] = "rdm-cache-hits";
+const char RDMCache::MISSES_VAR[] = "rdm-cache-misses";
+const char RDMCache::ENTRIES_VAR[] = "rdm-cache-entries";
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+string HexEncode(const string &input) {
+  string output;
+  output.reserve(input.size() * 2);
+  for (string::const_iterator iter = input.begin(); iter != input.end();
+       ++iter) {
+    uint8_t value = static_cast<uint8_t>(*iter);
+    output.push_back(HEX_DIGITS[value >> 4]);
+    output.push_back(HEX_DIGITS[value & 0x0f]);
+  }
+  return output;
+}
+
+bool HexDecode(const string &input, string *output) {
+  if (input.size() % 2) {
+    return false;
+  }
+  output->clear();
+  for (unsigned int i = 0; i < input.size(); i += 2) {
+    uint8_t value;
+    if (!HexStringToInt(input.substr(i, 2), &value)) {
+      return false;
+    }
+    output->push_back(static_cast<char>(value));
+  }
+  return true;
+}
+}  // namespace
+
+RDMCache::RequestInfo::RequestInfo(unsigned int universe,
+                                   const RDMRequest &request)
+    : m_universe(universe),
+      m_destination(request.DestinationUID()),
+      m_command_class(request.CommandClass()),
+      m_sub_device(request.SubDevice()),
+      m_param_id(request.ParamId()),
+      m_param_data(reinterpret_cast<const char*>(request.ParamData()),
+                   request.ParamDataSize()) {
+}
+
+bool RDMCache::RequestInfo::IsSet() const {
+  return m_command_class == RDMCommand::SET_COMMAND;
+}
+
+bool RDMCache::RequestInfo::IsGet() const {
+  return m_command_class == RDMCommand::GET_COMMAND;
+}
+
+bool RDMCache::Key::operator<(const Key &other) const {
+  if (universe != other.universe) {
+    return universe < other.universe;
+  }
+  if (uid != other.uid) {
+    return uid < other.uid;
+  }
+  if (sub_device != other.sub_device) {
+    return sub_device < other.sub_device;
+  }
+  if (param_id != other.param_id) {
+    return param_id < other.param_id;
+  }
+  return param_data < other.param_data;
+}
+
+RDMCache::RDMCache(const Options &options, ExportMap *export_map,
+                   Clock *clock)
+    : m_options(options),
+      m_clock(clock),
+      m_free_clock(false),
+      m_hits(NULL),
+      m_misses(NULL),
+      m_size(NULL) {
+  if (!m_clock) {
+    m_clock = new Clock();
+    m_free_clock = true;
+  }
+
+  if (export_map) {
+    m_hits = export_map->GetCounterVar(HITS_VAR);
+    m_misses = export_map->GetCounterVar(MISSES_VAR);
+    m_size = export_map->GetIntegerVar(ENTRIES_VAR);
+  }
+}
+
+RDMCache::~RDMCache() {
+  if (m_free_clock) {
+    delete m_clock;
+  }
+}
+
+bool RDMCache::Get(const RequestInfo &request, string *data) {
+  if (!request.IsGet() || !IsCacheable(request.ParamId())) {
+    return false;
+  }
+
+  Key key(request.Universe(), request.DestinationUID(), request.SubDevice(),
+          request.ParamId(), request.ParamData());
+  EntryMap::iterator iter = m_entries.find(key);
+  if (iter != m_entries.end()) {
+    TimeStamp now;
+    m_clock->CurrentTime(&now);
+    if (iter->second.expiry > now) {
+      *data = iter->second.data;
+      if (m_hits) {
+        (*m_hits)++;
+      }
+      return true;
+    }
+    m_entries.erase(iter);
+    UpdateSize();
+  }
+
+  if (m_misses) {
+    (*m_misses)++;
+  }
+  return false;
+}
+
+void RDMCache::Update(const RequestInfo &request, const RDMReply &reply) {
+  if (request.IsSet()) {
+    // The SET may have taken effect even if the reply was lost, and changing
+    // one parameter, like the personality, can change others.
+    Invalidate(request.Universe(), request.DestinationUID(), false,
+               request.ParamId());
+  }
+
+  const RDMResponse *response = reply.Response();
+  if (reply.StatusCode() != ola::rdm::RDM_COMPLETED_OK || !response) {
+    return;
+  }
+
+  if (response->MessageCount()) {
+    // Something has changed on the responder.
+    Invalidate(request.Universe(), response->SourceUID(), false, 0);
+  }
+
+  if (!request.IsGet() ||
+      response->CommandClass() != RDMCommand::GET_COMMAND_RESPONSE ||
+      response->ResponseType() != ola::rdm::RDM_ACK) {
+    return;
+  }
+
+  if (request.ParamId() == ola::rdm::PID_QUEUED_MESSAGE) {
+    // The reply is for whichever parameter changed.
+    Invalidate(request.Universe(), response->SourceUID(), false,
+               response->ParamId());
+  } else if (response->ParamId() == ola::rdm::PID_STATUS_MESSAGES) {
+    if (response->ParamDataSize()) {
+      Invalidate(request.Universe(), response->SourceUID(), false, 0);
+    }
+  } else if (response->ParamId() == request.ParamId() &&
+             IsCacheable(request.ParamId())) {
+    Store(request, *response);
+  }
+}
+
+void RDMCache::InvalidateUID(unsigned int universe, const UID &uid) {
+  Invalidate(universe, uid, true, 0);
+}
+
+void RDMCache::PurgeExpired() {
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+  EntryMap::iterator iter = m_entries.begin();
+  while (iter != m_entries.end()) {
+    if (iter->second.expiry <= now) {
+      m_entries.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  UpdateSize();
+}
+
+void RDMCache::Load(const Preferences &preferences) {
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+
+  const vector<string> values = preferences.GetMultipleValue(ENTRY_KEY);
+  vector<string>::const_iterator iter = values.begin();
+  for (; iter != values.end() && m_entries.size() < m_options.max_entries;
+       ++iter) {
+    Key key(0, UID(0, 0), 0, 0, "");
+    Entry entry;
+    if (!DecodeEntry(*iter, &key, &entry)) {
+      OLA_WARN << "Invalid RDM cache entry: " << *iter;
+      continue;
+    }
+    if (entry.expiry > now) {
+      m_entries[key] = entry;
+    }
+  }
+  UpdateSize();
+  OLA_INFO << "Loaded " << m_entries.size() << " RDM cache entries";
+}
+
+void RDMCache::Save(Preferences *preferences) const {
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+
+  preferences->RemoveValue(ENTRY_KEY);
+  EntryMap::const_iterator iter = m_entries.begin();
+  for (; iter != m_entries.end(); ++iter) {
+    if (iter->second.is_static && iter->second.expiry > now) {
+      preferences->SetMultipleValue(ENTRY_KEY,
+                                    EncodeEntry(iter->first, iter->second));
+    }
+  }
+}
+
+bool RDMCache::IsCacheable(uint16_t param_id) {
+  if (IsStatic(param_id)) {
+    return true;
+  }
+
+  switch (param_id) {
+    case ola::rdm::PID_DEFAULT_SLOT_VALUE:
+    case ola::rdm::PID_DEVICE_INFO:
+    case ola::rdm::PID_DEVICE_LABEL:
+    case ola::rdm::PID_DMX_PERSONALITY:
+    case ola::rdm::PID_DMX_START_ADDRESS:
+    case ola::rdm::PID_SLOT_DESCRIPTION:
+    case ola::rdm::PID_SLOT_INFO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void RDMCache::Store(const RequestInfo &request,
+                     const RDMResponse &response) {
+  Key key(request.Universe(), response.SourceUID(), response.SubDevice(),
+          request.ParamId(), request.ParamData());
+  EntryMap::iterator iter = m_entries.find(key);
+  if (iter == m_entries.end() && m_entries.size() >= m_options.max_entries) {
+    PurgeExpired();
+    if (m_entries.size() >= m_options.max_entries) {
+      OLA_DEBUG << "RDM cache is full, not caching PID "
+                << strings::ToHex(request.ParamId());
+      return;
+    }
+  }
+
+  Entry &entry = m_entries[key];
+  entry.data.assign(reinterpret_cast<const char*>(response.ParamData()),
+                    response.ParamDataSize());
+  entry.is_static = IsStatic(request.ParamId());
+  m_clock->CurrentTime(&entry.expiry);
+  entry.expiry += entry.is_static ? m_options.static_ttl :
+                  m_options.dynamic_ttl;
+  UpdateSize();
+}
+
+/*
+ * Remove the dynamic entries for a UID, which may be a broadcast or vendorcast
+ * UID. Static entries are only removed if include_static is true, or if they
+ * match param_id.
+ */
+void RDMCache::Invalidate(unsigned int universe, const UID &uid,
+                          bool include_static, uint16_t param_id) {
+  // Entries are ordered by universe then UID.
+  Key start(universe, uid.IsBroadcast() ? UID(0, 0) : uid, 0, 0, "");
+  EntryMap::iterator iter = m_entries.lower_bound(start);
+  while (iter != m_entries.end() && iter->first.universe == universe) {
+    if (!uid.IsBroadcast() && iter->first.uid != uid) {
+      break;
+    }
+    if (uid.DirectedToUID(iter->first.uid) &&
+        (include_static || !iter->second.is_static ||
+         (param_id && iter->first.param_id == param_id))) {
+      m_entries.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  UpdateSize();
+}
+
+void RDMCache::UpdateSize() {
+  if (m_size) {
+    m_size->Set(static_cast<int>(m_entries.size()));
+  }
+}
+
+bool RDMCache::IsStatic(uint16_t param_id) {
+  switch (param_id) {
+    case ola::rdm::PID_BOOT_SOFTWARE_VERSION_ID:
+    case ola::rdm::PID_BOOT_SOFTWARE_VERSION_LABEL:
+    case ola::rdm::PID_CURVE_DESCRIPTION:
+    case ola::rdm::PID_DEVICE_MODEL_DESCRIPTION:
+    case ola::rdm::PID_DIMMER_INFO:
+    case ola::rdm::PID_DMX_PERSONALITY_DESCRIPTION:
+    case ola::rdm::PID_LANGUAGE_CAPABILITIES:
+    case ola::rdm::PID_LOCK_STATE_DESCRIPTION:
+    case ola::rdm::PID_MANUFACTURER_LABEL:
+    case ola::rdm::PID_MODULATION_FREQUENCY_DESCRIPTION:
+    case ola::rdm::PID_OUTPUT_RESPONSE_TIME_DESCRIPTION:
+    case ola::rdm::PID_PARAMETER_DESCRIPTION:
+    case ola::rdm::PID_PRODUCT_DETAIL_ID_LIST:
+    case ola::rdm::PID_SELF_TEST_DESCRIPTION:
+    case ola::rdm::PID_SENSOR_DEFINITION:
+    case ola::rdm::PID_SOFTWARE_VERSION_LABEL:
+    case ola::rdm::PID_STATUS_ID_DESCRIPTION:
+    case ola::rdm::PID_SUPPORTED_PARAMETERS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * Entries are saved as:
+ *   universe,uid,sub_device,pid,expiry,param_data,data
+ * The expiry is in seconds since the epoch and the data is hex encoded.
+ */
+string RDMCache::EncodeEntry(const Key &key, const Entry &entry) {
+  std::ostringstream str;
+  str << key.universe << "," << key.uid << "," << key.sub_device << ","
+      << key.param_id << "," << entry.expiry.Seconds() << ","
+      << HexEncode(key.param_data) << "," << HexEncode(entry.data);
+  return str.str();
+}
+
+bool RDMCache::DecodeEntry(const string &input, Key *key, Entry *entry) {
+  vector<string> tokens;
+  StringSplit(input, &tokens, ",");
+  if (tokens.size() != 7) {
+    return false;
+  }
+
+  auto_ptr<UID> uid(UID::FromString(tokens[1]));
+  uint32_t expiry;
+  if (!uid.get() ||
+      !StringToInt(tokens[0], &key->universe) ||
+      !StringToInt(tokens[2], &key->sub_device) ||
+      !StringToInt(tokens[3], &key->param_id) ||
+      !StringToInt(tokens[4], &expiry) ||
+      !HexDecode(tokens[5], &key->param_data) ||
+      !HexDecode(tokens[6], &entry->data) ||
+      !IsStatic(key->param_id)) {
+    return false;
+  }
+
+  key->uid = *uid;
+  entry->expiry = TimeStamp() + TimeInterval(static_cast<int32_t>(expiry), 0);
+  entry->is_static = true;
+  return true;
+}
+}  // namespace ola
@@ -0,0 +1,218 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMCache.h
+ * Caches the replies to RDM GETs for parameters that rarely change.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef OLAD_RDMCACHE_H_
+#define OLAD_RDMCACHE_H_
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include "ola/Clock.h"
+#include "ola/base/Macro.h"
+#include "ola/rdm/RDMCommand.h"
+#include "ola/rdm/RDMReply.h"
+#include "ola/rdm/UID.h"
+
+namespace ola {
+
+/**
+ * @brief A cache of RDM parameter data, shared by all clients of olad.
+ *
+ * Static parameters, like the model description or the list of supported
+ * parameters, are kept for a long time and survive a restart of olad.
+ * Parameters which can change without a SET, like DEVICE_INFO, are only kept
+ * for a few seconds.
+ *
+ * Entries are invalidated when:
+ *  - A SET is sent to the responder, through any client.
+ *  - A responder reports it has queued messages.
+ *  - A queued message or status message is collected from the responder.
+ */
+class RDMCache {
+ public:
+  /**
+   * @brief The parts of a request the cache needs once the reply arrives.
+   */
+  class RequestInfo {
+   public:
+    RequestInfo(unsigned int universe, const ola::rdm::RDMRequest &request);
+
+    unsigned int Universe() const { return m_universe; }
+    const ola::rdm::UID &DestinationUID() const { return m_destination; }
+    uint16_t SubDevice() const { return m_sub_device; }
+    uint16_t ParamId() const { return m_param_id; }
+    const std::string &ParamData() const { return m_param_data; }
+    bool IsSet() const;
+    bool IsGet() const;
+
+   private:
+    unsigned int m_universe;
+    ola::rdm::UID m_destination;
+    ola::rdm::RDMCommand::RDMCommandClass m_command_class;
+    uint16_t m_sub_device;
+    uint16_t m_param_id;
+    std::string m_param_data;
+  };
+
+  struct Options {
+   public:
+    Options()
+        : max_entries(DEFAULT_MAX_ENTRIES),
+          static_ttl(DEFAULT_STATIC_TTL, 0),
+          dynamic_ttl(DEFAULT_DYNAMIC_TTL, 0) {
+    }
+
+    /**
+     * @brief The maximum number of parameters to cache.
+     */
+    unsigned int max_entries;
+
+    /**
+     * @brief How long to keep parameters that are fixed by the firmware.
+     */
+    TimeInterval static_ttl;
+
+    /**
+     * @brief How long to keep parameters that may change without a SET.
+     */
+    TimeInterval dynamic_ttl;
+  };
+
+  /**
+   * @brief Create a new RDMCache.
+   * @param options the Options for the cache.
+   * @param export_map the ExportMap to use for the hit & miss counters, may
+   *   be NULL.
+   * @param clock the Clock to use, if NULL a new one will be created.
+   */
+  explicit RDMCache(const Options &options,
+                    class ExportMap *export_map = NULL,
+                    Clock *clock = NULL);
+  ~RDMCache();
+
+  /**
+   * @brief Look up the parameter data for a GET.
+   * @param request the request to look up.
+   * @param[out] data the cached parameter data.
+   * @returns true if there was a valid entry, false otherwise.
+   */
+  bool Get(const RequestInfo &request, std::string *data);
+
+  /**
+   * @brief Update the cache with the result of a request.
+   * @param request the request that was sent.
+   * @param reply the reply to the request.
+   */
+  void Update(const RequestInfo &request, const ola::rdm::RDMReply &reply);
+
+  /**
+   * @brief Remove all entries for a responder.
+   */
+  void InvalidateUID(unsigned int universe, const ola::rdm::UID &uid);
+
+  /**
+   * @brief Remove the expired entries.
+   */
+  void PurgeExpired();
+
+  /**
+   * @brief The number of entries in the cache.
+   */
+  unsigned int Size() const {
+    return static_cast<unsigned int>(m_entries.size());
+  }
+
+  /**
+   * @brief Restore the static entries saved by Save().
+   * @param preferences the Preferences to read from.
+   */
+  void Load(const class Preferences &preferences);
+
+  /**
+   * @brief Save the static entries, so they can be restored after a restart.
+   * @param preferences the Preferences to write to, existing entries are
+   *   replaced.
+   */
+  void Save(class Preferences *preferences) const;
+
+  /**
+   * @brief Check if a parameter is cached.
+   */
+  static bool IsCacheable(uint16_t param_id);
+
+  static const char ENTRY_KEY[];
+  static const char HITS_VAR[];
+  static const char MISSES_VAR[];
+  static const char ENTRIES_VAR[];
+
+  static const unsigned int DEFAULT_MAX_ENTRIES = 10000;
+  static const int32_t DEFAULT_STATIC_TTL = 24 * 60 * 60;
+  static const int32_t DEFAULT_DYNAMIC_TTL = 30;
+
+ private:
+  struct Key {
+    Key(unsigned int universe, const ola::rdm::UID &uid, uint16_t sub_device,
+        uint16_t param_id, const std::string &param_data)
+        : universe(universe),
+          uid(uid),
+          sub_device(sub_device),
+          param_id(param_id),
+          param_data(param_data) {
+    }
+
+    unsigned int universe;
+    ola::rdm::UID uid;
+    uint16_t sub_device;
+    uint16_t param_id;
+    std::string param_data;
+
+    bool operator<(const Key &other) const;
+  };
+
+  struct Entry {
+    std::string data;
+    TimeStamp expiry;
+    bool is_static;
+  };
+
+  typedef std::map<Key, Entry> EntryMap;
+
+  const Options m_options;
+  Clock *m_clock;
+  bool m_free_clock;
+  EntryMap m_entries;
+  class CounterVariable *m_hits;
+  class CounterVariable *m_misses;
+  class IntegerVariable *m_size;
+
+  void Store(const RequestInfo &request,
+             const ola::rdm::RDMResponse &response);
+  void Invalidate(unsigned int universe, const ola::rdm::UID &uid,
+                  bool include_static, uint16_t param_id);
+  void UpdateSize();
+
+  static bool IsStatic(uint16_t param_id);
+  static std::string EncodeEntry(const Key &key, const Entry &entry);
+  static bool DecodeEntry(const std::string &input, Key *key, Entry *entry);
+
+  DISALLOW_COPY_AND_ASSIGN(RDMCache);
+};
+}  // namespace ola
+#endif  // OLAD_RDMCACHE_H_
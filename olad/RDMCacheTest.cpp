@@ -0,0 +1,364 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMCacheTest.cpp
+ * Test fixture for the RDMCache class.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include "ola/Clock.h"
+#include "ola/ExportMap.h"
+#include "ola/rdm/RDMCommand.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/rdm/RDMReply.h"
+#include "ola/rdm/UID.h"
+#include "ola/testing/TestUtils.h"
+#include "olad/Preferences.h"
+#include "olad/RDMCache.h"
+
+using ola::ExportMap;
+using ola::MemoryPreferences;
+using ola::MockClock;
+using ola::RDMCache;
+using ola::rdm::RDMGetRequest;
+using ola::rdm::RDMReply;
+using ola::rdm::RDMRequest;
+using ola::rdm::RDMResponse;
+using ola::rdm::RDMSetRequest;
+using ola::rdm::UID;
+using std::string;
+
+class RDMCacheTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(RDMCacheTest);
+  CPPUNIT_TEST(testGet);
+  CPPUNIT_TEST(testExpiry);
+  CPPUNIT_TEST(testSetInvalidates);
+  CPPUNIT_TEST(testQueuedMessages);
+  CPPUNIT_TEST(testMaxEntries);
+  CPPUNIT_TEST(testPersistence);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  RDMCacheTest()
+      : m_source(1, 1),
+        m_uid(0x7a70, 2),
+        m_other_uid(0x7a70, 3) {
+  }
+
+  void testGet();
+  void testExpiry();
+  void testSetInvalidates();
+  void testQueuedMessages();
+  void testMaxEntries();
+  void testPersistence();
+
+ private:
+  UID m_source;
+  UID m_uid;
+  UID m_other_uid;
+  MockClock m_clock;
+
+  RDMRequest *NewGet(const UID &uid, uint16_t pid,
+                     const string &param_data = "");
+  RDMRequest *NewSet(const UID &uid, uint16_t pid);
+  void Reply(RDMCache *cache, const RDMRequest &request, const string &data,
+             uint8_t message_count = 0);
+  bool Get(RDMCache *cache, const UID &uid, uint16_t pid, string *data,
+           const string &param_data = "");
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RDMCacheTest);
+
+static const unsigned int UNIVERSE = 1;
+
+
+RDMRequest *RDMCacheTest::NewGet(const UID &uid, uint16_t pid,
+                                 const string &param_data) {
+  return new RDMGetRequest(
+      m_source, uid, 0, 1, 0, pid,
+      reinterpret_cast<const uint8_t*>(param_data.data()),
+      param_data.size());
+}
+
+RDMRequest *RDMCacheTest::NewSet(const UID &uid, uint16_t pid) {
+  const uint8_t data[] = {1, 2};
+  return new RDMSetRequest(m_source, uid, 0, 1, 0, pid, data, sizeof(data));
+}
+
+/*
+ * Pass an ACK for a request through the cache.
+ */
+void RDMCacheTest::Reply(RDMCache *cache, const RDMRequest &request,
+                         const string &data, uint8_t message_count) {
+  RDMResponse *response = ola::rdm::GetResponseFromData(
+      &request, reinterpret_cast<const uint8_t*>(data.data()), data.size(),
+      ola::rdm::RDM_ACK, message_count);
+  RDMReply reply(ola::rdm::RDM_COMPLETED_OK, response);
+  cache->Update(RDMCache::RequestInfo(UNIVERSE, request), reply);
+}
+
+bool RDMCacheTest::Get(RDMCache *cache, const UID &uid, uint16_t pid,
+                       string *data, const string &param_data) {
+  std::auto_ptr<RDMRequest> request(NewGet(uid, pid, param_data));
+  return cache->Get(RDMCache::RequestInfo(UNIVERSE, *request), data);
+}
+
+
+/*
+ * Check that GETs are cached, and other requests aren't.
+ */
+void RDMCacheTest::testGet() {
+  ExportMap export_map;
+  RDMCache cache(RDMCache::Options(), &export_map, &m_clock);
+  string data;
+
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+
+  std::auto_ptr<RDMRequest> request(NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+  Reply(&cache, *request, "info");
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_EQ(string("info"), data);
+  OLA_ASSERT_FALSE(Get(&cache, m_other_uid, ola::rdm::PID_DEVICE_INFO, &data));
+
+  // The parameter data is part of the key.
+  string pid("\x00\x80", 2);
+  request.reset(NewGet(m_uid, ola::rdm::PID_PARAMETER_DESCRIPTION, pid));
+  Reply(&cache, *request, "description");
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_PARAMETER_DESCRIPTION,
+                      &data, pid));
+  OLA_ASSERT_EQ(string("description"), data);
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_PARAMETER_DESCRIPTION,
+                       &data, string("\x00\x81", 2)));
+
+  // Parameters that change all the time aren't cached.
+  request.reset(NewGet(m_uid, ola::rdm::PID_SENSOR_VALUE));
+  Reply(&cache, *request, "value");
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_SENSOR_VALUE, &data));
+
+  // Neither are NACKs.
+  request.reset(NewGet(m_uid, ola::rdm::PID_DEVICE_LABEL));
+  RDMReply nack(ola::rdm::RDM_COMPLETED_OK,
+                ola::rdm::NackWithReason(request.get(),
+                                         ola::rdm::NR_UNKNOWN_PID));
+  cache.Update(RDMCache::RequestInfo(UNIVERSE, *request), nack);
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_LABEL, &data));
+
+  OLA_ASSERT_EQ(2u, cache.Size());
+  OLA_ASSERT_EQ(2u, export_map.GetCounterVar(RDMCache::HITS_VAR)->Get());
+  OLA_ASSERT_EQ(2, export_map.GetIntegerVar(RDMCache::ENTRIES_VAR)->Get());
+}
+
+
+/*
+ * Check that entries expire.
+ */
+void RDMCacheTest::testExpiry() {
+  RDMCache cache(RDMCache::Options(), NULL, &m_clock);
+  string data;
+
+  std::auto_ptr<RDMRequest> request(NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+  Reply(&cache, *request, "info");
+  request.reset(NewGet(m_uid, ola::rdm::PID_MANUFACTURER_LABEL));
+  Reply(&cache, *request, "manufacturer");
+
+  m_clock.AdvanceTime(RDMCache::DEFAULT_DYNAMIC_TTL + 1, 0);
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                      &data));
+  OLA_ASSERT_EQ(string("manufacturer"), data);
+
+  m_clock.AdvanceTime(RDMCache::DEFAULT_STATIC_TTL, 0);
+  cache.PurgeExpired();
+  OLA_ASSERT_EQ(0u, cache.Size());
+}
+
+
+/*
+ * Check that SETs invalidate the entries for the responders they are sent to.
+ */
+void RDMCacheTest::testSetInvalidates() {
+  RDMCache cache(RDMCache::Options(), NULL, &m_clock);
+  string data;
+
+  const UID uids[] = {m_uid, m_other_uid};
+  for (unsigned int i = 0; i < 2; i++) {
+    std::auto_ptr<RDMRequest> request(
+        NewGet(uids[i], ola::rdm::PID_DEVICE_INFO));
+    Reply(&cache, *request, "info");
+    request.reset(NewGet(uids[i], ola::rdm::PID_MANUFACTURER_LABEL));
+    Reply(&cache, *request, "manufacturer");
+  }
+
+  // A SET of one parameter may change others, but not the static ones.
+  std::auto_ptr<RDMRequest> set(
+      NewSet(m_uid, ola::rdm::PID_DMX_PERSONALITY));
+  cache.Update(RDMCache::RequestInfo(UNIVERSE, *set),
+               RDMReply(ola::rdm::RDM_TIMEOUT));
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                      &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_other_uid, ola::rdm::PID_DEVICE_INFO,
+                      &data));
+
+  // A SET of a static parameter removes it.
+  set.reset(NewSet(m_uid, ola::rdm::PID_MANUFACTURER_LABEL));
+  Reply(&cache, *set, "");
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                       &data));
+
+  // Broadcasts invalidate all the matching responders.
+  set.reset(NewSet(UID::VendorcastAddress(0x7a70),
+                   ola::rdm::PID_DMX_START_ADDRESS));
+  cache.Update(RDMCache::RequestInfo(UNIVERSE, *set),
+               RDMReply(ola::rdm::RDM_WAS_BROADCAST));
+  OLA_ASSERT_FALSE(Get(&cache, m_other_uid, ola::rdm::PID_DEVICE_INFO,
+                       &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_other_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                      &data));
+
+  cache.InvalidateUID(UNIVERSE, m_other_uid);
+  OLA_ASSERT_EQ(0u, cache.Size());
+}
+
+
+/*
+ * Check that queued & status messages invalidate entries.
+ */
+void RDMCacheTest::testQueuedMessages() {
+  RDMCache cache(RDMCache::Options(), NULL, &m_clock);
+  string data;
+
+  std::auto_ptr<RDMRequest> request(NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+  Reply(&cache, *request, "info");
+  request.reset(NewGet(m_uid, ola::rdm::PID_DEVICE_LABEL));
+  Reply(&cache, *request, "label");
+  request.reset(NewGet(m_uid, ola::rdm::PID_MANUFACTURER_LABEL));
+  Reply(&cache, *request, "manufacturer");
+  OLA_ASSERT_EQ(3u, cache.Size());
+
+  // A response with a message count flushes the dynamic entries.
+  request.reset(NewGet(m_uid, ola::rdm::PID_SOFTWARE_VERSION_LABEL));
+  Reply(&cache, *request, "1.0", 1);
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                      &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_SOFTWARE_VERSION_LABEL,
+                      &data));
+
+  // The reply to a GET QUEUED_MESSAGE names the parameter that changed.
+  std::auto_ptr<RDMRequest> queued(
+      NewGet(m_uid, ola::rdm::PID_QUEUED_MESSAGE, string("\x04", 1)));
+  RDMReply reply(
+      ola::rdm::RDM_COMPLETED_OK,
+      ola::rdm::GetResponseWithPid(queued.get(),
+                                   ola::rdm::PID_MANUFACTURER_LABEL,
+                                   NULL, 0));
+  cache.Update(RDMCache::RequestInfo(UNIVERSE, *queued), reply);
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_MANUFACTURER_LABEL,
+                       &data));
+  OLA_ASSERT_EQ(1u, cache.Size());
+
+  // So does a status message.
+  request.reset(NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+  Reply(&cache, *request, "info");
+  request.reset(NewGet(m_uid, ola::rdm::PID_STATUS_MESSAGES,
+                       string("\x04", 1)));
+  Reply(&cache, *request, string(9, '\0'));
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_EQ(1u, cache.Size());
+}
+
+
+/*
+ * Check the cache doesn't grow beyond max_entries.
+ */
+void RDMCacheTest::testMaxEntries() {
+  RDMCache::Options options;
+  options.max_entries = 2;
+  RDMCache cache(options, NULL, &m_clock);
+  string data;
+
+  std::auto_ptr<RDMRequest> request(NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+  Reply(&cache, *request, "info");
+  request.reset(NewGet(m_uid, ola::rdm::PID_MANUFACTURER_LABEL));
+  Reply(&cache, *request, "manufacturer");
+  request.reset(NewGet(m_uid, ola::rdm::PID_DEVICE_MODEL_DESCRIPTION));
+  Reply(&cache, *request, "model");
+  OLA_ASSERT_EQ(2u, cache.Size());
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_MODEL_DESCRIPTION,
+                       &data));
+
+  // Expired entries make way for new ones.
+  m_clock.AdvanceTime(RDMCache::DEFAULT_DYNAMIC_TTL + 1, 0);
+  Reply(&cache, *request, "model");
+  OLA_ASSERT_EQ(2u, cache.Size());
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_MODEL_DESCRIPTION,
+                      &data));
+}
+
+
+/*
+ * Check the static entries survive a Save & Load.
+ */
+void RDMCacheTest::testPersistence() {
+  MemoryPreferences preferences("rdm-cache");
+  string data;
+  const string binary_data("\x00\x01\xff,", 4);
+
+  {
+    RDMCache cache(RDMCache::Options(), NULL, &m_clock);
+    std::auto_ptr<RDMRequest> request(
+        NewGet(m_uid, ola::rdm::PID_DEVICE_INFO));
+    Reply(&cache, *request, "info");
+    request.reset(NewGet(m_uid, ola::rdm::PID_SUPPORTED_PARAMETERS));
+    Reply(&cache, *request, binary_data);
+    request.reset(NewGet(m_other_uid, ola::rdm::PID_PARAMETER_DESCRIPTION,
+                         string("\x80\x00", 2)));
+    Reply(&cache, *request, "description");
+    cache.Save(&preferences);
+  }
+  OLA_ASSERT_EQ(static_cast<size_t>(2),
+                preferences.GetMultipleValue(RDMCache::ENTRY_KEY).size());
+
+  preferences.SetMultipleValue(RDMCache::ENTRY_KEY, "foo,bar");
+
+  RDMCache cache(RDMCache::Options(), NULL, &m_clock);
+  cache.Load(preferences);
+  OLA_ASSERT_EQ(2u, cache.Size());
+  OLA_ASSERT_FALSE(Get(&cache, m_uid, ola::rdm::PID_DEVICE_INFO, &data));
+  OLA_ASSERT_TRUE(Get(&cache, m_uid, ola::rdm::PID_SUPPORTED_PARAMETERS,
+                      &data));
+  OLA_ASSERT_EQ(binary_data, data);
+  OLA_ASSERT_TRUE(Get(&cache, m_other_uid,
+                      ola::rdm::PID_PARAMETER_DESCRIPTION, &data,
+                      string("\x80\x00", 2)));
+  OLA_ASSERT_EQ(string("description"), data);
+
+  // Saving again replaces the old entries.
+  cache.Save(&preferences);
+  OLA_ASSERT_EQ(static_cast<size_t>(2),
+                preferences.GetMultipleValue(RDMCache::ENTRY_KEY).size());
+
+  // Expired entries aren't loaded.
+  m_clock.AdvanceTime(RDMCache::DEFAULT_STATIC_TTL + 1, 0);
+  RDMCache expired_cache(RDMCache::Options(), NULL, &m_clock);
+  expired_cache.Load(preferences);
+  OLA_ASSERT_EQ(0u, expired_cache.Size());
+}
@@ -42,6 +42,7 @@
 #include "ola/thread/Mutex.h"
 #include "ola/web/Json.h"
 #include "ola/web/JsonSections.h"
+#include "ola/web/JsonStreamWriter.h"
 #include "olad/OlaServer.h"
 #include "olad/OladHTTPServer.h"
 #include "olad/RDMHTTPModule.h"
@@ -59,9 +60,8 @@ using ola::thread::MutexLocker;
 using ola::web::BoolItem;
 using ola::web::GenericItem;
 using ola::web::HiddenItem;
-using ola::web::JsonArray;
-using ola::web::JsonObject;
 using ola::web::JsonSection;
+using ola::web::JsonStreamWriter;
 using ola::web::SelectItem;
 using ola::web::StringItem;
 using ola::web::UIntItem;
@@ -165,6 +165,9 @@ RDMHTTPModule::RDMHTTPModule(HTTPServer *http_server,
       m_shim(client),
       m_rdm_api(&m_shim),
       m_pid_store(NULL) {
+  // Most of the parameters the UI shows rarely change, so let olad answer
+  // from its cache. SETs invalidate the cached values.
+  m_shim.SetCacheFirst(true);
 
   m_server->RegisterHandler(
       "/rdm/run_discovery",
@@ -713,9 +716,10 @@ void RDMHTTPModule::HandleUIDList(HTTPResponse *response,
        uid_iter != uid_state->resolved_uids.end(); ++uid_iter)
     uid_iter->second.active = false;
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("universe", universe_id);
-  JsonArray *json_uids = json.AddArray("uids");
+  json.StartArray("uids");
 
   for (; iter != uids.End(); ++iter) {
     uid_iter = uid_state->resolved_uids.find(*iter);
@@ -736,17 +740,20 @@ void RDMHTTPModule::HandleUIDList(HTTPResponse *response,
       uid_iter->second.active = true;
     }
 
-    JsonObject *json_uid = json_uids->AppendObject();
-    json_uid->Add("manufacturer_id", iter->ManufacturerId());
-    json_uid->Add("device_id", iter->DeviceId());
-    json_uid->Add("device", device);
-    json_uid->Add("manufacturer", manufacturer);
-    json_uid->Add("uid", iter->ToString());
+    json.StartObject();
+    json.Add("manufacturer_id", iter->ManufacturerId());
+    json.Add("device_id", iter->DeviceId());
+    json.Add("device", device);
+    json.Add("manufacturer", manufacturer);
+    json.Add("uid", iter->ToString());
+    json.EndObject();
   }
+  json.EndArray();
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 
   // remove any old UIDs
@@ -913,16 +920,18 @@ void RDMHTTPModule::UIDInfoHandler(HTTPResponse *response,
     return;
   }
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("error", "");
   json.Add("address", device.dmx_start_address);
   json.Add("footprint", device.dmx_footprint);
   json.Add("personality", static_cast<int>(device.current_personality));
   json.Add("personality_count", static_cast<int>(device.personality_count));
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -938,13 +947,15 @@ void RDMHTTPModule::UIDIdentifyDeviceHandler(
     return;
   }
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("error", "");
   json.Add("identify_device", value);
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -954,25 +965,29 @@ void RDMHTTPModule::UIDIdentifyDeviceHandler(
  */
 void RDMHTTPModule::SendPersonalityResponse(HTTPResponse *response,
                                             personality_info *info) {
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("error", "");
-  JsonArray *personalities = json.AddArray("personalities");
+  json.StartArray("personalities");
 
   unsigned int i = 1;
   while (i <= info->total && i <= info->personalities.size()) {
     if (info->personalities[i - 1].first != INVALID_PERSONALITY) {
-      JsonObject *personality = personalities->AppendObject();
-      personality->Add("name", info->personalities[i - 1].second);
-      personality->Add("index", i);
-      personality->Add("footprint", info->personalities[i - 1].first);
+      json.StartObject();
+      json.Add("name", info->personalities[i - 1].second);
+      json.Add("index", i);
+      json.Add("footprint", info->personalities[i - 1].first);
+      json.EndObject();
     }
     i++;
   }
+  json.EndArray();
   json.Add("selected", info->active);
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete info->uid;
   delete info;
 }
@@ -985,17 +1000,20 @@ void RDMHTTPModule::SupportedParamsHandler(
     HTTPResponse *response,
     const ola::rdm::ResponseStatus &status,
     const vector<uint16_t> &pids) {
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   if (CheckForRDMSuccess(status)) {
-    JsonArray *pids_json = json.AddArray("pids");
+    json.StartArray("pids");
     vector<uint16_t>::const_iterator iter = pids.begin();
     for (; iter != pids.end(); ++iter)
-      pids_json->Append(*iter);
+      json.Value(static_cast<unsigned int>(*iter));
+    json.EndArray();
   }
+  json.EndObject();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -1180,18 +1198,21 @@ void RDMHTTPModule::SupportedSectionsDeviceInfoHandler(
 
   sort(sections.begin(), sections.end(), lt_section_info());
 
-  JsonArray json;
+  JsonStreamWriter json(response->Body());
+  json.StartArray();
   vector<section_info>::const_iterator section_iter = sections.begin();
   for (; section_iter != sections.end(); ++section_iter) {
-    JsonObject *json_obj = json.AppendObject();
-    json_obj->Add("id", section_iter->id);
-    json_obj->Add("name", section_iter->name);
-    json_obj->Add("hint",  section_iter->hint);
+    json.StartObject();
+    json.Add("id", section_iter->id);
+    json.Add("name", section_iter->name);
+    json.Add("hint",  section_iter->hint);
+    json.EndObject();
   }
+  json.EndArray();
 
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->SendJson(json);
+  response->Send();
   delete response;
 }
 
@@ -3438,9 +3459,11 @@ int RDMHTTPModule::RespondWithError(HTTPResponse *response,
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
 
-  JsonObject json;
+  JsonStreamWriter json(response->Body());
+  json.StartObject();
   json.Add("error", error);
-  int r = response->SendJson(json);
+  json.EndObject();
+  int r = response->Send();
   delete response;
   return r;
 }
@@ -3453,7 +3476,8 @@ void RDMHTTPModule::RespondWithSection(HTTPResponse *response,
                                        const ola::web::JsonSection &section) {
   response->SetNoCache();
   response->SetContentType(HTTPServer::CONTENT_TYPE_PLAIN);
-  response->Append(section.AsString());
+  JsonStreamWriter json(response->Body());
+  section.Write(&json);
   response->Send();
   delete response;
 }
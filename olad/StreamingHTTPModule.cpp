@@ -0,0 +1,462 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * StreamingHTTPModule.cpp
+ * Pushes live DMX and universe changes to HTTP clients.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ola/Callback.h"
+#include "ola/Logging.h"
+#include "ola/StringUtils.h"
+#include "ola/web/Json.h"
+#include "ola/web/JsonWriter.h"
+#include "olad/StreamingHTTPModule.h"
+
+namespace ola {
+
+using ola::client::OlaInputPort;
+using ola::client::OlaOutputPort;
+using ola::client::OlaUniverse;
+using ola::http::HTTPEventStream;
+using ola::http::HTTPRequest;
+using ola::http::HTTPResponse;
+using ola::http::HTTPServer;
+using ola::thread::INVALID_TIMEOUT;
+using ola::web::JsonArray;
+using ola::web::JsonObject;
+using ola::web::JsonWriter;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+const unsigned int StreamingHTTPModule::DEFAULT_RATE;
+const unsigned int StreamingHTTPModule::MAX_RATE;
+
+namespace {
+template <typename PortClass>
+void PortsToJson(JsonArray *json, const vector<PortClass> &ports) {
+  typename vector<PortClass>::const_iterator iter = ports.begin();
+  for (; iter != ports.end(); ++iter) {
+    JsonObject *port = json->AppendObject();
+    port->Add("id", iter->Id());
+    port->Add("description", iter->Description());
+    port->Add("active", iter->IsActive());
+  }
+}
+}  // namespace
+
+
+StreamingHTTPModule::StreamingHTTPModule(HTTPServer *http_server,
+                                         client::OlaClient *client)
+    : m_server(http_server),
+      m_client(client),
+      m_event_streams(0),
+      m_universe_poll(INVALID_TIMEOUT) {
+  m_server->RegisterHandler(
+      "/stream",
+      NewCallback(this, &StreamingHTTPModule::StartStream));
+  m_client->SetDMXCallback(NewCallback(this, &StreamingHTTPModule::NewDmx));
+}
+
+
+/*
+ * The streams outlive us, they're deleted when the HTTP server closes the
+ * connections.
+ */
+StreamingHTTPModule::~StreamingHTTPModule() {
+  StopUniversePoll();
+  m_client->SetDMXCallback(NULL);
+
+  StreamSet::iterator iter = m_streams.begin();
+  for (; iter != m_streams.end(); ++iter) {
+    (*iter)->stream->SetOnClose(NULL);
+    (*iter)->stream->Close();
+    m_server->SelectServer()->RemoveTimeout((*iter)->timeout);
+    delete *iter;
+  }
+  m_streams.clear();
+}
+
+
+/**
+ * @brief Start a new event stream.
+ */
+int StreamingHTTPModule::StartStream(const HTTPRequest *request,
+                                     HTTPResponse *response) {
+  if (request->CheckParameterExists("help")) {
+    response->SetContentType(HTTPServer::CONTENT_TYPE_HTML);
+    response->Append("<b>Usage:</b><p>?u=[universe,universe...]"
+                     "&rate=[max updates per second]&events=[0|1]</p>");
+    int r = response->Send();
+    delete response;
+    return r;
+  }
+
+  std::set<unsigned int> universes;
+  unsigned int rate;
+  bool events;
+  string error;
+  if (!ParseOptions(request->GetParameter("u"),
+                    request->GetParameter("rate"),
+                    request->GetParameter("events"),
+                    &universes, &rate, &events, &error)) {
+    return m_server->ServeError(response, error);
+  }
+
+  StreamState *state = AddStream(universes, rate, events);
+  int r = response->SendEventStream(state->stream);
+  delete response;
+  return r;
+}
+
+
+/*
+ * Set up the state for a new stream.
+ */
+StreamingHTTPModule::StreamState *StreamingHTTPModule::AddStream(
+    const std::set<unsigned int> &universes,
+    unsigned int rate,
+    bool events) {
+  StreamState *state = new StreamState();
+  state->stream = new HTTPEventStream(
+      NewSingleCallback(this, &StreamingHTTPModule::StreamClosed, state));
+  state->events = events;
+  state->idle_ticks = 0;
+  state->keepalive_ticks = KEEPALIVE_INTERVAL_S * rate;
+  state->timeout = m_server->SelectServer()->RegisterRepeatingTimeout(
+      1000 / rate,
+      NewCallback(this, &StreamingHTTPModule::SendUpdates, state));
+  m_streams.insert(state);
+
+  std::set<unsigned int>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    // An empty frame, so the first update sends everything.
+    state->sent_frames[*iter] = DmxBuffer();
+    Subscribe(*iter);
+  }
+
+  if (events) {
+    m_event_streams++;
+    if (m_universe_poll == INVALID_TIMEOUT) {
+      StartUniversePoll();
+    } else {
+      UniverseInfoMap::const_iterator info_iter = m_universe_info.begin();
+      for (; info_iter != m_universe_info.end(); ++info_iter) {
+        state->stream->SendEvent("universe", info_iter->second);
+      }
+    }
+  }
+  return state;
+}
+
+
+/*
+ * Called when the HTTP server closes the connection.
+ */
+void StreamingHTTPModule::StreamClosed(StreamState *state) {
+  m_server->SelectServer()->RemoveTimeout(state->timeout);
+  m_streams.erase(state);
+
+  FrameMap::const_iterator iter = state->sent_frames.begin();
+  for (; iter != state->sent_frames.end(); ++iter) {
+    Unsubscribe(iter->first);
+  }
+
+  if (state->events && --m_event_streams == 0) {
+    StopUniversePoll();
+  }
+  delete state;
+}
+
+
+/*
+ * Send the universes that have changed since the last update.
+ */
+bool StreamingHTTPModule::SendUpdates(StreamState *state) {
+  if (state->stream->PendingBytes()) {
+    // The client hasn't received the last update yet, skip this one so
+    // changes are coalesced rather than queued.
+    return true;
+  }
+
+  bool sent = false;
+  FrameMap::iterator iter = state->sent_frames.begin();
+  for (; iter != state->sent_frames.end(); ++iter) {
+    UniverseMap::const_iterator universe_iter = m_universes.find(iter->first);
+    if (universe_iter == m_universes.end()) {
+      continue;
+    }
+    const DmxBuffer &latest = universe_iter->second.latest;
+    if (latest == iter->second) {
+      continue;
+    }
+
+    string full = FrameEvent(iter->first, latest);
+    if (iter->second.Size() == latest.Size()) {
+      string delta = DeltaEvent(iter->first, iter->second, latest);
+      if (delta.size() < full.size()) {
+        state->stream->SendEvent("dmx_delta", delta);
+      } else {
+        state->stream->SendEvent("dmx", full);
+      }
+    } else {
+      state->stream->SendEvent("dmx", full);
+    }
+    iter->second = latest;
+    sent = true;
+  }
+
+  if (sent) {
+    state->idle_ticks = 0;
+  } else if (++state->idle_ticks >= state->keepalive_ticks) {
+    state->stream->SendComment("keepalive");
+    state->idle_ticks = 0;
+  }
+  return true;
+}
+
+
+void StreamingHTTPModule::Subscribe(unsigned int universe) {
+  UniverseState &state = m_universes[universe];
+  if (state.streams++ == 0) {
+    m_client->RegisterUniverse(
+        universe, ola::client::REGISTER,
+        NewSingleCallback(this, &StreamingHTTPModule::RegisterComplete,
+                          universe));
+  }
+}
+
+
+void StreamingHTTPModule::Unsubscribe(unsigned int universe) {
+  UniverseMap::iterator iter = m_universes.find(universe);
+  if (iter == m_universes.end() || --iter->second.streams) {
+    return;
+  }
+  m_universes.erase(iter);
+  m_client->RegisterUniverse(
+      universe, ola::client::UNREGISTER,
+      NewSingleCallback(this, &StreamingHTTPModule::RegisterComplete,
+                        universe));
+}
+
+
+void StreamingHTTPModule::RegisterComplete(unsigned int universe,
+                                           const client::Result &result) {
+  if (!result.Success()) {
+    OLA_WARN << "Failed to (un)register for universe " << universe << ": "
+             << result.Error();
+  }
+}
+
+
+void StreamingHTTPModule::NewDmx(const client::DMXMetadata &metadata,
+                                 const DmxBuffer &data) {
+  UniverseMap::iterator iter = m_universes.find(metadata.universe);
+  if (iter != m_universes.end()) {
+    iter->second.latest = data;
+  }
+}
+
+
+void StreamingHTTPModule::StartUniversePoll() {
+  m_universe_poll = m_server->SelectServer()->RegisterRepeatingTimeout(
+      UNIVERSE_POLL_INTERVAL_MS,
+      NewCallback(this, &StreamingHTTPModule::PollUniverses));
+  PollUniverses();
+}
+
+
+void StreamingHTTPModule::StopUniversePoll() {
+  if (m_universe_poll != INVALID_TIMEOUT) {
+    m_server->SelectServer()->RemoveTimeout(m_universe_poll);
+    m_universe_poll = INVALID_TIMEOUT;
+  }
+  // The next client to ask for events will get the full list.
+  m_universe_info.clear();
+}
+
+
+bool StreamingHTTPModule::PollUniverses() {
+  m_client->FetchUniverseList(
+      NewSingleCallback(this, &StreamingHTTPModule::UniverseListReceived));
+  return true;
+}
+
+
+/*
+ * Send events for the universes that have changed since the last poll.
+ */
+void StreamingHTTPModule::UniverseListReceived(
+    const client::Result &result,
+    const vector<OlaUniverse> &universes) {
+  if (!result.Success() || m_universe_poll == INVALID_TIMEOUT) {
+    return;
+  }
+
+  UniverseInfoMap current;
+  vector<OlaUniverse>::const_iterator iter = universes.begin();
+  for (; iter != universes.end(); ++iter) {
+    const string info = UniverseInfo(*iter);
+    current[iter->Id()] = info;
+
+    UniverseInfoMap::const_iterator old_iter = m_universe_info.find(
+        iter->Id());
+    if (old_iter == m_universe_info.end() || old_iter->second != info) {
+      SendToEventStreams("universe", info);
+    }
+  }
+
+  UniverseInfoMap::const_iterator old_iter = m_universe_info.begin();
+  for (; old_iter != m_universe_info.end(); ++old_iter) {
+    if (current.find(old_iter->first) == current.end()) {
+      ostringstream str;
+      str << "{\"id\": " << old_iter->first << "}";
+      SendToEventStreams("universe_removed", str.str());
+    }
+  }
+  m_universe_info.swap(current);
+}
+
+
+void StreamingHTTPModule::SendToEventStreams(const string &event,
+                                             const string &data) {
+  StreamSet::iterator iter = m_streams.begin();
+  for (; iter != m_streams.end(); ++iter) {
+    if ((*iter)->events && !(*iter)->stream->SendEvent(event, data)) {
+      OLA_INFO << "Dropped " << event << " event for a slow client";
+    }
+  }
+}
+
+
+/*
+ * Parse the u, rate and events parameters of a /stream request.
+ */
+bool StreamingHTTPModule::ParseOptions(const string &universes_str,
+                                       const string &rate_str,
+                                       const string &events_str,
+                                       std::set<unsigned int> *universes,
+                                       unsigned int *rate,
+                                       bool *events,
+                                       string *error) {
+  vector<string> tokens;
+  StringSplit(universes_str, &tokens, ",");
+  vector<string>::const_iterator iter = tokens.begin();
+  for (; iter != tokens.end(); ++iter) {
+    if (iter->empty()) {
+      continue;
+    }
+    unsigned int universe;
+    if (!StringToInt(*iter, &universe)) {
+      *error = "Invalid universe " + *iter;
+      return false;
+    }
+    universes->insert(universe);
+  }
+
+  *rate = DEFAULT_RATE;
+  if (!rate_str.empty() && (!StringToInt(rate_str, rate) || *rate == 0)) {
+    *error = "Invalid rate " + rate_str;
+    return false;
+  }
+  *rate = std::min(*rate, MAX_RATE);
+
+  *events = events_str == "1";
+  if (universes->empty() && !*events) {
+    *error = "Nothing to stream";
+    return false;
+  }
+  return true;
+}
+
+
+/*
+ * {"universe": 1, "dmx": [0, 0, 255, ...]}
+ */
+string StreamingHTTPModule::FrameEvent(unsigned int universe,
+                                       const DmxBuffer &data) {
+  // As with /get_dmx, building 512 JsonValues is too slow, so use raw output.
+  ostringstream str;
+  str << "{\"universe\": " << universe << ", \"dmx\": [" << data.ToString()
+      << "]}";
+  return str.str();
+}
+
+
+/*
+ * {"universe": 1, "changes": [[10, 255, 0], [100, 7]]}
+ * The first value of each run is the offset of the slot it starts at.
+ */
+string StreamingHTTPModule::DeltaEvent(unsigned int universe,
+                                       const DmxBuffer &old_data,
+                                       const DmxBuffer &new_data) {
+  ostringstream str;
+  str << "{\"universe\": " << universe << ", \"changes\": [";
+
+  const unsigned int size = new_data.Size();
+  bool first_run = true;
+  unsigned int slot = 0;
+  while (slot < size) {
+    if (old_data.Get(slot) == new_data.Get(slot)) {
+      slot++;
+      continue;
+    }
+
+    // Extend the run until there are more than DELTA_MERGE_GAP unchanged
+    // slots in a row, since starting a new run costs more than that.
+    unsigned int end = slot + 1;
+    unsigned int unchanged = 0;
+    for (unsigned int i = end; i < size && unchanged <= DELTA_MERGE_GAP;
+         i++) {
+      if (old_data.Get(i) == new_data.Get(i)) {
+        unchanged++;
+      } else {
+        unchanged = 0;
+        end = i + 1;
+      }
+    }
+
+    str << (first_run ? "[" : ", [") << slot;
+    for (; slot < end; slot++) {
+      str << "," << static_cast<int>(new_data.Get(slot));
+    }
+    str << "]";
+    first_run = false;
+  }
+  str << "]}";
+  return str.str();
+}
+
+
+string StreamingHTTPModule::UniverseInfo(const OlaUniverse &universe) {
+  JsonObject json;
+  json.Add("id", universe.Id());
+  json.Add("name", universe.Name());
+  json.Add("merge_mode",
+           universe.MergeMode() == OlaUniverse::MERGE_HTP ? "HTP" : "LTP");
+  json.Add("rdm_devices", universe.RDMDeviceCount());
+  PortsToJson(json.AddArray("input_ports"), universe.InputPorts());
+  PortsToJson(json.AddArray("output_ports"), universe.OutputPorts());
+  return JsonWriter::AsString(json);
+}
+}  // namespace ola
@@ -0,0 +1,142 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * StreamingHTTPModule.h
+ * Pushes live DMX and universe changes to HTTP clients.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef OLAD_STREAMINGHTTPMODULE_H_
+#define OLAD_STREAMINGHTTPMODULE_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "ola/DmxBuffer.h"
+#include "ola/base/Macro.h"
+#include "ola/client/OlaClient.h"
+#include "ola/http/HTTPServer.h"
+#include "ola/thread/SchedulerInterface.h"
+
+namespace ola {
+
+/**
+ * @brief Streams DMX data and universe changes using Server-Sent Events.
+ *
+ * Rather than polling /get_dmx, a client opens a single /stream request, e.g.
+ * /stream?u=1,2&rate=10&events=1, and receives:
+ *  - a dmx event with the full frame the first time each universe is sent,
+ *  - dmx_delta events with just the slots that changed after that,
+ *  - universe and universe_removed events when a universe, its ports or the
+ *    number of RDM devices change, if events=1.
+ *
+ * DMX is sent at most rate times a second per universe, and only if it has
+ * changed. If a client can't keep up, frames are coalesced rather than queued.
+ *
+ * The module registers for each universe once, no matter how many clients
+ * are watching it, and one universe list request a second is shared by all
+ * the clients that want events.
+ */
+class StreamingHTTPModule {
+ public:
+  StreamingHTTPModule(ola::http::HTTPServer *http_server,
+                      ola::client::OlaClient *client);
+  ~StreamingHTTPModule();
+
+  int StartStream(const ola::http::HTTPRequest *request,
+                  ola::http::HTTPResponse *response);
+
+  static const unsigned int DEFAULT_RATE = 10;
+  // DMX can't be refreshed faster than this.
+  static const unsigned int MAX_RATE = 44;
+
+ private:
+  typedef std::map<unsigned int, DmxBuffer> FrameMap;
+
+  struct StreamState {
+    ola::http::HTTPEventStream *stream;
+    FrameMap sent_frames;  // The last frame sent, for each universe.
+    bool events;
+    unsigned int idle_ticks;
+    unsigned int keepalive_ticks;
+    ola::thread::timeout_id timeout;
+  };
+
+  struct UniverseState {
+    UniverseState() : streams(0) {}
+
+    DmxBuffer latest;
+    unsigned int streams;
+  };
+
+  typedef std::set<StreamState*> StreamSet;
+  typedef std::map<unsigned int, UniverseState> UniverseMap;
+  typedef std::map<unsigned int, std::string> UniverseInfoMap;
+
+  ola::http::HTTPServer *m_server;
+  ola::client::OlaClient *m_client;
+  StreamSet m_streams;
+  UniverseMap m_universes;
+  unsigned int m_event_streams;
+  ola::thread::timeout_id m_universe_poll;
+  UniverseInfoMap m_universe_info;  // The last universe event sent.
+
+  StreamState *AddStream(const std::set<unsigned int> &universes,
+                         unsigned int rate,
+                         bool events);
+  void StreamClosed(StreamState *state);
+  bool SendUpdates(StreamState *state);
+
+  void Subscribe(unsigned int universe);
+  void Unsubscribe(unsigned int universe);
+  void RegisterComplete(unsigned int universe,
+                        const ola::client::Result &result);
+  void NewDmx(const ola::client::DMXMetadata &metadata,
+              const DmxBuffer &data);
+
+  void StartUniversePoll();
+  void StopUniversePoll();
+  bool PollUniverses();
+  void UniverseListReceived(
+      const ola::client::Result &result,
+      const std::vector<ola::client::OlaUniverse> &universes);
+  void SendToEventStreams(const std::string &event, const std::string &data);
+
+  static bool ParseOptions(const std::string &universes_str,
+                           const std::string &rate_str,
+                           const std::string &events_str,
+                           std::set<unsigned int> *universes,
+                           unsigned int *rate,
+                           bool *events,
+                           std::string *error);
+  static std::string FrameEvent(unsigned int universe, const DmxBuffer &data);
+  static std::string DeltaEvent(unsigned int universe,
+                                const DmxBuffer &old_data,
+                                const DmxBuffer &new_data);
+  static std::string UniverseInfo(const ola::client::OlaUniverse &universe);
+
+  // Send a comment if nothing else has been sent for this long.
+  static const unsigned int KEEPALIVE_INTERVAL_S = 15;
+  static const unsigned int UNIVERSE_POLL_INTERVAL_MS = 1000;
+  // Changed slots this close together are sent as a single run.
+  static const unsigned int DELTA_MERGE_GAP = 3;
+
+  friend class StreamingHTTPModuleTest;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamingHTTPModule);
+};
+}  // namespace ola
+#endif  // OLAD_STREAMINGHTTPMODULE_H_
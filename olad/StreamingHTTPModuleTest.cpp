@@ -0,0 +1,522 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * StreamingHTTPModuleTest.cpp
+ * Test fixture for the StreamingHTTPModule class.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ola/DmxBuffer.h"
+#include "ola/StringUtils.h"
+#include "ola/client/ClientTypes.h"
+#include "ola/client/OlaClient.h"
+#include "ola/client/Result.h"
+#include "ola/http/HTTPServer.h"
+#include "ola/io/Descriptor.h"
+#include "ola/testing/TestUtils.h"
+#include "olad/StreamingHTTPModule.h"
+
+namespace ola {
+
+using ola::client::DMXMetadata;
+using ola::client::OlaClient;
+using ola::client::OlaInputPort;
+using ola::client::OlaOutputPort;
+using ola::client::OlaUniverse;
+using ola::client::Result;
+using ola::http::HTTPEventStream;
+using ola::http::HTTPServer;
+using ola::io::LoopbackDescriptor;
+using std::auto_ptr;
+using std::set;
+using std::string;
+using std::vector;
+
+
+class StreamingHTTPModuleTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(StreamingHTTPModuleTest);
+  CPPUNIT_TEST(testParseOptions);
+  CPPUNIT_TEST(testFrameEvent);
+  CPPUNIT_TEST(testDeltaEvent);
+  CPPUNIT_TEST(testUpdates);
+  CPPUNIT_TEST(testKeepalive);
+  CPPUNIT_TEST(testUniverseEvents);
+  CPPUNIT_TEST(testStreamClosed);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void tearDown();
+
+  void testParseOptions();
+  void testFrameEvent();
+  void testDeltaEvent();
+  void testUpdates();
+  void testKeepalive();
+  void testUniverseEvents();
+  void testStreamClosed();
+
+ private:
+  auto_ptr<LoopbackDescriptor> m_descriptor;
+  // The client is never connected, so requests fail straight away.
+  auto_ptr<OlaClient> m_client;
+  auto_ptr<HTTPServer> m_server;
+  auto_ptr<StreamingHTTPModule> m_module;
+
+  HTTPEventStream *AddStream(const set<unsigned int> &universes,
+                             unsigned int rate,
+                             bool events);
+  bool SendUpdates(HTTPEventStream *stream);
+  void NewDmx(unsigned int universe, const DmxBuffer &data);
+  void CloseStreams();
+  static string ReadAll(HTTPEventStream *stream);
+  static string UniverseEvent(const OlaUniverse &universe);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StreamingHTTPModuleTest);
+
+
+void StreamingHTTPModuleTest::setUp() {
+  m_descriptor.reset(new LoopbackDescriptor());
+  m_client.reset(new OlaClient(m_descriptor.get()));
+  ola::http::HTTPServer::HTTPServerOptions options;
+  m_server.reset(new HTTPServer(options));
+  m_module.reset(new StreamingHTTPModule(m_server.get(), m_client.get()));
+}
+
+
+void StreamingHTTPModuleTest::tearDown() {
+  CloseStreams();
+  m_module.reset();
+  m_server.reset();
+  m_client.reset();
+  m_descriptor.reset();
+}
+
+
+/*
+ * Start a stream, the way StartStream() does.
+ */
+HTTPEventStream *StreamingHTTPModuleTest::AddStream(
+    const set<unsigned int> &universes,
+    unsigned int rate,
+    bool events) {
+  return m_module->AddStream(universes, rate, events)->stream;
+}
+
+
+/*
+ * Run the update timeout for a stream.
+ */
+bool StreamingHTTPModuleTest::SendUpdates(HTTPEventStream *stream) {
+  StreamingHTTPModule::StreamSet::iterator iter = m_module->m_streams.begin();
+  for (; iter != m_module->m_streams.end(); ++iter) {
+    if ((*iter)->stream == stream) {
+      return m_module->SendUpdates(*iter);
+    }
+  }
+  OLA_FAIL("Unknown stream");
+  return false;
+}
+
+
+void StreamingHTTPModuleTest::NewDmx(unsigned int universe,
+                                     const DmxBuffer &data) {
+  m_module->NewDmx(DMXMetadata(universe), data);
+}
+
+
+/*
+ * Close the remaining streams, as libmicrohttpd would when the clients go
+ * away.
+ */
+void StreamingHTTPModuleTest::CloseStreams() {
+  while (!m_module->m_streams.empty()) {
+    (*m_module->m_streams.begin())->stream->ConnectionClosed();
+  }
+}
+
+
+string StreamingHTTPModuleTest::ReadAll(HTTPEventStream *stream) {
+  string output;
+  char buffer[1024];
+  ssize_t r;
+  while ((r = stream->Read(buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, r);
+  }
+  return output;
+}
+
+
+/*
+ * The universe event for a universe, the JSON is split over several lines.
+ */
+string StreamingHTTPModuleTest::UniverseEvent(const OlaUniverse &universe) {
+  string data = StreamingHTTPModule::UniverseInfo(universe);
+  ReplaceAll(&data, "\n", "\ndata: ");
+  return "event: universe\ndata: " + data + "\n\n";
+}
+
+
+/*
+ * Check the u, rate and events parameters.
+ */
+void StreamingHTTPModuleTest::testParseOptions() {
+  set<unsigned int> universes;
+  unsigned int rate = 0;
+  bool events = true;
+  string error;
+
+  OLA_ASSERT_TRUE(StreamingHTTPModule::ParseOptions(
+      "1", "", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(static_cast<size_t>(1), universes.size());
+  OLA_ASSERT_EQ(1u, *universes.begin());
+  OLA_ASSERT_EQ(StreamingHTTPModule::DEFAULT_RATE, rate);
+  OLA_ASSERT_FALSE(events);
+
+  // Duplicates and empty tokens are ignored.
+  universes.clear();
+  OLA_ASSERT_TRUE(StreamingHTTPModule::ParseOptions(
+      "3,,1,3,", "5", "1", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(static_cast<size_t>(2), universes.size());
+  OLA_ASSERT_EQ(1u, *universes.begin());
+  OLA_ASSERT_EQ(3u, *universes.rbegin());
+  OLA_ASSERT_EQ(5u, rate);
+  OLA_ASSERT_TRUE(events);
+
+  // Events on their own are fine.
+  universes.clear();
+  OLA_ASSERT_TRUE(StreamingHTTPModule::ParseOptions(
+      "", "", "1", &universes, &rate, &events, &error));
+  OLA_ASSERT_TRUE(universes.empty());
+  OLA_ASSERT_TRUE(events);
+
+  // The rate is capped.
+  universes.clear();
+  OLA_ASSERT_TRUE(StreamingHTTPModule::ParseOptions(
+      "1", "1000", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(StreamingHTTPModule::MAX_RATE, rate);
+
+  // Only 1 turns events on.
+  universes.clear();
+  OLA_ASSERT_TRUE(StreamingHTTPModule::ParseOptions(
+      "1", "", "true", &universes, &rate, &events, &error));
+  OLA_ASSERT_FALSE(events);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      "1,foo", "", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Invalid universe foo"), error);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      "-1", "", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Invalid universe -1"), error);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      "1", "0", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Invalid rate 0"), error);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      "1", "fast", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Invalid rate fast"), error);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      "", "", "0", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Nothing to stream"), error);
+
+  universes.clear();
+  OLA_ASSERT_FALSE(StreamingHTTPModule::ParseOptions(
+      ",", "", "", &universes, &rate, &events, &error));
+  OLA_ASSERT_EQ(string("Nothing to stream"), error);
+}
+
+
+/*
+ * Check the full frame encoding.
+ */
+void StreamingHTTPModuleTest::testFrameEvent() {
+  DmxBuffer buffer;
+  OLA_ASSERT_EQ(string("{\"universe\": 1, \"dmx\": []}"),
+                StreamingHTTPModule::FrameEvent(1, buffer));
+
+  buffer.SetFromString("0,128,255");
+  OLA_ASSERT_EQ(string("{\"universe\": 42, \"dmx\": [0,128,255]}"),
+                StreamingHTTPModule::FrameEvent(42, buffer));
+}
+
+
+/*
+ * Check the delta encoding, and how runs are merged.
+ */
+void StreamingHTTPModuleTest::testDeltaEvent() {
+  DmxBuffer old_data;
+  old_data.Blackout();
+
+  // Nothing changed.
+  OLA_ASSERT_EQ(string("{\"universe\": 1, \"changes\": []}"),
+                StreamingHTTPModule::DeltaEvent(1, old_data, old_data));
+
+  // A single slot, at each end of the frame.
+  DmxBuffer new_data(old_data);
+  new_data.SetChannel(0, 10);
+  new_data.SetChannel(511, 20);
+  OLA_ASSERT_EQ(string("{\"universe\": 1, \"changes\": [[0,10], [511,20]]}"),
+                StreamingHTTPModule::DeltaEvent(1, old_data, new_data));
+
+  // DELTA_MERGE_GAP unchanged slots are sent as part of the run.
+  new_data = old_data;
+  new_data.SetChannel(10, 1);
+  new_data.SetChannel(14, 2);
+  OLA_ASSERT_EQ(
+      string("{\"universe\": 2, \"changes\": [[10,1,0,0,0,2]]}"),
+      StreamingHTTPModule::DeltaEvent(2, old_data, new_data));
+
+  // But one more starts a new run.
+  new_data = old_data;
+  new_data.SetChannel(10, 1);
+  new_data.SetChannel(15, 2);
+  OLA_ASSERT_EQ(
+      string("{\"universe\": 2, \"changes\": [[10,1], [15,2]]}"),
+      StreamingHTTPModule::DeltaEvent(2, old_data, new_data));
+
+  // Trailing unchanged slots aren't included.
+  new_data = old_data;
+  new_data.SetChannel(100, 5);
+  new_data.SetChannel(101, 6);
+  new_data.SetChannel(103, 7);
+  OLA_ASSERT_EQ(
+      string("{\"universe\": 3, \"changes\": [[100,5,6,0,7]]}"),
+      StreamingHTTPModule::DeltaEvent(3, old_data, new_data));
+}
+
+
+/*
+ * Check full frames, deltas and coalescing.
+ */
+void StreamingHTTPModuleTest::testUpdates() {
+  set<unsigned int> universes;
+  universes.insert(1);
+  universes.insert(2);
+  HTTPEventStream *stream = AddStream(universes, 10, false);
+  OLA_ASSERT_EQ(static_cast<size_t>(2), m_module->m_universes.size());
+
+  // No DMX yet.
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+
+  // DMX for a universe no one is watching is ignored.
+  DmxBuffer frame;
+  frame.Blackout();
+  NewDmx(3, frame);
+  OLA_ASSERT_EQ(static_cast<size_t>(2), m_module->m_universes.size());
+
+  // The first frame is sent in full.
+  NewDmx(1, frame);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ("event: dmx\ndata: " +
+                StreamingHTTPModule::FrameEvent(1, frame) + "\n\n",
+                ReadAll(stream));
+
+  // The same frame again isn't sent.
+  NewDmx(1, frame);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+
+  // A small change is sent as a delta.
+  DmxBuffer changed(frame);
+  changed.SetChannel(5, 255);
+  NewDmx(1, changed);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ(
+      string("event: dmx_delta\n"
+             "data: {\"universe\": 1, \"changes\": [[5,255]]}\n\n"),
+      ReadAll(stream));
+
+  // If the client hasn't read the last update, new frames are coalesced.
+  DmxBuffer first;
+  first.SetFromString("1,2,3");
+  NewDmx(2, first);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_NE(static_cast<size_t>(0), stream->PendingBytes());
+
+  DmxBuffer second;
+  second.SetFromString("4,5,6");
+  NewDmx(2, second);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  DmxBuffer third;
+  third.SetFromString("7,8,9");
+  NewDmx(2, third);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ("event: dmx\ndata: " +
+                StreamingHTTPModule::FrameEvent(2, first) + "\n\n",
+                ReadAll(stream));
+
+  // Only the latest frame is sent once it has caught up. For small frames
+  // the full frame is shorter than the delta.
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ("event: dmx\ndata: " +
+                StreamingHTTPModule::FrameEvent(2, third) + "\n\n",
+                ReadAll(stream));
+
+  // A change of size is always sent in full.
+  DmxBuffer shorter;
+  shorter.SetFromString("7,8");
+  NewDmx(2, shorter);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ("event: dmx\ndata: " +
+                StreamingHTTPModule::FrameEvent(2, shorter) + "\n\n",
+                ReadAll(stream));
+}
+
+
+/*
+ * Check a comment is sent if there's nothing else to send.
+ */
+void StreamingHTTPModuleTest::testKeepalive() {
+  set<unsigned int> universes;
+  universes.insert(1);
+  HTTPEventStream *stream = AddStream(universes, 2, false);
+
+  // KEEPALIVE_INTERVAL_S at 2 updates a second.
+  const unsigned int ticks = StreamingHTTPModule::KEEPALIVE_INTERVAL_S * 2;
+  for (unsigned int i = 0; i < ticks - 1; i++) {
+    OLA_ASSERT_TRUE(SendUpdates(stream));
+  }
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ(string(": keepalive\n\n"), ReadAll(stream));
+
+  // Sending DMX resets the count.
+  for (unsigned int i = 0; i < ticks - 1; i++) {
+    OLA_ASSERT_TRUE(SendUpdates(stream));
+  }
+  DmxBuffer frame;
+  frame.SetFromString("1");
+  NewDmx(1, frame);
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ("event: dmx\ndata: " +
+                StreamingHTTPModule::FrameEvent(1, frame) + "\n\n",
+                ReadAll(stream));
+  OLA_ASSERT_TRUE(SendUpdates(stream));
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+}
+
+
+/*
+ * Check universe and universe_removed events.
+ */
+void StreamingHTTPModuleTest::testUniverseEvents() {
+  set<unsigned int> universes;
+  universes.insert(1);
+  HTTPEventStream *dmx_stream = AddStream(universes, 10, false);
+  HTTPEventStream *stream = AddStream(set<unsigned int>(), 10, true);
+  OLA_ASSERT_NE(ola::thread::INVALID_TIMEOUT, m_module->m_universe_poll);
+
+  vector<OlaUniverse> universe_list;
+  universe_list.push_back(OlaUniverse(1, OlaUniverse::MERGE_HTP, "foo",
+                                      vector<OlaInputPort>(),
+                                      vector<OlaOutputPort>(), 0));
+  universe_list.push_back(OlaUniverse(2, OlaUniverse::MERGE_LTP, "bar",
+                                      vector<OlaInputPort>(),
+                                      vector<OlaOutputPort>(), 3));
+  m_module->UniverseListReceived(Result(""), universe_list);
+  const string first_event = ReadAll(stream);
+  OLA_ASSERT_EQ(UniverseEvent(universe_list[0]) +
+                UniverseEvent(universe_list[1]),
+                first_event);
+  OLA_ASSERT_EQ(static_cast<size_t>(0),
+                first_event.find("event: universe\ndata: {\n"
+                                 "data:   \"id\": 1,\n"));
+  // Streams that didn't ask for events don't get them.
+  OLA_ASSERT_EQ(string(""), ReadAll(dmx_stream));
+
+  // Failed requests are ignored.
+  m_module->UniverseListReceived(Result("error"), vector<OlaUniverse>());
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+
+  // Only changes are sent.
+  universe_list[0] = OlaUniverse(1, OlaUniverse::MERGE_HTP, "new name",
+                                 vector<OlaInputPort>(),
+                                 vector<OlaOutputPort>(), 0);
+  universe_list.pop_back();
+  m_module->UniverseListReceived(Result(""), universe_list);
+  OLA_ASSERT_EQ(UniverseEvent(universe_list[0]) +
+                "event: universe_removed\ndata: {\"id\": 2}\n\n",
+                ReadAll(stream));
+
+  m_module->UniverseListReceived(Result(""), universe_list);
+  OLA_ASSERT_EQ(string(""), ReadAll(stream));
+
+  // A new client gets the current list straight away.
+  HTTPEventStream *late_stream = AddStream(set<unsigned int>(), 10, true);
+  OLA_ASSERT_EQ(UniverseEvent(universe_list[0]),
+                ReadAll(late_stream));
+
+  // The poll stops once the last client that wants events goes away.
+  stream->ConnectionClosed();
+  OLA_ASSERT_NE(ola::thread::INVALID_TIMEOUT, m_module->m_universe_poll);
+  late_stream->ConnectionClosed();
+  OLA_ASSERT_EQ(ola::thread::INVALID_TIMEOUT, m_module->m_universe_poll);
+  OLA_ASSERT_TRUE(m_module->m_universe_info.empty());
+}
+
+
+/*
+ * Check universes are shared between streams, and dropped when the last one
+ * closes.
+ */
+void StreamingHTTPModuleTest::testStreamClosed() {
+  set<unsigned int> universes;
+  universes.insert(1);
+  HTTPEventStream *stream1 = AddStream(universes, 10, false);
+  universes.insert(2);
+  HTTPEventStream *stream2 = AddStream(universes, 10, false);
+
+  OLA_ASSERT_EQ(static_cast<size_t>(2), m_module->m_streams.size());
+  OLA_ASSERT_EQ(static_cast<size_t>(2), m_module->m_universes.size());
+  OLA_ASSERT_EQ(2u, m_module->m_universes[1].streams);
+  OLA_ASSERT_EQ(1u, m_module->m_universes[2].streams);
+
+  // Both streams see the same DMX.
+  DmxBuffer frame;
+  frame.SetFromString("1,2");
+  NewDmx(1, frame);
+  OLA_ASSERT_TRUE(SendUpdates(stream1));
+  OLA_ASSERT_TRUE(SendUpdates(stream2));
+  const string expected = "event: dmx\ndata: " +
+      StreamingHTTPModule::FrameEvent(1, frame) + "\n\n";
+  OLA_ASSERT_EQ(expected, ReadAll(stream1));
+  OLA_ASSERT_EQ(expected, ReadAll(stream2));
+
+  stream2->ConnectionClosed();
+  OLA_ASSERT_EQ(static_cast<size_t>(1), m_module->m_streams.size());
+  OLA_ASSERT_EQ(static_cast<size_t>(1), m_module->m_universes.size());
+  OLA_ASSERT_EQ(1u, m_module->m_universes[1].streams);
+
+  stream1->ConnectionClosed();
+  OLA_ASSERT_TRUE(m_module->m_streams.empty());
+  OLA_ASSERT_TRUE(m_module->m_universes.empty());
+}
+}  // namespace ola
@@ -0,0 +1,141 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DmxFrameStats.cpp
+ * Tracks the frame rate, latency & jitter of a stream of DMX frames.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "ola/Clock.h"
+#include "olad/DmxFrameStats.h"
+
+namespace ola {
+
+namespace {
+// 10 slots of 100ms make up a one second window.
+const int64_t SLOT_LENGTH_US = 100000;
+const double WINDOW_SECONDS = 1.0;
+}  // namespace
+
+DmxFrameStats::DmxFrameStats()
+    : m_frames(0),
+      m_last_frame(),
+      m_last_interval(-1),
+      m_jitter(0) {
+  memset(m_slots, 0, sizeof(m_slots));
+  for (unsigned int i = 0; i < RING_SIZE; i++) {
+    m_slots[i].index = -1;
+  }
+}
+
+void DmxFrameStats::RecordFrame(const TimeStamp &now) {
+  CurrentSlot(now)->frames++;
+  m_frames++;
+
+  if (m_last_frame.IsSet() && now >= m_last_frame) {
+    int64_t interval = (now - m_last_frame).AsInt();
+    if (m_last_interval >= 0) {
+      int64_t delta = interval - m_last_interval;
+      if (delta < 0) {
+        delta = -delta;
+      }
+      // J = J + (|D| - J) / 16, from RFC 3550 A.8
+      m_jitter += delta - ((m_jitter + 8) >> 4);
+    }
+    m_last_interval = interval;
+  }
+  m_last_frame = now;
+}
+
+void DmxFrameStats::RecordFrame(const TimeStamp &now,
+                                const TimeInterval &latency) {
+  RecordFrame(now);
+  Slot *slot = CurrentSlot(now);
+  int64_t us = latency.AsInt();
+  if (us < 0) {
+    us = 0;
+  }
+  slot->latency_count++;
+  slot->latency_sum += us;
+  if (us > slot->max_latency) {
+    slot->max_latency = us;
+  }
+}
+
+double DmxFrameStats::FramesPerSecond(const TimeStamp &now) const {
+  int64_t current_index = SlotIndex(now);
+  unsigned int frames = 0;
+  for (unsigned int i = 0; i < RING_SIZE; i++) {
+    if (InWindow(m_slots[i], current_index)) {
+      frames += m_slots[i].frames;
+    }
+  }
+  return frames / WINDOW_SECONDS;
+}
+
+TimeInterval DmxFrameStats::MeanLatency(const TimeStamp &now) const {
+  int64_t current_index = SlotIndex(now);
+  unsigned int count = 0;
+  int64_t sum = 0;
+  for (unsigned int i = 0; i < RING_SIZE; i++) {
+    if (InWindow(m_slots[i], current_index)) {
+      count += m_slots[i].latency_count;
+      sum += m_slots[i].latency_sum;
+    }
+  }
+  return TimeInterval(count ? sum / count : 0);
+}
+
+TimeInterval DmxFrameStats::MaxLatency(const TimeStamp &now) const {
+  int64_t current_index = SlotIndex(now);
+  int64_t max_latency = 0;
+  for (unsigned int i = 0; i < RING_SIZE; i++) {
+    if (InWindow(m_slots[i], current_index) &&
+        m_slots[i].max_latency > max_latency) {
+      max_latency = m_slots[i].max_latency;
+    }
+  }
+  return TimeInterval(max_latency);
+}
+
+/*
+ * Return the slot for the current time, clearing it if it was last used for
+ * an earlier time.
+ */
+DmxFrameStats::Slot *DmxFrameStats::CurrentSlot(const TimeStamp &now) {
+  int64_t index = SlotIndex(now);
+  Slot *slot = &m_slots[index % RING_SIZE];
+  if (slot->index != index) {
+    memset(slot, 0, sizeof(*slot));
+    slot->index = index;
+  }
+  return slot;
+}
+
+/*
+ * The window is the WINDOW_SLOTS complete slots before the current one.
+ */
+bool DmxFrameStats::InWindow(const Slot &slot, int64_t current_index) const {
+  return slot.index < current_index &&
+         slot.index >= current_index - WINDOW_SLOTS;
+}
+
+int64_t DmxFrameStats::SlotIndex(const TimeStamp &now) {
+  return (static_cast<int64_t>(now.Seconds()) * 1000000 +
+          now.MicroSeconds()) / SLOT_LENGTH_US;
+}
+}  // namespace ola
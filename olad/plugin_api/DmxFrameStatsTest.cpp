@@ -0,0 +1,137 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DmxFrameStatsTest.cpp
+ * Test fixture for the DmxFrameStats class.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+
+#include "ola/Clock.h"
+#include "ola/testing/TestUtils.h"
+#include "olad/DmxFrameStats.h"
+
+using ola::DmxFrameStats;
+using ola::TimeInterval;
+using ola::TimeStamp;
+
+class DmxFrameStatsTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DmxFrameStatsTest);
+  CPPUNIT_TEST(testFrameRate);
+  CPPUNIT_TEST(testLatency);
+  CPPUNIT_TEST(testJitter);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void testFrameRate();
+  void testLatency();
+  void testJitter();
+
+  void setUp() {
+    // Start on a slot boundary.
+    struct timeval tv = {1000, 0};
+    m_now = tv;
+  }
+
+ private:
+  TimeStamp m_now;
+
+  TimeStamp Now() const { return m_now; }
+
+  void AdvanceTime(int32_t sec, int32_t usec) {
+    m_now += TimeInterval(sec, usec);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DmxFrameStatsTest);
+
+
+/*
+ * Check the frame rate over the window.
+ */
+void DmxFrameStatsTest::testFrameRate() {
+  DmxFrameStats stats;
+  OLA_ASSERT_EQ(static_cast<uint64_t>(0), stats.Frames());
+  OLA_ASSERT_EQ(0.0, stats.FramesPerSecond(Now()));
+
+  // 40 frames per second, for two seconds.
+  for (unsigned int i = 0; i < 80; i++) {
+    stats.RecordFrame(Now());
+    AdvanceTime(0, 25000);
+  }
+  OLA_ASSERT_EQ(static_cast<uint64_t>(80), stats.Frames());
+  OLA_ASSERT_EQ(40.0, stats.FramesPerSecond(Now()));
+
+  // The rate drops to 0 once there are no frames for a second.
+  AdvanceTime(0, 500000);
+  OLA_ASSERT_EQ(20.0, stats.FramesPerSecond(Now()));
+  AdvanceTime(0, 600000);
+  OLA_ASSERT_EQ(0.0, stats.FramesPerSecond(Now()));
+  OLA_ASSERT_EQ(static_cast<uint64_t>(80), stats.Frames());
+
+  // Old slots are reused
+  AdvanceTime(10, 0);
+  for (unsigned int i = 0; i < 11; i++) {
+    stats.RecordFrame(Now());
+    AdvanceTime(0, 100000);
+  }
+  OLA_ASSERT_EQ(10.0, stats.FramesPerSecond(Now()));
+}
+
+
+/*
+ * Check the mean & max latency.
+ */
+void DmxFrameStatsTest::testLatency() {
+  DmxFrameStats stats;
+  OLA_ASSERT_EQ(TimeInterval(0, 0), stats.MeanLatency(Now()));
+
+  stats.RecordFrame(Now(), TimeInterval(0, 1000));
+  stats.RecordFrame(Now(), TimeInterval(0, 3000));
+  stats.RecordFrame(Now());
+  // Not in the window until the slot is complete.
+  OLA_ASSERT_EQ(TimeInterval(0, 0), stats.MeanLatency(Now()));
+
+  AdvanceTime(0, 100000);
+  OLA_ASSERT_EQ(TimeInterval(0, 2000), stats.MeanLatency(Now()));
+  OLA_ASSERT_EQ(TimeInterval(0, 3000), stats.MaxLatency(Now()));
+
+  AdvanceTime(1, 0);
+  OLA_ASSERT_EQ(TimeInterval(0, 0), stats.MeanLatency(Now()));
+  OLA_ASSERT_EQ(TimeInterval(0, 0), stats.MaxLatency(Now()));
+}
+
+
+/*
+ * Check the jitter estimate.
+ */
+void DmxFrameStatsTest::testJitter() {
+  DmxFrameStats stats;
+  for (unsigned int i = 0; i < 100; i++) {
+    stats.RecordFrame(Now());
+    AdvanceTime(0, 25000);
+  }
+  OLA_ASSERT_EQ(TimeInterval(0, 0), stats.Jitter());
+
+  // Alternate between 20ms & 30ms, the estimate converges on 10ms.
+  for (unsigned int i = 0; i < 200; i++) {
+    stats.RecordFrame(Now());
+    AdvanceTime(0, i % 2 ? 20000 : 30000);
+  }
+  OLA_ASSERT_TRUE(stats.Jitter() > TimeInterval(0, 9500));
+  OLA_ASSERT_TRUE(stats.Jitter() <= TimeInterval(0, 10000));
+}
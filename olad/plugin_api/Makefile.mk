@@ -17,6 +17,7 @@ olad_plugin_api_libolaserverplugininterface_la_SOURCES = \
     olad/plugin_api/Device.cpp \
     olad/plugin_api/DeviceManager.cpp \
     olad/plugin_api/DeviceManager.h \
+    olad/plugin_api/DmxFrameStats.cpp \
     olad/plugin_api/DmxSource.cpp \
     olad/plugin_api/Plugin.cpp \
     olad/plugin_api/PluginAdaptor.cpp \
@@ -60,7 +61,9 @@ olad_plugin_api_DeviceTester_SOURCES = olad/plugin_api/DeviceManagerTest.cpp \
 olad_plugin_api_DeviceTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
 olad_plugin_api_DeviceTester_LDADD = $(COMMON_OLAD_PLUGIN_API_TEST_LDADD)
 
-olad_plugin_api_DmxSourceTester_SOURCES = olad/plugin_api/DmxSourceTest.cpp
+olad_plugin_api_DmxSourceTester_SOURCES = \
+    olad/plugin_api/DmxFrameStatsTest.cpp \
+    olad/plugin_api/DmxSourceTest.cpp
 olad_plugin_api_DmxSourceTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
 olad_plugin_api_DmxSourceTester_LDADD = $(COMMON_OLAD_PLUGIN_API_TEST_LDADD)
 
@@ -40,6 +40,7 @@
 #include <vector>
 
 #include "ola/base/Array.h"
+#include "ola/base/Atomic.h"
 #include "ola/Logging.h"
 #include "ola/MultiCallback.h"
 #include "ola/rdm/RDMCommand.h"
@@ -75,9 +76,45 @@ const char Universe::K_UNIVERSE_MODE_VAR[] = "universe-mode";
 const char Universe::K_UNIVERSE_NAME_VAR[] = "universe-name";
 const char Universe::K_UNIVERSE_OUTPUT_PORT_VAR[] = "universe-output-ports";
 const char Universe::K_UNIVERSE_RDM_REQUESTS[] = "universe-rdm-requests";
+const char Universe::K_UNIVERSE_RDM_OUTSTANDING_VAR[] =
+    "universe-rdm-requests-outstanding";
+const char Universe::K_UNIVERSE_RDM_TIME_VAR[] = "universe-rdm-request-time-ms";
 const char Universe::K_UNIVERSE_SINK_CLIENTS_VAR[] = "universe-sink-clients";
 const char Universe::K_UNIVERSE_SOURCE_CLIENTS_VAR[] =
     "universe-source-clients";
+const char Universe::K_UNIVERSE_DROPPED_VAR[] = "universe-dmx-dropped";
+const char Universe::K_UNIVERSE_MERGE_LATENCY_VAR[] =
+    "universe-merge-latency-us";
+const char Universe::K_UNIVERSE_INPUT_FRAMES_VAR[] = "universe-input-frames";
+const char Universe::K_UNIVERSE_INPUT_JITTER_VAR[] = "universe-input-jitter-us";
+const char Universe::K_UNIVERSE_OUTPUT_JITTER_VAR[] =
+    "universe-output-jitter-us";
+const char Universe::K_UNIVERSE_OUTPUT_LATENCY_VAR[] =
+    "universe-output-latency-us";
+
+namespace {
+// The buckets for the latency histograms, in microseconds.
+const uint64_t LATENCY_BOUNDS[] = {
+  50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000,
+};
+
+// The buckets for the RDM request time histogram, in milliseconds.
+const uint64_t RDM_TIME_BOUNDS[] = {
+  5, 10, 25, 50, 100, 250, 500, 1000, 2500,
+};
+
+/*
+ * Record an output frame, with the latency if we know when the data arrived.
+ */
+void RecordOutputFrame(DmxFrameStats *stats, const TimeStamp &now,
+                       const TimeStamp *arrival) {
+  if (arrival) {
+    stats->RecordFrame(now, now - *arrival);
+  } else {
+    stats->RecordFrame(now);
+  }
+}
+}  // namespace
 
 /*
  * Create a new universe
@@ -97,7 +134,15 @@ Universe::Universe(unsigned int universe_id, UniverseStore *store,
       m_clock(clock),
       m_rdm_discovery_interval(),
       m_last_discovery_time(),
-      m_transaction_number_sequence() {
+      m_transaction_number_sequence(),
+      m_frame_count(NULL),
+      m_dropped_count(NULL),
+      m_merge_latency(NULL),
+      m_input_frame_count(NULL),
+      m_input_jitter(NULL),
+      m_output_jitter(NULL),
+      m_output_latency(NULL),
+      m_rdm_request_time(NULL) {
   ostringstream universe_id_str, universe_name_str;
   universe_id_str << universe_id;
   m_universe_id_str = universe_id_str.str();
@@ -108,10 +153,10 @@ Universe::Universe(unsigned int universe_id, UniverseStore *store,
   UpdateMode();
 
   const char *vars[] = {
-    K_FPS_VAR,
     K_UNIVERSE_INPUT_PORT_VAR,
     K_UNIVERSE_OUTPUT_PORT_VAR,
     K_UNIVERSE_RDM_REQUESTS,
+    K_UNIVERSE_RDM_OUTSTANDING_VAR,
     K_UNIVERSE_SINK_CLIENTS_VAR,
     K_UNIVERSE_SOURCE_CLIENTS_VAR,
     K_UNIVERSE_UID_COUNT_VAR,
@@ -119,8 +164,40 @@ Universe::Universe(unsigned int universe_id, UniverseStore *store,
 
   if (m_export_map) {
     for (unsigned int i = 0; i < arraysize(vars); ++i) {
-      (*m_export_map->GetUIntMapVar(vars[i]))[m_universe_id_str] = 0;
+      m_export_map->GetUIntMapVar(vars[i])->Set(m_universe_id_str, 0);
     }
+
+    // These are updated for every frame, so hold on to the entries. They're
+    // read by the HTTP server's thread.
+    m_frame_count = &(*m_export_map->GetCounterMapVar(
+        K_FPS_VAR, "universe"))[m_universe_id_str];
+    AtomicStore(m_frame_count, 0);
+    m_dropped_count = &(*m_export_map->GetCounterMapVar(
+        K_UNIVERSE_DROPPED_VAR, "universe"))[m_universe_id_str];
+    AtomicStore(m_dropped_count, 0);
+    m_input_frame_count = &(*m_export_map->GetCounterMapVar(
+        K_UNIVERSE_INPUT_FRAMES_VAR, "universe"))[m_universe_id_str];
+    AtomicStore(m_input_frame_count, 0);
+    m_input_jitter = &(*m_export_map->GetUIntMapVar(
+        K_UNIVERSE_INPUT_JITTER_VAR, "universe"))[m_universe_id_str];
+    AtomicStore(m_input_jitter, 0);
+    m_output_jitter = &(*m_export_map->GetUIntMapVar(
+        K_UNIVERSE_OUTPUT_JITTER_VAR, "universe"))[m_universe_id_str];
+    AtomicStore(m_output_jitter, 0);
+
+    const vector<uint64_t> bounds(
+        LATENCY_BOUNDS, LATENCY_BOUNDS + arraysize(LATENCY_BOUNDS));
+    m_merge_latency = m_export_map->GetHistogramVar(
+        K_UNIVERSE_MERGE_LATENCY_VAR, "universe", bounds)->Lookup(
+            m_universe_id_str);
+    m_output_latency = m_export_map->GetHistogramVar(
+        K_UNIVERSE_OUTPUT_LATENCY_VAR, "universe", bounds)->Lookup(
+            m_universe_id_str);
+    const vector<uint64_t> rdm_bounds(
+        RDM_TIME_BOUNDS, RDM_TIME_BOUNDS + arraysize(RDM_TIME_BOUNDS));
+    m_rdm_request_time = m_export_map->GetHistogramVar(
+        K_UNIVERSE_RDM_TIME_VAR, "universe", rdm_bounds)->Lookup(
+            m_universe_id_str);
   }
 
   // We set the last discovery time to now, since most ports will trigger
@@ -133,16 +210,26 @@ Universe::Universe(unsigned int universe_id, UniverseStore *store,
  * Delete this universe
  */
 Universe::~Universe() {
+  // The replies to any outstanding RDM requests are still passed on, but
+  // don't update this universe.
+  std::set<rdm_request_tracker*>::iterator tracker_iter =
+      m_pending_rdm_requests.begin();
+  for (; tracker_iter != m_pending_rdm_requests.end(); ++tracker_iter) {
+    (*tracker_iter)->universe = NULL;
+  }
+
   const char *string_vars[] = {
     K_UNIVERSE_NAME_VAR,
     K_UNIVERSE_MODE_VAR,
   };
 
   const char *uint_vars[] = {
-    K_FPS_VAR,
+    K_UNIVERSE_INPUT_JITTER_VAR,
+    K_UNIVERSE_OUTPUT_JITTER_VAR,
     K_UNIVERSE_INPUT_PORT_VAR,
     K_UNIVERSE_OUTPUT_PORT_VAR,
     K_UNIVERSE_RDM_REQUESTS,
+    K_UNIVERSE_RDM_OUTSTANDING_VAR,
     K_UNIVERSE_SINK_CLIENTS_VAR,
     K_UNIVERSE_SOURCE_CLIENTS_VAR,
     K_UNIVERSE_UID_COUNT_VAR,
@@ -155,6 +242,20 @@ Universe::~Universe() {
     for (unsigned int i = 0; i < arraysize(uint_vars); ++i) {
       m_export_map->GetUIntMapVar(uint_vars[i])->Remove(m_universe_id_str);
     }
+    m_export_map->GetCounterMapVar(K_FPS_VAR)->Remove(m_universe_id_str);
+    m_export_map->GetCounterMapVar(K_UNIVERSE_DROPPED_VAR)->Remove(
+        m_universe_id_str);
+    m_export_map->GetCounterMapVar(K_UNIVERSE_INPUT_FRAMES_VAR)->Remove(
+        m_universe_id_str);
+    m_export_map->GetHistogramVar(
+        K_UNIVERSE_MERGE_LATENCY_VAR, "universe",
+        vector<uint64_t>())->Remove(m_universe_id_str);
+    m_export_map->GetHistogramVar(
+        K_UNIVERSE_OUTPUT_LATENCY_VAR, "universe",
+        vector<uint64_t>())->Remove(m_universe_id_str);
+    m_export_map->GetHistogramVar(
+        K_UNIVERSE_RDM_TIME_VAR, "universe",
+        vector<uint64_t>())->Remove(m_universe_id_str);
   }
 }
 
@@ -222,8 +323,8 @@ bool Universe::RemovePort(OutputPort *port) {
   bool ret = GenericRemovePort(port, &m_output_ports, &m_output_uids);
 
   if (m_export_map) {
-    (*m_export_map->GetUIntMapVar(K_UNIVERSE_UID_COUNT_VAR))[m_universe_id_str]
-        = m_output_uids.size();
+    m_export_map->GetUIntMapVar(K_UNIVERSE_UID_COUNT_VAR)->Set(
+        m_universe_id_str, m_output_uids.size());
   }
   return ret;
 }
@@ -403,9 +504,14 @@ bool Universe::PortDataChanged(InputPort *port) {
              << UniverseId();
     return false;
   }
+  TimeStamp start;
+  m_clock->CurrentTime(&start);
+  const TimeStamp arrival = RecordInputFrame(
+      port, port->SourceData().Timestamp(), start);
   if (MergeAll(port, NULL)) {
-    UpdateDependants();
+    UpdateDependants(&arrival);
   }
+  RecordMergeLatency(start);
   return true;
 }
 
@@ -419,9 +525,14 @@ bool Universe::SourceClientDataChanged(Client *client) {
   }
 
   AddSourceClient(client);   // always add since this may be the first call
+  TimeStamp start;
+  m_clock->CurrentTime(&start);
+  const TimeStamp arrival = RecordInputFrame(
+      NULL, client->SourceData(m_universe_id).Timestamp(), start);
   if (MergeAll(NULL, client)) {
-    UpdateDependants();
+    UpdateDependants(&arrival);
   }
+  RecordMergeLatency(start);
   return true;
 }
 
@@ -466,6 +577,16 @@ void Universe::SendRDMRequest(RDMRequest *request_ptr,
 
   SafeIncrement(K_UNIVERSE_RDM_REQUESTS);
 
+  // Track how many requests are outstanding and how long they take, this
+  // includes the time spent in the port's queue.
+  rdm_request_tracker *rdm_tracker = new rdm_request_tracker;
+  rdm_tracker->universe = this;
+  m_clock->CurrentTime(&rdm_tracker->start_time);
+  rdm_tracker->callback = callback;
+  m_pending_rdm_requests.insert(rdm_tracker);
+  SafeIncrement(K_UNIVERSE_RDM_OUTSTANDING_VAR);
+  callback = NewSingleCallback(&Universe::HandleRDMReply, rdm_tracker);
+
   if (request->DestinationUID().IsBroadcast()) {
     if (m_output_ports.empty()) {
       RunRDMCallback(
@@ -483,20 +604,24 @@ void Universe::SendRDMRequest(RDMRequest *request_ptr,
         ola::rdm::RDM_PLUGIN_DISCOVERY_NOT_SUPPORTED :
         ola::rdm::RDM_WAS_BROADCAST);
     tracker->callback = callback;
+    const bool is_dub = request->IsDUB();
     vector<OutputPort*>::iterator port_iter;
 
     for (port_iter = m_output_ports.begin(); port_iter != m_output_ports.end();
          ++port_iter) {
-      // because each port deletes the request, we need to copy it here
-      if (request->IsDUB()) {
+      // Each port deletes the request, so all but the last port get a copy.
+      // The copies share the parameter data.
+      RDMRequest *port_request = (port_iter + 1 == m_output_ports.end() ?
+          request.release() : request->Duplicate());
+      if (is_dub) {
         (*port_iter)->SendRDMRequest(
-            request->Duplicate(),
+            port_request,
             NewSingleCallback(this,
                               &Universe::HandleBroadcastDiscovery,
                               tracker));
       } else  {
         (*port_iter)->SendRDMRequest(
-            request->Duplicate(),
+            port_request,
             NewSingleCallback(this, &Universe::HandleBroadcastAck, tracker));
       }
     }
@@ -567,6 +692,7 @@ void Universe::NewUIDList(OutputPort *port, const ola::rdm::UIDSet &uids) {
   map<UID, OutputPort*>::iterator iter = m_output_uids.begin();
   while (iter != m_output_uids.end()) {
     if (iter->second == port && !uids.Contains(iter->first)) {
+      m_universe_store->UIDRemoved(m_universe_id, iter->first);
       m_output_uids.erase(iter++);
     } else {
       ++iter;
@@ -584,8 +710,8 @@ void Universe::NewUIDList(OutputPort *port, const ola::rdm::UIDSet &uids) {
   }
 
   if (m_export_map) {
-    (*m_export_map->GetUIntMapVar(K_UNIVERSE_UID_COUNT_VAR))[m_universe_id_str]
-        = m_output_uids.size();
+    m_export_map->GetUIntMapVar(K_UNIVERSE_UID_COUNT_VAR)->Set(
+        m_universe_id_str, m_output_uids.size());
   }
 }
 
@@ -632,14 +758,26 @@ bool Universe::IsActive() const {
 /*
  * Called when the dmx data for this universe changes,
  * updates everyone who needs to know (patched ports and network clients)
+ * @param arrival the time the data arrived, or NULL if it's not known.
  */
-bool Universe::UpdateDependants() {
+bool Universe::UpdateDependants(const TimeStamp *arrival) {
   vector<OutputPort*>::const_iterator iter;
   set<Client*>::const_iterator client_iter;
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
 
   // write to all ports assigned to this universe
   for (iter = m_output_ports.begin(); iter != m_output_ports.end(); ++iter) {
-    (*iter)->WriteDMX(m_buffer, m_active_priority);
+    if (!(*iter)->WriteDMX(m_buffer, m_active_priority)) {
+      if (m_dropped_count) {
+        AtomicAdd(m_dropped_count, 1);
+      }
+      continue;
+    }
+    PortStatsMap::iterator stats_iter = m_port_stats.find(*iter);
+    if (stats_iter != m_port_stats.end()) {
+      RecordOutputFrame(&stats_iter->second, now, arrival);
+    }
   }
 
   // write to all clients
@@ -649,11 +787,70 @@ bool Universe::UpdateDependants() {
     (*client_iter)->SendDMX(m_universe_id, m_active_priority, m_buffer);
   }
 
-  SafeIncrement(K_FPS_VAR);
+  RecordOutputFrame(&m_output_stats, now, arrival);
+  if (m_frame_count) {
+    AtomicAdd(m_frame_count, 1);
+    AtomicStore(m_output_jitter, m_output_stats.Jitter().AsInt());
+    if (arrival) {
+      int64_t latency = (now - *arrival).AsInt();
+      m_output_latency->Observe(latency > 0 ? latency : 0);
+    }
+  }
   return true;
 }
 
 
+/*
+ * Record a frame from a port or client.
+ * @param port the input port, or NULL if the data came from a client.
+ * @param timestamp the time the data arrived, from the DmxSource.
+ * @param now the current time, used if the DmxSource doesn't have a
+ *   timestamp.
+ * @returns the time the data arrived.
+ */
+TimeStamp Universe::RecordInputFrame(const Port *port,
+                                     const TimeStamp &timestamp,
+                                     const TimeStamp &now) {
+  const TimeStamp arrival =
+      (timestamp.IsSet() && timestamp <= now) ? timestamp : now;
+  m_input_stats.RecordFrame(arrival);
+  if (port) {
+    PortStatsMap::iterator iter = m_port_stats.find(port);
+    if (iter != m_port_stats.end()) {
+      iter->second.RecordFrame(arrival);
+    }
+  }
+  if (m_input_frame_count) {
+    AtomicAdd(m_input_frame_count, 1);
+    AtomicStore(m_input_jitter, m_input_stats.Jitter().AsInt());
+  }
+  return arrival;
+}
+
+
+/*
+ * Return the stats for a port.
+ */
+const DmxFrameStats *Universe::PortStats(const Port *port) const {
+  return STLFind(&m_port_stats, port);
+}
+
+
+/*
+ * Record the time taken to merge & send a frame.
+ * @param start the time the frame arrived.
+ */
+void Universe::RecordMergeLatency(const TimeStamp &start) {
+  if (!m_merge_latency) {
+    return;
+  }
+  TimeStamp now;
+  m_clock->CurrentTime(&now);
+  int64_t latency = (now - start).AsInt();
+  m_merge_latency->Observe(latency > 0 ? latency : 0);
+}
+
+
 /*
  * Update the name in the export map.
  */
@@ -662,7 +859,7 @@ void Universe::UpdateName() {
     return;
   }
   StringMap *name_map = m_export_map->GetStringMapVar(K_UNIVERSE_NAME_VAR);
-  (*name_map)[m_universe_id_str] = m_universe_name;
+  name_map->Set(m_universe_id_str, m_universe_name);
 }
 
 
@@ -674,8 +871,8 @@ void Universe::UpdateMode() {
     return;
   }
   StringMap *mode_map = m_export_map->GetStringMapVar(K_UNIVERSE_MODE_VAR);
-  (*mode_map)[m_universe_id_str] = (m_merge_mode == Universe::MERGE_LTP ?
-                                    K_MERGE_LTP_STR : K_MERGE_HTP_STR);
+  mode_map->Set(m_universe_id_str, m_merge_mode == Universe::MERGE_LTP ?
+                K_MERGE_LTP_STR : K_MERGE_HTP_STR);
 }
 
 
@@ -889,12 +1086,35 @@ void Universe::HandleBroadcastDiscovery(
 }
 
 
+/*
+ * Called when a RDM request completes.
+ */
+void Universe::HandleRDMReply(rdm_request_tracker *tracker,
+                              ola::rdm::RDMReply *reply) {
+  Universe *universe = tracker->universe;
+  if (universe) {
+    universe->m_pending_rdm_requests.erase(tracker);
+    if (universe->m_rdm_request_time) {
+      TimeStamp now;
+      universe->m_clock->CurrentTime(&now);
+      int64_t request_time = (now - tracker->start_time).InMilliSeconds();
+      universe->m_rdm_request_time->Observe(
+          static_cast<uint64_t>(request_time));
+    }
+    universe->SafeDecrement(K_UNIVERSE_RDM_OUTSTANDING_VAR);
+  }
+  ola::rdm::RDMCallback *callback = tracker->callback;
+  delete tracker;
+  callback->Run(reply);
+}
+
+
 /*
  * Helper function to increment an Export Map variable
  */
 void Universe::SafeIncrement(const string &name) {
   if (m_export_map) {
-    (*m_export_map->GetUIntMapVar(name))[m_universe_id_str]++;
+    m_export_map->GetUIntMapVar(name)->Increment(m_universe_id_str);
   }
 }
 
@@ -903,7 +1123,7 @@ void Universe::SafeIncrement(const string &name) {
  */
 void Universe::SafeDecrement(const string &name) {
   if (m_export_map) {
-    (*m_export_map->GetUIntMapVar(name))[m_universe_id_str]--;
+    m_export_map->GetUIntMapVar(name)->Decrement(m_universe_id_str);
   }
 }
 
@@ -920,11 +1140,12 @@ bool Universe::GenericAddPort(PortClass *port, vector<PortClass*> *ports) {
   }
 
   ports->push_back(port);
+  m_port_stats[port] = DmxFrameStats();
   if (m_export_map) {
     UIntMap *map = m_export_map->GetUIntMapVar(
         IsInputPort<PortClass>() ? K_UNIVERSE_INPUT_PORT_VAR :
         K_UNIVERSE_OUTPUT_PORT_VAR);
-    (*map)[m_universe_id_str]++;
+    map->Increment(m_universe_id_str);
   }
   return true;
 }
@@ -949,11 +1170,12 @@ bool Universe::GenericRemovePort(PortClass *port,
   }
 
   ports->erase(iter);
+  m_port_stats.erase(port);
   if (m_export_map) {
     UIntMap *map = m_export_map->GetUIntMapVar(
         IsInputPort<PortClass>() ? K_UNIVERSE_INPUT_PORT_VAR :
         K_UNIVERSE_OUTPUT_PORT_VAR);
-    (*map)[m_universe_id_str]--;
+    map->Decrement(m_universe_id_str);
   }
 
   if (!IsActive()) {
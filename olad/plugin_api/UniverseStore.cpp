@@ -52,8 +52,12 @@ UniverseStore::UniverseStore(Preferences *preferences,
     export_map->GetStringMapVar(Universe::K_UNIVERSE_NAME_VAR, "universe");
     export_map->GetStringMapVar(Universe::K_UNIVERSE_MODE_VAR, "universe");
 
+    export_map->GetCounterMapVar(Universe::K_FPS_VAR, "universe");
+    export_map->GetCounterMapVar(Universe::K_UNIVERSE_DROPPED_VAR, "universe");
+    export_map->GetCounterMapVar(Universe::K_UNIVERSE_INPUT_FRAMES_VAR,
+                                 "universe");
+
     const char *vars[] = {
-      Universe::K_FPS_VAR,
       Universe::K_UNIVERSE_INPUT_PORT_VAR,
       Universe::K_UNIVERSE_OUTPUT_PORT_VAR,
       Universe::K_UNIVERSE_SINK_CLIENTS_VAR,
@@ -127,6 +131,17 @@ void UniverseStore::GarbageCollectUniverses() {
   m_deletion_candiates.clear();
 }
 
+void UniverseStore::SetUIDRemovedCallback(UIDRemovedCallback *callback) {
+  m_uid_removed_callback.reset(callback);
+}
+
+void UniverseStore::UIDRemoved(unsigned int universe_id,
+                               const ola::rdm::UID &uid) {
+  if (m_uid_removed_callback.get()) {
+    m_uid_removed_callback->Run(universe_id, uid);
+  }
+}
+
 
 /*
  * Restore a universe's settings
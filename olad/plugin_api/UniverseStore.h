@@ -22,12 +22,15 @@
 #define OLAD_PLUGIN_API_UNIVERSESTORE_H_
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "ola/Callback.h"
 #include "ola/Clock.h"
 #include "ola/base/Macro.h"
+#include "ola/rdm/UID.h"
 
 namespace ola {
 
@@ -38,6 +41,12 @@ class Universe;
  */
 class UniverseStore {
  public:
+  /**
+   * @brief Run when an RDM responder is no longer found on a universe.
+   */
+  typedef Callback2<void, unsigned int, const ola::rdm::UID&>
+      UIDRemovedCallback;
+
   /**
    * @brief Create a new UniverseStore.
    * @param preferences The Preferences store.
@@ -92,6 +101,21 @@ class UniverseStore {
    */
   void GarbageCollectUniverses();
 
+  /**
+   * @brief Set the callback to run when discovery no longer finds a
+   *   responder on a universe.
+   * @param callback the callback to run, ownership is transferred. NULL
+   *   removes the callback.
+   */
+  void SetUIDRemovedCallback(UIDRemovedCallback *callback);
+
+  /**
+   * @brief Called by a Universe when discovery no longer finds a responder.
+   * @param universe_id the universe-id of the universe.
+   * @param uid the UID of the responder that was removed.
+   */
+  void UIDRemoved(unsigned int universe_id, const ola::rdm::UID &uid);
+
  private:
   typedef std::map<unsigned int, Universe*> UniverseMap;
 
@@ -101,6 +125,7 @@ class UniverseStore {
   std::set<Universe*> m_deletion_candiates;  // list of universes we may be
                                              // able to delete
   Clock m_clock;
+  std::auto_ptr<UIDRemovedCallback> m_uid_removed_callback;
 
   bool RestoreUniverseSettings(Universe *universe) const;
   bool SaveUniverseSettings(Universe *universe) const;
@@ -27,6 +27,7 @@
 #include "ola/Constants.h"
 #include "ola/Clock.h"
 #include "ola/DmxBuffer.h"
+#include "ola/ExportMap.h"
 #include "ola/rdm/RDMCommand.h"
 #include "ola/rdm/RDMReply.h"
 #include "ola/rdm/RDMResponseCodes.h"
@@ -47,6 +48,7 @@
 using ola::AbstractDevice;
 using ola::Clock;
 using ola::DmxBuffer;
+using ola::ExportMap;
 using ola::NewCallback;
 using ola::NewSingleCallback;
 using ola::TimeStamp;
@@ -78,6 +80,8 @@ class UniverseTest: public CppUnit::TestFixture {
   CPPUNIT_TEST(testHtpMerging);
   CPPUNIT_TEST(testRDMDiscovery);
   CPPUNIT_TEST(testRDMSend);
+  CPPUNIT_TEST(testRDMReplyAfterDelete);
+  CPPUNIT_TEST(testUIDRemoved);
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -93,6 +97,8 @@ class UniverseTest: public CppUnit::TestFixture {
   void testHtpMerging();
   void testRDMDiscovery();
   void testRDMSend();
+  void testRDMReplyAfterDelete();
+  void testUIDRemoved();
 
  private:
   ola::MemoryPreferences *m_preferences;
@@ -113,6 +119,18 @@ class UniverseTest: public CppUnit::TestFixture {
     delete request;
     RunRDMCallback(callback, status_code);
   }
+
+  void UIDRemoved(UIDSet *removed, unsigned int universe_id, const UID &uid) {
+    OLA_ASSERT_EQ(TEST_UNIVERSE, universe_id);
+    removed->AddUID(uid);
+  }
+
+  void DeferRDM(RDMCallback **deferred,
+                const RDMRequest *request,
+                RDMCallback *callback) {
+    delete request;
+    *deferred = callback;
+  }
 };
 
 
@@ -263,8 +281,16 @@ void UniverseTest::testReceiveDmx() {
   OLA_ASSERT_EQ(m_buffer.Size(), universe->GetDMX().Size());
   OLA_ASSERT_DMX_EQUALS(m_buffer, universe->GetDMX());
 
+  // Check the frame stats
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), universe->InputStats().Frames());
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), universe->OutputStats().Frames());
+  const ola::DmxFrameStats *port_stats = universe->PortStats(&port);
+  OLA_ASSERT_NOT_NULL(port_stats);
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), port_stats->Frames());
+
   // Remove the port from the universe
   universe->RemovePort(&port);
+  OLA_ASSERT_NULL(universe->PortStats(&port));
   OLA_ASSERT_FALSE(universe->IsActive());
   OLA_ASSERT_EQ((unsigned int) 0, universe->InputPortCount());
   OLA_ASSERT_EQ((unsigned int) 0, universe->OutputPortCount());
@@ -800,6 +826,101 @@ void UniverseTest::testRDMSend() {
 }
 
 
+/**
+ * Check the RDM request stats, and that a reply which arrives after the
+ * universe is deleted is still passed on.
+ */
+void UniverseTest::testRDMReplyAfterDelete() {
+  ExportMap export_map;
+  ola::UniverseStore store(m_preferences, &export_map);
+  Universe *universe = store.GetUniverseOrCreate(TEST_UNIVERSE);
+  OLA_ASSERT(universe);
+
+  UID uid1(0x7a70, 1);
+  UID source_uid(0x7a70, 100);
+  UIDSet port_uids;
+  port_uids.AddUID(uid1);
+  TestMockRDMOutputPort port(NULL, 1, &port_uids, true);
+  universe->AddPort(&port);
+  port.SetUniverse(universe);
+
+  RDMCallback *deferred = NULL;
+  port.SetRDMHandler(NewCallback(this, &UniverseTest::DeferRDM, &deferred));
+
+  universe->SendRDMRequest(
+      new ola::rdm::RDMGetRequest(source_uid, uid1, 0, 1, 10, 296, NULL, 0),
+      NewSingleCallback(this,
+                        &UniverseTest::ConfirmRDM,
+                        __LINE__,
+                        ola::rdm::RDM_TIMEOUT,
+                        reinterpret_cast<const RDMResponse*>(NULL)));
+  OLA_ASSERT(deferred);
+
+  const string universe_key = "1";
+  ola::UIntMap *outstanding = export_map.GetUIntMapVar(
+      Universe::K_UNIVERSE_RDM_OUTSTANDING_VAR);
+  OLA_ASSERT_EQ(1u, (*outstanding)[universe_key]);
+
+  RunRDMCallback(deferred, ola::rdm::RDM_TIMEOUT);
+  OLA_ASSERT_EQ(0u, (*outstanding)[universe_key]);
+  ola::Histogram *request_time = export_map.GetHistogramVar(
+      Universe::K_UNIVERSE_RDM_TIME_VAR, "universe",
+      vector<uint64_t>())->Lookup(universe_key);
+  OLA_ASSERT_EQ(static_cast<uint64_t>(1), request_time->Count());
+
+  // Now delete the universe while a request is outstanding.
+  deferred = NULL;
+  universe->SendRDMRequest(
+      new ola::rdm::RDMGetRequest(source_uid, uid1, 0, 1, 10, 296, NULL, 0),
+      NewSingleCallback(this,
+                        &UniverseTest::ConfirmRDM,
+                        __LINE__,
+                        ola::rdm::RDM_TIMEOUT,
+                        reinterpret_cast<const RDMResponse*>(NULL)));
+  OLA_ASSERT(deferred);
+
+  universe->RemovePort(&port);
+  store.DeleteAll();
+  OLA_ASSERT_EQ(0u, store.UniverseCount());
+
+  RunRDMCallback(deferred, ola::rdm::RDM_TIMEOUT);
+}
+
+
+/**
+ * Check the UniverseStore is told when discovery no longer finds a responder.
+ */
+void UniverseTest::testUIDRemoved() {
+  UIDSet removed;
+  m_store->SetUIDRemovedCallback(
+      NewCallback(this, &UniverseTest::UIDRemoved, &removed));
+  Universe *universe = m_store->GetUniverseOrCreate(TEST_UNIVERSE);
+  OLA_ASSERT(universe);
+
+  UID uid1(0x7a70, 1);
+  UID uid2(0x7a70, 2);
+  UIDSet port_uids;
+  TestMockRDMOutputPort port(NULL, 1, &port_uids, true);
+  universe->AddPort(&port);
+
+  UIDSet uids;
+  uids.AddUID(uid1);
+  uids.AddUID(uid2);
+  universe->NewUIDList(&port, uids);
+  OLA_ASSERT_EQ(0u, removed.Size());
+
+  uids.RemoveUID(uid1);
+  universe->NewUIDList(&port, uids);
+  UIDSet expected;
+  expected.AddUID(uid1);
+  OLA_ASSERT_EQ(expected, removed);
+
+  // Removing the port doesn't mean the responders have gone.
+  universe->RemovePort(&port);
+  OLA_ASSERT_EQ(expected, removed);
+}
+
+
 /**
  * Check we got the uids we expect
  */
@@ -143,3 +143,19 @@ dist_bootfonts_DATA = \
     olad/www/new/libs/bootstrap/fonts/glyphicons-halflings-regular.woff2
 dist_bootcss_DATA = \
     olad/www/new/libs/bootstrap/css/bootstrap.min.css
+
+# Install gzipped copies of the text files alongside them, the HTTP server
+# sends these to clients that accept gzip.
+www_gzip_find = find "$(DESTDIR)$(www_datadir)" -type f \
+    \( -name '*.css' -o -name '*.html' -o -name '*.js' -o -name '*.json' \
+       -o -name '*.map' -o -name '*.svg' -o -name '*.ttf' -o -name '*.eot' \
+       -o -name '*.xml' -o -name '*.webapp' \)
+
+install-data-hook-www:
+	$(www_gzip_find) -exec sh -c 'gzip -9 -n -c "$$1" > "$$1.gz"' sh {} \;
+
+uninstall-hook-www:
+	find "$(DESTDIR)$(www_datadir)" -type f -name '*.gz' -exec rm -f {} \;
+
+INSTALL_DATA_HOOKS += install-data-hook-www
+UNINSTALL_HOOKS += uninstall-hook-www
@@ -64,11 +64,14 @@ const char ArtNetDevice::K_LONG_NAME_KEY[] = "long_name";
 const char ArtNetDevice::K_LOOPBACK_KEY[] = "use_loopback";
 const char ArtNetDevice::K_NET_KEY[] = "net";
 const char ArtNetDevice::K_OUTPUT_PORT_KEY[] = "output_ports";
+const char ArtNetDevice::K_RDM_MAX_IN_FLIGHT_KEY[] = "rdm_max_in_flight";
 const char ArtNetDevice::K_SHORT_NAME_KEY[] = "short_name";
 const char ArtNetDevice::K_SUBNET_KEY[] = "subnet";
 const unsigned int ArtNetDevice::K_ARTNET_NET = 0;
 const unsigned int ArtNetDevice::K_ARTNET_SUBNET = 0;
 const unsigned int ArtNetDevice::K_DEFAULT_OUTPUT_PORT_COUNT = 4;
+const unsigned int ArtNetDevice::K_DEFAULT_RDM_MAX_IN_FLIGHT = 1;
+const unsigned int ArtNetDevice::K_MAX_RDM_MAX_IN_FLIGHT = 16;
 
 ArtNetDevice::ArtNetDevice(AbstractPlugin *owner,
                            ola::Preferences *preferences,
@@ -108,6 +111,9 @@ bool ArtNetDevice::StartHook() {
   node_options.input_port_count = StringToIntOrDefault(
       m_preferences->GetValue(K_OUTPUT_PORT_KEY),
       K_DEFAULT_OUTPUT_PORT_COUNT);
+  node_options.rdm_max_in_flight = StringToIntOrDefault(
+      m_preferences->GetValue(K_RDM_MAX_IN_FLIGHT_KEY),
+      K_DEFAULT_RDM_MAX_IN_FLIGHT);
 
   m_node = new ArtNetNode(iface, m_plugin_adaptor, node_options);
   m_node->SetNetAddress(net);
@@ -79,11 +79,14 @@ class ArtNetDevice: public Device {
   static const char K_LOOPBACK_KEY[];
   static const char K_NET_KEY[];
   static const char K_OUTPUT_PORT_KEY[];
+  static const char K_RDM_MAX_IN_FLIGHT_KEY[];
   static const char K_SHORT_NAME_KEY[];
   static const char K_SUBNET_KEY[];
   static const unsigned int K_ARTNET_NET;
   static const unsigned int K_ARTNET_SUBNET;
   static const unsigned int K_DEFAULT_OUTPUT_PORT_COUNT;
+  static const unsigned int K_DEFAULT_RDM_MAX_IN_FLIGHT;
+  static const unsigned int K_MAX_RDM_MAX_IN_FLIGHT;
   // 10s between polls when we're sending data, DMX-workshop uses 8s;
   static const unsigned int POLL_INTERVAL = 10000;
 
@@ -77,9 +77,27 @@ using std::vector;
 const char ArtNetNodeImpl::ARTNET_ID[] = "Art-Net";
 
 
-// UID to the IP Address it came from, and the number of times since we last
-// saw it in an ArtTod message.
-typedef map<UID, std::pair<IPV4Address, uint8_t> > uid_map;
+// An RDM request that has been sent, and the callback to run when it completes.
+class PendingRDMRequest {
+ public:
+  PendingRDMRequest(const RDMRequest *request,
+                    RDMCallback *callback,
+                    const IPV4Address &ip_destination)
+      : request(request),
+        callback(callback),
+        ip_destination(ip_destination),
+        timeout(ola::thread::INVALID_TIMEOUT) {
+  }
+  ~PendingRDMRequest() { delete request; }
+
+  const RDMRequest *request;
+  RDMCallback *callback;
+  IPV4Address ip_destination;
+  ola::thread::timeout_id timeout;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PendingRDMRequest);
+};
 
 // Input ports are ones that send data using ArtNet
 class ArtNetNodeImpl::InputPort {
@@ -89,9 +107,6 @@ class ArtNetNodeImpl::InputPort {
         sequence_number(0),
         discovery_callback(NULL),
         discovery_timeout(ola::thread::INVALID_TIMEOUT),
-        rdm_request_callback(NULL),
-        pending_request(NULL),
-        rdm_send_timeout(ola::thread::INVALID_TIMEOUT),
         m_port_address(0),
         m_tod_callback(NULL) {
   }
@@ -168,13 +183,8 @@ class ArtNetNodeImpl::InputPort {
   set<IPV4Address> discovery_node_set;
   // the timeout_id for the discovery timer
   ola::thread::timeout_id discovery_timeout;
-  // the in-flight request and it's callback
-  RDMCallback *rdm_request_callback;
-  const RDMRequest *pending_request;
-  IPV4Address rdm_ip_destination;
-
-  // these control the sending of RDM requests.
-  ola::thread::timeout_id rdm_send_timeout;
+  // the in-flight requests, only one request to each UID may be in flight.
+  map<UID, PendingRDMRequest*> pending_requests;
 
  private:
   uint8_t m_port_address;
@@ -184,10 +194,19 @@ class ArtNetNodeImpl::InputPort {
 
   void RunRDMCallbackWithUIDs(const uid_map &uids,
                               RDMDiscoveryCallback *callback) {
-    UIDSet uid_set;
+    // The map isn't ordered, sort the UIDs so they're cheap to add to the set.
+    vector<UID> sorted_uids;
+    sorted_uids.reserve(uids.size());
     uid_map::const_iterator uid_iter = uids.begin();
     for (; uid_iter != uids.end(); ++uid_iter) {
-      uid_set.AddUID(uid_iter->first);
+      sorted_uids.push_back(uid_iter->first);
+    }
+    std::sort(sorted_uids.begin(), sorted_uids.end());
+
+    UIDSet uid_set;
+    vector<UID>::const_iterator iter = sorted_uids.begin();
+    for (; iter != sorted_uids.end(); ++iter) {
+      uid_set.AddUID(*iter);
     }
     callback->Run(uid_set);
   }
@@ -285,19 +304,17 @@ bool ArtNetNodeImpl::Stop() {
     port->RunDiscoveryCallback();
 
     // clean up request state
-    if (port->rdm_send_timeout != ola::thread::INVALID_TIMEOUT) {
-      m_ss->RemoveTimeout(port->rdm_send_timeout);
-      port->rdm_send_timeout = ola::thread::INVALID_TIMEOUT;
-    }
-
-    if (port->pending_request) {
-      delete port->pending_request;
-      port->pending_request = NULL;
-    }
-
-    if (port->rdm_request_callback) {
-      RDMCallback *callback = port->rdm_request_callback;
-      port->rdm_request_callback = NULL;
+    map<UID, PendingRDMRequest*> pending_requests;
+    pending_requests.swap(port->pending_requests);
+    map<UID, PendingRDMRequest*>::iterator request_iter =
+        pending_requests.begin();
+    for (; request_iter != pending_requests.end(); ++request_iter) {
+      PendingRDMRequest *pending = request_iter->second;
+      if (pending->timeout != ola::thread::INVALID_TIMEOUT) {
+        m_ss->RemoveTimeout(pending->timeout);
+      }
+      RDMCallback *callback = pending->callback;
+      delete pending;
       RunRDMCallback(callback, ola::rdm::RDM_TIMEOUT);
     }
   }
@@ -671,14 +688,15 @@ void ArtNetNodeImpl::SendRDMRequest(uint8_t port_id,
     return;
   }
 
-  if (port->rdm_request_callback) {
-    OLA_FATAL << "Previous request hasn't completed yet, dropping request";
+  const UID uid_destination = request->DestinationUID();
+  if (STLContains(port->pending_requests, uid_destination)) {
+    OLA_FATAL << "Previous request to " << uid_destination
+              << " hasn't completed yet, dropping request";
     RunRDMCallback(on_complete, ola::rdm::RDM_FAILED_TO_SEND);
     return;
   }
 
-  port->rdm_ip_destination = m_interface.bcast_address;
-  const UID &uid_destination = request->DestinationUID();
+  IPV4Address ip_destination = m_interface.bcast_address;
   uid_map::const_iterator iter = port->uids.find(uid_destination);
   if (iter == port->uids.end()) {
     if (!uid_destination.IsBroadcast()) {
@@ -686,23 +704,20 @@ void ArtNetNodeImpl::SendRDMRequest(uint8_t port_id,
                << " in the uid map, broadcasting packet";
     }
   } else {
-    port->rdm_ip_destination = iter->second.first;
+    ip_destination = iter->second.first;
   }
 
-  port->rdm_request_callback = on_complete;
-  port->pending_request = request.release();
-  bool r = SendRDMCommand(*port->pending_request,
-                          port->rdm_ip_destination,
-                          port->PortAddress());
+  bool r = SendRDMCommand(*request, ip_destination, port->PortAddress());
 
   if (r && !uid_destination.IsBroadcast()) {
-    port->rdm_send_timeout = m_ss->RegisterSingleTimeout(
+    PendingRDMRequest *pending = new PendingRDMRequest(
+        request.release(), on_complete, ip_destination);
+    pending->timeout = m_ss->RegisterSingleTimeout(
       RDM_REQUEST_TIMEOUT_MS,
-      ola::NewSingleCallback(this, &ArtNetNodeImpl::TimeoutRDMRequest, port));
+      ola::NewSingleCallback(this, &ArtNetNodeImpl::TimeoutRDMRequest, port,
+                             uid_destination));
+    port->pending_requests[uid_destination] = pending;
   } else {
-    delete port->pending_request;
-    port->pending_request = NULL;
-    port->rdm_request_callback = NULL;
     RunRDMCallback(
         on_complete,
         uid_destination.IsBroadcast() ? ola::rdm::RDM_WAS_BROADCAST :
@@ -1353,11 +1368,14 @@ void ArtNetNodeImpl::HandleRDMResponse(InputPort *port,
     return;
   }
 
-  if (!port->pending_request) {
+  map<UID, PendingRDMRequest*>::iterator pending_iter =
+      port->pending_requests.find(reply->Response()->SourceUID());
+  if (pending_iter == port->pending_requests.end()) {
     return;
   }
 
-  const RDMRequest *request = port->pending_request;
+  PendingRDMRequest *pending = pending_iter->second;
+  const RDMRequest *request = pending->request;
   if (request->SourceUID() != reply->Response()->DestinationUID() ||
       request->DestinationUID() != reply->Response()->SourceUID()) {
     OLA_INFO << "Got response from/to unexpected UID: req "
@@ -1399,23 +1417,21 @@ void ArtNetNodeImpl::HandleRDMResponse(InputPort *port,
     return;
   }
 
-  if (port->rdm_ip_destination != m_interface.bcast_address &&
-      port->rdm_ip_destination != source_address) {
+  if (pending->ip_destination != m_interface.bcast_address &&
+      pending->ip_destination != source_address) {
     OLA_INFO << "IP address of RDM response didn't match";
     return;
   }
 
   // at this point we've decided it's for us
-  port->pending_request = NULL;
-  delete request;
-  RDMCallback *callback = port->rdm_request_callback;
-  port->rdm_request_callback = NULL;
+  port->pending_requests.erase(pending_iter);
+  RDMCallback *callback = pending->callback;
 
   // remove the timeout
-  if (port->rdm_send_timeout != ola::thread::INVALID_TIMEOUT) {
-    m_ss->RemoveTimeout(port->rdm_send_timeout);
-    port->rdm_send_timeout = ola::thread::INVALID_TIMEOUT;
+  if (pending->timeout != ola::thread::INVALID_TIMEOUT) {
+    m_ss->RemoveTimeout(pending->timeout);
   }
+  delete pending;
 
   callback->Run(reply.get());
 }
@@ -1459,13 +1475,15 @@ bool ArtNetNodeImpl::SendPacket(const artnet_packet &packet,
   return true;
 }
 
-void ArtNetNodeImpl::TimeoutRDMRequest(InputPort *port) {
-  OLA_INFO << "RDM Request timed out.";
-  port->rdm_send_timeout = ola::thread::INVALID_TIMEOUT;
-  delete port->pending_request;
-  port->pending_request = NULL;
-  RDMCallback *callback = port->rdm_request_callback;
-  port->rdm_request_callback = NULL;
+void ArtNetNodeImpl::TimeoutRDMRequest(InputPort *port, UID destination) {
+  OLA_INFO << "RDM Request to " << destination << " timed out.";
+  PendingRDMRequest *pending = STLLookupAndRemovePtr(&port->pending_requests,
+                                                     destination);
+  if (!pending) {
+    return;
+  }
+  RDMCallback *callback = pending->callback;
+  delete pending;
   RunRDMCallback(callback, ola::rdm::RDM_TIMEOUT);
 }
 
@@ -1797,12 +1815,15 @@ ArtNetNode::ArtNetNode(const ola::network::Interface &iface,
                        const ArtNetNodeOptions &options,
                        ola::network::UDPSocketInterface *socket):
     m_impl(iface, ss, options, socket) {
+  ola::rdm::QueueingRDMController::Options queue_options(
+      options.rdm_queue_size);
+  queue_options.max_in_flight = options.rdm_max_in_flight;
   for (unsigned int i = 0; i < options.input_port_count; i++) {
     ArtNetNodeImplRDMWrapper *wrapper = new ArtNetNodeImplRDMWrapper(&m_impl,
                                                                      i);
     m_wrappers.push_back(wrapper);
     m_controllers.push_back(new ola::rdm::DiscoverableQueueingRDMController(
-        wrapper, options.rdm_queue_size));
+        wrapper, queue_options));
   }
 }
 
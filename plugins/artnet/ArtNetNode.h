@@ -21,6 +21,11 @@
 #ifndef PLUGINS_ARTNET_ARTNETNODE_H_
 #define PLUGINS_ARTNET_ARTNETNODE_H_
 
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif  // HAVE_CONFIG_H
+
+#include <stddef.h>
 #include <map>
 #include <memory>
 #include <string>
@@ -42,6 +47,8 @@
 #include "ola/timecode/TimeCode.h"
 #include "plugins/artnet/ArtNetPackets.h"
 
+#include HASH_MAP_H
+
 namespace ola {
 namespace plugin {
 namespace artnet {
@@ -68,6 +75,7 @@ class ArtNetNodeOptions {
       : always_broadcast(false),
         use_limited_broadcast_address(false),
         rdm_queue_size(20),
+        rdm_max_in_flight(1),
         broadcast_threshold(30),
         input_port_count(4) {
   }
@@ -75,6 +83,9 @@ class ArtNetNodeOptions {
   bool always_broadcast;
   bool use_limited_broadcast_address;
   unsigned int rdm_queue_size;
+  // The number of RDM requests, each to a different UID, which can be in
+  // flight on a port at once.
+  unsigned int rdm_max_in_flight;
   unsigned int broadcast_threshold;
   uint8_t input_port_count;
 };
@@ -288,8 +299,8 @@ class ArtNetNodeImpl {
    * @param request the RDMRequest object
    * @param on_complete the RDMCallback to run
    *
-   * Because this is wrapped in the QueueingRDMController this will only be
-   * called one-at-a-time (per port)
+   * Because this is wrapped in the QueueingRDMController only one request
+   * to each UID will be outstanding at a time (per port).
    */
   void SendRDMRequest(uint8_t port_id,
                       ola::rdm::RDMRequest *request,
@@ -356,10 +367,26 @@ class ArtNetNodeImpl {
   class InputPort;
   typedef std::vector<InputPort*> InputPorts;
 
+  struct UIDHash {
+    size_t operator()(const ola::rdm::UID &uid) const {
+      // Device ids are often sequential, so mix the bits before the table
+      // reduces the hash.
+      uint64_t hash = (static_cast<uint64_t>(uid.ManufacturerId()) << 32) |
+                      uid.DeviceId();
+      hash ^= hash >> 33;
+      hash *= 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 33;
+      return static_cast<size_t>(hash);
+    }
+  };
+
   // map a uid to a IP address and the number of times we've missed a
-  // response.
-  typedef std::map<ola::rdm::UID,
-                   std::pair<ola::network::IPV4Address, uint8_t> > uid_map;
+  // response. This is checked for every RDM request, and updated for every
+  // UID in a TOD, so use a hash map.
+  typedef HASH_NAMESPACE::HASH_MAP_CLASS<
+      ola::rdm::UID,
+      std::pair<ola::network::IPV4Address, uint8_t>,
+      UIDHash> uid_map;
 
   enum { MAX_MERGE_SOURCES = 2 };
 
@@ -542,7 +569,7 @@ class ArtNetNodeImpl {
    * @brief Timeout a pending RDM request
    * @param port the id of the port to timeout.
    */
-  void TimeoutRDMRequest(InputPort *port);
+  void TimeoutRDMRequest(InputPort *port, ola::rdm::UID destination);
 
   /**
    * @brief Send a generic ArtRdm message
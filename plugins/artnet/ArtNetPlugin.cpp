@@ -101,6 +101,10 @@ bool ArtNetPlugin::SetDefaultPreferences() {
       ArtNetDevice::K_OUTPUT_PORT_KEY,
       UIntValidator(0, 16),
       ArtNetDevice::K_DEFAULT_OUTPUT_PORT_COUNT);
+  save |= m_preferences->SetDefaultValue(
+      ArtNetDevice::K_RDM_MAX_IN_FLIGHT_KEY,
+      UIntValidator(1, ArtNetDevice::K_MAX_RDM_MAX_IN_FLIGHT),
+      ArtNetDevice::K_DEFAULT_RDM_MAX_IN_FLIGHT);
   save |= m_preferences->SetDefaultValue(ArtNetDevice::K_ALWAYS_BROADCAST_KEY,
                                          BoolValidator(),
                                          false);
@@ -40,6 +40,18 @@ noinst_PROGRAMS += plugins/artnet/artnet_loadtest
 plugins_artnet_artnet_loadtest_SOURCES = plugins/artnet/artnet_loadtest.cpp
 plugins_artnet_artnet_loadtest_LDADD = plugins/artnet/libolaartnetnode.la
 
+# The replay driver injects packets using the MockUDPSocket.
+if BUILD_TESTS
+noinst_PROGRAMS += plugins/artnet/artnet_replay
+
+plugins_artnet_artnet_replay_SOURCES = plugins/artnet/artnet_replay.cpp
+plugins_artnet_artnet_replay_CXXFLAGS = $(COMMON_TESTING_FLAGS)
+plugins_artnet_artnet_replay_LDADD = $(CPPUNIT_LIBS) \
+                                     common/network/libolapacketreplay.la \
+                                     common/testing/libolatesting.la \
+                                     plugins/artnet/libolaartnetnode.la
+endif
+
 # TESTS
 ##################################################
 test_programs += plugins/artnet/ArtNetTester
@@ -0,0 +1,129 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * artnet_replay.cpp
+ * Replay a packet capture into an ArtNetNode and measure how it performs.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <stdint.h>
+#include "common/network/PacketCapture.h"
+#include "common/network/PacketReplay.h"
+#include "ola/Callback.h"
+#include "ola/Clock.h"
+#include "ola/DmxBuffer.h"
+#include "ola/Logging.h"
+#include "ola/base/Flags.h"
+#include "ola/base/Init.h"
+#include "ola/base/SysExits.h"
+#include "ola/io/SelectServer.h"
+#include "ola/network/IPV4Address.h"
+#include "ola/network/Interface.h"
+#include "ola/testing/MockUDPSocket.h"
+#include "plugins/artnet/ArtNetNode.h"
+#include "plugins/artnet/ArtNetPackets.h"
+
+using ola::Clock;
+using ola::DmxBuffer;
+using ola::TimeStamp;
+using ola::io::SelectServer;
+using ola::network::CapturedPacket;
+using ola::network::IPV4Address;
+using ola::network::Interface;
+using ola::network::LatencyRecorder;
+using ola::network::PacketCaptureReader;
+using ola::network::PrintReplaySummary;
+using ola::network::WaitForPacket;
+using ola::plugin::artnet::ArtNetNode;
+using ola::plugin::artnet::ArtNetNodeOptions;
+using ola::testing::MockUDPSocket;
+
+DEFINE_s_uint16(speed, s, 1,
+                "The replay speed as a multiple of real time, 0 replays as "
+                "fast as possible.");
+DEFINE_s_uint16(universe, u, 0,
+                "The Art-Net port address of the first output port, the "
+                "other ports use the following addresses.");
+
+DEFINE_s_uint16(port, p, 6454, "Replay the packets sent to this UDP port.");
+
+int main(int argc, char* argv[]) {
+  ola::AppInit(&argc, argv, "<capture-file>",
+               "Replay the Art-Net packets in a pcap file into an "
+               "ArtNetNode.");
+
+  if (argc != 2) {
+    ola::DisplayUsageAndExit();
+  }
+
+  PacketCaptureReader reader;
+  if (!reader.Open(argv[1])) {
+    exit(ola::EXIT_NOINPUT);
+  }
+
+  // The node ignores packets from its own address, so pick one that won't
+  // appear in captures.
+  Interface iface;
+  IPV4Address::FromString("127.0.0.2", &iface.ip_address);
+  IPV4Address::FromString("127.255.255.255", &iface.bcast_address);
+  IPV4Address::FromString("255.0.0.0", &iface.subnet_mask);
+
+  SelectServer ss;
+  Clock clock;
+  LatencyRecorder recorder(&clock);
+  MockUDPSocket *socket = new MockUDPSocket();
+  socket->SetDiscardMode(true);
+
+  ArtNetNodeOptions options;
+  ArtNetNode node(iface, &ss, options, socket);
+  node.SetNetAddress(static_cast<uint8_t>((FLAGS_universe >> 8) & 0x7f));
+  node.SetSubnetAddress(static_cast<uint8_t>((FLAGS_universe >> 4) & 0x0f));
+
+  DmxBuffer buffers[ola::plugin::artnet::ARTNET_MAX_PORTS];
+  for (uint8_t i = 0; i < ola::plugin::artnet::ARTNET_MAX_PORTS; i++) {
+    node.SetOutputPortUniverse(
+        i, static_cast<uint8_t>((FLAGS_universe + i) & 0x0f));
+    node.SetDMXHandler(i, &buffers[i],
+                       ola::NewCallback(&recorder, &LatencyRecorder::NewDMX));
+  }
+
+  if (!node.Start()) {
+    exit(ola::EXIT_UNAVAILABLE);
+  }
+
+  unsigned int packets = 0;
+  CapturedPacket packet;
+  TimeStamp capture_start, replay_start, replay_end;
+  clock.CurrentTime(&replay_start);
+
+  while (reader.Next(&packet)) {
+    if (packet.destination.Port() != FLAGS_port) {
+      continue;
+    }
+    if (packets == 0) {
+      capture_start = packet.timestamp;
+    }
+    WaitForPacket(&clock, FLAGS_speed, replay_start, capture_start,
+                  packet.timestamp);
+    recorder.PacketInjected();
+    socket->InjectData(packet.Data(), packet.Size(), packet.source);
+    packets++;
+  }
+  clock.CurrentTime(&replay_end);
+  node.Stop();
+
+  PrintReplaySummary(packets, replay_end - replay_start, recorder, "DMX");
+  return ola::EXIT_OK;
+}
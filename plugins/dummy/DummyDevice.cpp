@@ -23,6 +23,7 @@
 #include <string.h>
 #include <vector>
 
+#include "olad/PluginAdaptor.h"
 #include "plugins/dummy/DummyDevice.h"
 #include "plugins/dummy/DummyPort.h"
 
@@ -35,7 +36,7 @@ namespace dummy {
  * Start this device
  */
 bool DummyDevice::StartHook() {
-  DummyPort *port = new DummyPort(this, m_port_options, 0);
+  DummyPort *port = new DummyPort(this, m_port_options, 0, m_plugin_adaptor);
 
   if (!AddPort(port)) {
     delete port;
@@ -28,6 +28,7 @@
 namespace ola {
 
 class AbstractPlugin;
+class PluginAdaptor;
 
 namespace plugin {
 namespace dummy {
@@ -37,15 +38,18 @@ class DummyDevice: public Device {
   DummyDevice(
       AbstractPlugin *owner,
       const std::string &name,
-      const DummyPort::Options &port_options)
+      const DummyPort::Options &port_options,
+      PluginAdaptor *plugin_adaptor)
       : Device(owner, name),
-        m_port_options(port_options) {
+        m_port_options(port_options),
+        m_plugin_adaptor(plugin_adaptor) {
   }
 
   std::string DeviceId() const { return "1"; }
 
  protected:
   const DummyPort::Options m_port_options;
+  PluginAdaptor *m_plugin_adaptor;
 
   bool StartHook();
 };
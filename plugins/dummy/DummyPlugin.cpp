@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string>
 
+#include "ola/Logging.h"
 #include "ola/StringUtils.h"
 #include "olad/PluginAdaptor.h"
 #include "olad/Preferences.h"
@@ -46,6 +47,11 @@ const char DummyPlugin::DEVICE_NAME[] = "Dummy Device";
 const char DummyPlugin::DIMMER_COUNT_KEY[] = "dimmer_count";
 const char DummyPlugin::DIMMER_SUBDEVICE_COUNT_KEY[] = "dimmer_subdevice_count";
 const char DummyPlugin::DUMMY_DEVICE_COUNT_KEY[] = "dummy_device_count";
+const char DummyPlugin::FARM_COUNT_KEY[] = "farm_device_count";
+const char DummyPlugin::FARM_MAX_LATENCY_KEY[] = "farm_max_latency_us";
+const char DummyPlugin::FARM_MIN_LATENCY_KEY[] = "farm_min_latency_us";
+const unsigned int DummyPlugin::MAX_FARM_COUNT = 50000;
+const unsigned int DummyPlugin::MAX_FARM_LATENCY = 1000000;
 const char DummyPlugin::MOVING_LIGHT_COUNT_KEY[] = "moving_light_count";
 const char DummyPlugin::NETWORK_COUNT_KEY[] = "network_device_count";
 const char DummyPlugin::PLUGIN_NAME[] = "Dummy";
@@ -100,8 +106,29 @@ bool DummyPlugin::StartHook() {
     options.number_of_network_responders = DEFAULT_DEVICE_COUNT;
   }
 
+  if (!StringToInt(m_preferences->GetValue(FARM_COUNT_KEY) ,
+                   &options.farm.number_of_responders)) {
+    options.farm.number_of_responders = 0;
+  }
+
+  if (!StringToInt(m_preferences->GetValue(FARM_MIN_LATENCY_KEY) ,
+                   &options.farm.min_latency_us)) {
+    options.farm.min_latency_us = ResponderFarm::DEFAULT_MIN_LATENCY;
+  }
+
+  if (!StringToInt(m_preferences->GetValue(FARM_MAX_LATENCY_KEY) ,
+                   &options.farm.max_latency_us)) {
+    options.farm.max_latency_us = ResponderFarm::DEFAULT_MAX_LATENCY;
+  }
+
+  if (options.farm.max_latency_us < options.farm.min_latency_us) {
+    OLA_WARN << FARM_MAX_LATENCY_KEY << " is less than "
+             << FARM_MIN_LATENCY_KEY;
+    options.farm.max_latency_us = options.farm.min_latency_us;
+  }
+
   std::auto_ptr<DummyDevice> device(
-      new DummyDevice(this, DEVICE_NAME, options));
+      new DummyDevice(this, DEVICE_NAME, options, m_plugin_adaptor));
   if (!device->Start()) {
     return false;
   }
@@ -173,6 +200,18 @@ bool DummyPlugin::SetDefaultPreferences() {
                                          IntValidator(0, 254),
                                          DEFAULT_DEVICE_COUNT);
 
+  save |= m_preferences->SetDefaultValue(FARM_COUNT_KEY,
+                                         UIntValidator(0, MAX_FARM_COUNT),
+                                         0);
+
+  save |= m_preferences->SetDefaultValue(FARM_MIN_LATENCY_KEY,
+                                         UIntValidator(0, MAX_FARM_LATENCY),
+                                         ResponderFarm::DEFAULT_MIN_LATENCY);
+
+  save |= m_preferences->SetDefaultValue(FARM_MAX_LATENCY_KEY,
+                                         UIntValidator(0, MAX_FARM_LATENCY),
+                                         ResponderFarm::DEFAULT_MAX_LATENCY);
+
   if (save) {
     m_preferences->Save();
   }
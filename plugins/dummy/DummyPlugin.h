@@ -54,10 +54,15 @@ class DummyPlugin: public Plugin {
     static const uint8_t DEFAULT_DEVICE_COUNT;
     static const uint8_t DEFAULT_ACK_TIMER_DEVICE_COUNT;
     static const uint16_t DEFAULT_SUBDEVICE_COUNT;
+    static const unsigned int MAX_FARM_COUNT;
+    static const unsigned int MAX_FARM_LATENCY;
     static const char DEVICE_NAME[];
     static const char DIMMER_COUNT_KEY[];
     static const char DIMMER_SUBDEVICE_COUNT_KEY[];
     static const char DUMMY_DEVICE_COUNT_KEY[];
+    static const char FARM_COUNT_KEY[];
+    static const char FARM_MAX_LATENCY_KEY[];
+    static const char FARM_MIN_LATENCY_KEY[];
     static const char MOVING_LIGHT_COUNT_KEY[];
     static const char NETWORK_COUNT_KEY[];
     static const char PLUGIN_NAME[];
@@ -72,7 +72,8 @@ void AddResponders(map<UID, ola::rdm::RDMControllerInterface*> *responders,
 
 DummyPort::DummyPort(DummyDevice *parent,
                      const Options &options,
-                     unsigned int id)
+                     unsigned int id,
+                     ola::thread::SchedulerInterface *scheduler)
     : BasicOutputPort(parent, id, true, true) {
   UID first_uid(OPEN_LIGHTING_ESTA_CODE, DummyPort::kStartAddress);
   ola::rdm::UIDAllocator allocator(first_uid);
@@ -103,6 +104,10 @@ DummyPort::DummyPort(DummyDevice *parent,
       &m_responders, &allocator, options.number_of_sensor_responders);
   AddResponders<ola::rdm::NetworkResponder>(
       &m_responders, &allocator, options.number_of_network_responders);
+
+  if (options.farm.number_of_responders) {
+    m_farm.reset(new ResponderFarm(options.farm, scheduler));
+  }
 }
 
 
@@ -121,11 +126,11 @@ bool DummyPort::WriteDMX(const DmxBuffer &buffer,
 }
 
 void DummyPort::RunFullDiscovery(RDMDiscoveryCallback *callback) {
-  RunDiscovery(callback);
+  RunDiscovery(true, callback);
 }
 
 void DummyPort::RunIncrementalDiscovery(RDMDiscoveryCallback *callback) {
-  RunDiscovery(callback);
+  RunDiscovery(false, callback);
 }
 
 void DummyPort::SendRDMRequest(ola::rdm::RDMRequest *request_ptr,
@@ -138,7 +143,7 @@ void DummyPort::SendRDMRequest(ola::rdm::RDMRequest *request_ptr,
       RunRDMCallback(callback, ola::rdm::RDM_WAS_BROADCAST);
     } else {
       broadcast_request_tracker *tracker = new broadcast_request_tracker;
-      tracker->expected_count = m_responders.size();
+      tracker->expected_count = m_responders.size() + (m_farm.get() ? 1 : 0);
       tracker->current_count = 0;
       tracker->failed = false;
       tracker->callback = callback;
@@ -148,12 +153,19 @@ void DummyPort::SendRDMRequest(ola::rdm::RDMRequest *request_ptr,
           request->Duplicate(),
           NewSingleCallback(this, &DummyPort::HandleBroadcastAck, tracker));
       }
+      if (m_farm.get()) {
+        m_farm->SendRDMRequest(
+          request->Duplicate(),
+          NewSingleCallback(this, &DummyPort::HandleBroadcastAck, tracker));
+      }
     }
   } else {
     ola::rdm::RDMControllerInterface *controller = STLFindOrNull(
         m_responders, dest);
     if (controller) {
       controller->SendRDMRequest(request.release(), callback);
+    } else if (m_farm.get() && m_farm->Contains(dest)) {
+      m_farm->SendRDMRequest(request.release(), callback);
     } else {
       RunRDMCallback(callback, ola::rdm::RDM_UNKNOWN_UID);
     }
@@ -161,7 +173,14 @@ void DummyPort::SendRDMRequest(ola::rdm::RDMRequest *request_ptr,
 }
 
 
-void DummyPort::RunDiscovery(RDMDiscoveryCallback *callback) {
+void DummyPort::RunDiscovery(bool full, RDMDiscoveryCallback *callback) {
+  if (m_farm.get()) {
+    m_farm->RunDiscovery(
+        full,
+        NewSingleCallback(this, &DummyPort::FarmDiscoveryComplete, callback));
+    return;
+  }
+
   ola::rdm::UIDSet uid_set;
   for (ResponderMap::iterator i = m_responders.begin();
     i != m_responders.end(); i++) {
@@ -171,6 +190,17 @@ void DummyPort::RunDiscovery(RDMDiscoveryCallback *callback) {
 }
 
 
+void DummyPort::FarmDiscoveryComplete(RDMDiscoveryCallback *callback,
+                                      const ola::rdm::UIDSet &farm_uids) {
+  ola::rdm::UIDSet uid_set(farm_uids);
+  for (ResponderMap::iterator i = m_responders.begin();
+    i != m_responders.end(); i++) {
+    uid_set.AddUID(i->first);
+  }
+  callback->Run(uid_set);
+}
+
+
 void DummyPort::HandleBroadcastAck(broadcast_request_tracker *tracker,
                                    ola::rdm::RDMReply *reply) {
   tracker->current_count++;
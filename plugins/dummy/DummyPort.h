@@ -22,6 +22,7 @@
 #define PLUGINS_DUMMY_DUMMYPORT_H_
 
 #include <stdint.h>
+#include <memory>
 #include <string>
 #include <map>
 #include <vector>
@@ -30,7 +31,10 @@
 #include "ola/rdm/RDMControllerInterface.h"
 #include "ola/rdm/RDMEnums.h"
 #include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+#include "ola/thread/SchedulerInterface.h"
 #include "olad/Port.h"
+#include "plugins/dummy/ResponderFarm.h"
 
 namespace ola {
 namespace plugin {
@@ -59,6 +63,7 @@ class DummyPort: public BasicOutputPort {
     uint8_t number_of_advanced_dimmers;
     uint8_t number_of_sensor_responders;
     uint8_t number_of_network_responders;
+    ResponderFarm::Options farm;
   };
 
 
@@ -68,10 +73,13 @@ class DummyPort: public BasicOutputPort {
    * @param options the config for the DummyPort such as the number of fake RDM
    * devices to create
    * @param id the ID of this port
+   * @param scheduler the scheduler used to delay the responses from the
+   *   responder farm, may be NULL.
    */
   DummyPort(class DummyDevice *parent,
             const Options &options,
-            unsigned int id);
+            unsigned int id,
+            ola::thread::SchedulerInterface *scheduler = NULL);
   virtual ~DummyPort();
   bool WriteDMX(const DmxBuffer &buffer, uint8_t priority);
   std::string Description() const { return "Dummy Port"; }
@@ -97,8 +105,11 @@ class DummyPort: public BasicOutputPort {
 
   DmxBuffer m_buffer;
   ResponderMap m_responders;
+  std::auto_ptr<ResponderFarm> m_farm;
 
-  void RunDiscovery(ola::rdm::RDMDiscoveryCallback *callback);
+  void RunDiscovery(bool full, ola::rdm::RDMDiscoveryCallback *callback);
+  void FarmDiscoveryComplete(ola::rdm::RDMDiscoveryCallback *callback,
+                             const ola::rdm::UIDSet &farm_uids);
   void HandleBroadcastAck(broadcast_request_tracker *tracker,
                           ola::rdm::RDMReply *reply);
 
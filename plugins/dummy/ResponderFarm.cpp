@@ -0,0 +1,304 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ResponderFarm.cpp
+ * Simulates a line with a large number of RDM responders.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <string.h>
+#include <memory>
+#include <string>
+#include "ola/Logging.h"
+#include "ola/math/Random.h"
+#include "ola/rdm/RDMCommand.h"
+#include "plugins/dummy/ResponderFarm.h"
+
+namespace ola {
+namespace plugin {
+namespace dummy {
+
+using ola::rdm::DummyResponder;
+using ola::rdm::RDMCallback;
+using ola::rdm::RDMDiscoveryCallback;
+using ola::rdm::RDMReply;
+using ola::rdm::RDMRequest;
+using ola::rdm::RunRDMCallback;
+using ola::rdm::UID;
+using ola::rdm::UIDSet;
+using ola::thread::INVALID_TIMEOUT;
+using std::auto_ptr;
+using std::string;
+
+namespace {
+/*
+ * The replies to broadcasts are discarded.
+ */
+void DiscardReply(RDMReply*) {}
+
+/*
+ * OR a byte into a DUB response and add it to the checksum.
+ */
+void OrAndChecksum(uint8_t *data, unsigned int offset, uint8_t value,
+                   uint16_t *checksum) {
+  data[offset] |= value;
+  *checksum += value;
+}
+}  // namespace
+
+const unsigned int ResponderFarm::DEFAULT_MIN_LATENCY;
+const unsigned int ResponderFarm::DEFAULT_MAX_LATENCY;
+const uint16_t ResponderFarm::PROTOTYPE_ESTA_ID;
+const unsigned int ResponderFarm::DUB_RESPONSE_SIZE;
+
+ResponderFarm::ResponderFarm(const Options &options,
+                             ola::thread::SchedulerInterface *scheduler)
+    : m_options(options),
+      m_scheduler(scheduler),
+      m_discovery_agent(this),
+      m_discovery_timeout(INVALID_TIMEOUT),
+      m_discovery_action(NULL) {
+  // A fixed LCG, so the UIDs don't change when olad restarts.
+  uint32_t seed = 0x4f4c4121;
+  while (m_responders.size() < options.number_of_responders) {
+    seed = seed * 1664525 + 1013904223;
+    UID uid(PROTOTYPE_ESTA_ID, seed);
+    if (uid.IsBroadcast() || m_responders.find(uid) != m_responders.end()) {
+      continue;
+    }
+    SimulatedResponder &simulated = m_responders[uid];
+    simulated.responder = new DummyResponder(uid);
+    simulated.muted = false;
+  }
+}
+
+ResponderFarm::~ResponderFarm() {
+  m_discovery_agent.Abort();
+  if (m_discovery_action) {
+    m_scheduler->RemoveTimeout(m_discovery_timeout);
+    delete m_discovery_action;
+  }
+
+  PendingRequests::iterator pending_iter = m_pending_requests.begin();
+  for (; pending_iter != m_pending_requests.end(); ++pending_iter) {
+    PendingRequest *pending = *pending_iter;
+    m_scheduler->RemoveTimeout(pending->timeout);
+    delete pending->request;
+    RunRDMCallback(pending->callback, ola::rdm::RDM_FAILED_TO_SEND);
+    delete pending;
+  }
+
+  ResponderMap::iterator iter = m_responders.begin();
+  for (; iter != m_responders.end(); ++iter) {
+    delete iter->second.responder;
+  }
+}
+
+bool ResponderFarm::Contains(const UID &uid) const {
+  return m_responders.find(uid) != m_responders.end();
+}
+
+void ResponderFarm::SendRDMRequest(RDMRequest *request,
+                                   RDMCallback *callback) {
+  PendingRequest *pending = new PendingRequest;
+  pending->request = request;
+  pending->callback = callback;
+  pending->timeout = INVALID_TIMEOUT;
+
+  if (!m_scheduler) {
+    DeliverRequest(pending);
+    return;
+  }
+
+  m_pending_requests.insert(pending);
+  pending->timeout = m_scheduler->RegisterSingleTimeout(
+      Latency(),
+      NewSingleCallback(this, &ResponderFarm::DeliverRequest, pending));
+}
+
+void ResponderFarm::RunDiscovery(bool full, RDMDiscoveryCallback *callback) {
+  ola::rdm::DiscoveryAgent::DiscoveryCompleteCallback *on_complete =
+      NewSingleCallback(this, &ResponderFarm::DiscoveryComplete, callback);
+  if (full) {
+    m_discovery_agent.StartFullDiscovery(on_complete);
+  } else {
+    m_discovery_agent.StartIncrementalDiscovery(on_complete);
+  }
+}
+
+void ResponderFarm::MuteDevice(const UID &target,
+                               MuteDeviceCallback *mute_complete) {
+  ResponderMap::iterator iter = m_responders.find(target);
+  bool ok = iter != m_responders.end();
+  if (ok) {
+    iter->second.muted = true;
+  }
+  ScheduleDiscoveryAction(
+      NewSingleCallback(mute_complete, &MuteDeviceCallback::Run, ok));
+}
+
+void ResponderFarm::UnMuteAll(UnMuteDeviceCallback *unmute_complete) {
+  ResponderMap::iterator iter = m_responders.begin();
+  for (; iter != m_responders.end(); ++iter) {
+    iter->second.muted = false;
+  }
+  ScheduleDiscoveryAction(
+      NewSingleCallback(unmute_complete, &UnMuteDeviceCallback::Run));
+}
+
+void ResponderFarm::Branch(const UID &lower,
+                           const UID &upper,
+                           BranchCallback *callback) {
+  uint8_t data[DUB_RESPONSE_SIZE];
+  memset(data, 0, DUB_RESPONSE_SIZE);
+  unsigned int responders = 0;
+
+  // Every unmuted responder in the branch replies at the same time.
+  ResponderMap::const_iterator iter = m_responders.lower_bound(lower);
+  for (; iter != m_responders.end() && !(upper < iter->first);
+       ++iter) {
+    if (!iter->second.muted) {
+      OrDUBResponse(iter->first, data);
+      responders++;
+    }
+  }
+
+  // The OR of several responses can occasionally pass the checksum, which
+  // produces a phantom UID. Overlapping frames on a real line are skewed in
+  // time and rarely decode, so drop the last byte to make it a collision.
+  string response;
+  if (responders) {
+    response.assign(reinterpret_cast<char*>(data),
+                    responders == 1 ? DUB_RESPONSE_SIZE :
+                                      DUB_RESPONSE_SIZE - 1);
+  }
+  ScheduleDiscoveryAction(
+      NewSingleCallback(this, &ResponderFarm::RunBranchCallback, callback,
+                        response));
+}
+
+ola::TimeInterval ResponderFarm::Latency() const {
+  int64_t latency = ola::math::Random(m_options.min_latency_us,
+                                      m_options.max_latency_us);
+  return ola::TimeInterval(latency);
+}
+
+void ResponderFarm::DeliverRequest(PendingRequest *pending) {
+  m_pending_requests.erase(pending);
+  auto_ptr<RDMRequest> request(pending->request);
+  RDMCallback *callback = pending->callback;
+  delete pending;
+
+  const UID &dest = request->DestinationUID();
+  if (dest.IsBroadcast()) {
+    ResponderMap::iterator iter = m_responders.begin();
+    for (; iter != m_responders.end(); ++iter) {
+      if (dest.DirectedToUID(iter->first)) {
+        iter->second.responder->SendRDMRequest(
+            request->Duplicate(), NewSingleCallback(DiscardReply));
+      }
+    }
+    RunRDMCallback(callback, ola::rdm::RDM_WAS_BROADCAST);
+    return;
+  }
+
+  ResponderMap::iterator iter = m_responders.find(dest);
+  if (iter == m_responders.end()) {
+    RunRDMCallback(callback, ola::rdm::RDM_TIMEOUT);
+  } else {
+    iter->second.responder->SendRDMRequest(request.release(), callback);
+  }
+}
+
+void ResponderFarm::ScheduleDiscoveryAction(
+    SingleUseCallback0<void> *action) {
+  if (!m_scheduler) {
+    action->Run();
+    return;
+  }
+
+  if (m_discovery_action) {
+    OLA_WARN << "Discovery action already pending";
+    m_scheduler->RemoveTimeout(m_discovery_timeout);
+    delete m_discovery_action;
+  }
+  m_discovery_action = action;
+  m_discovery_timeout = m_scheduler->RegisterSingleTimeout(
+      Latency(),
+      NewSingleCallback(this, &ResponderFarm::RunDiscoveryAction));
+}
+
+void ResponderFarm::RunDiscoveryAction() {
+  SingleUseCallback0<void> *action = m_discovery_action;
+  m_discovery_action = NULL;
+  m_discovery_timeout = INVALID_TIMEOUT;
+  action->Run();
+}
+
+void ResponderFarm::RunBranchCallback(BranchCallback *callback,
+                                      string response) {
+  if (response.empty()) {
+    callback->Run(NULL, 0);
+  } else {
+    callback->Run(reinterpret_cast<const uint8_t*>(response.data()),
+                  response.size());
+  }
+}
+
+void ResponderFarm::DiscoveryComplete(RDMDiscoveryCallback *callback,
+                                      bool ok,
+                                      const UIDSet &uids) {
+  if (!ok) {
+    OLA_WARN << "Discovery of the responder farm failed";
+  }
+  callback->Run(uids);
+}
+
+/*
+ * OR the DUB response for a UID into data, which must be DUB_RESPONSE_SIZE
+ * bytes.
+ */
+void ResponderFarm::OrDUBResponse(const UID &uid, uint8_t *data) {
+  uint16_t manufacturer_id = uid.ManufacturerId();
+  uint32_t device_id = uid.DeviceId();
+
+  for (unsigned int i = 0; i < 7; i++) {
+    data[i] |= 0xfe;
+  }
+  data[7] |= 0xaa;
+
+  uint16_t checksum = 0;
+  OrAndChecksum(data, 8, (manufacturer_id >> 8) | 0xaa, &checksum);
+  OrAndChecksum(data, 9, (manufacturer_id >> 8) | 0x55, &checksum);
+  OrAndChecksum(data, 10, manufacturer_id | 0xaa, &checksum);
+  OrAndChecksum(data, 11, manufacturer_id | 0x55, &checksum);
+
+  OrAndChecksum(data, 12, (device_id >> 24) | 0xaa, &checksum);
+  OrAndChecksum(data, 13, (device_id >> 24) | 0x55, &checksum);
+  OrAndChecksum(data, 14, (device_id >> 16) | 0xaa, &checksum);
+  OrAndChecksum(data, 15, (device_id >> 16) | 0x55, &checksum);
+  OrAndChecksum(data, 16, (device_id >> 8) | 0xaa, &checksum);
+  OrAndChecksum(data, 17, (device_id >> 8) | 0x55, &checksum);
+  OrAndChecksum(data, 18, device_id | 0xaa, &checksum);
+  OrAndChecksum(data, 19, device_id | 0x55, &checksum);
+
+  data[20] |= (checksum >> 8) | 0xaa;
+  data[21] |= (checksum >> 8) | 0x55;
+  data[22] |= checksum | 0xaa;
+  data[23] |= checksum | 0x55;
+}
+}  // namespace dummy
+}  // namespace plugin
+}  // namespace ola
@@ -0,0 +1,162 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ResponderFarm.h
+ * Simulates a line with a large number of RDM responders.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef PLUGINS_DUMMY_RESPONDERFARM_H_
+#define PLUGINS_DUMMY_RESPONDERFARM_H_
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include "ola/Callback.h"
+#include "ola/base/Macro.h"
+#include "ola/rdm/DiscoveryAgent.h"
+#include "ola/rdm/DummyResponder.h"
+#include "ola/rdm/RDMControllerInterface.h"
+#include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+#include "ola/thread/SchedulerInterface.h"
+
+namespace ola {
+namespace plugin {
+namespace dummy {
+
+/**
+ * @brief Simulates a line with thousands of RDM responders.
+ *
+ * Each responder is a DummyResponder with a pseudo-random UID from the
+ * prototyping manufacturer range, so the UIDs are spread across the UID space
+ * like a real rig. The UIDs are the same each time the farm is created.
+ *
+ * Discovery runs the DiscoveryAgent against the simulated line. The DUB
+ * responses from all unmuted responders in a branch are OR'ed together, as
+ * they would be on the wire, so collisions have to be resolved the same way
+ * as with real hardware.
+ *
+ * Each request, and each step of discovery, completes after a random delay
+ * between the minimum and maximum latency. If no scheduler is provided, they
+ * complete immediately. Discovery then recurses once per step, so this is only
+ * suitable for small farms in tests.
+ */
+class ResponderFarm: public ola::rdm::DiscoveryTargetInterface {
+ public:
+  struct Options {
+   public:
+    Options()
+        : number_of_responders(0),
+          min_latency_us(DEFAULT_MIN_LATENCY),
+          max_latency_us(DEFAULT_MAX_LATENCY) {
+    }
+
+    unsigned int number_of_responders;
+    unsigned int min_latency_us;
+    unsigned int max_latency_us;
+  };
+
+  /**
+   * @brief Create a new ResponderFarm.
+   * @param options the Options for the farm.
+   * @param scheduler the scheduler used to delay the responses, may be NULL.
+   */
+  ResponderFarm(const Options &options,
+                ola::thread::SchedulerInterface *scheduler);
+  ~ResponderFarm();
+
+  /**
+   * @brief The number of responders in the farm.
+   */
+  unsigned int Size() const {
+    return static_cast<unsigned int>(m_responders.size());
+  }
+
+  /**
+   * @brief Check if a responder is part of the farm.
+   */
+  bool Contains(const ola::rdm::UID &uid) const;
+
+  /**
+   * @brief Send a request to one, or for broadcasts all, of the responders.
+   */
+  void SendRDMRequest(ola::rdm::RDMRequest *request,
+                      ola::rdm::RDMCallback *callback);
+
+  /**
+   * @brief Discover the responders using DUB.
+   * @param full true for a full discovery, false for an incremental one.
+   * @param callback run with the UIDs that were found.
+   */
+  void RunDiscovery(bool full, ola::rdm::RDMDiscoveryCallback *callback);
+
+  // DiscoveryTargetInterface methods.
+  void MuteDevice(const ola::rdm::UID &target,
+                  MuteDeviceCallback *mute_complete);
+  void UnMuteAll(UnMuteDeviceCallback *unmute_complete);
+  void Branch(const ola::rdm::UID &lower,
+              const ola::rdm::UID &upper,
+              BranchCallback *callback);
+
+  static const unsigned int DEFAULT_MIN_LATENCY = 2000;
+  static const unsigned int DEFAULT_MAX_LATENCY = 3000;
+
+  // The E1.20 manufacturer ID reserved for prototyping.
+  static const uint16_t PROTOTYPE_ESTA_ID = 0x7ff0;
+
+ private:
+  struct SimulatedResponder {
+    ola::rdm::DummyResponder *responder;
+    bool muted;
+  };
+
+  struct PendingRequest {
+    ola::rdm::RDMRequest *request;
+    ola::rdm::RDMCallback *callback;
+    ola::thread::timeout_id timeout;
+  };
+
+  typedef std::map<ola::rdm::UID, SimulatedResponder> ResponderMap;
+  typedef std::set<PendingRequest*> PendingRequests;
+
+  const Options m_options;
+  ola::thread::SchedulerInterface *m_scheduler;
+  ResponderMap m_responders;
+  PendingRequests m_pending_requests;
+  ola::rdm::DiscoveryAgent m_discovery_agent;
+  ola::thread::timeout_id m_discovery_timeout;
+  SingleUseCallback0<void> *m_discovery_action;
+
+  ola::TimeInterval Latency() const;
+  void DeliverRequest(PendingRequest *pending);
+  void ScheduleDiscoveryAction(SingleUseCallback0<void> *action);
+  void RunDiscoveryAction();
+  void RunBranchCallback(BranchCallback *callback, std::string response);
+  void DiscoveryComplete(ola::rdm::RDMDiscoveryCallback *callback,
+                         bool ok,
+                         const ola::rdm::UIDSet &uids);
+
+  static void OrDUBResponse(const ola::rdm::UID &uid, uint8_t *data);
+
+  static const unsigned int DUB_RESPONSE_SIZE = 24;
+
+  DISALLOW_COPY_AND_ASSIGN(ResponderFarm);
+};
+}  // namespace dummy
+}  // namespace plugin
+}  // namespace ola
+#endif  // PLUGINS_DUMMY_RESPONDERFARM_H_
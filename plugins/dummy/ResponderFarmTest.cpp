@@ -0,0 +1,226 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ResponderFarmTest.cpp
+ * Test fixture for the ResponderFarm.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ola/Callback.h"
+#include "ola/Logging.h"
+#include "ola/io/SelectServer.h"
+#include "ola/rdm/RDMCommand.h"
+#include "ola/rdm/RDMEnums.h"
+#include "ola/rdm/RDMReply.h"
+#include "ola/rdm/UID.h"
+#include "ola/rdm/UIDSet.h"
+#include "ola/testing/TestUtils.h"
+#include "plugins/dummy/DummyPort.h"
+#include "plugins/dummy/ResponderFarm.h"
+
+using ola::io::SelectServer;
+using ola::plugin::dummy::DummyPort;
+using ola::plugin::dummy::ResponderFarm;
+using ola::rdm::RDMGetRequest;
+using ola::rdm::RDMReply;
+using ola::rdm::RDMRequest;
+using ola::rdm::RDMSetRequest;
+using ola::rdm::UID;
+using ola::rdm::UIDSet;
+
+class ResponderFarmTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(ResponderFarmTest);
+  CPPUNIT_TEST(testDiscovery);
+  CPPUNIT_TEST(testRequests);
+  CPPUNIT_TEST(testLatency);
+  CPPUNIT_TEST(testDummyPort);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  ResponderFarmTest()
+      : m_source(1, 2),
+        m_replies(0),
+        m_status_code(ola::rdm::RDM_FAILED_TO_SEND) {
+  }
+
+  void setUp() {
+    ola::InitLogging(ola::OLA_LOG_WARN, ola::OLA_LOG_STDERR);
+    m_uids.Clear();
+    m_replies = 0;
+    m_status_code = ola::rdm::RDM_FAILED_TO_SEND;
+  }
+
+  void testDiscovery();
+  void testRequests();
+  void testLatency();
+  void testDummyPort();
+
+ private:
+  UID m_source;
+  UIDSet m_uids;
+  unsigned int m_replies;
+  ola::rdm::RDMStatusCode m_status_code;
+  SelectServer m_ss;
+
+  void DiscoveryComplete(const UIDSet &uids) {
+    m_uids = uids;
+    m_ss.Terminate();
+  }
+
+  void HandleReply(RDMReply *reply) {
+    m_replies++;
+    m_status_code = reply->StatusCode();
+  }
+
+  RDMRequest *NewDeviceInfoRequest(const UID &destination) {
+    return new RDMGetRequest(m_source, destination, 0, 1, 0,
+                             ola::rdm::PID_DEVICE_INFO, NULL, 0);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ResponderFarmTest);
+
+
+/*
+ * Check that DUB discovery finds all the responders.
+ */
+void ResponderFarmTest::testDiscovery() {
+  ResponderFarm::Options options;
+  options.number_of_responders = 1000;
+  options.min_latency_us = 0;
+  options.max_latency_us = 0;
+  ResponderFarm farm(options, &m_ss);
+  OLA_ASSERT_EQ(1000u, farm.Size());
+
+  farm.RunDiscovery(true, ola::NewSingleCallback(
+      this, &ResponderFarmTest::DiscoveryComplete));
+  m_ss.Run();
+  OLA_ASSERT_EQ(1000u, m_uids.Size());
+
+  UIDSet::Iterator iter = m_uids.Begin();
+  for (; iter != m_uids.End(); ++iter) {
+    OLA_ASSERT_EQ(ResponderFarm::PROTOTYPE_ESTA_ID, iter->ManufacturerId());
+    OLA_ASSERT_TRUE(farm.Contains(*iter));
+  }
+
+  // The UIDs are the same each time the farm is created.
+  ResponderFarm other_farm(options, &m_ss);
+  other_farm.RunDiscovery(false, ola::NewSingleCallback(
+      this, &ResponderFarmTest::DiscoveryComplete));
+  m_ss.Run();
+  OLA_ASSERT_EQ(1000u, m_uids.Size());
+  for (iter = m_uids.Begin(); iter != m_uids.End(); ++iter) {
+    OLA_ASSERT_TRUE(farm.Contains(*iter));
+  }
+}
+
+
+/*
+ * Check that requests are answered by the responders.
+ */
+void ResponderFarmTest::testRequests() {
+  ResponderFarm::Options options;
+  options.number_of_responders = 10;
+  ResponderFarm farm(options, NULL);
+  farm.RunDiscovery(true, ola::NewSingleCallback(
+      this, &ResponderFarmTest::DiscoveryComplete));
+  OLA_ASSERT_EQ(10u, m_uids.Size());
+
+  UIDSet::Iterator iter = m_uids.Begin();
+  for (; iter != m_uids.End(); ++iter) {
+    farm.SendRDMRequest(
+        NewDeviceInfoRequest(*iter),
+        ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+    OLA_ASSERT_EQ(ola::rdm::RDM_COMPLETED_OK, m_status_code);
+  }
+  OLA_ASSERT_EQ(10u, m_replies);
+
+  uint8_t identify_on = 1;
+  farm.SendRDMRequest(
+      new RDMSetRequest(m_source, UID::AllDevices(), 0, 1, 0,
+                        ola::rdm::PID_IDENTIFY_DEVICE, &identify_on,
+                        sizeof(identify_on)),
+      ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+  OLA_ASSERT_EQ(ola::rdm::RDM_WAS_BROADCAST, m_status_code);
+
+  farm.SendRDMRequest(
+      NewDeviceInfoRequest(UID(1, 2)),
+      ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+  OLA_ASSERT_EQ(ola::rdm::RDM_TIMEOUT, m_status_code);
+  OLA_ASSERT_EQ(12u, m_replies);
+}
+
+
+/*
+ * Check that responses are delayed when a scheduler is provided.
+ */
+void ResponderFarmTest::testLatency() {
+  ResponderFarm::Options options;
+  options.number_of_responders = 20;
+  options.min_latency_us = 100;
+  options.max_latency_us = 200;
+  ResponderFarm farm(options, &m_ss);
+
+  farm.RunDiscovery(true, ola::NewSingleCallback(
+      this, &ResponderFarmTest::DiscoveryComplete));
+  OLA_ASSERT_EQ(0u, m_uids.Size());
+  m_ss.Run();
+  OLA_ASSERT_EQ(20u, m_uids.Size());
+
+  farm.SendRDMRequest(
+      NewDeviceInfoRequest(*m_uids.Begin()),
+      ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+  OLA_ASSERT_EQ(0u, m_replies);
+  while (m_replies == 0) {
+    m_ss.RunOnce(ola::TimeInterval(0, 1000));
+  }
+  OLA_ASSERT_EQ(ola::rdm::RDM_COMPLETED_OK, m_status_code);
+
+  // Requests still pending when the farm is destroyed fail.
+  {
+    ResponderFarm other_farm(options, &m_ss);
+    other_farm.SendRDMRequest(
+        NewDeviceInfoRequest(*m_uids.Begin()),
+        ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+  }
+  OLA_ASSERT_EQ(2u, m_replies);
+  OLA_ASSERT_EQ(ola::rdm::RDM_FAILED_TO_SEND, m_status_code);
+}
+
+
+/*
+ * Check the DummyPort reports the farm responders as well as its own.
+ */
+void ResponderFarmTest::testDummyPort() {
+  DummyPort::Options options;
+  options.farm.number_of_responders = 100;
+  DummyPort port(NULL, options, 0);
+
+  port.RunFullDiscovery(ola::NewSingleCallback(
+      this, &ResponderFarmTest::DiscoveryComplete));
+  // The default options create 6 other responders.
+  OLA_ASSERT_EQ(106u, m_uids.Size());
+
+  UIDSet::Iterator iter = m_uids.Begin();
+  for (; iter != m_uids.End(); ++iter) {
+    port.SendRDMRequest(
+        NewDeviceInfoRequest(*iter),
+        ola::NewSingleCallback(this, &ResponderFarmTest::HandleReply));
+    OLA_ASSERT_EQ(ola::rdm::RDM_COMPLETED_OK, m_status_code);
+  }
+  OLA_ASSERT_EQ(106u, m_replies);
+}
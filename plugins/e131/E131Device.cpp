@@ -98,7 +98,12 @@ bool E131Device::StartHook() {
     m_output_ports.push_back(output_port);
   }
 
-  m_plugin_adaptor->AddReadDescriptor(m_node->GetSocket());
+  vector<ola::network::UDPSocket*> sockets;
+  m_node->GetReceiveSockets(&sockets);
+  vector<ola::network::UDPSocket*>::iterator iter = sockets.begin();
+  for (; iter != sockets.end(); ++iter) {
+    m_plugin_adaptor->AddReadDescriptor(*iter);
+  }
   return true;
 }
 
@@ -107,7 +112,12 @@ bool E131Device::StartHook() {
  * Stop this device
  */
 void E131Device::PrePortStop() {
-  m_plugin_adaptor->RemoveReadDescriptor(m_node->GetSocket());
+  vector<ola::network::UDPSocket*> sockets;
+  m_node->GetReceiveSockets(&sockets);
+  vector<ola::network::UDPSocket*>::iterator iter = sockets.begin();
+  for (; iter != sockets.end(); ++iter) {
+    m_plugin_adaptor->RemoveReadDescriptor(*iter);
+  }
 }
 
 
@@ -42,6 +42,7 @@ const char E131Plugin::CID_KEY[] = "cid";
 const unsigned int E131Plugin::DEFAULT_DSCP_VALUE = 0;
 const char E131Plugin::DSCP_KEY[] = "dscp";
 const char E131Plugin::DRAFT_DISCOVERY_KEY[] = "draft_discovery";
+const char E131Plugin::EXTRA_IP_KEY[] = "extra_ip";
 const char E131Plugin::IGNORE_PREVIEW_DATA_KEY[] = "ignore_preview";
 const char E131Plugin::INPUT_PORT_COUNT_KEY[] = "input_ports";
 const char E131Plugin::IP_KEY[] = "ip";
@@ -49,10 +50,15 @@ const char E131Plugin::OUTPUT_PORT_COUNT_KEY[] = "output_ports";
 const char E131Plugin::PLUGIN_NAME[] = "E1.31 (sACN)";
 const char E131Plugin::PLUGIN_PREFIX[] = "e131";
 const char E131Plugin::PREPEND_HOSTNAME_KEY[] = "prepend_hostname";
+const char E131Plugin::RECEIVE_SOCKETS_KEY[] = "receive_sockets";
+const char E131Plugin::REFRESH_INTERVAL_KEY[] = "refresh_interval";
 const char E131Plugin::REVISION_0_2[] = "0.2";
 const char E131Plugin::REVISION_0_46[] = "0.46";
 const char E131Plugin::REVISION_KEY[] = "revision";
+const char E131Plugin::SUPPRESS_UNCHANGED_KEY[] = "suppress_unchanged";
 const unsigned int E131Plugin::DEFAULT_PORT_COUNT = 5;
+const unsigned int E131Plugin::MAX_RECEIVE_SOCKETS = 64;
+const unsigned int E131Plugin::MAX_REFRESH_INTERVAL = 2000;
 
 
 /*
@@ -86,6 +92,22 @@ bool E131Plugin::StartHook() {
     options.dscp = dscp << 2;
   }
 
+  options.extra_interfaces = m_preferences->GetMultipleValue(EXTRA_IP_KEY);
+
+  if (!StringToInt(m_preferences->GetValue(RECEIVE_SOCKETS_KEY),
+                   &options.receive_sockets)) {
+    OLA_WARN << "Invalid value for receive_sockets";
+    options.receive_sockets = 1;
+  }
+
+  options.suppress_unchanged = m_preferences->GetValueAsBool(
+      SUPPRESS_UNCHANGED_KEY);
+  if (!StringToInt(m_preferences->GetValue(REFRESH_INTERVAL_KEY),
+                   &options.refresh_interval)) {
+    OLA_WARN << "Invalid value for refresh_interval";
+    options.refresh_interval = 0;
+  }
+
   if (!StringToInt(m_preferences->GetValue(INPUT_PORT_COUNT_KEY),
                    &options.input_ports)) {
     OLA_WARN << "Invalid value for input_ports";
@@ -180,6 +202,21 @@ bool E131Plugin::SetDefaultPreferences() {
       BoolValidator(),
       true);
 
+  save |= m_preferences->SetDefaultValue(
+      RECEIVE_SOCKETS_KEY,
+      UIntValidator(1, MAX_RECEIVE_SOCKETS),
+      1);
+
+  save |= m_preferences->SetDefaultValue(
+      REFRESH_INTERVAL_KEY,
+      UIntValidator(0, MAX_REFRESH_INTERVAL),
+      0);
+
+  save |= m_preferences->SetDefaultValue(
+      SUPPRESS_UNCHANGED_KEY,
+      BoolValidator(),
+      false);
+
   std::set<string> revision_values;
   revision_values.insert(REVISION_0_2);
   revision_values.insert(REVISION_0_46);
@@ -54,6 +54,7 @@ class E131Plugin: public ola::Plugin {
     static const unsigned int DEFAULT_PORT_COUNT;
     static const char DRAFT_DISCOVERY_KEY[];
     static const char DSCP_KEY[];
+    static const char EXTRA_IP_KEY[];
     static const char IGNORE_PREVIEW_DATA_KEY[];
     static const char INPUT_PORT_COUNT_KEY[];
     static const char IP_KEY[];
@@ -61,9 +62,14 @@ class E131Plugin: public ola::Plugin {
     static const char PLUGIN_NAME[];
     static const char PLUGIN_PREFIX[];
     static const char PREPEND_HOSTNAME_KEY[];
+    static const char RECEIVE_SOCKETS_KEY[];
+    static const char REFRESH_INTERVAL_KEY[];
     static const char REVISION_0_2[];
     static const char REVISION_0_46[];
     static const char REVISION_KEY[];
+    static const char SUPPRESS_UNCHANGED_KEY[];
+    static const unsigned int MAX_REFRESH_INTERVAL;
+    static const unsigned int MAX_RECEIVE_SOCKETS;
 };
 }  // namespace e131
 }  // namespace plugin
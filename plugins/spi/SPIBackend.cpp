@@ -162,7 +162,7 @@ void HardwareBackend::Commit(uint8_t output) {
   OutputData *output_data = m_output_data[output];
   if (output_data->IsPending() && m_drop_map) {
     // There was already another write pending which we're now stomping on
-    (*m_drop_map)[m_spi_writer->DevicePath()]++;
+    m_drop_map->Increment(m_spi_writer->DevicePath());
   }
   output_data->SetPending();
   m_mutex.Unlock();
@@ -394,7 +394,7 @@ void SoftwareBackend::Commit(uint8_t output) {
   if (should_write) {
     if (m_write_pending && m_drop_map) {
       // There was already another write pending which we're now stomping on
-      (*m_drop_map)[m_spi_writer->DevicePath()]++;
+      m_drop_map->Increment(m_spi_writer->DevicePath());
     }
     m_write_pending = should_write;
   }
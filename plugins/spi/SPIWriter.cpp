@@ -111,14 +111,14 @@ bool SPIWriter::WriteSPIData(const uint8_t *data, unsigned int length) {
   spi.len = length;
 
   if (m_write_map_var) {
-    (*m_write_map_var)[m_device_path]++;
+    m_write_map_var->Increment(m_device_path);
   }
 
   int bytes_written = ioctl(m_fd, SPI_IOC_MESSAGE(1), &spi);
   if (bytes_written != static_cast<int>(length)) {
     OLA_WARN << "Failed to write all the SPI data: " << strerror(errno);
     if (m_error_map_var) {
-      (*m_error_map_var)[m_device_path]++;
+      m_error_map_var->Increment(m_device_path);
     }
     return false;
   }
@@ -697,6 +697,27 @@ class RDMResponse(object):
       return "UNKNOWN_CC"
 
 
+class RDMOperation(object):
+  """A single request in a bulk RDM operation, see OlaClient.RDMBulk().
+
+  Attributes:
+    universe: The universe to send the request on.
+    uid: A UID object.
+    sub_device: The sub device index.
+    param_id: The param ID.
+    data: The data to send.
+    is_set: True for a SET, False for a GET.
+  """
+  def __init__(self, universe, uid, sub_device, param_id, data='',
+               is_set=False):
+    self.universe = universe
+    self.uid = uid
+    self.sub_device = sub_device
+    self.param_id = param_id
+    self.data = data
+    self.is_set = is_set
+
+
 class OlaClient(Ola_pb2.OlaClientService):
   """The client used to communicate with olad."""
   def __init__(self, our_socket=None, close_callback=None):
@@ -888,6 +909,63 @@ class OlaClient(Ola_pb2.OlaClientService):
       raise OLADNotRunningException()
     return True
 
+  def FetchBulkDmx(self, universes, callback):
+    """Fetch DMX data for several universes from the server
+
+    Args:
+      universes: a list of universes to fetch the data for
+      callback: The function to call once complete, takes two arguments, a
+        RequestStatus object and a dict of universe number to dmx data.
+        Universes which don't exist are left out.
+
+    Returns:
+      True if the request was sent, False otherwise.
+    """
+    if self._socket is None:
+      return False
+
+    controller = SimpleRpcController()
+    request = Ola_pb2.UniverseListRequest()
+    request.universe.extend(universes)
+    try:
+      self._stub.GetDmxBulk(
+          controller, request,
+          lambda x, y: self._GetDmxBulkComplete(callback, x, y))
+    except socket.error:
+      raise OLADNotRunningException()
+    return True
+
+  def SendBulkDmx(self, data, callback=None):
+    """Send DMX data for several universes to the server
+
+    The universes are all updated together. If any of them don't exist, none
+    are updated.
+
+    Args:
+      data: a dict of universe number to an array object with the DMX data
+      callback: The function to call once complete, takes one argument, a
+        RequestStatus object.
+
+    Returns:
+      True if the request was sent, False otherwise.
+    """
+    if self._socket is None:
+      return False
+
+    controller = SimpleRpcController()
+    request = Ola_pb2.DmxDataBulk()
+    for universe, dmx in sorted(data.items()):
+      universe_data = request.data.add()
+      universe_data.universe = universe
+      universe_data.data = dmx.tostring()
+    try:
+      self._stub.UpdateDmxDataBulk(
+          controller, request,
+          lambda x, y: self._AckMessageComplete(callback, x, y))
+    except socket.error:
+      raise OLADNotRunningException()
+    return True
+
   def SetUniverseName(self, universe, name, callback=None):
     """Set the name of a universe.
 
@@ -1150,7 +1228,7 @@ class OlaClient(Ola_pb2.OlaClientService):
     return True
 
   def RDMGet(self, universe, uid, sub_device, param_id, callback, data='',
-             include_frames=False):
+             include_frames=False, cache_first=False):
     """Send an RDM get command.
 
     Args:
@@ -1161,6 +1239,8 @@ class OlaClient(Ola_pb2.OlaClientService):
       callback: The function to call once complete, takes a RDMResponse object
       data: the data to send
       include_frames: True if the response should include the raw frame data.
+      cache_first: True to allow olad to answer from its cache, rather than
+        sending the request to the responder.
 
     Returns:
       True if the request was sent, False otherwise.
@@ -1169,7 +1249,7 @@ class OlaClient(Ola_pb2.OlaClientService):
       return False
 
     return self._RDMMessage(universe, uid, sub_device, param_id, callback,
-                            data, include_frames)
+                            data, include_frames, cache_first=cache_first)
 
   def RDMSet(self, universe, uid, sub_device, param_id, callback, data='',
              include_frames=False):
@@ -1193,6 +1273,47 @@ class OlaClient(Ola_pb2.OlaClientService):
     return self._RDMMessage(universe, uid, sub_device, param_id, callback,
                             data, include_frames, set=True)
 
+  def RDMBulk(self, operations, callback, include_frames=False,
+              cache_first=False):
+    """Send a batch of RDM commands. olad sends them without waiting for the
+      earlier ones to complete, up to 1000 operations can be sent at once.
+
+    Args:
+      operations: A list of RDMOperation objects.
+      callback: The function to call once complete, takes a list of
+        RDMResponse objects, in the same order as the operations.
+      include_frames: True if the responses should include the raw frame data.
+      cache_first: True to allow olad to answer the GETs from its cache.
+
+    Returns:
+      True if the request was sent, False otherwise.
+    """
+    if self._socket is None:
+      return False
+
+    controller = SimpleRpcController()
+    request = Ola_pb2.RDMBulkRequest()
+    for operation in operations:
+      rdm_request = request.request.add()
+      rdm_request.universe = operation.universe
+      rdm_request.uid.esta_id = operation.uid.manufacturer_id
+      rdm_request.uid.device_id = operation.uid.device_id
+      rdm_request.sub_device = operation.sub_device
+      rdm_request.param_id = operation.param_id
+      rdm_request.data = operation.data
+      rdm_request.is_set = operation.is_set
+      rdm_request.include_raw_response = include_frames
+      rdm_request.bulk = True
+      rdm_request.cache_first = cache_first
+    try:
+      self._stub.RDMBulkCommand(
+          controller, request,
+          lambda x, y: self._RDMBulkCommandComplete(
+              callback, len(operations), x, y))
+    except socket.error:
+      raise OLADNotRunningException()
+    return True
+
   def SendRawRDMDiscovery(self,
                           universe,
                           uid,
@@ -1274,7 +1395,7 @@ class OlaClient(Ola_pb2.OlaClientService):
     return True
 
   def _RDMMessage(self, universe, uid, sub_device, param_id, callback, data,
-                  include_frames, set=False):
+                  include_frames, set=False, cache_first=False):
     controller = SimpleRpcController()
     request = Ola_pb2.RDMRequest()
     request.universe = universe
@@ -1285,6 +1406,7 @@ class OlaClient(Ola_pb2.OlaClientService):
     request.data = data
     request.is_set = set
     request.include_raw_response = include_frames
+    request.cache_first = cache_first
     try:
       self._stub.RDMCommand(
           controller, request,
@@ -1402,6 +1524,28 @@ class OlaClient(Ola_pb2.OlaClientService):
 
     callback(status, universe, data)
 
+  def _GetDmxBulkComplete(self, callback, controller, response):
+    """Called when the GetDmxBulk request returns.
+
+    Args:
+      callback: the callback to run
+      controller: an RpcController
+      response: a DmxDataBulk message.
+    """
+    if not callback:
+      return
+    status = RequestStatus(controller)
+    data = None
+
+    if status.Succeeded():
+      data = {}
+      for universe_data in response.data:
+        dmx = array.array('B')
+        dmx.fromstring(universe_data.data)
+        data[universe_data.universe] = dmx
+
+    callback(status, data)
+
   def _AckMessageComplete(self, callback, controller, response):
     """Called when an rpc that returns an Ack completes.
 
@@ -1468,6 +1612,23 @@ class OlaClient(Ola_pb2.OlaClientService):
       return
     callback(RDMResponse(controller, response))
 
+  def _RDMBulkCommandComplete(self, callback, count, controller, response):
+    """Called when a bulk RDM request completes.
+
+    Args:
+      callback: the callback to run
+      count: the number of operations in the request
+      controller: an RpcController
+      response: an RDMBulkResponse message.
+    """
+    if not callback:
+      return
+    if controller.Failed():
+      responses = [RDMResponse(controller, None) for i in range(count)]
+    else:
+      responses = [RDMResponse(controller, r) for r in response.response]
+    callback(responses)
+
 
 # Populate the patch & register actions
 for value in Ola_pb2._PATCHACTION.values:
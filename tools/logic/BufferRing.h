@@ -0,0 +1,99 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * BufferRing.h
+ * A lock free, single producer, single consumer ring.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#ifndef TOOLS_LOGIC_BUFFERRING_H_
+#define TOOLS_LOGIC_BUFFERRING_H_
+
+#include <ola/base/Atomic.h>
+#include <ola/base/Macro.h>
+#include <vector>
+
+/**
+ * A fixed size ring used to pass sample buffers from the capture thread to the
+ * decode thread.
+ *
+ * Exactly one thread may call Push() and exactly one thread may call Pop().
+ * Neither of them blocks or takes a lock, so a slow decoder never stalls the
+ * device's capture thread, Push() returns false instead.
+ */
+template <typename T>
+class BufferRing {
+ public:
+  /**
+   * @param size the number of slots, this is rounded up to a power of two.
+   */
+  explicit BufferRing(unsigned int size)
+      : m_head(0),
+        m_tail(0) {
+    unsigned int slots = 2;
+    while (slots < size) {
+      slots <<= 1;
+    }
+    m_mask = slots - 1;
+    m_items.resize(slots);
+  }
+
+  /**
+   * Add an item to the ring. Only called from the producer thread.
+   * @returns false if the ring is full.
+   */
+  bool Push(const T &item) {
+    unsigned int tail = m_tail;
+    unsigned int next = (tail + 1) & m_mask;
+    if (next == m_head) {
+      return false;
+    }
+    m_items[tail] = item;
+    // Make sure the item is written before the consumer can see it.
+    ola::AtomicBarrier();
+    m_tail = next;
+    return true;
+  }
+
+  /**
+   * Remove an item from the ring. Only called from the consumer thread.
+   * @returns false if the ring is empty.
+   */
+  bool Pop(T *item) {
+    unsigned int head = m_head;
+    if (head == m_tail) {
+      return false;
+    }
+    ola::AtomicBarrier();
+    *item = m_items[head];
+    // Make sure the item is read before the producer can reuse the slot.
+    ola::AtomicBarrier();
+    m_head = (head + 1) & m_mask;
+    return true;
+  }
+
+  bool Empty() const {
+    return m_head == m_tail;
+  }
+
+ private:
+  volatile unsigned int m_head;
+  volatile unsigned int m_tail;
+  unsigned int m_mask;
+  std::vector<T> m_items;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferRing);
+};
+#endif  // TOOLS_LOGIC_BUFFERRING_H_
@@ -39,15 +39,26 @@
  *  36.72 (9 * 4.08) useconds passes and there was no rising edge it's a break.
  *
  * The implementation is based on a state machine, with a couple of tweaks.
+ *
+ * At 4MHz and above, stepping the state machine for every sample is too slow
+ * to keep up. The samples are first split into runs of the same value, which
+ * only takes a few instructions per eight samples. Most of a run can then be
+ * added to the tick count in one go, only the sample that causes a state
+ * transition goes through ProcessSample().
  */
 
 #include <ola/Logging.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
 #include <vector>
 
 #include "tools/logic/DMXSignalProcessor.h"
 
 using std::vector;
 
+const double DMXSignalProcessor::BIT_TIME = 4.0;
 const double DMXSignalProcessor::MIN_BREAK_TIME = 88.0;
 const double DMXSignalProcessor::MIN_MAB_TIME = 8.0;
 const double DMXSignalProcessor::MAX_MAB_TIME = 1000000.0;
@@ -65,10 +76,16 @@ DMXSignalProcessor::DMXSignalProcessor(DataCallback *callback,
     : m_callback(callback),
       m_sample_rate(sample_rate),
       m_microseconds_per_tick(1000000.0 / sample_rate),
+      m_ticks_per_bit(BIT_TIME / m_microseconds_per_tick),
+      m_max_mab_ticks(DurationAsTicks(MAX_MAB_TIME)),
+      m_max_bit_ticks(DurationAsTicks(MAX_BIT_TIME)),
+      m_stop_bits_ticks(DurationAsTicks(2 * MIN_BIT_TIME)),
+      m_max_mark_between_slots_ticks(DurationAsTicks(MAX_MARK_BETWEEN_SLOTS)),
       m_state(IDLE),
       m_ticks(0),
       m_may_be_in_break(false),
-      m_ticks_in_break(0) {
+      m_ticks_in_break(0),
+      m_bit_error(0) {
   if (m_sample_rate % DMX_BITRATE) {
     OLA_WARN << "Sample rate is not a multiple of " << DMX_BITRATE;
   }
@@ -83,10 +100,39 @@ DMXSignalProcessor::DMXSignalProcessor(DataCallback *callback,
  * @param mask the value to be AND'ed with each sample to determine if the
  *   signal is high or low.
  */
-void DMXSignalProcessor::Process(uint8_t *ptr, unsigned int size,
+void DMXSignalProcessor::Process(const uint8_t *ptr, unsigned int size,
                                  uint8_t mask) {
-  for (unsigned int i = 0 ; i < size; i++) {
-    ProcessSample(ptr[i] & mask);
+  unsigned int offset = 0;
+  while (offset < size) {
+    bool bit = ptr[offset] & mask;
+    unsigned int run = 1 + FindEdge(ptr + offset + 1, size - offset - 1, mask,
+                                    bit);
+    ProcessRun(bit, run);
+    offset += run;
+  }
+}
+
+/**
+ * Process a run of samples with the same value. This has the same result as
+ * calling ProcessSample() for each one.
+ */
+void DMXSignalProcessor::ProcessRun(bool bit, unsigned int samples) {
+  while (samples) {
+    unsigned int skip = std::min(SamplesUntilTransition(bit), samples);
+    if (skip) {
+      if (m_may_be_in_break && !bit) {
+        m_ticks_in_break += skip;
+      }
+      if (m_state != UNDEFINED) {
+        m_ticks += skip;
+      }
+      samples -= skip;
+      if (!samples) {
+        break;
+      }
+    }
+    ProcessSample(bit);
+    samples--;
   }
 }
 
@@ -190,6 +236,60 @@ void DMXSignalProcessor::ProcessSample(bool bit) {
   }
 }
 
+/**
+ * Return the number of samples with this value that can be processed before
+ * the next one may change the state. For these samples ProcessSample() would
+ * do nothing more than increment the tick counters.
+ */
+unsigned int DMXSignalProcessor::SamplesUntilTransition(bool bit) const {
+  const unsigned int unlimited = std::numeric_limits<unsigned int>::max();
+
+  switch (m_state) {
+    case UNDEFINED:
+      return bit ? 0 : unlimited;
+    case IDLE:
+      return bit ? unlimited : 0;
+    case BREAK:
+      return bit ? 0 : unlimited;
+    case MAB:
+      return bit ? TicksRemaining(m_max_mab_ticks) : 0;
+    case START_BIT:
+      return bit ? 0 : TicksRemaining(m_max_bit_ticks);
+    case BIT_1:
+    case BIT_2:
+    case BIT_3:
+    case BIT_4:
+    case BIT_5:
+    case BIT_6:
+    case BIT_7:
+    case BIT_8:
+      {
+        // The first sample of each bit sets the value, and a high sample
+        // clears m_may_be_in_break.
+        unsigned int offset = m_state - BIT_1;
+        if (!m_bits_defined[offset] || m_current_byte[offset] != bit ||
+            (bit && m_may_be_in_break)) {
+          return 0;
+        }
+        return TicksRemaining(m_max_bit_ticks);
+      }
+    case STOP_BITS:
+      return bit ? TicksRemaining(m_stop_bits_ticks) : 0;
+    case MARK_BETWEEN_SLOTS:
+      return bit ? TicksRemaining(m_max_mark_between_slots_ticks) : 0;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Return the number of ticks which can be added before the tick count reaches
+ * limit.
+ */
+unsigned int DMXSignalProcessor::TicksRemaining(unsigned int limit) const {
+  return m_ticks + 1 < limit ? limit - 1 - m_ticks : 0;
+}
+
 /**
  * Process a sample that makes up a bit of data.
  */
@@ -208,7 +308,16 @@ void DMXSignalProcessor::ProcessBit(bool bit) {
   m_ticks++;
   if (bit == current_bit) {
     if (DurationExceeds(MAX_BIT_TIME)) {
-      SetState(static_cast<State>(m_state + 1));
+      // There was no edge, so the samples past the nominal bit time belong to
+      // the next bit. Carrying them over stops the error building up across a
+      // run of identical bits. If a bit isn't a whole number of ticks, round
+      // each one so the run as a whole has the right length.
+      unsigned int bit_ticks = std::min(
+          m_ticks,
+          static_cast<unsigned int>(m_ticks_per_bit - m_bit_error + 0.5));
+      double bit_error = m_bit_error + bit_ticks - m_ticks_per_bit;
+      SetState(static_cast<State>(m_state + 1), m_ticks - bit_ticks);
+      m_bit_error = bit_error;
     }
   } else {
     // Because we force a transition into the next state (bit) after
@@ -286,6 +395,7 @@ void DMXSignalProcessor::SetState(State state, unsigned int ticks) {
            << TicksAsMicroSeconds();
   m_state = state;
   m_ticks = ticks;
+  m_bit_error = 0;
   if (state == UNDEFINED) {
     // if we have a partial frame, we should send that up the stack
     HandleFrame();
@@ -312,3 +422,50 @@ bool DMXSignalProcessor::DurationExceeds(double micro_seconds) {
 double DMXSignalProcessor::TicksAsMicroSeconds() {
   return m_ticks * m_microseconds_per_tick;
 }
+
+/*
+ * Return the smallest number of ticks for which DurationExceeds(micro_seconds)
+ * is true.
+ */
+unsigned int DMXSignalProcessor::DurationAsTicks(double micro_seconds) const {
+  unsigned int ticks = static_cast<unsigned int>(
+      micro_seconds / m_microseconds_per_tick);
+  while (ticks && (ticks - 1) * m_microseconds_per_tick >= micro_seconds) {
+    ticks--;
+  }
+  while (ticks * m_microseconds_per_tick < micro_seconds) {
+    ticks++;
+  }
+  return ticks;
+}
+
+/*
+ * Return the number of samples before the value changes from bit. This checks
+ * eight samples at a time while the samples are all low, or all high if the
+ * mask is a single bit.
+ */
+unsigned int DMXSignalProcessor::FindEdge(const uint8_t *ptr,
+                                          unsigned int size,
+                                          uint8_t mask,
+                                          bool bit) {
+  const uint64_t word_mask = mask * 0x0101010101010101ULL;
+  const bool single_bit = (mask & (mask - 1)) == 0;
+  const uint64_t expected = bit ? word_mask : 0;
+
+  unsigned int offset = 0;
+  if (!bit || single_bit) {
+    while (offset + sizeof(uint64_t) <= size) {
+      uint64_t word;
+      memcpy(&word, ptr + offset, sizeof(word));
+      if ((word & word_mask) != expected) {
+        break;
+      }
+      offset += sizeof(word);
+    }
+  }
+
+  while (offset < size && static_cast<bool>(ptr[offset] & mask) == bit) {
+    offset++;
+  }
+  return offset;
+}
@@ -42,7 +42,10 @@ class DMXSignalProcessor {
     }
 
     // Process more data.
-    void Process(uint8_t *ptr, unsigned int size, uint8_t mask = 0xff);
+    void Process(const uint8_t *ptr, unsigned int size, uint8_t mask = 0xff);
+
+    // Process a run of samples which all have the same value.
+    void ProcessRun(bool bit, unsigned int samples);
 
  private:
     enum State {
@@ -67,6 +70,14 @@ class DMXSignalProcessor {
     DataCallback* const m_callback;
     const unsigned int m_sample_rate;
     const double m_microseconds_per_tick;
+    // The length of a bit in ticks, this may not be a whole number.
+    const double m_ticks_per_bit;
+    // The timing limits, as the number of ticks at which DurationExceeds()
+    // becomes true.
+    const unsigned int m_max_mab_ticks;
+    const unsigned int m_max_bit_ticks;
+    const unsigned int m_stop_bits_ticks;
+    const unsigned int m_max_mark_between_slots_ticks;
 
     // our current state.
     State m_state;
@@ -76,6 +87,8 @@ class DMXSignalProcessor {
     // in DMXSignalProcessor.cpp
     bool m_may_be_in_break;
     unsigned int m_ticks_in_break;
+    // The ticks given to the bits since the last edge, less their real length.
+    double m_bit_error;
 
     // Used to accumulate the bits in the current byte.
     std::vector<bool> m_bits_defined;
@@ -86,6 +99,8 @@ class DMXSignalProcessor {
 
     void ProcessSample(bool bit);
     void ProcessBit(bool bit);
+    unsigned int SamplesUntilTransition(bool bit) const;
+    unsigned int TicksRemaining(unsigned int limit) const;
     bool SetBitIfNotDefined(bool bit);
     void AppendDataByte();
     void HandleFrame();
@@ -93,8 +108,13 @@ class DMXSignalProcessor {
     void SetState(State state, unsigned int ticks = 1);
     bool DurationExceeds(double micro_seconds);
     double TicksAsMicroSeconds();
+    unsigned int DurationAsTicks(double micro_seconds) const;
+
+    static unsigned int FindEdge(const uint8_t *ptr, unsigned int size,
+                                 uint8_t mask, bool bit);
 
     static const unsigned int DMX_BITRATE = 250000;
+    static const double BIT_TIME;
     // These are all in microseconds and are the receiver side limits.
     static const double MIN_BREAK_TIME;
     static const double MIN_MAB_TIME;
@@ -0,0 +1,316 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMXSignalProcessorTest.cpp
+ * Test fixture for the DMXSignalProcessor class.
+ * Copyright (C) 2018 Simon Newton
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "ola/Callback.h"
+#include "ola/testing/TestUtils.h"
+#include "tools/logic/DMXSignalProcessor.h"
+
+using std::vector;
+
+// Compare the slots of a decoded frame.
+#define ASSERT_FRAME_EQ(expected, frame)  \
+  OLA_ASSERT_DATA_EQUALS(&(expected)[0], \
+                         static_cast<unsigned int>((expected).size()), \
+                         &(frame)[0], \
+                         static_cast<unsigned int>((frame).size()))
+
+/**
+ * Builds the samples a logic analyzer would capture for a DMX signal.
+ */
+class SampleGenerator {
+ public:
+  explicit SampleGenerator(unsigned int sample_rate)
+      : m_sample_rate(sample_rate),
+        m_time(0) {
+  }
+
+  // Add a period of the given level. The edges are placed at the nearest
+  // sample to their real time, so when a bit isn't a whole number of samples
+  // some bits are a sample longer than others, as in a real capture.
+  void AddLevel(bool level, double micro_seconds) {
+    m_time += micro_seconds;
+    size_t end = static_cast<size_t>(m_time * m_sample_rate / 1000000 + 0.5);
+    m_samples.insert(m_samples.end(), end - m_samples.size(),
+                     level ? 0x01 : 0x00);
+  }
+
+  // Add a break, mark after break and the slots.
+  void AddFrame(const vector<uint8_t> &slots, double mark_between_slots = 0) {
+    AddLevel(false, 176);
+    AddLevel(true, 12);
+    for (unsigned int i = 0; i < slots.size(); i++) {
+      AddSlot(slots[i]);
+      if (mark_between_slots) {
+        AddLevel(true, mark_between_slots);
+      }
+    }
+  }
+
+  void AddSlot(uint8_t value) {
+    AddLevel(false, BIT_TIME);
+    // LSB first
+    for (unsigned int i = 0; i < 8; i++) {
+      AddLevel(value & (1 << i), BIT_TIME);
+    }
+    AddLevel(true, 2 * BIT_TIME);
+  }
+
+  vector<uint8_t>* Samples() { return &m_samples; }
+
+ private:
+  const unsigned int m_sample_rate;
+  double m_time;
+  vector<uint8_t> m_samples;
+
+  static const double BIT_TIME;
+};
+
+const double SampleGenerator::BIT_TIME = 4.0;
+
+
+class DMXSignalProcessorTest: public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DMXSignalProcessorTest);
+  CPPUNIT_TEST(testSampleRates);
+  CPPUNIT_TEST(testMarkBetweenSlots);
+  CPPUNIT_TEST(testSplitBuffers);
+  CPPUNIT_TEST(testMask);
+  CPPUNIT_TEST(testShortBreak);
+  CPPUNIT_TEST(testLongCapture);
+  CPPUNIT_TEST_SUITE_END();
+
+ public:
+  void setUp();
+  void testSampleRates();
+  void testMarkBetweenSlots();
+  void testSplitBuffers();
+  void testMask();
+  void testShortBreak();
+  void testLongCapture();
+
+ private:
+  vector<vector<uint8_t> > m_frames;
+  vector<uint8_t> m_slots;
+
+  void FrameReceived(const uint8_t *data, unsigned int length) {
+    m_frames.push_back(vector<uint8_t>(data, data + length));
+  }
+
+  void Decode(unsigned int sample_rate, const vector<uint8_t> &samples,
+              unsigned int chunk_size = 0, uint8_t mask = 0x01);
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DMXSignalProcessorTest);
+
+
+void DMXSignalProcessorTest::setUp() {
+  m_frames.clear();
+  m_slots.clear();
+  // Cover each bit pattern in the first byte, plus some edge cases.
+  const uint8_t slots[] = {0x00, 0xff, 0x55, 0xaa, 0x01, 0x80, 0x7f, 0xfe};
+  m_slots.assign(slots, slots + sizeof(slots));
+  for (unsigned int i = 0; i < 24; i++) {
+    m_slots.push_back(static_cast<uint8_t>(i * 37));
+  }
+}
+
+
+/**
+ * Feed the samples to a new processor.
+ * @param sample_rate the sample rate of the samples.
+ * @param samples the samples to decode.
+ * @param chunk_size if non-zero, the samples are passed to Process() in
+ *   blocks of this size.
+ * @param mask the mask to pass to Process().
+ */
+void DMXSignalProcessorTest::Decode(unsigned int sample_rate,
+                                    const vector<uint8_t> &samples,
+                                    unsigned int chunk_size,
+                                    uint8_t mask) {
+  std::auto_ptr<DMXSignalProcessor::DataCallback> callback(
+      ola::NewCallback(this, &DMXSignalProcessorTest::FrameReceived));
+  DMXSignalProcessor processor(callback.get(), sample_rate);
+  if (!chunk_size) {
+    chunk_size = samples.size();
+  }
+  for (unsigned int offset = 0; offset < samples.size();
+       offset += chunk_size) {
+    unsigned int length = std::min(
+        chunk_size, static_cast<unsigned int>(samples.size() - offset));
+    processor.Process(&samples[offset], length, mask);
+  }
+}
+
+
+/**
+ * Check frames are decoded at each of the supported sample rates.
+ */
+void DMXSignalProcessorTest::testSampleRates() {
+  const unsigned int sample_rates[] = {
+    1000000, 2000000, 4000000, 8000000, 12000000, 16000000, 24000000
+  };
+
+  vector<uint8_t> second_frame(m_slots.rbegin(), m_slots.rend());
+
+  for (unsigned int i = 0; i < sizeof(sample_rates) / sizeof(*sample_rates);
+       i++) {
+    m_frames.clear();
+    SampleGenerator generator(sample_rates[i]);
+    generator.AddLevel(true, 100);
+    generator.AddFrame(m_slots);
+    generator.AddLevel(true, 50);
+    generator.AddFrame(second_frame);
+    // The start of the next break completes the second frame.
+    generator.AddLevel(true, 50);
+    generator.AddLevel(false, 176);
+    Decode(sample_rates[i], *generator.Samples());
+
+    OLA_ASSERT_EQ(static_cast<size_t>(2), m_frames.size());
+    ASSERT_FRAME_EQ(m_slots, m_frames[0]);
+    ASSERT_FRAME_EQ(second_frame, m_frames[1]);
+  }
+}
+
+
+/**
+ * Check a mark between slots doesn't end the frame.
+ */
+void DMXSignalProcessorTest::testMarkBetweenSlots() {
+  const unsigned int sample_rate = 4000000;
+  SampleGenerator generator(sample_rate);
+  generator.AddLevel(true, 100);
+  generator.AddFrame(m_slots, 20);
+  generator.AddLevel(true, 1000);
+  generator.AddLevel(false, 176);
+  Decode(sample_rate, *generator.Samples());
+
+  OLA_ASSERT_EQ(static_cast<size_t>(1), m_frames.size());
+  ASSERT_FRAME_EQ(m_slots, m_frames[0]);
+}
+
+
+/**
+ * Check runs which span calls to Process() are decoded correctly.
+ */
+void DMXSignalProcessorTest::testSplitBuffers() {
+  const unsigned int sample_rate = 8000000;
+  SampleGenerator generator(sample_rate);
+  generator.AddLevel(true, 100);
+  generator.AddFrame(m_slots);
+  generator.AddLevel(true, 50);
+  generator.AddLevel(false, 176);
+
+  const unsigned int chunk_sizes[] = {1, 7, 8, 9, 64, 1000};
+  for (unsigned int i = 0; i < sizeof(chunk_sizes) / sizeof(*chunk_sizes);
+       i++) {
+    m_frames.clear();
+    Decode(sample_rate, *generator.Samples(), chunk_sizes[i]);
+    OLA_ASSERT_EQ(static_cast<size_t>(1), m_frames.size());
+    ASSERT_FRAME_EQ(m_slots, m_frames[0]);
+  }
+}
+
+
+/**
+ * Check the other channels of the analyzer are ignored.
+ */
+void DMXSignalProcessorTest::testMask() {
+  const unsigned int sample_rate = 4000000;
+  SampleGenerator generator(sample_rate);
+  generator.AddLevel(true, 100);
+  generator.AddFrame(m_slots);
+  generator.AddLevel(true, 50);
+  generator.AddLevel(false, 176);
+
+  // Move the signal to channel 2 and put noise on the others.
+  vector<uint8_t> samples(*generator.Samples());
+  for (unsigned int i = 0; i < samples.size(); i++) {
+    samples[i] = static_cast<uint8_t>((samples[i] << 2) | ((i / 3) & 0xf3));
+  }
+  Decode(sample_rate, samples, 0, 0x04);
+
+  OLA_ASSERT_EQ(static_cast<size_t>(1), m_frames.size());
+  ASSERT_FRAME_EQ(m_slots, m_frames[0]);
+}
+
+
+/**
+ * Check a break that is too short is ignored.
+ */
+void DMXSignalProcessorTest::testShortBreak() {
+  const unsigned int sample_rate = 4000000;
+  SampleGenerator generator(sample_rate);
+  generator.AddLevel(true, 100);
+  generator.AddLevel(false, 60);
+  generator.AddLevel(true, 12);
+  generator.AddSlot(0x12);
+  generator.AddLevel(true, 1000);
+  generator.AddFrame(m_slots);
+  generator.AddLevel(true, 50);
+  generator.AddLevel(false, 176);
+  Decode(sample_rate, *generator.Samples());
+
+  OLA_ASSERT_EQ(static_cast<size_t>(1), m_frames.size());
+  ASSERT_FRAME_EQ(m_slots, m_frames[0]);
+}
+
+
+/**
+ * Check long captures at sample rates where a bit isn't a whole number of
+ * samples. Runs of identical bits carry the rounding error from one bit to
+ * the next, and the frames are long enough that any error which isn't reset
+ * at the start of each slot would show up.
+ */
+void DMXSignalProcessorTest::testLongCapture() {
+  const unsigned int sample_rates[] = {
+    4400000, 5300000, 9900000, 13000000, 23300000
+  };
+
+  vector<uint8_t> first_frame, second_frame;
+  for (unsigned int i = 0; i < 512; i++) {
+    first_frame.push_back(m_slots[i % m_slots.size()]);
+    second_frame.push_back(i % 2 ? 0x00 : 0xff);
+  }
+
+  for (unsigned int i = 0; i < sizeof(sample_rates) / sizeof(*sample_rates);
+       i++) {
+    m_frames.clear();
+    SampleGenerator generator(sample_rates[i]);
+    generator.AddLevel(true, 100);
+    for (unsigned int frame = 0; frame < 20; frame++) {
+      generator.AddFrame(frame % 2 ? second_frame : first_frame);
+      generator.AddLevel(true, 50);
+    }
+    generator.AddLevel(false, 176);
+    Decode(sample_rates[i], *generator.Samples(), 4096);
+
+    OLA_ASSERT_EQ(static_cast<size_t>(20), m_frames.size());
+    for (unsigned int frame = 0; frame < m_frames.size(); frame++) {
+      ASSERT_FRAME_EQ(frame % 2 ? second_frame : first_frame,
+                      m_frames[frame]);
+    }
+  }
+}
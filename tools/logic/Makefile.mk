@@ -1,12 +1,34 @@
+# LIBRARIES
+##################################################
+# The decoder doesn't depend on the Saleae SDK, so it's always built and
+# tested.
+noinst_LTLIBRARIES += tools/logic/libolalogic.la
+tools_logic_libolalogic_la_SOURCES = \
+    tools/logic/DMXSignalProcessor.cpp \
+    tools/logic/DMXSignalProcessor.h
+tools_logic_libolalogic_la_LIBADD = common/libolacommon.la
+
+# PROGRAMS
+##################################################
 if HAVE_SALEAE_LOGIC
 bin_PROGRAMS += tools/logic/logic_rdm_sniffer
 endif
 
 tools_logic_logic_rdm_sniffer_SOURCES = \
-    tools/logic/DMXSignalProcessor.cpp \
-    tools/logic/DMXSignalProcessor.h \
+    tools/logic/BufferRing.h \
     tools/logic/logic-rdm-sniffer.cpp
 tools_logic_logic_rdm_sniffer_LDADD = common/libolacommon.la \
+                                      tools/logic/libolalogic.la \
                                       $(libSaleaeDevice_LIBS)
 
+# TESTS
+##################################################
+test_programs += tools/logic/DMXSignalProcessorTester
+
+tools_logic_DMXSignalProcessorTester_SOURCES = \
+    tools/logic/DMXSignalProcessorTest.cpp
+tools_logic_DMXSignalProcessorTester_CXXFLAGS = $(COMMON_TESTING_FLAGS)
+tools_logic_DMXSignalProcessorTester_LDADD = $(COMMON_TESTING_LIBS) \
+                                             tools/logic/libolalogic.la
+
 EXTRA_DIST += tools/logic/README.md
@@ -28,6 +28,7 @@
 
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <ola/base/Flags.h>
 #include <ola/base/Init.h>
@@ -48,14 +49,16 @@
 #include <ola/rdm/RDMResponseCodes.h>
 #include <ola/rdm/UID.h>
 #include <ola/StringUtils.h>
+#include <ola/thread/Mutex.h>
+#include <ola/thread/Thread.h>
 
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
-#include <queue>
 
+#include "tools/logic/BufferRing.h"
 #include "tools/logic/DMXSignalProcessor.h"
 
 using std::auto_ptr;
@@ -74,6 +77,7 @@ using ola::rdm::UID;
 using ola::strings::ToHex;
 
 
+using ola::thread::ConditionVariable;
 using ola::thread::Mutex;
 using ola::thread::MutexLocker;
 using ola::NewSingleCallback;
@@ -91,24 +95,157 @@ DEFINE_uint16(dmx_slot_limit, ola::DMX_UNIVERSE_SIZE,
 DEFINE_uint32(sample_rate, 4000000, "Sample rate in HZ.");
 DEFINE_string(pid_location, "",
               "The directory containing the PID definitions.");
+DEFINE_string(capture_file, "",
+              "Decode the samples in this file rather than reading from a "
+              "device. The file contains one byte per sample, with the "
+              "signal on bit 0.");
+DEFINE_string(save_capture, "",
+              "Write the samples read from the device to this file.");
 
 void OnReadData(U64 device_id, U8 *data, uint32_t data_length,
                 void *user_data);
 void OnError(U64 device_id, void *user_data);
-void ProcessData(U8 *data, uint32_t data_length);
+/**
+ * A buffer of samples, waiting to be decoded.
+ */
+struct SampleBuffer {
+  U8 *data;
+  uint32_t length;
+  bool from_device;  // true if the data is owned by the Saleae library.
+  bool follows_gap;  // true if samples were dropped before this buffer.
+};
+
+/**
+ * Decodes the samples on a separate thread. The device's capture thread
+ * passes the buffers through a lock free ring, so it's never blocked by the
+ * decoder or the output.
+ */
+class SampleDecoder: public ola::thread::Thread {
+ public:
+    SampleDecoder(DMXSignalProcessor *processor, std::ostream *capture_output)
+      : Thread(Thread::Options("decoder")),
+        m_processor(processor),
+        m_capture_output(capture_output),
+        m_ring(RING_SIZE),
+        m_stop(false),
+        m_sample_count(0) {
+    }
+
+    /**
+     * Queue a buffer for decoding. Ownership of the data is transferred if
+     * this returns true.
+     * @returns false if the decoder has fallen behind.
+     */
+    bool Push(const SampleBuffer &buffer) {
+      if (!m_ring.Push(buffer)) {
+        return false;
+      }
+      // A missed wake up is caught by the timed wait in Run().
+      m_condition.Signal();
+      return true;
+    }
+
+    /**
+     * Decode the remaining buffers and then wait for the thread to exit.
+     */
+    void Stop() {
+      if (!IsRunning()) {
+        return;
+      }
+      {
+        MutexLocker lock(&m_mu);
+        m_stop = true;
+        m_condition.Signal();
+      }
+      Join();
+    }
+
+    /**
+     * The number of samples that have been decoded.
+     */
+    uint64_t SampleCount() const {
+      MutexLocker lock(&m_mu);
+      return m_sample_count;
+    }
+
+ protected:
+    void *Run();
+
+ private:
+    DMXSignalProcessor *m_processor;
+    std::ostream *m_capture_output;
+    BufferRing<SampleBuffer> m_ring;
+    ola::Clock m_clock;
+    mutable Mutex m_mu;
+    ConditionVariable m_condition;
+    bool m_stop;  // GUARDED_BY(m_mu);
+    uint64_t m_sample_count;  // GUARDED_BY(m_mu);
+
+    static void FreeBuffer(const SampleBuffer &buffer);
+
+    static const unsigned int RING_SIZE = 1024;
+    static const unsigned int WAIT_TIME_US = 10000;
+};
+
+void *SampleDecoder::Run() {
+  while (true) {
+    SampleBuffer buffer;
+    if (m_ring.Pop(&buffer)) {
+      if (m_capture_output) {
+        m_capture_output->write(reinterpret_cast<const char*>(buffer.data),
+                                buffer.length);
+      }
+      if (buffer.follows_gap) {
+        m_processor->Reset();
+      }
+      m_processor->Process(buffer.data, buffer.length, 0x01);
+      FreeBuffer(buffer);
+
+      MutexLocker lock(&m_mu);
+      m_sample_count += buffer.length;
+      continue;
+    }
+
+    MutexLocker lock(&m_mu);
+    if (m_stop) {
+      if (m_ring.Empty()) {
+        break;
+      }
+      continue;
+    }
+    ola::TimeStamp wake_up_time;
+    m_clock.CurrentTime(&wake_up_time);
+    wake_up_time += ola::TimeInterval(0, WAIT_TIME_US);
+    m_condition.TimedWait(&m_mu, wake_up_time);
+  }
+  return NULL;
+}
+
+void SampleDecoder::FreeBuffer(const SampleBuffer &buffer) {
+  if (buffer.from_device) {
+    DevicesManagerInterface::DeleteU8ArrayPtr(buffer.data);
+  } else {
+    delete[] buffer.data;
+  }
+}
+
 
 class LogicReader {
  public:
-    explicit LogicReader(SelectServer *ss, unsigned int sample_rate)
+    explicit LogicReader(SelectServer *ss, unsigned int sample_rate,
+                         std::ostream *capture_output = NULL)
       : m_sample_rate(sample_rate),
         m_device_id(0),
         m_logic(NULL),
         m_ss(ss),
+        m_dropped_samples(false),
         m_signal_processor(ola::NewCallback(this, &LogicReader::FrameReceived),
                            sample_rate),
+        m_decoder(&m_signal_processor, capture_output),
         m_pid_helper(FLAGS_pid_location.str(), 4),
         m_command_printer(&cout, &m_pid_helper) {
       m_pid_helper.Init();
+      m_decoder.Start();
     }
     ~LogicReader();
 
@@ -116,6 +253,7 @@ class LogicReader {
     void DeviceDisconnected(U64 device);
     void DataReceived(U64 device, U8 *data, uint32_t data_length);
     void FrameReceived(const uint8_t *data, unsigned int length);
+    bool DecodeFile(const string &filename);
 
     void Stop();
 
@@ -130,20 +268,23 @@ class LogicReader {
     LogicInterface *m_logic;  // GUARDED_BY(m_mu);
     mutable Mutex m_mu;
     SelectServer *m_ss;
+    bool m_dropped_samples;  // only used by the capture thread.
     DMXSignalProcessor m_signal_processor;
+    SampleDecoder m_decoder;
     PidStoreHelper m_pid_helper;
     CommandPrinter m_command_printer;
-    Mutex m_data_mu;
-    std::queue<U8*> m_free_data;
 
-    void ProcessData(U8 *data, uint32_t data_length);
     void DisplayDMXFrame(const uint8_t *data, unsigned int length);
+
+    static const unsigned int FILE_BUFFER_SIZE = 1 << 20;
+    static const unsigned int WAIT_TIME_US = 1000;
     void DisplayRDMFrame(const uint8_t *data, unsigned int length);
     void DisplayAlternateFrame(const uint8_t *data, unsigned int length);
     void DisplayRawData(const uint8_t *data, unsigned int length);
 };
 
 LogicReader::~LogicReader() {
+  m_decoder.Stop();
   m_ss->DrainCallbacks();
 }
 
@@ -203,16 +344,12 @@ void LogicReader::DataReceived(U64 device, U8 *data, uint32_t data_length) {
       return;
     }
   }
-  m_ss->Execute(
-      NewSingleCallback(this, &LogicReader::ProcessData, data, data_length));
 
-  {
-    MutexLocker lock(&m_data_mu);
-    while (!m_free_data.empty()) {
-      U8 *data = m_free_data.front();
-      DevicesManagerInterface::DeleteU8ArrayPtr(data);
-      m_free_data.pop();
-    }
+  SampleBuffer buffer = {data, data_length, true, m_dropped_samples};
+  m_dropped_samples = !m_decoder.Push(buffer);
+  if (m_dropped_samples) {
+    OLA_WARN << "Decoder overrun, dropped " << data_length << " samples";
+    DevicesManagerInterface::DeleteU8ArrayPtr(data);
   }
 }
 
@@ -244,25 +381,50 @@ void LogicReader::Stop() {
 
 
 /**
- * Called in the main thread.
- * @param data pointer to the data, ownership is transferred, use
- *   DeleteU8ArrayPtr to free.
- * @param data_length the size of the data
+ * Decode a capture file, and report how long it took.
+ * @param filename the file to read the samples from.
+ * @returns true if the file was read, false otherwise.
  */
-void LogicReader::ProcessData(U8 *data, uint32_t data_length) {
-  m_signal_processor.Process(data, data_length, 0x01);
-  DevicesManagerInterface::DeleteU8ArrayPtr(data);
-
-  /*
-   * This is commented out until we get clarification on if DeleteU8ArrayPtr is
-   * thread safe. http://community.saleae.com/node/403
-   */
-  /*
-  {
-    MutexLocker lock(&m_data_mu);
-    m_free_data.push(data);
+bool LogicReader::DecodeFile(const string &filename) {
+  std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!input.is_open()) {
+    OLA_WARN << "Failed to open " << filename;
+    return false;
   }
-  */
+
+  ola::Clock clock;
+  ola::TimeStamp start, end;
+  clock.CurrentTime(&start);
+
+  while (input) {
+    U8 *data = new U8[FILE_BUFFER_SIZE];
+    input.read(reinterpret_cast<char*>(data), FILE_BUFFER_SIZE);
+    SampleBuffer buffer = {data, static_cast<uint32_t>(input.gcount()), false,
+                           false};
+    if (buffer.length == 0) {
+      delete[] data;
+      break;
+    }
+
+    // Unlike a device, a file can wait for the decoder to catch up.
+    while (!m_decoder.Push(buffer)) {
+      usleep(WAIT_TIME_US);
+    }
+  }
+
+  m_decoder.Stop();
+  clock.CurrentTime(&end);
+
+  uint64_t samples = m_decoder.SampleCount();
+  double elapsed = (end - start).InMilliSeconds() / 1000.0;
+  double duration = static_cast<double>(samples) / m_sample_rate;
+  cerr << "Decoded " << samples << " samples (" << duration << "s) in "
+       << elapsed << "s";
+  if (elapsed > 0) {
+    cerr << ", " << duration / elapsed << "x real time";
+  }
+  cerr << endl;
+  return true;
 }
 
 
@@ -367,7 +529,25 @@ int main(int argc, char *argv[]) {
                "Decode DMX/RDM data from a Saleae Logic device");
 
   SelectServer ss;
-  LogicReader reader(&ss, FLAGS_sample_rate);
+
+  if (!FLAGS_capture_file.str().empty()) {
+    LogicReader reader(&ss, FLAGS_sample_rate);
+    return reader.DecodeFile(FLAGS_capture_file.str()) ?
+        ola::EXIT_OK : ola::EXIT_NOINPUT;
+  }
+
+  auto_ptr<std::ofstream> capture_output;
+  if (!FLAGS_save_capture.str().empty()) {
+    capture_output.reset(new std::ofstream(
+        FLAGS_save_capture.str().c_str(),
+        std::ios::out | std::ios::binary | std::ios::trunc));
+    if (!capture_output->is_open()) {
+      OLA_FATAL << "Failed to open " << FLAGS_save_capture.str();
+      return ola::EXIT_CANTCREAT;
+    }
+  }
+
+  LogicReader reader(&ss, FLAGS_sample_rate, capture_output.get());
 
   DevicesManagerInterface::RegisterOnConnect(&OnConnect, &reader);
   DevicesManagerInterface::RegisterOnDisconnect(&OnDisconnect, &reader);